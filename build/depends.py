@@ -540,7 +540,8 @@ class SoundTouch(Dependence):
 
 class RubberBand(Dependence):
     def sources(self, build):
-        sources = ['src/engine/bufferscalers/enginebufferscalerubberband.cpp', ]
+        sources = ['src/engine/bufferscalers/enginebufferscalerubberband.cpp',
+                   'src/engine/bufferscalers/rubberbandworker.cpp', ]
         return sources
 
     def configure(self, build, conf, env=None):
@@ -818,6 +819,7 @@ class MixxxCore(Feature):
                    "src/engine/engineobject.cpp",
                    "src/engine/enginepregain.cpp",
                    "src/engine/enginemaster.cpp",
+                   "src/engine/offlinerenderer.cpp",
                    "src/engine/enginedelay.cpp",
                    "src/engine/enginevumeter.cpp",
                    "src/engine/enginesidechaincompressor.cpp",
@@ -890,6 +892,8 @@ class MixxxCore(Feature):
 
                    "src/sources/audiosource.cpp",
                    "src/sources/audiosourcestereoproxy.cpp",
+                   "src/sources/bytesource.cpp",
+                   "src/sources/decodedblockcache.cpp",
                    "src/sources/metadatasourcetaglib.cpp",
                    "src/sources/soundsource.cpp",
                    "src/sources/soundsourceproviderregistry.cpp",
@@ -970,6 +974,7 @@ class MixxxCore(Feature):
 
                    "src/library/trackcollection.cpp",
                    "src/library/basesqltablemodel.cpp",
+                   "src/library/basesqltableselecttask.cpp",
                    "src/library/basetrackcache.cpp",
                    "src/library/columncache.cpp",
                    "src/library/librarytablemodel.cpp",
@@ -981,9 +986,11 @@ class MixxxCore(Feature):
                    "src/library/proxytrackmodel.cpp",
                    "src/library/coverart.cpp",
                    "src/library/coverartcache.cpp",
+                   "src/library/coverartthumbnailstore.cpp",
                    "src/library/coverartutils.cpp",
 
                    "src/library/crate/cratestorage.cpp",
+                   "src/library/crate/cratemembership.cpp",
                    "src/library/crate/cratefeature.cpp",
                    "src/library/crate/cratefeaturehelper.cpp",
                    "src/library/crate/cratetablemodel.cpp",
@@ -993,6 +1000,7 @@ class MixxxCore(Feature):
                    "src/library/analysisfeature.cpp",
                    "src/library/autodj/autodjfeature.cpp",
                    "src/library/autodj/autodjprocessor.cpp",
+                   "src/library/autodj/autodjcandidateset.cpp",
                    "src/library/dao/directorydao.cpp",
                    "src/library/mixxxlibraryfeature.cpp",
                    "src/library/baseplaylistfeature.cpp",
@@ -1042,11 +1050,13 @@ class MixxxCore(Feature):
                    "src/library/scanner/scannertask.cpp",
                    "src/library/scanner/importfilestask.cpp",
                    "src/library/scanner/recursivescandirectorytask.cpp",
+                   "src/library/scanner/fileidentity.cpp",
 
                    "src/library/dao/cuedao.cpp",
                    "src/library/dao/trackdao.cpp",
                    "src/library/dao/playlistdao.cpp",
                    "src/library/dao/libraryhashdao.cpp",
+                   "src/library/dao/fileindexdao.cpp",
                    "src/library/dao/settingsdao.cpp",
                    "src/library/dao/analysisdao.cpp",
                    "src/library/dao/autodjcratesdao.cpp",
@@ -1173,6 +1183,7 @@ class MixxxCore(Feature):
                    "src/mixer/sampler.cpp",
                    "src/mixer/samplerbank.cpp",
 
+                   "src/soundio/audiocallbackmonitor.cpp",
                    "src/soundio/sounddevice.cpp",
                    "src/soundio/sounddevicenetwork.cpp",
                    "src/engine/sidechain/enginenetworkstream.cpp",
@@ -1214,12 +1225,14 @@ class MixxxCore(Feature):
                    "src/util/xml.cpp",
                    "src/util/tapfilter.cpp",
                    "src/util/movinginterquartilemean.cpp",
+                   "src/util/compressedbitmap.cpp",
                    "src/util/console.cpp",
                    "src/util/color/color.cpp",
                    "src/util/db/dbconnection.cpp",
                    "src/util/db/dbconnectionpool.cpp",
                    "src/util/db/dbconnectionpooler.cpp",
                    "src/util/db/dbconnectionpooled.cpp",
+                   "src/util/db/dbwriter.cpp",
                    "src/util/db/dbid.cpp",
                    "src/util/db/fwdsqlquery.cpp",
                    "src/util/db/fwdsqlqueryselectresult.cpp",
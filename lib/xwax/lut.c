@@ -22,13 +22,10 @@
 
 #include "lut.h"
 
-/* The number of bits to form the hash, which governs the overall size
- * of the hash lookup table, and hence the amount of chaining */
-
-#define HASH_BITS 16
+#define HASH_BITS LUT_HASH_BITS
 
 #define HASH(timecode) ((timecode) & ((1 << HASH_BITS) - 1))
-#define NO_SLOT ((unsigned)-1)
+#define NO_SLOT LUT_NO_SLOT
 
 
 /* Initialise an empty hash lookup table to store the given number
@@ -62,15 +59,34 @@ int lut_init(struct lut *lut, int nslots)
         lut->table[n] = NO_SLOT;
 
     lut->avail = 0;
+    lut->external = 0;
 
     return 0;
 }
 
 
+/* Use a complete lookup table in memory that is owned by the caller,
+ * e.g. one that has been mapped from a file. The table must have been
+ * built with lut_push() and LUT_HASHES hashes. */
+
+void lut_init_external(struct lut *lut, struct slot *slot,
+                       slot_no_t *table, slot_no_t avail)
+{
+    lut->slot = slot;
+    lut->table = table;
+    lut->avail = avail;
+    lut->external = 1;
+}
+
+
 void lut_clear(struct lut *lut)
 {
-    free(lut->table);
-    free(lut->slot);
+    if (!lut->external) {
+        free(lut->table);
+        free(lut->slot);
+    }
+    lut->table = NULL;
+    lut->slot = NULL;
 }
 
 
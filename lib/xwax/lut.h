@@ -22,6 +22,13 @@
 
 typedef unsigned int slot_no_t;
 
+/* The number of bits to form the hash, which governs the overall size
+ * of the hash lookup table, and hence the amount of chaining */
+
+#define LUT_HASH_BITS 16
+#define LUT_HASHES (1 << LUT_HASH_BITS)
+#define LUT_NO_SLOT ((slot_no_t)-1)
+
 struct slot {
     unsigned int timecode;
     slot_no_t next; /* next slot with the same hash */
@@ -31,9 +38,12 @@ struct lut {
     struct slot *slot;
     slot_no_t *table, /* hash -> slot lookup */
         avail; /* next available slot */
+    int external; /* memory is owned by the caller */
 };
 
 int lut_init(struct lut *lut, int nslots);
+void lut_init_external(struct lut *lut, struct slot *slot,
+                       slot_no_t *table, slot_no_t avail);
 void lut_clear(struct lut *lut);
 
 void lut_push(struct lut *lut, unsigned int timecode);
@@ -85,6 +85,8 @@ struct timecoder {
 };
 
 struct timecode_def* timecoder_find_definition(const char *name);
+struct timecode_def* timecoder_find_definition_without_lookup(const char *name);
+int timecoder_build_lookup(struct timecode_def *def);
 void timecoder_free_lookup(void);
 
 void timecoder_init(struct timecoder *tc, struct timecode_def *def,
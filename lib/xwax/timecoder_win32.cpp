@@ -235,12 +235,25 @@ static int build_lookup(struct timecode_def *def)
 }
 
 /*
- * Find a timecode definition by name
+ * Build the lookup table of a definition that is not part of the built-in
+ * list, e.g. a copy of one, or of one whose lookup has been freed
+ *
+ * Return: -1 if not enough memory could be allocated, otherwise 0
+ */
+
+int timecoder_build_lookup(struct timecode_def *def)
+{
+    return build_lookup(def);
+}
+
+/*
+ * Find a timecode definition by name without building its lookup table.
+ * The caller must provide the lookup table before using the definition.
  *
  * Return: pointer to timecode definition, or NULL if not found
  */
 
-struct timecode_def* timecoder_find_definition(const char *name)
+struct timecode_def* timecoder_find_definition_without_lookup(const char *name)
 {
     struct timecode_def *def, *end;
 
@@ -257,6 +270,23 @@ struct timecode_def* timecoder_find_definition(const char *name)
             return NULL;
     }
 
+    return def;
+}
+
+/*
+ * Find a timecode definition by name
+ *
+ * Return: pointer to timecode definition, or NULL if not found
+ */
+
+struct timecode_def* timecoder_find_definition(const char *name)
+{
+    struct timecode_def *def;
+
+    def = timecoder_find_definition_without_lookup(name);
+    if (def == NULL)
+        return NULL;
+
     if (build_lookup(def) == -1)
         return NULL;
 
@@ -274,8 +304,10 @@ void timecoder_free_lookup(void) {
     end = def + ARRAY_SIZE(timecodes);
 
     while (def < end) {
-        if (def->lookup)
+        if (def->lookup) {
             lut_clear(&def->lut);
+            def->lookup = false;
+        }
         def++;
     }
 }
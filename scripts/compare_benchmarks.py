@@ -0,0 +1,89 @@
+#!/usr/bin/env python
+"""Compares the results of two runs of the mixxx-test benchmarks.
+
+The results are written by
+    scons benchmark
+or
+    ./mixxx-test --benchmark --benchmark_format=json > results.json
+
+Usage:
+    compare_benchmarks.py baseline.json contender.json [--threshold 10]
+
+Prints the change of the time per iteration of every benchmark that is in
+both files and exits with 1 if any of them got slower by more than the
+threshold in percent.
+"""
+import argparse
+import json
+import sys
+
+
+def load_benchmarks(fname):
+    """reads a JSON file of the benchmark library and returns a dict of the
+       benchmark names to their results. Anything that is printed before the
+       JSON object is skipped.
+
+    """
+    with open(fname) as f:
+        text = f.read()
+    decoder = json.JSONDecoder()
+    start = text.find('{')
+    while start >= 0:
+        try:
+            results, _ = decoder.raw_decode(text, start)
+            if 'benchmarks' in results:
+                return dict((b['name'], b) for b in results['benchmarks'])
+        except ValueError:
+            pass
+        start = text.find('{', start + 1)
+    sys.exit('{}: no benchmark results found'.format(fname))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='compares two JSON files of benchmark results')
+    parser.add_argument('baseline')
+    parser.add_argument('contender')
+    parser.add_argument('--threshold', type=float, default=10.0,
+                        help='regression threshold in percent')
+    parser.add_argument('--time', choices=['real_time', 'cpu_time'],
+                        default='real_time',
+                        help='which time per iteration to compare')
+    args = parser.parse_args()
+
+    baseline = load_benchmarks(args.baseline)
+    contender = load_benchmarks(args.contender)
+
+    names = [name for name in baseline if name in contender]
+    if not names:
+        sys.exit('no common benchmarks')
+    width = max(len(name) for name in names)
+
+    regressions = []
+    for name in sorted(names):
+        old = float(baseline[name][args.time])
+        new = float(contender[name][args.time])
+        if old <= 0:
+            continue
+        change = (new - old) / old * 100.0
+        marker = ''
+        if change > args.threshold:
+            marker = '  REGRESSION'
+            regressions.append(name)
+        print('{:<{}} {:>12.0f} {:>12.0f} {:>+8.1f}%{}'.format(
+            name, width, old, new, change, marker))
+
+    for name in sorted(set(baseline) ^ set(contender)):
+        print('{:<{}} only in {}'.format(
+            name, width,
+            args.baseline if name in baseline else args.contender))
+
+    if regressions:
+        print('\n{} of {} benchmarks are more than {}% slower'.format(
+            len(regressions), len(names), args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <QString>
+#include <QStringList>
+
+#include "analyzer/constants.h"
 #include "util/assert.h"
 #include "util/types.h"
 
@@ -39,10 +43,29 @@ class Analyzer {
     // samples have been processed.
     virtual void storeResults(TrackPointer tio) = 0;
 
+    // Update the track object with preliminary results after the first
+    // kFastAnalysisSecondsToAnalyze seconds have been processed in
+    // progressive mode. Processing continues and storeResults() will
+    // replace them. Analyzers that are not able to provide preliminary
+    // results simply ignore this.
+    virtual void storePreliminaryResults(TrackPointer tio) {
+        Q_UNUSED(tio);
+    }
+
     // Discard any temporary results or free allocated memory.
     // This function will be invoked after the results have been
     // stored or if processing aborted preliminary.
     virtual void cleanup() = 0;
+
+  protected:
+    // Preliminary results from progressive mode are marked by an
+    // extra fragment in their sub-version, see kPreliminaryVersionKey
+    static QString preliminarySubVersionFragment() {
+        return QString(mixxx::kPreliminaryVersionKey) + QStringLiteral("=1");
+    }
+    static bool isPreliminarySubVersion(const QString& subVersion) {
+        return subVersion.split('|').contains(preliminarySubVersionFragment());
+    }
 };
 
 typedef std::unique_ptr<Analyzer> AnalyzerPtr;
@@ -82,6 +105,12 @@ class AnalyzerWithState final {
         }
     }
 
+    void storePreliminaryResults(TrackPointer tio) {
+        if (m_active) {
+            m_analyzer->storePreliminaryResults(tio);
+        }
+    }
+
     void finish(TrackPointer tio) {
         if (m_active) {
             m_analyzer->storeResults(tio);
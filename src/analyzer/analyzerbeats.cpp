@@ -22,9 +22,13 @@ QList<mixxx::AnalyzerPluginInfo> AnalyzerBeats::availablePlugins() {
     return plugins;
 }
 
-AnalyzerBeats::AnalyzerBeats(UserSettingsPointer pConfig, bool enforceBpmDetection)
+AnalyzerBeats::AnalyzerBeats(
+        UserSettingsPointer pConfig,
+        bool enforceBpmDetection,
+        bool progressive)
         : m_bpmSettings(pConfig),
           m_enforceBpmDetection(enforceBpmDetection),
+          m_progressive(progressive),
           m_bPreferencesReanalyzeOldBpm(false),
           m_bPreferencesFixedTempo(true),
           m_bPreferencesOffsetCorrection(false),
@@ -34,7 +38,9 @@ AnalyzerBeats::AnalyzerBeats(UserSettingsPointer pConfig, bool enforceBpmDetecti
           m_iMaxSamplesToProcess(0),
           m_iCurrentSample(0),
           m_iMinBpm(0),
-          m_iMaxBpm(9999) {
+          m_iMaxBpm(9999),
+          m_preliminaryBpm(0.0),
+          m_preliminaryFirstBeat(0.0) {
 }
 
 bool AnalyzerBeats::initialize(TrackPointer tio, int sampleRate, int totalSamples) {
@@ -66,7 +72,9 @@ bool AnalyzerBeats::initialize(TrackPointer tio, int sampleRate, int totalSample
     m_bPreferencesFixedTempo = m_bpmSettings.getFixedTempoAssumption();
     m_bPreferencesOffsetCorrection = m_bpmSettings.getFixedTempoOffsetCorrection();
     m_bPreferencesReanalyzeOldBpm = m_bpmSettings.getReanalyzeWhenSettingsChange();
-    m_bPreferencesFastAnalysis = m_bpmSettings.getFastAnalysis();
+    // Progressive mode stores the results of the first minute
+    // instead of stopping there
+    m_bPreferencesFastAnalysis = m_bpmSettings.getFastAnalysis() && !m_progressive;
 
     if (AnalyzerBeats::availablePlugins().size() > 0) {
         m_pluginId = AnalyzerBeats::availablePlugins().at(0).id; // first is default
@@ -85,7 +93,8 @@ bool AnalyzerBeats::initialize(TrackPointer tio, int sampleRate, int totalSample
              << "\nFixed tempo assumption:" << m_bPreferencesFixedTempo
              << "\nOffset correction:" << m_bPreferencesOffsetCorrection
              << "\nRe-analyze when settings change:" << m_bPreferencesReanalyzeOldBpm
-             << "\nFast analysis:" << m_bPreferencesFastAnalysis;
+             << "\nFast analysis:" << m_bPreferencesFastAnalysis
+             << "\nProgressive:" << m_progressive;
 
     m_iSampleRate = sampleRate;
     m_iTotalSamples = totalSamples;
@@ -98,6 +107,7 @@ bool AnalyzerBeats::initialize(TrackPointer tio, int sampleRate, int totalSample
         m_iMaxSamplesToProcess = m_iTotalSamples;
     }
     m_iCurrentSample = 0;
+    m_pPreliminaryBeats.reset();
 
     // if we can load a stored track don't reanalyze it
     bool bShouldAnalyze = shouldAnalyze(tio);
@@ -156,6 +166,11 @@ bool AnalyzerBeats::shouldAnalyze(TrackPointer tio) const {
         QString version = pBeats->getVersion();
         QString subVersion = pBeats->getSubVersion();
 
+        if (isPreliminarySubVersion(subVersion)) {
+            qDebug() << "Beats are preliminary results of an unfinished analysis.";
+            return true;
+        }
+
         QHash<QString, QString> extraVersionInfo = getExtraVersionInfo(
                 pluginID,
                 m_bPreferencesFastAnalysis);
@@ -173,6 +188,17 @@ bool AnalyzerBeats::shouldAnalyze(TrackPointer tio) const {
             // sane, re-analyzing will do nothing.
             return false;
         }
+        if (m_bPreferencesFastAnalysis && version == newVersion &&
+                subVersion == BeatFactory::getPreferredSubVersion(
+                        m_bPreferencesFixedTempo,
+                        m_bPreferencesOffsetCorrection,
+                        iMinBpm,
+                        iMaxBpm,
+                        getExtraVersionInfo(pluginID, false))) {
+            // The whole track has been analyzed, e.g. in progressive mode,
+            // which is at least as good as a fast analysis.
+            return false;
+        }
         if (!m_bPreferencesReanalyzeOldBpm) {
             return false;
         }
@@ -205,6 +231,52 @@ bool AnalyzerBeats::processSamples(const CSAMPLE *pIn, const int iLen) {
 
 void AnalyzerBeats::cleanup() {
     m_pPlugin.reset();
+    m_pPreliminaryBeats.reset();
+}
+
+void AnalyzerBeats::storePreliminaryResults(TrackPointer tio) {
+    VERIFY_OR_DEBUG_ASSERT(m_pPlugin) {
+        return;
+    }
+
+    if (!m_pPlugin->supportsBeatTracking() ||
+            !m_pPlugin->computePreliminaryResults()) {
+        return;
+    }
+
+    if (tio->isBpmLocked()) {
+        return;
+    }
+    // Existing beats from a previous analysis are only replaced
+    // by the final results
+    BeatsPointer pCurrentBeats = tio->getBeats();
+    if (pCurrentBeats && !isPreliminarySubVersion(pCurrentBeats->getSubVersion())) {
+        return;
+    }
+
+    QHash<QString, QString> extraVersionInfo = getExtraVersionInfo(
+            m_pluginId, false);
+    extraVersionInfo[mixxx::kPreliminaryVersionKey] = "1";
+    // A grid with a constant tempo is the best guess for the
+    // remaining part of the track that has not been analyzed yet
+    BeatsPointer pBeats = BeatFactory::makePreferredBeats(
+            *tio,
+            m_pPlugin->getBeats(),
+            extraVersionInfo,
+            true,
+            m_bPreferencesOffsetCorrection,
+            m_iSampleRate,
+            m_iCurrentSample,
+            m_iMinBpm,
+            m_iMaxBpm);
+    if (!pBeats) {
+        return;
+    }
+    qDebug() << "AnalyzerBeats stores preliminary BPM:" << pBeats->getBpm();
+    tio->setBeats(pBeats);
+    m_pPreliminaryBeats = pBeats;
+    m_preliminaryBpm = pBeats->getBpm();
+    m_preliminaryFirstBeat = pBeats->findNextBeat(0);
 }
 
 void AnalyzerBeats::storeResults(TrackPointer tio) {
@@ -256,6 +328,26 @@ void AnalyzerBeats::storeResults(TrackPointer tio) {
         return;
     }
 
+    // Preliminary beats are replaced unless they have been edited since
+    // we stored them. Those of an unfinished analysis in an earlier
+    // session are always replaced.
+    if (isPreliminarySubVersion(pCurrentBeats->getSubVersion())) {
+        if (pCurrentBeats != m_pPreliminaryBeats ||
+                (pCurrentBeats->getBpm() == m_preliminaryBpm &&
+                        pCurrentBeats->findNextBeat(0) == m_preliminaryFirstBeat)) {
+            tio->setBeats(pBeats);
+        } else {
+            qDebug() << "Keeping preliminary beats that have been edited while analyzing.";
+            // ...but don't consider them as preliminary anymore
+            QStringList fragments = pCurrentBeats->getSubVersion().split('|');
+            fragments.removeAll(preliminarySubVersionFragment());
+            BeatsPointer pEditedBeats = pCurrentBeats->clone();
+            pEditedBeats->setSubVersion(fragments.join('|'));
+            tio->setBeats(pEditedBeats);
+        }
+        return;
+    }
+
     // If the user prefers to replace old beatgrids with newly generated ones or
     // the old beatgrid has 0-bpm then we replace it.
     bool zeroCurrentBpm = pCurrentBeats->getBpm() == 0.0;
@@ -19,9 +19,13 @@
 
 class AnalyzerBeats : public Analyzer {
   public:
+    // In progressive mode the whole track is analyzed and preliminary
+    // results are stored after the first minute, regardless of the
+    // fast analysis preference.
     explicit AnalyzerBeats(
             UserSettingsPointer pConfig,
-            bool enforceBpmDetection = false);
+            bool enforceBpmDetection = false,
+            bool progressive = false);
     ~AnalyzerBeats() override = default;
 
     static QList<mixxx::AnalyzerPluginInfo> availablePlugins();
@@ -29,6 +33,7 @@ class AnalyzerBeats : public Analyzer {
     bool initialize(TrackPointer tio, int sampleRate, int totalSamples) override;
     bool processSamples(const CSAMPLE *pIn, const int iLen) override;
     void storeResults(TrackPointer tio) override;
+    void storePreliminaryResults(TrackPointer tio) override;
     void cleanup() override;
 
   private:
@@ -39,6 +44,7 @@ class AnalyzerBeats : public Analyzer {
     BeatDetectionSettings m_bpmSettings;
     std::unique_ptr<mixxx::AnalyzerBeatsPlugin> m_pPlugin;
     const bool m_enforceBpmDetection;
+    const bool m_progressive;
     QString m_pluginId;
     bool m_bPreferencesReanalyzeOldBpm;
     bool m_bPreferencesFixedTempo;
@@ -50,6 +56,12 @@ class AnalyzerBeats : public Analyzer {
     int m_iMaxSamplesToProcess;
     int m_iCurrentSample;
     int m_iMinBpm, m_iMaxBpm;
+
+    // The preliminary beats that have been stored and their properties
+    // at that time to detect if they have been edited afterwards
+    BeatsPointer m_pPreliminaryBeats;
+    double m_preliminaryBpm;
+    double m_preliminaryFirstBeat;
 };
 
 #endif /* ANALYZER_ANALYZERBEATS_H */
@@ -16,15 +16,17 @@ QList<mixxx::AnalyzerPluginInfo> AnalyzerKey::availablePlugins() {
     return analyzers;
 }
 
-AnalyzerKey::AnalyzerKey(KeyDetectionSettings keySettings)
+AnalyzerKey::AnalyzerKey(KeyDetectionSettings keySettings, bool progressive)
         : m_keySettings(keySettings),
+          m_progressive(progressive),
           m_iSampleRate(0),
           m_iTotalSamples(0),
           m_iMaxSamplesToProcess(0),
           m_iCurrentSample(0),
           m_bPreferencesKeyDetectionEnabled(true),
           m_bPreferencesFastAnalysisEnabled(false),
-          m_bPreferencesReanalyzeEnabled(false) {
+          m_bPreferencesReanalyzeEnabled(false),
+          m_preliminaryKeysStored(false) {
 }
 
 bool AnalyzerKey::initialize(TrackPointer tio, int sampleRate, int totalSamples) {
@@ -38,7 +40,9 @@ bool AnalyzerKey::initialize(TrackPointer tio, int sampleRate, int totalSamples)
         return false;
     }
 
-    m_bPreferencesFastAnalysisEnabled = m_keySettings.getFastAnalysis();
+    // Progressive mode stores the results of the first minute
+    // instead of stopping there
+    m_bPreferencesFastAnalysisEnabled = m_keySettings.getFastAnalysis() && !m_progressive;
     m_bPreferencesReanalyzeEnabled = m_keySettings.getReanalyzeWhenSettingsChange();
 
     if (AnalyzerKey::availablePlugins().size() > 0) {
@@ -55,7 +59,8 @@ bool AnalyzerKey::initialize(TrackPointer tio, int sampleRate, int totalSamples)
     qDebug() << "AnalyzerKey preference settings:"
              << "\nPlugin:" << m_pluginId
              << "\nRe-analyze when settings change:" << m_bPreferencesReanalyzeEnabled
-             << "\nFast analysis:" << m_bPreferencesFastAnalysisEnabled;
+             << "\nFast analysis:" << m_bPreferencesFastAnalysisEnabled
+             << "\nProgressive:" << m_progressive;
 
     m_iSampleRate = sampleRate;
     m_iTotalSamples = totalSamples;
@@ -67,6 +72,7 @@ bool AnalyzerKey::initialize(TrackPointer tio, int sampleRate, int totalSamples)
         m_iMaxSamplesToProcess = m_iTotalSamples;
     }
     m_iCurrentSample = 0;
+    m_preliminaryKeysStored = false;
 
     // if we can't load a stored track reanalyze it
     bool bShouldAnalyze = shouldAnalyze(tio);
@@ -97,7 +103,6 @@ bool AnalyzerKey::initialize(TrackPointer tio, int sampleRate, int totalSamples)
 }
 
 bool AnalyzerKey::shouldAnalyze(TrackPointer tio) const {
-    bool bPreferencesFastAnalysisEnabled = m_keySettings.getFastAnalysis();
     QString pluginID = m_keySettings.getKeyPluginId();
 
     const Keys keys(tio->getKeys());
@@ -105,8 +110,13 @@ bool AnalyzerKey::shouldAnalyze(TrackPointer tio) const {
         QString version = keys.getVersion();
         QString subVersion = keys.getSubVersion();
 
+        if (isPreliminarySubVersion(subVersion)) {
+            qDebug() << "Keys are preliminary results of an unfinished analysis.";
+            return true;
+        }
+
         QHash<QString, QString> extraVersionInfo = getExtraVersionInfo(
-                pluginID, bPreferencesFastAnalysisEnabled);
+                pluginID, m_bPreferencesFastAnalysisEnabled);
         QString newVersion = KeyFactory::getPreferredVersion();
         QString newSubVersion = KeyFactory::getPreferredSubVersion(extraVersionInfo);
 
@@ -116,6 +126,13 @@ bool AnalyzerKey::shouldAnalyze(TrackPointer tio) const {
             qDebug() << "Keys version/sub-version unchanged since previous analysis. Not analyzing.";
             return false;
         }
+        if (m_bPreferencesFastAnalysisEnabled && version == newVersion &&
+                subVersion == KeyFactory::getPreferredSubVersion(
+                        getExtraVersionInfo(pluginID, false))) {
+            // The whole track has been analyzed, e.g. in progressive mode,
+            // which is at least as good as a fast analysis.
+            return false;
+        }
         if (!m_bPreferencesReanalyzeEnabled) {
             qDebug() << "Track has previous key detection result that is not up"
                      << "to date with latest settings but user preferences"
@@ -143,6 +160,36 @@ void AnalyzerKey::cleanup() {
     m_pPlugin.reset();
 }
 
+void AnalyzerKey::storePreliminaryResults(TrackPointer tio) {
+    VERIFY_OR_DEBUG_ASSERT(m_pPlugin) {
+        return;
+    }
+
+    if (!m_pPlugin->computePreliminaryResults()) {
+        return;
+    }
+
+    // Existing keys from a previous analysis are only replaced
+    // by the final results
+    const Keys currentKeys(tio->getKeys());
+    if (currentKeys.isValid() && !isPreliminarySubVersion(currentKeys.getSubVersion())) {
+        return;
+    }
+
+    QHash<QString, QString> extraVersionInfo = getExtraVersionInfo(
+            m_pluginId, false);
+    extraVersionInfo[mixxx::kPreliminaryVersionKey] = "1";
+    // The global key is weighted by the duration of the analyzed part
+    Keys keys = KeyFactory::makePreferredKeys(
+            m_pPlugin->getKeyChanges(),
+            extraVersionInfo,
+            m_iSampleRate,
+            m_iCurrentSample);
+    qDebug() << "AnalyzerKey stores preliminary key:" << keys.getGlobalKeyText();
+    tio->setKeys(keys);
+    m_preliminaryKeysStored = true;
+}
+
 void AnalyzerKey::storeResults(TrackPointer tio) {
     VERIFY_OR_DEBUG_ASSERT(m_pPlugin) {
         return;
@@ -158,6 +205,13 @@ void AnalyzerKey::storeResults(TrackPointer tio) {
             m_pluginId, m_bPreferencesFastAnalysisEnabled);
     Keys track_keys = KeyFactory::makePreferredKeys(
             key_changes, extraVersionInfo, m_iSampleRate, m_iTotalSamples);
+    if (m_preliminaryKeysStored) {
+        const Keys currentKeys(tio->getKeys());
+        if (currentKeys.isValid() && !isPreliminarySubVersion(currentKeys.getSubVersion())) {
+            qDebug() << "Keeping the key that has been changed while analyzing.";
+            return;
+        }
+    }
     tio->setKeys(track_keys);
 }
 
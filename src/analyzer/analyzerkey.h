@@ -14,7 +14,12 @@
 
 class AnalyzerKey : public Analyzer {
   public:
-    explicit AnalyzerKey(KeyDetectionSettings keySettings);
+    // In progressive mode the whole track is analyzed and preliminary
+    // results are stored after the first minute, regardless of the
+    // fast analysis preference.
+    explicit AnalyzerKey(
+            KeyDetectionSettings keySettings,
+            bool progressive = false);
     ~AnalyzerKey() override = default;
 
     static QList<mixxx::AnalyzerPluginInfo> availablePlugins();
@@ -22,6 +27,7 @@ class AnalyzerKey : public Analyzer {
     bool initialize(TrackPointer tio, int sampleRate, int totalSamples) override;
     bool processSamples(const CSAMPLE *pIn, const int iLen) override;
     void storeResults(TrackPointer tio) override;
+    void storePreliminaryResults(TrackPointer tio) override;
     void cleanup() override;
 
   private:
@@ -31,6 +37,7 @@ class AnalyzerKey : public Analyzer {
     bool shouldAnalyze(TrackPointer tio) const;
 
     KeyDetectionSettings m_keySettings;
+    const bool m_progressive;
     std::unique_ptr<mixxx::AnalyzerKeyPlugin> m_pPlugin;
     QString m_pluginId;
     int m_iSampleRate;
@@ -41,6 +48,7 @@ class AnalyzerKey : public Analyzer {
     bool m_bPreferencesKeyDetectionEnabled;
     bool m_bPreferencesFastAnalysisEnabled;
     bool m_bPreferencesReanalyzeEnabled;
+    bool m_preliminaryKeysStored;
 };
 
 #endif /* ANALYZER_ANALYZERKEY_H */
@@ -1,5 +1,6 @@
 #include "analyzer/analyzerthread.h"
 
+#include <functional>
 #include <mutex>
 
 #include "analyzer/analyzerbeats.h"
@@ -15,6 +16,7 @@
 #include "engine/engine.h"
 
 #include "sources/audiosourcestereoproxy.h"
+#include "sources/decodedblockcache.h"
 #include "sources/soundsourceproxy.h"
 
 #include "util/db/dbconnectionpooled.h"
@@ -44,6 +46,23 @@ void deleteAnalyzerThread(AnalyzerThread* plainPtr) {
     }
 }
 
+// Runs the remaining analysis of a track in progressive mode on a
+// short-lived thread with its own priority.
+class RefinementThread : public QThread {
+  public:
+    explicit RefinementThread(std::function<void()> analyze)
+            : m_analyze(std::move(analyze)) {
+    }
+
+  protected:
+    void run() override {
+        m_analyze();
+    }
+
+  private:
+    const std::function<void()> m_analyze;
+};
+
 std::once_flag registerMetaTypesOnceFlag;
 
 void registerMetaTypesOnce() {
@@ -51,6 +70,7 @@ void registerMetaTypesOnce() {
     // AnalyzerProgress is just an alias/typedef and must be registered explicitly
     // by name!
     qRegisterMetaType<AnalyzerProgress>("AnalyzerProgress");
+    qRegisterMetaType<mixxx::Duration>("mixxx::Duration");
 }
 
 } // anonymous namespace
@@ -84,7 +104,7 @@ AnalyzerThread::AnalyzerThread(
           m_pConfig(std::move(pConfig)),
           m_modeFlags(modeFlags),
           m_nextTrack(MpscFifoConcurrency::SingleProducer),
-          m_sampleBuffer(mixxx::kAnalysisSamplesPerBlock),
+          m_sampleBuffer(mixxx::DecodedBlockCache::kBlockFrames * mixxx::kAnalysisChannels),
           m_emittedState(AnalyzerThreadState::Void) {
     std::call_once(registerMetaTypesOnceFlag, registerMetaTypesOnce);
 }
@@ -114,8 +134,9 @@ void AnalyzerThread::doRun() {
     // BPM detection might be disabled in the config, but can be overridden
     // and enabled by explicitly setting the mode flag.
     const bool enforceBpmDetection = (m_modeFlags & AnalyzerModeFlags::WithBeats) != 0;
-    m_analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerBeats>(m_pConfig, enforceBpmDetection)));
-    m_analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerKey>(m_pConfig)));
+    const bool progressive = (m_modeFlags & AnalyzerModeFlags::Progressive) != 0;
+    m_analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerBeats>(m_pConfig, enforceBpmDetection, progressive)));
+    m_analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerKey>(m_pConfig, progressive)));
     m_analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerSilence>(m_pConfig)));
     DEBUG_ASSERT(!m_analyzers.empty());
     kLogger.debug() << "Activated" << m_analyzers.size() << "analyzers";
@@ -152,6 +173,8 @@ void AnalyzerThread::doRun() {
         }
 
         if (processTrack) {
+            m_decodeDuration = mixxx::Duration();
+            m_analysisDuration = mixxx::Duration();
             const auto analysisResult = analyzeAudioSource(audioSource);
             DEBUG_ASSERT(analysisResult != AnalysisResult::Pending);
             if ((analysisResult == AnalysisResult::Complete) ||
@@ -164,9 +187,13 @@ void AnalyzerThread::doRun() {
                 // suddenly.
                 emitBusyProgress(kAnalyzerProgressFinalizing);
                 // This takes around 3 sec on a Atom Netbook
+                PerformanceTimer finishTimer;
+                finishTimer.start();
                 for (auto&& analyzer : m_analyzers) {
                     analyzer.finish(m_currentTrack);
                 }
+                m_analysisDuration += finishTimer.elapsed();
+                emit durations(m_id, m_decodeDuration, m_analysisDuration);
                 emitDoneProgress(kAnalyzerProgressDone);
             } else {
                 for (auto&& analyzer : m_analyzers) {
@@ -224,51 +251,106 @@ AnalyzerThread::AnalysisResult AnalyzerThread::analyzeAudioSource(
 
     mixxx::AudioSourceStereoProxy audioSourceProxy(
             audioSource,
-            mixxx::kAnalysisFramesPerBlock);
+            mixxx::DecodedBlockCache::kBlockFrames);
     DEBUG_ASSERT(audioSourceProxy.channelCount() == mixxx::kAnalysisChannels);
 
+    // Blocks that have already been decoded for playing the track in a
+    // deck are taken from there instead of decoding them again and vice
+    // versa.
+    const mixxx::DecodedBlockCache::Consumer decodedBlocks(
+            mixxx::DecodedBlockCache::instance(),
+            m_currentTrack->getLocation(),
+            audioSource->frameIndexRange(),
+            audioSource->sampleRate());
+
     // Analysis starts now
     emitBusyProgress(kAnalyzerProgressNone);
 
+    // In progressive mode preliminary results are stored after the first
+    // minute and the remaining track is analyzed with idle priority
+    SINT preliminaryFrameIndex = audioSource->frameIndexMax();
+    if (m_modeFlags & AnalyzerModeFlags::Progressive) {
+        preliminaryFrameIndex = audioSource->frameIndexMin() +
+                mixxx::kFastAnalysisSecondsToAnalyze * audioSource->sampleRate();
+    }
+    bool preliminaryResultsStored = false;
+
+    PerformanceTimer timer;
     mixxx::IndexRange remainingFrames = audioSource->frameIndexRange();
-    auto result = remainingFrames.empty() ? AnalysisResult::Complete : AnalysisResult::Pending;
-    while (result == AnalysisResult::Pending) {
+    SINT blockIndex = 0;
+    const auto analyzeNextBlock = [&]() -> AnalysisResult {
         DEBUG_ASSERT(!remainingFrames.empty());
+        auto result = AnalysisResult::Pending;
         sleepWhileSuspended();
         if (isStopping()) {
             return AnalysisResult::Cancelled;
         }
 
-        // 1st step: Decode next chunk of audio data
+        // 1st step: Decode next block of audio data or take it from
+        // the deck that has decoded it before
         const auto inputFrameIndexRange =
                 remainingFrames.splitAndShrinkFront(
-                        math_min(mixxx::kAnalysisFramesPerBlock, remainingFrames.length()));
+                        math_min(mixxx::DecodedBlockCache::kBlockFrames, remainingFrames.length()));
         DEBUG_ASSERT(!inputFrameIndexRange.empty());
-        const auto readableSampleFrames =
-                audioSourceProxy.readSampleFrames(
-                        mixxx::WritableSampleFrames(
-                                inputFrameIndexRange,
-                                mixxx::SampleBuffer::WritableSlice(m_sampleBuffer)));
+        mixxx::ReadableSampleFrames readableSampleFrames;
+        const mixxx::DecodedBlockPointer pDecodedBlock =
+                decodedBlocks.takeBlock(blockIndex);
+        if (pDecodedBlock) {
+            DEBUG_ASSERT(pDecodedBlock->frameIndexRange() == inputFrameIndexRange);
+            readableSampleFrames = pDecodedBlock->readableSampleFrames();
+        } else {
+            timer.start();
+            readableSampleFrames =
+                    audioSourceProxy.readSampleFrames(
+                            mixxx::WritableSampleFrames(
+                                    inputFrameIndexRange,
+                                    mixxx::SampleBuffer::WritableSlice(m_sampleBuffer)));
+            m_decodeDuration += timer.elapsed();
+            decodedBlocks.publishBlock(blockIndex, readableSampleFrames);
+        }
+        ++blockIndex;
 
         sleepWhileSuspended();
         if (isStopping()) {
             return AnalysisResult::Cancelled;
         }
 
-        // 2nd: step: Analyze chunk of decoded audio data
-        if (readableSampleFrames.frameLength() == mixxx::kAnalysisFramesPerBlock ||
+        // 2nd: step: Analyze block of decoded audio data in chunks
+        // of the size that the analyzers expect
+        if (readableSampleFrames.frameLength() == mixxx::DecodedBlockCache::kBlockFrames ||
                 remainingFrames.empty()) {
-            // Complete chunk of audio samples has been read for analysis
-            for (auto&& analyzer : m_analyzers) {
-                analyzer.processSamples(
-                        readableSampleFrames.readableData(),
-                        readableSampleFrames.readableLength());
+            // Complete block of audio samples has been read for analysis
+            timer.start();
+            for (SINT offset = 0;
+                    offset < readableSampleFrames.readableLength();
+                    offset += mixxx::kAnalysisSamplesPerBlock) {
+                const SINT length = math_min(
+                        mixxx::kAnalysisSamplesPerBlock,
+                        readableSampleFrames.readableLength(offset));
+                for (auto&& analyzer : m_analyzers) {
+                    analyzer.processSamples(
+                            readableSampleFrames.readableData(offset),
+                            length);
+                }
             }
+            m_analysisDuration += timer.elapsed();
             if (remainingFrames.empty()) {
                 result = AnalysisResult::Complete;
+            } else if (remainingFrames.start() >= preliminaryFrameIndex) {
+                kLogger.debug()
+                        << "Storing preliminary results after"
+                        << mixxx::kFastAnalysisSecondsToAnalyze
+                        << "seconds";
+                timer.start();
+                for (auto&& analyzer : m_analyzers) {
+                    analyzer.storePreliminaryResults(m_currentTrack);
+                }
+                m_analysisDuration += timer.elapsed();
+                preliminaryFrameIndex = audioSource->frameIndexMax();
+                preliminaryResultsStored = true;
             }
         } else {
-            // Partial chunk of audio samples has been read, but not the final.
+            // Partial block of audio samples has been read, but not the final.
             // A decoding error must have occurred, maybe a corrupt file?
             kLogger.warning()
                     << "Aborting analysis after failure to read sample data:"
@@ -290,6 +372,26 @@ AnalyzerThread::AnalysisResult AnalyzerThread::analyzeAudioSource(
         DEBUG_ASSERT(progress > kAnalyzerProgressNone);
         DEBUG_ASSERT(progress <= kAnalyzerProgressFinalizing);
         emitBusyProgress(progress);
+        return result;
+    };
+
+    auto result = remainingFrames.empty() ? AnalysisResult::Complete : AnalysisResult::Pending;
+    while (result == AnalysisResult::Pending && !preliminaryResultsStored) {
+        result = analyzeNextBlock();
+    }
+    if (result == AnalysisResult::Pending) {
+        // The remaining track is analyzed on a separate thread with idle
+        // priority while this thread is blocked. Lowering the priority of
+        // this thread instead could not be undone on Linux, where
+        // QThread::IdlePriority switches to SCHED_IDLE and unprivileged
+        // threads are not allowed to leave it again.
+        RefinementThread refinementThread([&] {
+            while (result == AnalysisResult::Pending) {
+                result = analyzeNextBlock();
+            }
+        });
+        refinementThread.start(QThread::IdlePriority);
+        refinementThread.wait();
     }
 
     return result;
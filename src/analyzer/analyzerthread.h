@@ -20,6 +20,9 @@ enum AnalyzerModeFlags {
     WithBeats = 0x01,
     WithWaveform = 0x02,
     All = WithBeats | WithWaveform,
+    // Store preliminary results after the first minute and continue
+    // analyzing the remaining track with idle priority
+    Progressive = 0x04,
 };
 
 enum class AnalyzerThreadState {
@@ -85,6 +88,11 @@ class AnalyzerThread : public WorkerThread {
     // AnalyzerThreadProgress object and register it as a new meta type.
     void progress(int threadId, AnalyzerThreadState threadState, TrackId trackId, AnalyzerProgress trackProgress);
 
+    // Emitted after a track has been analyzed with the time spent for
+    // decoding and analyzing its audio data. Only used for statistics,
+    // i.e. the order relative to the progress() signals doesn't matter.
+    void durations(int threadId, mixxx::Duration decodeDuration, mixxx::Duration analysisDuration);
+
   protected:
     void doRun() override;
 
@@ -111,7 +119,8 @@ class AnalyzerThread : public WorkerThread {
 
     /////////////////////////////////////////////////////////////////////////
     // Thread local: Only used in the constructor/destructor and within
-    // run() by the worker thread.
+    // run() by the worker thread. In progressive mode also used by the
+    // refinement thread while the worker thread waits for it.
 
     std::vector<AnalyzerWithState> m_analyzers;
 
@@ -123,6 +132,10 @@ class AnalyzerThread : public WorkerThread {
 
     PerformanceTimer m_lastBusyProgressEmittedTimer;
 
+    // Accumulated while analyzing the current track
+    mixxx::Duration m_decodeDuration;
+    mixxx::Duration m_analysisDuration;
+
     enum class AnalysisResult {
         Pending,
         Partial,
@@ -14,7 +14,12 @@ constexpr SINT kAnalysisFramesPerBlock = 4096;
 constexpr SINT kAnalysisSamplesPerBlock =
         kAnalysisFramesPerBlock * kAnalysisChannels;
 
-// Only analyze the first minute in fast-analysis mode.
+// Only analyze the first minute in fast-analysis mode. In progressive
+// mode preliminary results are stored after the first minute.
 constexpr int kFastAnalysisSecondsToAnalyze = 60;
 
+// Key of the sub-version fragment that marks preliminary results,
+// which are replaced when the analysis of the whole track finishes.
+constexpr const char* kPreliminaryVersionKey = "preliminary";
+
 }  // namespace mixxx
@@ -43,6 +43,14 @@ class AnalyzerPlugin {
     virtual bool initialize(int samplerate) = 0;
     virtual bool processSamples(const CSAMPLE* pIn, const int iLen) = 0;
     virtual bool finalize() = 0;
+
+    // Computes preliminary results from the samples that have been
+    // processed so far and makes them available like the results of
+    // finalize(). Processing may continue afterwards. Returns false
+    // if not supported.
+    virtual bool computePreliminaryResults() {
+        return false;
+    }
 };
 
 class AnalyzerBeatsPlugin : public AnalyzerPlugin {
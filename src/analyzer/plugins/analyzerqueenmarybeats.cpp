@@ -63,7 +63,23 @@ bool AnalyzerQueenMaryBeats::processSamples(const CSAMPLE* pIn, const int iLen)
 
 bool AnalyzerQueenMaryBeats::finalize() {
     m_helper.finalize();
+    computeBeats();
+    m_pDetectionFunction.reset();
+    return true;
+}
 
+bool AnalyzerQueenMaryBeats::computePreliminaryResults() {
+    if (!m_pDetectionFunction || m_detectionResults.empty()) {
+        return false;
+    }
+    // The samples that are still buffered by the helper are
+    // not considered, but the beat tracking doesn't modify
+    // the detection results.
+    computeBeats();
+    return true;
+}
+
+void AnalyzerQueenMaryBeats::computeBeats() {
     int nonZeroCount = m_detectionResults.size();
     while (nonZeroCount > 0 && m_detectionResults.at(nonZeroCount - 1) <= 0.0) {
         --nonZeroCount;
@@ -108,14 +124,12 @@ bool AnalyzerQueenMaryBeats::finalize() {
         }
     }
 
+    m_resultBeats.clear();
     m_resultBeats.reserve(beats.size());
     for (size_t i = firstBeat; i < beats.size(); ++i) {
         double result = (beats.at(i) * kStepSize) - kStepSize / 2;
         m_resultBeats.push_back(result);
     }
-
-    m_pDetectionFunction.reset();
-    return true;
 }
 
 } // namespace mixxx
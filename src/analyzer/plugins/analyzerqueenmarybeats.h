@@ -36,6 +36,7 @@ class AnalyzerQueenMaryBeats : public AnalyzerBeatsPlugin {
     bool initialize(int samplerate) override;
     bool processSamples(const CSAMPLE* pIn, const int iLen) override;
     bool finalize() override;
+    bool computePreliminaryResults() override;
 
     bool supportsBeatTracking() const override {
         return true;
@@ -46,6 +47,8 @@ class AnalyzerQueenMaryBeats : public AnalyzerBeatsPlugin {
     }
 
   private:
+    void computeBeats();
+
     std::unique_ptr<DetectionFunction> m_pDetectionFunction;
     DownmixAndOverlapHelper m_helper;
     int m_iSampleRate;
@@ -36,6 +36,10 @@ class AnalyzerQueenMaryKey : public AnalyzerKeyPlugin {
     bool initialize(int samplerate) override;
     bool processSamples(const CSAMPLE* pIn, const int iLen) override;
     bool finalize() override;
+    bool computePreliminaryResults() override {
+        // The key changes are collected while processing
+        return m_pKeyMode != nullptr;
+    }
 
     KeyChangeList getKeyChanges() const override {
         return m_resultKeys;
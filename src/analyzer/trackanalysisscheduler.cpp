@@ -1,5 +1,6 @@
 #include "analyzer/trackanalysisscheduler.h"
 
+#include "control/controlproxy.h"
 #include "library/library.h"
 #include "library/trackcollection.h"
 
@@ -15,6 +16,15 @@ constexpr QThread::Priority kWorkerThreadPriority = QThread::LowPriority;
 // Maximum frequency of progress updates
 constexpr std::chrono::milliseconds kProgressInhibitDuration(100);
 
+// Leave CPU time to the engine if the audio callback uses more than
+// this share of the available time.
+constexpr double kModerateAudioLatencyUsage = 0.5;
+constexpr double kHighAudioLatencyUsage = 0.75;
+
+// Maximum frequency of adapting the number of worker threads to the
+// load of the audio callback
+constexpr std::chrono::milliseconds kWorkersUpdateInterval(1000);
+
 void deleteTrackAnalysisScheduler(TrackAnalysisScheduler* plainPtr) {
     if (plainPtr) {
         // Trigger stop
@@ -53,8 +63,14 @@ TrackAnalysisScheduler::TrackAnalysisScheduler(
           m_currentTrackProgress(kAnalyzerProgressUnknown),
           m_currentTrackNumber(0),
           m_dequeuedTracksCount(0),
+          m_suspended(true),
+          m_preemptedWorkersCount(0),
+          m_pAudioLatencyUsage(new ControlProxy(
+                  "[Master]", "audio_latency_usage", this)),
           // The first signal should always be emitted
-          m_lastProgressEmittedAt(Clock::now() - kProgressInhibitDuration) {
+          m_lastProgressEmittedAt(Clock::now() - kProgressInhibitDuration),
+          m_lastWorkersUpdatedAt(Clock::now()),
+          m_analysisStartedAt(Clock::now()) {
     VERIFY_OR_DEBUG_ASSERT(numWorkerThreads > 0) {
             kLogger.warning()
                     << "Invalid number of worker threads:"
@@ -75,10 +91,12 @@ TrackAnalysisScheduler::TrackAnalysisScheduler(
                 modeFlags));
         connect(m_workers.back().thread(), &AnalyzerThread::progress,
             this, &TrackAnalysisScheduler::onWorkerThreadProgress);
+        connect(m_workers.back().thread(), &AnalyzerThread::durations,
+            this, &TrackAnalysisScheduler::onWorkerThreadDurations);
     }
     // 2nd pass: Start worker threads in a suspended state
-    for (const auto& worker: m_workers) {
-        worker.thread()->suspend();
+    for (auto& worker: m_workers) {
+        worker.suspendThread();
         worker.thread()->start(kWorkerThreadPriority);
     }
 }
@@ -170,6 +188,16 @@ void TrackAnalysisScheduler::emitProgressOrFinished() {
             m_currentTrackProgress,
             m_currentTrackNumber,
             totalTracksCount);
+
+    const double elapsedMinutes =
+            std::chrono::duration<double, std::ratio<60>>(
+                    now - m_analysisStartedAt).count();
+    const double tracksPerMinute = elapsedMinutes > 0 ?
+            finishedTracksCount / elapsedMinutes : 0;
+    emit throughput(
+            tracksPerMinute,
+            m_decodeDuration,
+            m_analysisDuration);
 }
 
 void TrackAnalysisScheduler::onWorkerThreadProgress(
@@ -193,8 +221,11 @@ void TrackAnalysisScheduler::onWorkerThreadProgress(
     case AnalyzerThreadState::Idle:
         DEBUG_ASSERT(!trackId.isValid());
         DEBUG_ASSERT(analyzerProgress == kAnalyzerProgressUnknown);
-        worker.onAnalyzerProgress(analyzerProgress);
-        submitNextTrack(&worker);
+        worker.onIdle();
+        // Preempted and suspended workers don't receive new tracks
+        if (!m_suspended && threadId < activeWorkersCount()) {
+            submitNextTrack(&worker);
+        }
         break;
     case AnalyzerThreadState::Busy:
         DEBUG_ASSERT(trackId.isValid());
@@ -202,7 +233,7 @@ void TrackAnalysisScheduler::onWorkerThreadProgress(
         if (m_pendingTrackIds.find(trackId) != m_pendingTrackIds.end()) {
             DEBUG_ASSERT(analyzerProgress != kAnalyzerProgressUnknown);
             DEBUG_ASSERT(analyzerProgress < kAnalyzerProgressDone);
-            worker.onAnalyzerProgress(analyzerProgress);
+            worker.onBusy(analyzerProgress);
             emit trackProgress(trackId, analyzerProgress);
         }
         break;
@@ -226,9 +257,20 @@ void TrackAnalysisScheduler::onWorkerThreadProgress(
     default:
         DEBUG_ASSERT(!"Unhandled signal from worker thread");
     }
+    if (Clock::now() >= m_lastWorkersUpdatedAt + kWorkersUpdateInterval) {
+        updateWorkers();
+    }
     emitProgressOrFinished();
 }
 
+void TrackAnalysisScheduler::onWorkerThreadDurations(
+        int /*threadId*/,
+        mixxx::Duration decodeDuration,
+        mixxx::Duration analysisDuration) {
+    m_decodeDuration += decodeDuration;
+    m_analysisDuration += analysisDuration;
+}
+
 bool TrackAnalysisScheduler::scheduleTrackById(TrackId trackId) {
     VERIFY_OR_DEBUG_ASSERT(trackId.isValid()) {
         qWarning()
@@ -236,6 +278,12 @@ bool TrackAnalysisScheduler::scheduleTrackById(TrackId trackId) {
                 << trackId;
         return false;
     }
+    if (allTracksFinished()) {
+        // A new analysis starts
+        m_analysisStartedAt = Clock::now();
+        m_decodeDuration = mixxx::Duration();
+        m_analysisDuration = mixxx::Duration();
+    }
     m_queuedTrackIds.push_back(trackId);
     // Don't wake up the suspended thread now to avoid race conditions
     // if multiple threads are added in a row by calling this function
@@ -256,15 +304,58 @@ int TrackAnalysisScheduler::scheduleTracksById(const QList<TrackId>& trackIds) {
 
 void TrackAnalysisScheduler::suspend() {
     kLogger.debug() << "Suspending";
-    for (auto& worker: m_workers) {
-        worker.suspendThread();
-    }
+    m_suspended = true;
+    updateWorkers();
 }
 
 void TrackAnalysisScheduler::resume() {
     kLogger.debug() << "Resuming";
-    for (auto& worker: m_workers) {
-        worker.resumeThread();
+    m_suspended = false;
+    updateWorkers();
+}
+
+void TrackAnalysisScheduler::preempt(int workersCount) {
+    DEBUG_ASSERT(workersCount >= 0);
+    if (m_preemptedWorkersCount == workersCount) {
+        return;
+    }
+    kLogger.debug() << "Preempting" << workersCount << "worker threads";
+    m_preemptedWorkersCount = workersCount;
+    updateWorkers();
+}
+
+int TrackAnalysisScheduler::activeWorkersCount() const {
+    int workersCount = static_cast<int>(m_workers.size()) -
+            m_preemptedWorkersCount;
+    const double audioLatencyUsage = m_pAudioLatencyUsage->get();
+    if (audioLatencyUsage >= kHighAudioLatencyUsage) {
+        workersCount = math_min(workersCount, 1);
+    } else if (audioLatencyUsage >= kModerateAudioLatencyUsage) {
+        // Leave one core to the engine
+        workersCount = math_min(workersCount,
+                math_max(1, QThread::idealThreadCount() - 1));
+    }
+    return math_max(workersCount, 0);
+}
+
+void TrackAnalysisScheduler::updateWorkers() {
+    m_lastWorkersUpdatedAt = Clock::now();
+    const int activeCount = m_suspended ? 0 : activeWorkersCount();
+    for (int threadId = 0; threadId < static_cast<int>(m_workers.size()); ++threadId) {
+        auto& worker = m_workers[threadId];
+        if (!worker) {
+            // Already exited
+            continue;
+        }
+        if (threadId < activeCount) {
+            worker.resumeThread();
+            if (worker.isIdle()) {
+                submitNextTrack(&worker);
+            }
+        } else {
+            // The thread pauses at the next block boundary
+            worker.suspendThread();
+        }
     }
 }
 
@@ -8,10 +8,12 @@
 
 #include "analyzer/analyzerthread.h"
 
+#include "util/duration.h"
 #include "util/memory.h"
 
 
 // forward declaration(s)
+class ControlProxy;
 class Library;
 
 class TrackAnalysisScheduler : public QObject {
@@ -51,6 +53,12 @@ class TrackAnalysisScheduler : public QObject {
     // https://bugs.launchpad.net/mixxx/+bug/1443181
     QList<TrackId> stopAndCollectScheduledTrackIds();
 
+    // The number of tracks that are either queued or currently analyzed.
+    int scheduledTracksCount() const {
+        return static_cast<int>(
+                m_queuedTrackIds.size() + m_pendingTrackIds.size());
+    }
+
   public slots:
     void suspend();
 
@@ -58,6 +66,13 @@ class TrackAnalysisScheduler : public QObject {
     // Resume must also be called after suspending the analysis.
     void resume();
 
+    // Pauses the given number of worker threads at the next block
+    // boundary to leave their CPU cores to a more urgent analysis,
+    // e.g. of tracks that have just been loaded into a deck. The
+    // remaining worker threads continue. Pass 0 to continue with all
+    // worker threads.
+    void preempt(int workersCount);
+
     // Stops a running analysis and discards all enqueued tracks.
     void stop();
 
@@ -66,10 +81,14 @@ class TrackAnalysisScheduler : public QObject {
     void trackProgress(TrackId trackId, AnalyzerProgress analyzerProgress);
     // Current average progress for all scheduled tracks and from all workers
     void progress(AnalyzerProgress currentTrackProgress, int currentTrackNumber, int totalTracksCount);
+    // Throughput since the analysis has been started, emitted together with
+    // progress(). The durations are summed up over all worker threads.
+    void throughput(double tracksPerMinute, mixxx::Duration decodeDuration, mixxx::Duration analysisDuration);
     void finished();
 
   private slots:
     void onWorkerThreadProgress(int threadId, AnalyzerThreadState threadState, TrackId trackId, AnalyzerProgress analyzerProgress);
+    void onWorkerThreadDurations(int threadId, mixxx::Duration decodeDuration, mixxx::Duration analysisDuration);
 
   private:
     // Owns an analyzer thread and buffers the most recent progress update
@@ -80,7 +99,9 @@ class TrackAnalysisScheduler : public QObject {
       public:
         explicit Worker(AnalyzerThread::Pointer thread = AnalyzerThread::NullPointer())
             : m_thread(std::move(thread)),
-              m_analyzerProgress(kAnalyzerProgressUnknown) {
+              m_analyzerProgress(kAnalyzerProgressUnknown),
+              m_idle(false),
+              m_threadSuspended(false) {
         }
         Worker(const Worker&) = delete;
         Worker(Worker&&) = default;
@@ -98,21 +119,34 @@ class TrackAnalysisScheduler : public QObject {
             return m_analyzerProgress;
         }
 
+        // The thread has reported that it is waiting for the next track
+        bool isIdle() const {
+            return m_idle;
+        }
+
         bool submitNextTrack(TrackPointer track) {
             DEBUG_ASSERT(track);
             DEBUG_ASSERT(m_thread);
-            return m_thread->submitNextTrack(std::move(track));
+            if (m_thread->submitNextTrack(std::move(track))) {
+                m_idle = false;
+                return true;
+            }
+            return false;
         }
 
+        // Only the transitions are passed on to the thread, because
+        // resuming always wakes up the thread.
         void suspendThread() {
-            if (m_thread) {
+            if (m_thread && !m_threadSuspended) {
                 m_thread->suspend();
+                m_threadSuspended = true;
             }
         }
 
         void resumeThread() {
-            if (m_thread) {
+            if (m_thread && m_threadSuspended) {
                 m_thread->resume();
+                m_threadSuspended = false;
             }
         }
 
@@ -127,20 +161,43 @@ class TrackAnalysisScheduler : public QObject {
             m_analyzerProgress = analyzerProgress;
         }
 
+        void onIdle() {
+            DEBUG_ASSERT(m_thread);
+            m_idle = true;
+            m_analyzerProgress = kAnalyzerProgressUnknown;
+        }
+
+        void onBusy(AnalyzerProgress analyzerProgress) {
+            DEBUG_ASSERT(m_thread);
+            m_idle = false;
+            m_analyzerProgress = analyzerProgress;
+        }
+
         void onThreadExit() {
             DEBUG_ASSERT(m_thread);
             m_thread.reset();
             m_analyzerProgress = kAnalyzerProgressUnknown;
+            m_idle = false;
         }
 
       private:
         AnalyzerThread::Pointer m_thread;
         AnalyzerProgress m_analyzerProgress;
+        bool m_idle;
+        bool m_threadSuspended;
     };
 
     bool submitNextTrack(Worker* worker);
     void emitProgressOrFinished();
 
+    // The number of worker threads that may analyze tracks, depending
+    // on preemption and on the load of the audio callback.
+    int activeWorkersCount() const;
+
+    // Suspends or resumes the worker threads according to
+    // activeWorkersCount() and submits tracks to idle workers.
+    void updateWorkers();
+
     bool allTracksFinished() const {
         return m_queuedTrackIds.empty() &&
                 m_pendingTrackIds.empty();
@@ -162,6 +219,18 @@ class TrackAnalysisScheduler : public QObject {
 
     int m_dequeuedTracksCount;
 
+    bool m_suspended;
+
+    int m_preemptedWorkersCount;
+
+    ControlProxy* m_pAudioLatencyUsage;
+
     typedef std::chrono::steady_clock Clock;
     Clock::time_point m_lastProgressEmittedAt;
+    Clock::time_point m_lastWorkersUpdatedAt;
+
+    // Throughput statistics since the analysis has been started
+    Clock::time_point m_analysisStartedAt;
+    mixxx::Duration m_decodeDuration;
+    mixxx::Duration m_analysisDuration;
 };
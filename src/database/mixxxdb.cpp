@@ -11,12 +11,45 @@
 const QString MixxxDb::kDefaultSchemaFile(":/schema.xml");
 
 //static
-const int MixxxDb::kRequiredSchemaVersion = 29;
+const int MixxxDb::kRequiredSchemaVersion = 31;
 
 namespace {
 
 const mixxx::Logger kLogger("MixxxDb");
 
+const QString kConfigGroup = "[Library]";
+
+// Either "performance" (default) or "default" for the defaults of SQLite
+const ConfigKey kDbProfileKey(kConfigGroup, "DbProfile");
+// Overrides of the profile, 0 disables memory-mapped I/O
+const ConfigKey kDbCacheSizeMiBKey(kConfigGroup, "DbCacheSizeMiB");
+const ConfigKey kDbMmapSizeMiBKey(kConfigGroup, "DbMmapSizeMiB");
+
+mixxx::DbConnection::Tuning dbConnectionTuning(
+        const UserSettingsPointer& pConfig) {
+    const QString profile = pConfig->getValue(
+            kDbProfileKey, "performance");
+    mixxx::DbConnection::Tuning tuning;
+    if (profile == "default") {
+        tuning = mixxx::DbConnection::Tuning::defaults();
+    } else {
+        if (profile != "performance") {
+            kLogger.warning()
+                    << "Unknown database profile"
+                    << profile;
+        }
+        tuning = mixxx::DbConnection::Tuning::performance();
+    }
+    if (pConfig->exists(kDbCacheSizeMiBKey)) {
+        tuning.cacheSizeKiB = pConfig->getValue(kDbCacheSizeMiBKey, 0) * 1024;
+    }
+    if (pConfig->exists(kDbMmapSizeMiBKey)) {
+        tuning.mmapSize = pConfig->getValue(kDbMmapSizeMiBKey, 0) *
+                qint64(1024 * 1024);
+    }
+    return tuning;
+}
+
 // The connection parameters for the main Mixxx DB
 mixxx::DbConnection::Params dbConnectionParams(
         const UserSettingsPointer& pConfig,
@@ -27,6 +60,7 @@ mixxx::DbConnection::Params dbConnectionParams(
     params.filePath = inMemoryConnection ? QString(":memory:") : QDir(pConfig->getSettingsPath()).filePath("mixxxdb.sqlite");
     params.userName = "mixxx";
     params.password = "mixxx";
+    params.tuning = dbConnectionTuning(pConfig);
     return params;
 }
 
@@ -56,6 +56,14 @@ class EngineBufferScale : public QObject {
 
     // Called from EngineBuffer when seeking, to ensure the buffers are flushed */
     virtual void clear() = 0;
+    // Returns true if the scaler has rendered output ahead of the play
+    // position with the current scale parameters. Before changing the
+    // parameters EngineBuffer then crossfades from the rendered output and
+    // restarts the scaler at the play position, because the read-ahead
+    // position is too far ahead of it.
+    virtual bool hasLookAhead() const {
+        return false;
+    }
     // Scale buffer
     // Returns the number of frames that have bean read from the unscaled
     // input buffer The number of frames copied to the output buffer is always
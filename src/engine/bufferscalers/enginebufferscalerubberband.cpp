@@ -4,11 +4,11 @@
 
 #include <QtDebug>
 
-#include "control/controlobject.h"
 #include "engine/readaheadmanager.h"
 #include "track/keyutils.h"
 #include "util/counter.h"
 #include "util/defs.h"
+#include "util/assert.h"
 #include "util/math.h"
 #include "util/sample.h"
 
@@ -19,19 +19,53 @@ namespace {
 // This is the default increment from RubberBand 1.8.1.
 size_t kRubberBandBlockSize = 256;
 
+// Callbacks with unchanged scale parameters before the stretching is
+// moved to the worker
+const int kSteadyCallbacksBeforeLookAhead = 16;
+
+// The worker output needs some time to settle after it has been reset.
+// This is the minimum number of frames that are stretched by both the
+// callback and the worker before switching to the worker output.
+const SINT kMinPrimingFrames = 16384;
+
+// How far the worker stretches ahead of the output in frames
+const SINT kLookAheadFrames = 4096;
+
+const QString kInCallbackCounter = QStringLiteral(
+        "EngineBufferScaleRubberBand::scaleBuffer in callback");
+const QString kLookAheadCounter = QStringLiteral(
+        "EngineBufferScaleRubberBand::scaleBuffer look-ahead");
+const QString kLookAheadUnderflowCounter = QStringLiteral(
+        "EngineBufferScaleRubberBand::scaleBuffer look-ahead underflow");
+
 }  // namespace
 
 EngineBufferScaleRubberBand::EngineBufferScaleRubberBand(
         ReadAheadManager* pReadAheadManager)
         : m_pReadAheadManager(pReadAheadManager),
           m_buffer_back(SampleUtil::alloc(MAX_BUFFER_LEN)),
-          m_bBackwards(false) {
+          m_bBackwards(false),
+          m_bWorkerBound(false),
+          m_workerRunning(false),
+          m_lookAheadState(LookAheadState::Off),
+          m_iSteadyCallbacks(0),
+          m_generation(0),
+          m_dTimeRatio(1.0),
+          m_dPitchScale(1.0),
+          m_dLookAheadInputFrames(0.0),
+          m_lookAheadOutputFrames(0),
+          m_primingOutputFrames(0),
+          m_outputBlockOffset(0),
+          m_pLookAheadBuffer(SampleUtil::alloc(MAX_BUFFER_LEN)) {
     m_retrieve_buffer[0] = SampleUtil::alloc(MAX_BUFFER_LEN);
     m_retrieve_buffer[1] = SampleUtil::alloc(MAX_BUFFER_LEN);
+    m_outputBlock.frames = 0;
     initRubberBand();
 }
 
 EngineBufferScaleRubberBand::~EngineBufferScaleRubberBand() {
+    m_worker.quitWait();
+    SampleUtil::free(m_pLookAheadBuffer);
     SampleUtil::free(m_buffer_back);
     SampleUtil::free(m_retrieve_buffer[0]);
     SampleUtil::free(m_retrieve_buffer[1]);
@@ -50,12 +84,41 @@ void EngineBufferScaleRubberBand::initRubberBand() {
     m_pRubberBand->setTimeRatio(1.0);
 }
 
+void EngineBufferScaleRubberBand::bindWorkers(
+        EngineWorkerScheduler* pWorkerScheduler) {
+    m_worker.setScheduler(pWorkerScheduler);
+    m_bWorkerBound = true;
+}
+
+void EngineBufferScaleRubberBand::setLookAheadWorkerEnabled(bool enabled) {
+    VERIFY_OR_DEBUG_ASSERT(m_bWorkerBound) {
+        return;
+    }
+    if (enabled == m_workerRunning.load()) {
+        return;
+    }
+    if (enabled) {
+        m_worker.startRunning();
+        m_workerRunning.store(true);
+    } else {
+        // The engine stops using the output of the worker with the next
+        // callback. A look-ahead that is running until then might miss
+        // a few blocks of output, which are replaced by silence.
+        m_workerRunning.store(false);
+        m_worker.quitWait();
+    }
+}
+
 void EngineBufferScaleRubberBand::setScaleParameters(double base_rate,
                                                      double* pTempoRatio,
                                                      double* pPitchRatio) {
     // Negative speed means we are going backwards. pitch does not affect
     // the playback direction.
-    m_bBackwards = *pTempoRatio < 0;
+    const bool backwards = *pTempoRatio < 0;
+    const double oldTimeRatio = m_dTimeRatio;
+    const double oldPitchScale = m_dPitchScale;
+    const bool directionChanged = backwards != m_bBackwards;
+    m_bBackwards = backwards;
 
     // Due to a bug in RubberBand, setting the timeRatio to a large value can
     // cause division-by-zero SIGFPEs. We limit the minimum seek speed to
@@ -78,6 +141,7 @@ void EngineBufferScaleRubberBand::setScaleParameters(double base_rate,
     if (pitchScale > 0) {
         //qDebug() << "EngineBufferScaleRubberBand setPitchScale" << *pitch << pitchScale;
         m_pRubberBand->setPitchScale(pitchScale);
+        m_dPitchScale = pitchScale;
     }
 
     // RubberBand handles checking for whether the change in timeRatio is a
@@ -105,19 +169,161 @@ void EngineBufferScaleRubberBand::setScaleParameters(double base_rate,
         *pTempoRatio = m_bBackwards ? -speed_abs : speed_abs;
     }
 
+    if (timeRatioInverse > 0) {
+        m_dTimeRatio = 1.0 / timeRatioInverse;
+    }
+
     // Used by other methods so we need to keep them up to date.
     m_dBaseRate = base_rate;
     m_dTempoRatio = speed_abs;
     m_dPitchRatio = *pPitchRatio;
+
+    if (directionChanged || m_dTimeRatio != oldTimeRatio ||
+            m_dPitchScale != oldPitchScale) {
+        m_iSteadyCallbacks = 0;
+        // EngineBuffer clears us before changing the parameters while the
+        // look-ahead is running. Priming is simply aborted.
+        if (m_lookAheadState != LookAheadState::Off) {
+            stopLookAhead();
+        }
+    }
 }
 
 void EngineBufferScaleRubberBand::setSampleRate(SINT iSampleRate) {
     EngineBufferScale::setSampleRate(iSampleRate);
     initRubberBand();
+    if (m_lookAheadState != LookAheadState::Off) {
+        stopLookAhead();
+    }
 }
 
 void EngineBufferScaleRubberBand::clear() {
     m_pRubberBand->reset();
+    if (m_lookAheadState != LookAheadState::Off) {
+        stopLookAhead();
+    }
+    m_iSteadyCallbacks = 0;
+}
+
+void EngineBufferScaleRubberBand::startPriming() {
+    ++m_generation;
+    m_worker.setGeneration(m_generation);
+    m_dLookAheadInputFrames = 0.0;
+    m_lookAheadOutputFrames = 0;
+    m_primingOutputFrames = 0;
+    m_outputBlock.frames = 0;
+    m_outputBlockOffset = 0;
+    m_lookAheadState = LookAheadState::Priming;
+}
+
+void EngineBufferScaleRubberBand::continuePriming(
+        CSAMPLE* pOutputBuffer, SINT frames) {
+    // The worker has been reset when priming started, just like our
+    // stretcher has been reset some time before. Both add the latency of
+    // RubberBand at the start, so the n-th output frame of the worker
+    // matches the n-th frame we have stretched since priming started.
+    const SINT skipFrames = m_primingOutputFrames - m_lookAheadOutputFrames;
+    m_primingOutputFrames += frames;
+    if (skipFrames > 0 &&
+            readLookAheadOutput(nullptr, skipFrames) < skipFrames) {
+        return;
+    }
+    if (readLookAheadOutput(m_pLookAheadBuffer, frames) < frames ||
+            m_primingOutputFrames < kMinPrimingFrames) {
+        return;
+    }
+
+    // The worker has caught up. Crossfade to its output to hide the
+    // remaining differences between both stretchers.
+    SampleUtil::linearCrossfadeBuffers(pOutputBuffer,
+            pOutputBuffer, m_pLookAheadBuffer,
+            getAudioSignal().frames2samples(frames));
+    m_lookAheadState = LookAheadState::Running;
+    fillLookAheadInput(frames);
+}
+
+void EngineBufferScaleRubberBand::stopLookAhead() {
+    // Let the worker discard everything that is still in flight
+    ++m_generation;
+    m_worker.setGeneration(m_generation);
+    m_outputBlock.frames = 0;
+    m_outputBlockOffset = 0;
+    m_lookAheadState = LookAheadState::Off;
+    m_iSteadyCallbacks = 0;
+}
+
+bool EngineBufferScaleRubberBand::writeLookAheadInput(
+        const CSAMPLE* pBuffer, SINT frames) {
+    while (frames > 0) {
+        if (m_worker.inputWriteAvailable() < 1) {
+            return false;
+        }
+        const SINT blockFrames = math_min(frames, kRubberBandBlockFrames);
+        const SINT blockSamples = getAudioSignal().frames2samples(blockFrames);
+        m_inputBlock.generation = m_generation;
+        m_inputBlock.frames = blockFrames;
+        m_inputBlock.sampleRate = getAudioSignal().sampleRate();
+        m_inputBlock.timeRatio = m_dTimeRatio;
+        m_inputBlock.pitchScale = m_dPitchScale;
+        SampleUtil::copy(m_inputBlock.samples, pBuffer, blockSamples);
+        m_worker.writeInput(m_inputBlock);
+        m_dLookAheadInputFrames += blockFrames;
+        pBuffer += blockSamples;
+        frames -= blockFrames;
+    }
+    return true;
+}
+
+void EngineBufferScaleRubberBand::fillLookAheadInput(SINT outputFrames) {
+    // Keep the worker kLookAheadFrames ahead of the output of the next
+    // callback, which is assumed to be as long as the current one.
+    const double inputFramesPerOutputFrame = m_dBaseRate * m_dTempoRatio;
+    const double targetInputFrames = inputFramesPerOutputFrame *
+            (m_lookAheadOutputFrames + outputFrames + kLookAheadFrames);
+    while (m_dLookAheadInputFrames < targetInputFrames &&
+            m_worker.inputWriteAvailable() > 0) {
+        const SINT iAvailSamples = m_pReadAheadManager->getNextSamples(
+                (m_bBackwards ? -1.0 : 1.0) * m_dBaseRate * m_dTempoRatio,
+                m_buffer_back,
+                getAudioSignal().frames2samples(kRubberBandBlockFrames));
+        const SINT iAvailFrames = getAudioSignal().samples2frames(iAvailSamples);
+        if (iAvailFrames <= 0) {
+            // Try again with the next callback
+            break;
+        }
+        writeLookAheadInput(m_buffer_back, iAvailFrames);
+    }
+}
+
+SINT EngineBufferScaleRubberBand::readLookAheadOutput(
+        CSAMPLE* pBuffer, SINT frames) {
+    SINT framesRead = 0;
+    while (framesRead < frames) {
+        if (m_outputBlockOffset >= m_outputBlock.frames) {
+            if (!m_worker.readOutput(&m_outputBlock)) {
+                break;
+            }
+            m_outputBlockOffset = 0;
+            if (m_outputBlock.generation != m_generation) {
+                // Output of an aborted look-ahead
+                m_outputBlock.frames = 0;
+                continue;
+            }
+        }
+        const SINT chunkFrames = math_min(frames - framesRead,
+                m_outputBlock.frames - m_outputBlockOffset);
+        if (pBuffer) {
+            SampleUtil::copy(
+                    pBuffer + getAudioSignal().frames2samples(framesRead),
+                    m_outputBlock.samples +
+                            getAudioSignal().frames2samples(m_outputBlockOffset),
+                    getAudioSignal().frames2samples(chunkFrames));
+        }
+        m_outputBlockOffset += chunkFrames;
+        framesRead += chunkFrames;
+    }
+    m_lookAheadOutputFrames += framesRead;
+    return framesRead;
 }
 
 SINT EngineBufferScaleRubberBand::retrieveAndDeinterleave(
@@ -155,6 +361,68 @@ double EngineBufferScaleRubberBand::scaleBuffer(
         return 0.0;
     }
 
+    if (m_lookAheadState != LookAheadState::Off && !m_workerRunning.load()) {
+        // The worker has been stopped
+        stopLookAhead();
+    }
+
+    SINT total_received_frames;
+    if (m_lookAheadState == LookAheadState::Running) {
+        total_received_frames = scaleBufferLookAhead(
+                pOutputBuffer, iOutputBufferSize);
+        Counter counter(kLookAheadCounter);
+        counter.increment();
+    } else {
+        total_received_frames = scaleBufferInCallback(
+                pOutputBuffer, iOutputBufferSize);
+        Counter counter(kInCallbackCounter);
+        counter.increment();
+        if (m_lookAheadState == LookAheadState::Priming) {
+            continuePriming(pOutputBuffer, total_received_frames);
+        } else if (++m_iSteadyCallbacks >= kSteadyCallbacksBeforeLookAhead &&
+                m_workerRunning.load()) {
+            startPriming();
+        }
+    }
+    if (m_lookAheadState != LookAheadState::Off) {
+        m_worker.workReady();
+    }
+
+    // framesRead is interpreted as the total number of virtual sample frames
+    // consumed to produce the scaled buffer. Due to this, we do not take into
+    // account directionality or starting point.
+    // NOTE(rryan): Why no m_dPitchAdjust here? Pitch does not change the time
+    // ratio. m_dSpeedAdjust is the ratio of unstretched time to stretched
+    // time. So, if we used total_received_frames in stretched time, then
+    // multiplying that by the ratio of unstretched time to stretched time
+    // will get us the unstretched sample frames read. This also holds for the
+    // output of the worker, which lags behind the read-ahead position but
+    // has been stretched with the current parameters.
+    double framesRead = m_dBaseRate * m_dTempoRatio * total_received_frames;
+
+    return framesRead;
+}
+
+SINT EngineBufferScaleRubberBand::scaleBufferLookAhead(
+        CSAMPLE* pOutputBuffer,
+        SINT iOutputBufferSize) {
+    const SINT frames = getAudioSignal().samples2frames(iOutputBufferSize);
+    const SINT received_frames = readLookAheadOutput(pOutputBuffer, frames);
+    if (received_frames < frames) {
+        // The worker did not keep up
+        SampleUtil::clear(
+                pOutputBuffer + getAudioSignal().frames2samples(received_frames),
+                getAudioSignal().frames2samples(frames - received_frames));
+        Counter counter(kLookAheadUnderflowCounter);
+        counter.increment();
+    }
+    fillLookAheadInput(frames);
+    return received_frames;
+}
+
+SINT EngineBufferScaleRubberBand::scaleBufferInCallback(
+        CSAMPLE* pOutputBuffer,
+        SINT iOutputBufferSize) {
     SINT total_received_frames = 0;
     SINT total_read_frames = 0;
 
@@ -208,6 +476,10 @@ double EngineBufferScaleRubberBand::scaleBuffer(
                 last_read_failed = false;
                 total_read_frames += iAvailFrames;
                 deinterleaveAndProcess(m_buffer_back, iAvailFrames, false);
+                if (m_lookAheadState == LookAheadState::Priming &&
+                        !writeLookAheadInput(m_buffer_back, iAvailFrames)) {
+                    stopLookAhead();
+                }
             } else {
                 if (last_read_failed) {
                     // Flush and break out after the next retrieval. If we are
@@ -215,6 +487,9 @@ double EngineBufferScaleRubberBand::scaleBuffer(
                     // RubberBand.
                     deinterleaveAndProcess(m_buffer_back, 0, true);
                     break_out_after_retrieve_and_reset_rubberband = true;
+                    if (m_lookAheadState == LookAheadState::Priming) {
+                        stopLookAhead();
+                    }
                 }
                 last_read_failed = true;
             }
@@ -227,15 +502,5 @@ double EngineBufferScaleRubberBand::scaleBuffer(
         counter.increment();
     }
 
-    // framesRead is interpreted as the total number of virtual sample frames
-    // consumed to produce the scaled buffer. Due to this, we do not take into
-    // account directionality or starting point.
-    // NOTE(rryan): Why no m_dPitchAdjust here? Pitch does not change the time
-    // ratio. m_dSpeedAdjust is the ratio of unstretched time to stretched
-    // time. So, if we used total_received_frames in stretched time, then
-    // multiplying that by the ratio of unstretched time to stretched time
-    // will get us the unstretched sample frames read.
-    double framesRead = m_dBaseRate * m_dTempoRatio * total_received_frames;
-
-    return framesRead;
+    return total_received_frames;
 }
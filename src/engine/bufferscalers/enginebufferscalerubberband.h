@@ -1,16 +1,28 @@
 #ifndef ENGINEBUFFERSCALERUBBERBAND_H
 #define ENGINEBUFFERSCALERUBBERBAND_H
 
+#include <atomic>
+
 #include "engine/bufferscalers/enginebufferscale.h"
+#include "engine/bufferscalers/rubberbandworker.h"
 #include "util/memory.h"
 
 namespace RubberBand {
 class RubberBandStretcher;
 }  // namespace RubberBand
 
+class EngineWorkerScheduler;
 class ReadAheadManager;
 
 // Uses librubberband to scale audio.  This class is not thread safe.
+//
+// If the RubberBandWorker has been started and the scale parameters
+// have been steady for a while, the stretching is moved to the worker
+// that renders ahead of the play position. EngineBuffer only starts it
+// while [Master],keylock_lookahead and keylock of the deck are enabled. The audio
+// callback then only reads the input from the ReadAheadManager and copies
+// the stretched output. Seeks and changes of the parameters fall back to
+// stretching in the callback.
 class EngineBufferScaleRubberBand : public EngineBufferScale {
     Q_OBJECT
   public:
@@ -18,6 +30,14 @@ class EngineBufferScaleRubberBand : public EngineBufferScale {
             ReadAheadManager* pReadAheadManager);
     ~EngineBufferScaleRubberBand() override;
 
+    // Binds the look-ahead worker to the scheduler without starting it
+    void bindWorkers(EngineWorkerScheduler* pWorkerScheduler);
+
+    // Starts or stops the thread of the look-ahead worker. Without it
+    // the stretching always happens in the callback. Must not be called
+    // from the engine thread.
+    void setLookAheadWorkerEnabled(bool enabled);
+
     void setScaleParameters(double base_rate,
                             double* pTempoRatio,
                             double* pPitchRatio) override;
@@ -31,13 +51,45 @@ class EngineBufferScaleRubberBand : public EngineBufferScale {
     // Flush buffer.
     void clear() override;
 
+    bool hasLookAhead() const override {
+        return m_lookAheadState == LookAheadState::Running;
+    }
+
   private:
+    enum class LookAheadState {
+        // Stretching in the callback
+        Off,
+        // Stretching in the callback while the worker stretches the same
+        // input until it is far enough ahead
+        Priming,
+        // Copying the output of the worker
+        Running,
+    };
+
     // Reset RubberBand library with new audio signal
     void initRubberBand();
 
     void deinterleaveAndProcess(const CSAMPLE* pBuffer, SINT frames, bool flush);
     SINT retrieveAndDeinterleave(CSAMPLE* pBuffer, SINT frames);
 
+    // Stretches in the callback. Returns the number of output frames.
+    SINT scaleBufferInCallback(CSAMPLE* pOutputBuffer, SINT iOutputBufferSize);
+    SINT scaleBufferLookAhead(CSAMPLE* pOutputBuffer, SINT iOutputBufferSize);
+
+    void startPriming();
+    // Checks if the worker has caught up after frames more frames have been
+    // stretched in the callback and switches to its output if it has.
+    void continuePriming(CSAMPLE* pOutputBuffer, SINT frames);
+    void stopLookAhead();
+    // Passes input that has been read from the ReadAheadManager to the
+    // worker. Returns false if the input FIFO is full.
+    bool writeLookAheadInput(const CSAMPLE* pBuffer, SINT frames);
+    // Reads input for the worker from the ReadAheadManager
+    void fillLookAheadInput(SINT outputFrames);
+    // Reads output of the worker into pBuffer or discards it if pBuffer is
+    // null. Returns the number of frames read.
+    SINT readLookAheadOutput(CSAMPLE* pBuffer, SINT frames);
+
     // The read-ahead manager that we use to fetch samples
     ReadAheadManager* m_pReadAheadManager;
 
@@ -48,6 +100,29 @@ class EngineBufferScaleRubberBand : public EngineBufferScale {
 
     // Holds the playback direction
     bool m_bBackwards;
+
+    RubberBandWorker m_worker;
+    bool m_bWorkerBound;
+    // Cleared before the worker is stopped, so that the engine falls
+    // back to stretching in the callback
+    std::atomic<bool> m_workerRunning;
+
+    LookAheadState m_lookAheadState;
+    int m_iSteadyCallbacks;
+    int m_generation;
+    double m_dTimeRatio;
+    double m_dPitchScale;
+    // Input frames passed to and output frames read from the worker since
+    // the start of the current generation
+    double m_dLookAheadInputFrames;
+    SINT m_lookAheadOutputFrames;
+    // Output frames stretched in the callback since priming started. The
+    // worker output corresponds to these frames.
+    SINT m_primingOutputFrames;
+    RubberBandBlock m_inputBlock;
+    RubberBandBlock m_outputBlock;
+    SINT m_outputBlockOffset;
+    CSAMPLE* m_pLookAheadBuffer;
 };
 
 
@@ -0,0 +1,117 @@
+#include "engine/bufferscalers/rubberbandworker.h"
+
+#include <rubberband/RubberBandStretcher.h>
+
+#include "util/assert.h"
+#include "util/math.h"
+#include "util/sample.h"
+
+using RubberBand::RubberBandStretcher;
+
+namespace {
+
+// 16384 frames of input and 32768 frames of output
+const int kInputFifoSize = 64;
+const int kOutputFifoSize = 128;
+
+}  // anonymous namespace
+
+RubberBandWorker::RubberBandWorker()
+        : m_inputFifo(kInputFifoSize),
+          m_outputFifo(kOutputFifoSize),
+          m_generation(0),
+          m_stop(false),
+          m_stretcherGeneration(-1),
+          m_sampleRate(0) {
+    m_buffers[0] = SampleUtil::alloc(kRubberBandBlockFrames);
+    m_buffers[1] = SampleUtil::alloc(kRubberBandBlockFrames);
+}
+
+RubberBandWorker::~RubberBandWorker() {
+    SampleUtil::free(m_buffers[0]);
+    SampleUtil::free(m_buffers[1]);
+}
+
+void RubberBandWorker::run() {
+    unsigned static id = 0; //the id of this thread, for debugging purposes
+    QThread::currentThread()->setObjectName(QString("RubberBandWorker %1").arg(++id));
+
+    while (!m_stop.load()) {
+        processInput();
+        m_semaRun.acquire();
+    }
+}
+
+void RubberBandWorker::startRunning() {
+    DEBUG_ASSERT(!isRunning());
+    m_stop = false;
+    start(QThread::HighPriority);
+}
+
+void RubberBandWorker::quitWait() {
+    m_stop = true;
+    m_semaRun.release();
+    wait();
+}
+
+void RubberBandWorker::processInput() {
+    while (!m_stop.load()) {
+        const int generation = m_generation.load();
+        if (m_stretcherGeneration == generation && !retrieveOutput()) {
+            // Continue after the engine has consumed some of the output
+            return;
+        }
+        if (m_inputFifo.read(&m_block, 1) != 1) {
+            return;
+        }
+        if (m_block.generation != generation) {
+            // Input of an aborted look-ahead
+            continue;
+        }
+        if (m_stretcherGeneration != generation) {
+            configure(m_block);
+        }
+        SampleUtil::deinterleaveBuffer(
+                m_buffers[0], m_buffers[1], m_block.samples, m_block.frames);
+        m_pRubberBand->process(
+                (const float* const*)m_buffers, m_block.frames, false);
+    }
+}
+
+void RubberBandWorker::configure(const RubberBandBlock& block) {
+    if (!m_pRubberBand || block.sampleRate != m_sampleRate) {
+        // Allocating is fine here, we are not in the audio callback
+        m_pRubberBand = std::make_unique<RubberBandStretcher>(
+                block.sampleRate, 2, RubberBandStretcher::OptionProcessRealTime);
+        m_pRubberBand->setMaxProcessSize(kRubberBandBlockFrames);
+        m_sampleRate = block.sampleRate;
+    } else {
+        m_pRubberBand->reset();
+    }
+    m_pRubberBand->setTimeRatio(block.timeRatio);
+    m_pRubberBand->setPitchScale(block.pitchScale);
+    m_stretcherGeneration = block.generation;
+}
+
+bool RubberBandWorker::retrieveOutput() {
+    while (m_pRubberBand->available() > 0) {
+        if (m_outputFifo.writeAvailable() < 1) {
+            return false;
+        }
+        if (m_generation.load() != m_stretcherGeneration) {
+            // Aborted, the output would be discarded anyway
+            return true;
+        }
+        const SINT frames = m_pRubberBand->retrieve(
+                (float* const*)m_buffers,
+                math_min<SINT>(m_pRubberBand->available(),
+                        kRubberBandBlockFrames));
+        RubberBandBlock& output = m_block;
+        output.generation = m_stretcherGeneration;
+        output.frames = frames;
+        SampleUtil::interleaveBuffer(
+                output.samples, m_buffers[0], m_buffers[1], frames);
+        m_outputFifo.write(&output, 1);
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+
+#include "engine/engineworker.h"
+#include "util/fifo.h"
+#include "util/memory.h"
+#include "util/types.h"
+
+namespace RubberBand {
+class RubberBandStretcher;
+}  // namespace RubberBand
+
+// Maximum number of frames in a RubberBandBlock
+constexpr SINT kRubberBandBlockFrames = 256;
+
+// POD with trivial ctor/dtor/copy for passing interleaved stereo audio
+// through a FIFO between the engine and the RubberBandWorker.
+typedef struct RubberBandBlock {
+    // Blocks of an aborted look-ahead are discarded by comparing the
+    // generation with the current one.
+    int generation;
+    SINT frames;
+    // Stretch parameters, only set for input blocks. They are constant
+    // within a generation.
+    SINT sampleRate;
+    double timeRatio;
+    double pitchScale;
+    CSAMPLE samples[kRubberBandBlockFrames * 2];
+} RubberBandBlock;
+
+// Time-stretches audio ahead of the play position with its own
+// RubberBandStretcher, so that EngineBufferScaleRubberBand only needs to
+// copy the already stretched output in the audio callback while the
+// tempo and pitch are steady. The engine writes input blocks and reads
+// output blocks; all stretching happens in this thread.
+class RubberBandWorker : public EngineWorker {
+    Q_OBJECT
+  public:
+    RubberBandWorker();
+    ~RubberBandWorker() override;
+
+    // Starts a new generation. Blocks of older generations are discarded
+    // and the stretcher is reset when the first input block of the new
+    // generation arrives. Called from the engine thread.
+    void setGeneration(int generation) {
+        m_generation.store(generation);
+    }
+
+    // Called from the engine thread
+    int inputWriteAvailable() const {
+        return m_inputFifo.writeAvailable();
+    }
+    bool writeInput(const RubberBandBlock& block) {
+        return m_inputFifo.write(&block, 1) == 1;
+    }
+    int outputReadAvailable() const {
+        return m_outputFifo.readAvailable();
+    }
+    bool readOutput(RubberBandBlock* pBlock) {
+        return m_outputFifo.read(pBlock, 1) == 1;
+    }
+
+    void run() override;
+
+    // Starts the thread, also again after quitWait()
+    void startRunning();
+    void quitWait();
+
+  private:
+    void processInput();
+    void configure(const RubberBandBlock& block);
+    // Moves the available output of the stretcher into the output FIFO.
+    // Returns false if the output FIFO is full.
+    bool retrieveOutput();
+
+    FIFO<RubberBandBlock> m_inputFifo;
+    FIFO<RubberBandBlock> m_outputFifo;
+    std::atomic<int> m_generation;
+    std::atomic<bool> m_stop;
+
+    // Only accessed by the worker thread
+    std::unique_ptr<RubberBand::RubberBandStretcher> m_pRubberBand;
+    int m_stretcherGeneration;
+    SINT m_sampleRate;
+    CSAMPLE* m_buffers[2];
+    // Scratch block for reading input and writing output
+    RubberBandBlock m_block;
+};
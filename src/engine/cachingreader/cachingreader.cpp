@@ -10,6 +10,7 @@
 #include "util/sample.h"
 #include "util/logger.h"
 #include "util/compatibility.h"
+#include "util/performancetimer.h"
 
 
 namespace {
@@ -26,6 +27,9 @@ const SINT kDefaultHintFrames = 1024;
 //static
 const SINT kNumberOfCachedChunksInMemory = 80;
 
+// Timeout while waiting for chunks in blocking mode
+const mixxx::Duration kBlockingReadTimeout = mixxx::Duration::fromSeconds(10);
+
 } // anonymous namespace
 
 
@@ -38,6 +42,7 @@ CachingReader::CachingReader(QString group,
           m_mruCachingReaderChunk(nullptr),
           m_lruCachingReaderChunk(nullptr),
           m_sampleBuffer(CachingReaderChunk::kSamples * kNumberOfCachedChunksInMemory),
+          m_blockingReads(false),
           m_worker(group, &m_chunkReadRequestFIFO, &m_readerStatusFIFO) {
 
     m_allocatedCachingReaderChunks.reserve(kNumberOfCachedChunksInMemory);
@@ -137,6 +142,70 @@ CachingReaderChunkForOwner* CachingReader::allocateChunkExpireLRU(SINT chunkInde
     return pChunk;
 }
 
+CachingReaderChunkForOwner* CachingReader::requestChunk(SINT chunkIndex) {
+    CachingReaderChunkForOwner* pChunk = allocateChunkExpireLRU(chunkIndex);
+    if (pChunk == nullptr) {
+        kLogger.warning() << "ERROR: Couldn't allocate spare CachingReaderChunk to make CachingReaderChunkReadRequest.";
+        return nullptr;
+    }
+    // Do not insert the allocated chunk into the MRU/LRU list,
+    // because it will be handed over to the worker immediately
+    CachingReaderChunkReadRequest request;
+    request.giveToWorker(pChunk);
+    // kLogger.debug() << "Requesting read of chunk" << current << "into" << pChunk;
+    // kLogger.debug() << "Requesting read into " << request.chunk->data;
+    if (m_chunkReadRequestFIFO.write(&request, 1) != 1) {
+        kLogger.warning() << "ERROR: Could not submit read request for "
+                 << chunkIndex;
+        // Revoke the chunk from the worker and free it
+        pChunk->takeFromWorker();
+        freeChunk(pChunk);
+        return nullptr;
+    }
+    return pChunk;
+}
+
+CachingReaderChunkForOwner* CachingReader::waitForChunk(SINT chunkIndex) {
+    CachingReaderChunkForOwner* pChunk = lookupChunk(chunkIndex);
+    if (pChunk == nullptr) {
+        pChunk = requestChunk(chunkIndex);
+        if (pChunk == nullptr) {
+            return nullptr;
+        }
+    }
+    // Bypass the EngineWorkerScheduler that would only wake up the
+    // worker after the current callback has finished.
+    m_worker.workReady();
+    m_worker.wakeIfReady();
+
+    PerformanceTimer timer;
+    timer.start();
+    while (pChunk->getState() == CachingReaderChunkForOwner::READ_PENDING) {
+        ReaderStatusUpdate status;
+        if (m_readerStatusFIFO.read(&status, 1) == 1) {
+            processStatusUpdate(status);
+            // Failed reads will free the chunk
+            pChunk = lookupChunk(chunkIndex);
+            if (pChunk == nullptr) {
+                return nullptr;
+            }
+            continue;
+        }
+        // The worker releases the semaphore after each status update.
+        // Permits of updates that have already been processed only
+        // cause another look into the empty FIFO.
+        const mixxx::Duration remaining = kBlockingReadTimeout - timer.elapsed();
+        if (remaining <= mixxx::Duration::empty() ||
+                !m_readerStatusAvailable.tryAcquire(1, remaining.toIntegerMillis())) {
+            kLogger.warning()
+                    << "Timed out while waiting for chunk"
+                    << chunkIndex;
+            return nullptr;
+        }
+    }
+    return pChunk;
+}
+
 CachingReaderChunkForOwner* CachingReader::lookupChunk(SINT chunkIndex) {
     // Defaults to nullptr if it's not in the hash.
     CachingReaderChunkForOwner* chunk = m_allocatedCachingReaderChunks.value(chunkIndex, nullptr);
@@ -183,43 +252,63 @@ void CachingReader::newTrack(TrackPointer pTrack) {
     m_worker.workReady();
 }
 
+void CachingReader::setBlockingReads(bool blockingReads) {
+    if (blockingReads) {
+        // The worker needs to notify us before read() starts waiting
+        m_worker.setStatusAvailableSemaphore(&m_readerStatusAvailable);
+        m_blockingReads.store(true);
+    } else {
+        m_blockingReads.store(false);
+        m_worker.setStatusAvailableSemaphore(nullptr);
+    }
+    // Discard the permits of all status updates that have been processed
+    // without waiting. Permits that are released concurrently only cause
+    // a spurious wakeup in waitForChunk(), which then checks the FIFO
+    // again.
+    m_readerStatusAvailable.tryAcquire(m_readerStatusAvailable.available());
+}
+
 void CachingReader::process() {
     ReaderStatusUpdate status;
     while (m_readerStatusFIFO.read(&status, 1) == 1) {
-        CachingReaderChunkForOwner* pChunk = static_cast<CachingReaderChunkForOwner*>(status.chunk);
-        if (pChunk) {
-            // Take over control of the chunk from the worker.
-            // This has to be done before freeing all chunks
-            // after a new track has been loaded (see below)!
-            pChunk->takeFromWorker();
-            if (status.status == CHUNK_READ_SUCCESS) {
-                // Insert or freshen the chunk in the MRU/LRU list after
-                // obtaining ownership from the worker.
-                freshenChunk(pChunk);
-            } else {
-                // Discard chunks that don't carry any data
-                freeChunk(pChunk);
-            }
-        }
-        if (status.status == TRACK_NOT_LOADED) {
-            m_readerStatus = status.status;
-        } else if (status.status == TRACK_LOADED) {
-            m_readerStatus = status.status;
-            // Reset the max. readable frame index
-            m_readableFrameIndexRange = status.readableFrameIndexRange();
-            // Free all chunks with sample data from a previous track
-            freeAllChunks();
-        }
-        if (m_readerStatus == TRACK_LOADED) {
-            // Adjust the readable frame index range after loading or reading
-            m_readableFrameIndexRange = intersect(
-                    m_readableFrameIndexRange,
-                    status.readableFrameIndexRange());
+        processStatusUpdate(status);
+    }
+}
+
+void CachingReader::processStatusUpdate(const ReaderStatusUpdate& status) {
+    CachingReaderChunkForOwner* pChunk = static_cast<CachingReaderChunkForOwner*>(status.chunk);
+    if (pChunk) {
+        // Take over control of the chunk from the worker.
+        // This has to be done before freeing all chunks
+        // after a new track has been loaded (see below)!
+        pChunk->takeFromWorker();
+        if (status.status == CHUNK_READ_SUCCESS) {
+            // Insert or freshen the chunk in the MRU/LRU list after
+            // obtaining ownership from the worker.
+            freshenChunk(pChunk);
         } else {
-            // Reset the readable frame index range
-            m_readableFrameIndexRange = mixxx::IndexRange();
+            // Discard chunks that don't carry any data
+            freeChunk(pChunk);
         }
     }
+    if (status.status == TRACK_NOT_LOADED) {
+        m_readerStatus = status.status;
+    } else if (status.status == TRACK_LOADED) {
+        m_readerStatus = status.status;
+        // Reset the max. readable frame index
+        m_readableFrameIndexRange = status.readableFrameIndexRange();
+        // Free all chunks with sample data from a previous track
+        freeAllChunks();
+    }
+    if (m_readerStatus == TRACK_LOADED) {
+        // Adjust the readable frame index range after loading or reading
+        m_readableFrameIndexRange = intersect(
+                m_readableFrameIndexRange,
+                status.readableFrameIndexRange());
+    } else {
+        // Reset the readable frame index range
+        m_readableFrameIndexRange = mixxx::IndexRange();
+    }
 }
 
 CachingReader::ReadResult CachingReader::read(SINT startSample, SINT numSamples, bool reverse, CSAMPLE* buffer) {
@@ -250,6 +339,9 @@ CachingReader::ReadResult CachingReader::read(SINT startSample, SINT numSamples,
         return ReadResult::AVAILABLE; // nothing to do
     }
 
+    // The mode might be changed concurrently, but not within a read
+    const bool blockingReads = m_blockingReads.load();
+
     // the samples are always read in forward direction
     // If reverse = true, the frames are copied in reverse order to the
     // destination buffer
@@ -348,7 +440,11 @@ CachingReader::ReadResult CachingReader::read(SINT startSample, SINT numSamples,
                 }
 
                 mixxx::IndexRange bufferedFrameIndexRange;
-                const CachingReaderChunkForOwner* const pChunk = lookupChunkAndFreshen(chunkIndex);
+                const CachingReaderChunkForOwner* pChunk = lookupChunkAndFreshen(chunkIndex);
+                if (blockingReads &&
+                        !(pChunk && (pChunk->getState() == CachingReaderChunkForOwner::READY))) {
+                    pChunk = waitForChunk(chunkIndex);
+                }
                 if (pChunk && (pChunk->getState() == CachingReaderChunkForOwner::READY)) {
                     if (reverse) {
                         bufferedFrameIndexRange =
@@ -477,24 +573,7 @@ void CachingReader::hintAndMaybeWake(const HintVector& hintList) {
             CachingReaderChunkForOwner* pChunk = lookupChunk(chunkIndex);
             if (pChunk == nullptr) {
                 shouldWake = true;
-                pChunk = allocateChunkExpireLRU(chunkIndex);
-                if (pChunk == nullptr) {
-                    kLogger.warning() << "ERROR: Couldn't allocate spare CachingReaderChunk to make CachingReaderChunkReadRequest.";
-                    continue;
-                }
-                // Do not insert the allocated chunk into the MRU/LRU list,
-                // because it will be handed over to the worker immediately
-                CachingReaderChunkReadRequest request;
-                request.giveToWorker(pChunk);
-                // kLogger.debug() << "Requesting read of chunk" << current << "into" << pChunk;
-                // kLogger.debug() << "Requesting read into " << request.chunk->data;
-                if (m_chunkReadRequestFIFO.write(&request, 1) != 1) {
-                    kLogger.warning() << "ERROR: Could not submit read request for "
-                             << chunkIndex;
-                    // Revoke the chunk from the worker and free it
-                    pChunk->takeFromWorker();
-                    freeChunk(pChunk);
-                }
+                requestChunk(chunkIndex);
                 //kLogger.debug() << "Checking chunk " << current << " shouldWake:" << shouldWake << " chunksToRead" << m_chunksToRead.size();
             } else if (pChunk->getState() == CachingReaderChunkForOwner::READY) {
                 // This will cause the chunk to be 'freshened' in the cache. The
@@ -4,12 +4,15 @@
 #ifndef ENGINE_CACHINGREADER_H
 #define ENGINE_CACHINGREADER_H
 
+#include <atomic>
+
 #include <QtDebug>
 #include <QList>
 #include <QVector>
 #include <QLinkedList>
 #include <QHash>
 #include <QVarLengthArray>
+#include <QSemaphore>
 
 #include "util/types.h"
 #include "preferences/usersettings.h"
@@ -112,6 +115,13 @@ class CachingReader : public QObject {
         m_worker.setScheduler(pScheduler);
     }
 
+    // In blocking mode read() waits until missing chunks have been
+    // decoded instead of returning ReadResult::UNAVAILABLE. Only
+    // intended for rendering faster than real-time without an audio
+    // device. Thread-safe, may be changed while the worker is loading
+    // a track. Takes effect with the next call of read().
+    void setBlockingReads(bool blockingReads);
+
   signals:
     // Emitted once a new track is loaded and ready to be read from.
     void trackLoading();
@@ -126,6 +136,9 @@ class CachingReader : public QObject {
     FIFO<CachingReaderChunkReadRequest> m_chunkReadRequestFIFO;
     FIFO<ReaderStatusUpdate> m_readerStatusFIFO;
 
+    // Applies a single status update received from the worker
+    void processStatusUpdate(const ReaderStatusUpdate& status);
+
     // Looks for the provided chunk number in the index of in-memory chunks and
     // returns it if it is present. If not, returns nullptr. If it is present then
     // freshenChunk is called on the chunk to make it the MRU chunk.
@@ -150,6 +163,16 @@ class CachingReader : public QObject {
     // Gets a chunk from the free list, frees the LRU CachingReaderChunk if none available.
     CachingReaderChunkForOwner* allocateChunkExpireLRU(SINT chunkIndex);
 
+    // Allocates a chunk and hands it over to the worker for reading.
+    // Returns nullptr on failure. The worker needs to be woken up
+    // afterwards.
+    CachingReaderChunkForOwner* requestChunk(SINT chunkIndex);
+
+    // Requests the chunk if needed and waits until it has been read by
+    // the worker. Returns nullptr if the chunk could not be read. Only
+    // used in blocking mode.
+    CachingReaderChunkForOwner* waitForChunk(SINT chunkIndex);
+
     ReaderStatus m_readerStatus;
 
     // Keeps track of all CachingReaderChunks we've allocated.
@@ -173,6 +196,10 @@ class CachingReader : public QObject {
     // The readable frame index range as reported by the worker.
     mixxx::IndexRange m_readableFrameIndexRange;
 
+    std::atomic<bool> m_blockingReads;
+    // Released by the worker for each status update in blocking mode
+    QSemaphore m_readerStatusAvailable;
+
     CachingReaderWorker m_worker;
 };
 
@@ -76,6 +76,21 @@ mixxx::IndexRange CachingReaderChunk::bufferSampleFrames(
     return m_bufferedSampleFrames.frameIndexRange();
 }
 
+mixxx::IndexRange CachingReaderChunk::bufferSampleFrames(
+        const mixxx::ReadableSampleFrames& decodedSampleFrames) {
+    DEBUG_ASSERT(decodedSampleFrames.frameLength() <= kFrames);
+    const SINT sampleCount = frames2samples(decodedSampleFrames.frameLength());
+    DEBUG_ASSERT(decodedSampleFrames.readableLength() == sampleCount);
+    SampleUtil::copy(
+            m_sampleBuffer.data(),
+            decodedSampleFrames.readableData(),
+            sampleCount);
+    m_bufferedSampleFrames = mixxx::ReadableSampleFrames(
+            decodedSampleFrames.frameIndexRange(),
+            mixxx::SampleBuffer::ReadableSlice(m_sampleBuffer.data(), sampleCount));
+    return m_bufferedSampleFrames.frameIndexRange();
+}
+
 mixxx::IndexRange CachingReaderChunk::readBufferedSampleFrames(
         CSAMPLE* sampleBuffer,
         const mixxx::IndexRange& frameIndexRange) const {
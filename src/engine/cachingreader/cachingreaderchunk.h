@@ -56,6 +56,15 @@ public:
     mixxx::IndexRange bufferSampleFrames(
             const mixxx::AudioSourcePointer& pAudioSource,
             mixxx::SampleBuffer::WritableSlice tempOutputBuffer);
+    // Copy sample frames that have already been decoded, e.g. by
+    // the analysis of the same track, and return the range of frames
+    // that have been copied.
+    mixxx::IndexRange bufferSampleFrames(
+            const mixxx::ReadableSampleFrames& decodedSampleFrames);
+
+    const mixxx::ReadableSampleFrames& bufferedSampleFrames() const {
+        return m_bufferedSampleFrames;
+    }
 
     mixxx::IndexRange readBufferedSampleFrames(
             CSAMPLE* sampleBuffer,
@@ -1,6 +1,10 @@
 #include <QtDebug>
 #include <QFileInfo>
 #include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <memory>
 
 #include "control/controlobject.h"
 
@@ -9,12 +13,106 @@
 #include "util/compatibility.h"
 #include "util/event.h"
 #include "util/logger.h"
+#include "util/math.h"
 
 
 namespace {
 
 mixxx::Logger kLogger("CachingReaderWorker");
 
+// The number of chunks of a single deck that are decoded at the same
+// time, including the chunk that is decoded by the worker thread. The
+// remaining threads of the shared pool are available for other decks.
+const int kMaxConcurrentChunkReadsPerDeck = 4;
+
+// Lossless formats with independently decodable frames that can be
+// read at any position without decoding the preceding audio data
+bool isDecodableInParallel(const QString& fileName) {
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix == "flac" ||
+            suffix == "wav" ||
+            suffix == "aiff" ||
+            suffix == "aif";
+}
+
+// Shared by the workers of all decks
+QThreadPool* sharedDecoderPool() {
+    static QThreadPool s_pool;
+    return &s_pool;
+}
+
+// Mono and stereo signals are decoded directly into the chunks. The
+// temporary buffer is only needed for down-mixing multi-channel
+// signals of decoders that are not able to decode them as stereo.
+SINT tempReadBufferSize(const mixxx::AudioSourcePointer& pAudioSource) {
+    return (pAudioSource->channelCount() > CachingReaderChunk::kChannels) ?
+            pAudioSource->frames2samples(CachingReaderChunk::kFrames) :
+            0;
+}
+
+// Try to read the data required for the chunk from the audio source.
+// The analysis of the same track might have decoded it already. Chunks
+// of the same track might be read concurrently with different audio
+// sources.
+mixxx::IndexRange readChunk(
+        CachingReaderChunk* pChunk,
+        const mixxx::AudioSourcePointer& pAudioSource,
+        mixxx::SampleBuffer* pTempReadBuffer,
+        const mixxx::DecodedBlockCache::Consumer& decodedBlocks) {
+    const mixxx::DecodedBlockPointer pDecodedBlock =
+            decodedBlocks.takeBlock(pChunk->getIndex());
+    if (pDecodedBlock) {
+        return pChunk->bufferSampleFrames(
+                pDecodedBlock->readableSampleFrames());
+    }
+    const auto bufferedFrameIndexRange = pChunk->bufferSampleFrames(
+            pAudioSource,
+            mixxx::SampleBuffer::WritableSlice(*pTempReadBuffer));
+    decodedBlocks.publishBlock(
+            pChunk->getIndex(),
+            pChunk->bufferedSampleFrames());
+    return bufferedFrameIndexRange;
+}
+
+// Reads a chunk on the shared thread pool and releases the semaphore
+// when finished
+class ParallelChunkRead : public QRunnable {
+  public:
+    ParallelChunkRead(
+            CachingReaderChunk* pChunk,
+            mixxx::AudioSourcePointer pAudioSource,
+            mixxx::SampleBuffer* pTempReadBuffer,
+            const mixxx::DecodedBlockCache::Consumer* pDecodedBlocks,
+            mixxx::IndexRange* pBufferedFrameIndexRange,
+            QSemaphore* pFinished)
+            : m_pChunk(pChunk),
+              m_pAudioSource(std::move(pAudioSource)),
+              m_pTempReadBuffer(pTempReadBuffer),
+              m_pDecodedBlocks(pDecodedBlocks),
+              m_pBufferedFrameIndexRange(pBufferedFrameIndexRange),
+              m_pFinished(pFinished) {
+    }
+
+    void run() override {
+        // Same priority as the worker threads
+        QThread::currentThread()->setPriority(QThread::HighPriority);
+        *m_pBufferedFrameIndexRange = readChunk(
+                m_pChunk,
+                m_pAudioSource,
+                m_pTempReadBuffer,
+                *m_pDecodedBlocks);
+        m_pFinished->release();
+    }
+
+  private:
+    CachingReaderChunk* const m_pChunk;
+    const mixxx::AudioSourcePointer m_pAudioSource;
+    mixxx::SampleBuffer* const m_pTempReadBuffer;
+    const mixxx::DecodedBlockCache::Consumer* const m_pDecodedBlocks;
+    mixxx::IndexRange* const m_pBufferedFrameIndexRange;
+    QSemaphore* const m_pFinished;
+};
+
 } // anonymous namespace
 
 CachingReaderWorker::CachingReaderWorker(
@@ -25,33 +123,37 @@ CachingReaderWorker::CachingReaderWorker(
           m_tag(QString("CachingReaderWorker %1").arg(m_group)),
           m_pChunkReadRequestFIFO(pChunkReadRequestFIFO),
           m_pReaderStatusFIFO(pReaderStatusFIFO),
+          m_pStatusAvailable(nullptr),
           m_newTrackAvailable(false),
           m_stop(0) {
+    // Chunks are shared as decoded blocks with the same index
+    DEBUG_ASSERT(CachingReaderChunk::kFrames == mixxx::DecodedBlockCache::kBlockFrames);
 }
 
 CachingReaderWorker::~CachingReaderWorker() {
 }
 
-ReaderStatusUpdate CachingReaderWorker::processReadRequest(
-        const CachingReaderChunkReadRequest& request) {
-    CachingReaderChunk* pChunk = request.chunk;
-    DEBUG_ASSERT(pChunk);
-
+bool CachingReaderWorker::isReadable(const CachingReaderChunk* pChunk) const {
     // Before trying to read any data we need to check if the audio source
     // is available and if any audio data that is needed by the chunk is
     // actually available.
     const auto chunkFrameIndexRange = pChunk->frameIndexRange(m_pAudioSource);
-    if (intersect(chunkFrameIndexRange, m_readableFrameIndexRange).empty()) {
-        ReaderStatusUpdate result;
-        result.init(CHUNK_READ_INVALID, pChunk, m_readableFrameIndexRange);
-        return result;
+    return !intersect(chunkFrameIndexRange, m_readableFrameIndexRange).empty();
+}
+
+void CachingReaderWorker::sendStatus(const ReaderStatusUpdate& status) {
+    m_pReaderStatusFIFO->writeBlocking(&status, 1);
+    QSemaphore* pStatusAvailable = m_pStatusAvailable.load();
+    if (pStatusAvailable) {
+        pStatusAvailable->release();
     }
+}
 
-    // Try to read the data required for the chunk from the audio source
-    // and adjust the max. readable frame index if decoding errors occur.
-    const mixxx::IndexRange bufferedFrameIndexRange = pChunk->bufferSampleFrames(
-            m_pAudioSource,
-            mixxx::SampleBuffer::WritableSlice(m_tempReadBuffer));
+ReaderStatusUpdate CachingReaderWorker::finishReadRequest(
+        CachingReaderChunk* pChunk,
+        const mixxx::IndexRange& bufferedFrameIndexRange) {
+    // Adjust the max. readable frame index if decoding errors occurred.
+    const auto chunkFrameIndexRange = pChunk->frameIndexRange(m_pAudioSource);
     ReaderStatus status = bufferedFrameIndexRange.empty() ? CHUNK_READ_EOF : CHUNK_READ_SUCCESS;
     if (chunkFrameIndexRange != bufferedFrameIndexRange) {
         kLogger.warning()
@@ -84,6 +186,111 @@ ReaderStatusUpdate CachingReaderWorker::processReadRequest(
     return result;
 }
 
+void CachingReaderWorker::processReadRequests(
+        const CachingReaderChunkReadRequest& request) {
+    CachingReaderChunkReadRequest requests[kMaxConcurrentChunkReadsPerDeck];
+    requests[0] = request;
+    int requestCount = 1;
+    if (m_pParallelDecodingTrack) {
+        requestCount += m_pChunkReadRequestFIFO->read(
+                &requests[1], kMaxConcurrentChunkReadsPerDeck - 1);
+    }
+
+    bool readable[kMaxConcurrentChunkReadsPerDeck];
+    int readableCount = 0;
+    for (int i = 0; i < requestCount; ++i) {
+        readable[i] = isReadable(requests[i].chunk);
+        if (readable[i]) {
+            ++readableCount;
+        }
+    }
+
+    // The worker thread reads the first chunk itself while the
+    // following chunks are read on the shared thread pool. Chunks
+    // that exceed the available decoders or threads of the pool are
+    // read by the worker thread afterwards.
+    const int parallelDecoderCount =
+            (readableCount > 1) ? openParallelDecoders(readableCount - 1) : 0;
+    mixxx::IndexRange bufferedFrameIndexRanges[kMaxConcurrentChunkReadsPerDeck];
+    bool readInParallel[kMaxConcurrentChunkReadsPerDeck];
+    QSemaphore parallelReadFinished[kMaxConcurrentChunkReadsPerDeck];
+    int parallelReadCount = 0;
+    bool firstReadable = true;
+    for (int i = 0; i < requestCount; ++i) {
+        readInParallel[i] = false;
+        if (!readable[i]) {
+            continue;
+        }
+        if (firstReadable) {
+            firstReadable = false;
+            continue;
+        }
+        if (parallelReadCount < parallelDecoderCount) {
+            ParallelDecoder& decoder = m_parallelDecoders[parallelReadCount];
+            auto pParallelRead = std::make_unique<ParallelChunkRead>(
+                    requests[i].chunk,
+                    decoder.pAudioSource,
+                    &decoder.tempReadBuffer,
+                    &m_decodedBlocks,
+                    &bufferedFrameIndexRanges[i],
+                    &parallelReadFinished[i]);
+            // Don't wait for threads that are busy with other decks
+            if (sharedDecoderPool()->tryStart(pParallelRead.get())) {
+                pParallelRead.release(); // owned by the pool
+                readInParallel[i] = true;
+                ++parallelReadCount;
+            }
+        }
+    }
+
+    // Sends the results in the order of the requests. Without waiting
+    // it stops at the first parallel read that has not finished yet.
+    bool readByWorker[kMaxConcurrentChunkReadsPerDeck] = {};
+    int sentCount = 0;
+    const auto sendResults = [&](int endIndex, bool wait) {
+        for (; sentCount < endIndex; ++sentCount) {
+            const int i = sentCount;
+            if (readInParallel[i]) {
+                if (wait) {
+                    parallelReadFinished[i].acquire();
+                } else if (!parallelReadFinished[i].tryAcquire()) {
+                    return;
+                }
+            }
+            ReaderStatusUpdate update;
+            if (readInParallel[i] || readByWorker[i]) {
+                update = finishReadRequest(
+                        requests[i].chunk,
+                        bufferedFrameIndexRanges[i]);
+            } else {
+                // Not readable or aborted
+                update.init(CHUNK_READ_INVALID, requests[i].chunk, m_readableFrameIndexRange);
+            }
+            sendStatus(update);
+        }
+    };
+
+    for (int i = 0; i < requestCount; ++i) {
+        if (readable[i] && !readInParallel[i]) {
+            if (m_newTrackAvailable || m_stop.load()) {
+                // Return the chunks that have not been read yet, the
+                // reader discards them after loading the new track
+                break;
+            }
+            bufferedFrameIndexRanges[i] = readChunk(
+                    requests[i].chunk,
+                    m_pAudioSource,
+                    &m_tempReadBuffer,
+                    m_decodedBlocks);
+            readByWorker[i] = true;
+        }
+        sendResults(i + 1, false);
+    }
+    // Also waits for all parallel reads before their decoders and
+    // buffers might be reused
+    sendResults(requestCount, true);
+}
+
 // WARNING: Always called from a different thread (GUI)
 void CachingReaderWorker::newTrack(TrackPointer pTrack) {
     QMutexLocker locker(&m_newTrackMutex);
@@ -109,9 +316,8 @@ void CachingReaderWorker::run() {
             } // implicitly unlocks the mutex
             loadTrack(pLoadTrack);
         } else if (m_pChunkReadRequestFIFO->read(&request, 1) == 1) {
-            // Read the requested chunk and send the result
-            const ReaderStatusUpdate update(processReadRequest(request));
-            m_pReaderStatusFIFO->writeBlocking(&update, 1);
+            // Read the requested chunks and send the results
+            processReadRequests(request);
         } else {
             Event::end(m_tag);
             m_semaRun.acquire();
@@ -136,11 +342,16 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
     ReaderStatusUpdate status;
     status.init(TRACK_NOT_LOADED);
 
+    // Close the additional audio sources of the previous track
+    m_pParallelDecodingTrack.reset();
+    m_parallelDecoders.clear();
+
     if (!pTrack) {
         // Unload track
+        m_decodedBlocks = mixxx::DecodedBlockCache::Consumer();
         m_pAudioSource.reset(); // Close open file handles
         m_readableFrameIndexRange = mixxx::IndexRange();
-        m_pReaderStatusFIFO->writeBlocking(&status, 1);
+        sendStatus(status);
         return;
     }
 
@@ -152,7 +363,7 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
         // Must unlock before emitting to avoid deadlock
         kLogger.debug() << m_group << "loadTrack() load failed for\""
                  << filename << "\", unlocked reader lock";
-        m_pReaderStatusFIFO->writeBlocking(&status, 1);
+        sendStatus(status);
         emit(trackLoadFailed(
             pTrack, QString("The file '%1' could not be found.")
                     .arg(QDir::toNativeSeparators(filename))));
@@ -161,23 +372,37 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
 
     mixxx::AudioSource::OpenParams config;
     config.setChannelCount(CachingReaderChunk::kChannels);
+    config.setIoStatsKey(m_tag);
+    m_decodedBlocks = mixxx::DecodedBlockCache::Consumer();
     m_pAudioSource = openAudioSourceForReading(pTrack, config);
     if (!m_pAudioSource) {
         m_readableFrameIndexRange = mixxx::IndexRange();
         // Must unlock before emitting to avoid deadlock
         kLogger.debug() << m_group << "loadTrack() load failed for\""
                  << filename << "\", file invalid, unlocked reader lock";
-        m_pReaderStatusFIFO->writeBlocking(&status, 1);
+        sendStatus(status);
         emit(trackLoadFailed(
             pTrack, QString("The file '%1' could not be loaded.").arg(filename)));
         return;
     }
 
-    const SINT tempReadBufferSize = m_pAudioSource->frames2samples(CachingReaderChunk::kFrames);
-    if (m_tempReadBuffer.size() != tempReadBufferSize) {
-        mixxx::SampleBuffer(tempReadBufferSize).swap(m_tempReadBuffer);
+    const SINT readBufferSize = tempReadBufferSize(m_pAudioSource);
+    if (m_tempReadBuffer.size() != readBufferSize) {
+        mixxx::SampleBuffer(readBufferSize).swap(m_tempReadBuffer);
+    }
+
+    // Additional audio sources for decoding multiple chunks at once
+    // are opened on demand
+    if (isDecodableInParallel(filename)) {
+        m_pParallelDecodingTrack = pTrack;
     }
 
+    m_decodedBlocks = mixxx::DecodedBlockCache::Consumer(
+            mixxx::DecodedBlockCache::instance(),
+            filename,
+            m_pAudioSource->frameIndexRange(),
+            m_pAudioSource->sampleRate());
+
     // Initially assume that the complete content offered by audio source
     // is available for reading. Later if read errors occur this value will
     // be decreased to avoid repeated reading of corrupt audio data.
@@ -186,7 +411,7 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
     status.status = TRACK_LOADED;
     status.readableFrameIndexRangeStart = m_readableFrameIndexRange.start();
     status.readableFrameIndexRangeEnd = m_readableFrameIndexRange.end();
-    m_pReaderStatusFIFO->writeBlocking(&status, 1);
+    sendStatus(status);
 
     // Clear the chunks to read list.
     CachingReaderChunkReadRequest request;
@@ -194,7 +419,7 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
         kLogger.debug() << "Cancelling read request for " << request.chunk->getIndex();
         status.status = CHUNK_READ_INVALID;
         status.chunk = request.chunk;
-        m_pReaderStatusFIFO->writeBlocking(&status, 1);
+        sendStatus(status);
     }
 
     // Emit that the track is loaded.
@@ -204,6 +429,34 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
     emit(trackLoaded(pTrack, m_pAudioSource->sampleRate(), sampleCount));
 }
 
+int CachingReaderWorker::openParallelDecoders(int count) {
+    DEBUG_ASSERT(count < kMaxConcurrentChunkReadsPerDeck);
+    while (m_pParallelDecodingTrack &&
+            (static_cast<int>(m_parallelDecoders.size()) < count)) {
+        mixxx::AudioSource::OpenParams config;
+        config.setChannelCount(CachingReaderChunk::kChannels);
+        config.setIoStatsKey(m_tag);
+        auto pAudioSource = openAudioSourceForReading(
+                m_pParallelDecodingTrack, config);
+        // All chunks must be read from the same signal
+        if (!pAudioSource ||
+                (pAudioSource->frameIndexRange() != m_pAudioSource->frameIndexRange()) ||
+                (pAudioSource->sampleRate() != m_pAudioSource->sampleRate())) {
+            kLogger.warning()
+                    << "Decoding chunks of"
+                    << m_pParallelDecodingTrack->getLocation()
+                    << "sequentially";
+            m_pParallelDecodingTrack.reset();
+            break;
+        }
+        ParallelDecoder decoder;
+        mixxx::SampleBuffer(tempReadBufferSize(pAudioSource)).swap(decoder.tempReadBuffer);
+        decoder.pAudioSource = std::move(pAudioSource);
+        m_parallelDecoders.push_back(std::move(decoder));
+    }
+    return math_min(count, static_cast<int>(m_parallelDecoders.size()));
+}
+
 void CachingReaderWorker::quitWait() {
     m_stop = 1;
     m_semaRun.release();
@@ -7,10 +7,14 @@
 #include <QThread>
 #include <QString>
 
+#include <atomic>
+#include <vector>
+
 #include "engine/cachingreader/cachingreaderchunk.h"
 #include "track/track.h"
 #include "engine/engineworker.h"
 #include "sources/audiosource.h"
+#include "sources/decodedblockcache.h"
 #include "util/fifo.h"
 
 
@@ -77,6 +81,14 @@ class CachingReaderWorker : public EngineWorker {
 
     void quitWait();
 
+    // Releases the semaphore after each status update that has been
+    // written into the FIFO. Only used for blocking reads, pass nullptr
+    // to disable. Thread-safe, the worker might still release the
+    // previous semaphore once after it has been replaced.
+    void setStatusAvailableSemaphore(QSemaphore* pStatusAvailable) {
+        m_pStatusAvailable.store(pStatusAvailable);
+    }
+
   signals:
     // Emitted once a new track is loaded and ready to be read from.
     void trackLoading();
@@ -91,6 +103,11 @@ class CachingReaderWorker : public EngineWorker {
     // reader thread.
     FIFO<CachingReaderChunkReadRequest>* m_pChunkReadRequestFIFO;
     FIFO<ReaderStatusUpdate>* m_pReaderStatusFIFO;
+    std::atomic<QSemaphore*> m_pStatusAvailable;
+
+    // Writes the status update into the FIFO and notifies a
+    // waiting reader
+    void sendStatus(const ReaderStatusUpdate& status);
 
     // Queue of Tracks to load, and the corresponding lock. Must acquire the
     // lock to touch.
@@ -101,12 +118,37 @@ class CachingReaderWorker : public EngineWorker {
     // Internal method to load a track. Emits trackLoaded when finished.
     void loadTrack(const TrackPointer& pTrack);
 
-    ReaderStatusUpdate processReadRequest(
+    // Processes the given request together with all pending requests
+    // that can be decoded in parallel and sends the results.
+    void processReadRequests(
             const CachingReaderChunkReadRequest& request);
 
+    bool isReadable(const CachingReaderChunk* pChunk) const;
+    ReaderStatusUpdate finishReadRequest(
+            CachingReaderChunk* pChunk,
+            const mixxx::IndexRange& bufferedFrameIndexRange);
+
+    // An additional audio source of the track loaded for decoding
+    // chunks on the shared thread pool
+    struct ParallelDecoder {
+        mixxx::AudioSourcePointer pAudioSource;
+        mixxx::SampleBuffer tempReadBuffer;
+    };
+
+    // Opens additional audio sources on demand and returns how many
+    // of the requested decoders are available
+    int openParallelDecoders(int count);
+
     // The current audio source of the track loaded
     mixxx::AudioSourcePointer m_pAudioSource;
 
+    // Only set while chunks of the track loaded are decoded in parallel
+    TrackPointer m_pParallelDecodingTrack;
+    std::vector<ParallelDecoder> m_parallelDecoders;
+
+    // Shares the decoded chunks with the analysis of the track loaded
+    mixxx::DecodedBlockCache::Consumer m_decodedBlocks;
+
     // Temporary buffer for reading samples from all channels
     // before conversion to a stereo signal.
     mixxx::SampleBuffer m_tempReadBuffer;
@@ -420,6 +420,20 @@ double LoopingControl::nextTrigger(bool reverse,
     return kNoTrigger;
 }
 
+bool LoopingControl::getActiveLoop(double* pStartSample,
+        double* pEndSample) const {
+    if (!m_bLoopingEnabled || m_bAdjustingLoopIn || m_bAdjustingLoopOut) {
+        return false;
+    }
+    LoopSamples loopSamples = m_loopSamples.getValue();
+    if (loopSamples.start == kNoTrigger || loopSamples.end == kNoTrigger) {
+        return false;
+    }
+    *pStartSample = loopSamples.start;
+    *pEndSample = loopSamples.end;
+    return true;
+}
+
 void LoopingControl::hintReader(HintVector* pHintList) {
     LoopSamples loopSamples = m_loopSamples.getValue();
     Hint loop_hint;
@@ -44,6 +44,10 @@ class LoopingControl : public EngineControl {
                        const double currentSample,
                        double *pTarget);
 
+    // getActiveLoop returns the loop that nextTrigger will take, without
+    // changing any state. Returns false if no loop will be taken.
+    virtual bool getActiveLoop(double* pStartSample, double* pEndSample) const;
+
     // hintReader will add to hintList hints both the loop in and loop out
     // sample, if set.
     void hintReader(HintVector* pHintList) override;
@@ -8,11 +8,13 @@ EngineEffectChain::EngineEffectChain(const QString& id,
                                      const QSet<ChannelHandleAndGroup>& registeredInputChannels,
                                      const QSet<ChannelHandleAndGroup>& registeredOutputChannels)
         : m_id(id),
+          m_idLatin1(id.toLatin1()),
           m_enableState(EffectEnableState::Enabled),
           m_mixMode(EffectChainMixMode::DrySlashWet),
           m_dMix(0),
           m_buffer1(MAX_BUFFER_LEN),
-          m_buffer2(MAX_BUFFER_LEN) {
+          m_buffer2(MAX_BUFFER_LEN),
+          m_bProcessTimingEnabled(false) {
     // Try to prevent memory allocation.
     m_effects.reserve(256);
 
@@ -257,6 +259,10 @@ bool EngineEffectChain::process(const ChannelHandle& inputHandle,
 
     bool processingOccured = false;
     if (effectiveChainEnableState != EffectEnableState::Disabled) {
+        if (m_bProcessTimingEnabled) {
+            m_processTimer.start();
+        }
+
         // Ramping code inside the effects need to access the original samples
         // after writing to the output buffer. This requires not to use the same buffer
         // for in and output: Also, ChannelMixer::applyEffectsAndMixChannels
@@ -327,6 +333,10 @@ bool EngineEffectChain::process(const ChannelHandle& inputHandle,
                         numSamples);
             }
         }
+
+        if (m_bProcessTimingEnabled) {
+            m_processTime += m_processTimer.elapsed();
+        }
     }
 
     channelStatus.oldMixKnob = currentMixKnob;
@@ -6,6 +6,8 @@
 #include <QLinkedList>
 
 #include "util/class.h"
+#include "util/duration.h"
+#include "util/performancetimer.h"
 #include "util/types.h"
 #include "util/samplebuffer.h"
 #include "util/memory.h"
@@ -38,8 +40,27 @@ class EngineEffectChain : public EffectsRequestHandler {
         return m_id;
     }
 
+    // The id as a plain C string that may be copied in the engine thread
+    const char* idLatin1() const {
+        return m_idLatin1.constData();
+    }
+
     bool enabledForChannel(const ChannelHandle& handle) const;
 
+    // Enables measuring the time spent in process(). Only call it from
+    // the engine thread.
+    void setProcessTimingEnabled(bool enabled) {
+        m_bProcessTimingEnabled = enabled;
+    }
+
+    // Returns the time spent in process() since the previous call and
+    // resets it. Only call it from the engine thread.
+    mixxx::Duration takeProcessTime() {
+        const mixxx::Duration processTime = m_processTime;
+        m_processTime = mixxx::Duration();
+        return processTime;
+    }
+
     void deleteStatesForInputChannel(const ChannelHandle* channel);
 
   private:
@@ -69,6 +90,7 @@ class EngineEffectChain : public EffectsRequestHandler {
                                     const ChannelHandle& outputHandle);
 
     QString m_id;
+    const QByteArray m_idLatin1;
     EffectEnableState m_enableState;
     EffectChainMixMode m_mixMode;
     CSAMPLE m_dMix;
@@ -77,6 +99,10 @@ class EngineEffectChain : public EffectsRequestHandler {
     mixxx::SampleBuffer m_buffer2;
     ChannelHandleMap<ChannelHandleMap<ChannelStatus>> m_chainStatusForChannelMatrix;
 
+    bool m_bProcessTimingEnabled;
+    PerformanceTimer m_processTimer;
+    mixxx::Duration m_processTime;
+
     DISALLOW_COPY_AND_ASSIGN(EngineEffectChain);
 };
 
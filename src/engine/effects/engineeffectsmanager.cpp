@@ -10,7 +10,8 @@
 EngineEffectsManager::EngineEffectsManager(EffectsResponsePipe* pResponsePipe)
         : m_pResponsePipe(pResponsePipe),
           m_buffer1(MAX_BUFFER_LEN),
-          m_buffer2(MAX_BUFFER_LEN) {
+          m_buffer2(MAX_BUFFER_LEN),
+          m_bProcessTimingEnabled(false) {
     // Try to prevent memory allocation.
     m_chains.reserve(256);
     m_effects.reserve(256);
@@ -48,6 +49,8 @@ void EngineEffectsManager::onCallbackStart() {
                     // requests about it.
                     if (request->type == EffectsRequest::ADD_CHAIN_TO_RACK) {
                         m_chains.append(request->AddChainToRack.pChain);
+                        request->AddChainToRack.pChain->setProcessTimingEnabled(
+                                m_bProcessTimingEnabled);
                     } else if (request->type == EffectsRequest::REMOVE_CHAIN_FROM_RACK) {
                         m_chains.removeAll(request->RemoveChainFromRack.pChain);
                     }
@@ -119,6 +122,37 @@ void EngineEffectsManager::onCallbackStart() {
     }
 }
 
+void EngineEffectsManager::setProcessTimingEnabled(bool enabled) {
+    if (m_bProcessTimingEnabled == enabled) {
+        return;
+    }
+    m_bProcessTimingEnabled = enabled;
+    for (EngineEffectChain* pChain : m_chains) {
+        pChain->setProcessTimingEnabled(enabled);
+    }
+}
+
+int EngineEffectsManager::collectProcessTimes(mixxx::Duration* pTotal,
+        const EngineEffectChain** pChains,
+        mixxx::Duration* pTimes,
+        int maxChains) {
+    int processedChains = 0;
+    *pTotal = mixxx::Duration();
+    for (EngineEffectChain* pChain : m_chains) {
+        const mixxx::Duration processTime = pChain->takeProcessTime();
+        if (processTime <= mixxx::Duration()) {
+            continue;
+        }
+        *pTotal += processTime;
+        if (processedChains < maxChains) {
+            pChains[processedChains] = pChain;
+            pTimes[processedChains] = processTime;
+        }
+        ++processedChains;
+    }
+    return processedChains;
+}
+
 void EngineEffectsManager::processPreFaderInPlace(const ChannelHandle& inputHandle,
                                                   const ChannelHandle& outputHandle,
                                                   CSAMPLE* pInOut,
@@ -3,6 +3,7 @@
 
 #include <QScopedPointer>
 
+#include "util/duration.h"
 #include "util/samplebuffer.h"
 #include "util/types.h"
 #include "util/fifo.h"
@@ -59,6 +60,19 @@ class EngineEffectsManager : public EffectsRequestHandler {
         EffectsRequest& message,
         EffectsResponsePipe* pResponsePipe);
 
+    // Enables measuring the processing times of all effect chains, also
+    // of the ones that are added later on.
+    void setProcessTimingEnabled(bool enabled);
+
+    // Sums up and resets the processing times of all effect chains since
+    // the previous call. The chains that have been processed and their
+    // times are stored in pChains and pTimes, up to maxChains. Returns
+    // the number of processed chains, which may exceed maxChains.
+    int collectProcessTimes(mixxx::Duration* pTotal,
+            const EngineEffectChain** pChains,
+            mixxx::Duration* pTimes,
+            int maxChains);
+
   private:
     QString debugString() const {
         return QString("EngineEffectsManager");
@@ -90,6 +104,8 @@ class EngineEffectsManager : public EffectsRequestHandler {
 
     mixxx::SampleBuffer m_buffer1;
     mixxx::SampleBuffer m_buffer2;
+
+    bool m_bProcessTimingEnabled;
 };
 
 
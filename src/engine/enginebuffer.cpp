@@ -67,6 +67,9 @@ EngineBuffer::EngineBuffer(const QString& group, UserSettingsPointer pConfig,
           m_tempo_ratio_old(1.),
           m_scratching_old(false),
           m_reverse_old(false),
+          m_loop_active_old(false),
+          m_loop_start_old(0.),
+          m_loop_end_old(0.),
           m_pitch_old(0),
           m_baserate_old(0),
           m_rate_old(0.),
@@ -75,6 +78,7 @@ EngineBuffer::EngineBuffer(const QString& group, UserSettingsPointer pConfig,
           m_dSlipPosition(0.),
           m_dSlipRate(1.0),
           m_bSlipEnabledProcessing(false),
+          m_bWorkersBound(false),
           m_pRepeat(nullptr),
           m_startButton(nullptr),
           m_endButton(nullptr),
@@ -168,6 +172,15 @@ EngineBuffer::EngineBuffer(const QString& group, UserSettingsPointer pConfig,
     m_pKeylock = new ControlPushButton(ConfigKey(m_group, "keylock"), true);
     m_pKeylock->setButtonMode(ControlPushButton::TOGGLE);
 
+    // The look-ahead worker is started and stopped in the thread of
+    // this object, never in the engine callback
+    m_pKeylockLookAhead = new ControlProxy("[Master]", "keylock_lookahead", this);
+    m_pKeylockLookAhead->connectValueChanged(this, &EngineBuffer::slotUpdateKeylockLookAhead,
+                                             Qt::QueuedConnection);
+    connect(m_pKeylock, &ControlObject::valueChanged,
+            this, &EngineBuffer::slotUpdateKeylockLookAhead,
+            Qt::QueuedConnection);
+
     m_pEject = new ControlPushButton(ConfigKey(m_group, "eject"));
     connect(m_pEject, &ControlObject::valueChanged,
             this, &EngineBuffer::slotEjectTrack,
@@ -691,6 +704,18 @@ void EngineBuffer::slotKeylockEngineChanged(double dIndex) {
     } else {
         m_pScaleKeylock = m_pScaleRB;
     }
+    QMetaObject::invokeMethod(this, "slotUpdateKeylockLookAhead",
+            Qt::QueuedConnection);
+}
+
+void EngineBuffer::slotUpdateKeylockLookAhead() {
+    if (!m_bWorkersBound) {
+        return;
+    }
+    m_pScaleRB->setLookAheadWorkerEnabled(
+            m_pKeylockLookAhead->toBool() &&
+            m_pKeylock->toBool() &&
+            m_pKeylockEngine->get() != SOUNDTOUCH);
 }
 
 void EngineBuffer::processTrackLocked(
@@ -865,6 +890,12 @@ void EngineBuffer::processTrackLocked(
             readToCrossfadeBuffer(iBufferSize);
             // Clear the scaler information
             m_pScale->clear();
+        } else if (m_pScale->hasLookAhead()) {
+            // The scaler has rendered ahead of the play position with the
+            // old parameters. Crossfade from that output and restart the
+            // scaler at the play position.
+            readToCrossfadeBuffer(iBufferSize);
+            m_pScale->clear();
         }
 
         m_baserate_old = baserate;
@@ -897,6 +928,25 @@ void EngineBuffer::processTrackLocked(
         rate = m_rate_old;
     }
 
+    // The scaler might have rendered ahead across the old loop boundaries,
+    // e.g. past loop_out of a loop that has just been enabled or shortened.
+    // Like for parameter changes, crossfade from that output and restart
+    // the scaler at the play position.
+    double loopStart = 0.;
+    double loopEnd = 0.;
+    const bool loopActive = m_pLoopingControl->getActiveLoop(&loopStart, &loopEnd);
+    if (loopActive != m_loop_active_old ||
+            (loopActive && (loopStart != m_loop_start_old ||
+                    loopEnd != m_loop_end_old))) {
+        if (m_pScale->hasLookAhead()) {
+            readToCrossfadeBuffer(iBufferSize);
+            m_pScale->clear();
+        }
+        m_loop_active_old = loopActive;
+        m_loop_start_old = loopStart;
+        m_loop_end_old = loopEnd;
+    }
+
     bool at_start = m_filepos_play <= 0;
     bool at_end = m_filepos_play >= m_trackSamplesOld;
     bool backwards = rate < 0;
@@ -1277,6 +1327,13 @@ void EngineBuffer::addControl(EngineControl* pControl) {
 
 void EngineBuffer::bindWorkers(EngineWorkerScheduler* pWorkerScheduler) {
     m_pReader->setScheduler(pWorkerScheduler);
+    m_pScaleRB->bindWorkers(pWorkerScheduler);
+    m_bWorkersBound = true;
+    slotUpdateKeylockLookAhead();
+}
+
+void EngineBuffer::setBlockingReads(bool blockingReads) {
+    m_pReader->setBlockingReads(blockingReads);
 }
 
 bool EngineBuffer::isTrackLoaded() {
@@ -116,6 +116,8 @@ class EngineBuffer : public EngineObject {
     virtual ~EngineBuffer();
 
     void bindWorkers(EngineWorkerScheduler* pWorkerScheduler);
+    // See CachingReader::setBlockingReads()
+    void setBlockingReads(bool blockingReads);
 
     // Return the current rate (not thread-safe)
     double getSpeed();
@@ -204,6 +206,9 @@ class EngineBuffer : public EngineObject {
                              QString reason);
     // Fired when passthrough mode is enabled or disabled.
     void slotPassthroughChanged(double v);
+    // Starts or stops the look-ahead worker of the Rubberband scaler,
+    // which is only needed while keylock is enabled
+    void slotUpdateKeylockLookAhead();
 
   private:
     // Add an engine control to the EngineBuffer
@@ -297,6 +302,12 @@ class EngineBuffer : public EngineObject {
     // True if the previous callback was reverse.
     bool m_reverse_old;
 
+    // The loop that was active in the previous callback. Used to discard
+    // the look-ahead of the scaler when the loop changes.
+    bool m_loop_active_old;
+    double m_loop_start_old;
+    double m_loop_end_old;
+
     // The previous callback's pitch. Used to check if the scaler parameters
     // need updating.
     double m_pitch_old;
@@ -344,7 +355,9 @@ class EngineBuffer : public EngineObject {
     ControlPotmeter* m_playposSlider;
     ControlProxy* m_pSampleRate;
     ControlProxy* m_pKeylockEngine;
+    ControlProxy* m_pKeylockLookAhead;
     ControlPushButton* m_pKeylock;
+    bool m_bWorkersBound;
 
     // This ControlProxys is created as parent to this and deleted by
     // the Qt object tree. This helps that they are deleted by the creating
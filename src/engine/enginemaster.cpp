@@ -11,6 +11,7 @@
 #include "control/controlpushbutton.h"
 #include "effects/effectsmanager.h"
 #include "engine/channelmixer.h"
+#include "engine/effects/engineeffectchain.h"
 #include "engine/effects/engineeffectsmanager.h"
 #include "engine/enginebuffer.h"
 #include "engine/enginebuffer.h"
@@ -25,6 +26,7 @@
 #include "engine/sync/enginesync.h"
 #include "mixer/playermanager.h"
 #include "util/defs.h"
+#include "util/math.h"
 #include "util/sample.h"
 #include "util/timer.h"
 #include "util/trace.h"
@@ -63,6 +65,11 @@ EngineMaster::EngineMaster(UserSettingsPointer pConfig,
     m_bBusOutputConnected[EngineChannel::CENTER] = false;
     m_bBusOutputConnected[EngineChannel::RIGHT] = false;
     m_bExternalRecordBroadcastInputConnected = false;
+    m_bStageTimingEnabled = false;
+    m_bTimingStages = false;
+    m_lastStageTimes.slowestChannel = -1;
+    m_lastStageTimes.effectChainCount = 0;
+    m_lastStageTimes.effectChainsOmitted = 0;
     m_pWorkerScheduler = new EngineWorkerScheduler(this);
     m_pWorkerScheduler->start(QThread::HighPriority);
 
@@ -174,6 +181,10 @@ EngineMaster::EngineMaster(UserSettingsPointer pConfig,
                                          true, false, true);
     m_pKeylockEngine->set(pConfig->getValueString(
             ConfigKey(group, "keylock_engine")).toDouble());
+    // Stretch ahead of the play position in a worker thread while the
+    // tempo of a deck with keylock is steady (Rubberband only)
+    m_pKeylockLookAhead = new ControlObject(ConfigKey(group, "keylock_lookahead"),
+                                            true, false, true);
 
     // TODO: Make this read only and make EngineMaster decide whether
     // processing the master mix is necessary.
@@ -193,6 +204,7 @@ EngineMaster::EngineMaster(UserSettingsPointer pConfig,
 
 EngineMaster::~EngineMaster() {
     qDebug() << "in ~EngineMaster()";
+    delete m_pKeylockLookAhead;
     delete m_pKeylockEngine;
     delete m_pCrossfader;
     delete m_pBalance;
@@ -347,11 +359,23 @@ void EngineMaster::processChannels(int iBufferSize) {
     }
 
     // Now that the list is built and ordered, do the processing.
+    m_lastStageTimes.slowestChannel = -1;
+    m_lastStageTimes.slowestChannelTime = mixxx::Duration();
     for (int i = activeChannelsStartIndex;
              i < m_activeChannels.size(); ++i) {
         ChannelInfo* pChannelInfo = m_activeChannels[i];
         EngineChannel* pChannel = pChannelInfo->m_pChannel;
-        pChannel->process(pChannelInfo->m_pBuffer, iBufferSize);
+        if (m_bTimingStages) {
+            m_channelTimer.start();
+            pChannel->process(pChannelInfo->m_pBuffer, iBufferSize);
+            const mixxx::Duration channelTime = m_channelTimer.elapsed();
+            if (channelTime > m_lastStageTimes.slowestChannelTime) {
+                m_lastStageTimes.slowestChannel = pChannelInfo->m_index;
+                m_lastStageTimes.slowestChannelTime = channelTime;
+            }
+        } else {
+            pChannel->process(pChannelInfo->m_pBuffer, iBufferSize);
+        }
 
         // Collect metadata for effects
         if (m_pEngineEffectsManager) {
@@ -389,7 +413,14 @@ void EngineMaster::process(const int iBufferSize) {
     const unsigned int kChannels = 2;
     const unsigned int iFrames = iBufferSize / kChannels;
 
+    m_bTimingStages = m_bStageTimingEnabled.load();
+    if (m_bTimingStages) {
+        m_stageTimer.start();
+        m_lastStageTimes.sidechain = mixxx::Duration();
+    }
+
     if (m_pEngineEffectsManager) {
+        m_pEngineEffectsManager->setProcessTimingEnabled(m_bTimingStages);
         m_pEngineEffectsManager->onCallbackStart();
     }
 
@@ -400,6 +431,10 @@ void EngineMaster::process(const int iBufferSize) {
     // Do internal master sync post-processing
     m_pMasterSync->onCallbackEnd(m_iSampleRate, m_iBufferSize);
 
+    if (m_bTimingStages) {
+        m_lastStageTimes.channels = m_stageTimer.restart();
+    }
+
     // Compute headphone mix
     // Head phone left/right mix
     CSAMPLE pflMixGainInHeadphones = 1;
@@ -514,6 +549,10 @@ void EngineMaster::process(const int iBufferSize) {
             m_iBufferSize, m_iSampleRate, busFeatures);
     }
 
+    if (m_bTimingStages) {
+        m_lastStageTimes.mixing = m_stageTimer.restart();
+    }
+
     if (masterEnabled) {
         // Mix the crossfader orientation buffers together into the master mix
         SampleUtil::copy3WithGain(m_pMaster,
@@ -667,7 +706,14 @@ void EngineMaster::process(const int iBufferSize) {
         // so skip sending a buffer to m_pSidechain here.
         if (!m_bExternalRecordBroadcastInputConnected
             && m_pEngineSideChain != nullptr) {
-            m_pEngineSideChain->writeSamples(m_pSidechainMix, iFrames);
+            if (m_bTimingStages) {
+                PerformanceTimer sidechainTimer;
+                sidechainTimer.start();
+                m_pEngineSideChain->writeSamples(m_pSidechainMix, iFrames);
+                m_lastStageTimes.sidechain = sidechainTimer.elapsed();
+            } else {
+                m_pEngineSideChain->writeSamples(m_pSidechainMix, iFrames);
+            }
         }
 
         // Process effects that apply to master hardware output only but not
@@ -724,9 +770,48 @@ void EngineMaster::process(const int iBufferSize) {
         m_pBoothDelay->process(m_pBooth, m_iBufferSize);
     }
 
+    if (m_bTimingStages) {
+        m_lastStageTimes.outputs = m_stageTimer.restart();
+    }
+
     // We're close to the end of the callback. Wake up the engine worker
     // scheduler so that it runs the workers.
     m_pWorkerScheduler->runWorkers();
+
+    if (m_bTimingStages) {
+        m_lastStageTimes.workers = m_stageTimer.elapsed();
+        collectEffectsProcessTimes();
+    }
+}
+
+void EngineMaster::collectEffectsProcessTimes() {
+    m_lastStageTimes.effects = mixxx::Duration();
+    m_lastStageTimes.effectChainCount = 0;
+    m_lastStageTimes.effectChainsOmitted = 0;
+    if (!m_pEngineEffectsManager) {
+        return;
+    }
+    const EngineEffectChain* chains[StageTimes::kMaxEffectChains];
+    mixxx::Duration times[StageTimes::kMaxEffectChains];
+    const int chainCount = m_pEngineEffectsManager->collectProcessTimes(
+            &m_lastStageTimes.effects,
+            chains, times, StageTimes::kMaxEffectChains);
+    for (int i = 0; i < math_min(chainCount, StageTimes::kMaxEffectChains); ++i) {
+        StageTimes::EffectChainTime& chainTime = m_lastStageTimes.effectChains[i];
+        qstrncpy(chainTime.id, chains[i]->idLatin1(), StageTimes::kMaxNameLength);
+        chainTime.time = times[i];
+    }
+    m_lastStageTimes.effectChainCount =
+            math_min(chainCount, StageTimes::kMaxEffectChains);
+    m_lastStageTimes.effectChainsOmitted =
+            chainCount - m_lastStageTimes.effectChainCount;
+}
+
+QString EngineMaster::getChannelGroup(int channelIndex) const {
+    if (channelIndex < 0 || channelIndex >= m_channels.size()) {
+        return QString();
+    }
+    return m_channels[channelIndex]->m_pChannel->getGroup();
 }
 
 void EngineMaster::applyMasterEffects() {
@@ -804,6 +889,15 @@ void EngineMaster::addChannel(EngineChannel* pChannel) {
     }
 }
 
+void EngineMaster::setBlockingReads(bool blockingReads) {
+    for (int i = 0; i < m_channels.size(); ++i) {
+        EngineBuffer* pBuffer = m_channels[i]->m_pChannel->getEngineBuffer();
+        if (pBuffer != NULL) {
+            pBuffer->setBlockingReads(blockingReads);
+        }
+    }
+}
+
 EngineChannel* EngineMaster::getChannel(const QString& group) {
     for (int i = 0; i < m_channels.size(); ++i) {
         ChannelInfo* pChannelInfo = m_channels[i];
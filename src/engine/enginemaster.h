@@ -18,6 +18,8 @@
 #ifndef ENGINEMASTER_H
 #define ENGINEMASTER_H
 
+#include <atomic>
+
 #include <QObject>
 #include <QVarLengthArray>
 
@@ -30,6 +32,8 @@
 #include "soundio/soundmanager.h"
 #include "soundio/soundmanagerutil.h"
 #include "recording/recordingmanager.h"
+#include "util/duration.h"
+#include "util/performancetimer.h"
 
 class EngineWorkerScheduler;
 class EngineBuffer;
@@ -90,6 +94,60 @@ class EngineMaster : public QObject, public AudioSource {
     // only call it before the engine has started mixing.
     void addChannel(EngineChannel* pChannel);
     EngineChannel* getChannel(const QString& group);
+
+    // Lets the engine wait for audio data that has not been decoded yet
+    // instead of playing silence. Only used for offline rendering. Only
+    // call it from the thread that calls process() or before mixing has
+    // started. The caching readers themselves may be busy meanwhile.
+    void setBlockingReads(bool blockingReads);
+
+    // Processing time of the individual stages of the most recent
+    // process() call. Only measured while enabled with
+    // setStageTimingEnabled(), e.g. by the AudioCallbackMonitor or the
+    // engine benchmarks, so the engine does not read the clock for every
+    // channel and effect chain if nobody is interested in the result.
+    struct StageTimes {
+        static constexpr int kMaxNameLength = 48;
+        static constexpr int kMaxEffectChains = 32;
+
+        struct EffectChainTime {
+            char id[kMaxNameLength];
+            mixxx::Duration time;
+        };
+
+        // EngineSync and all active channels incl. pre-fader effects
+        mixxx::Duration channels;
+        // Headphone, talkover and crossfader bus mixes incl. effects
+        mixxx::Duration mixing;
+        // Master, booth and headphone outputs incl. master effects
+        mixxx::Duration outputs;
+        // Scheduling of the engine workers
+        mixxx::Duration workers;
+
+        // Breakdown of the stages above
+        mixxx::Duration effects;
+        mixxx::Duration sidechain;
+        // Index of the slowest channel, see getChannelGroup()
+        int slowestChannel;
+        mixxx::Duration slowestChannelTime;
+        // All effect chains that have been processed, in the order they
+        // have been added to the engine. Chains beyond kMaxEffectChains
+        // are only counted in effectChainsOmitted and in effects.
+        EffectChainTime effectChains[kMaxEffectChains];
+        int effectChainCount;
+        int effectChainsOmitted;
+    };
+    // Thread safe, takes effect with the next callback.
+    void setStageTimingEnabled(bool enabled) {
+        m_bStageTimingEnabled.store(enabled);
+    }
+    const StageTimes& getLastStageTimes() const {
+        return m_lastStageTimes;
+    }
+    // Returns the group of a channel by the index that is used in
+    // StageTimes. Not thread safe -- only call it from the main thread.
+    QString getChannelGroup(int channelIndex) const;
+
     static inline double gainForOrientation(EngineChannel::ChannelOrientation orientation,
                                             double leftGain,
                                             double centerGain,
@@ -270,6 +328,10 @@ class EngineMaster : public QObject, public AudioSource {
     // respective output.
     void processChannels(int iBufferSize);
 
+    // Collects the processing times of all effect chains into
+    // m_lastStageTimes.
+    void collectEffectsProcessTimes();
+
     ChannelHandleFactory* m_pChannelHandleFactory;
     void applyMasterEffects();
     void processHeadphones(const double masterMixGainInHeadphones);
@@ -333,6 +395,7 @@ class EngineMaster : public QObject, public AudioSource {
     ControlPushButton* m_pXFaderReverse;
     ControlPushButton* m_pHeadSplitEnabled;
     ControlObject* m_pKeylockEngine;
+    ControlObject* m_pKeylockLookAhead;
 
     PflGainCalculator m_headphoneGain;
     TalkoverGainCalculator m_talkoverGain;
@@ -357,6 +420,13 @@ class EngineMaster : public QObject, public AudioSource {
 
     volatile bool m_bBusOutputConnected[3];
     bool m_bExternalRecordBroadcastInputConnected;
+
+    std::atomic<bool> m_bStageTimingEnabled;
+    // m_bStageTimingEnabled for the current callback
+    bool m_bTimingStages;
+    PerformanceTimer m_stageTimer;
+    PerformanceTimer m_channelTimer;
+    StageTimes m_lastStageTimes;
 };
 
 #endif
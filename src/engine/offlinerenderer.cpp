@@ -0,0 +1,252 @@
+#include "engine/offlinerenderer.h"
+
+#include <QFileInfo>
+
+#include "control/controlobject.h"
+#include "control/controlproxy.h"
+#include "engine/enginemaster.h"
+#include "soundio/soundmanagerutil.h"
+#include "util/compatibility.h"
+#include "util/denormalsarezero.h"
+#include "util/logger.h"
+#include "util/math.h"
+#include "util/performancetimer.h"
+#include "util/trace.h"
+
+namespace {
+
+const mixxx::Logger kLogger("OfflineRenderer");
+
+// EngineMaster produces stereo output
+const SINT kChannels = 2;
+
+const double kProgressIntervalSeconds = 10.0;
+
+const mixxx::Duration kTrackLoadTimeout = mixxx::Duration::fromSeconds(60);
+
+} // anonymous namespace
+
+OfflineRenderer::OfflineRenderer(UserSettingsPointer pConfig,
+        EngineMaster* pEngineMaster,
+        const QString& outputPath,
+        const QStringList& playGroups,
+        mixxx::Duration duration,
+        SINT sampleRate,
+        SINT framesPerBuffer)
+        : m_pConfig(pConfig),
+          m_pEngineMaster(pEngineMaster),
+          m_outputPath(outputPath),
+          m_duration(duration),
+          m_sampleRate(sampleRate),
+          m_framesPerBuffer(framesPerBuffer),
+          m_trackLoadsFailed(0),
+          m_stop(false) {
+    setObjectName("OfflineRenderer");
+    for (const auto& group: playGroups) {
+        m_playControls.append(
+                new ControlProxy(group, "play", this));
+        ControlProxy* pTrackLoaded =
+                new ControlProxy(group, "track_loaded", this);
+        pTrackLoaded->connectValueChanged(
+                this, &OfflineRenderer::slotTrackLoaded,
+                Qt::DirectConnection);
+        m_trackLoadedControls.append(pTrackLoaded);
+    }
+}
+
+OfflineRenderer::~OfflineRenderer() {
+    stop();
+    wait();
+}
+
+bool OfflineRenderer::initEncoder() {
+    // Select the encoder by the file extension and fall back to
+    // the format that has been configured for recording.
+    const EncoderFactory& factory = EncoderFactory::getFactory();
+    Encoder::Format format = factory.getSelectedFormat(m_pConfig);
+    const QString suffix = QFileInfo(m_outputPath).suffix();
+    for (const auto& candidate: factory.getFormats()) {
+        if (candidate.internalName.compare(suffix, Qt::CaseInsensitive) == 0) {
+            format = candidate;
+            break;
+        }
+    }
+    m_pEncoder = factory.getNewEncoder(format, m_pConfig, this);
+    if (!m_pEncoder) {
+        kLogger.warning() << "No encoder available for" << format.internalName;
+        return false;
+    }
+    QString errorMsg;
+    if (m_pEncoder->initEncoder(m_sampleRate, errorMsg) < 0) {
+        kLogger.warning() << "Failed to initialize encoder" << errorMsg;
+        m_pEncoder.reset();
+        return false;
+    }
+    kLogger.info() << "Rendering into" << m_outputPath
+            << "with format" << format.internalName;
+    return true;
+}
+
+void OfflineRenderer::slotTrackLoaded(double loaded) {
+    // A failed load ejects the track and resets the control
+    if (loaded <= 0.0) {
+        ++m_trackLoadsFailed;
+    }
+    m_trackLoadedChanged.release();
+}
+
+bool OfflineRenderer::waitForTracksLoaded(int bufferSamples,
+        mixxx::Duration bufferDuration) {
+    PerformanceTimer timer;
+    timer.start();
+    while (!m_stop) {
+        int tracksLoaded = 0;
+        for (const auto* pTrackLoaded: qAsConst(m_trackLoadedControls)) {
+            if (pTrackLoaded->get() > 0.0) {
+                ++tracksLoaded;
+            }
+        }
+        if (tracksLoaded == m_trackLoadedControls.size()) {
+            return true;
+        }
+        if (m_trackLoadsFailed.load() > 0) {
+            kLogger.warning() << "Failed to load the tracks for rendering";
+            return false;
+        }
+        const mixxx::Duration remaining = kTrackLoadTimeout - timer.elapsed();
+        if (remaining <= mixxx::Duration::empty()) {
+            kLogger.warning() << "Timed out while loading the tracks for rendering";
+            return false;
+        }
+        // The reader threads that load the tracks are only woken up
+        // after the engine has been processed. This output is not
+        // rendered.
+        m_pEngineMaster->process(bufferSamples);
+        m_trackLoadedChanged.tryAcquire(1,
+                math_min(remaining, bufferDuration).toIntegerMillis());
+    }
+    return false;
+}
+
+bool OfflineRenderer::isAnyDeckPlaying() const {
+    for (const auto* pPlay: m_playControls) {
+        if (pPlay->get() > 0.0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void OfflineRenderer::run() {
+    if (m_playControls.isEmpty() && m_duration <= mixxx::Duration::empty()) {
+        kLogger.warning() << "Neither tracks nor a duration given for rendering";
+        emit(renderingFinished(false));
+        return;
+    }
+    m_file.setFileName(m_outputPath);
+    if (!m_file.open(QIODevice::WriteOnly)) {
+        kLogger.warning() << "Failed to open" << m_outputPath << "for writing";
+        emit(renderingFinished(false));
+        return;
+    }
+    if (!initEncoder()) {
+        m_file.close();
+        emit(renderingFinished(false));
+        return;
+    }
+
+    // Replace the settings that are otherwise provided by the sound
+    // device that acts as the clock reference.
+    const mixxx::Duration bufferDuration = mixxx::Duration::fromSeconds(
+            static_cast<double>(m_framesPerBuffer) / m_sampleRate);
+    ControlObject::set(ConfigKey("[Master]", "samplerate"), m_sampleRate);
+    ControlObject::set(ConfigKey("[Master]", "latency"),
+            bufferDuration.toDoubleMillis());
+    ControlObject::set(ConfigKey("[Master]", "audio_buffer_size"),
+            bufferDuration.toDoubleMillis());
+    m_pEngineMaster->onOutputConnected(
+            AudioOutput(AudioOutput::MASTER, 0, kChannels));
+    m_pEngineMaster->setBlockingReads(true);
+
+#ifdef __SSE__
+    // See SoundDevicePortAudio::callbackProcessClkRef()
+    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+#endif
+
+    const SINT totalFrames = static_cast<SINT>(
+            m_duration.toDoubleSeconds() * m_sampleRate);
+    const SINT progressIntervalFrames = static_cast<SINT>(
+            kProgressIntervalSeconds * m_sampleRate);
+    const int bufferSamples = m_framesPerBuffer * kChannels;
+
+    if (!waitForTracksLoaded(bufferSamples, bufferDuration)) {
+        m_pEngineMaster->setBlockingReads(false);
+        m_pEncoder.reset();
+        m_file.close();
+        emit(renderingFinished(false));
+        return;
+    }
+    // All decks start playing with the first rendered buffer
+    for (auto* pPlay: qAsConst(m_playControls)) {
+        pPlay->set(1.0);
+    }
+
+    SINT renderedFrames = 0;
+    SINT nextProgressFrames = progressIntervalFrames;
+    PerformanceTimer timer;
+    timer.start();
+    while (!m_stop &&
+            (totalFrames > 0 ? renderedFrames < totalFrames : isAnyDeckPlaying())) {
+        Trace trace("OfflineRenderer::process");
+        m_pEngineMaster->process(bufferSamples);
+        m_pEncoder->encodeBuffer(
+                m_pEngineMaster->getMasterBuffer(), bufferSamples);
+        renderedFrames += m_framesPerBuffer;
+
+        if (renderedFrames >= nextProgressFrames) {
+            nextProgressFrames += progressIntervalFrames;
+            const double renderedSeconds =
+                    static_cast<double>(renderedFrames) / m_sampleRate;
+            emit(progress(renderedSeconds,
+                    renderedSeconds / timer.elapsed().toDoubleSeconds()));
+        }
+    }
+    m_pEncoder->flush();
+    m_pEncoder.reset();
+    m_file.close();
+
+    m_pEngineMaster->setBlockingReads(false);
+
+    const double renderedSeconds =
+            static_cast<double>(renderedFrames) / m_sampleRate;
+    const mixxx::Duration elapsed = timer.elapsed();
+    const double realtimeFactor = renderedSeconds / elapsed.toDoubleSeconds();
+    kLogger.info()
+            << "Rendered" << renderedSeconds << "s of audio in"
+            << elapsed.formatSecondsWithUnit()
+            << "- real-time factor" << realtimeFactor;
+    emit(progress(renderedSeconds, realtimeFactor));
+    emit(renderingFinished(true));
+}
+
+void OfflineRenderer::write(const unsigned char *header, const unsigned char *body,
+        int headerLen, int bodyLen) {
+    // Relevant for OGG
+    if (headerLen > 0) {
+        m_file.write(reinterpret_cast<const char*>(header), headerLen);
+    }
+    m_file.write(reinterpret_cast<const char*>(body), bodyLen);
+}
+
+int OfflineRenderer::tell() {
+    return m_file.pos();
+}
+
+void OfflineRenderer::seek(int pos) {
+    m_file.seek(pos);
+}
+
+int OfflineRenderer::filelen() {
+    return m_file.size();
+}
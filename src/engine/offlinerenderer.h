@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+
+#include <QFile>
+#include <QList>
+#include <QSemaphore>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+#include "encoder/encoder.h"
+#include "encoder/encodercallback.h"
+#include "preferences/usersettings.h"
+#include "util/duration.h"
+#include "util/types.h"
+
+class ControlProxy;
+class EngineMaster;
+
+// Drives EngineMaster::process() from its own thread as fast as the CPU
+// allows and encodes the master output into a file. Replaces the audio
+// devices as clock reference, i.e. no sound device must be open while
+// rendering. Missing audio data is decoded synchronously instead of
+// playing silence (see CachingReader::setBlockingReads()).
+//
+// Rendering starts with the first buffer after the tracks of all given
+// decks have been loaded. These decks are started at the same time.
+// Rendering ends after the given duration or, if no duration is given,
+// as soon as none of these decks is playing anymore.
+//
+// Controls are still modified asynchronously by controllers, AutoDJ
+// and the GUI, so their timing relative to the rendered audio is only
+// as accurate as the main thread is able to keep up.
+class OfflineRenderer : public QThread, public EncoderCallback {
+    Q_OBJECT
+  public:
+    static constexpr SINT kDefaultSampleRate = 44100;
+    static constexpr SINT kDefaultFramesPerBuffer = 1024;
+
+    // A zero duration renders until all decks in playGroups have
+    // stopped. Either a duration or at least one deck is required.
+    OfflineRenderer(UserSettingsPointer pConfig,
+            EngineMaster* pEngineMaster,
+            const QString& outputPath,
+            const QStringList& playGroups,
+            mixxx::Duration duration,
+            SINT sampleRate = kDefaultSampleRate,
+            SINT framesPerBuffer = kDefaultFramesPerBuffer);
+    ~OfflineRenderer() override;
+
+    // Thread-safe
+    void stop() {
+        m_stop = true;
+    }
+
+    // EncoderCallback
+    void write(const unsigned char *header, const unsigned char *body,
+            int headerLen, int bodyLen) override;
+    int tell() override;
+    void seek(int pos) override;
+    int filelen() override;
+
+  signals:
+    // Periodically reports the rendered audio duration and the ratio
+    // between rendered duration and elapsed wall-clock time.
+    void progress(double renderedSeconds, double realtimeFactor);
+    void renderingFinished(bool success);
+
+  protected:
+    void run() override;
+
+  private slots:
+    // Invoked directly by the reader threads of the decks
+    void slotTrackLoaded(double loaded);
+
+  private:
+    bool initEncoder();
+    // Processes the engine in real-time until the tracks of all decks
+    // have been loaded, because loading needs the engine workers.
+    bool waitForTracksLoaded(int bufferSamples,
+            mixxx::Duration bufferDuration);
+    bool isAnyDeckPlaying() const;
+
+    const UserSettingsPointer m_pConfig;
+    EngineMaster* const m_pEngineMaster;
+    const QString m_outputPath;
+    const mixxx::Duration m_duration;
+    const SINT m_sampleRate;
+    const SINT m_framesPerBuffer;
+
+    QList<ControlProxy*> m_playControls;
+    QList<ControlProxy*> m_trackLoadedControls;
+    QSemaphore m_trackLoadedChanged;
+    std::atomic<int> m_trackLoadsFailed;
+
+    EncoderPointer m_pEncoder;
+    QFile m_file;
+
+    std::atomic<bool> m_stop;
+};
@@ -6,11 +6,55 @@
 #include "engine/cachingreader/cachingreader.h"
 #include "engine/controls/loopingcontrol.h"
 #include "engine/controls/ratecontrol.h"
+#include "util/counter.h"
 #include "util/defs.h"
 #include "util/math.h"
 #include "util/sample.h"
 
-static const int kNumChannels = 2;
+namespace {
+
+const int kNumChannels = 2;
+
+// SoundTouch can read up to 2 chunks ahead. Always keep 2 chunks ahead in
+// cache.
+const SINT kMinHintFrames = 2 * CachingReaderChunk::kFrames;
+// Stay well below the capacity of the cache, which is shared with the hints
+// of the cues and loops.
+const SINT kMaxHintFrames = 8 * CachingReaderChunk::kFrames;
+// The number of callbacks that are hinted ahead of the current position
+const int kHintCallbacks = 4;
+
+const QString kCacheMissCounter = QStringLiteral(
+        "ReadAheadManager::getNextSamples cache miss");
+const QString kReadLogOverflowCounter = QStringLiteral(
+        "ReadAheadManager read log overflow");
+
+// Appends a hint for numSamples samples from startSample in the direction
+// of play.
+void appendHint(HintVector* pHintList, double startSample, double numSamples,
+        bool reverse) {
+    const double endSample = reverse ?
+            startSample - numSamples : startSample + numSamples;
+    Hint hint;
+    hint.frame = static_cast<SINT>(
+            floor(math_min(startSample, endSample) / kNumChannels));
+    hint.frameCount = static_cast<SINT>(
+            ceil(math_max(startSample, endSample) / kNumChannels)) - hint.frame;
+    // A frame count of 0 would request the default number of frames
+    if (hint.frameCount <= 0) {
+        return;
+    }
+    // If we are trying to cache before the start of the track,
+    // Then we don't need to cache because it's all zeros!
+    if (hint.frame + hint.frameCount <= 0) {
+        return;
+    }
+    // top priority, we need to read this data immediately
+    hint.priority = 1;
+    pHintList->append(hint);
+}
+
+}  // namespace
 
 ReadAheadManager::ReadAheadManager()
         : m_pLoopingControl(NULL),
@@ -18,7 +62,9 @@ ReadAheadManager::ReadAheadManager()
           m_currentPosition(0),
           m_pReader(NULL),
           m_pCrossFadeBuffer(SampleUtil::alloc(MAX_BUFFER_LEN)),
-          m_cacheMissHappened(false) {
+          m_cacheMissHappened(false),
+          m_samplesReadSinceHint(0),
+          m_cacheMissCount(0) {
     // For testing only: ReadAheadManagerMock
 }
 
@@ -29,7 +75,9 @@ ReadAheadManager::ReadAheadManager(CachingReader* pReader,
           m_currentPosition(0),
           m_pReader(pReader),
           m_pCrossFadeBuffer(SampleUtil::alloc(MAX_BUFFER_LEN)),
-          m_cacheMissHappened(false) {
+          m_cacheMissHappened(false),
+          m_samplesReadSinceHint(0),
+          m_cacheMissCount(0) {
     DEBUG_ASSERT(m_pLoopingControl != NULL);
     DEBUG_ASSERT(m_pReader != NULL);
 }
@@ -94,6 +142,7 @@ SINT ReadAheadManager::getNextSamples(double dRate, CSAMPLE* pOutput,
         // Set the cache miss flag to decide when to apply ramping
         // after the following read attempts.
         m_cacheMissHappened = true;
+        onCacheMiss();
     } else if (m_cacheMissHappened) {
         // Previous read was a cache miss, but now we got something back.
         // Apply ramping gain, because the last buffer has unwanted silenced
@@ -113,6 +162,7 @@ SINT ReadAheadManager::getNextSamples(double dRate, CSAMPLE* pOutput,
         addReadLogEntry(m_currentPosition, m_currentPosition + samples_from_reader);
         m_currentPosition += samples_from_reader;
     }
+    m_samplesReadSinceHint += samples_from_reader;
 
     // Activate on this trigger if necessary
     if (reachedTrigger) {
@@ -152,6 +202,7 @@ SINT ReadAheadManager::getNextSamples(double dRate, CSAMPLE* pOutput,
             // Set the cache miss flag to decide when to apply ramping
             // after the following read attempts.
             m_cacheMissHappened = true;
+            onCacheMiss();
         }
 
         // do crossfade from the current buffer into the new loop beginning
@@ -164,6 +215,12 @@ SINT ReadAheadManager::getNextSamples(double dRate, CSAMPLE* pOutput,
     return samples_from_reader;
 }
 
+void ReadAheadManager::onCacheMiss() {
+    ++m_cacheMissCount;
+    Counter counter(kCacheMissCounter);
+    counter.increment();
+}
+
 void ReadAheadManager::addRateControl(RateControl* pRateControl) {
     m_pRateControl = pRateControl;
 }
@@ -185,34 +242,48 @@ void ReadAheadManager::notifySeek(double seekPosition) {
 
 void ReadAheadManager::hintReader(double dRate, HintVector* pHintList) {
     bool in_reverse = dRate < 0;
-    Hint current_position;
-
-    // SoundTouch can read up to 2 chunks ahead. Always keep 2 chunks ahead in
-    // cache.
-    SINT frameCountToCache = 2 * CachingReaderChunk::kFrames;
-    current_position.frameCount = frameCountToCache;
 
-    // this called after the precious chunk was consumed
-    if (in_reverse) {
-        current_position.frame =
-                static_cast<SINT>(ceil(m_currentPosition / kNumChannels)) -
-                frameCountToCache;
-    } else {
-        current_position.frame =
-                static_cast<SINT>(floor(m_currentPosition / kNumChannels));
-    }
-
-    // If we are trying to cache before the start of the track,
-    // Then we don't need to cache because it's all zeros!
-    if (current_position.frame < 0 &&
-            current_position.frame + current_position.frameCount < 0)
-    {
-    	return;
+    // The samples the scalers have read during the last callback. They
+    // follow the rate, the sample rate of the track and the read-ahead of
+    // the scaler.
+    const double samplesPerCallback = m_samplesReadSinceHint;
+    m_samplesReadSinceHint = 0;
+    const double samplesToHint = math_clamp(
+            kHintCallbacks * samplesPerCallback,
+            static_cast<double>(kMinHintFrames * kNumChannels),
+            static_cast<double>(kMaxHintFrames * kNumChannels));
+
+    double loopStart;
+    double loopEnd;
+    if (m_pLoopingControl &&
+            m_pLoopingControl->getActiveLoop(&loopStart, &loopEnd)) {
+        const double samplesToLoopTrigger = in_reverse ?
+                m_currentPosition - loopStart :
+                loopEnd - m_currentPosition;
+        if (samplesToLoopTrigger >= 0.0 &&
+                samplesToLoopTrigger < samplesToHint) {
+            // The loop will be taken within the hinted samples. Hint up to
+            // the loop trigger, and then from the other end of the loop
+            // including the samples before it that getNextSamples() reads for
+            // the crossfade. A loop that is shorter than the hinted samples
+            // is hinted as a whole.
+            appendHint(pHintList, m_currentPosition, samplesToLoopTrigger,
+                    in_reverse);
+            const double loopTarget = in_reverse ? loopEnd : loopStart;
+            const double crossfadeSamples = math_min(samplesPerCallback,
+                    static_cast<double>(MAX_BUFFER_LEN));
+            const double samplesInLoop = math_min(
+                    samplesToHint - samplesToLoopTrigger, loopEnd - loopStart);
+            appendHint(pHintList,
+                    in_reverse ?
+                            loopTarget + crossfadeSamples :
+                            loopTarget - crossfadeSamples,
+                    crossfadeSamples + samplesInLoop, in_reverse);
+            return;
+        }
     }
 
-    // top priority, we need to read this data immediately
-    current_position.priority = 1;
-    pHintList->append(current_position);
+    appendHint(pHintList, m_currentPosition, samplesToHint, in_reverse);
 }
 
 // Not thread-save, call from engine thread only
@@ -220,12 +291,18 @@ void ReadAheadManager::addReadLogEntry(double virtualPlaypositionStart,
                                        double virtualPlaypositionEndNonInclusive) {
     ReadLogEntry newEntry(virtualPlaypositionStart,
                           virtualPlaypositionEndNonInclusive);
-    if (m_readAheadLog.size() > 0) {
+    if (!m_readAheadLog.isEmpty()) {
         ReadLogEntry& last = m_readAheadLog.last();
         if (last.merge(newEntry)) {
             return;
         }
     }
+    if (m_readAheadLog.isFull()) {
+        // The playposition will jump over the oldest entry
+        m_readAheadLog.removeFirst();
+        Counter counter(kReadLogOverflowCounter);
+        counter.increment();
+    }
     m_readAheadLog.append(newEntry);
 }
 
@@ -237,7 +314,7 @@ double ReadAheadManager::getFilePlaypositionFromLog(
         return currentFilePlayposition;
     }
 
-    if (m_readAheadLog.size() == 0) {
+    if (m_readAheadLog.isEmpty()) {
         // No log entries to read from.
         qDebug() << this << "No read ahead log entries to read from. Case not currently handled.";
         // TODO(rryan) log through a stats pipe eventually
@@ -246,7 +323,7 @@ double ReadAheadManager::getFilePlaypositionFromLog(
 
     double filePlayposition = 0;
     bool shouldNotifySeek = false;
-    while (m_readAheadLog.size() > 0 && numConsumedSamples > 0) {
+    while (!m_readAheadLog.isEmpty() && numConsumedSamples > 0) {
         ReadLogEntry& entry = m_readAheadLog.first();
 
         // Notify EngineControls that we have taken a seek.
@@ -4,10 +4,10 @@
 #ifndef READAHEADMANGER_H
 #define READAHEADMANGER_H
 
-#include <QLinkedList>
 #include <QList>
 #include <QPair>
 
+#include "util/assert.h"
 #include "util/types.h"
 #include "util/math.h"
 #include "engine/cachingreader/cachingreader.h"
@@ -53,7 +53,10 @@ class ReadAheadManager {
     virtual void notifySeek(double seekPosition);
 
     // hintReader allows the ReadAheadManager to provide hints to the reader to
-    // indicate that the given portion of a song is about to be read.
+    // indicate that the given portion of a song is about to be read. It hints
+    // the samples for the next few callbacks at the rate the scalers have read
+    // in the last one, following the active loop back to the loop in point.
+    // Call it once per callback after processing.
     virtual void hintReader(double dRate, HintVector* hintList);
 
     virtual double getFilePlaypositionFromLog(double currentFilePlayposition,
@@ -63,6 +66,12 @@ class ReadAheadManager {
         m_pReader = pReader;
     }
 
+    // The number of reads that returned silence because the samples were not
+    // in the cache. They are also tracked by the stats counters.
+    int getCacheMissCount() const {
+        return m_cacheMissCount;
+    }
+
   private:
     // An entry in the read log indicates the virtual playposition the read
     // began at and the virtual playposition it ended at.
@@ -70,6 +79,11 @@ class ReadAheadManager {
         double virtualPlaypositionStart;
         double virtualPlaypositionEndNonInclusive;
 
+        ReadLogEntry()
+                : virtualPlaypositionStart(0),
+                  virtualPlaypositionEndNonInclusive(0) {
+        }
+
         ReadLogEntry(double virtualPlaypositionStart,
                      double virtualPlaypositionEndNonInclusive) {
             this->virtualPlaypositionStart = virtualPlaypositionStart;
@@ -114,18 +128,76 @@ class ReadAheadManager {
         }
     };
 
+    // A ring of ReadLogEntry's with a fixed capacity, so that logging a read
+    // never allocates memory in the engine thread. The log is consumed every
+    // callback, it only grows beyond a few entries with very short loops.
+    class ReadLog {
+      public:
+        ReadLog()
+                : m_first(0),
+                  m_size(0) {
+        }
+
+        bool isEmpty() const {
+            return m_size == 0;
+        }
+
+        bool isFull() const {
+            return m_size == kCapacity;
+        }
+
+        ReadLogEntry& first() {
+            DEBUG_ASSERT(!isEmpty());
+            return m_entries[m_first];
+        }
+
+        ReadLogEntry& last() {
+            DEBUG_ASSERT(!isEmpty());
+            return m_entries[(m_first + m_size - 1) % kCapacity];
+        }
+
+        void append(const ReadLogEntry& entry) {
+            DEBUG_ASSERT(!isFull());
+            m_entries[(m_first + m_size) % kCapacity] = entry;
+            ++m_size;
+        }
+
+        void removeFirst() {
+            DEBUG_ASSERT(!isEmpty());
+            m_first = (m_first + 1) % kCapacity;
+            --m_size;
+        }
+
+        void clear() {
+            m_first = 0;
+            m_size = 0;
+        }
+
+      private:
+        static constexpr int kCapacity = 1024;
+
+        ReadLogEntry m_entries[kCapacity];
+        int m_first;
+        int m_size;
+    };
+
     // virtualPlaypositionEnd is the first sample in the direction that was read
     // that was NOT read as part of this log entry. This is to simplify the
     void addReadLogEntry(double virtualPlaypositionStart,
                          double virtualPlaypositionEndNonInclusive);
 
+    void onCacheMiss();
+
     LoopingControl* m_pLoopingControl;
     RateControl* m_pRateControl;
-    QLinkedList<ReadLogEntry> m_readAheadLog;
+    ReadLog m_readAheadLog;
     double m_currentPosition;
     CachingReader* m_pReader;
     CSAMPLE* m_pCrossFadeBuffer;
     bool m_cacheMissHappened;
+    // The samples read since the last call of hintReader()
+    double m_samplesReadSinceHint;
+    int m_cacheMissCount;
 };
 
 #endif // READAHEADMANGER_H
@@ -25,20 +25,70 @@
 #include "engine/sidechain/enginesidechain.h"
 
 #include <QtDebug>
-#include <QMutexLocker>
 
+#include "control/controlobject.h"
 #include "engine/sidechain/sidechainworker.h"
 #include "util/counter.h"
 #include "util/event.h"
+#include "util/math.h"
 #include "util/sample.h"
+#include "util/time.h"
 #include "util/timer.h"
 #include "util/trace.h"
 
+namespace {
+
+const QString kGroup = "[Master]";
+
+const ConfigKey kBufferSizeConfigKey(kGroup, "SideChainBufferSize");
+
+const ConfigKey kSampleRateKey(kGroup, "samplerate");
+
+// The sidechain thread is woken up when the FIFO contains at least
+// this many samples, independent of the configured FIFO size. Any
+// additional capacity is reserved for bridging stalls of the workers.
+const int kWakeupThreshold = EngineSideChain::SIDECHAIN_BUFFER_SIZE * 4 / 5;
+
+// TODO: remove assumption of stereo buffer
+const int kChannels = 2;
+
+int fifoSize(const UserSettingsPointer& pConfig) {
+    const int configuredSize = pConfig->getValue(
+            kBufferSizeConfigKey, EngineSideChain::SIDECHAIN_BUFFER_SIZE);
+    // The FIFO rounds up to the next power of 2
+    return roundUpToPowerOf2(math_max(
+            configuredSize, EngineSideChain::SIDECHAIN_BUFFER_SIZE));
+}
+
+} // anonymous namespace
+
 EngineSideChain::EngineSideChain(UserSettingsPointer pConfig)
         : m_pConfig(pConfig),
           m_bStopThread(false),
-          m_sampleFifo(SIDECHAIN_BUFFER_SIZE),
-          m_pWorkBuffer(SampleUtil::alloc(SIDECHAIN_BUFFER_SIZE)) {
+          m_sampleFifoSize(fifoSize(pConfig)),
+          m_sampleFifo(m_sampleFifoSize),
+          m_pWorkBuffer(SampleUtil::alloc(SIDECHAIN_BUFFER_SIZE)),
+          m_wakeupTimeNanos(0),
+          m_wakeupReadAvailable(0),
+          m_overflowCount(0),
+          m_droppedFrames(0),
+          m_underflowCount(0) {
+    m_wakeupPending.clear();
+
+    m_pBufferSize = new ControlObject(
+            ConfigKey(kGroup, "sidechain_buffer_size"), true, true);
+    m_pBufferSize->setReadOnly();
+    m_pBufferSize->forceSet(m_sampleFifoSize / kChannels);
+    m_pOverflowCount = new ControlObject(
+            ConfigKey(kGroup, "sidechain_overflow_count"), true, true);
+    m_pOverflowCount->setReadOnly();
+    m_pDroppedFrames = new ControlObject(
+            ConfigKey(kGroup, "sidechain_dropped_frames"), true, true);
+    m_pDroppedFrames->setReadOnly();
+    m_pUnderflowCount = new ControlObject(
+            ConfigKey(kGroup, "sidechain_underflow_count"), true, true);
+    m_pUnderflowCount->setReadOnly();
+
     // We use HighPriority to prevent starvation by lower-priority processes (Qt
     // main thread, analysis, etc.). This used to be LowPriority but that is not
     // a suitable choice since we do semi-realtime tasks
@@ -49,10 +99,8 @@ EngineSideChain::EngineSideChain(UserSettingsPointer pConfig)
 }
 
 EngineSideChain::~EngineSideChain() {
-    m_waitLock.lock();
     m_bStopThread = true;
-    m_waitForSamples.wakeAll();
-    m_waitLock.unlock();
+    m_samplesAvailable.release();
 
     // Wait until the thread has finished.
     wait();
@@ -66,6 +114,11 @@ EngineSideChain::~EngineSideChain() {
     locker.unlock();
 
     SampleUtil::free(m_pWorkBuffer);
+
+    delete m_pUnderflowCount;
+    delete m_pDroppedFrames;
+    delete m_pOverflowCount;
+    delete m_pBufferSize;
 }
 
 void EngineSideChain::addSideChainWorker(SideChainWorker* pWorker) {
@@ -85,22 +138,52 @@ void EngineSideChain::receiveBuffer(AudioInput input,
 
 void EngineSideChain::writeSamples(const CSAMPLE* pBuffer, int iFrames) {
     Trace sidechain("EngineSideChain::writeSamples");
-    // TODO: remove assumption of stereo buffer
-    const int kChannels = 2;
     const int iSamples = iFrames * kChannels;
     int samples_written = m_sampleFifo.write(pBuffer, iSamples);
 
     if (samples_written != iSamples) {
         Counter("EngineSideChain::writeSamples buffer overrun").increment();
+        m_overflowCount.fetch_add(1, std::memory_order_relaxed);
+        m_droppedFrames.fetch_add(
+                (iSamples - samples_written) / kChannels,
+                std::memory_order_relaxed);
     }
 
-    if (m_sampleFifo.writeAvailable() < SIDECHAIN_BUFFER_SIZE / 5) {
+    const int readAvailable = m_sampleFifo.readAvailable();
+    if (readAvailable >= kWakeupThreshold &&
+            !m_wakeupPending.test_and_set(std::memory_order_acquire)) {
         // Signal to the sidechain that samples are available.
         Trace wakeup("EngineSideChain::writeSamples wake up");
-        m_waitForSamples.wakeAll();
+        m_wakeupTimeNanos.store(
+                mixxx::Time::elapsed().toIntegerNanos(),
+                std::memory_order_relaxed);
+        m_wakeupReadAvailable.store(readAvailable, std::memory_order_relaxed);
+        m_samplesAvailable.release();
     }
 }
 
+void EngineSideChain::updateControls() {
+    m_pOverflowCount->forceSet(
+            m_overflowCount.load(std::memory_order_relaxed));
+    m_pDroppedFrames->forceSet(
+            m_droppedFrames.load(std::memory_order_relaxed));
+    m_pUnderflowCount->forceSet(m_underflowCount);
+}
+
+bool EngineSideChain::missedReadDeadline() const {
+    const double sampleRate = ControlObject::get(kSampleRateKey);
+    if (sampleRate <= 0) {
+        return false;
+    }
+    // The engine fills up the remaining capacity of the FIFO in real-time
+    const int headroomFrames = (m_sampleFifoSize -
+            m_wakeupReadAvailable.load(std::memory_order_relaxed)) / kChannels;
+    const auto deadline = mixxx::Duration::fromNanos(
+            m_wakeupTimeNanos.load(std::memory_order_relaxed)) +
+            mixxx::Duration::fromSeconds(headroomFrames / sampleRate);
+    return mixxx::Time::elapsed() > deadline;
+}
+
 void EngineSideChain::run() {
     // the id of this thread, for debugging purposes //XXX copypasta (should
     // factor this out somehow), -kousu 2/2009
@@ -110,12 +193,21 @@ void EngineSideChain::run() {
     Event::start("EngineSideChain");
     while (!m_bStopThread) {
         // Sleep until samples are available.
-        m_waitLock.lock();
-
         Event::end("EngineSideChain");
-        m_waitForSamples.wait(&m_waitLock);
-        m_waitLock.unlock();
+        m_samplesAvailable.acquire();
         Event::start("EngineSideChain");
+        // Re-arm the wakeup before draining the FIFO to not miss any
+        // samples that are written in the meantime.
+        m_wakeupPending.clear(std::memory_order_release);
+
+        if (m_bStopThread) {
+            return;
+        }
+
+        if (missedReadDeadline()) {
+            Counter("EngineSideChain::run missed read deadline").increment();
+            ++m_underflowCount;
+        }
 
         int samples_read;
         while ((samples_read = m_sampleFifo.read(m_pWorkBuffer,
@@ -126,6 +218,7 @@ void EngineSideChain::run() {
                 pWorker->process(m_pWorkBuffer, samples_read);
             }
         }
+        updateControls();
 
         // Check to see if we're supposed to exit/stop this thread.
         if (m_bStopThread) {
@@ -17,18 +17,21 @@
 #ifndef ENGINESIDECHAIN_H
 #define ENGINESIDECHAIN_H
 
+#include <atomic>
+
 #include <QThread>
-#include <QMutex>
-#include <QWaitCondition>
 #include <QList>
 
 #include "preferences/usersettings.h"
 #include "engine/sidechain/sidechainworker.h"
 #include "soundio/soundmanagerutil.h"
 #include "util/fifo.h"
+#include "util/lightweightsemaphore.h"
 #include "util/mutex.h"
 #include "util/types.h"
 
+class ControlObject;
+
 class EngineSideChain : public QThread, public AudioDestination {
     Q_OBJECT
   public:
@@ -49,22 +52,52 @@ class EngineSideChain : public QThread, public AudioDestination {
     // Thread-safe, blocking.
     void addSideChainWorker(SideChainWorker* pWorker);
 
+    // The maximum number of samples that are passed to the workers
+    // at once. Also the default and minimum size of the FIFO.
     static const int SIDECHAIN_BUFFER_SIZE = 65536;
 
   private:
     void run() override;
+    void updateControls();
+    // Whether the sidechain thread has started to drain the FIFO too late
+    // after it has been woken up
+    bool missedReadDeadline() const;
 
     UserSettingsPointer m_pConfig;
     // Indicates that the thread should exit.
-    volatile bool m_bStopThread;
+    std::atomic<bool> m_bStopThread;
 
+    // Configurable with [Master],SideChainBufferSize to bridge longer
+    // stalls of slow encoders or network connections.
+    const int m_sampleFifoSize;
     FIFO<CSAMPLE> m_sampleFifo;
     CSAMPLE* m_pWorkBuffer;
 
-    // Provides thread safety around the wait condition below.
-    QMutex m_waitLock;
-    // Allows sleeping until we have samples to process.
-    QWaitCondition m_waitForSamples;
+    // Allows sleeping until we have samples to process. Signaled from
+    // the engine callback without taking any lock.
+    mixxx::LightweightSemaphore m_samplesAvailable;
+    // Prevents signaling the semaphore repeatedly until the sidechain
+    // thread has woken up.
+    std::atomic_flag m_wakeupPending;
+
+    // When and at which fill level of the FIFO the engine callback has
+    // woken up the sidechain thread. The thread must drain the FIFO
+    // before the remaining capacity has been filled up.
+    std::atomic<qint64> m_wakeupTimeNanos;
+    std::atomic<int> m_wakeupReadAvailable;
+
+    // Written by the engine callback, published as controls by the
+    // sidechain thread.
+    std::atomic<int> m_overflowCount;
+    std::atomic<int> m_droppedFrames;
+    // Counts the wakeups that missed their deadline, i.e. the workers
+    // have been starved although the engine kept producing samples.
+    int m_underflowCount;
+
+    ControlObject* m_pBufferSize;
+    ControlObject* m_pOverflowCount;
+    ControlObject* m_pDroppedFrames;
+    ControlObject* m_pUnderflowCount;
 
     // Sidechain workers registered with EngineSideChain.
     MMutex m_workerLock;
@@ -48,6 +48,7 @@ AnalysisFeature::AnalysisFeature(
         m_library(parent),
         m_pConfig(pConfig),
         m_pTrackAnalysisScheduler(TrackAnalysisScheduler::NullPointer()),
+        m_preemptedThreadsCount(0),
         m_analysisTitleName(tr("Analyze")),
         m_pAnalysisView(nullptr),
         m_icon(":/images/library/ic_library_prepare.svg") {
@@ -144,6 +145,10 @@ void AnalysisFeature::analyzeTracks(QList<TrackId> trackIds) {
                 this, &AnalysisFeature::onTrackAnalysisSchedulerProgress);
         connect(m_pTrackAnalysisScheduler.get(), &TrackAnalysisScheduler::finished,
                 this, &AnalysisFeature::stopAnalysis);
+        connect(m_pTrackAnalysisScheduler.get(), &TrackAnalysisScheduler::throughput,
+                m_pAnalysisView, &DlgAnalysis::onTrackAnalysisSchedulerThroughput);
+        // Loaded tracks might already be analyzed
+        m_pTrackAnalysisScheduler->preempt(m_preemptedThreadsCount);
 
         emit(analysisActive(true));
     }
@@ -182,6 +187,13 @@ void AnalysisFeature::resumeAnalysis() {
     }
 }
 
+void AnalysisFeature::preemptAnalysis(int threadsCount) {
+    m_preemptedThreadsCount = threadsCount;
+    if (m_pTrackAnalysisScheduler) {
+        m_pTrackAnalysisScheduler->preempt(threadsCount);
+    }
+}
+
 void AnalysisFeature::stopAnalysis() {
     //qDebug() << this << "stopAnalysis()";
     if (m_pTrackAnalysisScheduler) {
@@ -50,6 +50,9 @@ class AnalysisFeature : public LibraryFeature {
 
     void suspendAnalysis();
     void resumeAnalysis();
+    // Pauses the given number of batch analysis threads in favor of
+    // the analysis of loaded tracks.
+    void preemptAnalysis(int threadsCount);
 
   private slots:
     void onTrackAnalysisSchedulerProgress(AnalyzerProgress currentTrackProgress, int currentTrackNumber, int totalTracksCount);
@@ -69,6 +72,7 @@ class AnalysisFeature : public LibraryFeature {
 
     UserSettingsPointer m_pConfig;
     TrackAnalysisScheduler::Pointer m_pTrackAnalysisScheduler;
+    int m_preemptedThreadsCount;
 
     // The title returned by title()
     QVariant m_Title;
@@ -0,0 +1,289 @@
+#include "library/autodj/autodjcandidateset.h"
+
+#include <algorithm>
+
+#include "util/assert.h"
+
+AutoDJCandidateSet::AutoDJCandidateSet(Order order)
+        : m_order(order),
+          m_availableUnplayedCount(0),
+          m_root(-1),
+          m_random(std::random_device()()) {
+}
+
+void AutoDJCandidateSet::setOrder(Order order) {
+    if (m_order == order) {
+        return;
+    }
+    m_order = order;
+    m_availableUnplayedCount = 0;
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_root = -1;
+    for (auto i = m_candidates.begin(); i != m_candidates.end(); ++i) {
+        i.value().node = -1;
+        if (isAvailable(i.value().candidate)) {
+            insertNode(i.key(), &i.value());
+        }
+    }
+}
+
+void AutoDJCandidateSet::clear() {
+    m_candidates.clear();
+    m_availableUnplayedCount = 0;
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_root = -1;
+}
+
+const AutoDJCandidateSet::Candidate* AutoDJCandidateSet::find(
+        TrackId trackId) const {
+    const auto i = m_candidates.constFind(trackId);
+    if (i == m_candidates.constEnd()) {
+        return nullptr;
+    }
+    return &i.value().candidate;
+}
+
+bool AutoDJCandidateSet::addCrateRef(TrackId trackId, int timesPlayed) {
+    auto i = m_candidates.find(trackId);
+    if (i != m_candidates.end()) {
+        ++i.value().candidate.crateRefs;
+        return false;
+    }
+    i = m_candidates.insert(trackId, Entry());
+    i.value().candidate.crateRefs = 1;
+    i.value().candidate.timesPlayed = timesPlayed;
+    insertNode(trackId, &i.value());
+    return true;
+}
+
+void AutoDJCandidateSet::removeCrateRef(TrackId trackId) {
+    auto i = m_candidates.find(trackId);
+    if (i == m_candidates.end()) {
+        return;
+    }
+    if (--i.value().candidate.crateRefs > 0) {
+        return;
+    }
+    removeNode(&i.value());
+    m_candidates.erase(i);
+}
+
+void AutoDJCandidateSet::addAutoDjRef(TrackId trackId) {
+    const Candidate* pCandidate = find(trackId);
+    if (pCandidate) {
+        setAutoDjRefs(trackId, pCandidate->autoDjRefs + 1);
+    }
+}
+
+void AutoDJCandidateSet::removeAutoDjRef(TrackId trackId) {
+    const Candidate* pCandidate = find(trackId);
+    if (pCandidate) {
+        setAutoDjRefs(trackId, pCandidate->autoDjRefs - 1);
+    }
+}
+
+void AutoDJCandidateSet::setAutoDjRefs(TrackId trackId, int autoDjRefs) {
+    auto i = m_candidates.find(trackId);
+    if (i == m_candidates.end()) {
+        return;
+    }
+    removeNode(&i.value());
+    i.value().candidate.autoDjRefs = autoDjRefs;
+    updateNode(trackId, &i.value());
+}
+
+void AutoDJCandidateSet::setTimesPlayed(TrackId trackId, int timesPlayed) {
+    auto i = m_candidates.find(trackId);
+    if (i == m_candidates.end() ||
+            i.value().candidate.timesPlayed == timesPlayed) {
+        return;
+    }
+    removeNode(&i.value());
+    i.value().candidate.timesPlayed = timesPlayed;
+    updateNode(trackId, &i.value());
+}
+
+void AutoDJCandidateSet::setLastPlayed(TrackId trackId, const QString& lastPlayed) {
+    auto i = m_candidates.find(trackId);
+    if (i == m_candidates.end() ||
+            i.value().candidate.lastPlayed == lastPlayed) {
+        return;
+    }
+    removeNode(&i.value());
+    i.value().candidate.lastPlayed = lastPlayed;
+    updateNode(trackId, &i.value());
+}
+
+int AutoDJCandidateSet::availableCount() const {
+    return nodeSize(m_root);
+}
+
+int AutoDJCandidateSet::availableLastPlayedBefore(const QString& lastPlayed) const {
+    VERIFY_OR_DEBUG_ASSERT(m_order == Order::LastPlayed) {
+        return 0;
+    }
+    int count = 0;
+    int node = m_root;
+    while (node >= 0) {
+        const Node& n = m_nodes[node];
+        if (n.lastPlayed < lastPlayed) {
+            count += nodeSize(n.left) + 1;
+            node = n.right;
+        } else {
+            node = n.left;
+        }
+    }
+    return count;
+}
+
+TrackId AutoDJCandidateSet::availableAt(int rank) const {
+    VERIFY_OR_DEBUG_ASSERT(rank >= 0 && rank < availableCount()) {
+        return TrackId();
+    }
+    int node = m_root;
+    while (node >= 0) {
+        const Node& n = m_nodes[node];
+        const int leftSize = nodeSize(n.left);
+        if (rank < leftSize) {
+            node = n.left;
+        } else if (rank == leftSize) {
+            return n.trackId;
+        } else {
+            rank -= leftSize + 1;
+            node = n.right;
+        }
+    }
+    DEBUG_ASSERT(!"unreachable");
+    return TrackId();
+}
+
+TrackId AutoDJCandidateSet::pickAvailable(int activeCount) {
+    activeCount = std::min(activeCount, availableCount());
+    if (activeCount <= 0) {
+        return TrackId();
+    }
+    std::uniform_int_distribution<int> distribution(0, activeCount - 1);
+    return availableAt(distribution(m_random));
+}
+
+void AutoDJCandidateSet::updateNode(TrackId trackId, Entry* pEntry) {
+    const Candidate& candidate = pEntry->candidate;
+    if (isAvailable(candidate)) {
+        insertNode(trackId, pEntry);
+    }
+}
+
+void AutoDJCandidateSet::insertNode(TrackId trackId, Entry* pEntry) {
+    DEBUG_ASSERT(pEntry->node < 0);
+    const Candidate& candidate = pEntry->candidate;
+    int node;
+    if (m_freeNodes.empty()) {
+        node = static_cast<int>(m_nodes.size());
+        m_nodes.emplace_back();
+    } else {
+        node = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    }
+    Node& n = m_nodes[node];
+    n.trackId = trackId;
+    n.timesPlayed = candidate.timesPlayed;
+    n.lastPlayed = candidate.lastPlayed;
+    n.priority = static_cast<quint32>(m_random());
+    n.left = -1;
+    n.right = -1;
+    n.size = 1;
+    int left;
+    int right;
+    split(m_root, n, &left, &right);
+    m_root = merge(merge(left, node), right);
+    pEntry->node = node;
+    if (candidate.timesPlayed == 0) {
+        ++m_availableUnplayedCount;
+    }
+}
+
+void AutoDJCandidateSet::removeNode(Entry* pEntry) {
+    const int node = pEntry->node;
+    if (node < 0) {
+        return;
+    }
+    int left;
+    int right;
+    split(m_root, m_nodes[node], &left, &right);
+    int first;
+    int rest;
+    splitAt(right, 1, &first, &rest);
+    DEBUG_ASSERT(first == node);
+    m_root = merge(left, rest);
+    m_nodes[node].lastPlayed.clear();
+    m_freeNodes.push_back(node);
+    pEntry->node = -1;
+    if (pEntry->candidate.timesPlayed == 0) {
+        --m_availableUnplayedCount;
+    }
+}
+
+bool AutoDJCandidateSet::lessThan(const Node& lhs, const Node& rhs) const {
+    if (m_order == Order::TimesPlayedThenLastPlayed &&
+            lhs.timesPlayed != rhs.timesPlayed) {
+        return lhs.timesPlayed < rhs.timesPlayed;
+    }
+    if (lhs.lastPlayed != rhs.lastPlayed) {
+        return lhs.lastPlayed < rhs.lastPlayed;
+    }
+    // Unique and stable among equal candidates
+    return lhs.trackId < rhs.trackId;
+}
+
+int AutoDJCandidateSet::merge(int left, int right) {
+    if (left < 0) {
+        return right;
+    }
+    if (right < 0) {
+        return left;
+    }
+    if (m_nodes[left].priority > m_nodes[right].priority) {
+        m_nodes[left].right = merge(m_nodes[left].right, right);
+        updateSize(left);
+        return left;
+    } else {
+        m_nodes[right].left = merge(left, m_nodes[right].left);
+        updateSize(right);
+        return right;
+    }
+}
+
+void AutoDJCandidateSet::split(int node, const Node& key, int* pLeft, int* pRight) {
+    if (node < 0) {
+        *pLeft = -1;
+        *pRight = -1;
+        return;
+    }
+    if (lessThan(m_nodes[node], key)) {
+        split(m_nodes[node].right, key, &m_nodes[node].right, pRight);
+        *pLeft = node;
+    } else {
+        split(m_nodes[node].left, key, pLeft, &m_nodes[node].left);
+        *pRight = node;
+    }
+    updateSize(node);
+}
+
+void AutoDJCandidateSet::splitAt(int node, int count, int* pLeft, int* pRight) {
+    if (node < 0) {
+        *pLeft = -1;
+        *pRight = -1;
+        return;
+    }
+    const int leftSize = nodeSize(m_nodes[node].left);
+    if (count <= leftSize) {
+        splitAt(m_nodes[node].left, count, pLeft, &m_nodes[node].left);
+        *pRight = node;
+    } else {
+        splitAt(m_nodes[node].right, count - leftSize - 1, &m_nodes[node].right, pRight);
+        *pLeft = node;
+    }
+    updateSize(node);
+}
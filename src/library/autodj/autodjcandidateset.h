@@ -0,0 +1,156 @@
+#ifndef AUTODJCANDIDATESET_H
+#define AUTODJCANDIDATESET_H
+
+#include <random>
+#include <vector>
+
+#include <QHash>
+#include <QString>
+
+#include "track/trackid.h"
+
+// The tracks of the Auto DJ crates that Auto DJ randomly picks from,
+// kept in memory and updated incrementally.
+//
+// A candidate is available unless it is referenced by the Auto DJ
+// playlist or loaded into a deck. The available candidates are ordered
+// by the number of times they have been played and the date/time they
+// have last been played, optionally only by the latter. Auto DJ prefers
+// the first, i.e. least played, of them.
+//
+// The available candidates are stored in a treap with subtree sizes,
+// so that counting and picking them by rank takes O(log n).
+class AutoDJCandidateSet final {
+  public:
+    enum class Order {
+        TimesPlayedThenLastPlayed,
+        LastPlayed,
+    };
+
+    struct Candidate {
+        Candidate()
+                : crateRefs(0),
+                  autoDjRefs(0),
+                  timesPlayed(0) {
+        }
+        // The number of Auto DJ crates that contain the track
+        int crateRefs;
+        // The number of references in the Auto DJ playlist and decks
+        int autoDjRefs;
+        int timesPlayed;
+        // In the format of SQLite, empty if never played
+        QString lastPlayed;
+    };
+
+    explicit AutoDJCandidateSet(Order order = Order::TimesPlayedThenLastPlayed);
+
+    Order order() const {
+        return m_order;
+    }
+    // Reorders all available candidates
+    void setOrder(Order order);
+
+    void clear();
+
+    int size() const {
+        return m_candidates.size();
+    }
+    bool contains(TrackId trackId) const {
+        return m_candidates.contains(trackId);
+    }
+    // Returns nullptr if the track is not a candidate
+    const Candidate* find(TrackId trackId) const;
+    QList<TrackId> trackIds() const {
+        return m_candidates.keys();
+    }
+
+    // Adds a reference from an Auto DJ crate. Returns true if the track
+    // has not been a candidate before.
+    bool addCrateRef(TrackId trackId, int timesPlayed);
+    // Removes a reference from an Auto DJ crate and the candidate itself
+    // if no references are left.
+    void removeCrateRef(TrackId trackId);
+
+    void addAutoDjRef(TrackId trackId);
+    void removeAutoDjRef(TrackId trackId);
+    void setAutoDjRefs(TrackId trackId, int autoDjRefs);
+    void setTimesPlayed(TrackId trackId, int timesPlayed);
+    void setLastPlayed(TrackId trackId, const QString& lastPlayed);
+
+    // The candidates that are available for picking
+    int availableCount() const;
+    // The available candidates that have never been played
+    int availableUnplayedCount() const {
+        return m_availableUnplayedCount;
+    }
+    // The available candidates that have last been played before the
+    // given date/time. Requires Order::LastPlayed.
+    int availableLastPlayedBefore(const QString& lastPlayed) const;
+    // The candidates that are not available
+    int queuedCount() const {
+        return size() - availableCount();
+    }
+
+    // Returns the available candidate with the given rank in order
+    TrackId availableAt(int rank) const;
+    // Picks one of the first activeCount available candidates with equal
+    // probability. Returns an invalid id if there are none.
+    TrackId pickAvailable(int activeCount);
+
+  private:
+    struct Node {
+        TrackId trackId;
+        int timesPlayed;
+        QString lastPlayed;
+        quint32 priority;
+        int left;
+        int right;
+        // The number of nodes in this subtree
+        int size;
+    };
+
+    struct Entry {
+        Entry()
+                : node(-1) {
+        }
+        Candidate candidate;
+        // The node of an available candidate, -1 otherwise
+        int node;
+    };
+
+    static bool isAvailable(const Candidate& candidate) {
+        return candidate.autoDjRefs <= 0;
+    }
+
+    // Inserts or removes the node of an entry after its candidate has
+    // been modified
+    void updateNode(TrackId trackId, Entry* pEntry);
+    void insertNode(TrackId trackId, Entry* pEntry);
+    void removeNode(Entry* pEntry);
+
+    bool lessThan(const Node& lhs, const Node& rhs) const;
+    int nodeSize(int node) const {
+        return node < 0 ? 0 : m_nodes[node].size;
+    }
+    void updateSize(int node) {
+        Node& n = m_nodes[node];
+        n.size = 1 + nodeSize(n.left) + nodeSize(n.right);
+    }
+    int merge(int left, int right);
+    // Splits into the nodes that are less than the key and the others
+    void split(int node, const Node& key, int* pLeft, int* pRight);
+    // Splits off the given number of first nodes
+    void splitAt(int node, int count, int* pLeft, int* pRight);
+
+    Order m_order;
+    QHash<TrackId, Entry> m_candidates;
+    int m_availableUnplayedCount;
+
+    std::vector<Node> m_nodes;
+    std::vector<int> m_freeNodes;
+    int m_root;
+
+    std::mt19937 m_random;
+};
+
+#endif // AUTODJCANDIDATESET_H
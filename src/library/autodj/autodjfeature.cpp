@@ -157,8 +157,9 @@ bool AutoDJFeature::dropAccept(QList<QUrl> urls, QObject* pSource) {
         }
     }
 
-    // Return whether the tracks were appended.
-    return m_playlistDao.appendTracksToPlaylist(trackIds, m_iAutoDJPlaylistId);
+    // The tracks are appended by the writer thread
+    m_playlistDao.appendTracksToPlaylistAsync(trackIds, m_iAutoDJPlaylistId);
+    return true;
 }
 
 bool AutoDJFeature::dragMoveAccept(QUrl url) {
@@ -42,7 +42,8 @@ BaseSqlTableModel::BaseSqlTableModel(QObject* pParent,
           m_database(pTrackCollection->database()),
           m_previewDeckGroup(PlayerManager::groupForPreviewDeck(0)),
           m_bInitialized(false),
-          m_currentSearch("") {
+          m_currentSearch(""),
+          m_selectTimer("BaseSqlTableModel::selectAsync") {
     DEBUG_ASSERT(m_pTrackCollection);
     connect(&PlayerInfo::instance(), SIGNAL(trackLoaded(QString, TrackPointer)),
             this, SLOT(trackLoaded(QString, TrackPointer)));
@@ -53,6 +54,7 @@ BaseSqlTableModel::BaseSqlTableModel(QObject* pParent,
 }
 
 BaseSqlTableModel::~BaseSqlTableModel() {
+    cancelSelect();
 }
 
 void BaseSqlTableModel::initHeaderData() {
@@ -272,12 +274,25 @@ void BaseSqlTableModel::select() {
         qDebug() << this << "select()";
     }
 
+    // Replaces the rows of a pending selectAsync()
+    const bool selectAsyncPending = isSelecting();
+    cancelSelect();
+
+    selectRows();
+
+    if (selectAsyncPending) {
+        // Receivers might still wait for the rows of the cancelled
+        // selectAsync()
+        emit(selectFinished());
+    }
+}
+
+void BaseSqlTableModel::selectRows() {
     PerformanceTimer time;
     time.start();
 
     // Prepare query for id and all columns not in m_trackSource
-    QString queryString = QString("SELECT %1 FROM %2 %3")
-            .arg(m_tableColumns.join(","), m_tableName, m_tableOrderBy);
+    QString queryString = selectQueryString();
 
     if (sDebug) {
         qDebug() << this << "select() executing:" << queryString;
@@ -349,7 +364,146 @@ void BaseSqlTableModel::select() {
                                      m_sortColumns,
                                      m_tableColumns.size() - 1, // exclude the 1st column with the id
                                      &m_trackSortOrder);
+    }
+
+    replaceSelectedRows(std::move(rowInfos));
+
+    qDebug() << this << "select() took" << time.elapsed().debugMillisWithUnit()
+             << m_rowInfo.size();
+}
+
+void BaseSqlTableModel::selectAsync() {
+    if (!m_bInitialized) {
+        return;
+    }
+    const mixxx::DbConnectionPoolPtr pDbConnectionPool =
+            m_pTrackCollection->dbConnectionPool();
+    if (!pDbConnectionPool) {
+        select();
+        return;
+    }
 
+    if (sDebug) {
+        qDebug() << this << "selectAsync()";
+    }
+
+    // Superseded, e.g. while the user is still typing
+    cancelSelect();
+    m_selectTimer.start();
+
+    BaseSqlTableSelectTask::Query query;
+    QStringList tableNames;
+    tableNames << m_tableName;
+    query.queryString = selectQueryString();
+    query.idColumn = m_idColumn;
+    query.columnCount = m_tableColumns.size();
+    if (m_trackSource) {
+        query.filterAndSort = true;
+        query.filterAndSortQuery = m_trackSource->prepareFilterAndSort(
+                m_currentSearch,
+                m_currentSearchFilter,
+                m_trackSourceOrderBy);
+        tableNames << query.filterAndSortQuery.tableName;
+    }
+    query.temporaryViews = BaseSqlTableSelectTask::temporaryViewDefinitions(
+            m_database, tableNames);
+
+    m_pSelectTask = BaseSqlTableSelectTask::create(
+            pDbConnectionPool, std::move(query));
+    connect(m_pSelectTask.data(), SIGNAL(firstPageSelected()),
+            this, SLOT(slotFirstPageSelected()));
+    connect(m_pSelectTask.data(), SIGNAL(finished()),
+            this, SLOT(slotSelectFinished()));
+    BaseSqlTableSelectTask::start(m_pSelectTask);
+}
+
+void BaseSqlTableModel::cancelSelect() {
+    if (m_pSelectTask) {
+        m_pSelectTask->disconnect(this);
+        m_pSelectTask->cancel();
+        m_pSelectTask.clear();
+    }
+}
+
+void BaseSqlTableModel::slotFirstPageSelected() {
+    if (sender() != m_pSelectTask.data()) {
+        return;
+    }
+    QVector<RowInfo> rowInfos = toRowInfos(m_pSelectTask->takeFirstPage());
+    TrackId2Rows trackIdToRows;
+    for (int i = 0; i < rowInfos.size(); ++i) {
+        trackIdToRows[rowInfos[i].trackId].push_back(i);
+    }
+    clearRows();
+    replaceRows(
+            std::move(rowInfos),
+            std::move(trackIdToRows));
+}
+
+void BaseSqlTableModel::slotSelectFinished() {
+    if (sender() != m_pSelectTask.data()) {
+        return;
+    }
+    BaseSqlTableSelectTask::Result result = m_pSelectTask->takeResult();
+    m_pSelectTask.clear();
+
+    if (!result.succeeded) {
+        // Temporary views might depend on other temporary views
+        qWarning() << this << "selectAsync() failed, selecting synchronously";
+        select();
+        emit(selectFinished());
+        return;
+    }
+
+    QVector<RowInfo> rowInfos = toRowInfos(std::move(result.rows));
+    if (m_trackSource && !result.trackIds.isEmpty()) {
+        m_trackSource->finishFilterAndSort(result.trackIds,
+                                           std::move(result.sortedTrackIds),
+                                           m_currentSearch,
+                                           m_sortColumns,
+                                           m_tableColumns.size() - 1, // exclude the 1st column with the id
+                                           &m_trackSortOrder);
+    }
+
+    clearRows();
+    replaceSelectedRows(std::move(rowInfos));
+
+    qDebug() << this << "selectAsync() took"
+             << m_selectTimer.elapsed(true).debugMillisWithUnit()
+             << "with queries taking"
+             << result.queryDuration.debugMillisWithUnit()
+             << m_rowInfo.size();
+    emit(selectFinished());
+}
+
+QString BaseSqlTableModel::selectQueryString() const {
+    const QString filter = tableFilter();
+    if (filter.isEmpty()) {
+        return QString("SELECT %1 FROM %2 %3")
+                .arg(m_tableColumns.join(","), m_tableName, m_tableOrderBy);
+    }
+    return QString("SELECT %1 FROM %2 WHERE %3 %4")
+            .arg(m_tableColumns.join(","), m_tableName, filter, m_tableOrderBy);
+}
+
+// static
+QVector<BaseSqlTableModel::RowInfo> BaseSqlTableModel::toRowInfos(
+        QVector<BaseSqlTableSelectTask::Row> rows) {
+    QVector<RowInfo> rowInfos;
+    rowInfos.reserve(rows.size());
+    for (auto& row : rows) {
+        RowInfo rowInfo;
+        rowInfo.trackId = row.trackId;
+        // current position defines the ordering
+        rowInfo.order = rowInfos.size();
+        rowInfo.metadata = std::move(row.metadata);
+        rowInfos.push_back(std::move(rowInfo));
+    }
+    return rowInfos;
+}
+
+void BaseSqlTableModel::replaceSelectedRows(QVector<RowInfo>&& rowInfos) {
+    if (m_trackSource) {
         // Re-sort the track IDs since filterAndSort can change their order or mark
         // them for removal (by setting their row to -1).
         for (auto& rowInfo: rowInfos) {
@@ -395,9 +549,6 @@ void BaseSqlTableModel::select() {
             std::move(trackIdToRows));
     // Both rowInfo and trackIdToRows (might) have been moved and
     // must not be used afterwards!
-
-    qDebug() << this << "select() took" << time.elapsed().debugMillisWithUnit()
-             << m_rowInfo.size();
 }
 
 void BaseSqlTableModel::setTable(const QString& tableName,
@@ -477,7 +628,7 @@ void BaseSqlTableModel::search(const QString& searchText, const QString& extraFi
         qDebug() << this << "search" << searchText;
     }
     setSearch(searchText, extraFilter);
-    select();
+    selectAsync();
 }
 
 void BaseSqlTableModel::setSort(int column, Qt::SortOrder order) {
@@ -623,7 +774,7 @@ void BaseSqlTableModel::sort(int column, Qt::SortOrder order) {
         qDebug() << this << "sort()" << column << order;
     }
     setSort(column, order);
-    select();
+    selectAsync();
 }
 
 int BaseSqlTableModel::rowCount(const QModelIndex& parent) const {
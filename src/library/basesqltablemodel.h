@@ -3,14 +3,17 @@
 #define BASESQLTABLEMODEL_H
 
 #include <QHash>
+#include <QSharedPointer>
 #include <QtSql>
 
+#include "library/basesqltableselecttask.h"
 #include "library/basetrackcache.h"
 #include "library/dao/trackdao.h"
 #include "library/trackcollection.h"
 #include "library/trackmodel.h"
 #include "library/columncache.h"
 #include "util/class.h"
+#include "util/timer.h"
 
 // BaseSqlTableModel is a custom-written SQL-backed table which aggressively
 // caches the contents of the table and supports lightweight updates.
@@ -84,8 +87,24 @@ class BaseSqlTableModel : public QAbstractTableModel, public TrackModel {
     ///////////////////////////////////////////////////////////////////////////
     bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
 
+    // Returns true while the rows are replaced by selectAsync()
+    bool isSelecting() const {
+        return !m_pSelectTask.isNull();
+    }
+
   public slots:
+    // Replaces all rows synchronously, e.g. when the caller needs to access
+    // the new rows immediately after modifying the table. Emits
+    // selectFinished() if it supersedes a pending selectAsync().
     void select();
+    // Executes the queries with another database connection in a worker
+    // thread. The rows of the first page are displayed as soon as they are
+    // known, all rows when selectFinished() is emitted. Pending selects are
+    // cancelled. Falls back to select() if no connection pool is available.
+    void selectAsync();
+
+  signals:
+    void selectFinished();
 
   protected:
     void setTable(const QString& tableName, const QString& trackIdColumn,
@@ -94,6 +113,12 @@ class BaseSqlTableModel : public QAbstractTableModel, public TrackModel {
     void initHeaderData();
     virtual void initSortColumnMapping();
 
+    // An SQL condition that restricts the rows of the table provided to
+    // setTable(). Evaluated on every select, so it may change in between.
+    virtual QString tableFilter() const {
+        return QString();
+    }
+
     // Use this if you want a model that is read-only.
     virtual Qt::ItemFlags readOnlyFlags(const QModelIndex &index) const;
     // Use this if you want a model that can be changed
@@ -112,6 +137,8 @@ class BaseSqlTableModel : public QAbstractTableModel, public TrackModel {
     virtual void tracksChanged(QSet<TrackId> trackIds);
     virtual void trackLoaded(QString group, TrackPointer pTrack);
     void refreshCell(int row, int column);
+    void slotFirstPageSelected();
+    void slotSelectFinished();
 
   private:
     // A simple helper function for initializing header title and width.  Note
@@ -124,6 +151,7 @@ class BaseSqlTableModel : public QAbstractTableModel, public TrackModel {
     // names in the table provided to setTable. Must be called after setTable is
     // called.
     QString orderByClause() const;
+    QString selectQueryString() const;
 
     struct RowInfo {
         TrackId trackId;
@@ -147,6 +175,13 @@ class BaseSqlTableModel : public QAbstractTableModel, public TrackModel {
     void replaceRows(
             QVector<RowInfo>&& rows,
             TrackId2Rows&& trackIdToRows);
+    // Sorts the rows by the order of the track source and replaces them
+    void replaceSelectedRows(QVector<RowInfo>&& rowInfos);
+    static QVector<RowInfo> toRowInfos(
+            QVector<BaseSqlTableSelectTask::Row> rows);
+    void cancelSelect();
+    // Executes the queries of select() and replaces the rows
+    void selectRows();
 
     QVector<RowInfo> m_rowInfo;
 
@@ -163,6 +198,8 @@ class BaseSqlTableModel : public QAbstractTableModel, public TrackModel {
     QString m_currentSearchFilter;
     QVector<QHash<int, QVariant> > m_headerInfo;
     QString m_trackSourceOrderBy;
+    QSharedPointer<BaseSqlTableSelectTask> m_pSelectTask;
+    Timer m_selectTimer;
 
     DISALLOW_COPY_AND_ASSIGN(BaseSqlTableModel);
 };
@@ -0,0 +1,242 @@
+#include "library/basesqltableselecttask.h"
+
+#include <QMutexLocker>
+#include <QRegExp>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QtConcurrentRun>
+
+#include "library/queryutil.h"
+#include "util/assert.h"
+#include "util/db/dbconnectionpooled.h"
+#include "util/db/dbconnectionpooler.h"
+#include "util/logger.h"
+#include "util/performancetimer.h"
+#include "util/timer.h"
+
+namespace {
+
+mixxx::Logger kLogger("BaseSqlTableSelectTask");
+
+// How often a cancelled task is detected while fetching rows
+const int kCancelCheckRows = 1000;
+
+// SQLite removes the TEMP keyword from the stored definition
+const QString kCreateViewPattern =
+        QStringLiteral("^CREATE\\s+(TEMP\\s+|TEMPORARY\\s+)?VIEW");
+
+// Picks the rows of the first page of sorted track ids. Tracks might be
+// contained multiple times, e.g. in history playlists.
+QVector<BaseSqlTableSelectTask::Row> firstPageRows(
+        const QVector<BaseSqlTableSelectTask::Row>& rows,
+        const QVector<TrackId>& sortedTrackIds) {
+    QHash<TrackId, int> pageIndices;
+    for (int i = 0; i < sortedTrackIds.size(); ++i) {
+        if (!pageIndices.contains(sortedTrackIds[i])) {
+            pageIndices.insert(sortedTrackIds[i], i);
+        }
+    }
+    QVector<QVector<BaseSqlTableSelectTask::Row>> pageRows(sortedTrackIds.size());
+    for (const auto& row : rows) {
+        const auto i = pageIndices.constFind(row.trackId);
+        if (i != pageIndices.constEnd()) {
+            pageRows[i.value()].append(row);
+        }
+    }
+    QVector<BaseSqlTableSelectTask::Row> firstPage;
+    firstPage.reserve(sortedTrackIds.size());
+    for (const auto& rowsOfTrack : pageRows) {
+        firstPage += rowsOfTrack;
+    }
+    return firstPage;
+}
+
+} // anonymous namespace
+
+const int BaseSqlTableSelectTask::kFirstPageRows = 100;
+
+// static
+QStringList BaseSqlTableSelectTask::temporaryViewDefinitions(
+        QSqlDatabase database,
+        const QStringList& tableNames) {
+    QStringList definitions;
+    QSqlQuery query(database);
+    query.prepare(
+            "SELECT sql FROM sqlite_temp_master "
+            "WHERE type='view' AND name=:name");
+    for (const auto& tableName : tableNames) {
+        query.bindValue(":name", tableName);
+        if (!query.exec()) {
+            LOG_FAILED_QUERY(query);
+            continue;
+        }
+        if (query.next()) {
+            definitions << query.value(0).toString();
+        }
+    }
+    return definitions;
+}
+
+// static
+QSharedPointer<BaseSqlTableSelectTask> BaseSqlTableSelectTask::create(
+        mixxx::DbConnectionPoolPtr pDbConnectionPool,
+        Query query) {
+    // The worker thread might release the last reference
+    return QSharedPointer<BaseSqlTableSelectTask>(
+            new BaseSqlTableSelectTask(
+                    std::move(pDbConnectionPool),
+                    std::move(query)),
+            &QObject::deleteLater);
+}
+
+// static
+void BaseSqlTableSelectTask::start(QSharedPointer<BaseSqlTableSelectTask> pTask) {
+    QtConcurrent::run(&BaseSqlTableSelectTask::run, pTask);
+}
+
+BaseSqlTableSelectTask::BaseSqlTableSelectTask(
+        mixxx::DbConnectionPoolPtr pDbConnectionPool,
+        Query query)
+        : m_pDbConnectionPool(std::move(pDbConnectionPool)),
+          m_query(std::move(query)),
+          m_cancelled(0) {
+}
+
+void BaseSqlTableSelectTask::cancel() {
+    m_cancelled.storeRelease(1);
+}
+
+bool BaseSqlTableSelectTask::isCancelled() const {
+    return m_cancelled.loadAcquire() != 0;
+}
+
+QVector<BaseSqlTableSelectTask::Row> BaseSqlTableSelectTask::takeFirstPage() {
+    QMutexLocker locked(&m_mutex);
+    QVector<Row> firstPage;
+    firstPage.swap(m_firstPage);
+    return firstPage;
+}
+
+BaseSqlTableSelectTask::Result BaseSqlTableSelectTask::takeResult() {
+    QMutexLocker locked(&m_mutex);
+    Result result;
+    std::swap(result, m_result);
+    return result;
+}
+
+// static
+void BaseSqlTableSelectTask::run(QSharedPointer<BaseSqlTableSelectTask> pTask) {
+    ScopedTimer t("BaseSqlTableSelectTask::run");
+    Result result;
+    if (!pTask->isCancelled()) {
+        PerformanceTimer timer;
+        timer.start();
+        const mixxx::DbConnectionPooler dbConnectionPooler(
+                pTask->m_pDbConnectionPool);
+        if (dbConnectionPooler.isPooling()) {
+            result.succeeded = pTask->exec(
+                    mixxx::DbConnectionPooled(pTask->m_pDbConnectionPool),
+                    &result);
+        } else {
+            kLogger.warning()
+                    << "Failed to obtain database connection";
+        }
+        result.queryDuration = timer.elapsed();
+    }
+    {
+        QMutexLocker locked(&pTask->m_mutex);
+        pTask->m_result = std::move(result);
+    }
+    emit(pTask->finished());
+}
+
+bool BaseSqlTableSelectTask::exec(QSqlDatabase database, Result* pResult) {
+    const QRegExp createViewRegex(kCreateViewPattern, Qt::CaseInsensitive);
+    for (QString definition : m_query.temporaryViews) {
+        definition.replace(createViewRegex, "CREATE TEMPORARY VIEW");
+        QSqlQuery query(database);
+        if (!query.exec(definition)) {
+            LOG_FAILED_QUERY(query);
+            return false;
+        }
+    }
+
+    QSqlQuery query(database);
+    // This causes a memory savings since QSqlCachedResult (what QtSQLite uses)
+    // won't allocate a giant in-memory table that we won't use at all.
+    query.setForwardOnly(true);
+    if (!query.prepare(m_query.queryString) || !query.exec()) {
+        LOG_FAILED_QUERY(query);
+        return false;
+    }
+    int idColumn = -1;
+    while (query.next()) {
+        if (pResult->rows.size() % kCancelCheckRows == 0 && isCancelled()) {
+            return false;
+        }
+        const QSqlRecord sqlRecord = query.record();
+        if (idColumn < 0) {
+            idColumn = sqlRecord.indexOf(m_query.idColumn);
+            VERIFY_OR_DEBUG_ASSERT(idColumn >= 0) {
+                kLogger.critical()
+                        << "ID column not available in database query results:"
+                        << m_query.idColumn;
+                return false;
+            }
+        }
+        Row row;
+        row.trackId = TrackId(sqlRecord.value(idColumn));
+        row.metadata.reserve(m_query.columnCount);
+        for (int i = 0; i < m_query.columnCount; ++i) {
+            row.metadata.push_back(sqlRecord.value(i));
+        }
+        pResult->trackIds.insert(row.trackId);
+        pResult->rows.push_back(std::move(row));
+        if (!m_query.filterAndSort &&
+                pResult->rows.size() == kFirstPageRows) {
+            // The order of the table query is final
+            publishFirstPage(pResult->rows);
+        }
+    }
+
+    if (!m_query.filterAndSort || pResult->trackIds.isEmpty()) {
+        return true;
+    }
+    if (isCancelled()) {
+        return false;
+    }
+
+    const BaseTrackCache::FilterAndSortQuery& filterAndSortQuery =
+            m_query.filterAndSortQuery;
+    QSqlQuery sortQuery(database);
+    sortQuery.setForwardOnly(true);
+    if (!sortQuery.prepare(filterAndSortQuery.toSql(pResult->trackIds)) ||
+            !sortQuery.exec()) {
+        LOG_FAILED_QUERY(sortQuery);
+        return false;
+    }
+    const int sortIdColumn = sortQuery.record().indexOf(
+            filterAndSortQuery.idColumn);
+    while (sortQuery.next()) {
+        if (pResult->sortedTrackIds.size() % kCancelCheckRows == 0 &&
+                isCancelled()) {
+            return false;
+        }
+        pResult->sortedTrackIds.append(TrackId(sortQuery.value(sortIdColumn)));
+        // Otherwise the rows are finally in the order of the table query
+        if (!filterAndSortQuery.orderByClause.isEmpty() &&
+                pResult->sortedTrackIds.size() == kFirstPageRows) {
+            publishFirstPage(firstPageRows(
+                    pResult->rows, pResult->sortedTrackIds));
+        }
+    }
+    return true;
+}
+
+void BaseSqlTableSelectTask::publishFirstPage(QVector<Row> firstPage) {
+    {
+        QMutexLocker locked(&m_mutex);
+        m_firstPage = std::move(firstPage);
+    }
+    emit(firstPageSelected());
+}
@@ -0,0 +1,112 @@
+#ifndef BASESQLTABLESELECTTASK_H
+#define BASESQLTABLESELECTTASK_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QSharedPointer>
+#include <QSqlDatabase>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+#include "library/basetrackcache.h"
+#include "track/trackid.h"
+#include "util/db/dbconnectionpool.h"
+#include "util/duration.h"
+
+// Executes the queries of BaseSqlTableModel::selectAsync() with a pooled
+// database connection in a worker thread, so that the GUI stays responsive
+// while searching or switching to a large table.
+//
+// The first page of rows is published as soon as its order is known, and
+// all rows after the queries have finished. A task that has been superseded
+// by a newer one, e.g. while the user is still typing, should be cancelled.
+// The signals are delivered to the thread that has created the task.
+class BaseSqlTableSelectTask : public QObject {
+    Q_OBJECT
+  public:
+    // Fills the visible rows of the library table
+    static const int kFirstPageRows;
+
+    struct Row {
+        TrackId trackId;
+        QVector<QVariant> metadata;
+    };
+
+    struct Query {
+        Query()
+                : columnCount(0),
+                  filterAndSort(false) {
+        }
+        // The definitions of all temporary views that are needed by the
+        // queries, because they only exist for the connection that has
+        // created them.
+        QStringList temporaryViews;
+        QString queryString;
+        QString idColumn;
+        int columnCount;
+        // Only if the model has a track source
+        bool filterAndSort;
+        BaseTrackCache::FilterAndSortQuery filterAndSortQuery;
+    };
+
+    struct Result {
+        Result()
+                : succeeded(false) {
+        }
+        bool succeeded;
+        // In the order of the table query
+        QVector<Row> rows;
+        QSet<TrackId> trackIds;
+        // The filtered and sorted track ids, only if filterAndSort
+        QVector<TrackId> sortedTrackIds;
+        mixxx::Duration queryDuration;
+    };
+
+    // Returns the definitions of those tables that are temporary views
+    // of the given connection.
+    static QStringList temporaryViewDefinitions(
+            QSqlDatabase database,
+            const QStringList& tableNames);
+
+    // Created in the GUI thread and connected before it is started
+    static QSharedPointer<BaseSqlTableSelectTask> create(
+            mixxx::DbConnectionPoolPtr pDbConnectionPool,
+            Query query);
+    static void start(QSharedPointer<BaseSqlTableSelectTask> pTask);
+
+    void cancel();
+    bool isCancelled() const;
+
+    // Valid after firstPageSelected(). The rows of the first page are in
+    // their final order, but without any corrections for tracks that have
+    // been modified in memory.
+    QVector<Row> takeFirstPage();
+    // Valid after finished()
+    Result takeResult();
+
+  signals:
+    void firstPageSelected();
+    void finished();
+
+  private:
+    BaseSqlTableSelectTask(
+            mixxx::DbConnectionPoolPtr pDbConnectionPool,
+            Query query);
+
+    static void run(QSharedPointer<BaseSqlTableSelectTask> pTask);
+    bool exec(QSqlDatabase database, Result* pResult);
+    void publishFirstPage(QVector<Row> firstPage);
+
+    const mixxx::DbConnectionPoolPtr m_pDbConnectionPool;
+    const Query m_query;
+    QAtomicInt m_cancelled;
+
+    QMutex m_mutex;
+    QVector<Row> m_firstPage;
+    Result m_result;
+};
+
+#endif // BASESQLTABLESELECTTASK_H
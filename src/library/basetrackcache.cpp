@@ -462,6 +462,42 @@ QVariant BaseTrackCache::data(TrackId trackId, int column) const {
     return result;
 }
 
+QString BaseTrackCache::FilterAndSortQuery::toSql(
+        const QSet<TrackId>& trackIds) const {
+    QStringList idStrings;
+    idStrings.reserve(trackIds.size());
+    for (const auto& trackId: trackIds) {
+        idStrings << trackId.toString();
+    }
+    QString where = QString("WHERE %1 IN (%2)")
+            .arg(idColumn, idStrings.join(","));
+    if (!filter.isEmpty()) {
+        where += QString(" AND (%1)").arg(filter);
+    }
+    return QString("SELECT %1 FROM %2 %3 %4")
+            .arg(idColumn, tableName, where, orderByClause);
+}
+
+BaseTrackCache::FilterAndSortQuery BaseTrackCache::prepareFilterAndSort(
+        const QString& searchQuery,
+        const QString& extraFilter,
+        const QString& orderByClause) {
+    if (!m_bIndexBuilt) {
+        buildIndex();
+    }
+
+    // The track ids are only added when executing the query
+    std::unique_ptr<QueryNode> pQuery(parseQuery(
+        searchQuery, extraFilter, QStringList()));
+
+    FilterAndSortQuery query;
+    query.tableName = m_tableName;
+    query.idColumn = m_idColumn;
+    query.filter = pQuery->toSql();
+    query.orderByClause = orderByClause;
+    return query;
+}
+
 void BaseTrackCache::filterAndSort(const QSet<TrackId>& trackIds,
                                    const QString& searchQuery,
                                    const QString& extraFilter,
@@ -474,31 +510,8 @@ void BaseTrackCache::filterAndSort(const QSet<TrackId>& trackIds,
         return;
     }
 
-    if (!m_bIndexBuilt) {
-        buildIndex();
-    }
-
-    QStringList idStrings;
-    // TODO(rryan) consider making this the data passed in and a separate
-    // QVector for output
-    QSet<TrackId> dirtyTracks;
-    for (const auto& trackId: trackIds) {
-        idStrings << trackId.toString();
-        if (m_dirtyTracks.contains(trackId)) {
-            dirtyTracks.insert(trackId);
-        }
-    }
-
-    std::unique_ptr<QueryNode> pQuery(parseQuery(
-        searchQuery, extraFilter, idStrings));
-
-    QString filter = pQuery->toSql();
-    if (!filter.isEmpty()) {
-        filter.prepend("WHERE ");
-    }
-
-    QString queryString = QString("SELECT %1 FROM %2 %3 %4")
-            .arg(m_idColumn, m_tableName, filter, orderByClause);
+    const QString queryString = prepareFilterAndSort(
+            searchQuery, extraFilter, orderByClause).toSql(trackIds);
 
     if (sDebug) {
         qDebug() << this << "select() executing:" << queryString;
@@ -521,17 +534,29 @@ void BaseTrackCache::filterAndSort(const QSet<TrackId>& trackIds,
         qDebug() << "Rows returned:" << rows;
     }
 
-    m_trackOrder.resize(0); // keeps allocated memory
-    trackToIndex->clear();
+    QVector<TrackId> sortedTrackIds;
     if (rows > 0) {
-        trackToIndex->reserve(rows);
-        m_trackOrder.reserve(rows);
+        sortedTrackIds.reserve(rows);
     }
-
     while (query.next()) {
-        TrackId trackId(query.value(idColumn));
-        (*trackToIndex)[trackId] = m_trackOrder.size();
-        m_trackOrder.append(trackId);
+        sortedTrackIds.append(TrackId(query.value(idColumn)));
+    }
+
+    finishFilterAndSort(trackIds, std::move(sortedTrackIds),
+            searchQuery, sortColumns, columnOffset, trackToIndex);
+}
+
+void BaseTrackCache::finishFilterAndSort(const QSet<TrackId>& trackIds,
+                                         QVector<TrackId> sortedTrackIds,
+                                         const QString& searchQuery,
+                                         const QList<SortColumn>& sortColumns,
+                                         const int columnOffset,
+                                         QHash<TrackId, int>* trackToIndex) {
+    m_trackOrder = std::move(sortedTrackIds);
+    trackToIndex->clear();
+    trackToIndex->reserve(m_trackOrder.size());
+    for (int i = 0; i < m_trackOrder.size(); ++i) {
+        (*trackToIndex)[m_trackOrder[i]] = i;
     }
 
     // At this point, the original set of tracks have been divided into two
@@ -543,9 +568,22 @@ void BaseTrackCache::filterAndSort(const QSet<TrackId>& trackIds,
     // membership of tracks in either set, we must then insertion-sort the
     // missing tracks into the resulting index list.
 
-    if (!m_bIsCaching || dirtyTracks.isEmpty()) {
+    if (!m_bIsCaching) {
+        return;
+    }
+    // Tracks might have become dirty while the query has been executed
+    QSet<TrackId> dirtyTracks;
+    for (const auto& trackId: trackIds) {
+        if (m_dirtyTracks.contains(trackId)) {
+            dirtyTracks.insert(trackId);
+        }
+    }
+    if (dirtyTracks.isEmpty()) {
         return;
     }
+    // The extra SQL filter and the track ids match all tracks anyway
+    std::unique_ptr<QueryNode> pQuery(parseQuery(
+        searchQuery, QString(), QStringList()));
 
     for (TrackId trackId: qAsConst(dirtyTracks)) {
         // Only get the track if it is in the cache. Tracks that
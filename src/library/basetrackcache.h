@@ -71,6 +71,29 @@ class BaseTrackCache : public QObject {
                                const QList<SortColumn>& sortColumns,
                                const int columnOffset,
                                QHash<TrackId, int>* trackToIndex);
+
+    // The SQL query of filterAndSort() that can be executed with any
+    // database connection, e.g. by a worker thread. Temporary views of
+    // the table must exist for that connection.
+    struct FilterAndSortQuery {
+        QString toSql(const QSet<TrackId>& trackIds) const;
+
+        QString tableName;
+        QString idColumn;
+        QString filter;
+        QString orderByClause;
+    };
+    FilterAndSortQuery prepareFilterAndSort(const QString& query,
+                                            const QString& extraFilter,
+                                            const QString& orderByClause);
+    // Takes the ids that have been returned by the query in this order and
+    // corrects them for tracks that have been modified in memory.
+    void finishFilterAndSort(const QSet<TrackId>& trackIds,
+                             QVector<TrackId> sortedTrackIds,
+                             const QString& query,
+                             const QList<SortColumn>& sortColumns,
+                             const int columnOffset,
+                             QHash<TrackId, int>* trackToIndex);
     virtual bool isCached(TrackId trackId) const;
     virtual void ensureCached(TrackId trackId);
     virtual void ensureCached(QSet<TrackId> trackIds);
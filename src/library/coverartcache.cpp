@@ -5,6 +5,7 @@
 #include <QtDebug>
 
 #include "library/coverartcache.h"
+#include "library/coverartthumbnailstore.h"
 #include "library/coverartutils.h"
 #include "util/logger.h"
 
@@ -124,16 +125,30 @@ CoverArtCache::FutureResult CoverArtCache::loadCover(
                  << info << desiredWidth << signalWhenDone;
     }
 
-    QImage image = CoverArtUtils::loadCover(info);
-
-    // TODO(XXX) Should we re-hash here? If the cover file (or track metadata)
-    // has changed then info.hash may be incorrect. The fix
-    // will also require noticing a hash mis-match at higher levels and
-    // recording the hash change in the database.
+    // Scrolling through the library table should never touch the
+    // track or image files of covers that have been displayed or
+    // scanned before. The thumbnails are only accessed here and not
+    // in the GUI thread, because storing them blocks all readers.
+    CoverArtThumbnailStore* pThumbnailStore = CoverArtThumbnailStore::instance();
+    QImage image = pThumbnailStore->loadThumbnail(info, desiredWidth);
+    if (image.isNull()) {
+        image = CoverArtUtils::loadCover(info);
+
+        // TODO(XXX) Should we re-hash here? If the cover file (or track metadata)
+        // has changed then info.hash may be incorrect. The fix
+        // will also require noticing a hash mis-match at higher levels and
+        // recording the hash change in the database.
+        // Until then at least don't persist thumbnails with a stale hash.
+        if (!image.isNull() &&
+                pThumbnailStore->shouldStoreThumbnails(info) &&
+                CoverArtUtils::calculateHash(image) == info.hash) {
+            pThumbnailStore->storeThumbnails(info, image);
+        }
+    }
 
     // Adjust the cover size according to the request or downsize the image for
     // efficiency.
-    if (!image.isNull() && desiredWidth > 0) {
+    if (!image.isNull() && desiredWidth > 0 && image.width() != desiredWidth) {
         image = resizeImageWidth(image, desiredWidth);
     }
 
@@ -201,6 +216,13 @@ void CoverArtCache::guessCover(TrackPointer pTrack) {
         }
         CoverInfo cover = CoverArtUtils::guessCoverInfo(*pTrack);
         pTrack->setCoverInfo(cover);
+        // Prepare the thumbnails for the library table while we are at it
+        CoverArtThumbnailStore* pThumbnailStore = CoverArtThumbnailStore::instance();
+        if (cover.type != CoverInfo::NONE &&
+                pThumbnailStore->shouldStoreThumbnails(cover)) {
+            pThumbnailStore->storeThumbnails(
+                    cover, CoverArtUtils::loadCover(cover));
+        }
     }
 }
 
@@ -0,0 +1,454 @@
+#include "library/coverartthumbnailstore.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+#include "util/assert.h"
+#include "util/logger.h"
+
+namespace {
+
+mixxx::Logger kLogger("CoverArtThumbnailStore");
+
+const quint32 kMagic = 0x4d585854; // "MXXT"
+const quint32 kVersion = 2;
+
+struct Header {
+    quint32 magic;
+    quint32 version;
+    quint32 width;
+    quint32 reserved;
+};
+
+struct Entry {
+    // 0 if the slot is empty
+    quint64 key;
+    quint64 offset;
+    quint16 width;
+    quint16 height;
+    quint32 reserved;
+};
+
+static_assert(sizeof(Header) == 16, "unexpected padding");
+static_assert(sizeof(Entry) == 24, "unexpected padding");
+
+// The thumbnails by the digest of their cover location and hash
+// followed by the image data by the digest of its pixels
+enum class Table {
+    Thumbnails = 0,
+    ImageData = 1,
+};
+
+const qint64 kTableEntries = 1 << 17;
+// Linear probing ends after this many occupied slots. The first of
+// them is replaced when inserting into a crowded region.
+const int kMaxProbes = 16;
+const qint64 kDataOffset = sizeof(Header) + 2 * kTableEntries * sizeof(Entry);
+
+// The files are reset when reaching this size, i.e. after about 4k
+// square thumbnails in the largest and 64k in the smallest bucket.
+const qint64 kMaxFileSize = qint64(1) << 30;
+
+// Stored without any conversion when copying it out of the file
+const QImage::Format kFormat = QImage::Format_ARGB32_Premultiplied;
+const int kBytesPerPixel = 4;
+
+qint64 entryOffset(Table table, qint64 slot) {
+    return sizeof(Header) +
+            (static_cast<int>(table) * kTableEntries + slot) * sizeof(Entry);
+}
+
+const Entry* entryAt(const uchar* pData, Table table, qint64 slot) {
+    return reinterpret_cast<const Entry*>(pData + entryOffset(table, slot));
+}
+
+qint64 homeSlot(quint64 key, int probe) {
+    return (key + probe) % kTableEntries;
+}
+
+const Entry* findEntry(const uchar* pData, Table table, quint64 key) {
+    for (int probe = 0; probe < kMaxProbes; ++probe) {
+        const Entry* pEntry = entryAt(pData, table, homeSlot(key, probe));
+        if (pEntry->key == key) {
+            return pEntry;
+        }
+        if (pEntry->key == 0) {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+qint64 insertSlot(const uchar* pData, Table table, quint64 key) {
+    for (int probe = 0; probe < kMaxProbes; ++probe) {
+        const qint64 slot = homeSlot(key, probe);
+        const quint64 slotKey = entryAt(pData, table, slot)->key;
+        if (slotKey == 0 || slotKey == key) {
+            return slot;
+        }
+    }
+    return homeSlot(key, 0);
+}
+
+bool writeEntry(QFile* pFile, Table table, qint64 slot, const Entry& entry) {
+    return pFile->seek(entryOffset(table, slot)) &&
+            pFile->write(reinterpret_cast<const char*>(&entry), sizeof(entry)) ==
+                    sizeof(entry);
+}
+
+// 64-bit FNV-1a
+quint64 digest(const void* pData, qint64 size,
+        quint64 value = 14695981039346656037ULL) {
+    const auto pBytes = static_cast<const uchar*>(pData);
+    for (qint64 i = 0; i < size; ++i) {
+        value ^= pBytes[i];
+        value *= 1099511628211ULL;
+    }
+    return value;
+}
+
+quint64 nonEmptyKey(quint64 key) {
+    return (key != 0) ? key : 1;
+}
+
+// The track file for embedded covers and the image file otherwise
+QString coverLocation(const CoverInfo& info) {
+    if (info.type == CoverInfo::FILE) {
+        return QDir(QFileInfo(info.trackLocation).absolutePath())
+                .absoluteFilePath(info.coverLocation);
+    }
+    return info.trackLocation;
+}
+
+quint64 thumbnailKey(const CoverInfo& info) {
+    const QByteArray location = coverLocation(info).toUtf8();
+    return nonEmptyKey(digest(location.constData(), location.size(),
+            digest(&info.hash, sizeof(info.hash))));
+}
+
+quint64 imageDataKey(const QImage& thumbnail) {
+    const qint32 size[] = {thumbnail.width(), thumbnail.height()};
+    quint64 value = digest(size, sizeof(size));
+    const qint64 bytesPerLine = qint64(thumbnail.width()) * kBytesPerPixel;
+    for (int y = 0; y < thumbnail.height(); ++y) {
+        value = digest(thumbnail.constScanLine(y), bytesPerLine, value);
+    }
+    return nonEmptyKey(value);
+}
+
+} // anonymous namespace
+
+// Covers the library table with the default row heights on high
+// resolution displays, larger covers are only loaded by the decks
+const std::vector<int> CoverArtThumbnailStore::kBucketWidths = {64, 128, 256};
+
+// static
+int CoverArtThumbnailStore::bucketWidth(int desiredWidth) {
+    if (desiredWidth <= 0) {
+        return 0;
+    }
+    for (int width : kBucketWidths) {
+        if (desiredWidth <= width) {
+            return width;
+        }
+    }
+    return 0;
+}
+
+// static
+CoverArtThumbnailStore* CoverArtThumbnailStore::instance() {
+    static CoverArtThumbnailStore s_instance;
+    return &s_instance;
+}
+
+CoverArtThumbnailStore::CoverArtThumbnailStore() {
+}
+
+CoverArtThumbnailStore::~CoverArtThumbnailStore() {
+    close();
+}
+
+bool CoverArtThumbnailStore::open(const QString& directoryPath) {
+    close();
+    QMutexLocker locked(&m_mutex);
+    if (!QDir().mkpath(directoryPath)) {
+        kLogger.warning()
+                << "Failed to create directory"
+                << directoryPath;
+        return false;
+    }
+    std::vector<Bucket> buckets(kBucketWidths.size());
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        Bucket& bucket = buckets[i];
+        bucket.width = kBucketWidths[i];
+        bucket.pFile = std::make_unique<QFile>(QDir(directoryPath).filePath(
+                QString("thumbnails-%1.bin").arg(bucket.width)));
+        if (!openBucket(&bucket)) {
+            kLogger.warning()
+                    << "Failed to open"
+                    << bucket.pFile->fileName()
+                    << bucket.pFile->errorString();
+            return false;
+        }
+    }
+    m_directoryPath = directoryPath;
+    m_buckets = std::move(buckets);
+    kLogger.info()
+            << "Opened thumbnails in"
+            << m_directoryPath;
+    return true;
+}
+
+void CoverArtThumbnailStore::close() {
+    QMutexLocker locked(&m_mutex);
+    // Unmapped and closed by QFile
+    m_buckets.clear();
+    m_directoryPath.clear();
+}
+
+bool CoverArtThumbnailStore::isOpen() const {
+    QMutexLocker locked(&m_mutex);
+    return !m_buckets.empty();
+}
+
+QImage CoverArtThumbnailStore::loadThumbnail(
+        const CoverInfo& info, int desiredWidth) const {
+    const int width = bucketWidth(desiredWidth);
+    if (width == 0) {
+        return QImage();
+    }
+    const quint64 key = thumbnailKey(info);
+    QMutexLocker locked(&m_mutex);
+    // Fall back to larger buckets if the thumbnail has not
+    // been stored in the preferred one yet
+    for (const auto& bucket : m_buckets) {
+        if (bucket.width < width) {
+            continue;
+        }
+        QImage thumbnail = loadThumbnail(bucket, key);
+        if (!thumbnail.isNull()) {
+            return thumbnail;
+        }
+    }
+    return QImage();
+}
+
+bool CoverArtThumbnailStore::shouldStoreThumbnails(const CoverInfo& info) const {
+    const quint64 key = thumbnailKey(info);
+    QMutexLocker locked(&m_mutex);
+    for (const auto& bucket : m_buckets) {
+        if (!containsThumbnail(bucket, key)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CoverArtThumbnailStore::storeThumbnails(
+        const CoverInfo& info, const QImage& cover) {
+    if (cover.isNull()) {
+        return;
+    }
+    const quint64 key = thumbnailKey(info);
+    // Scale the cover without holding the lock
+    std::vector<int> missingWidths;
+    {
+        QMutexLocker locked(&m_mutex);
+        for (const auto& bucket : m_buckets) {
+            if (!containsThumbnail(bucket, key)) {
+                missingWidths.push_back(bucket.width);
+            }
+        }
+    }
+    for (int width : missingWidths) {
+        QImage thumbnail;
+        if (cover.width() > width) {
+            thumbnail = cover.scaledToWidth(width, Qt::SmoothTransformation);
+        } else {
+            thumbnail = cover;
+        }
+        thumbnail = thumbnail.convertToFormat(kFormat);
+        if (thumbnail.height() > 0xffff) {
+            continue;
+        }
+        QMutexLocker locked(&m_mutex);
+        for (auto& bucket : m_buckets) {
+            if (bucket.width == width) {
+                appendThumbnail(&bucket, key, thumbnail);
+            }
+        }
+    }
+}
+
+bool CoverArtThumbnailStore::openBucket(Bucket* pBucket) {
+    QFile* pFile = pBucket->pFile.get();
+    if (!pFile->open(QIODevice::ReadWrite)) {
+        return false;
+    }
+    Header header;
+    if (pFile->size() < kDataOffset ||
+            pFile->read(reinterpret_cast<char*>(&header), sizeof(header)) !=
+                    sizeof(header) ||
+            header.magic != kMagic ||
+            header.version != kVersion ||
+            header.width != static_cast<quint32>(pBucket->width)) {
+        kLogger.info()
+                << "Creating"
+                << pFile->fileName();
+        if (!resetBucket(pBucket)) {
+            return false;
+        }
+    }
+    return mapBucket(pBucket);
+}
+
+bool CoverArtThumbnailStore::resetBucket(Bucket* pBucket) {
+    QFile* pFile = pBucket->pFile.get();
+    if (pBucket->pData) {
+        pFile->unmap(pBucket->pData);
+        pBucket->pData = nullptr;
+        pBucket->size = 0;
+    }
+    Header header;
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.width = pBucket->width;
+    header.reserved = 0;
+    // The index is filled with zeros when growing the file
+    return pFile->resize(0) &&
+            pFile->seek(0) &&
+            pFile->write(reinterpret_cast<const char*>(&header), sizeof(header)) ==
+                    sizeof(header) &&
+            pFile->resize(kDataOffset);
+}
+
+bool CoverArtThumbnailStore::mapBucket(Bucket* pBucket) {
+    QFile* pFile = pBucket->pFile.get();
+    if (pBucket->pData) {
+        pFile->unmap(pBucket->pData);
+    }
+    pBucket->size = pFile->size();
+    pBucket->pData = pFile->map(0, pBucket->size);
+    if (!pBucket->pData) {
+        pBucket->size = 0;
+        return false;
+    }
+    return true;
+}
+
+bool CoverArtThumbnailStore::containsThumbnail(
+        const Bucket& bucket, quint64 key) const {
+    if (!bucket.pData) {
+        // Nothing can be stored
+        return true;
+    }
+    return findEntry(bucket.pData, Table::Thumbnails, key) != nullptr;
+}
+
+QImage CoverArtThumbnailStore::loadThumbnail(
+        const Bucket& bucket, quint64 key) const {
+    if (!bucket.pData) {
+        return QImage();
+    }
+    const Entry* pEntry = findEntry(bucket.pData, Table::Thumbnails, key);
+    if (!pEntry) {
+        return QImage();
+    }
+    const int bytesPerLine = pEntry->width * kBytesPerPixel;
+    VERIFY_OR_DEBUG_ASSERT(pEntry->offset >= static_cast<quint64>(kDataOffset) &&
+            pEntry->offset + static_cast<quint64>(bytesPerLine) * pEntry->height <=
+                    static_cast<quint64>(bucket.size)) {
+        return QImage();
+    }
+    // Deep copy, the file is remapped when storing more thumbnails
+    return QImage(
+            bucket.pData + pEntry->offset,
+            pEntry->width,
+            pEntry->height,
+            bytesPerLine,
+            kFormat).copy();
+}
+
+bool CoverArtThumbnailStore::appendThumbnail(
+        Bucket* pBucket, quint64 key, const QImage& thumbnail) {
+    DEBUG_ASSERT(thumbnail.format() == kFormat);
+    if (containsThumbnail(*pBucket, key)) {
+        // Stored concurrently
+        return true;
+    }
+    QFile* pFile = pBucket->pFile.get();
+    const qint64 bytesPerLine = qint64(thumbnail.width()) * kBytesPerPixel;
+    const qint64 length = bytesPerLine * thumbnail.height();
+    if (pBucket->size + length > kMaxFileSize) {
+        kLogger.info()
+                << "Discarding all thumbnails in"
+                << pFile->fileName();
+        if (!resetBucket(pBucket) || !mapBucket(pBucket)) {
+            kLogger.warning()
+                    << "Failed to reset"
+                    << pFile->fileName()
+                    << pFile->errorString();
+            return false;
+        }
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.offset = 0;
+    entry.width = thumbnail.width();
+    entry.height = thumbnail.height();
+    entry.reserved = 0;
+    // Share the image data with other tracks that embed the same cover
+    const quint64 dataKey = imageDataKey(thumbnail);
+    const Entry* pDataEntry = findEntry(pBucket->pData, Table::ImageData, dataKey);
+    if (pDataEntry &&
+            pDataEntry->width == entry.width &&
+            pDataEntry->height == entry.height) {
+        entry.offset = pDataEntry->offset;
+    }
+    const qint64 thumbnailSlot = insertSlot(pBucket->pData, Table::Thumbnails, key);
+    const qint64 dataSlot = insertSlot(pBucket->pData, Table::ImageData, dataKey);
+    pFile->unmap(pBucket->pData);
+    pBucket->pData = nullptr;
+
+    bool written = true;
+    if (entry.offset == 0) {
+        const qint64 offset = pFile->size();
+        written = pFile->seek(offset);
+        for (int y = 0; written && y < thumbnail.height(); ++y) {
+            written = pFile->write(
+                    reinterpret_cast<const char*>(thumbnail.constScanLine(y)),
+                    bytesPerLine) == bytesPerLine;
+        }
+        if (written) {
+            entry.offset = offset;
+            Entry dataEntry = entry;
+            dataEntry.key = dataKey;
+            written = pFile->flush() &&
+                    writeEntry(pFile, Table::ImageData, dataSlot, dataEntry);
+        } else {
+            // Drop the incomplete data
+            pFile->resize(offset);
+        }
+    }
+    // Only referenced after the data has been written completely
+    written = written &&
+            pFile->flush() &&
+            writeEntry(pFile, Table::Thumbnails, thumbnailSlot, entry) &&
+            pFile->flush();
+    if (!written) {
+        kLogger.warning()
+                << "Failed to write thumbnail to"
+                << pFile->fileName()
+                << pFile->errorString();
+    }
+    if (!mapBucket(pBucket)) {
+        kLogger.warning()
+                << "Failed to map"
+                << pFile->fileName()
+                << pFile->errorString();
+        return false;
+    }
+    return written;
+}
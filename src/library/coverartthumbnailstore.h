@@ -0,0 +1,97 @@
+#ifndef COVERARTTHUMBNAILSTORE_H
+#define COVERARTTHUMBNAILSTORE_H
+
+#include <memory>
+#include <vector>
+
+#include <QFile>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+#include "library/coverart.h"
+
+// Persistent thumbnails of cover art that are keyed by the location
+// and the hash of the cover.
+//
+// The library table requests covers with the width of the cover art
+// column. Loading them from the audio or image files when scrolling
+// through a large library is slow, even if it is done in worker threads.
+// Instead the covers are scaled down once, either when the tracks are
+// scanned or when a cover is loaded for the first time, and stored
+// uncompressed in a file per width bucket. These files are mapped into
+// memory and a thumbnail is copied out of it without any decoding.
+//
+// The 16-bit cover hash alone is not unique. Each thumbnail is found by
+// a 64-bit digest of the hash and the location of the cover, i.e. the
+// track file for embedded covers and the image file otherwise. Hits with
+// a different digest are rejected. Tracks that embed the same cover share
+// the image data, which is found by a digest of the pixels.
+//
+// Each file starts with a header and two hash tables with open addressing
+// for both digests, followed by the image data that is only ever appended.
+// The files are in native byte order and are recreated if they don't
+// match.
+//
+// All functions are thread-safe. Writing blocks all other callers while
+// the files are written and remapped, so they must not be called from
+// the GUI thread.
+class CoverArtThumbnailStore final {
+  public:
+    // The widths of the stored thumbnails in ascending order
+    static const std::vector<int> kBucketWidths;
+
+    // Returns the width of the smallest bucket for the desired width
+    // or 0 if it is larger than all buckets.
+    static int bucketWidth(int desiredWidth);
+
+    // Closed until opened with the settings directory
+    static CoverArtThumbnailStore* instance();
+
+    CoverArtThumbnailStore();
+    ~CoverArtThumbnailStore();
+
+    bool open(const QString& directoryPath);
+    void close();
+    bool isOpen() const;
+
+    // Returns the thumbnail of the smallest bucket for the desired width
+    // that has been stored or a null image otherwise. The thumbnail might
+    // be smaller than the desired width if the cover is.
+    QImage loadThumbnail(const CoverInfo& info, int desiredWidth) const;
+
+    // Returns true if a thumbnail is missing in any bucket, i.e. if
+    // it is worth loading the cover for storeThumbnails().
+    bool shouldStoreThumbnails(const CoverInfo& info) const;
+
+    // Scales the cover down for all buckets that don't contain it yet.
+    // Covers are never scaled up.
+    void storeThumbnails(const CoverInfo& info, const QImage& cover);
+
+  private:
+    struct Bucket {
+        Bucket()
+                : width(0),
+                  pData(nullptr),
+                  size(0) {
+        }
+        int width;
+        std::unique_ptr<QFile> pFile;
+        uchar* pData;
+        qint64 size;
+    };
+
+    // The caller must hold the lock
+    bool openBucket(Bucket* pBucket);
+    bool resetBucket(Bucket* pBucket);
+    bool mapBucket(Bucket* pBucket);
+    bool containsThumbnail(const Bucket& bucket, quint64 key) const;
+    QImage loadThumbnail(const Bucket& bucket, quint64 key) const;
+    bool appendThumbnail(Bucket* pBucket, quint64 key, const QImage& thumbnail);
+
+    mutable QMutex m_mutex;
+    QString m_directoryPath;
+    std::vector<Bucket> m_buckets;
+};
+
+#endif // COVERARTTHUMBNAILSTORE_H
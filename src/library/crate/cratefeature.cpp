@@ -220,7 +220,7 @@ bool CrateFeature::dropAcceptChild(const QModelIndex& index, QList<QUrl> urls,
             trackIds.removeAt(trackIdIndex--);
         }
     }
-    m_pTrackCollection->addCrateTracks(crateId, trackIds);
+    m_pTrackCollection->addCrateTracksAsync(crateId, trackIds);
     return true;
 }
 
@@ -0,0 +1,259 @@
+#include "library/crate/cratemembership.h"
+
+#include "library/crate/cratestorage.h"
+#include "library/dao/trackschema.h"
+#include "util/db/dbconnection.h"
+#include "util/db/sqllikewildcards.h"
+#include "util/logger.h"
+#include "util/timer.h"
+
+namespace {
+
+const mixxx::Logger kLogger("CrateMembership");
+
+// Larger sets of track ids are not listed literally in a query
+const int kMaxTrackIdsSqlValues = 50000;
+// Runs of consecutive track ids are formatted as ranges. SQLite limits
+// the depth of expressions, so is the number of ranges.
+const quint32 kMinTrackIdsSqlRangeLength = 8;
+const int kMaxTrackIdsSqlRanges = 100;
+
+} // anonymous namespace
+
+CrateMembership::CrateMembership(const CrateStorage* pCrateStorage)
+        : m_pCrateStorage(pCrateStorage),
+          m_loaded(false),
+          m_revision(0),
+          m_tracksWithCrateValid(false) {
+    DEBUG_ASSERT(m_pCrateStorage);
+}
+
+void CrateMembership::reset() {
+    m_loaded = false;
+    m_crates.clear();
+    modified();
+}
+
+void CrateMembership::modified() {
+    ++m_revision;
+    m_tracksWithCrateValid = false;
+    m_tracksWithCrate.clear();
+}
+
+void CrateMembership::load() const {
+    if (m_loaded) {
+        return;
+    }
+    Timer timer("CrateMembership::load");
+    timer.start();
+
+    m_crates.clear();
+    {
+        CrateSelectResult crates(m_pCrateStorage->selectCrates());
+        Crate crate;
+        while (crates.populateNext(&crate)) {
+            m_crates[crate.getId()].name = crate.getName();
+        }
+    }
+    {
+        CrateTrackSelectResult crateTracks(
+                m_pCrateStorage->selectAllCrateTracksSorted());
+        CrateId crateId;
+        std::vector<quint32> trackValues;
+        const auto flush = [this, &crateId, &trackValues]() {
+            // Orphaned tracks of inexistent crates are ignored like
+            // when joining crates and crate_tracks
+            const auto i = m_crates.find(crateId);
+            if (i != m_crates.end()) {
+                i.value().tracks =
+                        mixxx::CompressedBitmap::fromSorted(trackValues);
+            }
+            trackValues.clear();
+        };
+        while (crateTracks.next()) {
+            if (crateTracks.crateId() != crateId) {
+                flush();
+                crateId = crateTracks.crateId();
+            }
+            const TrackId trackId = crateTracks.trackId();
+            if (trackId.isValid()) {
+                trackValues.push_back(toBitmapValue(trackId));
+            }
+        }
+        flush();
+    }
+    m_loaded = true;
+
+    const mixxx::Duration elapsed = timer.elapsed(true);
+    if (kLogger.debugEnabled()) {
+        kLogger.debug()
+                << "Loaded" << m_crates.size() << "crates in"
+                << elapsed.formatMillisWithUnit();
+    }
+}
+
+int CrateMembership::crateCount() const {
+    load();
+    return m_crates.size();
+}
+
+mixxx::CompressedBitmap CrateMembership::crateTracks(CrateId crateId) const {
+    load();
+    const auto i = m_crates.constFind(crateId);
+    if (i == m_crates.constEnd()) {
+        return mixxx::CompressedBitmap();
+    }
+    return i.value().tracks;
+}
+
+mixxx::CompressedBitmap CrateMembership::tracksByCrateNameLike(
+        const QString& crateNameLike) const {
+    load();
+    const QString pattern = kSqlLikeMatchAll + crateNameLike + kSqlLikeMatchAll;
+    mixxx::CompressedBitmap tracks;
+    for (auto i = m_crates.constBegin(); i != m_crates.constEnd(); ++i) {
+        // The arguments are modified, the same as the LIKE function
+        // that is installed into SQLite
+        QString likePattern = pattern;
+        QString name = i.value().name;
+        if (mixxx::DbConnection::likeCompareLatinLow(
+                &likePattern, &name, QChar('\0'))) {
+            tracks |= i.value().tracks;
+        }
+    }
+    return tracks;
+}
+
+const mixxx::CompressedBitmap& CrateMembership::tracksWithCrate() const {
+    load();
+    if (!m_tracksWithCrateValid) {
+        m_tracksWithCrate.clear();
+        for (const auto& entry : m_crates) {
+            m_tracksWithCrate |= entry.tracks;
+        }
+        m_tracksWithCrateValid = true;
+    }
+    return m_tracksWithCrate;
+}
+
+void CrateMembership::onPurgedTracks(const QList<TrackId>& trackIds) {
+    if (m_loaded) {
+        mixxx::CompressedBitmap purged;
+        for (const auto& trackId : trackIds) {
+            if (trackId.isValid()) {
+                purged.insert(toBitmapValue(trackId));
+            }
+        }
+        for (auto& entry : m_crates) {
+            entry.tracks -= purged;
+        }
+    }
+    modified();
+}
+
+void CrateMembership::readCrateName(CrateId crateId) {
+    Crate crate;
+    if (m_pCrateStorage->readCrateById(crateId, &crate)) {
+        m_crates[crateId].name = crate.getName();
+    } else {
+        kLogger.warning()
+                << "Failed to read crate"
+                << crateId;
+        // Reload everything on next use
+        m_loaded = false;
+        m_crates.clear();
+    }
+}
+
+void CrateMembership::slotCrateInserted(CrateId crateId) {
+    if (m_loaded) {
+        readCrateName(crateId);
+    }
+    modified();
+}
+
+void CrateMembership::slotCrateUpdated(CrateId crateId) {
+    if (m_loaded) {
+        // The name might have changed
+        readCrateName(crateId);
+    }
+    modified();
+}
+
+void CrateMembership::slotCrateDeleted(CrateId crateId) {
+    if (m_loaded) {
+        m_crates.remove(crateId);
+    }
+    modified();
+}
+
+void CrateMembership::slotCrateTracksChanged(
+        CrateId crateId,
+        const QList<TrackId>& tracksAdded,
+        const QList<TrackId>& tracksRemoved) {
+    const auto i = m_crates.find(crateId);
+    if (i != m_crates.end()) {
+        mixxx::CompressedBitmap& tracks = i.value().tracks;
+        for (const auto& trackId : tracksAdded) {
+            if (trackId.isValid()) {
+                tracks.insert(toBitmapValue(trackId));
+            }
+        }
+        for (const auto& trackId : tracksRemoved) {
+            if (trackId.isValid()) {
+                tracks.remove(toBitmapValue(trackId));
+            }
+        }
+    }
+    modified();
+}
+
+//static
+QString CrateMembership::formatTrackIdsSql(
+        const mixxx::CompressedBitmap& trackIds,
+        bool negated) {
+    QStringList values;
+    QStringList ranges;
+    for (const auto& range : trackIds.ranges()) {
+        if (range.second - range.first + 1 >= kMinTrackIdsSqlRangeLength &&
+                ranges.size() < kMaxTrackIdsSqlRanges) {
+            ranges << QString("%1 BETWEEN %2 AND %3").arg(
+                    LIBRARYTABLE_ID,
+                    QString::number(range.first),
+                    QString::number(range.second));
+            continue;
+        }
+        if (values.size() + (range.second - range.first + 1) >
+                static_cast<quint32>(kMaxTrackIdsSqlValues)) {
+            return QString();
+        }
+        for (quint32 value = range.first; value <= range.second; ++value) {
+            values << QString::number(value);
+            if (value == range.second) {
+                break; // prevent overflow
+            }
+        }
+    }
+    const int clauseCount = ranges.size() + (values.isEmpty() ? 0 : 1);
+    if (clauseCount == 0) {
+        // Constant expressions for no or all tracks
+        return negated ? "1" : "0";
+    }
+    // A single clause is negated inline
+    const QString inlineNot = (negated && clauseCount == 1) ? "NOT " : "";
+    QStringList sqlClauses;
+    if (!values.isEmpty()) {
+        sqlClauses << QString("%1 %2IN (%3)").arg(
+                LIBRARYTABLE_ID, inlineNot, values.join(","));
+    }
+    for (const auto& range : ranges) {
+        sqlClauses << (inlineNot.isEmpty() ? range :
+                QString(range).replace(" BETWEEN ", " NOT BETWEEN "));
+    }
+    QString sql = sqlClauses.size() > 1 ?
+            "(" + sqlClauses.join(") OR (") + ")" : sqlClauses.front();
+    if (negated && clauseCount > 1) {
+        sql = "NOT (" + sql + ")";
+    }
+    return sql;
+}
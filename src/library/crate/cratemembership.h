@@ -0,0 +1,97 @@
+#ifndef MIXXX_CRATEMEMBERSHIP_H
+#define MIXXX_CRATEMEMBERSHIP_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+#include "library/crate/crateid.h"
+#include "track/trackid.h"
+#include "util/compressedbitmap.h"
+
+class CrateStorage;
+
+// The tracks of all crates kept in memory as compressed bitmaps of
+// track ids. Crate filters of search queries and the rows of the
+// CrateTableModel are evaluated against these bitmaps instead of
+// joining crate_tracks and crates for each query.
+//
+// All crates are loaded with a single query on first use. Afterwards
+// the bitmaps are updated incrementally when TrackCollection signals
+// that crates or their tracks have been modified.
+class CrateMembership : public QObject {
+    Q_OBJECT
+
+  public:
+    explicit CrateMembership(const CrateStorage* pCrateStorage);
+    ~CrateMembership() override = default;
+
+    // Valid track ids are never negative
+    static quint32 toBitmapValue(TrackId trackId) {
+        DEBUG_ASSERT(trackId.isValid());
+        return static_cast<quint32>(trackId.value());
+    }
+
+    // Discards all bitmaps, e.g. after the database has been
+    // (dis-)connected. They will be reloaded on next use.
+    void reset();
+
+    // Incremented on every modification. Results that have been derived
+    // from the bitmaps need to be evaluated again when it changes.
+    quint64 revision() const {
+        return m_revision;
+    }
+
+    int crateCount() const;
+    mixxx::CompressedBitmap crateTracks(CrateId crateId) const;
+    // The tracks of all crates with a name that contains the given
+    // pattern, consistent with formatQueryForTrackIdsByCrateNameLike()
+    mixxx::CompressedBitmap tracksByCrateNameLike(const QString& crateNameLike) const;
+    // The tracks that are contained in at least one crate
+    const mixxx::CompressedBitmap& tracksWithCrate() const;
+
+    // Tracks that have been purged are removed from all crates without
+    // a signal
+    void onPurgedTracks(const QList<TrackId>& trackIds);
+
+    // Formats an SQL condition on the id column of the library for a set
+    // of track ids, e.g. for the tracks of a crate or a crate filter of a
+    // search query. Returns a null string if the set is too large for a
+    // literal query, i.e. when it contains a huge number of scattered
+    // track ids.
+    static QString formatTrackIdsSql(
+            const mixxx::CompressedBitmap& trackIds,
+            bool negated);
+
+  public slots:
+    void slotCrateInserted(CrateId crateId);
+    void slotCrateUpdated(CrateId crateId);
+    void slotCrateDeleted(CrateId crateId);
+    void slotCrateTracksChanged(
+            CrateId crateId,
+            const QList<TrackId>& tracksAdded,
+            const QList<TrackId>& tracksRemoved);
+
+  private:
+    struct Entry {
+        QString name;
+        mixxx::CompressedBitmap tracks;
+    };
+
+    void load() const;
+    void readCrateName(CrateId crateId);
+    void modified();
+
+    const CrateStorage* const m_pCrateStorage;
+
+    mutable bool m_loaded;
+    mutable QHash<CrateId, Entry> m_crates;
+    quint64 m_revision;
+
+    // Derived from m_crates and recalculated on demand
+    mutable bool m_tracksWithCrateValid;
+    mutable mixxx::CompressedBitmap m_tracksWithCrate;
+};
+
+#endif // MIXXX_CRATEMEMBERSHIP_H
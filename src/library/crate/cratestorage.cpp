@@ -559,6 +559,19 @@ TrackSelectResult CrateStorage::selectAllTracksSorted() const {
     }
 }
 
+CrateTrackSelectResult CrateStorage::selectAllCrateTracksSorted() const {
+    FwdSqlQuery query(m_database, QString(
+            "SELECT %1,%2 FROM %3 ORDER BY %1,%2").arg(
+                    CRATETRACKSTABLE_CRATEID, // %1
+                    CRATETRACKSTABLE_TRACKID, // %2
+                    CRATE_TRACKS_TABLE)); // %3
+    if (query.execPrepared()) {
+        return CrateTrackSelectResult(std::move(query));
+    } else {
+        return CrateTrackSelectResult();
+    }
+}
+
 QSet<CrateId> CrateStorage::collectCrateIdsOfTracks(const QList<TrackId>& trackIds) const {
     // NOTE(uklotzde): One query per track id. This could be optimized
     // by querying for chunks of track ids and collecting the results.
@@ -711,7 +724,16 @@ bool CrateStorage::onDeletingCrate(
 bool CrateStorage::onAddingCrateTracks(
         CrateId crateId,
         const QList<TrackId>& trackIds) {
-    FwdSqlQuery query(m_database, QString(
+    return onAddingCrateTracks(m_database, crateId, trackIds);
+}
+
+
+//static
+bool CrateStorage::onAddingCrateTracks(
+        QSqlDatabase database,
+        CrateId crateId,
+        const QList<TrackId>& trackIds) {
+    FwdSqlQuery query(database, QString(
             "INSERT OR IGNORE INTO %1 (%2, %3) VALUES (:crateId,:trackId)").arg(
                     CRATE_TRACKS_TABLE,
                     CRATETRACKSTABLE_CRATEID,
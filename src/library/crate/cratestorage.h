@@ -255,6 +255,12 @@ class CrateStorage: public virtual /*implements*/ SqlStorage {
     bool onAddingCrateTracks(
             CrateId crateId,
             const QList<TrackId>& trackIds);
+    // Same as onAddingCrateTracks() for connections of other threads,
+    // e.g. of the DbWriter
+    static bool onAddingCrateTracks(
+            QSqlDatabase database,
+            CrateId crateId,
+            const QList<TrackId>& trackIds);
 
     bool onRemovingCrateTracks(
             CrateId crateId,
@@ -319,6 +325,8 @@ class CrateStorage: public virtual /*implements*/ SqlStorage {
     CrateTrackSelectResult selectTracksSortedByCrateNameLike(
             const QString& crateNameLike) const;
     TrackSelectResult selectAllTracksSorted() const;
+    // The contents of all crates at once, sorted by crate and track id
+    CrateTrackSelectResult selectAllCrateTracksSorted() const;
 
     // Returns the set of crate ids for crates that contain any of the
     // provided track ids.
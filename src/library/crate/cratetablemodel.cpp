@@ -8,6 +8,12 @@
 
 #include <QtDebug>
 
+namespace {
+
+const QString kCrateLibraryView = "crate_library_view";
+
+} // anonymous namespace
+
 CrateTableModel::CrateTableModel(QObject* pParent,
                                  TrackCollection* pTrackCollection)
         : BaseSqlTableModel(pParent, pTrackCollection,
@@ -25,7 +31,8 @@ void CrateTableModel::selectCrate(CrateId crateId) {
     }
     m_selectedCrate = crateId;
 
-    QString tableName = QString("crate_%1").arg(m_selectedCrate.toString());
+    // All crates share a single view. The tracks of the selected crate
+    // are picked by tableFilter().
     QStringList columns;
     columns << LIBRARYTABLE_ID
             << "'' AS " + LIBRARYTABLE_PREVIEW
@@ -38,25 +45,35 @@ void CrateTableModel::selectCrate(CrateId crateId) {
     // track property, which persist over a hide / unhide cycle.
     QString queryString = QString("CREATE TEMPORARY VIEW IF NOT EXISTS %1 AS "
                                   "SELECT %2 FROM %3 "
-                                  "WHERE %4 IN (%5) "
-                                  "AND %6=0")
-                          .arg(tableName,
+                                  "WHERE %4=0")
+                          .arg(kCrateLibraryView,
                                columns.join(","),
                                LIBRARY_TABLE,
-                               LIBRARYTABLE_ID,
-                               CrateStorage::formatSubselectQueryForCrateTrackIds(crateId),
                                LIBRARYTABLE_MIXXXDELETED);
     FwdSqlQuery(m_database, queryString).execPrepared();
 
     columns[0] = LIBRARYTABLE_ID;
     columns[1] = LIBRARYTABLE_PREVIEW;
     columns[2] = LIBRARYTABLE_COVERART;
-    setTable(tableName, LIBRARYTABLE_ID, columns,
+    setTable(kCrateLibraryView, LIBRARYTABLE_ID, columns,
              m_pTrackCollection->getTrackSource());
     setSearch("");
     setDefaultSort(fieldIndex("artist"), Qt::AscendingOrder);
 }
 
+QString CrateTableModel::tableFilter() const {
+    const QString sql = CrateMembership::formatTrackIdsSql(
+            m_pTrackCollection->crateMembership().crateTracks(m_selectedCrate),
+            false);
+    if (!sql.isNull()) {
+        return sql;
+    }
+    // Too many scattered tracks to list them literally
+    return QString("%1 IN (%2)").arg(
+            LIBRARYTABLE_ID,
+            CrateStorage::formatSubselectQueryForCrateTrackIds(m_selectedCrate));
+}
+
 bool CrateTableModel::addTrack(const QModelIndex& index, QString location) {
     Q_UNUSED(index);
 
@@ -29,6 +29,9 @@ class CrateTableModel : public BaseSqlTableModel {
     int addTracks(const QModelIndex& index, const QList<QString>& locations) final;
     CapabilitiesFlags getCapabilities() const final;
 
+  protected:
+    QString tableFilter() const final;
+
   private:
     CrateId m_selectedCrate;
 };
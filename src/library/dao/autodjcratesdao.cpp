@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <QtDebug>
 #include <QtSql>
 
@@ -12,30 +14,19 @@
 #include "library/queryutil.h"
 #include "library/trackcollection.h"
 
-#define AUTODJCRATESTABLE_TRACKID "track_id"
-#define AUTODJCRATESTABLE_CRATEREFS "craterefs"
-#define AUTODJCRATESTABLE_TIMESPLAYED "timesplayed"
-#define AUTODJCRATESTABLE_AUTODJREFS "autodjrefs"
-#define AUTODJCRATESTABLE_LASTPLAYED "lastplayed"
-
-#define AUTODJCRATES_TABLE "temp_autodj_crates"
-// A table of all tracks that are assigned to the AutoDJ via a crate
-// Columns:
-// INTEGER AUTODJCRATESTABLE_TRACKID -> Tracks that are member of crate assigned to AutoDj
-// INTEGER AUTODJCRATESTABLE_CRATEREFS -> counts the occurrences of track in auto dj crates
-// INTEGER AUTODJCRATESTABLE_TIMESPLAYED -> library played counter
-// INTEGER AUTODJCRATESTABLE_AUTODJREFS -> counts the occurrences of the track in the AutoDj queue
-// DATETIME AUTODJCRATESTABLE_LASTPLAYED -> from the history feature
-
-#define AUTODJACTIVETRACKS_TABLE "temp_autodj_activetracks"
-// The same table like above, but of all tracks that not already queued into Auto DJ
-// ordered by TimesPlayed.
-
 namespace {
 // Percentage of most and least played tracks to ignore [0,50)
 const int kLeastPreferredPercent = 15;
 const int kLeastPreferredPercentMin = 0;
 const int kLeastPreferredPercentMax = 50;
+
+AutoDJCandidateSet::Order candidateOrder(bool bUseIgnoreTime) {
+    // Tracks that haven't been played in a while are preferred regardless
+    // of the number of times they have been played.
+    return bUseIgnoreTime ?
+            AutoDJCandidateSet::Order::LastPlayed :
+            AutoDJCandidateSet::Order::TimesPlayedThenLastPlayed;
+}
 } // anonymous namespace
 
 AutoDJCratesDAO::AutoDJCratesDAO(
@@ -46,8 +37,8 @@ AutoDJCratesDAO::AutoDJCratesDAO(
           m_pTrackCollection(pTrackCollection),
           m_database(pTrackCollection->database()),
           m_pConfig(pConfig),
-          // The database has not been created yet.
-          m_bAutoDjCratesDbCreated(false),
+          // The candidates have not been loaded yet.
+          m_bAutoDjCandidatesLoaded(false),
           // By default, active tracks are not tracks that haven't been played in
           // a while.
           m_bUseIgnoreTime(false) {
@@ -56,120 +47,56 @@ AutoDJCratesDAO::AutoDJCratesDAO(
 AutoDJCratesDAO::~AutoDJCratesDAO() {
 }
 
-// Create the temporary auto-DJ-crates table.
+// Load the tracks of the auto-DJ crates into memory.
 // Done the first time it's used, since the user might not even make
 // use of this feature.
-void AutoDJCratesDAO::createAndConnectAutoDjCratesDatabase() {
+void AutoDJCratesDAO::loadAndConnectAutoDjCandidates() {
     // If the use of tracks that haven't been played in a while has changed,
-    // then the active-tracks view must be recreated.
+    // then the candidates must be reordered.
     bool bUseIgnoreTime = m_pConfig->getValue(
             ConfigKey("[Auto DJ]", "UseIgnoreTime"), false);
-    if (m_bAutoDjCratesDbCreated) {
-        if (m_bUseIgnoreTime != bUseIgnoreTime) {
-            // Do all this in a single transaction.
-            ScopedTransaction oTransaction(m_database);
-
-            // Get rid of the old active-tracks view.
-            QSqlQuery oQuery(m_database);
-            oQuery.exec ("DROP VIEW IF EXISTS " AUTODJACTIVETRACKS_TABLE);
-            if (!oQuery.exec()) {
-                LOG_FAILED_QUERY(oQuery);
-                return;
-            }
-
-            // Create the new active-tracks view.
-            if (!createActiveTracksView(bUseIgnoreTime)) {
-                return;
-            }
-
-            // Remember the new setting.
-            m_bUseIgnoreTime = bUseIgnoreTime;
-
-            // Commit these changes.
-            oTransaction.commit();
-        }
-    } else {
-        m_bUseIgnoreTime = bUseIgnoreTime;
-    }
+    m_bUseIgnoreTime = bUseIgnoreTime;
+    m_candidates.setOrder(candidateOrder(m_bUseIgnoreTime));
 
-    // If this database has already been created, skip this.
-    if (m_bAutoDjCratesDbCreated) {
+    // If the candidates have already been loaded, skip this.
+    if (m_bAutoDjCandidatesLoaded) {
         return;
     }
 
-    // Do all of this in a single transaction.
-    ScopedTransaction oTransaction(m_database);
-
-    // The auto-DJ-crates table contains the track ID, the number of references
-    // to that track ID in all of the auto-DJ crates, the number of times that
-    // track has been played, and the number of references to the track in the
-    // auto-DJ playlist (or in loaded decks).  It filters out tracks that have
-    // been deleted from the database (i.e. "hidden" tracks).
+    // The candidates are the tracks of all auto-DJ crates, with the number
+    // of references to each track in all of the auto-DJ crates, the number of
+    // times that track has been played, and the number of references to the
+    // track in the auto-DJ playlist (or in loaded decks).  Tracks that have
+    // been deleted from the database (i.e. "hidden" tracks) are filtered out.
+    m_candidates.clear();
+    m_autoDjCrateTracks.clear();
 
-    // Create an empty table.
+    // SELECT id FROM crates WHERE autodj_source = 1;
     QSqlQuery oQuery(m_database);
-    // CREATE TEMP TABLE temp_autodj_crates (track_id INTEGER UNIQUE, craterefs INTEGER, timesplayed INTEGER, autodjrefs INTEGER, lastplayed DATETIME);
-    //oQuery.exec ("DROP TABLE IF EXISTS " AUTODJCRATES_TABLE);
-    QString strQuery("CREATE TEMP TABLE " AUTODJCRATES_TABLE
-        " (" AUTODJCRATESTABLE_TRACKID " INTEGER UNIQUE, "
-        AUTODJCRATESTABLE_CRATEREFS " INTEGER, "
-        AUTODJCRATESTABLE_TIMESPLAYED " INTEGER, "
-        AUTODJCRATESTABLE_AUTODJREFS " INTEGER, "
-        AUTODJCRATESTABLE_LASTPLAYED " DATETIME)");
-    oQuery.prepare(strQuery);
+    oQuery.prepare(QString("SELECT %1 FROM " CRATE_TABLE " WHERE %2 = 1")
+            .arg(CRATETABLE_ID, // %1
+                 CRATETABLE_AUTODJ_SOURCE)); // %2
     if (!oQuery.exec()) {
         LOG_FAILED_QUERY(oQuery);
         return;
     }
-
-    // Fill out the first three columns.
-    // Supply default values for the last two.
-    // INSERT INTO temp_autodj_crates (
-    //     track_id, craterefs, timesplayed, autodjrefs, lastplayed)
-    // SELECT crate_tracks.track_id, COUNT (*), library.timesplayed, 0, ""
-    // FROM crate_tracks, library
-    // WHERE crate_tracks.crate_id IN (
-    //     SELECT id
-    //     FROM crates
-    //     WHERE autodj = 1)
-    // AND crate_tracks.track_id = library.id
-    // AND library.mixxx_deleted = 0
-    // GROUP BY crate_tracks.track_id, library.timesplayed;
-    strQuery = QString("INSERT INTO " AUTODJCRATES_TABLE
-            " (" AUTODJCRATESTABLE_TRACKID ", " AUTODJCRATESTABLE_CRATEREFS ", "
-            AUTODJCRATESTABLE_TIMESPLAYED ", " AUTODJCRATESTABLE_AUTODJREFS ", "
-            AUTODJCRATESTABLE_LASTPLAYED ") SELECT " CRATE_TRACKS_TABLE
-            ".%1 , COUNT (*), " LIBRARY_TABLE ".%2, 0, \"\" FROM "
-            CRATE_TRACKS_TABLE ", " LIBRARY_TABLE " WHERE " CRATE_TRACKS_TABLE
-            ".%4 IN (SELECT %5 FROM " CRATE_TABLE " WHERE %6 = 1) AND "
-            CRATE_TRACKS_TABLE ".%1 = " LIBRARY_TABLE ".%7 AND " LIBRARY_TABLE
-            ".%3 == 0 GROUP BY " CRATE_TRACKS_TABLE ".%1, " LIBRARY_TABLE ".%2")
-                .arg(CRATETRACKSTABLE_TRACKID, // %1
-                     LIBRARYTABLE_TIMESPLAYED, // %2
-                     LIBRARYTABLE_MIXXXDELETED, // %3
-                     CRATETRACKSTABLE_CRATEID, // %4
-                     CRATETABLE_ID, // %5
-                     CRATETABLE_AUTODJ_SOURCE, // %6
-                     LIBRARYTABLE_ID); // %7
-    oQuery.prepare(strQuery);
-    if (!oQuery.exec()) {
-        LOG_FAILED_QUERY(oQuery);
-        return;
+    QList<CrateId> autoDjCrateIds;
+    while (oQuery.next()) {
+        autoDjCrateIds.append(CrateId(oQuery.value(0)));
+    }
+    for (const auto& crateId : autoDjCrateIds) {
+        addAutoDjCrateTracks(crateId);
     }
 
+    const QSet<TrackId> trackIds = m_candidates.trackIds().toSet();
+
     // Fill out the number of auto-DJ-playlist references.
-    if (!updateAutoDjPlaylistReferences()) {
+    if (!updateAutoDjPlaylistReferences(trackIds)) {
         return;
     }
 
     // Fill out the last-played date/time.
-    if (!updateLastPlayedDateTime()) {
-        return;
-    }
-
-    // Create the active-tracks view.
-    //oQuery.exec ("DROP VIEW IF EXISTS " AUTODJACTIVETRACKS_TABLE);
-    if (!createActiveTracksView (m_bUseIgnoreTime)) {
+    if (!updateLastPlayedDateTime(trackIds)) {
         return;
     }
 
@@ -187,10 +114,8 @@ void AutoDJCratesDAO::createAndConnectAutoDjCratesDatabase() {
         return;
     }
 
-    // Now the auto-DJ crates database is initialized.
-    // Externally-driven updates to the database from now on are driven by
-    // signals.
-    oTransaction.commit();
+    // Now the candidates are initialized.
+    // Externally-driven updates from now on are driven by signals.
 
     // Be notified when a track is modified.
     // We only care when the number of times it's been played changes.
@@ -230,271 +155,204 @@ void AutoDJCratesDAO::createAndConnectAutoDjCratesDatabase() {
             SIGNAL(trackUnloaded(QString,TrackPointer)),
             this, SLOT(slotPlayerInfoTrackUnloaded(QString,TrackPointer)));
 
-    // Remember that the auto-DJ-crates database has been created.
-    m_bAutoDjCratesDbCreated = true;
+    // Remember that the candidates have been loaded.
+    m_bAutoDjCandidatesLoaded = true;
 }
 
-// Create the active-tracks view.
-bool AutoDJCratesDAO::createActiveTracksView (bool a_bUseIgnoreTime) {
-    // Create the active-tracks view.  This is a list of all tracks loaded into
-    // the auto-DJ-crates database, excluding all tracks already in the auto-DJ
-    // playlist, sorted by the number of times the track has been played, and
-    // limited by either the active percentage or by the number of tracks that
-    // have never been played, whichever is larger.
-    //
-    // At one point, I hoped that I could create this table in a single SQL
-    // statement, with a "limit" clause that dynamically updated the size of the
-    // view as the state of the system changed.  Unfortunately, that limit
-    // clause is only evaluated once.  For posterity, though, here's the monster
-    // SQL query that attempted to create that version:
-    //
-    // CREATE TEMP VIEW temp_autodj_activetracks AS
-    //     SELECT * FROM temp_autodj_crates
-    //     WHERE autodjrefs = 0
-    //     ORDER BY timesplayed, lastplayed LIMIT (
-    //         SELECT MAX(count)
-    //         FROM (
-    //             SELECT COUNT(*) AS count
-    //             FROM temp_autodj_crates WHERE timesplayed = 0
-    //             UNION ALL SELECT (
-    //                 count * (
-    //                     SELECT value
-    //                     FROM settings WHERE
-    //                     name="mixxx.db.model.autodjcrates.active_percentage")
-    //                 / 100) AS count
-    //                 FROM (
-    //                     SELECT COUNT(*) AS count
-    //                     FROM temp_autodj_crates)));
-
-    // CREATE TEMP VIEW temp_autodj_activetracks AS
-    // SELECT *
-    // FROM temp_autodj_crates
-    // WHERE autodjrefs = 0
-    // ORDER BY timesplayed, lastplayed;
+QSet<TrackId> AutoDJCratesDAO::addAutoDjCrateTracks(CrateId crateId) {
+    QSet<TrackId>& crateTrackIds = m_autoDjCrateTracks[crateId];
+    QSet<TrackId> newTrackIds;
+
+    // SELECT crate_tracks.track_id, library.timesplayed
+    // FROM crate_tracks, library
+    // WHERE crate_tracks.crate_id = :crate_id
+    // AND crate_tracks.track_id = library.id
+    // AND library.mixxx_deleted = 0;
     QSqlQuery oQuery(m_database);
-    QString strTimesPlayed;
-    if (!a_bUseIgnoreTime) {
-        strTimesPlayed = AUTODJCRATESTABLE_TIMESPLAYED ", ";
-    }
-    oQuery.prepare(QString("CREATE TEMP VIEW " AUTODJACTIVETRACKS_TABLE
-            " AS SELECT * FROM " AUTODJCRATES_TABLE " WHERE "
-            AUTODJCRATESTABLE_AUTODJREFS " = 0 ORDER BY %1"
-            AUTODJCRATESTABLE_LASTPLAYED)
-            .arg(strTimesPlayed)); // %1
+    oQuery.setForwardOnly(true);
+    oQuery.prepare(QString("SELECT " CRATE_TRACKS_TABLE ".%1, " LIBRARY_TABLE
+            ".%2 FROM " CRATE_TRACKS_TABLE ", " LIBRARY_TABLE " WHERE "
+            CRATE_TRACKS_TABLE ".%3 = :crate_id AND " CRATE_TRACKS_TABLE
+            ".%1 = " LIBRARY_TABLE ".%4 AND " LIBRARY_TABLE ".%5 = 0")
+            .arg(CRATETRACKSTABLE_TRACKID, // %1
+                 LIBRARYTABLE_TIMESPLAYED, // %2
+                 CRATETRACKSTABLE_CRATEID, // %3
+                 LIBRARYTABLE_ID, // %4
+                 LIBRARYTABLE_MIXXXDELETED)); // %5
+    oQuery.bindValue(":crate_id", crateId.toVariant());
     if (!oQuery.exec()) {
         LOG_FAILED_QUERY(oQuery);
-        return false;
+        return newTrackIds;
     }
-    return true;
+    while (oQuery.next()) {
+        TrackId trackId(oQuery.value(0));
+        if (crateTrackIds.contains(trackId)) {
+            continue;
+        }
+        crateTrackIds.insert(trackId);
+        if (m_candidates.addCrateRef(trackId, oQuery.value(1).toInt())) {
+            newTrackIds.insert(trackId);
+        }
+    }
+    return newTrackIds;
 }
 
-// Update the number of auto-DJ-playlist references to each track in the
-// auto-DJ-crates database.
-bool AutoDJCratesDAO::updateAutoDjPlaylistReferences() {
-    QSqlQuery oQuery(m_database);
+// Update the number of auto-DJ-playlist references to the given tracks.
+bool AutoDJCratesDAO::updateAutoDjPlaylistReferences(const QSet<TrackId>& trackIds) {
+    if (trackIds.isEmpty()) {
+        return true;
+    }
 
-    // Rebuild the auto-DJ-playlist reference count.
-    // INSERT OR REPLACE INTO temp_autodj_crates (
-    //     track_id, craterefs, timesplayed, autodjrefs)
-    // SELECT *
-    // FROM (
-    //     SELECT PlaylistTracks.track_id, craterefs, timesplayed, COUNT (*) AS newautodjrefs
-    //     FROM PlaylistTracks, temp_autodj_crates
-    //     WHERE PlaylistTracks.playlist_id IN (
-    //         SELECT id FROM Playlists WHERE hidden = PLHT_AUTO_DJ)
-    //     AND PlaylistTracks.track_id = temp_autodj_crates.track_id
-    //     GROUP BY PlaylistTracks.track_id)
-    // WHERE newautodjrefs > 0;
-    QString strHidden;
-    strHidden.setNum(PlaylistDAO::PLHT_AUTO_DJ);
-    QString strQuery(QString ("INSERT OR REPLACE INTO " AUTODJCRATES_TABLE
-            " (" AUTODJCRATESTABLE_TRACKID ", " AUTODJCRATESTABLE_CRATEREFS ", "
-            AUTODJCRATESTABLE_TIMESPLAYED ", " AUTODJCRATESTABLE_AUTODJREFS ")"
-            " SELECT * FROM (SELECT " PLAYLIST_TRACKS_TABLE ".%1, "
-            AUTODJCRATESTABLE_CRATEREFS ", " AUTODJCRATESTABLE_TIMESPLAYED
-            ", COUNT (*) AS new" AUTODJCRATESTABLE_AUTODJREFS " FROM "
-            PLAYLIST_TRACKS_TABLE ", " AUTODJCRATES_TABLE " WHERE "
-            PLAYLIST_TRACKS_TABLE ".%2 IN (SELECT %3 FROM " PLAYLIST_TABLE
-            " WHERE %4 = %5) AND " PLAYLIST_TRACKS_TABLE ".%1 = "
-            AUTODJCRATES_TABLE "." AUTODJCRATESTABLE_TRACKID " GROUP BY "
-            PLAYLIST_TRACKS_TABLE ".%1) WHERE new" AUTODJCRATESTABLE_AUTODJREFS
-            " > 0")
+    // The auto-DJ playlist is small compared to the crates, so count the
+    // references to all of its tracks and skip the others.
+    // SELECT track_id, COUNT (*)
+    // FROM PlaylistTracks
+    // WHERE playlist_id IN (
+    //     SELECT id FROM Playlists WHERE hidden = PLHT_AUTO_DJ)
+    // GROUP BY track_id;
+    QSqlQuery oQuery(m_database);
+    oQuery.setForwardOnly(true);
+    oQuery.prepare(QString("SELECT %1, COUNT (*) FROM " PLAYLIST_TRACKS_TABLE
+            " WHERE %2 IN (SELECT %3 FROM " PLAYLIST_TABLE " WHERE %4 = %5)"
+            " GROUP BY %1")
             .arg(PLAYLISTTRACKSTABLE_TRACKID, // %1
                  PLAYLISTTRACKSTABLE_PLAYLISTID, // %2
                  PLAYLISTTABLE_ID, // %3
                  PLAYLISTTABLE_HIDDEN, // %4
-                 strHidden)); // %5
-    oQuery.prepare(strQuery);
+                 QString::number(PlaylistDAO::PLHT_AUTO_DJ))); // %5
     if (!oQuery.exec()) {
         LOG_FAILED_QUERY(oQuery);
         return false;
     }
+    while (oQuery.next()) {
+        TrackId trackId(oQuery.value(0));
+        if (trackIds.contains(trackId)) {
+            m_candidates.setAutoDjRefs(trackId, oQuery.value(1).toInt());
+        }
+    }
 
     // Incorporate all tracks loaded into decks.
-    // Each track has to be done as a separate database query, in case the same
-    // track is loaded into multiple decks.
     int iDecks = (int) PlayerManager::numDecks();
     for (int i = 0; i < iDecks; ++i) {
         QString group = PlayerManager::groupForDeck(i);
         TrackPointer pTrack = PlayerInfo::instance().getTrackInfo(group);
-        if (pTrack) {
-            TrackId trackId(pTrack->getId());
-            // UPDATE temp_autodj_crates SET autodjrefs = autodjrefs + 1 WHERE track_id IN (:track_id);
-            oQuery.prepare("UPDATE " AUTODJCRATES_TABLE " SET "
-                    AUTODJCRATESTABLE_AUTODJREFS " = " AUTODJCRATESTABLE_AUTODJREFS
-                    " + 1 WHERE " AUTODJCRATESTABLE_TRACKID " IN (:track_id)");
-            oQuery.bindValue(":track_id", trackId.toVariant());
-            if (!oQuery.exec()) {
-                LOG_FAILED_QUERY(oQuery);
-                return false;
-            }
+        if (pTrack && trackIds.contains(pTrack->getId())) {
+            m_candidates.addAutoDjRef(pTrack->getId());
         }
     }
     return true;
 }
 
-// Update the number of auto-DJ-playlist references to the given track in the
-// auto-DJ-crates database.
+// Update the number of auto-DJ-playlist references to the given track.
 bool AutoDJCratesDAO::updateAutoDjPlaylistReferencesForTrack(TrackId trackId) {
-    QSqlQuery oQuery(m_database);
+    if (!m_candidates.contains(trackId)) {
+        return true;
+    }
 
-    // INSERT OR REPLACE INTO temp_autodj_crates (
-    //     track_id, craterefs, timesplayed, autodjrefs)
-    // SELECT *
-    // FROM (
-    //     SELECT :track_id AS new_track_id, craterefs, timesplayed, COUNT (*) AS newautodjrefs
-    //     FROM PlaylistTracks, temp_autodj_crates
-    //     WHERE PlaylistTracks.playlist_id IN (
-    //         SELECT id
-    //         FROM Playlists
-    //         WHERE hidden = 1)
-    //     AND PlaylistTracks.track_id = :track_id
-    //     AND temp_autodj_crates.track_id = :track_id
-    //     GROUP BY new_track_id)
-    // WHERE newautodjrefs > 0;
-    QString strHidden;
-    strHidden.setNum(PlaylistDAO::PLHT_AUTO_DJ);
-    oQuery.prepare(QString("INSERT OR REPLACE INTO " AUTODJCRATES_TABLE " ("
-            AUTODJCRATESTABLE_TRACKID ", " AUTODJCRATESTABLE_CRATEREFS ", "
-            AUTODJCRATESTABLE_TIMESPLAYED ", " AUTODJCRATESTABLE_AUTODJREFS
-            ") SELECT * FROM (SELECT :track_id_1 AS new_track_id, "
-            AUTODJCRATESTABLE_CRATEREFS ", " AUTODJCRATESTABLE_TIMESPLAYED
-            ", COUNT (*) AS new" AUTODJCRATESTABLE_AUTODJREFS " FROM "
-            PLAYLIST_TRACKS_TABLE ", " AUTODJCRATES_TABLE " WHERE "
-            PLAYLIST_TRACKS_TABLE ".%1 IN (SELECT %4 FROM " PLAYLIST_TABLE
-            " WHERE %2 = %5) AND " PLAYLIST_TRACKS_TABLE ".%3 = :track_id_2 AND "
-            AUTODJCRATES_TABLE "." AUTODJCRATESTABLE_TRACKID
-            " = :track_id_3 GROUP BY new_track_id) WHERE new"
-            AUTODJCRATESTABLE_AUTODJREFS " > 0")
+    // SELECT COUNT (*)
+    // FROM PlaylistTracks
+    // WHERE playlist_id IN (
+    //     SELECT id FROM Playlists WHERE hidden = PLHT_AUTO_DJ)
+    // AND track_id = :track_id;
+    QSqlQuery oQuery(m_database);
+    oQuery.prepare(QString("SELECT COUNT (*) FROM " PLAYLIST_TRACKS_TABLE
+            " WHERE %1 IN (SELECT %2 FROM " PLAYLIST_TABLE " WHERE %3 = %4)"
+            " AND %5 = :track_id")
             .arg(PLAYLISTTRACKSTABLE_PLAYLISTID, // %1
-                 PLAYLISTTABLE_HIDDEN, // %2
-                 PLAYLISTTRACKSTABLE_TRACKID, // %3
-                 PLAYLISTTABLE_ID, // %4
-                 strHidden)); // %5
-    oQuery.bindValue(":track_id_1", trackId.toVariant());
-    oQuery.bindValue(":track_id_2", trackId.toVariant());
-    oQuery.bindValue(":track_id_3", trackId.toVariant());
-    if (!oQuery.exec()) {
+                 PLAYLISTTABLE_ID, // %2
+                 PLAYLISTTABLE_HIDDEN, // %3
+                 QString::number(PlaylistDAO::PLHT_AUTO_DJ), // %4
+                 PLAYLISTTRACKSTABLE_TRACKID)); // %5
+    oQuery.bindValue(":track_id", trackId.toVariant());
+    if (!oQuery.exec() || !oQuery.next()) {
         LOG_FAILED_QUERY(oQuery);
         return false;
     }
+    int iAutoDjRefs = oQuery.value(0).toInt();
+
+    // Incorporate all decks that have loaded the track.
+    int iDecks = (int) PlayerManager::numDecks();
+    for (int i = 0; i < iDecks; ++i) {
+        QString group = PlayerManager::groupForDeck(i);
+        TrackPointer pTrack = PlayerInfo::instance().getTrackInfo(group);
+        if (pTrack && pTrack->getId() == trackId) {
+            ++iAutoDjRefs;
+        }
+    }
+    m_candidates.setAutoDjRefs(trackId, iAutoDjRefs);
 
     // The update was successful.
     return true;
 }
 
-// Update the last-played date/time for each track in the auto-DJ-crates
-// database.
-bool AutoDJCratesDAO::updateLastPlayedDateTime() {
-    QSqlQuery oQuery(m_database);
+// Update the last-played date/time for the given tracks.
+bool AutoDJCratesDAO::updateLastPlayedDateTime(const QSet<TrackId>& trackIds) {
+    if (trackIds.isEmpty()) {
+        return true;
+    }
+
+    // Tracks that are not in any set-log playlist anymore
+    for (const auto& trackId : trackIds) {
+        m_candidates.setLastPlayed(trackId, QString());
+    }
 
-    // Rebuild the auto-DJ-playlist last-played date/time.
-    // INSERT OR REPLACE INTO temp_autodj_crates (
-    //     track_id, craterefs, timesplayed, autodjrefs, lastplayed)
-    // SELECT *
-    // FROM (
-    //     SELECT PlaylistTracks.track_id, craterefs, timesplayed, autodjrefs, MAX(pl_datetime_added) AS newlastplayed
-    //     FROM PlaylistTracks, temp_autodj_crates
-    //     WHERE PlaylistTracks.playlist_id IN (
-    //         SELECT id FROM Playlists WHERE hidden = PLHT_SET_LOG)
-    //     AND PlaylistTracks.track_id = temp_autodj_crates.track_id
-    //     GROUP BY PlaylistTracks.track_id)
-    // WHERE newlastplayed != "";
-    QString strSetLog;
-    strSetLog.setNum(PlaylistDAO::PLHT_SET_LOG);
-    QString strQuery(QString ("INSERT OR REPLACE INTO " AUTODJCRATES_TABLE
-            " (" AUTODJCRATESTABLE_TRACKID ", " AUTODJCRATESTABLE_CRATEREFS ", "
-            AUTODJCRATESTABLE_TIMESPLAYED ", " AUTODJCRATESTABLE_AUTODJREFS ", "
-            AUTODJCRATESTABLE_LASTPLAYED ")"
-            " SELECT * FROM (SELECT " PLAYLIST_TRACKS_TABLE ".%1, "
-            AUTODJCRATESTABLE_CRATEREFS ", " AUTODJCRATESTABLE_TIMESPLAYED ", "
-            AUTODJCRATESTABLE_AUTODJREFS ", MAX(%3) AS new"
-            AUTODJCRATESTABLE_LASTPLAYED " FROM " PLAYLIST_TRACKS_TABLE ", "
-            AUTODJCRATES_TABLE " WHERE " PLAYLIST_TRACKS_TABLE
-            ".%2 IN (SELECT %4 FROM " PLAYLIST_TABLE " WHERE %5 = %6) AND "
-            PLAYLIST_TRACKS_TABLE ".%1 = " AUTODJCRATES_TABLE "."
-            AUTODJCRATESTABLE_TRACKID " GROUP BY " PLAYLIST_TRACKS_TABLE
-            ".%1) WHERE new" AUTODJCRATESTABLE_LASTPLAYED " != \"\"")
+    // SELECT track_id, MAX(pl_datetime_added)
+    // FROM PlaylistTracks
+    // WHERE playlist_id IN (
+    //     SELECT id FROM Playlists WHERE hidden = PLHT_SET_LOG)
+    // GROUP BY track_id;
+    QSqlQuery oQuery(m_database);
+    oQuery.setForwardOnly(true);
+    oQuery.prepare(QString("SELECT %1, MAX(%2) FROM " PLAYLIST_TRACKS_TABLE
+            " WHERE %3 IN (SELECT %4 FROM " PLAYLIST_TABLE " WHERE %5 = %6)"
+            " GROUP BY %1")
             .arg(PLAYLISTTRACKSTABLE_TRACKID, // %1
-                 PLAYLISTTRACKSTABLE_PLAYLISTID, // %2
-                 PLAYLISTTRACKSTABLE_DATETIMEADDED, // %3
+                 PLAYLISTTRACKSTABLE_DATETIMEADDED, // %2
+                 PLAYLISTTRACKSTABLE_PLAYLISTID, // %3
                  PLAYLISTTABLE_ID, // %4
                  PLAYLISTTABLE_HIDDEN, // %5
-                 strSetLog)); // %6
-    oQuery.prepare(strQuery);
+                 QString::number(PlaylistDAO::PLHT_SET_LOG))); // %6
     if (!oQuery.exec()) {
         LOG_FAILED_QUERY(oQuery);
         return false;
     }
+    while (oQuery.next()) {
+        TrackId trackId(oQuery.value(0));
+        if (trackIds.contains(trackId)) {
+            m_candidates.setLastPlayed(trackId, oQuery.value(1).toString());
+        }
+    }
 
     return true;
 }
 
-// Update the last-played date/time for the given track in the auto-DJ-crates
-// database.
+// Update the last-played date/time for the given track.
 bool AutoDJCratesDAO::updateLastPlayedDateTimeForTrack(TrackId trackId) {
-    QSqlQuery oQuery(m_database);
+    if (!m_candidates.contains(trackId)) {
+        return true;
+    }
 
-    // Update the last-played date/time for this track.
-    // INSERT OR REPLACE INTO temp_autodj_crates (
-    //     track_id, craterefs, timesplayed, autodjrefs, lastplayed)
-    // SELECT *
-    // FROM (
-    //     SELECT PlaylistTracks.track_id, craterefs, timesplayed, autodjrefs, MAX(pl_datetime_added) AS newlastplayed
-    //     FROM PlaylistTracks, temp_autodj_crates
-    //     WHERE PlaylistTracks.playlist_id IN (
-    //         SELECT id FROM Playlists WHERE hidden = PLHT_SET_LOG)
-    //     AND PlaylistTracks.track_id = :track_id
-    //     AND PlaylistTracks.track_id = temp_autodj_crates.track_id
-    //     GROUP BY PlaylistTracks.track_id)
-    // WHERE newlastplayed != "";
-    QString strSetLog;
-    strSetLog.setNum(PlaylistDAO::PLHT_SET_LOG);
-    oQuery.prepare(QString ("INSERT OR REPLACE INTO " AUTODJCRATES_TABLE
-            " (" AUTODJCRATESTABLE_TRACKID ", " AUTODJCRATESTABLE_CRATEREFS ", "
-            AUTODJCRATESTABLE_TIMESPLAYED ", " AUTODJCRATESTABLE_AUTODJREFS ", "
-            AUTODJCRATESTABLE_LASTPLAYED ")"
-            " SELECT * FROM (SELECT " PLAYLIST_TRACKS_TABLE ".%1, "
-            AUTODJCRATESTABLE_CRATEREFS ", " AUTODJCRATESTABLE_TIMESPLAYED ", "
-            AUTODJCRATESTABLE_AUTODJREFS ", MAX(%3) AS new"
-            AUTODJCRATESTABLE_LASTPLAYED " FROM " PLAYLIST_TRACKS_TABLE ", "
-            AUTODJCRATES_TABLE " WHERE " PLAYLIST_TRACKS_TABLE
-            ".%2 IN (SELECT %4 FROM " PLAYLIST_TABLE " WHERE %5 = %6) AND "
-            PLAYLIST_TRACKS_TABLE ".%1 = :track_id AND " PLAYLIST_TRACKS_TABLE
-            ".%1 = " AUTODJCRATES_TABLE "." AUTODJCRATESTABLE_TRACKID
-            " GROUP BY " PLAYLIST_TRACKS_TABLE ".%1) WHERE new"
-            AUTODJCRATESTABLE_LASTPLAYED " != \"\"")
-            .arg(PLAYLISTTRACKSTABLE_TRACKID, // %1
+    // SELECT MAX(pl_datetime_added)
+    // FROM PlaylistTracks
+    // WHERE playlist_id IN (
+    //     SELECT id FROM Playlists WHERE hidden = PLHT_SET_LOG)
+    // AND track_id = :track_id;
+    QSqlQuery oQuery(m_database);
+    oQuery.prepare(QString("SELECT MAX(%1) FROM " PLAYLIST_TRACKS_TABLE
+            " WHERE %2 IN (SELECT %3 FROM " PLAYLIST_TABLE " WHERE %4 = %5)"
+            " AND %6 = :track_id")
+            .arg(PLAYLISTTRACKSTABLE_DATETIMEADDED, // %1
                  PLAYLISTTRACKSTABLE_PLAYLISTID, // %2
-                 PLAYLISTTRACKSTABLE_DATETIMEADDED, // %3
-                 PLAYLISTTABLE_ID, // %4
-                 PLAYLISTTABLE_HIDDEN, // %5
-                 strSetLog)); // %6
+                 PLAYLISTTABLE_ID, // %3
+                 PLAYLISTTABLE_HIDDEN, // %4
+                 QString::number(PlaylistDAO::PLHT_SET_LOG), // %5
+                 PLAYLISTTRACKSTABLE_TRACKID)); // %6
     oQuery.bindValue(":track_id", trackId.toVariant());
-    if (!oQuery.exec()) {
+    if (!oQuery.exec() || !oQuery.next()) {
         LOG_FAILED_QUERY(oQuery);
         return false;
     }
+    m_candidates.setLastPlayed(trackId, oQuery.value(0).toString());
 
     // The update was successful.
     return true;
@@ -503,33 +361,13 @@ bool AutoDJCratesDAO::updateLastPlayedDateTimeForTrack(TrackId trackId) {
 // Get the ID, i.e. one that references library.id, of a random track.
 // Returns an invalid track id if there was an error.
 TrackId AutoDJCratesDAO::getRandomTrackId() {
-    // If necessary, create the temporary auto-DJ-crates database.
-    createAndConnectAutoDjCratesDatabase();
+    // If necessary, load the candidates.
+    loadAndConnectAutoDjCandidates();
 
-    // Calculate the number of active-tracks that have never been played, and
+    // The number of active-tracks that have never been played, and
     // the total number of active-tracks.
-    QSqlQuery oQuery(m_database);
-    // SELECT COUNT(*) AS count
-    // FROM temp_autodj_activetracks
-    // WHERE timesplayed = 0
-    // UNION ALL SELECT COUNT(*) AS count
-    // FROM temp_autodj_activetracks;
-    oQuery.prepare("SELECT COUNT(*) AS count FROM " AUTODJACTIVETRACKS_TABLE
-        " WHERE " AUTODJCRATESTABLE_TIMESPLAYED
-        " = 0 UNION ALL SELECT COUNT(*) AS count FROM "
-        AUTODJACTIVETRACKS_TABLE);
-    VERIFY_OR_DEBUG_ASSERT(oQuery.exec()) {
-        LOG_FAILED_QUERY(oQuery);
-        return TrackId();
-    }
-    int iUnplayedTracks = 0;
-    int iTotalTracks = 0;
-    if (oQuery.next()) {
-        iUnplayedTracks = oQuery.value(0).toInt();
-        if (oQuery.next()) {
-            iTotalTracks = oQuery.value(0).toInt();
-        }
-    }
+    int iUnplayedTracks = m_candidates.availableUnplayedCount();
+    int iTotalTracks = m_candidates.availableCount();
 
     // Get the active percentage (default 20%).
     int minimumAvailablePercentage = m_pConfig->getValue(
@@ -569,19 +407,7 @@ TrackId AutoDJCratesDAO::getRandomTrackId() {
         QString strDateTime = timeCurrent.toString("yyyy-MM-dd hh:mm:ss");
 
         // Count the number of tracks that haven't been played since this time.
-        // SELECT COUNT(*) FROM temp_autodj_activetracks WHERE lastplayed < :lastplayed;
-        int iIgnoreTimeTracks = 0;
-        oQuery.prepare("SELECT COUNT(*) FROM " AUTODJACTIVETRACKS_TABLE
-            " WHERE " AUTODJCRATESTABLE_LASTPLAYED " < :lastplayed");
-        oQuery.bindValue (":lastplayed", strDateTime);
-        if (oQuery.exec()) {
-            if (oQuery.next()) {
-                iIgnoreTimeTracks = oQuery.value(0).toInt();
-            }
-        } else {
-            LOG_FAILED_QUERY(oQuery);
-            return TrackId();
-        }
+        int iIgnoreTimeTracks = m_candidates.availableLastPlayedBefore(strDateTime);
 
         // Allow that to be a new maximum.
         iActiveTracks = qMax(iActiveTracks, iIgnoreTimeTracks);
@@ -595,24 +421,8 @@ TrackId AutoDJCratesDAO::getRandomTrackId() {
         return TrackId();
     }
 
-    // Pick a random track.
-    // SELECT track_id
-    // FROM temp_autodj_activetracks LIMIT 1 OFFSET ABS (RANDOM() % :active);
-    oQuery.prepare("SELECT " AUTODJCRATESTABLE_TRACKID " FROM "
-        AUTODJACTIVETRACKS_TABLE " LIMIT 1 OFFSET ABS (RANDOM() % :active)");
-    oQuery.bindValue (":active", iActiveTracks);
-    VERIFY_OR_DEBUG_ASSERT(oQuery.exec()) {
-        LOG_FAILED_QUERY(oQuery);
-        return TrackId();
-    }
-    if (oQuery.next()) {
-        // Give our caller the randomly-selected track.
-        return TrackId(oQuery.value(0));
-    } else {
-        DEBUG_ASSERT(false); // We should have exit earlier
-        qDebug() << "No random track available for Auto DJ";
-        return TrackId();
-    }
+    // Pick a random track among the least played active-tracks.
+    return m_candidates.pickAvailable(iActiveTracks);
 }
 
 TrackId AutoDJCratesDAO::getRandomTrackIdFromAutoDj(int percentActive) {
@@ -623,22 +433,9 @@ TrackId AutoDJCratesDAO::getRandomTrackIdFromAutoDj(int percentActive) {
         return TrackId();
     }
 
-    // Calculate the number of tracks in the AutoDJ playlist
+    // The number of tracks in the AutoDJ playlist
     // that are already queued up from the crates
-    QSqlQuery oQuery(m_database);
-    // SELECT COUNT(*) AS count
-    // FROM temp_autodj_crates
-    // WHERE autodjrefs > 0;
-    oQuery.prepare("SELECT COUNT(*) AS count FROM " AUTODJCRATES_TABLE
-        " WHERE " AUTODJCRATESTABLE_AUTODJREFS " > 0" );
-    VERIFY_OR_DEBUG_ASSERT(oQuery.exec()) {
-        LOG_FAILED_QUERY(oQuery);
-        return TrackId();
-    }
-    VERIFY_OR_DEBUG_ASSERT(oQuery.next()) {
-        return TrackId();
-    }
-    int queuedTracks = oQuery.value(0).toInt();
+    int queuedTracks = m_candidates.queuedCount();
 
     // If there are no tracks, let our caller know.
     if (queuedTracks == 0) {
@@ -649,36 +446,42 @@ TrackId AutoDJCratesDAO::getRandomTrackIdFromAutoDj(int percentActive) {
     // Use the top percentage of the AutoDJ to re-add
     int iActiveTracks = qMax((queuedTracks * percentActive / 100), 1);
 
-    // Pick a random track.
-    // SELECT DISTINCT track_id
-    // FROM temp_autodj_crates INNER JOIN Playlists
-    // ON temp_autodj_crates.track_id = PlaylistsTracks.track_id
-    // AND PlaylistsTracks.playlist_id = m_iAutoDjPlaylistId
-    // ORDER BY temp_autodj_crates.autodjrefs, PlaylistsTracks.position
-    // LIMIT 1 OFFSET ABS (RANDOM() % :active);
-    oQuery.prepare(QString("SELECT DISTINCT " AUTODJCRATES_TABLE "."
-            AUTODJCRATESTABLE_TRACKID " FROM "
-            AUTODJCRATES_TABLE " INNER JOIN " PLAYLIST_TRACKS_TABLE
-            " ON " AUTODJCRATES_TABLE "." AUTODJCRATESTABLE_TRACKID
-            " = " PLAYLIST_TRACKS_TABLE ".%1"
-            " AND " PLAYLIST_TRACKS_TABLE ".%2 = %3"
-            " ORDER BY " AUTODJCRATES_TABLE "." AUTODJCRATESTABLE_AUTODJREFS ", "
-            PLAYLIST_TRACKS_TABLE ".%4"
-            " LIMIT 1 OFFSET ABS (RANDOM() % :active)")
+    // The crate tracks in the AutoDJ playlist, ordered by the number of
+    // references and their position.
+    // SELECT track_id
+    // FROM PlaylistTracks
+    // WHERE playlist_id = m_iAutoDjPlaylistId
+    // ORDER BY position;
+    QSqlQuery oQuery(m_database);
+    oQuery.prepare(QString("SELECT %1 FROM " PLAYLIST_TRACKS_TABLE
+            " WHERE %2 = %3 ORDER BY %4")
             .arg(PLAYLISTTRACKSTABLE_TRACKID, // %1
                  PLAYLISTTRACKSTABLE_PLAYLISTID, // %2
                  QString::number(m_iAutoDjPlaylistId), // %3
-                 PLAYLISTTABLE_POSITION)); // %4
-    oQuery.bindValue (":active", iActiveTracks);
+                 PLAYLISTTRACKSTABLE_POSITION)); // %4
     VERIFY_OR_DEBUG_ASSERT(oQuery.exec()) {
         LOG_FAILED_QUERY(oQuery);
         return TrackId();
     }
-    if (oQuery.next()) {
+    QList<TrackId> queuedTrackIds;
+    QSet<TrackId> distinctTrackIds;
+    while (oQuery.next()) {
+        TrackId trackId(oQuery.value(0));
+        if (m_candidates.contains(trackId) && !distinctTrackIds.contains(trackId)) {
+            distinctTrackIds.insert(trackId);
+            queuedTrackIds.append(trackId);
+        }
+    }
+    std::stable_sort(queuedTrackIds.begin(), queuedTrackIds.end(),
+            [this](TrackId lhs, TrackId rhs) {
+                return m_candidates.find(lhs)->autoDjRefs <
+                        m_candidates.find(rhs)->autoDjRefs;
+            });
+    iActiveTracks = qMin(iActiveTracks, queuedTrackIds.size());
+    if (iActiveTracks > 0) {
         // Give our caller the randomly-selected track.
-        return TrackId(oQuery.value(0));
+        return queuedTrackIds.at(qrand() % iActiveTracks);
     } else {
-        DEBUG_ASSERT(false); // We should have exit earlier
         qDebug() << "No random track available for Auto DJ";
         return TrackId();
     }
@@ -688,33 +491,16 @@ TrackId AutoDJCratesDAO::getRandomTrackIdFromAutoDj(int percentActive) {
 
 // Signaled by the track DAO when a track's information is updated.
 void AutoDJCratesDAO::slotTrackDirty(TrackId trackId) {
+    if (!m_candidates.contains(trackId)) {
+        return;
+    }
     // Update our record of the number of times played, if that changed.
     TrackPointer pTrack = m_pTrackCollection->getTrackDAO().getTrack(trackId);
     if (pTrack == NULL) {
         return;
     }
     const PlayCounter playCounter(pTrack->getPlayCounter());
-    if (playCounter.getTimesPlayed() == 0) {
-        return;
-    }
-
-    // Update our record of how many times this track has been played.
-    // UPDATE temp_autodj_crates
-    // SET timesplayed = :newplayed
-    // WHERE track_id = :track_id
-    // AND timesplayed = :oldplayed;
-    QSqlQuery oQuery(m_database);
-    oQuery.prepare("UPDATE " AUTODJCRATES_TABLE " SET "
-            AUTODJCRATESTABLE_TIMESPLAYED " = :newplayed WHERE "
-            AUTODJCRATESTABLE_TRACKID " = :track_id AND "
-            AUTODJCRATESTABLE_TIMESPLAYED " = :oldplayed");
-    oQuery.bindValue(":track_id", trackId.toVariant());
-    oQuery.bindValue(":oldplayed", playCounter.getTimesPlayed() - 1);
-    oQuery.bindValue(":newplayed", playCounter.getTimesPlayed());
-    if (!oQuery.exec()) {
-        LOG_FAILED_QUERY(oQuery);
-        return;
-    }
+    m_candidates.setTimesPlayed(trackId, playCounter.getTimesPlayed());
 }
 
 void AutoDJCratesDAO::slotCrateInserted(CrateId crateId) {
@@ -745,187 +531,77 @@ void AutoDJCratesDAO::slotCrateDeleted(CrateId crateId) {
 }
 
 void AutoDJCratesDAO::updateAutoDjCrate(CrateId crateId) {
-    // Handle a crate that's entered the auto-DJ queue differently than one that
-    // is leaving it.  (Obviously.)
-    ScopedTransaction oTransaction(m_database);
-
-    // Add a crate-reference to every track in this crate, if that track is
-    // already in the auto-DJ-crates table.
-    QSqlQuery oQuery(m_database);
-    // UPDATE temp_autodj_crates SET craterefs = craterefs + 1
-    // WHERE track_id IN (
-    //     SELECT temp_autodj_crates.track_id
-    //     FROM crate_tracks, temp_autodj_crates
-    //     WHERE crate_tracks.crate_id = :crate_id
-    //     AND crate_tracks.track_id = temp_autodj_crates.track_id);
-    oQuery.prepare(QString ("UPDATE " AUTODJCRATES_TABLE " SET "
-            AUTODJCRATESTABLE_CRATEREFS " = " AUTODJCRATESTABLE_CRATEREFS
-            " + 1 WHERE " AUTODJCRATESTABLE_TRACKID " IN (SELECT "
-            AUTODJCRATES_TABLE "." AUTODJCRATESTABLE_TRACKID " FROM "
-            CRATE_TRACKS_TABLE ", " AUTODJCRATES_TABLE " WHERE "
-            CRATE_TRACKS_TABLE ".%2 = :crate_id AND " CRATE_TRACKS_TABLE
-            ".%1 = " AUTODJCRATES_TABLE "." AUTODJCRATESTABLE_TRACKID ")")
-            .arg(CRATETRACKSTABLE_TRACKID, // %1
-                 CRATETRACKSTABLE_CRATEID)); // %2
-    oQuery.bindValue(":crate_id", crateId.toVariant());
-    if (!oQuery.exec()) {
-        LOG_FAILED_QUERY(oQuery);
-        return;
-    }
-
-    // Create an entry for all tracks that weren't in the auto-DJ-crates
-    // table already.
-    // The number of crate references is known to be 1 for such tracks.
-    // The number of references to each track in the auto-DJ playlist isn't
-    // set yet; it defaults to zero.
-    // If no records were modified by this query, then there's no reason to
-    // update the number of auto-DJ-playlist references to each track.
-
-    // INSERT INTO temp_autodj_crates (
-    //     track_id, craterefs, timesplayed, autodjrefs)
-    // SELECT crate_tracks.track_id, 1, library.timesplayed, 0
-    // FROM crate_tracks, library
-    // WHERE crate_tracks.crate_id = :crate_id
-    // AND crate_tracks.track_id NOT IN (
-    //     SELECT track_id FROM temp_autodj_crates)
-    // AND crate_tracks.track_id = library.id
-    // AND library.mixxx_deleted = 0;
-    oQuery.prepare(QString("INSERT INTO " AUTODJCRATES_TABLE " ("
-            AUTODJCRATESTABLE_TRACKID ", " AUTODJCRATESTABLE_CRATEREFS ", "
-            AUTODJCRATESTABLE_TIMESPLAYED ", " AUTODJCRATESTABLE_AUTODJREFS
-            ") SELECT " CRATE_TRACKS_TABLE ".%1, 1, " LIBRARY_TABLE
-            ".timesplayed, 0 FROM " CRATE_TRACKS_TABLE ", " LIBRARY_TABLE
-            " WHERE " CRATE_TRACKS_TABLE ".%2 = :crate_id AND "
-            CRATE_TRACKS_TABLE ".%1 NOT IN (SELECT " AUTODJCRATESTABLE_TRACKID
-            " FROM " AUTODJCRATES_TABLE" ) AND " CRATE_TRACKS_TABLE ".%1 = "
-            LIBRARY_TABLE ".%3 AND " LIBRARY_TABLE ".%4 = 0")
-            .arg(CRATETRACKSTABLE_TRACKID, // %1
-                 CRATETRACKSTABLE_CRATEID, // %2
-                 LIBRARYTABLE_ID, // %3
-                 LIBRARYTABLE_MIXXXDELETED)); // %4
-    oQuery.bindValue(":crate_id", crateId.toVariant());
-    if (!oQuery.exec()) {
-        LOG_FAILED_QUERY(oQuery);
-        return;
-    }
-    if (oQuery.numRowsAffected() == 0) {
-        oTransaction.commit();
+    // Crates are also updated when renamed, so only handle a crate that
+    // has entered the auto-DJ queue.
+    if (m_autoDjCrateTracks.contains(crateId)) {
         return;
     }
 
-    // Update the number of auto-DJ-playlist references to each track.
-    // There's no way to avoid updating the number of references to tracks
-    // that were already in the database, but the auto-DJ-playlist is likely
-    // to be small compared to the number of tracks in auto-DJ crates, so
-    // this isn't so bad.
-    if (!updateAutoDjPlaylistReferences()) {
-        return;
-    }
+    // Add a crate-reference to every track in this crate, and a new
+    // candidate for the tracks that have not been in any auto-DJ crate.
+    const QSet<TrackId> newTrackIds = addAutoDjCrateTracks(crateId);
 
-    // Update the last-played date/time for each track.
-    // Similarly, there's no way to avoid updating the last-played date/time
-    // of tracks that were already in the database.
-    if (!updateLastPlayedDateTime()) {
+    // Fill out the remaining columns of the new candidates.
+    if (!updateAutoDjPlaylistReferences(newTrackIds)) {
         return;
     }
-
-    // The transaction was successful.
-    oTransaction.commit();
+    updateLastPlayedDateTime(newTrackIds);
 }
 
 void AutoDJCratesDAO::deleteAutoDjCrate(CrateId crateId) {
-    // Handle a crate that's entered the auto-DJ queue differently than one that
-    // is leaving it.  (Obviously.)
-    ScopedTransaction oTransaction(m_database);
-
-    // Remove a crate-reference from every track in this crate.
-    QSqlQuery oQuery(m_database);
-    // UPDATE temp_autodj_crates SET craterefs = craterefs - 1
-    // WHERE track_id IN (
-    //     SELECT track_id
-    //     FROM crate_tracks
-    //     WHERE crate_tracks.crate_id = :crate_id);
-    oQuery.prepare(QString("UPDATE " AUTODJCRATES_TABLE " SET "
-            AUTODJCRATESTABLE_CRATEREFS " = " AUTODJCRATESTABLE_CRATEREFS
-            " - 1 WHERE " AUTODJCRATESTABLE_TRACKID " IN (SELECT %1 FROM "
-            CRATE_TRACKS_TABLE " WHERE " CRATE_TRACKS_TABLE ".%2 = :crate_id)")
-            .arg(CRATETRACKSTABLE_TRACKID, // %1
-                 CRATETRACKSTABLE_CRATEID)); // %2
-    oQuery.bindValue(":crate_id", crateId.toVariant());
-    if (!oQuery.exec()) {
-        LOG_FAILED_QUERY(oQuery);
+    // The tracks of a deleted crate are not available from the database
+    // anymore.
+    const auto i = m_autoDjCrateTracks.find(crateId);
+    if (i == m_autoDjCrateTracks.end()) {
         return;
     }
-
-    // Remove all tracks that no longer have crate references.
-    //DELETE FROM temp_autodj_crates WHERE craterefs = 0;
-    oQuery.prepare("DELETE FROM " AUTODJCRATES_TABLE " WHERE "
-        AUTODJCRATESTABLE_CRATEREFS " = 0");
-    if (!oQuery.exec()) {
-        LOG_FAILED_QUERY(oQuery);
-        return;
+    for (const auto& trackId : i.value()) {
+        m_candidates.removeCrateRef(trackId);
     }
-
-    // The transaction was successful.
-    oTransaction.commit();
+    m_autoDjCrateTracks.erase(i);
 }
 
 void AutoDJCratesDAO::slotCrateTracksChanged(
         CrateId crateId, const QList<TrackId>& addedTrackIds,
         const QList<TrackId>& removedTrackIds) {
-    // Skip this if it's not an auto-DJ crate.
-    Crate crate;
-    if (!m_pTrackCollection->crates().readCrateById(crateId, &crate)
-            || !crate.isAutoDjSource()) {
+    const auto i = m_autoDjCrateTracks.find(crateId);
+    if (i == m_autoDjCrateTracks.end()) {
         return;
     }
+    QSet<TrackId>& crateTrackIds = i.value();
 
-    ScopedTransaction oTransaction(m_database);
-    QSqlQuery oQuery(m_database);
     for (const auto& trackId: addedTrackIds) {
-        // Add a crate-reference to this track, if it's already in the
-        // auto-DJ-crates table (in which case, we're done).
-        // UPDATE temp_autodj_crates SET craterefs = craterefs + 1 WHERE track_id = :track_id;
-        QString strHidden;
-        strHidden.setNum(PlaylistDAO::PLHT_AUTO_DJ);
-        oQuery.prepare("UPDATE " AUTODJCRATES_TABLE " SET "
-            AUTODJCRATESTABLE_CRATEREFS " = " AUTODJCRATESTABLE_CRATEREFS
-            " + 1 WHERE " AUTODJCRATESTABLE_TRACKID " = :track_id");
-        oQuery.bindValue(":track_id", trackId.toVariant());
-        if (!oQuery.exec()) {
-            LOG_FAILED_QUERY(oQuery);
-            return;
+        if (crateTrackIds.contains(trackId)) {
+            continue;
         }
-        if (oQuery.numRowsAffected() == 1) {
+        const AutoDJCandidateSet::Candidate* pCandidate = m_candidates.find(trackId);
+        if (pCandidate) {
+            // Add a crate-reference to this track, if it's already a
+            // candidate (in which case, we're done).
+            crateTrackIds.insert(trackId);
+            m_candidates.addCrateRef(trackId, pCandidate->timesPlayed);
             continue;
         }
 
-        // Create an entry for the track.
-        // The number of crate references is known to be 1 for such tracks.
-        // The number of references to each track in the auto-DJ playlist isn't
-        // set yet; it defaults to zero.
-        // If no records were modified by this query (i.e. because the track's
-        // mixxx_deleted flag is set), then there's no reason to update the number
-        // of auto-DJ-playlist references to each track.
-        // INSERT INTO temp_autodj_crates (track_id, craterefs, timesplayed, autodjrefs) SELECT :track_id, 1, library.timesplayed, 0 FROM library WHERE :track_id = library.id AND library.mixxx_deleted = 0;
-        oQuery.prepare(QString("INSERT INTO " AUTODJCRATES_TABLE " ("
-                AUTODJCRATESTABLE_TRACKID ", " AUTODJCRATESTABLE_CRATEREFS ", "
-                AUTODJCRATESTABLE_TIMESPLAYED ", " AUTODJCRATESTABLE_AUTODJREFS
-                ") SELECT :track_id_1, 1, " LIBRARY_TABLE ".%1, 0 FROM " LIBRARY_TABLE
-                " WHERE :track_id_2 = " LIBRARY_TABLE ".%2 AND " LIBRARY_TABLE
-                ".%3 = 0")
+        // Create a candidate for the track, unless its mixxx_deleted flag
+        // is set.
+        // SELECT timesplayed FROM library WHERE id = :track_id AND mixxx_deleted = 0;
+        QSqlQuery oQuery(m_database);
+        oQuery.prepare(QString("SELECT %1 FROM " LIBRARY_TABLE
+                " WHERE %2 = :track_id AND %3 = 0")
                 .arg(LIBRARYTABLE_TIMESPLAYED, // %1
                      LIBRARYTABLE_ID, // %2
                      LIBRARYTABLE_MIXXXDELETED)); // %3
-        oQuery.bindValue(":track_id_1", trackId.toVariant());
-        oQuery.bindValue(":track_id_2", trackId.toVariant());
+        oQuery.bindValue(":track_id", trackId.toVariant());
         if (!oQuery.exec()) {
             LOG_FAILED_QUERY(oQuery);
             return;
         }
-        if (oQuery.numRowsAffected() == 0) {
+        if (!oQuery.next()) {
             continue;
         }
+        crateTrackIds.insert(trackId);
+        m_candidates.addCrateRef(trackId, oQuery.value(0).toInt());
 
         // Update the number of auto-DJ-playlist references to this track.
         if (!updateAutoDjPlaylistReferencesForTrack(trackId)) {
@@ -938,29 +614,11 @@ void AutoDJCratesDAO::slotCrateTracksChanged(
         }
     }
     for (const auto& trackId: removedTrackIds) {
-        // UPDATE temp_autodj_crates SET craterefs = craterefs - 1 WHERE track_id = :track_id;
-        oQuery.prepare("UPDATE " AUTODJCRATES_TABLE " SET "
-            AUTODJCRATESTABLE_CRATEREFS " = " AUTODJCRATESTABLE_CRATEREFS
-            " - 1 WHERE " AUTODJCRATESTABLE_TRACKID " = :track_id");
-        oQuery.bindValue(":track_id", trackId.toVariant());
-        if (!oQuery.exec()) {
-            LOG_FAILED_QUERY(oQuery);
-            return;
-        }
-
         // Remove the track if it no longer has a crate reference.
-        //DELETE FROM temp_autodj_crates WHERE track_id = :track_id AND craterefs = 0;
-        oQuery.prepare("DELETE FROM " AUTODJCRATES_TABLE " WHERE "
-            AUTODJCRATESTABLE_TRACKID " = :track_id AND "
-            AUTODJCRATESTABLE_CRATEREFS " = 0");
-        oQuery.bindValue(":track_id", trackId.toVariant());
-        if (!oQuery.exec()) {
-            LOG_FAILED_QUERY(oQuery);
-            return;
+        if (crateTrackIds.remove(trackId)) {
+            m_candidates.removeCrateRef(trackId);
         }
     }
-    // The transaction was successful.
-    oTransaction.commit();
 }
 
 // Signaled by the playlistDAO when a playlist is added.
@@ -969,7 +627,7 @@ void AutoDJCratesDAO::slotPlaylistAdded(int playlistId) {
     if (m_pTrackCollection->getPlaylistDAO().getHiddenType(playlistId)
             == PlaylistDAO::PLHT_SET_LOG) {
         m_lstSetLogPlaylistIds.append(playlistId);
-        updateLastPlayedDateTime();
+        updateLastPlayedDateTime(m_candidates.trackIds().toSet());
     }
 }
 
@@ -979,7 +637,7 @@ void AutoDJCratesDAO::slotPlaylistDeleted(int playlistId) {
     int iIndex = m_lstSetLogPlaylistIds.indexOf(playlistId);
     if (iIndex >= 0) {
         m_lstSetLogPlaylistIds.removeAt(iIndex);
-        updateLastPlayedDateTime();
+        updateLastPlayedDateTime(m_candidates.trackIds().toSet());
     }
 }
 
@@ -988,22 +646,10 @@ void AutoDJCratesDAO::slotPlaylistTrackAdded(int playlistId, TrackId trackId,
                                              int /* a_iPosition */) {
     // Deal with changes to the auto-DJ playlist.
     if (playlistId == m_iAutoDjPlaylistId) {
-        QSqlQuery oQuery(m_database);
-        // UPDATE temp_autodj_crates SET autodjrefs = autodjrefs + 1
-        // WHERE track_id = :track_id;
-        oQuery.prepare("UPDATE " AUTODJCRATES_TABLE " SET "
-            AUTODJCRATESTABLE_AUTODJREFS " = " AUTODJCRATESTABLE_AUTODJREFS
-            " + 1 WHERE " AUTODJCRATESTABLE_TRACKID " = :track_id");
-        oQuery.bindValue(":track_id", trackId.toVariant());
-        if (!oQuery.exec()) {
-            LOG_FAILED_QUERY(oQuery);
-            return;
-        }
+        m_candidates.addAutoDjRef(trackId);
     } else if (m_lstSetLogPlaylistIds.contains(playlistId)) {
         // Deal with changes to set-log playlists.
         // If this query doesn't succeed, it'll log a message.
-        // Do nothing special otherwise -- any change it makes can be part of
-        // any current transaction.
         updateLastPlayedDateTimeForTrack(trackId);
     }
 }
@@ -1014,21 +660,10 @@ void AutoDJCratesDAO::slotPlaylistTrackRemoved(int playlistId,
                                                int /* a_iPosition */) {
     // Deal with changes to the auto-DJ playlist.
     if (playlistId == m_iAutoDjPlaylistId) {
-        QSqlQuery oQuery(m_database);
-        // UPDATE temp_autodj_crates SET autodjrefs = autodjrefs - 1 WHERE track_id = :track_id;
-        oQuery.prepare("UPDATE " AUTODJCRATES_TABLE " SET "
-            AUTODJCRATESTABLE_AUTODJREFS " = " AUTODJCRATESTABLE_AUTODJREFS
-            " - 1 WHERE " AUTODJCRATESTABLE_TRACKID " = :track_id");
-        oQuery.bindValue(":track_id", trackId.toVariant());
-        if (!oQuery.exec()) {
-            LOG_FAILED_QUERY(oQuery);
-            return;
-        }
+        m_candidates.removeAutoDjRef(trackId);
     } else if (m_lstSetLogPlaylistIds.contains(playlistId)) {
         // Deal with changes to set-log playlists.
         // If this query doesn't succeed, it'll log a message.
-        // Do nothing special otherwise -- any change it makes can be part of
-        // any current transaction.
         updateLastPlayedDateTimeForTrack(trackId);
     }
 }
@@ -1048,17 +683,7 @@ void AutoDJCratesDAO::slotPlayerInfoTrackLoaded(QString a_strGroup,
     for (unsigned int i = 0; i < numDecks; ++i) {
         if (a_strGroup == PlayerManager::groupForDeck(i)) {
             // Update the number of auto-DJ-playlist references to this track.
-            QSqlQuery oQuery(m_database);
-            // UPDATE temp_autodj_crates SET autodjrefs = autodjrefs + 1
-            // WHERE track_id = :track_id;
-            oQuery.prepare("UPDATE " AUTODJCRATES_TABLE " SET "
-                AUTODJCRATESTABLE_AUTODJREFS " = " AUTODJCRATESTABLE_AUTODJREFS
-                " + 1 WHERE " AUTODJCRATESTABLE_TRACKID " = :track_id");
-            oQuery.bindValue(":track_id", trackId.toVariant());
-            if (!oQuery.exec()) {
-                LOG_FAILED_QUERY(oQuery);
-                return;
-            }
+            m_candidates.addAutoDjRef(trackId);
             return;
         }
     }
@@ -1074,17 +699,7 @@ void AutoDJCratesDAO::slotPlayerInfoTrackUnloaded(QString group,
     for (unsigned int i = 0; i < numDecks; ++i) {
         if (group == PlayerManager::groupForDeck(i)) {
             // Get rid of the ID of the track in this deck.
-            QSqlQuery oQuery(m_database);
-            // UPDATE temp_autodj_crates SET autodjrefs = autodjrefs - 1
-            // WHERE track_id = :track_id;
-            oQuery.prepare("UPDATE " AUTODJCRATES_TABLE " SET "
-                AUTODJCRATESTABLE_AUTODJREFS " = " AUTODJCRATESTABLE_AUTODJREFS
-                " - 1 WHERE " AUTODJCRATESTABLE_TRACKID " = :track_id");
-            oQuery.bindValue(":track_id", trackId.toVariant());
-            if (!oQuery.exec()) {
-                LOG_FAILED_QUERY(oQuery);
-                return;
-            }
+            m_candidates.removeAutoDjRef(trackId);
             return;
         }
     }
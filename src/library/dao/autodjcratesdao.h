@@ -1,10 +1,13 @@
 #ifndef AUTODJCRATESDAO_H
 #define AUTODJCRATESDAO_H
 
+#include <QHash>
 #include <QObject>
+#include <QSet>
 #include <QSqlDatabase>
 
 #include "preferences/usersettings.h"
+#include "library/autodj/autodjcandidateset.h"
 #include "library/crate/crateid.h"
 #include "track/track.h"
 #include "util/class.h"
@@ -32,28 +35,29 @@ class AutoDJCratesDAO : public QObject {
     // (Isn't that normal for QObject subclasses?)
     DISALLOW_COPY_AND_ASSIGN(AutoDJCratesDAO);
 
-    // Create the temporary auto-DJ-crates database.
+    // Load the tracks of the auto-DJ crates into memory.
     // Done the first time it's used, since the user might not even make
     // use of this feature.
-    void createAndConnectAutoDjCratesDatabase();
+    void loadAndConnectAutoDjCandidates();
 
-    // Create the active-tracks view.
-    bool createActiveTracksView(bool a_bUseIgnoreTime);
+    // Add the tracks of an auto-DJ crate that are not hidden. Returns the
+    // tracks that have not been candidates before.
+    QSet<TrackId> addAutoDjCrateTracks(CrateId crateId);
 
-    // Update the number of auto-DJ-playlist references to each track in the
-    // auto-DJ-crates database.  Returns true if successful.
-    bool updateAutoDjPlaylistReferences();
+    // Update the number of auto-DJ-playlist references to the given tracks,
+    // which must not have any references yet.  Returns true if successful.
+    bool updateAutoDjPlaylistReferences(const QSet<TrackId>& trackIds);
 
-    // Update the number of auto-DJ-playlist references to the given track
-    // in the auto-DJ-crates database.  Returns true if successful.
+    // Update the number of auto-DJ-playlist references to the given track.
+    // Returns true if successful.
     bool updateAutoDjPlaylistReferencesForTrack(TrackId trackId);
 
-    // Update the last-played date/time for each track in the
-    // auto-DJ-crates database.  Returns true if successful.
-    bool updateLastPlayedDateTime();
+    // Update the last-played date/time for the given tracks.
+    // Returns true if successful.
+    bool updateLastPlayedDateTime(const QSet<TrackId>& trackIds);
 
-    // Update the last-played date/time for the given track in the
-    // auto-DJ-crates database.  Returns true if successful.
+    // Update the last-played date/time for the given track.
+    // Returns true if successful.
     bool updateLastPlayedDateTimeForTrack(TrackId trackId);
 
     // Calculates a random Track from AutoDJ,
@@ -110,8 +114,15 @@ class AutoDJCratesDAO : public QObject {
     // The source of our configuration.
     UserSettingsPointer m_pConfig;
 
-    // True if the auto-DJ-crates database has been created.
-    bool m_bAutoDjCratesDbCreated;
+    // The tracks of the auto-DJ crates that are picked from.
+    AutoDJCandidateSet m_candidates;
+
+    // The tracks that every auto-DJ crate has contributed to the
+    // candidates.
+    QHash<CrateId, QSet<TrackId>> m_autoDjCrateTracks;
+
+    // True if the candidates have been loaded.
+    bool m_bAutoDjCandidatesLoaded;
 
     // True if active tracks can be tracks that haven't been played in
     // a while.
@@ -0,0 +1,61 @@
+#include <QtSql>
+
+#include "library/dao/fileindexdao.h"
+#include "library/queryutil.h"
+
+FileIdentityIndex FileIndexDAO::getFileIdentities() {
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare("SELECT location, filesize, fs_modified, fs_inode "
+                  "FROM track_file_index");
+    FileIdentityIndex fileIdentities;
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query);
+        return fileIdentities;
+    }
+
+    const int locationColumn = query.record().indexOf("location");
+    const int fileSizeColumn = query.record().indexOf("filesize");
+    const int modifiedColumn = query.record().indexOf("fs_modified");
+    const int inodeColumn = query.record().indexOf("fs_inode");
+    while (query.next()) {
+        fileIdentities.insert(
+                query.value(locationColumn).toString(),
+                FileIdentity(
+                        query.value(fileSizeColumn).toLongLong(),
+                        query.value(modifiedColumn).toLongLong(),
+                        static_cast<quint64>(
+                                query.value(inodeColumn).toLongLong())));
+    }
+    return fileIdentities;
+}
+
+void FileIndexDAO::saveFileIdentities(const FileIdentityIndex& fileIdentities) {
+    if (fileIdentities.isEmpty()) {
+        return;
+    }
+    QSqlQuery query(m_database);
+    query.prepare("INSERT OR REPLACE INTO track_file_index "
+                  "(location, filesize, fs_modified, fs_inode) "
+                  "VALUES (:location, :filesize, :fs_modified, :fs_inode)");
+    for (auto it = fileIdentities.constBegin();
+            it != fileIdentities.constEnd(); ++it) {
+        query.bindValue(":location", it.key());
+        query.bindValue(":filesize", it.value().fileSize());
+        query.bindValue(":fs_modified", it.value().modifiedMillis());
+        // SQLite only stores signed 64-bit integers
+        query.bindValue(":fs_inode", static_cast<qint64>(it.value().inode()));
+        if (!query.exec()) {
+            LOG_FAILED_QUERY(query) << "Saving file identity failed.";
+        }
+    }
+}
+
+void FileIndexDAO::removeStaleFileIdentities() {
+    QSqlQuery query(m_database);
+    query.prepare("DELETE FROM track_file_index WHERE location NOT IN "
+                  "(SELECT location FROM track_locations WHERE fs_deleted=0)");
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query);
+    }
+}
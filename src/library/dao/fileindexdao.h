@@ -0,0 +1,30 @@
+#ifndef FILEINDEXDAO_H
+#define FILEINDEXDAO_H
+
+#include <QSqlDatabase>
+
+#include "library/dao/dao.h"
+#include "library/scanner/fileidentity.h"
+
+// Persistent index of the file identities of all track files that
+// have been visited by the library scanner. Only accessed by the
+// library scanner thread.
+class FileIndexDAO : public DAO {
+  public:
+    ~FileIndexDAO() override {}
+
+    void initialize(const QSqlDatabase& database) override {
+        m_database = database;
+    }
+
+    FileIdentityIndex getFileIdentities();
+    void saveFileIdentities(const FileIdentityIndex& fileIdentities);
+    // Removes the entries of all files that are not referenced by
+    // an existing track location.
+    void removeStaleFileIdentities();
+
+  private:
+    QSqlDatabase m_database;
+};
+
+#endif //FILEINDEXDAO_H
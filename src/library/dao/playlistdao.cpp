@@ -6,10 +6,60 @@
 #include "library/queryutil.h"
 #include "library/trackcollection.h"
 #include "library/autodj/autodjprocessor.h"
+#include "util/db/dbwriter.h"
 #include "util/math.h"
 
+namespace {
+
+int maxPosition(const QSqlDatabase& database, const int playlistId) {
+    // Find out the highest position existing in the playlist so we know what
+    // position this track should have.
+    QSqlQuery query(database);
+    query.prepare("SELECT max(position) as position FROM PlaylistTracks "
+                  "WHERE playlist_id = :id");
+    query.bindValue(":id", playlistId);
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query);
+    }
+
+    // Get the position of the highest track in the playlist.
+    int position = 0;
+    if (query.next()) {
+        position = query.value(query.record().indexOf("position")).toInt();
+    }
+    return position;
+}
+
+// Returns the position of the first inserted track or -1 on failure.
+// Must be invoked within a transaction.
+int insertTracksAfterLastPosition(const QSqlDatabase& database,
+        const QList<TrackId>& trackIds, const int playlistId) {
+    // Append after the last song. If no songs or a failed query then 0 becomes 1.
+    const int position = maxPosition(database, playlistId) + 1;
+
+    //Insert the song into the PlaylistTracks table
+    QSqlQuery query(database);
+    query.prepare("INSERT INTO PlaylistTracks (playlist_id, track_id, position, pl_datetime_added)"
+                  "VALUES (:playlist_id, :track_id, :position, CURRENT_TIMESTAMP)");
+    query.bindValue(":playlist_id", playlistId);
+
+    int insertPosition = position;
+    for (const auto& trackId: trackIds) {
+        query.bindValue(":track_id", trackId.toVariant());
+        query.bindValue(":position", insertPosition++);
+        if (!query.exec()) {
+            LOG_FAILED_QUERY(query);
+            return -1;
+        }
+    }
+    return position;
+}
+
+} // anonymous namespace
+
 PlaylistDAO::PlaylistDAO()
-        : m_pAutoDJProcessor(nullptr) {
+        : m_pAutoDJProcessor(nullptr),
+          m_pDbWriter(nullptr) {
 }
 
 void PlaylistDAO::initialize(const QSqlDatabase& database) {
@@ -160,6 +210,7 @@ int PlaylistDAO::getPlaylistIdFromName(const QString& name) const {
 }
 
 void PlaylistDAO::deletePlaylist(const int playlistId) {
+    finishPendingWrites();
     //qDebug() << "PlaylistDAO::deletePlaylist" << QThread::currentThread() << m_database.connectionName();
     ScopedTransaction transaction(m_database);
 
@@ -244,6 +295,7 @@ bool PlaylistDAO::isPlaylistLocked(const int playlistId) const {
 }
 
 bool PlaylistDAO::removeTracksFromPlaylist(const int playlistId, const int startIndex) {
+    finishPendingWrites();
     // Retain the first track if it is loaded in a deck
     ScopedTransaction transaction(m_database);
     QSqlQuery query(m_database);
@@ -261,45 +313,65 @@ bool PlaylistDAO::removeTracksFromPlaylist(const int playlistId, const int start
 }
 
 bool PlaylistDAO::appendTracksToPlaylist(const QList<TrackId>& trackIds, const int playlistId) {
+    finishPendingWrites();
     // qDebug() << "PlaylistDAO::appendTracksToPlaylist"
     //          << QThread::currentThread() << m_database.connectionName();
 
     // Start the transaction
     ScopedTransaction transaction(m_database);
 
-    int position = getMaxPosition(playlistId);
-
-    // Append after the last song. If no songs or a failed query then 0 becomes 1.
-    ++position;
+    int position = insertTracksAfterLastPosition(m_database, trackIds, playlistId);
+    if (position < 0) {
+        return false;
+    }
 
-    //Insert the song into the PlaylistTracks table
-    QSqlQuery query(m_database);
-    query.prepare("INSERT INTO PlaylistTracks (playlist_id, track_id, position, pl_datetime_added)"
-                  "VALUES (:playlist_id, :track_id, :position, CURRENT_TIMESTAMP)");
-    query.bindValue(":playlist_id", playlistId);
+    // Commit the transaction
+    transaction.commit();
 
+    afterAppendingTracksToPlaylist(trackIds, playlistId, position);
+    return true;
+}
 
-    int insertPosition = position;
-    for (const auto& trackId: trackIds) {
-        query.bindValue(":track_id", trackId.toVariant());
-        query.bindValue(":position", insertPosition++);
-        if (!query.exec()) {
-            LOG_FAILED_QUERY(query);
-            return false;
-        }
+void PlaylistDAO::appendTracksToPlaylistAsync(const QList<TrackId>& trackIds, const int playlistId) {
+    if (!m_pDbWriter) {
+        appendTracksToPlaylist(trackIds, playlistId);
+        return;
     }
+    // The position is only known after the preceding commands have
+    // been executed.
+    auto pPosition = std::make_shared<int>(-1);
+    m_pDbWriter->enqueue(
+            [trackIds, playlistId, pPosition](QSqlDatabase database) {
+                *pPosition = insertTracksAfterLastPosition(
+                        database, trackIds, playlistId);
+                return *pPosition >= 0;
+            },
+            [this, trackIds, playlistId, pPosition](bool succeeded) {
+                if (!succeeded) {
+                    qWarning() << "Failed to append" << trackIds.size()
+                               << "tracks to playlist" << playlistId;
+                    emit(appendingTracksFailed(playlistId, trackIds.size()));
+                    return;
+                }
+                afterAppendingTracksToPlaylist(trackIds, playlistId, *pPosition);
+            },
+            this);
+}
 
-    // Commit the transaction
-    transaction.commit();
+void PlaylistDAO::finishPendingWrites() {
+    if (m_pDbWriter) {
+        m_pDbWriter->finishPending();
+    }
+}
 
-    insertPosition = position;
+void PlaylistDAO::afterAppendingTracksToPlaylist(const QList<TrackId>& trackIds,
+        const int playlistId, int position) {
     for (const auto& trackId: trackIds) {
         m_playlistsTrackIsIn.insert(trackId, playlistId);
         // TODO(XXX) don't emit if the track didn't add successfully.
-        emit(trackAdded(playlistId, trackId, insertPosition++));
+        emit(trackAdded(playlistId, trackId, position++));
     }
     emit(changed(playlistId));
-    return true;
 }
 
 bool PlaylistDAO::appendTrackToPlaylist(TrackId trackId, const int playlistId) {
@@ -379,6 +451,7 @@ bool PlaylistDAO::isHidden(const int playlistId) const {
 
 
 void PlaylistDAO::removeHiddenTracks(const int playlistId) {
+    finishPendingWrites();
     ScopedTransaction transaction(m_database);
     // This query deletes all tracks marked as deleted and all
     // phantom track_ids with no match in the library table
@@ -416,6 +489,7 @@ void PlaylistDAO::removeHiddenTracks(const int playlistId) {
 
 
 void PlaylistDAO::removeTrackFromPlaylist(const int playlistId, const TrackId& trackId) {
+    finishPendingWrites();
     ScopedTransaction transaction(m_database);
 
     QSqlQuery query(m_database);
@@ -442,6 +516,7 @@ void PlaylistDAO::removeTrackFromPlaylist(const int playlistId, const TrackId& t
 
 
 void PlaylistDAO::removeTrackFromPlaylist(const int playlistId, const int position) {
+    finishPendingWrites();
     // qDebug() << "PlaylistDAO::removeTrackFromPlaylist"
     //          << QThread::currentThread() << m_database.connectionName();
     ScopedTransaction transaction(m_database);
@@ -451,6 +526,7 @@ void PlaylistDAO::removeTrackFromPlaylist(const int playlistId, const int positi
 }
 
 void PlaylistDAO::removeTracksFromPlaylist(const int playlistId, QList<int>& positions) {
+    finishPendingWrites();
     // get positions in reversed order
     std::sort(positions.begin(), positions.end(), std::greater<int>());
 
@@ -510,6 +586,7 @@ void PlaylistDAO::removeTracksFromPlaylistInner(int playlistId, int position) {
 
 
 bool PlaylistDAO::insertTrackIntoPlaylist(TrackId trackId, const int playlistId, int position) {
+    finishPendingWrites();
     if (playlistId < 0 || !trackId.isValid() || position < 0)
         return false;
 
@@ -555,6 +632,7 @@ bool PlaylistDAO::insertTrackIntoPlaylist(TrackId trackId, const int playlistId,
 
 int PlaylistDAO::insertTracksIntoPlaylist(const QList<TrackId>& trackIds,
                                           const int playlistId, int position) {
+    finishPendingWrites();
     if (playlistId < 0 || position < 0) {
         return 0;
     }
@@ -672,6 +750,7 @@ int PlaylistDAO::getPreviousPlaylist(const int currentPlaylistId, HiddenType hid
 }
 
 bool PlaylistDAO::copyPlaylistTracks(const int sourcePlaylistID, const int targetPlaylistID) {
+    finishPendingWrites();
     // Start the transaction
     ScopedTransaction transaction(m_database);
 
@@ -728,25 +807,11 @@ bool PlaylistDAO::copyPlaylistTracks(const int sourcePlaylistID, const int targe
 }
 
 int PlaylistDAO::getMaxPosition(const int playlistId) const {
-    // Find out the highest position existing in the playlist so we know what
-    // position this track should have.
-    QSqlQuery query(m_database);
-    query.prepare("SELECT max(position) as position FROM PlaylistTracks "
-                  "WHERE playlist_id = :id");
-    query.bindValue(":id", playlistId);
-    if (!query.exec()) {
-        LOG_FAILED_QUERY(query);
-    }
-
-    // Get the position of the highest track in the playlist.
-    int position = 0;
-    if (query.next()) {
-        position = query.value(query.record().indexOf("position")).toInt();
-    }
-    return position;
+    return maxPosition(m_database, playlistId);
 }
 
 void PlaylistDAO::removeTracksFromPlaylists(const QList<TrackId>& trackIds) {
+    finishPendingWrites();
     // copy the hash, because there is no guarantee that "it" is valid after remove
     QMultiHash<TrackId, int> playlistsTrackIsInCopy = m_playlistsTrackIsIn;
     for (const auto& trackId: trackIds) {
@@ -778,6 +843,7 @@ int PlaylistDAO::tracksInPlaylist(const int playlistId) const {
 }
 
 void PlaylistDAO::moveTrack(const int playlistId, const int oldPosition, const int newPosition) {
+    finishPendingWrites();
     ScopedTransaction transaction(m_database);
     QSqlQuery query(m_database);
 
@@ -852,6 +918,7 @@ void PlaylistDAO::searchForDuplicateTrack(const int fromPosition,
 }
 
 void PlaylistDAO::shuffleTracks(const int playlistId, const QList<int>& positions, const QHash<int,TrackId>& allIds) {
+    finishPendingWrites();
     ScopedTransaction transaction(m_database);
     QSqlQuery query(m_database);
 
@@ -31,6 +31,9 @@ const QString PLAYLISTTRACKSTABLE_DATETIMEADDED = "pl_datetime_added";
 #define AUTODJ_TABLE "Auto DJ"
 
 class AutoDJProcessor;
+namespace mixxx {
+class DbWriter;
+} // namespace mixxx
 
 class PlaylistDAO : public QObject, public virtual DAO {
     Q_OBJECT
@@ -67,6 +70,11 @@ class PlaylistDAO : public QObject, public virtual DAO {
     bool isPlaylistLocked(const int playlistId) const;
     // Append a list of tracks to a playlist
     bool appendTracksToPlaylist(const QList<TrackId>& trackIds, const int playlistId);
+    // Append a list of tracks to a playlist in the writer thread if
+    // available. The signals are emitted after the tracks have been added
+    // or appendingTracksFailed() if that was not possible. All synchronous
+    // modifications of playlist tracks wait for these pending appends.
+    void appendTracksToPlaylistAsync(const QList<TrackId>& trackIds, const int playlistId);
     // Append a track to a playlist
     bool appendTrackToPlaylist(TrackId trackId, const int playlistId);
     // Find out how many playlists exist.
@@ -119,6 +127,9 @@ class PlaylistDAO : public QObject, public virtual DAO {
     void getPlaylistsTrackIsIn(TrackId trackId, QSet<int>* playlistSet) const;
 
     void setAutoDJProcessor(AutoDJProcessor* pAutoDJProcessor);
+    void setDbWriter(mixxx::DbWriter* pDbWriter) {
+        m_pDbWriter = pDbWriter;
+    }
     void sendToAutoDJ(const QList<TrackId>& trackIds, AutoDJSendLoc loc);
 
   signals:
@@ -129,6 +140,7 @@ class PlaylistDAO : public QObject, public virtual DAO {
     void trackRemoved(int playlistId, TrackId trackId, int position);
     void renamed(int playlistId, QString a_strName);
     void lockChanged(int playlistId);
+    void appendingTracksFailed(int playlistId, int trackCount);
 
   private:
     bool removeTracksFromPlaylist(const int playlistId, const int startIndex);
@@ -141,10 +153,16 @@ class PlaylistDAO : public QObject, public virtual DAO {
                                  const QHash<int,TrackId>* pTrackPositionIds,
                                  int* pTrackDistance);
     void populatePlaylistMembershipCache();
+    // Waits until all tracks that are appended asynchronously have been
+    // added to their playlists
+    void finishPendingWrites();
+    void afterAppendingTracksToPlaylist(const QList<TrackId>& trackIds,
+            const int playlistId, int position);
 
     QSqlDatabase m_database;
     QMultiHash<TrackId, int> m_playlistsTrackIsIn;
     AutoDJProcessor* m_pAutoDJProcessor;
+    mixxx::DbWriter* m_pDbWriter;
     DISALLOW_COPY_AND_ASSIGN(PlaylistDAO);
 };
 
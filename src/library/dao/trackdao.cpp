@@ -25,6 +25,7 @@
 #include "library/dao/analysisdao.h"
 #include "library/dao/libraryhashdao.h"
 #include "library/coverartcache.h"
+#include "library/coverartthumbnailstore.h"
 #include "track/beatfactory.h"
 #include "track/beats.h"
 #include "track/keyfactory.h"
@@ -1905,13 +1906,18 @@ void TrackDAO::detectCoverArtForTracksWithoutCover(volatile const bool* pCancel,
 
         QImage image(CoverArtUtils::extractEmbeddedCover(trackFile));
         if (!image.isNull()) {
+            const quint16 hash = CoverArtUtils::calculateHash(image);
+            CoverInfo embeddedCoverInfo;
+            embeddedCoverInfo.type = CoverInfo::METADATA;
+            embeddedCoverInfo.hash = hash;
+            embeddedCoverInfo.trackLocation = track.trackLocation;
+            CoverArtThumbnailStore::instance()->storeThumbnails(embeddedCoverInfo, image);
             updateQuery.bindValue(":coverart_type",
                                   static_cast<int>(CoverInfo::METADATA));
             updateQuery.bindValue(":coverart_source",
                                   static_cast<int>(CoverInfo::GUESSED));
             // TODO() here we may introduce a duplicate hash code
-            updateQuery.bindValue(":coverart_hash",
-                                  CoverArtUtils::calculateHash(image));
+            updateQuery.bindValue(":coverart_hash", hash);
             updateQuery.bindValue(":coverart_location", "");
             updateQuery.bindValue(":track_id", track.trackId.toVariant());
             if (!updateQuery.exec()) {
@@ -1932,6 +1938,14 @@ void TrackDAO::detectCoverArtForTracksWithoutCover(volatile const bool* pCancel,
 
         CoverInfoRelative coverInfo = CoverArtUtils::selectCoverArtForTrack(
             trackFile, track.trackAlbum, possibleCovers);
+        // All tracks of an album usually share the same cover file
+        CoverArtThumbnailStore* pThumbnailStore = CoverArtThumbnailStore::instance();
+        const CoverInfo coverInfoWithLocation(coverInfo, track.trackLocation);
+        if (coverInfo.type == CoverInfo::FILE &&
+                pThumbnailStore->shouldStoreThumbnails(coverInfoWithLocation)) {
+            pThumbnailStore->storeThumbnails(coverInfoWithLocation,
+                    CoverArtUtils::loadCover(coverInfoWithLocation));
+        }
 
         updateQuery.bindValue(":coverart_type",
                               static_cast<int>(coverInfo.type));
@@ -153,6 +153,7 @@ void DlgAnalysis::slotAnalysisActive(bool bActive) {
         pushButtonAnalyze->setText(tr("Analyze"));
         labelProgress->setText("");
         labelProgress->setEnabled(false);
+        labelThroughput->setText("");
     }
 }
 
@@ -178,6 +179,19 @@ void DlgAnalysis::onTrackAnalysisSchedulerProgress(
     }
 }
 
+void DlgAnalysis::onTrackAnalysisSchedulerThroughput(
+        double tracksPerMinute,
+        mixxx::Duration decodeDuration,
+        mixxx::Duration analysisDuration) {
+    if (labelProgress->isEnabled()) {
+        labelThroughput->setText(
+                tr("%1 tracks/min, decoding %2 s, analysis %3 s").arg(
+                        QString::number(tracksPerMinute, 'f', 1),
+                        QString::number(decodeDuration.toDoubleSeconds(), 'f', 0),
+                        QString::number(analysisDuration.toDoubleSeconds(), 'f', 0)));
+    }
+}
+
 void DlgAnalysis::onTrackAnalysisSchedulerFinished() {
     slotAnalysisActive(false);
 }
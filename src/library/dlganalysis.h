@@ -10,6 +10,7 @@
 #include "library/trackcollection.h"
 #include "library/ui_dlganalysis.h"
 #include "analyzer/analyzerprogress.h"
+#include "util/duration.h"
 
 class AnalysisLibraryTableModel;
 class WAnalysisLibraryTableView;
@@ -43,6 +44,7 @@ class DlgAnalysis : public QWidget, public Ui::DlgAnalysis, public virtual Libra
     void analyze();
     void slotAnalysisActive(bool bActive);
     void onTrackAnalysisSchedulerProgress(AnalyzerProgress analyzerProgress, int finishedCount, int totalCount);
+    void onTrackAnalysisSchedulerThroughput(double tracksPerMinute, mixxx::Duration decodeDuration, mixxx::Duration analysisDuration);
     void onTrackAnalysisSchedulerFinished();
     void showRecentSongs();
     void showAllSongs();
@@ -90,6 +90,7 @@ Library::Library(
 
     kLogger.info() << "Connecting database";
     m_pTrackCollection->connectDatabase(dbConnection);
+    m_pTrackCollection->setDbConnectionPool(m_pDbConnectionPool);
 
     qRegisterMetaType<Library::RemovalType>("Library::RemovalType");
 
@@ -132,10 +133,10 @@ Library::Library(
     connect(m_pCrateFeature, &CrateFeature::analyzeTracks,
             m_pAnalysisFeature, &AnalysisFeature::analyzeTracks);
     addFeature(m_pAnalysisFeature);
-    // Suspend a batch analysis while an ad-hoc analysis of
-    // loaded tracks is in progress and resume it afterwards.
-    connect(pPlayerManager, &PlayerManager::trackAnalyzerProgress,
-            this, &Library::onPlayerManagerTrackAnalyzerProgress);
+    // Pause as many threads of a batch analysis as are needed for the
+    // ad-hoc analysis of loaded tracks and resume them afterwards.
+    connect(pPlayerManager, &PlayerManager::trackAnalyzerBusy,
+            this, &Library::onPlayerManagerTrackAnalyzerBusy);
     connect(pPlayerManager, &PlayerManager::trackAnalyzerIdle,
             this, &Library::onPlayerManagerTrackAnalyzerIdle);
 
@@ -307,16 +308,15 @@ void Library::addFeature(LibraryFeature* feature) {
             this, SIGNAL(trackSelected(TrackPointer)));
 }
 
-void Library::onPlayerManagerTrackAnalyzerProgress(
-        TrackId /*trackId*/,AnalyzerProgress /*analyzerProgress*/) {
+void Library::onPlayerManagerTrackAnalyzerBusy(int threadsCount) {
     if (m_pAnalysisFeature) {
-        m_pAnalysisFeature->suspendAnalysis();
+        m_pAnalysisFeature->preemptAnalysis(threadsCount);
     }
 }
 
 void Library::onPlayerManagerTrackAnalyzerIdle() {
     if (m_pAnalysisFeature) {
-        m_pAnalysisFeature->resumeAnalysis();
+        m_pAnalysisFeature->preemptAnalysis(0);
     }
 }
 
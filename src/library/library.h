@@ -132,7 +132,7 @@ class Library: public QObject,
     void scanFinished();
 
   private slots:
-      void onPlayerManagerTrackAnalyzerProgress(TrackId trackId, AnalyzerProgress analyzerProgress);
+      void onPlayerManagerTrackAnalyzerBusy(int threadsCount);
       void onPlayerManagerTrackAnalyzerIdle();
 
   private:
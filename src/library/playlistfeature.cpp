@@ -125,8 +125,9 @@ bool PlaylistFeature::dropAcceptChild(const QModelIndex& index, QList<QUrl> urls
         }
     }
 
-    // Return whether appendTracksToPlaylist succeeded.
-    return m_playlistDao.appendTracksToPlaylist(trackIds, playlistId);
+    // The tracks are appended by the writer thread
+    m_playlistDao.appendTracksToPlaylistAsync(trackIds, playlistId);
+    return true;
 }
 
 bool PlaylistFeature::dragMoveAcceptChild(const QModelIndex& index, QUrl url) {
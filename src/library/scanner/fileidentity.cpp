@@ -0,0 +1,46 @@
+#include "library/scanner/fileidentity.h"
+
+#if !defined(__WINDOWS__)
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+#include <QDateTime>
+#include <QFile>
+
+//static
+FileIdentity FileIdentity::fromFileInfo(const QFileInfo& fileInfo) {
+#if defined(__WINDOWS__)
+    // No inodes on Windows. QFileInfo caches the results of the
+    // underlying system call.
+    if (!fileInfo.exists()) {
+        return FileIdentity();
+    }
+    return FileIdentity(
+            fileInfo.size(),
+            fileInfo.lastModified().toMSecsSinceEpoch(),
+            0);
+#else
+    // Bypass QFileInfo that would need multiple system calls and
+    // doesn't expose the inode.
+    const QByteArray encodedPath =
+            QFile::encodeName(fileInfo.absoluteFilePath());
+    struct stat st;
+    if (::stat(encodedPath.constData(), &st) != 0) {
+        return FileIdentity();
+    }
+#if defined(__APPLE__)
+    const qint64 modifiedMillis =
+            static_cast<qint64>(st.st_mtimespec.tv_sec) * 1000 +
+            st.st_mtimespec.tv_nsec / 1000000;
+#else
+    const qint64 modifiedMillis =
+            static_cast<qint64>(st.st_mtim.tv_sec) * 1000 +
+            st.st_mtim.tv_nsec / 1000000;
+#endif
+    return FileIdentity(
+            st.st_size,
+            modifiedMillis,
+            st.st_ino);
+#endif
+}
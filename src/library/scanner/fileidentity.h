@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QFileInfo>
+#include <QHash>
+#include <QString>
+#include <QtDebug>
+
+// A cheap fingerprint of a file on the file system that is used by the
+// library scanner to decide whether the metadata of an already imported
+// track needs to be re-read. Two identities are equal if the size, the
+// modification time and the inode of the file did not change in between.
+//
+// On systems without inodes the inode is always 0 and only size and
+// modification time are compared.
+class FileIdentity {
+  public:
+    FileIdentity()
+            : m_fileSize(-1),
+              m_modifiedMillis(0),
+              m_inode(0) {
+    }
+    FileIdentity(
+            qint64 fileSize,
+            qint64 modifiedMillis,
+            quint64 inode)
+            : m_fileSize(fileSize),
+              m_modifiedMillis(modifiedMillis),
+              m_inode(inode) {
+    }
+
+    // Obtains the identity of the file with a single stat() call if
+    // possible. Returns an invalid identity if the file is inaccessible.
+    static FileIdentity fromFileInfo(const QFileInfo& fileInfo);
+
+    bool isValid() const {
+        return m_fileSize >= 0;
+    }
+
+    qint64 fileSize() const {
+        return m_fileSize;
+    }
+    qint64 modifiedMillis() const {
+        return m_modifiedMillis;
+    }
+    quint64 inode() const {
+        return m_inode;
+    }
+
+  private:
+    qint64 m_fileSize;
+    qint64 m_modifiedMillis;
+    quint64 m_inode;
+};
+
+inline bool operator==(const FileIdentity& lhs, const FileIdentity& rhs) {
+    return (lhs.fileSize() == rhs.fileSize()) &&
+            (lhs.modifiedMillis() == rhs.modifiedMillis()) &&
+            (lhs.inode() == rhs.inode());
+}
+
+inline bool operator!=(const FileIdentity& lhs, const FileIdentity& rhs) {
+    return !(lhs == rhs);
+}
+
+inline QDebug operator<<(QDebug dbg, const FileIdentity& arg) {
+    return dbg << "FileIdentity{"
+            << "size:" << arg.fileSize() << ','
+            << "modified:" << arg.modifiedMillis() << ','
+            << "inode:" << arg.inode() << '}';
+}
+
+// Maps the track location to the identity of the corresponding file.
+typedef QHash<QString, FileIdentity> FileIdentityIndex;
@@ -32,6 +32,8 @@ void ImportFilesTask::run() {
 
         const QString trackLocation(TrackFile(fileInfo).location());
         //qDebug() << "ImportFilesTask::run" << trackLocation;
+        const bool fileModified = m_scannerGlobal->updateFileIdentity(
+                trackLocation, FileIdentity::fromFileInfo(fileInfo));
 
         // If the file does not exist in the database then add it. If it
         // does then it is either in the user's library OR the user has
@@ -42,6 +44,9 @@ void ImportFilesTask::run() {
             // executed when other files in the same directory have changed (the
             // directory hash has changed).
             emit(trackExists(trackLocation));
+            if (fileModified) {
+                m_scannerGlobal->addModifiedTrack(trackLocation);
+            }
         } else {
             if (!fileInfo.exists()) {
                 qWarning() << "ImportFilesTask: Skipping inaccessible file"
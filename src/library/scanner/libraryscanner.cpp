@@ -20,6 +20,12 @@ namespace {
 // TODO(rryan) make configurable
 const int kScannerThreadPoolSize = 1;
 
+// Changes in watched directories are collected for a while before
+// starting a rescan, e.g. when copying many files at once.
+const int kRescanDelayMillis = 5000;
+
+const ConfigKey kWatchDirectoriesConfigKey("[Library]", "WatchDirectories");
+
 mixxx::Logger kLogger("LibraryScanner");
 
 QAtomicInt s_instanceCounter(0);
@@ -37,12 +43,15 @@ LibraryScanner::LibraryScanner(
                   m_analysisDao, m_libraryHashDao,
                   pConfig),
           m_stateSema(1), // only one transaction is possible at a time
-          m_state(IDLE) {
+          m_state(IDLE),
+          m_watchDirectories(pConfig->getValue(kWatchDirectoriesConfigKey, false)) {
     // Move LibraryScanner to its own thread so that our signals/slots will
     // queue to our event loop.
     kLogger.debug() << "Starting thread";
     moveToThread(this);
     m_pool.moveToThread(this);
+    m_directoryWatcher.moveToThread(this);
+    m_rescanTimer.moveToThread(this);
 
     const int instanceId = s_instanceCounter.fetchAndAddAcquire(1) + 1;
     setObjectName(QString("LibraryScanner %1").arg(instanceId));
@@ -54,6 +63,13 @@ LibraryScanner::LibraryScanner(
     connect(this, SIGNAL(startScan()),
             this, SLOT(slotStartScan()));
 
+    m_rescanTimer.setSingleShot(true);
+    m_rescanTimer.setInterval(kRescanDelayMillis);
+    connect(&m_rescanTimer, SIGNAL(timeout()),
+            this, SLOT(scan()));
+    connect(&m_directoryWatcher, SIGNAL(directoryChanged(QString)),
+            this, SLOT(slotDirectoryChanged(QString)));
+
     // Force the GUI thread's Track cache to be cleared when a library
     // scan is finished, because we might have modified the database directly
     // when we detected moved files, and the TIOs corresponding to the moved
@@ -104,6 +120,7 @@ void LibraryScanner::run() {
         }
 
         m_libraryHashDao.initialize(dbConnection);
+        m_fileIndexDao.initialize(dbConnection);
         m_cueDao.initialize(dbConnection);
         m_trackDao.initialize(dbConnection);
         m_playlistDao.initialize(dbConnection);
@@ -134,6 +151,7 @@ void LibraryScanner::slotStartScan() {
 
     QSet<QString> trackLocations = m_trackDao.getTrackLocations();
     QHash<QString, int> directoryHashes = m_libraryHashDao.getDirectoryHashes();
+    FileIdentityIndex fileIdentities = m_fileIndexDao.getFileIdentities();
     QRegExp extensionFilter(SoundSourceProxy::getSupportedFileNamesRegex());
     QRegExp coverExtensionFilter =
             QRegExp(CoverArtUtils::supportedCoverArtExtensionsRegex(),
@@ -141,7 +159,8 @@ void LibraryScanner::slotStartScan() {
     QStringList directoryBlacklist = ScannerUtil::getDirectoryBlacklist();
 
     m_scannerGlobal = ScannerGlobalPointer(
-            new ScannerGlobal(trackLocations, directoryHashes, extensionFilter,
+            new ScannerGlobal(trackLocations, directoryHashes, fileIdentities,
+                              extensionFilter,
                               coverExtensionFilter, directoryBlacklist));
 
     m_scannerGlobal->startTimer();
@@ -291,8 +310,29 @@ void LibraryScanner::cleanUpScan() {
     // A.
     m_libraryHashDao.removeDeletedDirectoryHashes();
 
+    // The identities of modified files are only saved after their
+    // metadata has been re-imported. Otherwise the files that have not
+    // been re-imported before canceling would be considered unchanged
+    // by the next scan.
+    kLogger.debug() << "Updating the file index";
+    FileIdentityIndex fileIdentities = m_scannerGlobal->fileIdentitiesChanged();
+    FileIdentityIndex modifiedFileIdentities;
+    for (const QString& trackLocation: m_scannerGlobal->modifiedTracks()) {
+        const auto it = fileIdentities.find(trackLocation);
+        if (it != fileIdentities.end()) {
+            modifiedFileIdentities.insert(it.key(), it.value());
+            fileIdentities.erase(it);
+        }
+    }
+    m_fileIndexDao.saveFileIdentities(fileIdentities);
+    m_fileIndexDao.removeStaleFileIdentities();
+
     transaction.commit();
 
+    kLogger.debug() << "Re-importing metadata of modified files";
+    QSet<TrackId> modifiedTracksChanged;
+    reimportModifiedTracks(modifiedFileIdentities, &modifiedTracksChanged);
+
     kLogger.debug() << "Detecting cover art for unscanned files";
     QSet<TrackId> coverArtTracksChanged;
     m_trackDao.detectCoverArtForTracksWithoutCover(
@@ -300,7 +340,79 @@ void LibraryScanner::cleanUpScan() {
 
     // Update BaseTrackCache via signals connected to the main TrackDAO.
     emit(tracksMoved(tracksMovedSetOld, tracksMovedSetNew));
-    emit(tracksChanged(coverArtTracksChanged));
+    emit(tracksChanged(coverArtTracksChanged + modifiedTracksChanged));
+
+    updateWatchedDirectories();
+}
+
+void LibraryScanner::reimportModifiedTracks(
+        const FileIdentityIndex& modifiedFileIdentities,
+        QSet<TrackId>* pTracksChanged) {
+    FileIdentityIndex reimportedFileIdentities;
+    for (const QString& trackLocation: m_scannerGlobal->modifiedTracks()) {
+        if (m_scannerGlobal->shouldCancel()) {
+            break;
+        }
+        const auto it = modifiedFileIdentities.constFind(trackLocation);
+        if (it != modifiedFileIdentities.constEnd()) {
+            reimportedFileIdentities.insert(it.key(), it.value());
+        }
+        const TrackId trackId = m_trackDao.getTrackId(trackLocation);
+        if (!trackId.isValid()) {
+            continue;
+        }
+        TrackPointer pTrack = m_trackDao.getTrack(trackId);
+        if (!pTrack) {
+            continue;
+        }
+        kLogger.debug() << "Re-importing metadata of modified file"
+                << trackLocation;
+        // The modified track will be saved when it is evicted from
+        // the cache.
+        SoundSourceProxy(pTrack).updateTrackFromSource(
+                SoundSourceProxy::ImportTrackMetadataMode::Again);
+        pTracksChanged->insert(trackId);
+        emit(progressLoading(trackLocation));
+    }
+
+    // Also after canceling for all files that have been re-imported
+    QSqlDatabase dbConnection = mixxx::DbConnectionPooled(m_pDbConnectionPool);
+    ScopedTransaction transaction(dbConnection);
+    m_fileIndexDao.saveFileIdentities(reimportedFileIdentities);
+    transaction.commit();
+}
+
+void LibraryScanner::updateWatchedDirectories() {
+    if (!m_watchDirectories) {
+        return;
+    }
+    const QSet<QString> watchedDirs =
+            QSet<QString>::fromList(m_directoryWatcher.directories());
+    const QSet<QString>& scannedDirs = m_scannerGlobal->scannedDirectories();
+    const QStringList removedDirs = (watchedDirs - scannedDirs).toList();
+    if (!removedDirs.isEmpty()) {
+        m_directoryWatcher.removePaths(removedDirs);
+    }
+    const QStringList addedDirs = (scannedDirs - watchedDirs).toList();
+    if (!addedDirs.isEmpty()) {
+        // Fails for individual directories if the system-wide limit
+        // of watches is exceeded (fs.inotify.max_user_watches)
+        const QStringList failedDirs = m_directoryWatcher.addPaths(addedDirs);
+        if (!failedDirs.isEmpty()) {
+            kLogger.warning()
+                    << "Failed to watch"
+                    << failedDirs.size()
+                    << "of"
+                    << addedDirs.size()
+                    << "directories for changes";
+        }
+    }
+}
+
+void LibraryScanner::slotDirectoryChanged(const QString& directoryPath) {
+    kLogger.debug() << "Directory changed" << directoryPath;
+    // Restarts the timer if it is already running
+    m_rescanTimer.start();
 }
 
 
@@ -340,12 +452,16 @@ void LibraryScanner::slotFinishUnhashedScan() {
            "%d unchanged directories. "
            "%d changed/added directories. "
            "%d tracks verified from changed/added directories. "
-           "%d new tracks.",
+           "%d new tracks. "
+           "%d files checked for modifications. "
+           "%d modified tracks.",
            m_scannerGlobal->timerElapsed().formatNanosWithUnit().toLocal8Bit().constData(),
            m_scannerGlobal->verifiedDirectories().size(),
            m_scannerGlobal->numScannedDirectories(),
            m_scannerGlobal->verifiedTracks().size(),
-           m_scannerGlobal->addedTracks().size());
+           m_scannerGlobal->addedTracks().size(),
+           m_scannerGlobal->numStatedFiles(),
+           m_scannerGlobal->modifiedTracks().size());
 
     m_scannerGlobal.clear();
     changeScannerState(FINISHED);
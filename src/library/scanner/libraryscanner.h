@@ -3,6 +3,8 @@
 
 #include <QThread>
 #include <QThreadPool>
+#include <QFileSystemWatcher>
+#include <QTimer>
 #include <QString>
 #include <QStringList>
 #include <QSemaphore>
@@ -10,6 +12,7 @@
 
 #include "library/dao/cuedao.h"
 #include "library/dao/libraryhashdao.h"
+#include "library/dao/fileindexdao.h"
 #include "library/dao/directorydao.h"
 #include "library/dao/playlistdao.h"
 #include "library/dao/trackdao.h"
@@ -26,6 +29,8 @@ class TrackCollection;
 
 class LibraryScanner : public QThread {
     FRIEND_TEST(LibraryScannerTest, ScannerRoundtrip);
+    // Waits for scans to finish
+    friend class LibraryScannerTest;
     Q_OBJECT
   public:
     LibraryScanner(
@@ -74,6 +79,9 @@ class LibraryScanner : public QThread {
     void slotTrackExists(const QString& trackPath);
     void slotAddNewTrack(const QString& trackPath);
 
+    // File system watcher handler.
+    void slotDirectoryChanged(const QString& directoryPath);
+
   private:
     enum ScannerState {
         IDLE,
@@ -97,6 +105,12 @@ class LibraryScanner : public QThread {
     bool changeScannerState(LibraryScanner::ScannerState newState);
 
     void cleanUpScan();
+    // Saves the file identities of the modified tracks after their
+    // metadata has been re-imported
+    void reimportModifiedTracks(
+            const FileIdentityIndex& modifiedFileIdentities,
+            QSet<TrackId>* pTracksChanged);
+    void updateWatchedDirectories();
 
     mixxx::DbConnectionPoolPtr m_pDbConnectionPool;
 
@@ -109,6 +123,7 @@ class LibraryScanner : public QThread {
 
     // The library scanner thread's DAOs.
     LibraryHashDAO m_libraryHashDao;
+    FileIndexDAO m_fileIndexDao;
     CueDAO m_cueDao;
     PlaylistDAO m_playlistDao;
     DirectoryDAO m_directoryDao;
@@ -126,6 +141,13 @@ class LibraryScanner : public QThread {
     volatile ScannerState m_state;
 
     QStringList m_libraryRootDirs;
+
+    // Optionally watches all directories that have been visited by the
+    // previous scan and triggers a new (incremental) scan after changes
+    // have been detected. Backed by inotify on Linux.
+    const bool m_watchDirectories;
+    QFileSystemWatcher m_directoryWatcher;
+    QTimer m_rescanTimer;
     QScopedPointer<LibraryScannerDlg> m_pProgressDlg;
 };
 
@@ -4,6 +4,7 @@
 
 #include "library/scanner/libraryscanner.h"
 #include "library/scanner/importfilestask.h"
+#include "track/trackfile.h"
 #include "util/timer.h"
 
 RecursiveScanDirectoryTask::RecursiveScanDirectoryTask(
@@ -96,6 +97,21 @@ void RecursiveScanDirectoryTask::run() {
                 emit(directoryHashedAndScanned(dirPath, !prevHashExists, newHash));
             }
         } else {
+            // The list of files is unchanged, but the contents of
+            // individual files might have been modified in place, e.g.
+            // by editing their tags with an external application.
+            // Only those files need to be re-imported.
+            for (const QFileInfo& fileInfo: filesToImport) {
+                if (m_scannerGlobal->shouldCancel()) {
+                    setSuccess(false);
+                    return;
+                }
+                const QString trackLocation(TrackFile(fileInfo).location());
+                if (m_scannerGlobal->updateFileIdentity(trackLocation,
+                        FileIdentity::fromFileInfo(fileInfo))) {
+                    m_scannerGlobal->addModifiedTrack(trackLocation);
+                }
+            }
             emit(directoryUnchanged(dirPath));
         }
     } else {
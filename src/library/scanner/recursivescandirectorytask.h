@@ -9,7 +9,9 @@
 // Recursively scan a music library. Doesn't import tracks for any directories
 // that have already been scanned and have not changed. Changes are tracked by
 // performing a hash of the directory's file list, and those hashes are stored
-// in the database. Successful if the scan completed without being
+// in the database. Files in unchanged directories are only re-imported if
+// their FileIdentity differs from the one recorded by the previous scan.
+// Successful if the scan completed without being
 // cancelled. False if the scan was cancelled part-way through.
 class RecursiveScanDirectoryTask : public ScannerTask {
     Q_OBJECT
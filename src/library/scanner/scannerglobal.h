@@ -7,8 +7,10 @@
 #include <QStringList>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QAtomicInt>
 #include <QSharedPointer>
 
+#include "library/scanner/fileidentity.h"
 #include "util/task.h"
 #include "util/performancetimer.h"
 
@@ -38,18 +40,21 @@ class ScannerGlobal {
   public:
     ScannerGlobal(const QSet<QString>& trackLocations,
                   const QHash<QString, int>& directoryHashes,
+                  const FileIdentityIndex& fileIdentities,
                   const QRegExp& supportedExtensionsMatcher,
                   const QRegExp& supportedCoverExtensionsMatcher,
                   const QStringList& directoriesBlacklist)
             : m_trackLocations(trackLocations),
               m_directoryHashes(directoryHashes),
+              m_fileIdentities(fileIdentities),
               m_supportedExtensionsMatcher(supportedExtensionsMatcher),
               m_supportedCoverExtensionsMatcher(supportedCoverExtensionsMatcher),
               m_directoriesBlacklist(directoriesBlacklist),
               // Unless marked un-clean, we assume it will finish cleanly.
               m_scanFinishedCleanly(true),
               m_shouldCancel(false),
-              m_numScannedDirectories(0) {
+              m_numScannedDirectories(0),
+              m_numStatedFiles(0) {
     }
 
     TaskWatcher& getTaskWatcher() {
@@ -66,6 +71,37 @@ class ScannerGlobal {
         return m_directoryHashes.value(directoryPath, -1);
     }
 
+    // Returns the file identity that has been recorded during a previous
+    // scan or an invalid identity if the file has never been seen.
+    inline FileIdentity fileIdentityInDatabase(const QString& trackLocation) const {
+        return m_fileIdentities.value(trackLocation);
+    }
+
+    // Compares the current identity of a track file with the one from
+    // the previous scan and records any difference. Returns true if the
+    // file has been modified since it has been seen by the previous scan.
+    // Files that are not yet part of the index are only recorded.
+    bool updateFileIdentity(const QString& trackLocation,
+                            const FileIdentity& fileIdentity) {
+        m_numStatedFiles.fetchAndAddRelaxed(1);
+        if (!fileIdentity.isValid()) {
+            return false;
+        }
+        const FileIdentity prevFileIdentity =
+                fileIdentityInDatabase(trackLocation);
+        if (prevFileIdentity == fileIdentity) {
+            return false;
+        }
+        QMutexLocker locker(&m_fileIdentitiesChangedMutex);
+        m_fileIdentitiesChanged.insert(trackLocation, fileIdentity);
+        return prevFileIdentity.isValid();
+    }
+
+    // Only accessed after all tasks have finished.
+    const FileIdentityIndex& fileIdentitiesChanged() const {
+        return m_fileIdentitiesChanged;
+    }
+
     inline bool directoryBlacklisted(const QString& directoryPath) const {
         return m_directoriesBlacklist.contains(directoryPath);
     }
@@ -85,6 +121,11 @@ class ScannerGlobal {
         }
     }
 
+    // Only accessed after all tasks have finished.
+    const QSet<QString>& scannedDirectories() const {
+        return m_directoriesScanned;
+    }
+
     inline void addUnhashedDir(const QDir& dir,
                                const SecurityTokenPointer& token) {
         QMutexLocker locker(&m_directoriesUnhashedMutex);
@@ -149,6 +190,16 @@ class ScannerGlobal {
         return m_verifiedTracks;
     }
 
+    void addModifiedTrack(const QString& trackLocation) {
+        QMutexLocker locker(&m_modifiedTracksMutex);
+        m_modifiedTracks << trackLocation;
+    }
+
+    // Only accessed after all tasks have finished.
+    const QStringList& modifiedTracks() const {
+        return m_modifiedTracks;
+    }
+
     void startTimer() {
         m_timer.start();
     }
@@ -172,12 +223,22 @@ class ScannerGlobal {
         m_numScannedDirectories++;
     }
 
+    int numStatedFiles() const {
+        return m_numStatedFiles.load();
+    }
+
 
   private:
     TaskWatcher m_watcher;
 
     QSet<QString> m_trackLocations;
     QHash<QString, int> m_directoryHashes;
+    FileIdentityIndex m_fileIdentities;
+
+    // New or updated file identities that need to be written back
+    // into the database at the end of the scan.
+    mutable QMutex m_fileIdentitiesChangedMutex;
+    FileIdentityIndex m_fileIdentitiesChanged;
 
     mutable QMutex m_supportedExtensionsMatcherMutex;
     QRegExp m_supportedExtensionsMatcher;
@@ -208,6 +269,11 @@ class ScannerGlobal {
     // The list of tracks verified by the scan.
     QStringList m_verifiedTracks;
 
+    // The list of existing tracks whose files have been modified since
+    // the previous scan and need to be re-imported.
+    mutable QMutex m_modifiedTracksMutex;
+    QStringList m_modifiedTracks;
+
     // The list of tracks added by the scan.
     QStringList m_addedTracks;
 
@@ -217,6 +283,7 @@ class ScannerGlobal {
     // Stats tracking.
     PerformanceTimer m_timer;
     int m_numScannedDirectories;
+    QAtomicInt m_numStatedFiles;
 };
 
 typedef QSharedPointer<ScannerGlobal> ScannerGlobalPointer;
@@ -9,6 +9,42 @@
 #include "util/db/sqllikewildcards.h"
 #include "util/db/dbconnection.h"
 
+namespace {
+
+// Combines a set of track ids with another one, each of them either
+// the set of matching tracks or the complement if negated.
+void combineTrackIdSets(
+        bool conjunction,
+        mixxx::CompressedBitmap* pTrackIds,
+        bool* pNegated,
+        const mixxx::CompressedBitmap& otherTrackIds,
+        bool otherNegated) {
+    if (!conjunction) {
+        // A OR B = NOT (NOT A AND NOT B)
+        *pNegated = !*pNegated;
+        combineTrackIdSets(true, pTrackIds, pNegated, otherTrackIds, !otherNegated);
+        *pNegated = !*pNegated;
+        return;
+    }
+    if (!*pNegated) {
+        if (!otherNegated) {
+            *pTrackIds &= otherTrackIds;
+        } else {
+            *pTrackIds -= otherTrackIds;
+        }
+    } else {
+        if (!otherNegated) {
+            mixxx::CompressedBitmap trackIds = otherTrackIds;
+            trackIds -= *pTrackIds;
+            *pTrackIds = std::move(trackIds);
+            *pNegated = false;
+        } else {
+            *pTrackIds |= otherTrackIds;
+        }
+    }
+}
+
+} // anonymous namespace
 
 QVariant getTrackValueForColumn(const TrackPointer& pTrack, const QString& column) {
     if (column == LIBRARYTABLE_ARTIST) {
@@ -76,6 +112,63 @@ QString QueryNode::concatSqlClauses(
     }
 }
 
+bool GroupNode::combineTrackIds(
+        Operator op,
+        mixxx::CompressedBitmap* pTrackIds,
+        bool* pNegated,
+        std::vector<std::size_t>* pCombined) const {
+    DEBUG_ASSERT(pCombined->empty());
+    for (std::size_t i = 0; i < m_nodes.size(); ++i) {
+        mixxx::CompressedBitmap trackIds;
+        bool negated = false;
+        if (!m_nodes[i]->evaluateTrackIds(&trackIds, &negated)) {
+            continue;
+        }
+        if (pCombined->empty()) {
+            *pTrackIds = std::move(trackIds);
+            *pNegated = negated;
+        } else {
+            combineTrackIdSets(op == Operator::And,
+                    pTrackIds, pNegated, trackIds, negated);
+        }
+        pCombined->push_back(i);
+    }
+    return !pCombined->empty();
+}
+
+QString GroupNode::combinedSql(Operator op) const {
+    mixxx::CompressedBitmap trackIds;
+    bool negated = false;
+    std::vector<std::size_t> combined;
+    QString trackIdsSql;
+    // A single child formats its track ids itself
+    if (combineTrackIds(op, &trackIds, &negated, &combined) &&
+            combined.size() > 1) {
+        trackIdsSql = CrateMembership::formatTrackIdsSql(trackIds, negated);
+    }
+    if (trackIdsSql.isNull()) {
+        combined.clear();
+    }
+
+    QStringList queryFragments;
+    queryFragments.reserve(m_nodes.size());
+    for (std::size_t i = 0; i < m_nodes.size(); ++i) {
+        if (!combined.empty() && i == combined.front()) {
+            queryFragments << trackIdsSql;
+            continue;
+        }
+        if (std::binary_search(combined.begin(), combined.end(), i)) {
+            continue;
+        }
+        QString sql = m_nodes[i]->toSql();
+        if (!sql.isEmpty()) {
+            queryFragments << sql;
+        }
+    }
+    return concatSqlClauses(queryFragments,
+            op == Operator::And ? "AND" : "OR");
+}
+
 bool AndNode::match(const TrackPointer& pTrack) const {
     for (const auto& pNode: m_nodes) {
         if (!pNode->match(pTrack)) {
@@ -88,15 +181,15 @@ bool AndNode::match(const TrackPointer& pTrack) const {
 }
 
 QString AndNode::toSql() const {
-    QStringList queryFragments;
-    queryFragments.reserve(m_nodes.size());
-    for (const auto& pNode: m_nodes) {
-        QString sql = pNode->toSql();
-        if (!sql.isEmpty()) {
-            queryFragments << sql;
-        }
-    }
-    return concatSqlClauses(queryFragments, "AND");
+    return combinedSql(Operator::And);
+}
+
+bool AndNode::evaluateTrackIds(
+        mixxx::CompressedBitmap* pTrackIds,
+        bool* pNegated) const {
+    std::vector<std::size_t> combined;
+    return combineTrackIds(Operator::And, pTrackIds, pNegated, &combined) &&
+            combined.size() == m_nodes.size();
 }
 
 bool OrNode::match(const TrackPointer& pTrack) const {
@@ -117,15 +210,15 @@ bool OrNode::match(const TrackPointer& pTrack) const {
 }
 
 QString OrNode::toSql() const {
-    QStringList queryFragments;
-    queryFragments.reserve(m_nodes.size());
-    for (const auto& pNode: m_nodes) {
-        QString sql = pNode->toSql();
-        if (!sql.isEmpty()) {
-            queryFragments << sql;
-        }
-    }
-    return concatSqlClauses(queryFragments, "OR");
+    return combinedSql(Operator::Or);
+}
+
+bool OrNode::evaluateTrackIds(
+        mixxx::CompressedBitmap* pTrackIds,
+        bool* pNegated) const {
+    std::vector<std::size_t> combined;
+    return combineTrackIds(Operator::Or, pTrackIds, pNegated, &combined) &&
+            combined.size() == m_nodes.size();
 }
 
 bool NotNode::match(const TrackPointer& pTrack) const {
@@ -133,6 +226,14 @@ bool NotNode::match(const TrackPointer& pTrack) const {
 }
 
 QString NotNode::toSql() const {
+    mixxx::CompressedBitmap trackIds;
+    bool negated = false;
+    if (evaluateTrackIds(&trackIds, &negated)) {
+        const QString sql = CrateMembership::formatTrackIdsSql(trackIds, negated);
+        if (!sql.isNull()) {
+            return sql;
+        }
+    }
     QString sql(m_pNode->toSql());
     if (sql.isEmpty()) {
         return QString();
@@ -144,6 +245,16 @@ QString NotNode::toSql() const {
     }
 }
 
+bool NotNode::evaluateTrackIds(
+        mixxx::CompressedBitmap* pTrackIds,
+        bool* pNegated) const {
+    if (!m_pNode->evaluateTrackIds(pTrackIds, pNegated)) {
+        return false;
+    }
+    *pNegated = !*pNegated;
+    return true;
+}
+
 TextFilterNode::TextFilterNode(const QSqlDatabase& database,
                const QStringList& sqlColumns,
                const QString& argument)
@@ -209,59 +320,83 @@ QString NullOrEmptyTextFilterNode::toSql() const {
 }
 
 CrateFilterNode::CrateFilterNode(const CrateStorage* pCrateStorage,
+                                 const CrateMembership* pCrateMembership,
                                  const QString& crateNameLike)
     : m_pCrateStorage(pCrateStorage),
+      m_pCrateMembership(pCrateMembership),
       m_crateNameLike(crateNameLike),
+      m_revision(0),
       m_matchInitialized(false) {
 }
 
-bool CrateFilterNode::match(const TrackPointer& pTrack) const {
-    if (!m_matchInitialized) {
-        CrateTrackSelectResult crateTracks(
-             m_pCrateStorage->selectTracksSortedByCrateNameLike(m_crateNameLike));
-
-        while (crateTracks.next()) {
-            m_matchingTrackIds.push_back(crateTracks.trackId());
-        }
-
+const mixxx::CompressedBitmap& CrateFilterNode::matchingTrackIds() const {
+    if (!m_matchInitialized || m_revision != m_pCrateMembership->revision()) {
+        m_matchingTrackIds = m_pCrateMembership->tracksByCrateNameLike(m_crateNameLike);
+        m_revision = m_pCrateMembership->revision();
         m_matchInitialized = true;
     }
+    return m_matchingTrackIds;
+}
 
-    return std::binary_search(m_matchingTrackIds.begin(), m_matchingTrackIds.end(), pTrack->getId());
+bool CrateFilterNode::match(const TrackPointer& pTrack) const {
+    const TrackId trackId = pTrack->getId();
+    if (!trackId.isValid()) {
+        return false;
+    }
+    return matchingTrackIds().contains(CrateMembership::toBitmapValue(trackId));
 }
 
 QString CrateFilterNode::toSql() const {
+    const QString sql = CrateMembership::formatTrackIdsSql(matchingTrackIds(), false);
+    if (!sql.isNull()) {
+        return sql;
+    }
     return QString("id IN (%1)").arg(
             m_pCrateStorage->formatQueryForTrackIdsByCrateNameLike(m_crateNameLike));
 }
 
+bool CrateFilterNode::evaluateTrackIds(
+        mixxx::CompressedBitmap* pTrackIds,
+        bool* pNegated) const {
+    *pTrackIds = matchingTrackIds();
+    *pNegated = false;
+    return true;
+}
+
 
-NoCrateFilterNode::NoCrateFilterNode(const CrateStorage* pCrateStorage)
+NoCrateFilterNode::NoCrateFilterNode(const CrateStorage* pCrateStorage,
+                                     const CrateMembership* pCrateMembership)
     : m_pCrateStorage(pCrateStorage),
-      m_matchInitialized(false) {
+      m_pCrateMembership(pCrateMembership) {
 }
 
 bool NoCrateFilterNode::match(const TrackPointer& pTrack) const {
-    if (!m_matchInitialized) {
-        TrackSelectResult tracks(
-                m_pCrateStorage->selectAllTracksSorted());
-
-        while (tracks.next()) {
-            m_matchingTrackIds.push_back(tracks.trackId());
-        }
-
-        m_matchInitialized = true;
+    const TrackId trackId = pTrack->getId();
+    if (!trackId.isValid()) {
+        return true;
     }
-
-    return !std::binary_search(m_matchingTrackIds.begin(), m_matchingTrackIds.end(), pTrack->getId());
+    return !m_pCrateMembership->tracksWithCrate().contains(
+            CrateMembership::toBitmapValue(trackId));
 }
 
 QString NoCrateFilterNode::toSql() const {
+    const QString sql = CrateMembership::formatTrackIdsSql(m_pCrateMembership->tracksWithCrate(), true);
+    if (!sql.isNull()) {
+        return sql;
+    }
     return QString("%1 NOT IN (%2)").arg(
             CRATETABLE_ID,
             CrateStorage::formatQueryForTrackIdsWithCrate());
 }
 
+bool NoCrateFilterNode::evaluateTrackIds(
+        mixxx::CompressedBitmap* pTrackIds,
+        bool* pNegated) const {
+    *pTrackIds = m_pCrateMembership->tracksWithCrate();
+    *pNegated = true;
+    return true;
+}
+
 NumericFilterNode::NumericFilterNode(const QStringList& sqlColumns)
         : m_sqlColumns(sqlColumns),
           m_bOperatorQuery(false),
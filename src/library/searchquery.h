@@ -14,7 +14,9 @@
 #include "proto/keys.pb.h"
 #include "util/assert.h"
 #include "util/memory.h"
+#include "library/crate/cratemembership.h"
 #include "library/crate/cratestorage.h"
+#include "util/compressedbitmap.h"
 
 const QString kMissingFieldSearchTerm = "\"\""; // "" searches for an empty string
 
@@ -28,6 +30,17 @@ class QueryNode {
     virtual bool match(const TrackPointer& pTrack) const = 0;
     virtual QString toSql() const = 0;
 
+    // Evaluates the node in memory into the set of matching track ids or,
+    // if *pNegated is set on return, the set of track ids that don't
+    // match. Returns false if the node can only be evaluated by SQL.
+    virtual bool evaluateTrackIds(
+            mixxx::CompressedBitmap* pTrackIds,
+            bool* pNegated) const {
+        Q_UNUSED(pTrackIds);
+        Q_UNUSED(pNegated);
+        return false;
+    }
+
   protected:
     QueryNode() {}
 
@@ -42,6 +55,24 @@ class GroupNode : public QueryNode {
     }
 
   protected:
+    enum class Operator {
+        And,
+        Or,
+    };
+
+    // Combines the track ids of all children that can be evaluated in
+    // memory with set operations. Returns false if none of them can.
+    // The indexes of the combined children are stored in pCombined.
+    bool combineTrackIds(
+            Operator op,
+            mixxx::CompressedBitmap* pTrackIds,
+            bool* pNegated,
+            std::vector<std::size_t>* pCombined) const;
+
+    // The children that can be evaluated in memory are replaced by a
+    // single SQL clause at the position of the first of them
+    QString combinedSql(Operator op) const;
+
     // NOTE(uklotzde): std::vector is more suitable (efficiency)
     // than a QList for a private member. And QList from Qt 4
     // does not support std::unique_ptr yet.
@@ -52,12 +83,18 @@ class OrNode : public GroupNode {
   public:
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool evaluateTrackIds(
+            mixxx::CompressedBitmap* pTrackIds,
+            bool* pNegated) const override;
 };
 
 class AndNode : public GroupNode {
   public:
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool evaluateTrackIds(
+            mixxx::CompressedBitmap* pTrackIds,
+            bool* pNegated) const override;
 };
 
 class NotNode : public QueryNode {
@@ -69,6 +106,9 @@ class NotNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool evaluateTrackIds(
+            mixxx::CompressedBitmap* pTrackIds,
+            bool* pNegated) const override;
 
   private:
     std::unique_ptr<QueryNode> m_pNode;
@@ -106,33 +146,48 @@ class NullOrEmptyTextFilterNode : public QueryNode {
 };
 
 
+// Crate filters are evaluated against the bitmaps of CrateMembership.
+// The SQL subselects are only used if the matching track ids are too
+// many to be listed literally.
 class CrateFilterNode : public QueryNode {
   public:
     CrateFilterNode(const CrateStorage* pCrateStorage,
+                    const CrateMembership* pCrateMembership,
                     const QString& crateNameLike);
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool evaluateTrackIds(
+            mixxx::CompressedBitmap* pTrackIds,
+            bool* pNegated) const override;
 
   private:
+    const mixxx::CompressedBitmap& matchingTrackIds() const;
+
     const CrateStorage* m_pCrateStorage;
+    const CrateMembership* m_pCrateMembership;
     QString m_crateNameLike;
+    // The revision of CrateMembership that m_matchingTrackIds are
+    // derived from
+    mutable quint64 m_revision;
     mutable bool m_matchInitialized;
-    mutable std::vector<TrackId> m_matchingTrackIds;
+    mutable mixxx::CompressedBitmap m_matchingTrackIds;
 };
 
 class NoCrateFilterNode : public QueryNode {
   public:
-    explicit NoCrateFilterNode(const CrateStorage* pCrateStorage);
+    NoCrateFilterNode(const CrateStorage* pCrateStorage,
+                      const CrateMembership* pCrateMembership);
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool evaluateTrackIds(
+            mixxx::CompressedBitmap* pTrackIds,
+            bool* pNegated) const override;
 
   private:
     const CrateStorage* m_pCrateStorage;
-    QString m_crateNameLike;
-    mutable bool m_matchInitialized;
-    mutable std::vector<TrackId> m_matchingTrackIds;
+    const CrateMembership* m_pCrateMembership;
 };
 
 class NumericFilterNode : public QueryNode {
@@ -150,7 +150,8 @@ void SearchQueryParser::parseTokens(QStringList tokens,
                 qDebug() << "argument explicit empty";
                 if (field == "crate") {
                     pNode = std::make_unique<NoCrateFilterNode>(
-                          &m_pTrackCollection->crates());
+                          &m_pTrackCollection->crates(),
+                          &m_pTrackCollection->crateMembership());
                     qDebug() << pNode->toSql();
                 } else {
                     pNode = std::make_unique<NullOrEmptyTextFilterNode>(
@@ -160,7 +161,9 @@ void SearchQueryParser::parseTokens(QStringList tokens,
             } else if (!argument.isEmpty()) {
                 if (field == "crate") {
                     pNode = std::make_unique<CrateFilterNode>(
-                            &m_pTrackCollection->crates(), argument);
+                            &m_pTrackCollection->crates(),
+                            &m_pTrackCollection->crateMembership(),
+                            argument);
                 } else {
                     pNode = std::make_unique<TextFilterNode>(
                             m_pTrackCollection->database(),
@@ -228,7 +231,9 @@ void SearchQueryParser::parseTokens(QStringList tokens,
                     std::unique_ptr<OrNode> gNode = std::make_unique<OrNode>();
 
                     gNode->addNode(std::make_unique<CrateFilterNode>(
-                                    &m_pTrackCollection->crates(), argument));
+                                    &m_pTrackCollection->crates(),
+                                    &m_pTrackCollection->crateMembership(),
+                                    argument));
                     gNode->addNode(std::make_unique<TextFilterNode>(
                                     m_pTrackCollection->database(), queryColumns, argument));
 
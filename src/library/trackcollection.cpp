@@ -1,6 +1,7 @@
 #include <QStringBuilder>
 #include <QThread>
 #include <QApplication>
+#include <QMessageBox>
 
 #include "library/trackcollection.h"
 
@@ -18,9 +19,26 @@ namespace {
 TrackCollection::TrackCollection(
         const UserSettingsPointer& pConfig)
         : m_pConfig(pConfig),
+          m_crateMembership(&m_crates),
           m_analysisDao(pConfig),
           m_trackDao(m_cueDao, m_playlistDao,
                      m_analysisDao, m_libraryHashDao, pConfig) {
+    // Connected first and directly for updating the bitmaps before
+    // any other receiver of the signals might filter by crate
+    connect(this, SIGNAL(crateInserted(CrateId)),
+            &m_crateMembership, SLOT(slotCrateInserted(CrateId)),
+            Qt::DirectConnection);
+    connect(this, SIGNAL(crateUpdated(CrateId)),
+            &m_crateMembership, SLOT(slotCrateUpdated(CrateId)),
+            Qt::DirectConnection);
+    connect(this, SIGNAL(crateDeleted(CrateId)),
+            &m_crateMembership, SLOT(slotCrateDeleted(CrateId)),
+            Qt::DirectConnection);
+    connect(this, SIGNAL(crateTracksChanged(CrateId,QList<TrackId>,QList<TrackId>)),
+            &m_crateMembership, SLOT(slotCrateTracksChanged(CrateId,QList<TrackId>,QList<TrackId>)),
+            Qt::DirectConnection);
+    connect(&m_playlistDao, SIGNAL(appendingTracksFailed(int,int)),
+            this, SLOT(slotAppendingTracksToPlaylistFailed(int,int)));
 }
 
 TrackCollection::~TrackCollection() {
@@ -48,14 +66,56 @@ void TrackCollection::connectDatabase(QSqlDatabase database) {
     m_analysisDao.initialize(database);
     m_libraryHashDao.initialize(database);
     m_crates.connectDatabase(database);
+    m_crateMembership.reset();
 }
 
 void TrackCollection::disconnectDatabase() {
     DEBUG_ASSERT(QApplication::instance()->thread() == QThread::currentThread());
 
+    if (m_pDbWriter) {
+        // Finish all pending mutations before closing the connection
+        m_pDbWriter->stop();
+        m_playlistDao.setDbWriter(nullptr);
+        m_pDbWriter.reset();
+    }
     m_database = QSqlDatabase();
     m_trackDao.finish();
     m_crates.disconnectDatabase();
+    m_crateMembership.reset();
+}
+
+void TrackCollection::setDbConnectionPool(
+        mixxx::DbConnectionPoolPtr pDbConnectionPool) {
+    DEBUG_ASSERT(QApplication::instance()->thread() == QThread::currentThread());
+
+    if (m_pDbWriter) {
+        m_pDbWriter->stop();
+        m_playlistDao.setDbWriter(nullptr);
+        m_pDbWriter.reset();
+    }
+    m_pDbConnectionPool = std::move(pDbConnectionPool);
+    if (m_pDbConnectionPool) {
+        m_pDbWriter = std::make_unique<mixxx::DbWriter>(
+                m_pDbConnectionPool, "TrackCollection");
+        m_pDbWriter->start(QThread::LowPriority);
+        m_playlistDao.setDbWriter(m_pDbWriter.get());
+    }
+}
+
+void TrackCollection::finishPendingWrites() {
+    if (m_pDbWriter) {
+        m_pDbWriter->finishPending();
+    }
+}
+
+void TrackCollection::slotAppendingTracksToPlaylistFailed(
+        int playlistId, int trackCount) {
+    QMessageBox::warning(
+            nullptr,
+            tr("Adding tracks to playlist"),
+            tr("Failed to add %1 track(s) to the playlist \"%2\".")
+                    .arg(QString::number(trackCount),
+                            m_playlistDao.getPlaylistName(playlistId)));
 }
 
 void TrackCollection::setTrackSource(QSharedPointer<BaseTrackCache> pTrackSource) {
@@ -90,6 +150,8 @@ void TrackCollection::relocateDirectory(QString oldDir, QString newDir) {
 bool TrackCollection::hideTracks(const QList<TrackId>& trackIds) {
     DEBUG_ASSERT(QApplication::instance()->thread() == QThread::currentThread());
 
+    finishPendingWrites();
+
     // Warn if tracks have a playlist membership
     QSet<int> allPlaylistIds;
     for (const auto& trackId: trackIds) {
@@ -186,6 +248,8 @@ bool TrackCollection::purgeTracks(
         const QList<TrackId>& trackIds) {
     DEBUG_ASSERT(QApplication::instance()->thread() == QThread::currentThread());
 
+    finishPendingWrites();
+
     // Transactional
     SqlTransaction transaction(m_database);
     VERIFY_OR_DEBUG_ASSERT(transaction) {
@@ -205,6 +269,7 @@ bool TrackCollection::purgeTracks(
     VERIFY_OR_DEBUG_ASSERT(transaction.commit()) {
         return false;
     }
+    m_crateMembership.onPurgedTracks(trackIds);
     // TODO(XXX): Move reversible actions inside transaction
     m_cueDao.deleteCuesForTracks(trackIds);
     m_playlistDao.removeTracksFromPlaylists(trackIds);
@@ -281,6 +346,8 @@ bool TrackCollection::deleteCrate(
         CrateId crateId) {
     DEBUG_ASSERT(QApplication::instance()->thread() == QThread::currentThread());
 
+    finishPendingWrites();
+
     // Transactional
     SqlTransaction transaction(m_database);
     VERIFY_OR_DEBUG_ASSERT(transaction) {
@@ -304,6 +371,8 @@ bool TrackCollection::addCrateTracks(
         const QList<TrackId>& trackIds) {
     DEBUG_ASSERT(QApplication::instance()->thread() == QThread::currentThread());
 
+    finishPendingWrites();
+
     // Transactional
     SqlTransaction transaction(m_database);
     VERIFY_OR_DEBUG_ASSERT(transaction) {
@@ -322,11 +391,50 @@ bool TrackCollection::addCrateTracks(
     return true;
 }
 
+void TrackCollection::addCrateTracksAsync(
+        CrateId crateId,
+        const QList<TrackId>& trackIds) {
+    DEBUG_ASSERT(QApplication::instance()->thread() == QThread::currentThread());
+
+    if (!m_pDbWriter) {
+        addCrateTracks(crateId, trackIds);
+        return;
+    }
+    m_pDbWriter->enqueue(
+            [crateId, trackIds](QSqlDatabase database) {
+                return CrateStorage::onAddingCrateTracks(
+                        database, crateId, trackIds);
+            },
+            [this, crateId, trackIds](bool succeeded) {
+                if (!succeeded) {
+                    kLogger.warning()
+                            << "Failed to add"
+                            << trackIds.size()
+                            << "tracks to crate"
+                            << crateId;
+                    Crate crate;
+                    m_crates.readCrateById(crateId, &crate);
+                    QMessageBox::warning(
+                            nullptr,
+                            tr("Adding tracks to crate"),
+                            tr("Failed to add %1 track(s) to the crate \"%2\".")
+                                    .arg(QString::number(trackIds.size()),
+                                            crate.getName()));
+                    return;
+                }
+                // Emit signals
+                emit(crateTracksChanged(crateId, trackIds, QList<TrackId>()));
+            },
+            this);
+}
+
 bool TrackCollection::removeCrateTracks(
         CrateId crateId,
         const QList<TrackId>& trackIds) {
     DEBUG_ASSERT(QApplication::instance()->thread() == QThread::currentThread());
 
+    finishPendingWrites();
+
     // Transactional
     SqlTransaction transaction(m_database);
     VERIFY_OR_DEBUG_ASSERT(transaction) {
@@ -7,6 +7,7 @@
 
 #include "preferences/usersettings.h"
 #include "library/basetrackcache.h"
+#include "library/crate/cratemembership.h"
 #include "library/crate/cratestorage.h"
 #include "library/dao/trackdao.h"
 #include "library/dao/cuedao.h"
@@ -14,6 +15,9 @@
 #include "library/dao/analysisdao.h"
 #include "library/dao/directorydao.h"
 #include "library/dao/libraryhashdao.h"
+#include "util/db/dbconnectionpool.h"
+#include "util/db/dbwriter.h"
+#include "util/memory.h"
 
 
 // forward declaration(s)
@@ -40,9 +44,25 @@ class TrackCollection : public QObject,
         return m_database;
     }
 
+    // For executing queries in worker threads, might be null
+    const mixxx::DbConnectionPoolPtr& dbConnectionPool() const {
+        return m_pDbConnectionPool;
+    }
+    // Also starts the writer thread
+    void setDbConnectionPool(mixxx::DbConnectionPoolPtr pDbConnectionPool);
+
+    // For executing mutations in the writer thread, might be null
+    mixxx::DbWriter* dbWriter() const {
+        return m_pDbWriter.get();
+    }
+
     const CrateStorage& crates() const {
         return m_crates;
     }
+    // The tracks of all crates in memory for filtering
+    const CrateMembership& crateMembership() const {
+        return m_crateMembership;
+    }
 
     TrackDAO& getTrackDAO() {
         return m_trackDao;
@@ -76,6 +96,10 @@ class TrackCollection : public QObject,
     bool updateCrate(const Crate& crate);
     bool deleteCrate(CrateId crateId);
     bool addCrateTracks(CrateId crateId, const QList<TrackId>& trackIds);
+    // Adds the tracks in the writer thread if available. The signals are
+    // emitted after the tracks have been added. All synchronous
+    // modifications of crate tracks wait for these pending additions.
+    void addCrateTracksAsync(CrateId crateId, const QList<TrackId>& trackIds);
     bool removeCrateTracks(CrateId crateId, const QList<TrackId>& trackIds);
 
     bool updateAutoDjCrate(CrateId crateId, bool isAutoDjSource);
@@ -98,13 +122,23 @@ class TrackCollection : public QObject,
     void crateSummaryChanged(
             const QSet<CrateId>& crates);
 
+  private slots:
+    void slotAppendingTracksToPlaylistFailed(int playlistId, int trackCount);
+
   private:
+    // Waits until all tracks that are added asynchronously have been
+    // added to their playlists and crates
+    void finishPendingWrites();
+
     UserSettingsPointer m_pConfig;
 
     QSqlDatabase m_database;
+    mixxx::DbConnectionPoolPtr m_pDbConnectionPool;
+    std::unique_ptr<mixxx::DbWriter> m_pDbWriter;
 
     PlaylistDAO m_playlistDao;
     CrateStorage m_crates;
+    CrateMembership m_crateMembership;
     CueDAO m_cueDao;
     DirectoryDAO m_directoryDao;
     AnalysisDao m_analysisDao;
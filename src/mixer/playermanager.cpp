@@ -127,7 +127,10 @@ void PlayerManager::bindToLibrary(Library* pLibrary) {
             pLibrary,
             kNumberOfAnalyzerThreads,
             m_pConfig,
-            AnalyzerModeFlags::WithWaveform);
+            // Deliver beats and key of the first minute quickly
+            static_cast<AnalyzerModeFlags>(
+                    AnalyzerModeFlags::WithWaveform |
+                    AnalyzerModeFlags::Progressive));
 
     connect(m_pTrackAnalysisScheduler.get(), &TrackAnalysisScheduler::trackProgress,
             this, &PlayerManager::onTrackAnalysisProgress);
@@ -651,14 +654,25 @@ void PlayerManager::slotAnalyzeTrack(TrackPointer track) {
         if (m_pTrackAnalysisScheduler->scheduleTrackById(track->getId())) {
             m_pTrackAnalysisScheduler->resume();
         }
-        // The first progress signal will suspend a running batch analysis
+        // Pause the threads of a running batch analysis that are needed
         // until all loaded tracks have been analyzed. Emit it once just now
         // before any signals from the analyzer queue arrive.
+        emit trackAnalyzerBusy(math_min(
+                m_pTrackAnalysisScheduler->scheduledTracksCount(),
+                kNumberOfAnalyzerThreads));
         emit trackAnalyzerProgress(track->getId(), kAnalyzerProgressUnknown);
     }
 }
 
 void PlayerManager::onTrackAnalysisProgress(TrackId trackId, AnalyzerProgress analyzerProgress) {
+    if (m_pTrackAnalysisScheduler) {
+        const int scheduledTracksCount =
+                m_pTrackAnalysisScheduler->scheduledTracksCount();
+        if (scheduledTracksCount > 0) {
+            emit trackAnalyzerBusy(math_min(
+                    scheduledTracksCount, kNumberOfAnalyzerThreads));
+        }
+    }
     emit trackAnalyzerProgress(trackId, analyzerProgress);
 }
 
@@ -228,6 +228,9 @@ class PlayerManager : public QObject, public PlayerManagerInterface {
     void numberOfDecksChanged(int decks);
 
     void trackAnalyzerProgress(TrackId trackId, AnalyzerProgress analyzerProgress);
+    // The number of analyzer threads that are needed for analyzing the
+    // loaded tracks.
+    void trackAnalyzerBusy(int threadsCount);
     void trackAnalyzerIdle();
 
   private:
@@ -35,12 +35,14 @@
 #include "preferences/constants.h"
 #include "dialog/dlgdevelopertools.h"
 #include "engine/enginemaster.h"
+#include "engine/offlinerenderer.h"
 #include "effects/effectsmanager.h"
 #include "effects/builtin/builtinbackend.h"
 #ifdef __LILV__
 #include "effects/lv2/lv2backend.h"
 #endif
 #include "library/coverartcache.h"
+#include "library/coverartthumbnailstore.h"
 #include "library/library.h"
 #include "library/library_preferences.h"
 #include "controllers/controllermanager.h"
@@ -143,6 +145,7 @@ MixxxMainWindow::MixxxMainWindow(QApplication* pApp, const CmdlineArgs& args)
           m_pEngine(nullptr),
           m_pSkinLoader(nullptr),
           m_pSoundManager(nullptr),
+          m_pOfflineRenderer(nullptr),
           m_pPlayerManager(nullptr),
           m_pRecordingManager(nullptr),
 #ifdef __BROADCAST__
@@ -192,7 +195,12 @@ MixxxMainWindow::MixxxMainWindow(QApplication* pApp, const CmdlineArgs& args)
     m_pWidgetParent = (QWidget*)m_pLaunchImage;
     setCentralWidget(m_pWidgetParent);
 
-    show();
+    // The main window is still created when rendering into a file, because
+    // the library, the skin and the controllers are all set up as part of
+    // it. It is just not shown.
+    if (!args.getOfflineRenderingEnabled()) {
+        show();
+    }
     pApp->processEvents();
 
     initialize(pApp, args);
@@ -331,6 +339,8 @@ void MixxxMainWindow::initialize(QApplication* pApp, const CmdlineArgs& args) {
 #endif
 
     CoverArtCache::createInstance();
+    CoverArtThumbnailStore::instance()->open(
+            QDir(pConfig->getSettingsPath()).filePath("covers"));
 
     m_pDbConnectionPool = MixxxDb(pConfig).connectionPool();
     if (!m_pDbConnectionPool) {
@@ -502,7 +512,8 @@ void MixxxMainWindow::initialize(QApplication* pApp, const CmdlineArgs& args) {
     // mode.
     bool fullscreenPref = pConfig->getValue<bool>(
             ConfigKey("[Config]", "StartInFullscreen"));
-    if (args.getStartInFullscreen() || fullscreenPref) {
+    if ((args.getStartInFullscreen() || fullscreenPref) &&
+            !args.getOfflineRenderingEnabled()) {
         slotViewFullScreen(true);
     }
     emit(newSkinLoaded());
@@ -536,49 +547,69 @@ void MixxxMainWindow::initialize(QApplication* pApp, const CmdlineArgs& args) {
     // https://bugs.launchpad.net/mixxx/+bug/1758189
     m_pPlayerManager->loadSamplers();
 
-    // Try open player device If that fails, the preference panel is opened.
-    bool retryClicked;
-    do {
-        retryClicked = false;
-        SoundDeviceError result = m_pSoundManager->setupDevices();
-        if (result == SOUNDDEVICE_ERROR_DEVICE_COUNT ||
-                result == SOUNDDEVICE_ERROR_EXCESSIVE_OUTPUT_CHANNEL) {
-            if (soundDeviceBusyDlg(&retryClicked) != QDialog::Accepted) {
-                exit(0);
+    // When rendering into a file no sound device is opened at all, the
+    // OfflineRenderer is the clock reference of the engine instead.
+    if (!args.getOfflineRenderingEnabled()) {
+        // Try open player device If that fails, the preference panel is opened.
+        bool retryClicked;
+        do {
+            retryClicked = false;
+            SoundDeviceError result = m_pSoundManager->setupDevices();
+            if (result == SOUNDDEVICE_ERROR_DEVICE_COUNT ||
+                    result == SOUNDDEVICE_ERROR_EXCESSIVE_OUTPUT_CHANNEL) {
+                if (soundDeviceBusyDlg(&retryClicked) != QDialog::Accepted) {
+                    exit(0);
+                }
+            } else if (result != SOUNDDEVICE_ERROR_OK) {
+                if (soundDeviceErrorMsgDlg(result, &retryClicked) !=
+                        QDialog::Accepted) {
+                    exit(0);
+                }
             }
-        } else if (result != SOUNDDEVICE_ERROR_OK) {
-            if (soundDeviceErrorMsgDlg(result, &retryClicked) !=
-                    QDialog::Accepted) {
+        } while (retryClicked);
+
+        // test for at least one out device, if none, display another dlg that
+        // says "mixxx will barely work with no outs"
+        // In case persisting errors, the user has already received a message
+        // box from the preferences dialog above. So we can watch here just the
+        // output count.
+        while (m_pSoundManager->getConfig().getOutputs().count() == 0) {
+            // Exit when we press the Exit button in the noSoundDlg dialog
+            // only call it if result != OK
+            bool continueClicked = false;
+            if (noOutputDlg(&continueClicked) != QDialog::Accepted) {
                 exit(0);
             }
-        }
-    } while (retryClicked);
-
-    // test for at least one out device, if none, display another dlg that
-    // says "mixxx will barely work with no outs"
-    // In case persisting errors, the user has already received a message
-    // box from the preferences dialog above. So we can watch here just the
-    // output count.
-    while (m_pSoundManager->getConfig().getOutputs().count() == 0) {
-        // Exit when we press the Exit button in the noSoundDlg dialog
-        // only call it if result != OK
-        bool continueClicked = false;
-        if (noOutputDlg(&continueClicked) != QDialog::Accepted) {
-            exit(0);
-        }
-        if (continueClicked) break;
-   }
+            if (continueClicked) break;
+       }
+    }
 
     // Load tracks in args.qlMusicFiles (command line arguments) into player
     // 1 and 2:
     const QList<QString>& musicFiles = args.getMusicFiles();
+    QStringList loadedGroups;
     for (int i = 0; i < (int)m_pPlayerManager->numDecks()
             && i < musicFiles.count(); ++i) {
         if (SoundSourceProxy::isFileNameSupported(musicFiles.at(i))) {
             m_pPlayerManager->slotLoadToDeck(musicFiles.at(i), i+1);
+            loadedGroups.append(PlayerManager::groupForDeck(i));
         }
     }
 
+    if (args.getOfflineRenderingEnabled()) {
+        // Renders the decks with the tracks from the command line
+        m_pOfflineRenderer = new OfflineRenderer(pConfig, m_pEngine,
+                args.getRenderPath(),
+                loadedGroups,
+                mixxx::Duration::fromSeconds(args.getRenderSeconds()));
+        connect(m_pOfflineRenderer,
+                &OfflineRenderer::renderingFinished,
+                this,
+                &MixxxMainWindow::close,
+                Qt::QueuedConnection);
+        m_pOfflineRenderer->start();
+    }
+
     connect(&PlayerInfo::instance(),
             &PlayerInfo::currentPlayingTrackChanged,
             this,
@@ -651,6 +682,14 @@ void MixxxMainWindow::finalize() {
     qDebug() << t.elapsed(false).debugMillisWithUnit() << "stopping pending Library tasks";
     m_pLibrary->stopFeatures();
 
+    if (m_pOfflineRenderer) {
+        qDebug() << t.elapsed(false).debugMillisWithUnit() << "stopping OfflineRenderer";
+        m_pOfflineRenderer->stop();
+        m_pOfflineRenderer->wait();
+        delete m_pOfflineRenderer;
+        m_pOfflineRenderer = nullptr;
+    }
+
     // SoundManager depend on Engine and Config
     qDebug() << t.elapsed(false).debugMillisWithUnit() << "deleting SoundManager";
     delete m_pSoundManager;
@@ -1503,6 +1542,10 @@ void MixxxMainWindow::checkDirectRendering() {
 }
 
 bool MixxxMainWindow::confirmExit() {
+    if (m_pOfflineRenderer) {
+        // Rendering has finished or been aborted, nobody to ask
+        return true;
+    }
     bool playing(false);
     bool playingSampler(false);
     unsigned int deckCount = m_pPlayerManager->numDecks();
@@ -41,6 +41,7 @@ class EngineMaster;
 class GuiTick;
 class VisualsManager;
 class LaunchImage;
+class OfflineRenderer;
 class Library;
 class KeyboardEventFilter;
 class PlayerManager;
@@ -157,6 +158,9 @@ class MixxxMainWindow : public QMainWindow {
     // The sound manager
     SoundManager* m_pSoundManager;
 
+    // Replaces the sound devices when rendering to a file (--renderTo)
+    OfflineRenderer* m_pOfflineRenderer;
+
     // Keeps track of players
     PlayerManager* m_pPlayerManager;
     // RecordingManager
@@ -0,0 +1,297 @@
+#include "soundio/audiocallbackmonitor.h"
+
+#include <QDir>
+#include <QTextStream>
+
+#include "control/controlobject.h"
+#include "util/logger.h"
+#include "util/math.h"
+
+namespace {
+
+const mixxx::Logger kLogger("AudioCallbackMonitor");
+
+const QString kTraceFileName = QStringLiteral("audio_callback_trace.csv");
+
+// The trace file is moved to kTraceFileName.1 when it exceeds this size
+// so that both files together never exceed twice this size.
+const qint64 kMaxTraceFileSize = 4 * 1024 * 1024;
+
+// Room for 16 overrun histories between two updates
+const int kOverrunFifoSize = 256;
+
+const int kUpdateIntervalMillis = 1000;
+
+const double kDefaultThreshold = 0.9;
+
+const char* stageName(AudioCallbackMonitor::Stage stage) {
+    switch (stage) {
+    case AudioCallbackMonitor::Stage::Input:
+        return "input";
+    case AudioCallbackMonitor::Stage::Channels:
+        return "channels";
+    case AudioCallbackMonitor::Stage::Mixing:
+        return "mixing";
+    case AudioCallbackMonitor::Stage::Outputs:
+        return "outputs";
+    case AudioCallbackMonitor::Stage::Workers:
+        return "workers";
+    case AudioCallbackMonitor::Stage::Output:
+        return "output";
+    case AudioCallbackMonitor::Stage::Count:
+        break;
+    }
+    return "unknown";
+}
+
+mixxx::Duration stageTime(const AudioCallbackMonitor::Record& record,
+        AudioCallbackMonitor::Stage stage) {
+    switch (stage) {
+    case AudioCallbackMonitor::Stage::Input:
+        return record.input;
+    case AudioCallbackMonitor::Stage::Channels:
+        return record.engine.channels;
+    case AudioCallbackMonitor::Stage::Mixing:
+        return record.engine.mixing;
+    case AudioCallbackMonitor::Stage::Outputs:
+        return record.engine.outputs;
+    case AudioCallbackMonitor::Stage::Workers:
+        return record.engine.workers;
+    case AudioCallbackMonitor::Stage::Output:
+        return record.output;
+    case AudioCallbackMonitor::Stage::Count:
+        break;
+    }
+    return mixxx::Duration();
+}
+
+AudioCallbackMonitor::Stage slowestStage(
+        const AudioCallbackMonitor::Record& record) {
+    AudioCallbackMonitor::Stage slowest = AudioCallbackMonitor::Stage::Input;
+    for (int i = 0; i < static_cast<int>(AudioCallbackMonitor::Stage::Count); ++i) {
+        const auto stage = static_cast<AudioCallbackMonitor::Stage>(i);
+        if (stageTime(record, stage) > stageTime(record, slowest)) {
+            slowest = stage;
+        }
+    }
+    return slowest;
+}
+
+QString formatMicros(mixxx::Duration duration) {
+    return QString::number(duration.toDoubleMicros(), 'f', 0);
+}
+
+// Formats the times of all processed effect chains as a single quoted
+// CSV field like "chain1=12;chain2=34".
+QString formatEffectChains(const EngineMaster::StageTimes& stageTimes) {
+    QString result = QStringLiteral("\"");
+    for (int i = 0; i < stageTimes.effectChainCount; ++i) {
+        const auto& chainTime = stageTimes.effectChains[i];
+        if (i > 0) {
+            result += ';';
+        }
+        result += QString::fromLatin1(chainTime.id).replace('"', QStringLiteral("\"\""));
+        result += '=';
+        result += formatMicros(chainTime.time);
+    }
+    if (stageTimes.effectChainsOmitted > 0) {
+        if (stageTimes.effectChainCount > 0) {
+            result += ';';
+        }
+        result += QString("+%1").arg(stageTimes.effectChainsOmitted);
+    }
+    result += '"';
+    return result;
+}
+
+const EngineMaster::StageTimes::EffectChainTime* slowestEffectChain(
+        const EngineMaster::StageTimes& stageTimes) {
+    const EngineMaster::StageTimes::EffectChainTime* pSlowest = nullptr;
+    for (int i = 0; i < stageTimes.effectChainCount; ++i) {
+        const auto& chainTime = stageTimes.effectChains[i];
+        if (!pSlowest || chainTime.time > pSlowest->time) {
+            pSlowest = &chainTime;
+        }
+    }
+    return pSlowest;
+}
+
+} // anonymous namespace
+
+AudioCallbackMonitor::AudioCallbackMonitor(UserSettingsPointer pConfig,
+        EngineMaster* pEngineMaster)
+        : m_pConfig(pConfig),
+          m_pEngineMaster(pEngineMaster),
+          m_callbackCount(0),
+          m_nextUnreportedCallback(0),
+          m_overrunFifo(kOverrunFifoSize),
+          m_overrunCount(0),
+          m_droppedHistories(0),
+          m_traceFile(QDir(pConfig->getSettingsPath()).filePath(kTraceFileName)) {
+    m_pThreshold = new ControlObject(
+            ConfigKey("[Master]", "audio_callback_deadline_threshold"),
+            true, false, true, kDefaultThreshold);
+    m_pOverrunCount = new ControlObject(
+            ConfigKey("[Master]", "audio_callback_overrun_count"));
+    m_pOverrunCount->setReadOnly();
+    m_pOverrunUsage = new ControlObject(
+            ConfigKey("[Master]", "audio_callback_overrun_usage"));
+    m_pOverrunUsage->setReadOnly();
+    m_pOverrunStage = new ControlObject(
+            ConfigKey("[Master]", "audio_callback_overrun_stage"));
+    m_pOverrunStage->setReadOnly();
+
+    connect(&m_timer, &QTimer::timeout,
+            this, &AudioCallbackMonitor::slotProcessOverruns);
+    m_timer.start(kUpdateIntervalMillis);
+
+    m_pEngineMaster->setStageTimingEnabled(true);
+}
+
+AudioCallbackMonitor::~AudioCallbackMonitor() {
+    m_pEngineMaster->setStageTimingEnabled(false);
+    m_timer.stop();
+    delete m_pOverrunStage;
+    delete m_pOverrunUsage;
+    delete m_pOverrunCount;
+    delete m_pThreshold;
+}
+
+void AudioCallbackMonitor::onCallbackFinished(mixxx::Duration deadline,
+        mixxx::Duration total,
+        mixxx::Duration input,
+        mixxx::Duration output) {
+    Record& record = m_history[m_callbackCount % kHistorySize];
+    record.callback = m_callbackCount++;
+    record.deadline = deadline;
+    record.total = total;
+    record.input = input;
+    record.engine = m_pEngineMaster->getLastStageTimes();
+    record.output = output;
+    record.overrun = total.toDoubleSeconds() >
+            m_pThreshold->get() * deadline.toDoubleSeconds();
+    if (!record.overrun) {
+        return;
+    }
+
+    m_overrunCount.fetch_add(1);
+    // Hand over the history in chronological order, ending with the
+    // callback that overran. Callbacks that have already been handed
+    // over with a previous overrun are skipped.
+    quint64 first = math_max(m_nextUnreportedCallback,
+            m_callbackCount - math_min<quint64>(m_callbackCount, kHistorySize));
+    const int count = static_cast<int>(m_callbackCount - first);
+    if (m_overrunFifo.writeAvailable() < count) {
+        m_droppedHistories.fetch_add(1);
+        return;
+    }
+    for (; first < m_callbackCount; ++first) {
+        m_overrunFifo.write(&m_history[first % kHistorySize], 1);
+    }
+    m_nextUnreportedCallback = m_callbackCount;
+}
+
+void AudioCallbackMonitor::slotProcessOverruns() {
+    m_pOverrunCount->forceSet(m_overrunCount.load());
+    const int droppedHistories = m_droppedHistories.exchange(0);
+    if (droppedHistories > 0) {
+        kLogger.warning()
+                << "Discarded the history of" << droppedHistories
+                << "audio callback overruns";
+    }
+
+    Record record;
+    while (m_overrunFifo.read(&record, 1) == 1) {
+        traceRecord(record);
+        if (record.overrun) {
+            logOverrun(record);
+        }
+    }
+    if (m_traceFile.isOpen()) {
+        m_traceFile.flush();
+    }
+}
+
+void AudioCallbackMonitor::logOverrun(const Record& record) {
+    const Stage stage = slowestStage(record);
+    const double usage = record.total.toDoubleSeconds() /
+            record.deadline.toDoubleSeconds();
+    m_pOverrunUsage->forceSet(usage);
+    m_pOverrunStage->forceSet(static_cast<int>(stage));
+
+    auto log = kLogger.warning();
+    log << "Audio callback" << record.callback
+        << "took" << record.total.debugMicrosWithUnit()
+        << "of" << record.deadline.debugMicrosWithUnit()
+        << "- slowest stage:" << stageName(stage)
+        << stageTime(record, stage).debugMicrosWithUnit();
+    if (record.engine.slowestChannel >= 0) {
+        log << "- slowest channel:"
+            << m_pEngineMaster->getChannelGroup(record.engine.slowestChannel)
+            << record.engine.slowestChannelTime.debugMicrosWithUnit();
+    }
+    const auto* pSlowestChain = slowestEffectChain(record.engine);
+    if (pSlowestChain) {
+        log << "- slowest effect chain:"
+            << pSlowestChain->id
+            << pSlowestChain->time.debugMicrosWithUnit();
+    }
+}
+
+bool AudioCallbackMonitor::openTraceFile() {
+    if (m_traceFile.isOpen()) {
+        if (m_traceFile.size() < kMaxTraceFileSize) {
+            return true;
+        }
+        m_traceFile.close();
+    }
+    if (m_traceFile.size() >= kMaxTraceFileSize) {
+        const QString backupFileName = m_traceFile.fileName() + ".1";
+        QFile::remove(backupFileName);
+        if (!m_traceFile.rename(backupFileName)) {
+            kLogger.warning() << "Failed to rotate" << m_traceFile.fileName();
+            m_traceFile.remove();
+        }
+        // QFile::rename() changes the file name of the object
+        m_traceFile.setFileName(
+                QDir(m_pConfig->getSettingsPath()).filePath(kTraceFileName));
+    }
+
+    const bool newFile = !m_traceFile.exists();
+    if (!m_traceFile.open(QIODevice::WriteOnly | QIODevice::Append |
+            QIODevice::Text)) {
+        kLogger.warning() << "Failed to open" << m_traceFile.fileName();
+        return false;
+    }
+    if (newFile) {
+        QTextStream(&m_traceFile)
+                << "callback,overrun,deadline_us,total_us,input_us,"
+                << "channels_us,effects_us,mixing_us,sidechain_us,"
+                << "outputs_us,workers_us,output_us,"
+                << "slowest_channel,slowest_channel_us,"
+                << "effect_chains_us\n";
+    }
+    return true;
+}
+
+void AudioCallbackMonitor::traceRecord(const Record& record) {
+    if (!openTraceFile()) {
+        return;
+    }
+    QTextStream(&m_traceFile)
+            << record.callback << ','
+            << (record.overrun ? 1 : 0) << ','
+            << formatMicros(record.deadline) << ','
+            << formatMicros(record.total) << ','
+            << formatMicros(record.input) << ','
+            << formatMicros(record.engine.channels) << ','
+            << formatMicros(record.engine.effects) << ','
+            << formatMicros(record.engine.mixing) << ','
+            << formatMicros(record.engine.sidechain) << ','
+            << formatMicros(record.engine.outputs) << ','
+            << formatMicros(record.engine.workers) << ','
+            << formatMicros(record.output) << ','
+            << m_pEngineMaster->getChannelGroup(record.engine.slowestChannel) << ','
+            << formatMicros(record.engine.slowestChannelTime) << ','
+            << formatEffectChains(record.engine) << '\n';
+}
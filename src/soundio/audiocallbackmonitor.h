@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+
+#include <QFile>
+#include <QObject>
+#include <QTimer>
+
+#include "engine/enginemaster.h"
+#include "preferences/usersettings.h"
+#include "util/class.h"
+#include "util/duration.h"
+#include "util/fifo.h"
+
+class ControlObject;
+
+// Keeps a breakdown of the processing time of the most recent audio
+// callbacks of the clock reference device. When a callback exceeds the
+// configured fraction of its deadline the recent history is handed over
+// to the main thread, which logs the callback that overran and appends
+// the history to a trace file in the settings directory. The trace file
+// is rotated when it exceeds a few megabytes, keeping a single backup.
+//
+// The monitor enables the stage timing of the EngineMaster for as long
+// as it exists.
+//
+// Controls in [Master]:
+//   audio_callback_deadline_threshold: fraction of the deadline that
+//       counts as an overrun (persistent, default 0.9)
+//   audio_callback_overrun_count: number of overruns (read-only)
+//   audio_callback_overrun_usage: used fraction of the deadline of the
+//       most recent overrun (read-only)
+//   audio_callback_overrun_stage: Stage that took the longest in the
+//       most recent overrun (read-only)
+class AudioCallbackMonitor : public QObject {
+    Q_OBJECT
+  public:
+    enum class Stage {
+        Input = 0,
+        Channels,
+        Mixing,
+        Outputs,
+        Workers,
+        Output,
+        Count,
+    };
+
+    struct Record {
+        quint64 callback;
+        mixxx::Duration deadline;
+        mixxx::Duration total;
+        // Receiving the input buffers, incl. vinyl control and passthrough
+        mixxx::Duration input;
+        EngineMaster::StageTimes engine;
+        // Writing the output buffers of all devices
+        mixxx::Duration output;
+        bool overrun;
+    };
+
+    AudioCallbackMonitor(UserSettingsPointer pConfig,
+            EngineMaster* pEngineMaster);
+    ~AudioCallbackMonitor() override;
+
+    // Called by the clock reference device at the end of each callback.
+    // Real-time safe.
+    void onCallbackFinished(mixxx::Duration deadline,
+            mixxx::Duration total,
+            mixxx::Duration input,
+            mixxx::Duration output);
+
+  private slots:
+    void slotProcessOverruns();
+
+  private:
+    static constexpr int kHistorySize = 16;
+
+    void logOverrun(const Record& record);
+    void traceRecord(const Record& record);
+    bool openTraceFile();
+
+    const UserSettingsPointer m_pConfig;
+    EngineMaster* const m_pEngineMaster;
+
+    // Only accessed by the callback thread
+    Record m_history[kHistorySize];
+    quint64 m_callbackCount;
+    quint64 m_nextUnreportedCallback;
+
+    // Overrun histories on their way to the main thread
+    FIFO<Record> m_overrunFifo;
+    std::atomic<int> m_overrunCount;
+    std::atomic<int> m_droppedHistories;
+
+    ControlObject* m_pThreshold;
+    ControlObject* m_pOverrunCount;
+    ControlObject* m_pOverrunUsage;
+    ControlObject* m_pOverrunStage;
+
+    QTimer m_timer;
+    QFile m_traceFile;
+
+    DISALLOW_COPY_AND_ASSIGN(AudioCallbackMonitor);
+};
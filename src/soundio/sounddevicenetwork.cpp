@@ -449,7 +449,9 @@ void SoundDeviceNetwork::callbackProcessClkRef() {
 #endif
     }
 
+    const mixxx::Duration inputStart = m_clkRefTimer.elapsed();
     m_pSoundManager->readProcess();
+    const mixxx::Duration inputTime = m_clkRefTimer.elapsed() - inputStart;
 
     {
         ScopedTimer t("SoundDevicePortAudio::callbackProcess prepare %1",
@@ -457,10 +459,18 @@ void SoundDeviceNetwork::callbackProcessClkRef() {
         m_pSoundManager->onDeviceOutputCallback(m_framesPerBuffer);
     }
 
+    const mixxx::Duration outputStart = m_clkRefTimer.elapsed();
     m_pSoundManager->writeProcess();
 
     m_pSoundManager->processUnderflowHappened();
 
+    const mixxx::Duration callbackTime = m_clkRefTimer.elapsed();
+    m_pSoundManager->onCallbackFinished(
+            m_audioBufferTime,
+            callbackTime,
+            inputTime,
+            callbackTime - outputStart);
+
     updateAudioLatencyUsage();
 }
 
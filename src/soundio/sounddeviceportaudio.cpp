@@ -927,6 +927,7 @@ int SoundDevicePortAudio::callbackProcessClkRef(
     //      m_pSoundManager->requestBuffer() is called below.)
 
     // Send audio from the soundcard's input off to the SoundManager...
+    const mixxx::Duration inputStart = m_clkRefTimer.elapsed();
     if (in) {
         ScopedTimer t("SoundDevicePortAudio::callbackProcess input %1",
                 getInternalName());
@@ -935,6 +936,7 @@ int SoundDevicePortAudio::callbackProcessClkRef(
     }
 
     m_pSoundManager->readProcess();
+    const mixxx::Duration inputTime = m_clkRefTimer.elapsed() - inputStart;
 
     {
         ScopedTimer t("SoundDevicePortAudio::callbackProcess prepare %1",
@@ -942,6 +944,7 @@ int SoundDevicePortAudio::callbackProcessClkRef(
         m_pSoundManager->onDeviceOutputCallback(framesPerBuffer);
     }
 
+    const mixxx::Duration outputStart = m_clkRefTimer.elapsed();
     if (out) {
         ScopedTimer t("SoundDevicePortAudio::callbackProcess output %1",
                 getInternalName());
@@ -959,6 +962,13 @@ int SoundDevicePortAudio::callbackProcessClkRef(
 
     m_pSoundManager->writeProcess();
 
+    const mixxx::Duration callbackTime = m_clkRefTimer.elapsed();
+    m_pSoundManager->onCallbackFinished(
+            mixxx::Duration::fromSeconds(framesPerBuffer / m_dSampleRate),
+            callbackTime,
+            inputTime,
+            callbackTime - outputStart);
+
     updateAudioLatencyUsage(framesPerBuffer);
 
     return paContinue;
@@ -28,6 +28,7 @@
 #include "engine/enginemaster.h"
 #include "engine/sidechain/enginenetworkstream.h"
 #include "engine/sidechain/enginesidechain.h"
+#include "soundio/audiocallbackmonitor.h"
 #include "soundio/sounddevice.h"
 #include "soundio/sounddevicenetwork.h"
 #include "soundio/sounddevicenotfound.h"
@@ -36,6 +37,7 @@
 #include "util/compatibility.h"
 #include "util/cmdlineargs.h"
 #include "util/defs.h"
+#include "util/memory.h"
 #include "util/sample.h"
 #include "util/sleep.h"
 #include "util/version.h"
@@ -81,6 +83,9 @@ SoundManager::SoundManager(UserSettingsPointer pConfig,
     m_pMasterAudioLatencyOverload = new ControlProxy("[Master]",
             "audio_latency_overload");
 
+    m_pCallbackMonitor = std::make_unique<AudioCallbackMonitor>(
+            pConfig, pMaster);
+
     //Hack because PortAudio samplerate enumeration is slow as hell on Linux (ALSA dmix sucks, so we can't blame PortAudio)
     m_samplerates.push_back(44100);
     m_samplerates.push_back(48000);
@@ -673,6 +678,13 @@ int SoundManager::getConfiguredDeckCount() const {
     return m_config.getDeckCount();
 }
 
+void SoundManager::onCallbackFinished(mixxx::Duration deadline,
+        mixxx::Duration total,
+        mixxx::Duration input,
+        mixxx::Duration output) {
+    m_pCallbackMonitor->onCallbackFinished(deadline, total, input, output);
+}
+
 void SoundManager::processUnderflowHappened() {
     if (m_underflowUpdateCount == 0) {
         if (m_underflowHappened.load()) {
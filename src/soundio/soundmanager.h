@@ -31,8 +31,10 @@
 #include "soundio/sounddevice.h"
 #include "util/types.h"
 #include "util/cmdlineargs.h"
+#include "util/duration.h"
 
 
+class AudioCallbackMonitor;
 class EngineMaster;
 class AudioOutput;
 class AudioInput;
@@ -127,6 +129,13 @@ class SoundManager : public QObject {
 
     void processUnderflowHappened();
 
+    // Called by the clock reference device at the end of each callback
+    // with the processing times that were measured by the device.
+    void onCallbackFinished(mixxx::Duration deadline,
+            mixxx::Duration total,
+            mixxx::Duration input,
+            mixxx::Duration output);
+
   signals:
     void devicesUpdated(); // emitted when pointers to SoundDevices go stale
     void devicesSetup(); // emitted when the sound devices have been set up
@@ -166,6 +175,8 @@ class SoundManager : public QObject {
     int m_underflowUpdateCount;
     ControlProxy* m_pMasterAudioLatencyOverloadCount;
     ControlProxy* m_pMasterAudioLatencyOverload;
+
+    std::unique_ptr<AudioCallbackMonitor> m_pCallbackMonitor;
 };
 
 #endif
@@ -56,6 +56,22 @@ bool AudioSource::initFrameIndexRangeOnce(
     return true;
 }
 
+//static
+AudioSource::ChannelCount AudioSource::decodingChannelCount(
+        ChannelCount streamChannelCount,
+        const OpenParams& params) {
+    const bool enforceStereo =
+            streamChannelCount.valid() &&
+            params.channelCount().valid() &&
+            (params.channelCount() <= 2) &&
+            ((params.channelCount() == 2) || (streamChannelCount > 2));
+    if (enforceStereo) {
+        return ChannelCount(2);
+    } else {
+        return streamChannelCount;
+    }
+}
+
 bool AudioSource::initBitrateOnce(Bitrate bitrate) {
     if (bitrate < Bitrate()) {
         kLogger.warning()
@@ -192,6 +192,18 @@ class AudioSource : public UrlResource, public AudioSignal, public virtual /*imp
 
         using AudioSignal::setChannelCount;
         using AudioSignal::setSampleRate;
+
+        // Optional key for reporting the latencies of reading
+        // the encoded data, e.g. per deck
+        const QString& ioStatsKey() const {
+            return m_ioStatsKey;
+        }
+        void setIoStatsKey(const QString& ioStatsKey) {
+            m_ioStatsKey = ioStatsKey;
+        }
+
+      private:
+        QString m_ioStatsKey;
     };
 
     // Opens the AudioSource for reading audio data.
@@ -314,6 +326,15 @@ class AudioSource : public UrlResource, public AudioSignal, public virtual /*imp
         return initBitrateOnce(Bitrate(bitrate));
     }
 
+    // The number of channels for decoders that are able to up- or
+    // down-mix the signal while converting the decoded samples. Only
+    // stereo is supported, i.e. mono signals are doubled and only the
+    // first two channels of multi-channel signals are decoded. Mono
+    // signals are preserved unless stereo is requested explicitly.
+    static ChannelCount decodingChannelCount(
+            ChannelCount streamChannelCount,
+            const OpenParams& params);
+
     // Tries to open the AudioSource for reading audio data according
     // to the "Template Method" design pattern.
     //
@@ -1,5 +1,7 @@
 #include "sources/audiosourcestereoproxy.h"
 
+#include <cstring>
+
 #include "util/logger.h"
 #include "util/sample.h"
 
@@ -17,7 +19,7 @@ AudioSourceStereoProxy::AudioSourceStereoProxy(
         : AudioSource(*pAudioSource),
           m_pAudioSource(std::move(pAudioSource)),
           m_tempSampleBuffer(
-                  (m_pAudioSource->channelCount() != 2) ? m_pAudioSource->frames2samples(maxReadableFrames) : 0),
+                  (m_pAudioSource->channelCount() > 2) ? m_pAudioSource->frames2samples(maxReadableFrames) : 0),
           m_tempWritableSlice(m_tempSampleBuffer) {
     setChannelCount(2);
 }
@@ -56,6 +58,9 @@ ReadableSampleFrames AudioSourceStereoProxy::readSampleFramesClamped(
     if (m_pAudioSource->channelCount() == 2) {
         return readSampleFramesClampedOn(*m_pAudioSource, sampleFrames);
     }
+    if (m_pAudioSource->channelCount() == 1) {
+        return readMonoSampleFramesClamped(sampleFrames);
+    }
 
     // Check location and capacity of temporary buffer
     VERIFY_OR_DEBUG_ASSERT(isDisjunct(
@@ -97,18 +102,55 @@ ReadableSampleFrames AudioSourceStereoProxy::readSampleFramesClamped(
     SampleBuffer::WritableSlice writableSlice(
             sampleFrames.writableData(frames2samples(frameOffset)),
             frames2samples(readableSampleFrames.frameLength()));
-    if (m_pAudioSource->channelCount() == 1) {
-        SampleUtil::copyMonoToDualMono(
-                writableSlice.data(),
-                readableSampleFrames.readableData(),
-                readableSampleFrames.frameLength());
-    } else {
-        SampleUtil::copyMultiToStereo(
+    SampleUtil::copyMultiToStereo(
+            writableSlice.data(),
+            readableSampleFrames.readableData(),
+            readableSampleFrames.frameLength(),
+            m_pAudioSource->channelCount());
+    return ReadableSampleFrames(
+            readableSampleFrames.frameIndexRange(),
+            SampleBuffer::ReadableSlice(
+                    writableSlice.data(),
+                    writableSlice.length()));
+}
+
+ReadableSampleFrames AudioSourceStereoProxy::readMonoSampleFramesClamped(
+        WritableSampleFrames sampleFrames) {
+    DEBUG_ASSERT(m_pAudioSource->channelCount() == 1);
+    // The mono samples fit into the first half of the output buffer
+    // and are doubled in-place afterwards. No temporary buffer is
+    // needed.
+    const auto readableSampleFrames =
+            readSampleFramesClampedOn(
+                    *m_pAudioSource,
+                    WritableSampleFrames(
+                            sampleFrames.frameIndexRange(),
+                            SampleBuffer::WritableSlice(
+                                    sampleFrames.writableData(),
+                                    std::min(
+                                            sampleFrames.writableLength(),
+                                            sampleFrames.frameLength()))));
+    if (readableSampleFrames.frameIndexRange().empty() ||
+            !sampleFrames.writableData()) {
+        return ReadableSampleFrames(readableSampleFrames.frameIndexRange());
+    }
+    DEBUG_ASSERT(readableSampleFrames.frameIndexRange() <= sampleFrames.frameIndexRange());
+    DEBUG_ASSERT(readableSampleFrames.frameIndexRange().start() >= sampleFrames.frameIndexRange().start());
+    const SINT frameOffset =
+            readableSampleFrames.frameIndexRange().start() - sampleFrames.frameIndexRange().start();
+    SampleBuffer::WritableSlice writableSlice(
+            sampleFrames.writableData(frames2samples(frameOffset)),
+            frames2samples(readableSampleFrames.frameLength()));
+    if (writableSlice.data() != readableSampleFrames.readableData()) {
+        // Move the mono samples to the start of the output
+        std::memmove(
                 writableSlice.data(),
                 readableSampleFrames.readableData(),
-                readableSampleFrames.frameLength(),
-                m_pAudioSource->channelCount());
+                readableSampleFrames.frameLength() * sizeof(CSAMPLE));
     }
+    SampleUtil::doubleMonoToDualMono(
+            writableSlice.data(),
+            readableSampleFrames.frameLength());
     return ReadableSampleFrames(
             readableSampleFrames.frameIndexRange(),
             SampleBuffer::ReadableSlice(
@@ -15,7 +15,8 @@ class AudioSourceStereoProxy : public AudioSource {
                 maxReadableFrames);
     }
 
-    // Create an instance with its own temporary buffer
+    // Create an instance with its own temporary buffer. The
+    // temporary buffer is only needed for multi-channel signals.
     AudioSourceStereoProxy(
             AudioSourcePointer pAudioSource,
             SINT maxReadableFrames);
@@ -40,6 +41,9 @@ class AudioSourceStereoProxy : public AudioSource {
             WritableSampleFrames writableSampleFrames) override;
 
   private:
+    ReadableSampleFrames readMonoSampleFramesClamped(
+            WritableSampleFrames sampleFrames);
+
     AudioSourcePointer m_pAudioSource;
     SampleBuffer m_tempSampleBuffer;
     SampleBuffer::WritableSlice m_tempWritableSlice;
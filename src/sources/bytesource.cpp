@@ -0,0 +1,409 @@
+#include "sources/bytesource.h"
+
+#include <cstring>
+
+#include <QMutexLocker>
+#include <QStorageInfo>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+#include "util/assert.h"
+#include "util/logger.h"
+#include "util/memory.h"
+#include "util/performancetimer.h"
+#include "util/stat.h"
+
+namespace mixxx {
+
+namespace {
+
+const Logger kLogger("ByteSource");
+
+// File system types as reported by QStorageInfo
+const QList<QByteArray> kNetworkFileSystemTypes = {
+        "afpfs",
+        "cifs",
+        "fuse.sshfs",
+        "ncpfs",
+        "nfs",
+        "nfs4",
+        "smb",
+        "smb2",
+        "smbfs",
+        "webdav",
+};
+
+} // anonymous namespace
+
+// static
+std::unique_ptr<QIODevice> ByteSource::open(
+        const QString& fileName,
+        const Options& options) {
+    Strategy strategy = options.strategy;
+    if (strategy == Strategy::Auto) {
+        strategy = isOnNetworkFileSystem(fileName) ?
+                Strategy::ReadAhead : Strategy::Mapped;
+    }
+    switch (strategy) {
+    case Strategy::Mapped: {
+        auto pDevice = std::make_unique<MappedFileDevice>(fileName);
+        if (pDevice->open(QIODevice::ReadOnly)) {
+            return std::move(pDevice);
+        }
+        kLogger.debug()
+                << "Failed to map file"
+                << fileName;
+        break;
+    }
+    case Strategy::ReadAhead: {
+        auto pFile = std::make_unique<QFile>(fileName);
+        if (!pFile->open(QIODevice::ReadOnly)) {
+            break;
+        }
+        adviseSequential(pFile.get());
+        auto pDevice = std::make_unique<ReadAheadDevice>(
+                std::move(pFile), options.statsKey);
+        if (pDevice->open(QIODevice::ReadOnly)) {
+            return std::move(pDevice);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    auto pFile = std::make_unique<QFile>(fileName);
+    if (!pFile->open(QIODevice::ReadOnly)) {
+        kLogger.warning()
+                << "Failed to open file"
+                << fileName
+                << pFile->errorString();
+        return nullptr;
+    }
+    return std::move(pFile);
+}
+
+// static
+bool ByteSource::isOnNetworkFileSystem(const QString& fileName) {
+    const QStorageInfo storageInfo(fileName);
+    return storageInfo.isValid() &&
+            kNetworkFileSystemTypes.contains(
+                    storageInfo.fileSystemType().toLower());
+}
+
+// static
+void ByteSource::adviseSequential(QFile* pFile) {
+#ifdef Q_OS_LINUX
+    if (pFile->handle() >= 0) {
+        posix_fadvise(pFile->handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#else
+    Q_UNUSED(pFile);
+#endif
+}
+
+// static
+void ByteSource::adviseWillNeed(QFile* pFile, qint64 offset, qint64 length) {
+#ifdef Q_OS_LINUX
+    if (pFile->handle() >= 0) {
+        posix_fadvise(pFile->handle(), offset, length, POSIX_FADV_WILLNEED);
+    }
+#else
+    Q_UNUSED(pFile);
+    Q_UNUSED(offset);
+    Q_UNUSED(length);
+#endif
+}
+
+// static
+void ByteSource::reportLatency(const QString& statsKey, qint64 nanos) {
+    if (statsKey.isEmpty()) {
+        return;
+    }
+    // The histogram tracks every distinct value
+    qint64 bucketMicros = 1;
+    while (bucketMicros * 1000 < nanos) {
+        bucketMicros *= 2;
+    }
+    Stat::track(statsKey, Stat::DURATION_NANOSEC,
+            Stat::COUNT | Stat::AVERAGE | Stat::MAX | Stat::HISTOGRAM,
+            bucketMicros * 1000);
+}
+
+MappedFileDevice::MappedFileDevice(const QString& fileName)
+        : m_file(fileName),
+          m_pData(nullptr),
+          m_size(0) {
+}
+
+MappedFileDevice::~MappedFileDevice() {
+    close();
+}
+
+bool MappedFileDevice::open(OpenMode mode) {
+    VERIFY_OR_DEBUG_ASSERT(mode == QIODevice::ReadOnly) {
+        return false;
+    }
+    VERIFY_OR_DEBUG_ASSERT(!isOpen()) {
+        return false;
+    }
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        setErrorString(m_file.errorString());
+        return false;
+    }
+    m_size = m_file.size();
+    if (m_size > 0) {
+        m_pData = m_file.map(0, m_size);
+        if (!m_pData) {
+            setErrorString(m_file.errorString());
+            m_file.close();
+            m_size = 0;
+            return false;
+        }
+    }
+    // The mapped data doesn't need to be buffered again
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void MappedFileDevice::close() {
+    if (!isOpen()) {
+        return;
+    }
+    QIODevice::close();
+    if (m_pData) {
+        m_file.unmap(const_cast<uchar*>(m_pData));
+        m_pData = nullptr;
+    }
+    m_file.close();
+    m_size = 0;
+}
+
+bool MappedFileDevice::seek(qint64 pos) {
+    return pos <= m_size && QIODevice::seek(pos);
+}
+
+qint64 MappedFileDevice::readData(char* data, qint64 maxSize) {
+    // QIODevice has already advanced the position past any data that
+    // has been pushed back with ungetChar()
+    const qint64 readPos = pos();
+    const qint64 readSize = std::min(maxSize, m_size - readPos);
+    if (readSize <= 0) {
+        return 0;
+    }
+    std::memcpy(data, m_pData + readPos, readSize);
+    return readSize;
+}
+
+qint64 MappedFileDevice::writeData(const char* data, qint64 maxSize) {
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+// Large enough for network file systems to saturate the link and
+// aligned with the block size of all common file systems
+const qint64 ReadAheadDevice::kDefaultBlockSize = 256 * 1024;
+const int ReadAheadDevice::kDefaultBlockCount = 8;
+
+ReadAheadDevice::ReadAheadDevice(
+        std::unique_ptr<QIODevice> pUpstream,
+        const QString& statsKey,
+        qint64 blockSize,
+        int blockCount)
+        : m_pUpstream(std::move(pUpstream)),
+          m_readStatsKey(statsKey.isEmpty() ? statsKey : statsKey + " I/O read"),
+          m_waitStatsKey(statsKey.isEmpty() ? statsKey : statsKey + " I/O wait"),
+          m_blockSize(blockSize),
+          m_blockCount(blockCount),
+          m_size(m_pUpstream->size()),
+          m_fetchThread(this),
+          m_windowStart(0),
+          m_stopFetching(false) {
+    DEBUG_ASSERT(m_pUpstream->isOpen());
+    DEBUG_ASSERT(!m_pUpstream->isSequential());
+    DEBUG_ASSERT(m_blockSize > 0);
+    DEBUG_ASSERT(m_blockCount > 0);
+}
+
+ReadAheadDevice::~ReadAheadDevice() {
+    close();
+}
+
+bool ReadAheadDevice::open(OpenMode mode) {
+    VERIFY_OR_DEBUG_ASSERT(mode == QIODevice::ReadOnly) {
+        return false;
+    }
+    VERIFY_OR_DEBUG_ASSERT(!isOpen()) {
+        return false;
+    }
+    {
+        QMutexLocker locked(&m_mutex);
+        m_blocks.clear();
+        m_windowStart = 0;
+        m_stopFetching = false;
+    }
+    m_fetchThread.start();
+    // The blocks don't need to be buffered again
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void ReadAheadDevice::close() {
+    if (!isOpen()) {
+        return;
+    }
+    QIODevice::close();
+    stopFetching();
+}
+
+void ReadAheadDevice::stopFetching() {
+    {
+        QMutexLocker locked(&m_mutex);
+        m_stopFetching = true;
+        m_windowMoved.wakeAll();
+    }
+    m_fetchThread.wait();
+    QMutexLocker locked(&m_mutex);
+    m_blocks.clear();
+}
+
+bool ReadAheadDevice::seek(qint64 pos) {
+    if (pos > m_size || !QIODevice::seek(pos)) {
+        return false;
+    }
+    // Start fetching the blocks at the new position before reading
+    QMutexLocker locked(&m_mutex);
+    moveWindow(pos / m_blockSize);
+    return true;
+}
+
+void ReadAheadDevice::moveWindow(qint64 blockIndex) {
+    if (m_windowStart == blockIndex) {
+        return;
+    }
+    m_windowStart = blockIndex;
+    // Keep the previous block for small backward seeks of the decoder
+    auto i = m_blocks.begin();
+    while (i != m_blocks.end()) {
+        if (i->first < m_windowStart - 1 ||
+                i->first >= m_windowStart + m_blockCount) {
+            i = m_blocks.erase(i);
+        } else {
+            ++i;
+        }
+    }
+    m_windowMoved.wakeAll();
+}
+
+qint64 ReadAheadDevice::readData(char* data, qint64 maxSize) {
+    // See MappedFileDevice::readData()
+    qint64 readPos = pos();
+    qint64 readSize = 0;
+    QMutexLocker locked(&m_mutex);
+    while (readSize < maxSize && readPos < m_size) {
+        const qint64 blockIndex = readPos / m_blockSize;
+        moveWindow(blockIndex);
+        auto i = m_blocks.find(blockIndex);
+        if (i == m_blocks.end()) {
+            PerformanceTimer timer;
+            timer.start();
+            do {
+                m_blockFetched.wait(&m_mutex);
+                i = m_blocks.find(blockIndex);
+            } while (i == m_blocks.end() && !m_stopFetching);
+            ByteSource::reportLatency(m_waitStatsKey, timer.elapsed().toIntegerNanos());
+            if (i == m_blocks.end()) {
+                break;
+            }
+        }
+        const QByteArray& block = i->second;
+        const qint64 blockOffset = readPos - blockIndex * m_blockSize;
+        if (blockOffset >= block.size()) {
+            setErrorString("Failed to read block from upstream device");
+            return readSize > 0 ? readSize : -1;
+        }
+        const qint64 copySize = std::min(
+                maxSize - readSize, block.size() - blockOffset);
+        std::memcpy(data + readSize, block.constData() + blockOffset, copySize);
+        readSize += copySize;
+        readPos += copySize;
+    }
+    return readSize;
+}
+
+qint64 ReadAheadDevice::writeData(const char* data, qint64 maxSize) {
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+void ReadAheadDevice::fetchBlocks() {
+    const qint64 blockCountTotal = (m_size + m_blockSize - 1) / m_blockSize;
+    QFile* pFile = qobject_cast<QFile*>(m_pUpstream.get());
+    qint64 advisedWindowStart = -1;
+    QMutexLocker locked(&m_mutex);
+    while (!m_stopFetching) {
+        const qint64 windowStart = m_windowStart;
+        const qint64 windowEnd = std::min(
+                windowStart + m_blockCount, blockCountTotal);
+        qint64 missingBlockIndex = -1;
+        for (qint64 blockIndex = windowStart; blockIndex < windowEnd; ++blockIndex) {
+            if (m_blocks.find(blockIndex) == m_blocks.end()) {
+                missingBlockIndex = blockIndex;
+                break;
+            }
+        }
+        if (missingBlockIndex < 0) {
+            m_windowMoved.wait(&m_mutex);
+            continue;
+        }
+        if (pFile && advisedWindowStart != windowStart) {
+            advisedWindowStart = windowStart;
+            ByteSource::adviseWillNeed(pFile,
+                    windowStart * m_blockSize,
+                    (windowEnd - windowStart) * m_blockSize);
+        }
+        locked.unlock();
+        QByteArray block = fetchBlock(missingBlockIndex);
+        locked.relock();
+        // Discard blocks that have been fetched for an outdated window
+        if (missingBlockIndex >= m_windowStart - 1 &&
+                missingBlockIndex < m_windowStart + m_blockCount) {
+            m_blocks[missingBlockIndex] = std::move(block);
+        }
+        m_blockFetched.wakeAll();
+    }
+    m_blockFetched.wakeAll();
+}
+
+QByteArray ReadAheadDevice::fetchBlock(qint64 blockIndex) {
+    const qint64 offset = blockIndex * m_blockSize;
+    const qint64 size = std::min(m_blockSize, m_size - offset);
+    PerformanceTimer timer;
+    timer.start();
+    QByteArray block(size, Qt::Uninitialized);
+    qint64 readSize = 0;
+    if (m_pUpstream->seek(offset)) {
+        while (readSize < size) {
+            const qint64 chunkSize = m_pUpstream->read(
+                    block.data() + readSize, size - readSize);
+            if (chunkSize <= 0) {
+                break;
+            }
+            readSize += chunkSize;
+        }
+    }
+    ByteSource::reportLatency(m_readStatsKey, timer.elapsed().toIntegerNanos());
+    if (readSize < size) {
+        kLogger.warning()
+                << "Failed to read"
+                << size
+                << "bytes at offset"
+                << offset
+                << m_pUpstream->errorString();
+        return QByteArray();
+    }
+    return block;
+}
+
+} // namespace mixxx
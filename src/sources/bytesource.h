@@ -0,0 +1,178 @@
+#ifndef MIXXX_BYTESOURCE_H
+#define MIXXX_BYTESOURCE_H
+
+#include <map>
+#include <memory>
+
+#include <QFile>
+#include <QIODevice>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+namespace mixxx {
+
+// Provides the encoded bytes of a file to the decoders of those
+// SoundSources that read their input through callbacks.
+//
+// Decoding a chunk issues many small reads. On local file systems these
+// are served from the page cache, but on network file systems (NAS, SMB)
+// a single slow read stalls the chunk loading of the whole deck. Instead
+// of reading from a QFile directly the decoders read through a QIODevice
+// that is opened with a strategy that fits the storage of the file.
+class ByteSource final {
+  public:
+    enum class Strategy {
+        // Mapped for local files, read ahead for files on network
+        // file systems
+        Auto,
+        // A plain QFile
+        Buffered,
+        // The whole file is mapped into memory
+        Mapped,
+        // Large blocks are read ahead by a worker thread
+        ReadAhead,
+    };
+
+    struct Options {
+        Options()
+                : strategy(Strategy::Auto) {
+        }
+        Strategy strategy;
+        // Optional key prefix for reporting I/O latencies to the stats,
+        // e.g. per deck
+        QString statsKey;
+    };
+
+    // Returns an opened, read-only and random access device or nullptr
+    // if the file could not be opened. Falls back to a plain QFile if the
+    // preferred strategy is not available.
+    static std::unique_ptr<QIODevice> open(
+            const QString& fileName,
+            const Options& options = Options());
+
+    static bool isOnNetworkFileSystem(const QString& fileName);
+
+    // Hints for the page cache of the operating system. No-ops on
+    // platforms that don't support them.
+    static void adviseSequential(QFile* pFile);
+    static void adviseWillNeed(QFile* pFile, qint64 offset, qint64 length);
+
+    // Reports the latency of a single I/O operation as a histogram with
+    // power of two buckets in microseconds.
+    static void reportLatency(const QString& statsKey, qint64 nanos);
+
+  private:
+    ByteSource() = delete;
+};
+
+// Serves reads from a file that is mapped into memory as a whole. Page
+// faults are resolved by the operating system without copying the data
+// into an intermediate buffer.
+class MappedFileDevice final : public QIODevice {
+  public:
+    explicit MappedFileDevice(const QString& fileName);
+    ~MappedFileDevice() override;
+
+    // Only QIODevice::ReadOnly is supported
+    bool open(OpenMode mode) override;
+    void close() override;
+
+    bool isSequential() const override {
+        return false;
+    }
+    qint64 size() const override {
+        return m_size;
+    }
+    bool seek(qint64 pos) override;
+
+  protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+  private:
+    QFile m_file;
+    const uchar* m_pData;
+    qint64 m_size;
+};
+
+// Reads an upstream device in large aligned blocks ahead of the current
+// position with a worker thread. The decoder only blocks when reading a
+// block that has not been fetched yet, e.g. after seeking.
+//
+// The upstream device is only accessed by the worker thread after
+// opening. Both the time for fetching a block and the time the reader
+// had to wait for it are reported to the stats with the optional key.
+class ReadAheadDevice final : public QIODevice {
+  public:
+    static const qint64 kDefaultBlockSize;
+    static const int kDefaultBlockCount;
+
+    // Takes the ownership of an opened upstream device with random access
+    ReadAheadDevice(
+            std::unique_ptr<QIODevice> pUpstream,
+            const QString& statsKey = QString(),
+            qint64 blockSize = kDefaultBlockSize,
+            int blockCount = kDefaultBlockCount);
+    ~ReadAheadDevice() override;
+
+    // Only QIODevice::ReadOnly is supported
+    bool open(OpenMode mode) override;
+    void close() override;
+
+    bool isSequential() const override {
+        return false;
+    }
+    qint64 size() const override {
+        return m_size;
+    }
+    bool seek(qint64 pos) override;
+
+  protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+  private:
+    class FetchThread : public QThread {
+      public:
+        explicit FetchThread(ReadAheadDevice* pDevice)
+                : m_pDevice(pDevice) {
+        }
+      protected:
+        void run() override {
+            m_pDevice->fetchBlocks();
+        }
+      private:
+        ReadAheadDevice* const m_pDevice;
+    };
+
+    void stopFetching();
+    void fetchBlocks();
+    // Returns a null byte array on failure
+    QByteArray fetchBlock(qint64 blockIndex);
+    // The caller must hold the lock
+    void moveWindow(qint64 blockIndex);
+
+    const std::unique_ptr<QIODevice> m_pUpstream;
+    const QString m_readStatsKey;
+    const QString m_waitStatsKey;
+    const qint64 m_blockSize;
+    const int m_blockCount;
+    const qint64 m_size;
+
+    FetchThread m_fetchThread;
+
+    QMutex m_mutex;
+    QWaitCondition m_windowMoved;
+    QWaitCondition m_blockFetched;
+    // The block of the current position
+    qint64 m_windowStart;
+    bool m_stopFetching;
+    // Indexed by block, failed blocks are empty
+    std::map<qint64, QByteArray> m_blocks;
+};
+
+} // namespace mixxx
+
+#endif // MIXXX_BYTESOURCE_H
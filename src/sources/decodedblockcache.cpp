@@ -0,0 +1,314 @@
+#include "sources/decodedblockcache.h"
+
+#include <QMutexLocker>
+
+#include "util/counter.h"
+#include "util/logger.h"
+#include "util/sample.h"
+
+namespace mixxx {
+
+namespace {
+
+Logger kLogger("DecodedBlockCache");
+
+// All consumers decode the stereo signal
+const SINT kChannels = 2;
+
+const QString kSharedBlocksCounter =
+        QStringLiteral("DecodedBlockCache shared blocks");
+const QString kDecodedBlocksCounter =
+        QStringLiteral("DecodedBlockCache decoded blocks");
+const QString kDuplicatedBlocksCounter =
+        QStringLiteral("DecodedBlockCache duplicated blocks");
+
+const int kInvalidConsumerId = -1;
+
+} // anonymous namespace
+
+// ~170 ms at 48 kHz, i.e. 64 KB per block
+const SINT DecodedBlockCache::kBlockFrames = 8192;
+// ~5.6 s at 48 kHz
+const int DecodedBlockCache::kMaxBlocksPerFile = 32;
+const int DecodedBlockCache::kMaxUnsharedBlocksPerFile = 8;
+// 16 MB
+const int DecodedBlockCache::kMaxBlocks = 256;
+
+DecodedBlock::DecodedBlock(const ReadableSampleFrames& readableSampleFrames)
+        : m_frameIndexRange(readableSampleFrames.frameIndexRange()),
+          m_sampleBuffer(readableSampleFrames.readableLength()) {
+    DEBUG_ASSERT(readableSampleFrames.readableLength() ==
+            m_frameIndexRange.length() * kChannels);
+    SampleUtil::copy(
+            m_sampleBuffer.data(),
+            readableSampleFrames.readableData(),
+            m_sampleBuffer.size());
+}
+
+DecodedBlockCache::Consumer::Consumer()
+        : m_pCache(nullptr),
+          m_id(kInvalidConsumerId) {
+}
+
+DecodedBlockCache::Consumer::Consumer(
+        DecodedBlockCache* pCache,
+        const QString& location,
+        IndexRange frameIndexRange,
+        SINT sampleRate)
+        : m_pCache(nullptr),
+          m_location(location),
+          m_frameIndexRange(frameIndexRange),
+          m_id(kInvalidConsumerId) {
+    DEBUG_ASSERT(pCache);
+    if (location.isEmpty()) {
+        return;
+    }
+    m_id = pCache->acquire(location, frameIndexRange, sampleRate);
+    if (m_id != kInvalidConsumerId) {
+        m_pCache = pCache;
+    }
+}
+
+DecodedBlockCache::Consumer::Consumer(Consumer&& that)
+        : m_pCache(that.m_pCache),
+          m_location(std::move(that.m_location)),
+          m_frameIndexRange(that.m_frameIndexRange),
+          m_id(that.m_id) {
+    that.m_pCache = nullptr;
+    that.m_id = kInvalidConsumerId;
+}
+
+DecodedBlockCache::Consumer::~Consumer() {
+    release();
+}
+
+DecodedBlockCache::Consumer& DecodedBlockCache::Consumer::operator=(
+        Consumer&& that) {
+    if (this != &that) {
+        release();
+        m_pCache = that.m_pCache;
+        m_location = std::move(that.m_location);
+        m_frameIndexRange = that.m_frameIndexRange;
+        m_id = that.m_id;
+        that.m_pCache = nullptr;
+        that.m_id = kInvalidConsumerId;
+    }
+    return *this;
+}
+
+void DecodedBlockCache::Consumer::release() {
+    if (m_pCache) {
+        m_pCache->release(m_location);
+        m_pCache = nullptr;
+        m_id = kInvalidConsumerId;
+    }
+}
+
+IndexRange DecodedBlockCache::Consumer::blockFrameIndexRange(
+        SINT blockIndex) const {
+    return intersect(
+            IndexRange::forward(
+                    m_frameIndexRange.start() + blockIndex * kBlockFrames,
+                    kBlockFrames),
+            m_frameIndexRange);
+}
+
+DecodedBlockPointer DecodedBlockCache::Consumer::takeBlock(
+        SINT blockIndex) const {
+    if (!m_pCache) {
+        return DecodedBlockPointer();
+    }
+    return m_pCache->takeBlock(m_location, blockIndex, m_id);
+}
+
+void DecodedBlockCache::Consumer::publishBlock(
+        SINT blockIndex,
+        const ReadableSampleFrames& decodedSampleFrames) const {
+    if (!m_pCache) {
+        return;
+    }
+    if (!m_pCache->onBlockDecoded(m_location, blockIndex)) {
+        return;
+    }
+    if (decodedSampleFrames.frameIndexRange() != blockFrameIndexRange(blockIndex) ||
+            decodedSampleFrames.readableLength() !=
+                    decodedSampleFrames.frameLength() * kChannels) {
+        // Incomplete blocks after decoding errors are not shared
+        return;
+    }
+    // Copy the sample data without holding the lock
+    m_pCache->publishBlock(m_location, blockIndex, m_id,
+            std::make_shared<const DecodedBlock>(decodedSampleFrames));
+}
+
+// static
+DecodedBlockCache* DecodedBlockCache::instance() {
+    static DecodedBlockCache s_instance;
+    return &s_instance;
+}
+
+DecodedBlockCache::DecodedBlockCache()
+        : m_nextConsumerId(0) {
+}
+
+int DecodedBlockCache::cachedBlockCount(const QString& location) const {
+    QMutexLocker locked(&m_mutex);
+    const auto i = m_files.constFind(location);
+    if (i == m_files.constEnd()) {
+        return 0;
+    }
+    return i.value().cachedBlockCount;
+}
+
+DecodedBlockCache::Stats DecodedBlockCache::stats() const {
+    QMutexLocker locked(&m_mutex);
+    return m_stats;
+}
+
+int DecodedBlockCache::acquire(
+        const QString& location,
+        IndexRange frameIndexRange,
+        SINT sampleRate) {
+    QMutexLocker locked(&m_mutex);
+    File& file = m_files[location];
+    if (file.consumerCount == 0) {
+        file.frameIndexRange = frameIndexRange;
+        file.sampleRate = sampleRate;
+        file.publishedBlocks.assign(
+                (file.frameIndexRange.length() + kBlockFrames - 1) / kBlockFrames,
+                false);
+    } else if (file.frameIndexRange != frameIndexRange ||
+            file.sampleRate != sampleRate) {
+        // The decoded blocks would not match
+        kLogger.warning()
+                << "Not sharing decoded blocks of"
+                << location
+                << "with different frame index ranges:"
+                << file.frameIndexRange
+                << "<>"
+                << frameIndexRange;
+        return kInvalidConsumerId;
+    }
+    ++file.consumerCount;
+    return m_nextConsumerId++;
+}
+
+void DecodedBlockCache::release(const QString& location) {
+    QMutexLocker locked(&m_mutex);
+    auto i = m_files.find(location);
+    VERIFY_OR_DEBUG_ASSERT(i != m_files.end()) {
+        return;
+    }
+    if (--i.value().consumerCount > 0) {
+        return;
+    }
+    m_files.erase(i);
+    auto j = m_blocks.begin();
+    while (j != m_blocks.end()) {
+        if (j->location == location) {
+            m_blockIndex.remove(BlockKey(j->location, j->blockIndex));
+            j = m_blocks.erase(j);
+        } else {
+            ++j;
+        }
+    }
+}
+
+DecodedBlockPointer DecodedBlockCache::takeBlock(
+        const QString& location,
+        SINT blockIndex,
+        int consumerId) {
+    QMutexLocker locked(&m_mutex);
+    const auto i = m_blockIndex.value(BlockKey(location, blockIndex), m_blocks.end());
+    if (i == m_blocks.end()) {
+        return DecodedBlockPointer();
+    }
+    ++m_stats.sharedBlocks;
+    Counter(kSharedBlocksCounter).increment();
+    const DecodedBlockPointer pBlock = i->pBlock;
+    const auto file = m_files.constFind(location);
+    DEBUG_ASSERT(file != m_files.constEnd());
+    if (i->publisherId != consumerId &&
+            ++i->takenCount >= file.value().consumerCount - 1) {
+        // All other consumers have got it
+        evictBlock(i);
+    }
+    return pBlock;
+}
+
+bool DecodedBlockCache::onBlockDecoded(
+        const QString& location,
+        SINT blockIndex) {
+    QMutexLocker locked(&m_mutex);
+    ++m_stats.decodedBlocks;
+    Counter(kDecodedBlocksCounter).increment();
+    auto i = m_files.find(location);
+    VERIFY_OR_DEBUG_ASSERT(i != m_files.end()) {
+        return false;
+    }
+    File& file = i.value();
+    VERIFY_OR_DEBUG_ASSERT(blockIndex >= 0 &&
+            blockIndex < static_cast<SINT>(file.publishedBlocks.size())) {
+        return false;
+    }
+    if (file.publishedBlocks[blockIndex]) {
+        ++m_stats.duplicatedBlocks;
+        Counter(kDuplicatedBlocksCounter).increment();
+    }
+    if (m_blockIndex.contains(BlockKey(location, blockIndex))) {
+        return false;
+    }
+    if (file.consumerCount > 1) {
+        return true;
+    }
+    return file.cachedBlockCount < kMaxUnsharedBlocksPerFile;
+}
+
+void DecodedBlockCache::publishBlock(
+        const QString& location,
+        SINT blockIndex,
+        int publisherId,
+        DecodedBlockPointer pBlock) {
+    QMutexLocker locked(&m_mutex);
+    auto i = m_files.find(location);
+    if (i == m_files.end()) {
+        return;
+    }
+    const BlockKey key(location, blockIndex);
+    if (m_blockIndex.contains(key)) {
+        // Published concurrently by another consumer
+        return;
+    }
+    if (i.value().cachedBlockCount >= kMaxBlocksPerFile) {
+        auto j = m_blocks.begin();
+        while (j->location != location) {
+            ++j;
+        }
+        evictBlock(j);
+    }
+    if (static_cast<int>(m_blocks.size()) >= kMaxBlocks) {
+        evictBlock(m_blocks.begin());
+    }
+    Block block;
+    block.location = location;
+    block.blockIndex = blockIndex;
+    block.publisherId = publisherId;
+    block.takenCount = 0;
+    block.pBlock = std::move(pBlock);
+    m_blockIndex.insert(key, m_blocks.insert(m_blocks.end(), std::move(block)));
+    File& file = i.value();
+    ++file.cachedBlockCount;
+    file.publishedBlocks[blockIndex] = true;
+}
+
+void DecodedBlockCache::evictBlock(BlockList::iterator i) {
+    DEBUG_ASSERT(i != m_blocks.end());
+    auto file = m_files.find(i->location);
+    if (file != m_files.end()) {
+        --file.value().cachedBlockCount;
+    }
+    m_blockIndex.remove(BlockKey(i->location, i->blockIndex));
+    m_blocks.erase(i);
+}
+
+} // namespace mixxx
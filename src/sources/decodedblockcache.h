@@ -0,0 +1,194 @@
+#ifndef MIXXX_DECODEDBLOCKCACHE_H
+#define MIXXX_DECODEDBLOCKCACHE_H
+
+#include <list>
+#include <memory>
+#include <vector>
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include "sources/audiosource.h"
+
+namespace mixxx {
+
+// Immutable stereo sample data of a block of frames that has been
+// decoded once and is shared between all consumers of the same file.
+class DecodedBlock final {
+  public:
+    // Copies the sample data
+    explicit DecodedBlock(const ReadableSampleFrames& readableSampleFrames);
+
+    const IndexRange& frameIndexRange() const {
+        return m_frameIndexRange;
+    }
+
+    ReadableSampleFrames readableSampleFrames() const {
+        return ReadableSampleFrames(
+                m_frameIndexRange,
+                SampleBuffer::ReadableSlice(m_sampleBuffer, 0, m_sampleBuffer.size()));
+    }
+
+  private:
+    const IndexRange m_frameIndexRange;
+    SampleBuffer m_sampleBuffer;
+};
+
+typedef std::shared_ptr<const DecodedBlock> DecodedBlockPointer;
+
+// A track that is loaded into a deck is decoded by the CachingReaderWorker
+// and at the same time by an AnalyzerThread if it has not been analyzed
+// before. Both decode the stereo signal of the same audio source in blocks
+// of kBlockFrames frames. Whoever decodes a block first publishes it here
+// and the other one takes it instead of decoding it again.
+//
+// While a file has only a single consumer its first few decoded blocks
+// are kept for a consumer that arrives later, e.g. the analysis of a track
+// that starts after the deck has already read the beginning. Only a limited
+// number of blocks is kept per file and in total. Blocks are evicted in the
+// order they have been published and dropped as soon as all other consumers
+// of the file have taken them. All blocks of a file are dropped when its
+// last consumer is gone.
+//
+// All functions are thread-safe. The lock is only held for bookkeeping
+// and never while decoding or copying sample data.
+class DecodedBlockCache final {
+  public:
+    // Same as CachingReaderChunk::kFrames
+    static const SINT kBlockFrames;
+    static const int kMaxBlocksPerFile;
+    static const int kMaxUnsharedBlocksPerFile;
+    static const int kMaxBlocks;
+
+    struct Stats {
+        Stats()
+                : sharedBlocks(0),
+                  decodedBlocks(0),
+                  duplicatedBlocks(0) {
+        }
+        // Blocks that have been taken from the cache instead of decoding them
+        int sharedBlocks;
+        // Blocks that have been decoded by any consumer
+        int decodedBlocks;
+        // Blocks that have been decoded again after they have been
+        // published before, e.g. because they have already been evicted
+        int duplicatedBlocks;
+    };
+
+    // Registers a consumer of the stereo signal of a file for the lifetime
+    // of this object. The frame index range and the sample rate of the audio
+    // source must match those of all other consumers, otherwise an invalid
+    // consumer that neither takes nor publishes anything is constructed.
+    class Consumer final {
+      public:
+        Consumer();
+        Consumer(
+                DecodedBlockCache* pCache,
+                const QString& location,
+                IndexRange frameIndexRange,
+                SINT sampleRate);
+        Consumer(Consumer&& that);
+        ~Consumer();
+
+        Consumer& operator=(Consumer&& that);
+
+        Consumer(const Consumer&) = delete;
+        Consumer& operator=(const Consumer&) = delete;
+
+        bool isValid() const {
+            return m_pCache != nullptr;
+        }
+
+        // Returns a null pointer if the block has not been published
+        DecodedBlockPointer takeBlock(SINT blockIndex) const;
+
+        // Copies the sample data if another consumer might need it. The
+        // decoded frames must cover the whole frame index range of the
+        // block, otherwise the block is not published.
+        void publishBlock(
+                SINT blockIndex,
+                const ReadableSampleFrames& decodedSampleFrames) const;
+
+        // Returns the frame index range of a block of the audio source
+        IndexRange blockFrameIndexRange(SINT blockIndex) const;
+
+      private:
+        void release();
+
+        DecodedBlockCache* m_pCache;
+        QString m_location;
+        IndexRange m_frameIndexRange;
+        int m_id;
+    };
+
+    static DecodedBlockCache* instance();
+
+    DecodedBlockCache();
+
+    // Returns the number of blocks of a file that are currently cached
+    int cachedBlockCount(const QString& location) const;
+
+    Stats stats() const;
+
+  private:
+    struct File {
+        File()
+                : sampleRate(0),
+                  consumerCount(0),
+                  cachedBlockCount(0) {
+        }
+        IndexRange frameIndexRange;
+        SINT sampleRate;
+        int consumerCount;
+        int cachedBlockCount;
+        // All blocks that have ever been published for this file
+        // to detect duplicate decoding
+        std::vector<bool> publishedBlocks;
+    };
+
+    struct Block {
+        QString location;
+        SINT blockIndex;
+        int publisherId;
+        int takenCount;
+        DecodedBlockPointer pBlock;
+    };
+    typedef std::list<Block> BlockList;
+    typedef QPair<QString, SINT> BlockKey;
+
+    int acquire(
+            const QString& location,
+            IndexRange frameIndexRange,
+            SINT sampleRate);
+    void release(const QString& location);
+
+    DecodedBlockPointer takeBlock(
+            const QString& location,
+            SINT blockIndex,
+            int consumerId);
+    // Accounts a decoded block and returns true if it should be published
+    bool onBlockDecoded(
+            const QString& location,
+            SINT blockIndex);
+    void publishBlock(
+            const QString& location,
+            SINT blockIndex,
+            int publisherId,
+            DecodedBlockPointer pBlock);
+
+    // The caller must hold the lock
+    void evictBlock(BlockList::iterator i);
+
+    mutable QMutex m_mutex;
+    QHash<QString, File> m_files;
+    // In the order of publishing, the oldest first
+    BlockList m_blocks;
+    QHash<BlockKey, BlockList::iterator> m_blockIndex;
+    int m_nextConsumerId;
+    Stats m_stats;
+};
+
+} // namespace mixxx
+
+#endif // MIXXX_DECODEDBLOCKCACHE_H
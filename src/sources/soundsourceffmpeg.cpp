@@ -1,20 +1,14 @@
 #include "sources/soundsourceffmpeg.h"
 
-#include "encoder/encoderffmpegresample.h"
-
 #include "util/logger.h"
+#include "util/sample.h"
 
+#include <algorithm>
 #include <mutex>
-#include <vector>
 
 #define LIBAVCODEC_HAS_AV_PACKET_UNREF \
     (LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 8, 0))
 
-#define AUDIOSOURCEFFMPEG_CACHESIZE 1000
-#define AUDIOSOURCEFFMPEG_MIXXXFRAME_TO_BYTEOFFSET(numFrames) (frames2samples(numFrames) * sizeof(CSAMPLE))
-#define AUDIOSOURCEFFMPEG_BYTEOFFSET_TO_MIXXXFRAME(byteOffset) (samples2frames(byteOffset / sizeof(CSAMPLE)))
-#define AUDIOSOURCEFFMPEG_FILL_FROM_CURRENTPOS -1
-
 namespace mixxx {
 
 namespace {
@@ -32,6 +26,17 @@ void initFFmpegLib() {
 // More than 2 channels are currently not supported
 const SINT kMaxChannelCount = 2;
 
+// Decoding is restarted this number of frames before the seek
+// position to warm up the decoder, e.g. for the bit reservoir of
+// MP3 or the overlapping windows of AAC. Jumping forward by less
+// frames continues decoding instead of seeking.
+const SINT kNumberOfPrerollFrames = 2112;
+
+// The initial capacity of the sample buffer for the remaining
+// samples of a decoded frame. Larger frames, e.g. WMA, increase
+// the capacity once.
+const SINT kMinSampleBufferFrameCount = 8192;
+
 inline AVMediaType getMediaTypeOfStream(AVStream* pStream) {
     return m_pAVStreamWrapper.getMediaTypeOfStream(pStream);
 }
@@ -106,8 +111,90 @@ inline bool getFrameIndexRangeOfStream(AVStream* pStream, mixxx::IndexRange* pFr
     return true;
 }
 
-inline AVSampleFormat getSampleFormatOfStream(AVStream* pStream) {
-    return m_pAVStreamWrapper.getSampleFormatOfStream(pStream);
+inline AVFrame* allocFrame() {
+#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(55, 52, 0)
+    return avcodec_alloc_frame();
+#else
+    return av_frame_alloc();
+#endif
+}
+
+inline void freeFrame(AVFrame** ppFrame) {
+    if (*ppFrame == nullptr) {
+        return;
+    }
+// FFMPEG 2.2 and beyond
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(54, 86, 100)
+    av_frame_free(ppFrame);
+// FFMPEG 0.11 and below
+#elif LIBAVCODEC_VERSION_INT <= AV_VERSION_INT(54, 23, 100)
+    av_free(*ppFrame);
+// FFMPEG 1.0 - 2.1
+#else
+    avcodec_free_frame(ppFrame);
+#endif
+    *ppFrame = nullptr;
+}
+
+bool isSupportedSampleFormat(AVSampleFormat sampleFormat) {
+    switch (av_get_packed_sample_fmt(sampleFormat)) {
+    case AV_SAMPLE_FMT_U8:
+    case AV_SAMPLE_FMT_S16:
+    case AV_SAMPLE_FMT_S32:
+    case AV_SAMPLE_FMT_FLT:
+    case AV_SAMPLE_FMT_DBL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Converts decoded planar or interleaved samples into interleaved
+// floating point samples without any intermediate buffers. Mono
+// signals are doubled and multi-channel signals are stripped down
+// to stereo if the number of channels differs from the stream.
+template<typename T, typename F>
+void convertSamples(
+        const AVFrame* pFrame,
+        bool planar,
+        SINT streamChannelCount,
+        SINT channelCount,
+        SINT frameOffset,
+        SINT frameCount,
+        CSAMPLE* pOutput,
+        F convertSample) {
+    if (planar) {
+        for (SINT channel = 0; channel < channelCount; ++channel) {
+            const SINT streamChannel = std::min(channel, streamChannelCount - 1);
+            const T* pInput =
+                    reinterpret_cast<const T*>(pFrame->extended_data[streamChannel]) +
+                    frameOffset;
+            CSAMPLE* pChannelOutput = pOutput + channel;
+            for (SINT i = 0; i < frameCount; ++i) {
+                *pChannelOutput = convertSample(pInput[i]);
+                pChannelOutput += channelCount;
+            }
+        }
+    } else if (channelCount == streamChannelCount) {
+        const T* pInput =
+                reinterpret_cast<const T*>(pFrame->extended_data[0]) +
+                frameOffset * channelCount;
+        const SINT sampleCount = frameCount * channelCount;
+        for (SINT i = 0; i < sampleCount; ++i) {
+            pOutput[i] = convertSample(pInput[i]);
+        }
+    } else {
+        const T* pInput =
+                reinterpret_cast<const T*>(pFrame->extended_data[0]) +
+                frameOffset * streamChannelCount;
+        for (SINT i = 0; i < frameCount; ++i) {
+            for (SINT channel = 0; channel < channelCount; ++channel) {
+                const SINT streamChannel = std::min(channel, streamChannelCount - 1);
+                *pOutput++ = convertSample(pInput[streamChannel]);
+            }
+            pInput += streamChannelCount;
+        }
+    }
 }
 
 } // anonymous namespace
@@ -285,26 +372,35 @@ void SoundSourceFFmpeg::ClosableAVCodecContextPtr::close() {
 
 SoundSourceFFmpeg::SoundSourceFFmpeg(const QUrl& url)
         : SoundSource(url),
-          m_pResample(nullptr),
-          m_currentMixxxFrameIndex(0),
-          m_bIsSeeked(false),
-          m_lCacheFramePos(0),
-          m_lCacheStartFrame(0),
-          m_lCacheEndFrame(0),
-          m_lCacheLastPos(0),
-          m_lLastStoredPos(0),
-          m_lStoreCount(0),
-          m_lStoredSeekPoint(-1),
-          m_SStoredJumpPoint(nullptr) {
+          m_pDecodedFrame(nullptr),
+          m_streamChannelCount(0),
+          m_curFrameIndex(0),
+          m_restartedDecoding(false),
+          m_seekFrameIndex(0),
+          m_endOfStream(false) {
+    av_init_packet(&m_packet);
+    m_packet.data = nullptr;
+    m_packet.size = 0;
+#if !AVSTREAM_FROM_API_VERSION_3_1
+    m_pendingPacket = m_packet;
+#endif
 }
 
 SoundSourceFFmpeg::~SoundSourceFFmpeg() {
     close();
 }
 
+AVCodecContext* SoundSourceFFmpeg::getCodecContext() {
+#if AVSTREAM_FROM_API_VERSION_3_1
+    return m_pAudioContext;
+#else
+    return m_pAudioStream->codec;
+#endif
+}
+
 SoundSource::OpenResult SoundSourceFFmpeg::tryOpen(
         OpenMode /*mode*/,
-        const OpenParams& /*config*/) {
+        const OpenParams& params) {
     AVFormatContext* pInputFormatContext =
             openInputFile(getLocalFileName());
     if (pInputFormatContext == nullptr) {
@@ -407,30 +503,43 @@ SoundSource::OpenResult SoundSourceFFmpeg::tryOpen(
         return OpenResult::Failed;
     }
 
-    setChannelCount(channelCount);
+    m_streamChannelCount = channelCount;
+    setChannelCount(decodingChannelCount(channelCount, params));
     setSampleRate(sampleRate);
     initFrameIndexRangeOnce(frameIndexRange);
 
-#if AVSTREAM_FROM_API_VERSION_3_1
-    m_pResample = std::make_unique<EncoderFfmpegResample>(m_pAudioContext);
-#else
-    m_pResample = std::make_unique<EncoderFfmpegResample>(m_pAudioStream->codec);
-#endif
-    m_pResample->openMixxx(getSampleFormatOfStream(m_pAudioStream), AV_SAMPLE_FMT_FLT);
+    const AVSampleFormat sampleFormat = getCodecContext()->sample_fmt;
+    if (!isSupportedSampleFormat(sampleFormat)) {
+        kLogger.warning()
+                << "Unsupported sample format:"
+                << av_get_sample_fmt_name(sampleFormat);
+        return OpenResult::Aborted;
+    }
+
+    m_pDecodedFrame = allocFrame();
+    if (m_pDecodedFrame == nullptr) {
+        kLogger.warning()
+                << "Failed to allocate frame";
+        return OpenResult::Failed;
+    }
+
+    // The frame size is unknown (0) for some codecs
+    const SINT maxDecodedFrameCount = std::max(
+            SINT(getCodecContext()->frame_size), kMinSampleBufferFrameCount);
+    m_sampleBuffer = ReadAheadSampleBuffer(frames2samples(maxDecodedFrameCount));
+
+    m_curFrameIndex = frameIndexMin();
+    m_restartedDecoding = true;
+    m_seekFrameIndex = frameIndexMin();
+    m_endOfStream = false;
 
     return OpenResult::Succeeded;
 }
 
 void SoundSourceFFmpeg::close() {
-    clearCache();
-
-    m_pResample.reset();
-
-    while (m_SJumpPoints.size() > 0) {
-        ffmpegLocationObject* l_SRmJmp = m_SJumpPoints[0];
-        m_SJumpPoints.remove(0);
-        free(l_SRmJmp);
-    }
+    m_sampleBuffer.clear();
+    unrefPacket();
+    freeFrame(&m_pDecodedFrame);
 
 #if AVSTREAM_FROM_API_VERSION_3_1
     m_pAudioContext.close();
@@ -439,536 +548,369 @@ void SoundSourceFFmpeg::close() {
     m_pInputFormatContext.close();
 }
 
-void SoundSourceFFmpeg::clearCache() {
-    while (m_SCache.size() > 0) {
-        struct ffmpegCacheObject* l_SRmObj = m_SCache[0];
-        m_SCache.remove(0);
-        free(l_SRmObj->bytes);
-        free(l_SRmObj);
+SINT SoundSourceFFmpeg::convertTimestampToFrameIndex(int64_t timestamp) {
+    int64_t startTime = m_pAudioStream->start_time;
+    if (startTime == AV_NOPTS_VALUE) {
+        startTime = 0;
     }
+    const AVRational frameTimeBase = {1, static_cast<int>(sampleRate())};
+    return frameIndexMin() + av_rescale_q(
+            timestamp - startTime, m_pAudioStream->time_base, frameTimeBase);
 }
 
-bool SoundSourceFFmpeg::readFramesToCache(unsigned int count, SINT offset) {
-    unsigned int l_iCount = count;
-    qint32 l_iRet = 0;
-    AVPacket l_SPacket;
-    l_SPacket.data = nullptr;
-    l_SPacket.size = 0;
-    AVFrame* l_pFrame = nullptr;
-    bool l_bStop = false;
-#if !AVSTREAM_FROM_API_VERSION_3_1
-    int l_iFrameFinished = 0;
-#endif
-    struct ffmpegCacheObject* l_SObj = nullptr;
-    struct ffmpegCacheObject* l_SRmObj = nullptr;
-    qint64 l_lLastPacketPos = -1;
-    int l_iError = 0;
-    int l_iFrameCount = 0;
-
-    while (l_iCount > 0) {
-        if (l_pFrame != nullptr) {
-            l_iFrameCount--;
-// FFMPEG 2.2 and beyond
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(54, 86, 100)
-            av_frame_free(&l_pFrame);
-// FFMPEG 0.11 and below
-#elif LIBAVCODEC_VERSION_INT <= AV_VERSION_INT(54, 23, 100)
-            av_free(l_pFrame);
-// FFMPEG 1.0 - 2.1
-#else
-            avcodec_free_frame(&l_pFrame);
-#endif
-            l_pFrame = nullptr;
-        }
-
-        if (l_bStop) {
-            break;
-        }
-        l_iFrameCount++;
-        av_init_packet(&l_SPacket);
-#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(55, 52, 0)
-        l_pFrame = avcodec_alloc_frame();
-#else
-        l_pFrame = av_frame_alloc();
-#endif
-
-        if (l_pFrame == nullptr) {
-            kLogger.debug() << "readFramesToCache: Can't alloc memory!";
-            return false;
-        }
-
-        // Read one frame (which has nothing to do with Mixxx Frame)
-        // it's some packed audio data from container like MP3, Ogg or MP4
-        if (av_read_frame(m_pInputFormatContext, &l_SPacket) >= 0) {
-            // Are we on correct audio stream. Currently we are always
-            // Using first audio stream but in future there should be
-            // possibility to choose which to use
-            // If Pos is -1 it meand FFmpeg/AVConv doesn't know it
-            // So then we use pts instead
-            if (l_SPacket.stream_index == m_pAudioStream->index &&
-                    (l_SPacket.pos >= 0 || l_SPacket.pos == -1)) {
-                // Codecs like Wavpack does it like this
-                // They work but you can say about position nothing
-                if (l_SPacket.pos == -1) {
-                    l_SPacket.pos = l_SPacket.pts;
-                }
-                if (m_lStoredSeekPoint > 0) {
-                    struct ffmpegLocationObject* l_STestObj = nullptr;
-                    if (m_SJumpPoints.size() > 0) {
-                        l_STestObj = m_SJumpPoints.first();
-
-                        if (l_STestObj->pos > l_SPacket.pos) {
-                            continue;
-                        }
-                    }
-
-                    // Seek for correct jump point
-                    if (m_lStoredSeekPoint > l_SPacket.pos) {
-#if (LIBAVCODEC_HAS_AV_PACKET_UNREF)
-                        av_packet_unref(&l_SPacket);
-#else
-                        av_free_packet(&l_SPacket);
-#endif
-                        l_SPacket.data = nullptr;
-                        l_SPacket.size = 0;
-                        continue;
-                    }
-                    m_lStoredSeekPoint = -1;
-                    m_SStoredJumpPoint = nullptr;
-                }
-
-#if AVSTREAM_FROM_API_VERSION_3_1
-                l_iRet = avcodec_send_packet(m_pAudioContext, &l_SPacket);
-
-                // AVERROR(EAGAIN) means that we need to feed more
-                // That we can decode Frame or Packet
-                if (l_iRet == AVERROR(EAGAIN)) {
-                    kLogger.warning() << "readFramesToCache: Need more packets to decode!";
-                    continue;
-                }
-
-                if (l_iRet == AVERROR_EOF || l_iRet == AVERROR(EINVAL)) {
-                    kLogger.warning() << "readFramesToCache: Warning can't decode frame!";
-                }
-
-                l_iRet = avcodec_receive_frame(m_pAudioContext, l_pFrame);
-
-                // AVERROR(EAGAIN) means that we need to feed more
-                // That we can decode Frame or Packet
-                if (l_iRet == AVERROR(EAGAIN)) {
-                    kLogger.warning() << "readFramesToCache: Need more packets to decode!";
-                    continue;
-                }
-
-                if (l_iRet == AVERROR_EOF || l_iRet == AVERROR(EINVAL)) {
-                    kLogger.warning() << "readFramesToCache: Warning can't decode frame!";
-                }
-
-                if (l_iRet == AVERROR_EOF || l_iRet < 0) {
-#else
-                // Decode audio bytes (These can be S16P or FloatP [P is Planar])
-                l_iRet = avcodec_decode_audio4(m_pAudioStream->codec, l_pFrame, &l_iFrameFinished, &l_SPacket);
-                if (l_iRet <= 0) {
-#endif
-                    // An error or EOF occurred,index break out and return what
-                    // we have so far.
-                    kLogger.debug() << "readFramesToCache: EOF or uncoverable error!";
-                    l_bStop = true;
-                    continue;
-                } else {
-                    l_iRet = 0;
-                    l_SObj = (struct ffmpegCacheObject*)malloc(sizeof(struct ffmpegCacheObject));
-                    if (l_SObj == nullptr) {
-                        kLogger.debug() << "readFramesToCache: Not enough memory!";
-                        l_bStop = true;
-                        continue;
-                    }
-                    memset(l_SObj, 0x00, sizeof(struct ffmpegCacheObject));
-
-                    // Try to convert it to Mixxx understand output format
-                    // which is pure Stereo Float
-                    l_iRet = m_pResample->reSampleMixxx(l_pFrame, &l_SObj->bytes);
-
-                    if (l_iRet > 0) {
-                        // Remove from cache
-                        if (m_SCache.size() >= (AUDIOSOURCEFFMPEG_CACHESIZE - 10)) {
-                            l_SRmObj = m_SCache[0];
-                            m_SCache.remove(0);
-                            free(l_SRmObj->bytes);
-                            free(l_SRmObj);
-                        }
-
-                        // Add to cache and store byte place to memory
-                        m_SCache.append(l_SObj);
-                        l_SObj->startFrame = m_lCacheFramePos;
-                        l_SObj->length = l_iRet;
-                        m_lCacheFramePos += AUDIOSOURCEFFMPEG_BYTEOFFSET_TO_MIXXXFRAME(l_iRet);
-
-                        // Ogg/Opus have packages pos that have many
-                        // audio frames so seek next unique pos..
-                        if (l_SPacket.pos != l_lLastPacketPos) {
-                            l_lLastPacketPos = l_SPacket.pos;
-                            m_lStoreCount++;
-                        }
-
-                        // If we are over last storepos and we have read more than jump point need is
-                        // and pos is unique we store it to memory
-                        //
-                        // So why number 32? Sorry I just made that up from the hat there is no
-                        // math behind it. Number 32 it's not too big nor jumps points are not
-                        // too close each other. Mainly it's ugly compromise with MP3,MP4,OGG and WMA
-                        // different codec frame sizes
-                        if (m_lStoreCount == 32) {
-                            struct ffmpegLocationObject* l_STestObj = nullptr;
-
-                            if (m_SJumpPoints.size() > 0) {
-                                l_STestObj = m_SJumpPoints.last();
-                            }
-                            // Check whether we have this jumppoint stored already or not
-                            // We should have jumppoints below that pos
-                            if (l_STestObj == nullptr || l_STestObj->pos < l_SPacket.pos) {
-                                struct ffmpegLocationObject* l_SJmp = (struct ffmpegLocationObject*)malloc(
-                                        sizeof(struct ffmpegLocationObject));
-                                m_lLastStoredPos = m_lCacheFramePos;
-                                l_SJmp->startFrame = m_lCacheFramePos;
-                                l_SJmp->pos = l_SPacket.pos;
-                                l_SJmp->pts = l_SPacket.pts;
-                                m_SJumpPoints.append(l_SJmp);
-                            }
-                            m_lStoreCount = 0;
-                        }
-
-                        if (offset < 0 || offset <= m_lCacheFramePos) {
-                            l_iCount--;
-                        }
-                    } else {
-                        free(l_SObj);
-                        l_SObj = nullptr;
-                        kLogger.debug() << "readFramesToCache: General error in audio decode:" << l_iRet;
-                    }
-                }
+int64_t SoundSourceFFmpeg::convertFrameIndexToTimestamp(SINT frameIndex) {
+    int64_t startTime = m_pAudioStream->start_time;
+    if (startTime == AV_NOPTS_VALUE) {
+        startTime = 0;
+    }
+    const AVRational frameTimeBase = {1, static_cast<int>(sampleRate())};
+    return startTime + av_rescale_q(
+            frameIndex - frameIndexMin(), frameTimeBase, m_pAudioStream->time_base);
+}
 
+void SoundSourceFFmpeg::unrefPacket() {
 #if (LIBAVCODEC_HAS_AV_PACKET_UNREF)
-                av_packet_unref(&l_SPacket);
+    av_packet_unref(&m_packet);
 #else
-                av_free_packet(&l_SPacket);
+    av_free_packet(&m_packet);
 #endif
-                l_SPacket.data = nullptr;
-                l_SPacket.size = 0;
-
-            } else {
-                l_iError++;
-                if (l_iError == 5) {
-                    // Stream end and we couldn't read enough frames
-                    l_bStop = true;
-                }
-            }
-
-        } else {
-            kLogger.debug() << "readFramesToCache: Packet too big or File end";
-            l_bStop = true;
-        }
-    }
-
-    if (l_pFrame != nullptr) {
-        l_iFrameCount--;
-// FFMPEG 2.2 and beyond
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(54, 86, 100)
-        av_frame_unref(l_pFrame);
-        av_frame_free(&l_pFrame);
-// FFMPEG 0.11 and below
-#elif LIBAVCODEC_VERSION_INT <= AV_VERSION_INT(54, 23, 100)
-        av_free(l_pFrame);
-// FFMPEG 1.0 - 2.1
-#else
-    avcodec_free_frame(&l_pFrame);
+    m_packet.data = nullptr;
+    m_packet.size = 0;
+#if !AVSTREAM_FROM_API_VERSION_3_1
+    m_pendingPacket = m_packet;
 #endif
-        l_pFrame = nullptr;
-    }
-
-    if (l_iFrameCount > 0) {
-        kLogger.debug() << "readFramesToCache(): Frame balance is not 0 it is: " << l_iFrameCount;
-    }
-
-    if (m_SCache.isEmpty()) {
-        kLogger.debug() << "readFramesToCache(): Can't read frames. Cache empty!";
-        return false;
-    }
-
-    l_SObj = m_SCache.first();
-    m_lCacheStartFrame = l_SObj->startFrame;
-    l_SObj = m_SCache.last();
-    m_lCacheEndFrame = (l_SObj->startFrame + l_SObj->length);
-
-    if (!l_iCount) {
-        return true;
-    } else {
-        return false;
-    }
-} // namespace mixxx
+}
 
-bool SoundSourceFFmpeg::getBytesFromCache(CSAMPLE* buffer, SINT offset, SINT size) {
-    struct ffmpegCacheObject* l_SObj = nullptr;
-    qint32 l_lPos = 0;
-    quint32 l_lLeft = AUDIOSOURCEFFMPEG_MIXXXFRAME_TO_BYTEOFFSET(size);
-    quint32 l_lOffset = 0;
-    quint32 l_lBytesToCopy = 0;
-    bool l_bEndOfFile = false;
-
-    char* l_pBuffer = (char*)buffer;
-
-    // If cache is empty then return without crash.
-    if (m_SCache.isEmpty()) {
-        kLogger.debug() << "getBytesFromCache: Cache is empty can't return bytes";
-        if (l_pBuffer != nullptr) {
-            memset(l_pBuffer, 0x00, l_lLeft);
-        }
+bool SoundSourceFFmpeg::restartDecoding(SINT frameIndex, SINT prerollFrameCount) {
+    DEBUG_ASSERT(isValidFrameIndex(frameIndex));
+    DEBUG_ASSERT(prerollFrameCount >= 0);
+    // Restart decoding some frames before the actual target position
+    // to avoid audible glitches. The preceding frames are skipped
+    // while reading.
+    const SINT seekFrameIndex = std::max(
+            frameIndexMin(), frameIndex - prerollFrameCount);
+    const int av_seek_frame_result = av_seek_frame(
+            m_pInputFormatContext,
+            m_pAudioStream->index,
+            convertFrameIndexToTimestamp(seekFrameIndex),
+            AVSEEK_FLAG_BACKWARD);
+    if (av_seek_frame_result < 0) {
+        kLogger.warning()
+                << "av_seek_frame() failed and returned"
+                << av_seek_frame_result
+                << "when seeking to frame"
+                << seekFrameIndex;
         return false;
     }
+    avcodec_flush_buffers(getCodecContext());
+    unrefPacket();
+    m_sampleBuffer.clear();
+    // Only an estimate until the timestamp of the first
+    // decoded frame is available
+    m_curFrameIndex = seekFrameIndex;
+    m_restartedDecoding = true;
+    m_seekFrameIndex = seekFrameIndex;
+    m_endOfStream = false;
+    return true;
+}
 
-    // Is offset bigger than start of cache
-    if (offset >= m_lCacheStartFrame) {
-        int l_lTmpLen = 0;
-        // If last pos is (which it shouldn't) use caches end
-        if (m_lCacheLastPos == 0) {
-            m_lCacheLastPos = m_SCache.size() - 1;
-        }
-
-        // Seek to correct FrameIndex (Minus 5 for faster seek)
-        //
-        // This could be done per steps but because there
-        // Jump points can be far away and codec frames are small
-        // just jump to point where is safe to start.
-        for (l_lPos = m_lCacheLastPos; l_lPos >= 0; l_lPos -= 5) {
-            l_SObj = m_SCache[l_lPos];
-
-            // Because length is in byte we have to convert it to Frames
-            l_lTmpLen = AUDIOSOURCEFFMPEG_BYTEOFFSET_TO_MIXXXFRAME(l_SObj->length);
-
-            if ((l_SObj->startFrame + l_lTmpLen) < offset) {
-                break;
-            }
-        }
-
-        // Because we step 5 backward we can end up to below zero
-        // We can't go further so hope for the best
-        if (l_lPos < 0) {
-            l_lPos = 0;
+bool SoundSourceFFmpeg::decodeNextFrame() {
+    AVCodecContext* pCodecContext = getCodecContext();
+    while (!m_endOfStream) {
+#if AVSTREAM_FROM_API_VERSION_3_1
+        const int avcodec_receive_frame_result =
+                avcodec_receive_frame(pCodecContext, m_pDecodedFrame);
+        if (avcodec_receive_frame_result == 0) {
+            return true;
         }
-
-        // This shouldn't never happen.. because it's nearly impossible
-        // but because it can happen double check
-        if (l_lPos >= m_SCache.size()) {
-            l_lPos = m_SCache.size() - 1;
+        if (avcodec_receive_frame_result == AVERROR_EOF) {
+            m_endOfStream = true;
+            break;
         }
-
-        // Use this Cache object as starting point
-        l_SObj = m_SCache[l_lPos];
-
-        if (l_SObj == nullptr) {
-            kLogger.debug() << "getBytesFromCache: Cache object nullptr";
-            return false;
+        if (avcodec_receive_frame_result != AVERROR(EAGAIN)) {
+            kLogger.warning()
+                    << "avcodec_receive_frame() failed and returned"
+                    << avcodec_receive_frame_result;
+            m_endOfStream = true;
+            break;
         }
-
-        if (l_pBuffer == nullptr) {
-            kLogger.debug() << "getBytesFromCache: Out buffer nullptr";
-            return false;
+        // The decoder needs more input
+        if (av_read_frame(m_pInputFormatContext, &m_packet) < 0) {
+            // Flush the remaining frames out of the decoder
+            avcodec_send_packet(pCodecContext, nullptr);
+            continue;
         }
-
-        while (l_lLeft > 0) {
-            // If Cache is running low read more
-            if ((l_lPos + 5) > m_SCache.size() && l_bEndOfFile == false) {
-                offset = l_SObj->startFrame;
-                // Read 50 frames from current pos. If we hit file end before that
-                // exit
-                if (readFramesToCache(50, AUDIOSOURCEFFMPEG_FILL_FROM_CURRENTPOS) == false) {
-                    // File has ended.. don't try to cache anymore
-                    // or some fatal error has occurred so.. just don't
-                    l_bEndOfFile = true;
-                }
-
-                // Seek back to correct place
-                for (l_lPos = (m_SCache.size() - 50); l_lPos > 0; l_lPos--) {
-                    l_SObj = m_SCache[l_lPos];
-                    if ((l_SObj->startFrame + l_SObj->length) < offset) {
-                        break;
-                    }
-                }
-
-                if (l_lPos < m_SCache.size() && l_lPos >= 0) {
-                    l_SObj = m_SCache[l_lPos];
-                    continue;
-                } else if (l_lPos < 0) {
-                    l_lPos = 0;
-                } else {
-                    l_SObj = m_SCache.last();
-                    l_lPos = l_lPos < m_SCache.size() - 1;
-                }
-            }
-
-            // If Cache object ain't correct then calculate offset
-            if (l_SObj->startFrame <= offset) {
-                // We have to convert again it to bytes
-                l_lOffset = AUDIOSOURCEFFMPEG_MIXXXFRAME_TO_BYTEOFFSET(offset - l_SObj->startFrame);
-            }
-
-            // Okay somehow offset is bigger than our Cache object have bytes
-            if (l_lOffset >= l_SObj->length) {
-                if ((l_lPos + 1) < m_SCache.size()) {
-                    l_SObj = m_SCache[++l_lPos];
-                    continue;
-                } else {
-                    kLogger.debug() << "getBytesFromCache: Buffer run out. Shouldn't happen!";
-                    if (l_pBuffer != nullptr) {
-                        memset(l_pBuffer, 0x00, l_lLeft);
-                    }
-                    return false;
-                }
+        if (m_packet.stream_index == m_pAudioStream->index) {
+            const int avcodec_send_packet_result =
+                    avcodec_send_packet(pCodecContext, &m_packet);
+            if (avcodec_send_packet_result < 0) {
+                // Skip corrupt packets
+                kLogger.warning()
+                        << "avcodec_send_packet() failed and returned"
+                        << avcodec_send_packet_result;
             }
-
-            // If bytes left is bigger than FFmpeg frame bytes available
-            // then copy to buffer end and then jump to next FFmpeg frame
-            // to understand this here are some examples
-            //   * MP3 have size 2304 * 4
-            //   * OGG/Opus size 256 - 1024
-            //   * WMA size 32767 - 131070
-            // and all these are separated in packets nor solid stream of bytes
-            // that just can be copied to buffer
-            // so that's why this kind of abstraction is needed
-            if (l_lLeft > (l_SObj->length - l_lOffset)) {
-                // calculate start point of copy
-                l_lBytesToCopy = l_SObj->length - l_lOffset;
-                memcpy(l_pBuffer, (l_SObj->bytes + l_lOffset), l_lBytesToCopy);
-                l_lOffset = 0;
-                l_pBuffer += l_lBytesToCopy;
-                l_lLeft -= l_lBytesToCopy;
-            } else {
-                memcpy(l_pBuffer, (l_SObj->bytes + l_lOffset), l_lLeft);
-                l_lLeft = 0;
+        }
+        unrefPacket();
+#else
+        if (m_pendingPacket.size <= 0) {
+            unrefPacket();
+            if (av_read_frame(m_pInputFormatContext, &m_packet) < 0) {
+                m_endOfStream = true;
+                break;
             }
-
-            // If we have more items of cache use them
-            // or after that just zero buffer..
-            if ((l_lPos + 1) < m_SCache.size()) {
-                l_SObj = m_SCache[++l_lPos];
-            } else {
-                // With MP3 VBR length of audio is just a guess
-                // it's near good as it can get but it can be too long
-                // so fill buffer with 0x00 (zero) that we don't get ugly
-                // noise at the end of the file
-                memset(l_pBuffer, 0x00, l_lLeft);
-                l_lLeft = 0;
+            if (m_packet.stream_index != m_pAudioStream->index) {
+                continue;
             }
+            m_pendingPacket = m_packet;
         }
-
-        m_lCacheLastPos = --l_lPos;
-        return true;
+        int gotFrame = 0;
+        const int avcodec_decode_audio4_result = avcodec_decode_audio4(
+                pCodecContext, m_pDecodedFrame, &gotFrame, &m_pendingPacket);
+        if (avcodec_decode_audio4_result < 0) {
+            // Skip the remainder of corrupt packets
+            kLogger.warning()
+                    << "avcodec_decode_audio4() failed and returned"
+                    << avcodec_decode_audio4_result;
+            m_pendingPacket.size = 0;
+            continue;
+        }
+        // Packets might contain multiple frames
+        m_pendingPacket.data += avcodec_decode_audio4_result;
+        m_pendingPacket.size -= avcodec_decode_audio4_result;
+        if (gotFrame) {
+            return true;
+        }
+#endif
     }
-
     return false;
 }
 
+void SoundSourceFFmpeg::convertDecodedFrame(
+        CSAMPLE* pOutput,
+        SINT frameOffset,
+        SINT frameCount) const {
+    const AVSampleFormat sampleFormat =
+            static_cast<AVSampleFormat>(m_pDecodedFrame->format);
+    const bool planar = av_sample_fmt_is_planar(sampleFormat);
+    switch (av_get_packed_sample_fmt(sampleFormat)) {
+    case AV_SAMPLE_FMT_U8:
+        convertSamples<uint8_t>(
+                m_pDecodedFrame, planar, m_streamChannelCount, channelCount(), frameOffset, frameCount, pOutput,
+                [](uint8_t sample) {
+                    return (static_cast<CSAMPLE>(sample) - 128.0f) / 128.0f;
+                });
+        break;
+    case AV_SAMPLE_FMT_S16:
+        convertSamples<int16_t>(
+                m_pDecodedFrame, planar, m_streamChannelCount, channelCount(), frameOffset, frameCount, pOutput,
+                [](int16_t sample) {
+                    return static_cast<CSAMPLE>(sample) / 32768.0f;
+                });
+        break;
+    case AV_SAMPLE_FMT_S32:
+        convertSamples<int32_t>(
+                m_pDecodedFrame, planar, m_streamChannelCount, channelCount(), frameOffset, frameCount, pOutput,
+                [](int32_t sample) {
+                    return static_cast<CSAMPLE>(sample) / 2147483648.0f;
+                });
+        break;
+    case AV_SAMPLE_FMT_FLT:
+        convertSamples<float>(
+                m_pDecodedFrame, planar, m_streamChannelCount, channelCount(), frameOffset, frameCount, pOutput,
+                [](float sample) {
+                    return static_cast<CSAMPLE>(sample);
+                });
+        break;
+    case AV_SAMPLE_FMT_DBL:
+        convertSamples<double>(
+                m_pDecodedFrame, planar, m_streamChannelCount, channelCount(), frameOffset, frameCount, pOutput,
+                [](double sample) {
+                    return static_cast<CSAMPLE>(sample);
+                });
+        break;
+    default:
+        DEBUG_ASSERT(!"unsupported sample format");
+        SampleUtil::clear(pOutput, frames2samples(frameCount));
+    }
+}
+
 ReadableSampleFrames SoundSourceFFmpeg::readSampleFramesClamped(
         WritableSampleFrames writableSampleFrames) {
     const SINT firstFrameIndex = writableSampleFrames.frameIndexRange().start();
 
-    const SINT seekFrameIndex = firstFrameIndex;
-    if ((m_currentMixxxFrameIndex != seekFrameIndex) || (m_SCache.size() == 0)) {
-        int ret = 0;
-        qint64 i = 0;
-        struct ffmpegLocationObject* l_STestObj = nullptr;
-
-        if (seekFrameIndex < m_lCacheStartFrame) {
-            // Seek to set (start of the stream which is FFmpeg frame 0)
-            // because we are dealing with compressed audio FFmpeg takes
-            // best of to seek that point (in this case 0 Is always there)
-            // in every other case we should provide MIN and MAX tolerance
-            // which we can take.
-            // FFmpeg just just can't take zero as MAX tolerance so we try to
-            // just make some tolerable (which is never used because zero point
-            // should always be there) some number (which is 0xffff 65535)
-            // that is chosen because in WMA frames can be that big and if it's
-            // smaller than the frame we are seeking we can get into error
-            ret = avformat_seek_file(m_pInputFormatContext,
-                    m_pAudioStream->index,
-                    0,
-                    0,
-                    0xffff,
-                    AVSEEK_FLAG_BACKWARD);
-
-            if (ret < 0) {
-                kLogger.warning() << "seek: Can't seek to 0 byte!";
-                return ReadableSampleFrames();
+    if ((firstFrameIndex < m_curFrameIndex) ||                         // seeking backwards?
+            (firstFrameIndex > (m_curFrameIndex + kNumberOfPrerollFrames))) { // jumping forward?
+        if (!restartDecoding(firstFrameIndex, kNumberOfPrerollFrames)) {
+            // Abort
+            return ReadableSampleFrames(
+                    IndexRange::between(
+                            firstFrameIndex,
+                            firstFrameIndex));
+        }
+    }
+    // Decoding starts before or at the actual target position. The
+    // preceding frames are skipped when reading.
+    DEBUG_ASSERT(m_curFrameIndex <= firstFrameIndex);
+
+    CSAMPLE* const pOutput = writableSampleFrames.writableData();
+    const SINT endFrameIndex = writableSampleFrames.frameIndexRange().end();
+    SINT outputFrameIndex = firstFrameIndex;
+    while (outputFrameIndex < endFrameIndex) {
+        if (!m_sampleBuffer.empty()) {
+            // Consume previously decoded sample data
+            DEBUG_ASSERT(m_curFrameIndex <= outputFrameIndex);
+            const SINT precedingFrameCount = outputFrameIndex - m_curFrameIndex;
+            if (precedingFrameCount > 0) {
+                const SampleBuffer::ReadableSlice skippedSlice(
+                        m_sampleBuffer.shrinkForReading(
+                                frames2samples(precedingFrameCount)));
+                m_curFrameIndex += samples2frames(skippedSlice.length());
+                continue;
+            }
+            const SampleBuffer::ReadableSlice readableSlice(
+                    m_sampleBuffer.shrinkForReading(
+                            frames2samples(endFrameIndex - outputFrameIndex)));
+            if (pOutput) {
+                SampleUtil::copy(
+                        pOutput + frames2samples(outputFrameIndex - firstFrameIndex),
+                        readableSlice.data(),
+                        readableSlice.length());
             }
+            outputFrameIndex += samples2frames(readableSlice.length());
+            m_curFrameIndex = outputFrameIndex;
+            continue;
+        }
+        // All previously decoded sample data has been consumed now
+        DEBUG_ASSERT(m_sampleBuffer.empty());
+
+        if (!decodeNextFrame()) {
+            break; // EOF or error
+        }
+        VERIFY_OR_DEBUG_ASSERT(getCodecContext()->channels == m_streamChannelCount) {
+            kLogger.critical()
+                    << "Unexpected number of channels"
+                    << getCodecContext()->channels
+                    << "<>" << m_streamChannelCount;
+            break; // abort
+        }
+        const SINT decodedFrameCount = m_pDecodedFrame->nb_samples;
 
-            clearCache();
-            m_lCacheStartFrame = 0;
-            m_lCacheEndFrame = 0;
-            m_lCacheLastPos = 0;
-            m_lCacheFramePos = 0;
-            m_lStoredSeekPoint = -1;
-
-            // Try to find some jump point near to
-            // where we are located so we don't needed
-            // to try guess it
-            if (m_SJumpPoints.size() > 0) {
-                l_STestObj = m_SJumpPoints.first();
-
-                if (seekFrameIndex > l_STestObj->startFrame) {
-                    for (i = 0; i < m_SJumpPoints.size(); i++) {
-                        if (m_SJumpPoints[i]->startFrame >= seekFrameIndex) {
-                            if (i > 0) {
-                                i--;
-                            }
-
-                            m_lCacheFramePos = m_SJumpPoints[i]->startFrame;
-                            m_lStoredSeekPoint = m_SJumpPoints[i]->pos;
-                            m_SStoredJumpPoint = m_SJumpPoints[i];
-                            break;
-                        }
-                    }
+        if (m_restartedDecoding) {
+            m_restartedDecoding = false;
+#if AVSTREAM_FROM_API_VERSION_3_1
+            const int64_t timestamp = m_pDecodedFrame->pts;
+#else
+            const int64_t timestamp = m_pDecodedFrame->pkt_pts;
+#endif
+            // All following frames are positioned by counting the decoded
+            // frames, because timestamps might be rounded
+            if (timestamp != AV_NOPTS_VALUE) {
+                m_curFrameIndex = convertTimestampToFrameIndex(timestamp);
+            } else {
+                kLogger.debug()
+                        << "Missing timestamp of first decoded frame";
+            }
+            if ((m_curFrameIndex > outputFrameIndex) &&
+                    (m_seekFrameIndex > frameIndexMin())) {
+                // The demuxer has not seeked far enough back. Double
+                // the distance to the target position and try again.
+                DEBUG_ASSERT(outputFrameIndex == firstFrameIndex);
+                const SINT prerollFrameCount = 2 * std::max(
+                        outputFrameIndex - m_seekFrameIndex,
+                        kNumberOfPrerollFrames);
+                kLogger.debug()
+                        << "Decoding restarted at"
+                        << m_curFrameIndex
+                        << "instead of before"
+                        << outputFrameIndex
+                        << "- seeking"
+                        << prerollFrameCount
+                        << "frames back";
+                if (!restartDecoding(outputFrameIndex, prerollFrameCount)) {
+                    break; // abort
                 }
+                continue;
             }
+        }
+        const SINT decodedFrameIndex = m_curFrameIndex;
 
-            if (seekFrameIndex == frameIndexMin()) {
-                // Because we are in the beginning just read cache full
-                // but leave 50 of just in case
-                // -1 one means we are seeking from current position and
-                // filling the cache
-                readFramesToCache((AUDIOSOURCEFFMPEG_CACHESIZE - 50),
-                        AUDIOSOURCEFFMPEG_FILL_FROM_CURRENTPOS);
+        if (decodedFrameIndex > outputFrameIndex) {
+            // The stream has a gap at the beginning or even seeking
+            // to the first frame has not been accurate enough
+            const SINT missingFrameCount =
+                    std::min(decodedFrameIndex, endFrameIndex) - outputFrameIndex;
+            kLogger.warning()
+                    << "Filling"
+                    << missingFrameCount
+                    << "missing frames with silence at"
+                    << outputFrameIndex;
+            if (pOutput) {
+                SampleUtil::clear(
+                        pOutput + frames2samples(outputFrameIndex - firstFrameIndex),
+                        frames2samples(missingFrameCount));
             }
+            outputFrameIndex += missingFrameCount;
         }
 
-        if (m_lCacheEndFrame <= seekFrameIndex) {
-            // Cache tries to read until it gets to frameIndex
-            // after that we still read 100 FFmpeg frames to memory
-            // so we have good cache to go forward (100) and backward (900)
-            // from the point
-            readFramesToCache(100, seekFrameIndex);
+        // Skip decoded frames that precede the output position. A frame
+        // that starts at or after the end of the requested range is kept
+        // as a whole for the next read.
+        const SINT skippedFrameCount = std::max(SINT(0), std::min(
+                decodedFrameCount, outputFrameIndex - decodedFrameIndex));
+        const SINT readFrameCount = std::min(
+                decodedFrameCount - skippedFrameCount,
+                endFrameIndex - outputFrameIndex);
+        DEBUG_ASSERT(skippedFrameCount >= 0);
+        DEBUG_ASSERT(readFrameCount >= 0);
+        if (pOutput && (readFrameCount > 0)) {
+            // Convert samples directly into the output buffer
+            convertDecodedFrame(
+                    pOutput + frames2samples(outputFrameIndex - firstFrameIndex),
+                    skippedFrameCount,
+                    readFrameCount);
+        }
+        outputFrameIndex += readFrameCount;
+        m_curFrameIndex = decodedFrameIndex + skippedFrameCount + readFrameCount;
+
+        // Keep the remaining samples for the next read
+        const SINT bufferedFrameCount =
+                decodedFrameCount - (skippedFrameCount + readFrameCount);
+        if (bufferedFrameCount > 0) {
+            const SINT bufferedSampleCount = frames2samples(bufferedFrameCount);
+            if (m_sampleBuffer.capacity() < bufferedSampleCount) {
+                kLogger.debug()
+                        << "Increasing the capacity of the sample buffer for"
+                        << decodedFrameCount
+                        << "decoded frames";
+                m_sampleBuffer.adjustCapacity(frames2samples(decodedFrameCount));
+            }
+            const SampleBuffer::WritableSlice writableSlice(
+                    m_sampleBuffer.growForWriting(bufferedSampleCount));
+            DEBUG_ASSERT(writableSlice.length() == bufferedSampleCount);
+            convertDecodedFrame(
+                    writableSlice.data(),
+                    skippedFrameCount + readFrameCount,
+                    bufferedFrameCount);
         }
-
-        m_currentMixxxFrameIndex = seekFrameIndex;
-
-        m_bIsSeeked = m_currentMixxxFrameIndex != frameIndexMin();
     }
-    DEBUG_ASSERT(m_currentMixxxFrameIndex == seekFrameIndex);
 
-    const SINT numberOfFrames = writableSampleFrames.frameLength();
-
-    DEBUG_ASSERT(m_currentMixxxFrameIndex == firstFrameIndex);
-    DEBUG_ASSERT(m_SCache.size() > 0);
-    getBytesFromCache(
-            writableSampleFrames.writableData(),
-            m_currentMixxxFrameIndex,
-            numberOfFrames);
-    m_currentMixxxFrameIndex += numberOfFrames;
-    m_bIsSeeked = false;
+    if (m_endOfStream && (outputFrameIndex < endFrameIndex)) {
+        // The duration of VBR streams is only an estimate. Fill the
+        // remaining frames with silence to avoid ugly noise at the
+        // end of the stream.
+        if (pOutput) {
+            SampleUtil::clear(
+                    pOutput + frames2samples(outputFrameIndex - firstFrameIndex),
+                    frames2samples(endFrameIndex - outputFrameIndex));
+        }
+        outputFrameIndex = endFrameIndex;
+    }
 
+    const SINT numberOfFrames = outputFrameIndex - firstFrameIndex;
     return ReadableSampleFrames(
             IndexRange::forward(firstFrameIndex, numberOfFrames),
             SampleBuffer::ReadableSlice(
-                    writableSampleFrames.writableData(),
+                    pOutput,
                     std::min(writableSampleFrames.writableLength(), frames2samples(numberOfFrames))));
 }
 
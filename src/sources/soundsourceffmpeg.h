@@ -16,18 +16,13 @@ extern "C" {
 
 } // extern "C"
 
-#include <QVector>
-
 #include "sources/soundsourceprovider.h"
 
-#include "util/memory.h" // std::unique_ptr<> + std::make_unique()
+#include "util/readaheadsamplebuffer.h"
 
 #define AVSTREAM_FROM_API_VERSION_3_1 \
     (LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 48, 0))
 
-// forward declaration
-class EncoderFfmpegResample;
-
 namespace {
 
 // Because 3.1 changed API how to access thigs in AVStream
@@ -98,18 +93,6 @@ AVStreamWrapperImpl m_pAVStreamWrapper;
 
 namespace mixxx {
 
-struct ffmpegLocationObject {
-    SINT pos;
-    SINT pts;
-    SINT startFrame;
-};
-
-struct ffmpegCacheObject {
-    SINT startFrame;
-    SINT length;
-    quint8* bytes;
-};
-
 class SoundSourceFFmpeg : public SoundSource {
   public:
     explicit SoundSourceFFmpeg(const QUrl& url);
@@ -126,12 +109,29 @@ class SoundSourceFFmpeg : public SoundSource {
             OpenMode mode,
             const OpenParams& params) override;
 
-    bool readFramesToCache(unsigned int count, SINT offset);
-    bool getBytesFromCache(CSAMPLE* buffer, SINT offset, SINT size);
-    SINT getSizeofCache();
-    void clearCache();
+    AVCodecContext* getCodecContext();
+
+    // Conversion between frame indices and timestamps in the
+    // time base of the audio stream
+    SINT convertTimestampToFrameIndex(int64_t timestamp);
+    int64_t convertFrameIndexToTimestamp(SINT frameIndex);
 
-    unsigned int read(unsigned long size, SAMPLE*);
+    // Seeks the demuxer to a packet at least prerollFrameCount frames
+    // before the given frame index and discards all buffered packets and
+    // samples
+    bool restartDecoding(SINT frameIndex, SINT prerollFrameCount);
+
+    // Decodes the next frame of the audio stream into m_pDecodedFrame
+    // and returns false at the end of the stream or on errors
+    bool decodeNextFrame();
+    void unrefPacket();
+
+    // Converts decoded samples from m_pDecodedFrame into interleaved
+    // floating point samples
+    void convertDecodedFrame(
+            CSAMPLE* pOutput,
+            SINT frameOffset,
+            SINT frameCount) const;
 
     static AVFormatContext* openInputFile(const QString& fileName);
 
@@ -263,22 +263,37 @@ class SoundSourceFFmpeg : public SoundSource {
     ClosableAVCodecContextPtr m_pAudioContext;
 #endif
 
-    std::unique_ptr<EncoderFfmpegResample> m_pResample;
-
-    SINT m_currentMixxxFrameIndex;
-
-    bool m_bIsSeeked;
-
-    SINT m_lCacheFramePos;
-    SINT m_lCacheStartFrame;
-    SINT m_lCacheEndFrame;
-    SINT m_lCacheLastPos;
-    QVector<struct ffmpegCacheObject*> m_SCache;
-    QVector<struct ffmpegLocationObject*> m_SJumpPoints;
-    SINT m_lLastStoredPos;
-    SINT m_lStoreCount;
-    SINT m_lStoredSeekPoint;
-    struct ffmpegLocationObject* m_SStoredJumpPoint;
+    // Allocated once when opening the file and reused for each
+    // packet and frame while decoding
+    AVPacket m_packet;
+#if !AVSTREAM_FROM_API_VERSION_3_1
+    // The part of m_packet that has not been consumed by the decoder
+    AVPacket m_pendingPacket;
+#endif
+    AVFrame* m_pDecodedFrame;
+
+    // Might differ from channelCount() if the decoded signal
+    // is up- or down-mixed to stereo
+    SINT m_streamChannelCount;
+
+    // The remaining samples of the most recently decoded frame that
+    // have not been read yet. The capacity is sufficient for a whole
+    // frame and only needs to be increased for unusually large
+    // frames, i.e. no memory is allocated while reading.
+    ReadAheadSampleBuffer m_sampleBuffer;
+
+    // The index of the first frame in m_sampleBuffer or, if it is empty,
+    // of the next frame that will be decoded
+    SINT m_curFrameIndex;
+
+    // The position of the first decoded frame after seeking is
+    // determined by its timestamp
+    bool m_restartedDecoding;
+    // The position that has been requested from the demuxer when
+    // decoding was restarted
+    SINT m_seekFrameIndex;
+
+    bool m_endOfStream;
 };
 
 class SoundSourceProviderFFmpeg : public SoundSourceProvider {
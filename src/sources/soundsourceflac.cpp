@@ -1,5 +1,7 @@
 #include "sources/soundsourceflac.h"
 
+#include "sources/bytesource.h"
+
 #include "util/logger.h"
 #include "util/math.h"
 #include "util/sample.h"
@@ -73,10 +75,13 @@ const unsigned kBitsPerSampleDefault = 0;
 
 SoundSourceFLAC::SoundSourceFLAC(const QUrl& url)
         : SoundSource(url, "flac"),
-          m_file(getLocalFileName()),
           m_decoder(nullptr),
           m_maxBlocksize(0),
           m_bitsPerSample(kBitsPerSampleDefault),
+          m_streamChannelCount(0),
+          m_pDirectOutput(nullptr),
+          m_directOutputFrameCapacity(0),
+          m_directOutputFrameCount(0),
           m_curFrameIndex(0) {
 }
 
@@ -86,12 +91,19 @@ SoundSourceFLAC::~SoundSourceFLAC() {
 
 SoundSource::OpenResult SoundSourceFLAC::tryOpen(
         OpenMode /*mode*/,
-        const OpenParams& /*config*/) {
-    DEBUG_ASSERT(!m_file.isOpen());
-    if (!m_file.open(QIODevice::ReadOnly)) {
+        const OpenParams& params) {
+    DEBUG_ASSERT(!m_pFile);
+    // The number of decoded channels is set when
+    // processing the metadata
+    m_openParams = params;
+
+    ByteSource::Options byteSourceOptions;
+    byteSourceOptions.statsKey = params.ioStatsKey();
+    m_pFile = ByteSource::open(getLocalFileName(), byteSourceOptions);
+    if (!m_pFile) {
         kLogger.warning()
                 << "Failed to open FLAC file:"
-                << m_file.fileName();
+                << getLocalFileName();
         return OpenResult::Failed;
     }
 
@@ -139,7 +151,7 @@ void SoundSourceFLAC::close() {
         m_decoder = nullptr;
     }
 
-    m_file.close();
+    m_pFile.reset();
 }
 
 ReadableSampleFrames SoundSourceFLAC::readSampleFramesClamped(
@@ -169,14 +181,14 @@ ReadableSampleFrames SoundSourceFLAC::readSampleFramesClamped(
                 // Failure
                 kLogger.warning()
                         << "Seek error at" << seekFrameIndex
-                        << "in file" << m_file.fileName();
+                        << "in file" << getLocalFileName();
                 if (FLAC__STREAM_DECODER_SEEK_ERROR == FLAC__stream_decoder_get_state(m_decoder)) {
                     // Flush the input stream of the decoder according to the
                     // documentation of FLAC__stream_decoder_seek_absolute()
                     if (!FLAC__stream_decoder_flush(m_decoder)) {
                         kLogger.warning()
                                 << "Failed to flush input buffer of the FLAC decoder after seek failure"
-                                << "in file" << m_file.fileName();
+                                << "in file" << getLocalFileName();
                         invalidateCurFrameIndex();
                         // ...and abort
                         return ReadableSampleFrames(
@@ -232,14 +244,25 @@ ReadableSampleFrames SoundSourceFLAC::readSampleFramesClamped(
         if (m_sampleBuffer.empty()) {
             // Save the current frame index
             const SINT curFrameIndexBeforeProcessing = m_curFrameIndex;
+            // Decode the next block directly into the output buffer
+            m_pDirectOutput = writableSampleFrames.writableData() ?
+                    writableSampleFrames.writableData(outputSampleOffset) :
+                    nullptr;
+            m_directOutputFrameCapacity = samples2frames(numberOfSamplesRemaining);
+            m_directOutputFrameCount = 0;
             // Documentation of FLAC__stream_decoder_process_single():
             // "Depending on what was decoded, the metadata or write callback
             // will be called with the decoded metadata block or audio frame."
             // See also: https://xiph.org/flac/api/group__flac__stream__decoder.html#ga9d6df4a39892c05955122cf7f987f856
-            if (!FLAC__stream_decoder_process_single(m_decoder)) {
+            const bool processed = FLAC__stream_decoder_process_single(m_decoder);
+            const SINT directOutputFrameCount = m_directOutputFrameCount;
+            m_pDirectOutput = nullptr;
+            m_directOutputFrameCapacity = 0;
+            m_directOutputFrameCount = 0;
+            if (!processed) {
                 kLogger.warning()
                         << "Failed to decode FLAC file"
-                        << m_file.fileName();
+                        << getLocalFileName();
                 break; // abort
             }
             // After decoding we might first need to skip some samples if the
@@ -251,7 +274,7 @@ ReadableSampleFrames SoundSourceFLAC::readSampleFramesClamped(
                             << "Trying to adjust frame index"
                             << m_curFrameIndex << "<" << curFrameIndexBeforeProcessing
                             << "while decoding FLAC file"
-                            << m_file.fileName();
+                            << getLocalFileName();
                     const auto skipFrames =
                             IndexRange::between(m_curFrameIndex, curFrameIndexBeforeProcessing);
                     if (skipFrames != readSampleFramesClamped(WritableSampleFrames(skipFrames)).frameIndexRange()) {
@@ -259,7 +282,7 @@ ReadableSampleFrames SoundSourceFLAC::readSampleFramesClamped(
                                 << "Failed to skip sample frames"
                                 << skipFrames
                                 << "while decoding FLAC file"
-                                << m_file.fileName();
+                                << getLocalFileName();
                         break; // abort
                     }
                 } else {
@@ -267,11 +290,23 @@ ReadableSampleFrames SoundSourceFLAC::readSampleFramesClamped(
                             << "Unexpected frame index"
                             << m_curFrameIndex << ">" << curFrameIndexBeforeProcessing
                             << "while decoding FLAC file"
-                            << m_file.fileName();
+                            << getLocalFileName();
                     break; // abort
                 }
             }
             DEBUG_ASSERT(curFrameIndexBeforeProcessing == m_curFrameIndex);
+            if (directOutputFrameCount > 0) {
+                // Decoded in-place
+                const SINT numberOfSamplesDecoded =
+                        frames2samples(directOutputFrameCount);
+                DEBUG_ASSERT(numberOfSamplesDecoded <= numberOfSamplesRemaining);
+                if (writableSampleFrames.writableData()) {
+                    outputSampleOffset += numberOfSamplesDecoded;
+                }
+                m_curFrameIndex += directOutputFrameCount;
+                numberOfSamplesRemaining -= numberOfSamplesDecoded;
+                continue;
+            }
         }
         if (m_sampleBuffer.empty()) {
             break; // EOF
@@ -312,7 +347,7 @@ FLAC__StreamDecoderReadStatus SoundSourceFLAC::flacRead(FLAC__byte buffer[],
         return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
     }
 
-    const qint64 readlen = m_file.read((char*)buffer, maxlen);
+    const qint64 readlen = m_pFile->read((char*)buffer, maxlen);
 
     if (0 < readlen) {
         *bytes = readlen;
@@ -328,38 +363,38 @@ FLAC__StreamDecoderReadStatus SoundSourceFLAC::flacRead(FLAC__byte buffer[],
 }
 
 FLAC__StreamDecoderSeekStatus SoundSourceFLAC::flacSeek(FLAC__uint64 absolute_byte_offset) {
-    if (m_file.seek(absolute_byte_offset)) {
+    if (m_pFile->seek(absolute_byte_offset)) {
         return FLAC__STREAM_DECODER_SEEK_STATUS_OK;
     } else {
         kLogger.warning()
                 << "SoundSourceFLAC: An unrecoverable error occurred ("
-                << m_file.fileName() << ")";
+                << getLocalFileName() << ")";
         return FLAC__STREAM_DECODER_SEEK_STATUS_ERROR;
     }
 }
 
 FLAC__StreamDecoderTellStatus SoundSourceFLAC::flacTell(FLAC__uint64* offset) {
-    if (m_file.isSequential()) {
+    if (m_pFile->isSequential()) {
         return FLAC__STREAM_DECODER_TELL_STATUS_UNSUPPORTED;
     }
-    *offset = m_file.pos();
+    *offset = m_pFile->pos();
     return FLAC__STREAM_DECODER_TELL_STATUS_OK;
 }
 
 FLAC__StreamDecoderLengthStatus SoundSourceFLAC::flacLength(
         FLAC__uint64* length) {
-    if (m_file.isSequential()) {
+    if (m_pFile->isSequential()) {
         return FLAC__STREAM_DECODER_LENGTH_STATUS_UNSUPPORTED;
     }
-    *length = m_file.size();
+    *length = m_pFile->size();
     return FLAC__STREAM_DECODER_LENGTH_STATUS_OK;
 }
 
 FLAC__bool SoundSourceFLAC::flacEOF() {
-    if (m_file.isSequential()) {
+    if (m_pFile->isSequential()) {
         return false;
     }
-    return m_file.atEnd();
+    return m_pFile->atEnd();
 }
 
 namespace {
@@ -383,16 +418,57 @@ inline CSAMPLE convertDecodedSample(FLAC__int32 decodedSample, int bitsPerSample
     return (decodedSample << ((std::numeric_limits<FLAC__int32>::digits + 1) - bitsPerSample)) * kSampleScaleFactor;
 }
 
+// Converts and interleaves decoded samples. Mono signals are doubled
+// and multi-channel signals are stripped down to stereo if the number
+// of channels differs from the stream.
+void convertDecodedSamples(
+        CSAMPLE* pSampleBuffer,
+        const FLAC__int32* const buffer[],
+        SINT frameOffset,
+        SINT frameCount,
+        SINT channelCount,
+        SINT streamChannelCount,
+        int bitsPerSample) {
+    switch (channelCount) {
+    case 1: {
+        // optimized code for 1 channel (mono)
+        const FLAC__int32* pMono = buffer[0] + frameOffset;
+        for (SINT i = 0; i < frameCount; ++i) {
+            *pSampleBuffer++ = convertDecodedSample(pMono[i], bitsPerSample);
+        }
+        break;
+    }
+    case 2: {
+        // optimized code for 2 channels (stereo)
+        const FLAC__int32* pLeft = buffer[0] + frameOffset;
+        const FLAC__int32* pRight = buffer[(streamChannelCount > 1) ? 1 : 0] + frameOffset;
+        for (SINT i = 0; i < frameCount; ++i) {
+            *pSampleBuffer++ = convertDecodedSample(pLeft[i], bitsPerSample);
+            *pSampleBuffer++ = convertDecodedSample(pRight[i], bitsPerSample);
+        }
+        break;
+    }
+    default: {
+        // generic code for multiple channels
+        for (SINT i = frameOffset; i < frameOffset + frameCount; ++i) {
+            for (SINT j = 0; j < channelCount; ++j) {
+                *pSampleBuffer++ = convertDecodedSample(buffer[j][i], bitsPerSample);
+            }
+        }
+    }
+    }
+}
+
 } // anonymous namespace
 
 FLAC__StreamDecoderWriteStatus SoundSourceFLAC::flacWrite(
         const FLAC__Frame* frame, const FLAC__int32* const buffer[]) {
     const SINT numChannels = frame->header.channels;
-    if (channelCount() > numChannels) {
+    if (m_streamChannelCount > numChannels) {
         kLogger.warning()
                 << "Corrupt or unsupported FLAC file:"
                 << "Invalid number of channels in FLAC frame header"
-                << frame->header.channels << "<>" << channelCount();
+                << frame->header.channels << "<>" << m_streamChannelCount;
         return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
     }
     if (sampleRate() != SINT(frame->header.sample_rate)) {
@@ -414,48 +490,52 @@ FLAC__StreamDecoderWriteStatus SoundSourceFLAC::flacWrite(
     // According to the API docs the decoder will always report the current
     // position in "FLAC samples" (= "Mixxx frames") for convenience
     DEBUG_ASSERT(frame->header.number_type == FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER);
-    m_curFrameIndex = frame->header.number.sample_number;
+    const SINT blockFrameIndex = frame->header.number.sample_number;
+
+    // Decode directly into the output buffer only if the block
+    // continues at the current position
+    SINT numDirectFrames = 0;
+    if (blockFrameIndex == m_curFrameIndex) {
+        numDirectFrames = std::min(numReadableFrames, m_directOutputFrameCapacity);
+    }
+    m_curFrameIndex = blockFrameIndex;
+    if (m_pDirectOutput) {
+        convertDecodedSamples(
+                m_pDirectOutput,
+                buffer,
+                0,
+                numDirectFrames,
+                channelCount(),
+                m_streamChannelCount,
+                m_bitsPerSample);
+    }
+    m_directOutputFrameCount = numDirectFrames;
 
     // Decode buffer should be empty before decoding the next frame
     DEBUG_ASSERT(m_sampleBuffer.empty());
+    const SINT numBufferedFrames = numReadableFrames - numDirectFrames;
+    if (numBufferedFrames <= 0) {
+        return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+    }
     const SampleBuffer::WritableSlice writableSlice(
-            m_sampleBuffer.growForWriting(frames2samples(numReadableFrames)));
+            m_sampleBuffer.growForWriting(frames2samples(numBufferedFrames)));
 
     const SINT numWritableFrames = samples2frames(writableSlice.length());
-    DEBUG_ASSERT(numWritableFrames <= numReadableFrames);
-    if (numWritableFrames < numReadableFrames) {
+    DEBUG_ASSERT(numWritableFrames <= numBufferedFrames);
+    if (numWritableFrames < numBufferedFrames) {
         kLogger.warning()
                 << "Sample buffer has not enough free space for all decoded FLAC samples:"
-                << numWritableFrames << "<" << numReadableFrames;
+                << numWritableFrames << "<" << numBufferedFrames;
     }
 
-    CSAMPLE* pSampleBuffer = writableSlice.data();
-    DEBUG_ASSERT(channelCount() <= numChannels);
-    switch (channelCount()) {
-    case 1: {
-        // optimized code for 1 channel (mono)
-        for (SINT i = 0; i < numWritableFrames; ++i) {
-            *pSampleBuffer++ = convertDecodedSample(buffer[0][i], m_bitsPerSample);
-        }
-        break;
-    }
-    case 2: {
-        // optimized code for 2 channels (stereo)
-        for (SINT i = 0; i < numWritableFrames; ++i) {
-            *pSampleBuffer++ = convertDecodedSample(buffer[0][i], m_bitsPerSample);
-            *pSampleBuffer++ = convertDecodedSample(buffer[1][i], m_bitsPerSample);
-        }
-        break;
-    }
-    default: {
-        // generic code for multiple channels
-        for (SINT i = 0; i < numWritableFrames; ++i) {
-            for (SINT j = 0; j < channelCount(); ++j) {
-                *pSampleBuffer++ = convertDecodedSample(buffer[j][i], m_bitsPerSample);
-            }
-        }
-    }
-    }
+    convertDecodedSamples(
+            writableSlice.data(),
+            buffer,
+            numDirectFrames,
+            numWritableFrames,
+            channelCount(),
+            m_streamChannelCount,
+            m_bitsPerSample);
 
     return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
 }
@@ -467,7 +547,9 @@ void SoundSourceFLAC::flacMetadata(const FLAC__StreamMetadata* metadata) {
     // "...always before the first audio frame (i.e. write callback)."
     switch (metadata->type) {
     case FLAC__METADATA_TYPE_STREAMINFO: {
-        setChannelCount(metadata->data.stream_info.channels);
+        m_streamChannelCount = metadata->data.stream_info.channels;
+        setChannelCount(decodingChannelCount(
+                ChannelCount(m_streamChannelCount), m_openParams));
         setSampleRate(metadata->data.stream_info.sample_rate);
         initFrameIndexRangeOnce(
                 IndexRange::forward(
@@ -531,7 +613,7 @@ void SoundSourceFLAC::flacError(FLAC__StreamDecoderErrorStatus status) {
     }
     kLogger.warning()
             << "FLAC decoding error" << error
-            << "in file" << m_file.fileName();
+            << "in file" << getLocalFileName();
     // not much else to do here... whatever function that initiated whatever
     // decoder method resulted in this error will return an error, and the caller
     // will bail. libFLAC docs say to not close the decoder here -- bkgood
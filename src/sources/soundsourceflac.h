@@ -7,7 +7,9 @@
 
 #include <FLAC/stream_decoder.h>
 
-#include <QFile>
+#include <QIODevice>
+
+#include <memory>
 
 namespace mixxx {
 
@@ -38,7 +40,9 @@ class SoundSourceFLAC final : public SoundSource {
             OpenMode mode,
             const OpenParams& params) override;
 
-    QFile m_file;
+    std::unique_ptr<QIODevice> m_pFile;
+
+    OpenParams m_openParams;
 
     FLAC__StreamDecoder* m_decoder;
     // misc bits about the flac format:
@@ -48,6 +52,17 @@ class SoundSourceFLAC final : public SoundSource {
     // of subframes (one for each channel)
     SINT m_maxBlocksize; // in time samples (audio samples = time samples * chanCount)
     SINT m_bitsPerSample;
+    // Might differ from channelCount() if the decoded signal
+    // is up- or down-mixed to stereo
+    SINT m_streamChannelCount;
+
+    // While reading decoded samples are written directly into the
+    // output buffer as far as possible. Only the remaining samples
+    // of each block are buffered. Without an output buffer the
+    // samples are skipped without converting them.
+    CSAMPLE* m_pDirectOutput;
+    SINT m_directOutputFrameCapacity;
+    SINT m_directOutputFrameCount;
 
     ReadAheadSampleBuffer m_sampleBuffer;
 
@@ -1,5 +1,6 @@
 #include "sources/soundsourcemp3.h"
 #include "sources/mp3decoding.h"
+#include "sources/bytesource.h"
 
 #include "util/logger.h"
 #include "util/math.h"
@@ -201,6 +202,10 @@ SoundSource::OpenResult SoundSourceMp3::tryOpen(
         return OpenResult::Failed;
     }
 
+    // libmad needs the whole file in contiguous memory. The page faults
+    // of the initial scan are resolved faster when reading ahead.
+    ByteSource::adviseSequential(&m_file);
+
     // Get a pointer to the file using memory mapped IO
     m_fileSize = m_file.size();
     m_pFileData = m_file.map(0, m_fileSize);
@@ -1,7 +1,8 @@
-#include <QFile>
+#include <QIODevice>
 
 #include "sources/soundsourceoggvorbis.h"
 
+#include "sources/bytesource.h"
 #include "util/logger.h"
 
 namespace mixxx {
@@ -29,6 +30,7 @@ ov_callbacks SoundSourceOggVorbis::s_callbacks = {
 
 SoundSourceOggVorbis::SoundSourceOggVorbis(const QUrl& url)
         : SoundSource(url, "ogg"),
+          m_streamChannelCount(0),
           m_curFrameIndex(0) {
     memset(&m_vf, 0, sizeof(m_vf));
 }
@@ -39,9 +41,11 @@ SoundSourceOggVorbis::~SoundSourceOggVorbis() {
 
 SoundSource::OpenResult SoundSourceOggVorbis::tryOpen(
         OpenMode /*mode*/,
-        const OpenParams& /*config*/) {
-    m_pFile = std::make_unique<QFile>(getLocalFileName());
-    if (!m_pFile->open(QFile::ReadOnly)) {
+        const OpenParams& params) {
+    ByteSource::Options byteSourceOptions;
+    byteSourceOptions.statsKey = params.ioStatsKey();
+    m_pFile = ByteSource::open(getLocalFileName(), byteSourceOptions);
+    if (!m_pFile) {
         kLogger.warning()
                 << "Failed to open file for"
                 << getUrlString();
@@ -82,7 +86,9 @@ SoundSource::OpenResult SoundSourceOggVorbis::tryOpen(
                 << getUrlString();
         return OpenResult::Failed;
     }
-    setChannelCount(vi->channels);
+    m_streamChannelCount = vi->channels;
+    setChannelCount(decodingChannelCount(
+            ChannelCount(m_streamChannelCount), params));
     setSampleRate(vi->rate);
     if (0 < vi->bitrate_nominal) {
         initBitrateOnce(vi->bitrate_nominal / 1000);
@@ -160,12 +166,17 @@ ReadableSampleFrames SoundSourceOggVorbis::readSampleFramesClamped(
                         *pSampleBuffer++ = pcmChannels[0][i];
                     }
                     break;
-                case 2:
+                case 2: {
+                    // Mono signals are doubled and multi-channel signals
+                    // are stripped down to stereo while interleaving
+                    const float* pLeft = pcmChannels[0];
+                    const float* pRight = pcmChannels[(m_streamChannelCount > 1) ? 1 : 0];
                     for (long i = 0; i < readResult; ++i) {
-                        *pSampleBuffer++ = pcmChannels[0][i];
-                        *pSampleBuffer++ = pcmChannels[1][i];
+                        *pSampleBuffer++ = pLeft[i];
+                        *pSampleBuffer++ = pRight[i];
                     }
                     break;
+                }
                 default:
                     for (long i = 0; i < readResult; ++i) {
                         for (SINT j = 0; j < channelCount(); ++j) {
@@ -196,7 +207,7 @@ size_t SoundSourceOggVorbis::ReadCallback(void* ptr, size_t size, size_t nmemb,
     if (!size || !nmemb) {
         return 0;
     }
-    QFile* pFile = static_cast<QFile*>(datasource);
+    QIODevice* pFile = static_cast<QIODevice*>(datasource);
     if (!pFile) {
         return 0;
     }
@@ -208,7 +219,7 @@ size_t SoundSourceOggVorbis::ReadCallback(void* ptr, size_t size, size_t nmemb,
 
 //static
 int SoundSourceOggVorbis::SeekCallback(void* datasource, ogg_int64_t offset, int whence) {
-    QFile* pFile = static_cast<QFile*>(datasource);
+    QIODevice* pFile = static_cast<QIODevice*>(datasource);
     if (!pFile) {
         return 0;
     }
@@ -227,7 +238,7 @@ int SoundSourceOggVorbis::SeekCallback(void* datasource, ogg_int64_t offset, int
 
 //static
 int SoundSourceOggVorbis::CloseCallback(void* datasource) {
-    QFile* pFile = static_cast<QFile*>(datasource);
+    QIODevice* pFile = static_cast<QIODevice*>(datasource);
     if (!pFile) {
         return 0;
     }
@@ -237,7 +248,7 @@ int SoundSourceOggVorbis::CloseCallback(void* datasource) {
 
 //static
 long SoundSourceOggVorbis::TellCallback(void* datasource) {
-    QFile* pFile = static_cast<QFile*>(datasource);
+    QIODevice* pFile = static_cast<QIODevice*>(datasource);
     if (!pFile) {
         return 0;
     }
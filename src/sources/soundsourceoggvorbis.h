@@ -7,7 +7,7 @@
 #define OV_EXCLUDE_STATIC_CALLBACKS
 #include <vorbis/vorbisfile.h>
 
-class QFile;
+class QIODevice;
 
 namespace mixxx {
 
@@ -33,10 +33,14 @@ class SoundSourceOggVorbis final : public SoundSource {
     static long TellCallback(void *datasource);
     static ov_callbacks s_callbacks;
 
-    std::unique_ptr<QFile> m_pFile;
+    std::unique_ptr<QIODevice> m_pFile;
 
     OggVorbis_File m_vf;
 
+    // Might differ from channelCount() if the decoded signal
+    // is up- or down-mixed to stereo
+    SINT m_streamChannelCount;
+
     SINT m_curFrameIndex;
 };
 
@@ -217,16 +217,8 @@ SoundSource::OpenResult SoundSourceOpus::tryOpen(
     const int streamChannelCount = op_channel_count(m_pOggOpusFile, kCurrentStreamLink);
     if (0 < streamChannelCount) {
         // opusfile supports to enforce stereo decoding
-        bool enforceStereoDecoding =
-                params.channelCount().valid() &&
-                (params.channelCount() <= 2) &&
-                // preserve mono signals if stereo signal is not requested explicitly
-                ((params.channelCount() == 2) || (streamChannelCount > 2));
-        if (enforceStereoDecoding) {
-            setChannelCount(2);
-        } else {
-            setChannelCount(streamChannelCount);
-        }
+        setChannelCount(decodingChannelCount(
+                ChannelCount(streamChannelCount), params));
     } else {
         kLogger.warning()
                 << "Failed to read channel configuration of OggOpus file:"
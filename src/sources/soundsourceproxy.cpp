@@ -36,6 +36,7 @@
 #endif
 
 #include "library/coverartcache.h"
+#include "library/coverartthumbnailstore.h"
 #include "library/coverartutils.h"
 #include "track/globaltrackcache.h"
 #include "util/cmdlineargs.h"
@@ -472,6 +473,8 @@ void SoundSourceProxy::updateTrackFromSource(
             coverInfoNew.type = CoverInfo::METADATA;
             // TODO(XXX) here we may introduce a duplicate hash code
             coverInfoNew.hash = CoverArtUtils::calculateHash(coverImg);
+            CoverArtThumbnailStore::instance()->storeThumbnails(
+                    CoverInfo(coverInfoNew, m_pTrack->getLocation()), coverImg);
             if (kLogger.debugEnabled()) {
                 kLogger.debug()
                         << "Embedded cover art found in file"
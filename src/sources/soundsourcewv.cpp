@@ -3,6 +3,7 @@
 
 #include "sources/soundsourcewv.h"
 
+#include "sources/bytesource.h"
 #include "util/logger.h"
 
 namespace mixxx {
@@ -27,8 +28,6 @@ SoundSourceWV::SoundSourceWV(const QUrl& url)
         : SoundSource(url, "wv"),
           m_wpc(nullptr),
           m_sampleScaleFactor(CSAMPLE_ZERO),
-          m_pWVFile(nullptr),
-          m_pWVCFile(nullptr),
           m_curFrameIndex(0) {
 }
 
@@ -50,15 +49,19 @@ SoundSource::OpenResult SoundSourceWV::tryOpen(
     // We use WavpackOpenFileInputEx to support Unicode paths on windows
     // http://www.wavpack.com/lib_use.txt
     QString wavPackFileName = getLocalFileName();
-    m_pWVFile = new QFile(wavPackFileName);
-    m_pWVFile->open(QFile::ReadOnly);
+    ByteSource::Options byteSourceOptions;
+    byteSourceOptions.statsKey = params.ioStatsKey();
+    m_pWVFile = ByteSource::open(wavPackFileName, byteSourceOptions);
+    if (!m_pWVFile) {
+        kLogger.warning() << "failed to open file : " << wavPackFileName;
+        return OpenResult::Failed;
+    }
     QString correctionFileName(wavPackFileName + "c");
     if (QFile::exists(correctionFileName)) {
         // If there is a correction file, open it as well
-        m_pWVCFile = new QFile(correctionFileName);
-        m_pWVCFile->open(QFile::ReadOnly);
+        m_pWVCFile = ByteSource::open(correctionFileName, byteSourceOptions);
     }
-    m_wpc = WavpackOpenFileInputEx(&s_streamReader, m_pWVFile, m_pWVCFile, msg, openFlags, 0);
+    m_wpc = WavpackOpenFileInputEx(&s_streamReader, m_pWVFile.get(), m_pWVCFile.get(), msg, openFlags, 0);
     if (!m_wpc) {
         kLogger.warning() << "failed to open file : " << msg;
         return OpenResult::Failed;
@@ -99,16 +102,8 @@ void SoundSourceWV::close() {
         WavpackCloseFile(m_wpc);
         m_wpc = nullptr;
     }
-    if (m_pWVFile) {
-        m_pWVFile->close();
-        delete m_pWVFile;
-        m_pWVFile = nullptr;
-    }
-    if (m_pWVCFile) {
-        m_pWVCFile->close();
-        delete m_pWVCFile;
-        m_pWVCFile = nullptr;
-    }
+    m_pWVFile.reset();
+    m_pWVCFile.reset();
 }
 
 ReadableSampleFrames SoundSourceWV::readSampleFramesClamped(
@@ -172,7 +167,7 @@ SoundSourcePointer SoundSourceProviderWV::newSoundSource(const QUrl& url) {
 
 //static
 int32_t SoundSourceWV::ReadBytesCallback(void* id, void* data, int bcount) {
-    QFile* pFile = static_cast<QFile*>(id);
+    QIODevice* pFile = static_cast<QIODevice*>(id);
     if (!pFile) {
         return 0;
     }
@@ -181,7 +176,7 @@ int32_t SoundSourceWV::ReadBytesCallback(void* id, void* data, int bcount) {
 
 // static
 uint32_t SoundSourceWV::GetPosCallback(void* id) {
-    QFile* pFile = static_cast<QFile*>(id);
+    QIODevice* pFile = static_cast<QIODevice*>(id);
     if (!pFile) {
         return 0;
     }
@@ -190,7 +185,7 @@ uint32_t SoundSourceWV::GetPosCallback(void* id) {
 
 //static
 int SoundSourceWV::SetPosAbsCallback(void* id, unsigned int pos) {
-    QFile* pFile = static_cast<QFile*>(id);
+    QIODevice* pFile = static_cast<QIODevice*>(id);
     if (!pFile) {
         return 0;
     }
@@ -199,7 +194,7 @@ int SoundSourceWV::SetPosAbsCallback(void* id, unsigned int pos) {
 
 //static
 int SoundSourceWV::SetPosRelCallback(void* id, int delta, int mode) {
-    QFile* pFile = static_cast<QFile*>(id);
+    QIODevice* pFile = static_cast<QIODevice*>(id);
     if (!pFile) {
         return 0;
     }
@@ -218,7 +213,7 @@ int SoundSourceWV::SetPosRelCallback(void* id, int delta, int mode) {
 
 //static
 int SoundSourceWV::PushBackByteCallback(void* id, int c) {
-    QFile* pFile = static_cast<QFile*>(id);
+    QIODevice* pFile = static_cast<QIODevice*>(id);
     if (!pFile) {
         return 0;
     }
@@ -228,7 +223,7 @@ int SoundSourceWV::PushBackByteCallback(void* id, int c) {
 
 //static
 uint32_t SoundSourceWV::GetlengthCallback(void* id) {
-    QFile* pFile = static_cast<QFile*>(id);
+    QIODevice* pFile = static_cast<QIODevice*>(id);
     if (!pFile) {
         return 0;
     }
@@ -237,7 +232,7 @@ uint32_t SoundSourceWV::GetlengthCallback(void* id) {
 
 //static
 int SoundSourceWV::CanSeekCallback(void* id) {
-    QFile* pFile = static_cast<QFile*>(id);
+    QIODevice* pFile = static_cast<QIODevice*>(id);
     if (!pFile) {
         return 0;
     }
@@ -246,7 +241,7 @@ int SoundSourceWV::CanSeekCallback(void* id) {
 
 //static
 int32_t SoundSourceWV::WriteBytesCallback(void* id, void* data, int32_t bcount) {
-    QFile* pFile = static_cast<QFile*>(id);
+    QIODevice* pFile = static_cast<QIODevice*>(id);
     if (!pFile) {
         return 0;
     }
@@ -4,7 +4,7 @@
 #include "sources/soundsource.h"
 #include "sources/soundsourceprovider.h"
 
-class QFile;
+class QIODevice;
 
 typedef void WavpackContext;
 
@@ -37,8 +37,8 @@ class SoundSourceWV : public SoundSource {
 
     WavpackContext* m_wpc;
     CSAMPLE m_sampleScaleFactor;
-    QFile* m_pWVFile;
-    QFile* m_pWVCFile;
+    std::unique_ptr<QIODevice> m_pWVFile;
+    std::unique_ptr<QIODevice> m_pWVCFile;
 
     SINT m_curFrameIndex;
 };
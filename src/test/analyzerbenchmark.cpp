@@ -0,0 +1,102 @@
+// Benchmarks of the analyzers that run on every track. Run them with
+//   mixxx-test --benchmark --benchmark_filter=BM_Analyzer
+// Each iteration processes one analysis block like AnalyzerThread does. A
+// new track is started outside of the measurement when the current one is
+// complete.
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <QSqlDatabase>
+
+#include "analyzer/analyzerebur128.h"
+#include "analyzer/analyzerwaveform.h"
+#include "analyzer/constants.h"
+#include "preferences/replaygainsettings.h"
+#include "test/mixxxtest.h"
+#include "track/track.h"
+#include "util/math.h"
+
+namespace {
+
+const int kSampleRate = 44100;
+const int kTrackSeconds = 60;
+
+class AnalyzerBenchmark : public MixxxTest {
+  public:
+    AnalyzerBenchmark() {
+        ReplayGainSettings replayGainSettings(config());
+        replayGainSettings.setReplayGainAnalyzerEnabled(true);
+        replayGainSettings.setReplayGainAnalyzerVersion(2);
+    }
+
+    using MixxxTest::config;
+
+    void TestBody() override {}
+};
+
+// Music-like input with different signals on both channels
+std::vector<CSAMPLE> testBlock() {
+    std::vector<CSAMPLE> block(mixxx::kAnalysisSamplesPerBlock);
+    for (SINT i = 0; i < mixxx::kAnalysisFramesPerBlock; ++i) {
+        const double t = static_cast<double>(i) / kSampleRate;
+        block[i * 2] = static_cast<CSAMPLE>(
+                0.4 * std::sin(2 * M_PI * 110 * t) +
+                0.1 * std::sin(2 * M_PI * 3520 * t));
+        block[i * 2 + 1] = static_cast<CSAMPLE>(
+                0.4 * std::sin(2 * M_PI * 220 * t) +
+                0.1 * std::sin(2 * M_PI * 7040 * t));
+    }
+    return block;
+}
+
+bool startTrack(Analyzer* pAnalyzer) {
+    TrackPointer pTrack = Track::newTemporary();
+    pTrack->setSampleRate(kSampleRate);
+    return pAnalyzer->initialize(pTrack, kSampleRate,
+            kTrackSeconds * kSampleRate * mixxx::kAnalysisChannels);
+}
+
+void benchmarkAnalyzer(benchmark::State& state, Analyzer* pAnalyzer) {
+    const std::vector<CSAMPLE> block = testBlock();
+    const int blocksPerTrack =
+            kTrackSeconds * kSampleRate / mixxx::kAnalysisFramesPerBlock;
+    if (!startTrack(pAnalyzer)) {
+        while (state.KeepRunning()) {
+        }
+        state.SetLabel("not initialized");
+        return;
+    }
+    int blocks = 0;
+    while (state.KeepRunning()) {
+        pAnalyzer->processSamples(block.data(), mixxx::kAnalysisSamplesPerBlock);
+        if (++blocks == blocksPerTrack) {
+            state.PauseTiming();
+            pAnalyzer->cleanup();
+            startTrack(pAnalyzer);
+            blocks = 0;
+            state.ResumeTiming();
+        }
+    }
+    pAnalyzer->cleanup();
+    state.SetItemsProcessed(
+            state.iterations() * mixxx::kAnalysisFramesPerBlock);
+}
+
+static void BM_AnalyzerWaveform(benchmark::State& state) {
+    AnalyzerBenchmark test;
+    AnalyzerWaveform analyzer(test.config(), QSqlDatabase());
+    benchmarkAnalyzer(state, &analyzer);
+}
+BENCHMARK(BM_AnalyzerWaveform);
+
+static void BM_AnalyzerEbur128(benchmark::State& state) {
+    AnalyzerBenchmark test;
+    AnalyzerEbur128 analyzer(test.config());
+    benchmarkAnalyzer(state, &analyzer);
+}
+BENCHMARK(BM_AnalyzerEbur128);
+
+}  // namespace
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "test/mixxxtest.h"
+
+#include "analyzer/analyzerkey.h"
+#include "analyzer/constants.h"
+#include "util/math.h"
+
+namespace {
+
+constexpr int kSampleRate = 44100;
+constexpr int kTrackLengthSeconds = 90;
+constexpr SINT kTrackLengthSamples =
+        kTrackLengthSeconds * kSampleRate * mixxx::kAnalysisChannels;
+constexpr SINT kPreliminarySamples =
+        mixxx::kFastAnalysisSecondsToAnalyze * kSampleRate * mixxx::kAnalysisChannels;
+constexpr double kTonePitchHz = 440.0; // A
+
+bool isPreliminary(const Keys& keys) {
+    return keys.getSubVersion().contains(
+            QString(mixxx::kPreliminaryVersionKey) + "=1");
+}
+
+class AnalyzerKeyTest : public MixxxTest {
+  protected:
+    AnalyzerKeyTest()
+            : m_sampleIndex(0) {
+    }
+
+    void SetUp() override {
+        m_pTrack = Track::newTemporary();
+        m_pTrack->setSampleRate(kSampleRate);
+    }
+
+    // Processes a tone in blocks like the AnalyzerThread does
+    void processSamples(AnalyzerKey* pAnalyzer, SINT samples) {
+        std::vector<CSAMPLE> block(mixxx::kAnalysisSamplesPerBlock);
+        while (samples > 0) {
+            const SINT length = math_min(mixxx::kAnalysisSamplesPerBlock, samples);
+            for (SINT i = 0; i < length; i += 2) {
+                const double t =
+                        static_cast<double>((m_sampleIndex + i) / 2) / kSampleRate;
+                block[i] = block[i + 1] = static_cast<CSAMPLE>(
+                        0.5 * std::sin(2 * M_PI * kTonePitchHz * t));
+            }
+            ASSERT_TRUE(pAnalyzer->processSamples(block.data(), length));
+            m_sampleIndex += length;
+            samples -= length;
+        }
+    }
+
+    TrackPointer m_pTrack;
+    SINT m_sampleIndex;
+};
+
+TEST_F(AnalyzerKeyTest, StorePreliminaryKeysAfterFirstMinute) {
+    AnalyzerKey analyzer(config(), true);
+    ASSERT_TRUE(analyzer.initialize(m_pTrack, kSampleRate, kTrackLengthSamples));
+
+    processSamples(&analyzer, kPreliminarySamples);
+    analyzer.storePreliminaryResults(m_pTrack);
+    const Keys preliminaryKeys = m_pTrack->getKeys();
+    EXPECT_TRUE(preliminaryKeys.isValid());
+    EXPECT_TRUE(isPreliminary(preliminaryKeys));
+
+    processSamples(&analyzer, kTrackLengthSamples - kPreliminarySamples);
+    analyzer.storeResults(m_pTrack);
+    analyzer.cleanup();
+    const Keys keys = m_pTrack->getKeys();
+    EXPECT_TRUE(keys.isValid());
+    EXPECT_FALSE(isPreliminary(keys));
+    EXPECT_EQ(preliminaryKeys.getGlobalKey(), keys.getGlobalKey());
+}
+
+TEST_F(AnalyzerKeyTest, KeepKeyChangedWhileAnalyzing) {
+    AnalyzerKey analyzer(config(), true);
+    ASSERT_TRUE(analyzer.initialize(m_pTrack, kSampleRate, kTrackLengthSamples));
+
+    processSamples(&analyzer, kPreliminarySamples);
+    analyzer.storePreliminaryResults(m_pTrack);
+    m_pTrack->setKey(mixxx::track::io::key::F_MINOR, mixxx::track::io::key::USER);
+
+    processSamples(&analyzer, kTrackLengthSamples - kPreliminarySamples);
+    analyzer.storeResults(m_pTrack);
+    analyzer.cleanup();
+    EXPECT_EQ(mixxx::track::io::key::F_MINOR, m_pTrack->getKey());
+}
+
+TEST_F(AnalyzerKeyTest, ReanalyzePreliminaryKeys) {
+    {
+        AnalyzerKey analyzer(config(), true);
+        ASSERT_TRUE(analyzer.initialize(m_pTrack, kSampleRate, kTrackLengthSamples));
+        processSamples(&analyzer, kPreliminarySamples);
+        analyzer.storePreliminaryResults(m_pTrack);
+        // The analysis is aborted, e.g. when quitting
+        analyzer.cleanup();
+    }
+    ASSERT_TRUE(isPreliminary(m_pTrack->getKeys()));
+
+    // Even if re-analyzing is disabled in the preferences
+    KeyDetectionSettings(config()).setReanalyzeWhenSettingsChange(false);
+    AnalyzerKey analyzer(config());
+    EXPECT_TRUE(analyzer.initialize(m_pTrack, kSampleRate, kTrackLengthSamples));
+    analyzer.cleanup();
+}
+
+} // namespace
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include "library/autodj/autodjcandidateset.h"
+
+namespace {
+
+class AutoDJCandidateSetTest : public testing::Test {
+  protected:
+    QList<TrackId> availableTrackIds() const {
+        QList<TrackId> trackIds;
+        for (int rank = 0; rank < m_candidates.availableCount(); ++rank) {
+            trackIds.append(m_candidates.availableAt(rank));
+        }
+        return trackIds;
+    }
+
+    AutoDJCandidateSet m_candidates;
+};
+
+TEST_F(AutoDJCandidateSetTest, OrderByTimesPlayedThenLastPlayed) {
+    EXPECT_TRUE(m_candidates.addCrateRef(TrackId(1), 3));
+    EXPECT_TRUE(m_candidates.addCrateRef(TrackId(2), 0));
+    EXPECT_TRUE(m_candidates.addCrateRef(TrackId(3), 3));
+    EXPECT_TRUE(m_candidates.addCrateRef(TrackId(4), 1));
+    m_candidates.setLastPlayed(TrackId(1), "2017-01-02 10:00:00");
+    m_candidates.setLastPlayed(TrackId(3), "2017-01-01 10:00:00");
+    m_candidates.setLastPlayed(TrackId(4), "2017-01-03 10:00:00");
+
+    EXPECT_EQ(QList<TrackId>() << TrackId(2) << TrackId(4) << TrackId(3)
+            << TrackId(1), availableTrackIds());
+    EXPECT_EQ(4, m_candidates.availableCount());
+    EXPECT_EQ(1, m_candidates.availableUnplayedCount());
+
+    m_candidates.setTimesPlayed(TrackId(2), 5);
+    EXPECT_EQ(QList<TrackId>() << TrackId(4) << TrackId(3) << TrackId(1)
+            << TrackId(2), availableTrackIds());
+    EXPECT_EQ(0, m_candidates.availableUnplayedCount());
+}
+
+TEST_F(AutoDJCandidateSetTest, OrderByLastPlayed) {
+    m_candidates.setOrder(AutoDJCandidateSet::Order::LastPlayed);
+    m_candidates.addCrateRef(TrackId(1), 0);
+    m_candidates.addCrateRef(TrackId(2), 7);
+    m_candidates.addCrateRef(TrackId(3), 2);
+    m_candidates.setLastPlayed(TrackId(2), "2017-01-01 10:00:00");
+    m_candidates.setLastPlayed(TrackId(3), "2017-01-02 10:00:00");
+
+    // Never played sorts first
+    EXPECT_EQ(QList<TrackId>() << TrackId(1) << TrackId(2) << TrackId(3),
+            availableTrackIds());
+    EXPECT_EQ(2, m_candidates.availableLastPlayedBefore("2017-01-02 00:00:00"));
+    EXPECT_EQ(3, m_candidates.availableLastPlayedBefore("2018-01-01 00:00:00"));
+
+    m_candidates.setOrder(AutoDJCandidateSet::Order::TimesPlayedThenLastPlayed);
+    EXPECT_EQ(QList<TrackId>() << TrackId(1) << TrackId(3) << TrackId(2),
+            availableTrackIds());
+    EXPECT_EQ(1, m_candidates.availableUnplayedCount());
+}
+
+TEST_F(AutoDJCandidateSetTest, AutoDjReferences) {
+    m_candidates.addCrateRef(TrackId(1), 0);
+    m_candidates.addCrateRef(TrackId(2), 0);
+    m_candidates.addAutoDjRef(TrackId(1));
+    m_candidates.addAutoDjRef(TrackId(1));
+    // Not a candidate
+    m_candidates.addAutoDjRef(TrackId(3));
+
+    EXPECT_EQ(2, m_candidates.size());
+    EXPECT_EQ(1, m_candidates.availableCount());
+    EXPECT_EQ(1, m_candidates.queuedCount());
+    EXPECT_EQ(1, m_candidates.availableUnplayedCount());
+    EXPECT_EQ(TrackId(2), m_candidates.pickAvailable(100));
+
+    m_candidates.removeAutoDjRef(TrackId(1));
+    EXPECT_EQ(1, m_candidates.availableCount());
+    m_candidates.removeAutoDjRef(TrackId(1));
+    EXPECT_EQ(2, m_candidates.availableCount());
+    EXPECT_EQ(0, m_candidates.queuedCount());
+}
+
+TEST_F(AutoDJCandidateSetTest, CrateReferences) {
+    EXPECT_TRUE(m_candidates.addCrateRef(TrackId(1), 2));
+    EXPECT_FALSE(m_candidates.addCrateRef(TrackId(1), 2));
+    EXPECT_EQ(2, m_candidates.find(TrackId(1))->crateRefs);
+
+    m_candidates.removeCrateRef(TrackId(1));
+    EXPECT_TRUE(m_candidates.contains(TrackId(1)));
+    m_candidates.removeCrateRef(TrackId(1));
+    EXPECT_FALSE(m_candidates.contains(TrackId(1)));
+    EXPECT_EQ(nullptr, m_candidates.find(TrackId(1)));
+    EXPECT_EQ(0, m_candidates.availableCount());
+    EXPECT_FALSE(m_candidates.pickAvailable(1).isValid());
+}
+
+TEST_F(AutoDJCandidateSetTest, PickAmongActive) {
+    for (int i = 1; i <= 100; ++i) {
+        m_candidates.addCrateRef(TrackId(i), i);
+    }
+    QSet<TrackId> picked;
+    for (int i = 0; i < 1000; ++i) {
+        const TrackId trackId = m_candidates.pickAvailable(5);
+        ASSERT_TRUE(trackId.isValid());
+        EXPECT_GE(5, m_candidates.find(trackId)->timesPlayed);
+        picked.insert(trackId);
+    }
+    EXPECT_EQ(5, picked.size());
+}
+
+TEST_F(AutoDJCandidateSetTest, ManyUpdates) {
+    const int kCount = 1000;
+    for (int i = 0; i < kCount; ++i) {
+        m_candidates.addCrateRef(TrackId(i + 1), i % 10);
+    }
+    for (int i = 0; i < kCount; i += 3) {
+        m_candidates.setTimesPlayed(TrackId(i + 1), (i * 7) % 13);
+        m_candidates.addAutoDjRef(TrackId(i + 2));
+    }
+    QList<TrackId> trackIds = availableTrackIds();
+    ASSERT_EQ(m_candidates.availableCount(), trackIds.size());
+    int unplayed = 0;
+    for (int i = 0; i < trackIds.size(); ++i) {
+        const auto* pCandidate = m_candidates.find(trackIds[i]);
+        EXPECT_EQ(0, pCandidate->autoDjRefs);
+        if (pCandidate->timesPlayed == 0) {
+            ++unplayed;
+        }
+        if (i > 0) {
+            EXPECT_LE(m_candidates.find(trackIds[i - 1])->timesPlayed,
+                    pCandidate->timesPlayed);
+        }
+    }
+    EXPECT_EQ(unplayed, m_candidates.availableUnplayedCount());
+}
+
+} // namespace
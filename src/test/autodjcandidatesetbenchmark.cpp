@@ -0,0 +1,51 @@
+// Benchmarks of picking random tracks from the Auto DJ crates. Run them with
+//   mixxx-test --benchmark --benchmark_filter=BM_AutoDJ
+// The crates contain state.range_x() tracks. BM_AutoDJ_PickCandidate
+// measures the picks per second, BM_AutoDJ_UpdateCandidate the cost of
+// keeping the candidates in sync when a track is played.
+#include <benchmark/benchmark.h>
+
+#include "library/autodj/autodjcandidateset.h"
+
+namespace {
+
+void addCandidates(AutoDJCandidateSet* pCandidates, int numTracks) {
+    for (int i = 0; i < numTracks; ++i) {
+        const TrackId trackId(i + 1);
+        pCandidates->addCrateRef(trackId, i % 20);
+        if (i % 3 == 0) {
+            pCandidates->setLastPlayed(trackId,
+                    QString("2017-01-%1 10:00:00").arg(1 + i % 28, 2, 10, QChar('0')));
+        }
+    }
+}
+
+static void BM_AutoDJ_PickCandidate(benchmark::State& state) {
+    AutoDJCandidateSet candidates;
+    addCandidates(&candidates, state.range_x());
+    // The default of MinimumAvailable
+    const int activeCount = candidates.availableCount() * 20 / 100;
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(candidates.pickAvailable(activeCount));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AutoDJ_PickCandidate)->Arg(1000)->Arg(20000)->Arg(200000);
+
+static void BM_AutoDJ_UpdateCandidate(benchmark::State& state) {
+    AutoDJCandidateSet candidates;
+    addCandidates(&candidates, state.range_x());
+    int timesPlayed = 0;
+    while (state.KeepRunning()) {
+        // Queue, play and dequeue the next pick
+        const TrackId trackId = candidates.pickAvailable(
+                candidates.availableCount());
+        candidates.addAutoDjRef(trackId);
+        candidates.setTimesPlayed(trackId, ++timesPlayed % 20);
+        candidates.removeAutoDjRef(trackId);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AutoDJ_UpdateCandidate)->Arg(1000)->Arg(20000)->Arg(200000);
+
+} // namespace
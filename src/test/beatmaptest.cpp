@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <benchmark/benchmark.h>
 #include <QtDebug>
 
 #include "track/beatmap.h"
@@ -294,4 +295,102 @@ TEST_F(BeatMapTest, TestBpmAround) {
     EXPECT_DOUBLE_EQ(filebpm, pMap->getBpmAroundPosition(1 * approx_beat_length, 4));
 }
 
+TEST_F(BeatMapTest, TestDisabledBeatsAreSkipped) {
+    const double bpm = 60.0;
+    m_pTrack->setBpm(bpm);
+    m_pTrack->setSampleRate(m_iSampleRate);
+    const double beatLengthFrames = getBeatLengthFrames(bpm);
+    const double beatLengthSamples = getBeatLengthSamples(bpm);
+
+    // Beats are only disabled in serialized beat maps.
+    mixxx::track::io::BeatMap map;
+    for (int i = 0; i < 5; ++i) {
+        mixxx::track::io::Beat* pBeat = map.add_beat();
+        pBeat->set_frame_position(i * beatLengthFrames);
+        pBeat->set_enabled(i != 2);
+    }
+    std::string serialized;
+    map.SerializeToString(&serialized);
+    auto pMap = std::make_unique<BeatMap>(*m_pTrack, 0,
+            QByteArray(serialized.data(), serialized.length()));
+
+    // Between the disabled beat and the next one
+    double position = 2.5 * beatLengthSamples;
+    double foundPrevBeat, foundNextBeat;
+    EXPECT_TRUE(pMap->findPrevNextBeats(position, &foundPrevBeat, &foundNextBeat));
+    EXPECT_DOUBLE_EQ(1 * beatLengthSamples, foundPrevBeat);
+    EXPECT_DOUBLE_EQ(3 * beatLengthSamples, foundNextBeat);
+
+    // On the disabled beat
+    position = 2 * beatLengthSamples;
+    EXPECT_TRUE(pMap->findPrevNextBeats(position, &foundPrevBeat, &foundNextBeat));
+    EXPECT_DOUBLE_EQ(1 * beatLengthSamples, foundPrevBeat);
+    EXPECT_DOUBLE_EQ(3 * beatLengthSamples, foundNextBeat);
+    EXPECT_DOUBLE_EQ(3 * beatLengthSamples, pMap->findNthBeat(position, 1));
+    EXPECT_DOUBLE_EQ(1 * beatLengthSamples, pMap->findNthBeat(position, -1));
+    EXPECT_DOUBLE_EQ(4 * beatLengthSamples, pMap->findNthBeat(position, 2));
+    EXPECT_DOUBLE_EQ(-1, pMap->findNthBeat(position, 3));
+}
+
+TEST_F(BeatMapTest, TestLookupsFollowEdits) {
+    const double bpm = 60.0;
+    m_pTrack->setBpm(bpm);
+    m_pTrack->setSampleRate(m_iSampleRate);
+    const double beatLengthSamples = getBeatLengthSamples(bpm);
+    QVector<double> beats = createBeatVector(0, 10, getBeatLengthFrames(bpm));
+    auto pMap = std::make_unique<BeatMap>(*m_pTrack, 0, beats);
+    BeatsPointer pClone = pMap->clone();
+
+    const double position = 2.5 * beatLengthSamples;
+    pMap->translate(beatLengthSamples / 4);
+    EXPECT_DOUBLE_EQ(2.25 * beatLengthSamples, pMap->findPrevBeat(position));
+    EXPECT_DOUBLE_EQ(3.25 * beatLengthSamples, pMap->findNextBeat(position));
+
+    // The clone is not affected by edits of the original
+    EXPECT_DOUBLE_EQ(2 * beatLengthSamples, pClone->findPrevBeat(position));
+    EXPECT_DOUBLE_EQ(3 * beatLengthSamples, pClone->findNextBeat(position));
+}
+
+// Looks up the surrounding beats of random positions in a beat map of a
+// three hour long track at 128 bpm, like the engine does for every callback
+// of every deck that is synced or quantized.
+static void BM_BeatMapFindPrevNextBeats(benchmark::State& state) {
+    const int kSampleRate = 44100;
+    const double kBpm = 128.0;
+    const double kDurationSeconds = 3 * 60 * 60;
+    const double beatLengthFrames = 60.0 * kSampleRate / kBpm;
+
+    TrackPointer pTrack(Track::newTemporary());
+    pTrack->setSampleRate(kSampleRate);
+    QVector<double> beats;
+    for (double frame = 0; frame < kDurationSeconds * kSampleRate;
+            frame += beatLengthFrames) {
+        beats.append(frame);
+    }
+    BeatMap map(*pTrack, kSampleRate, beats);
+
+    // Precomputed pseudo random positions, so that the branch predictor and
+    // the caches can't take advantage of a regular access pattern.
+    const int kPositions = 4096;
+    std::vector<double> positions(kPositions);
+    quint32 seed = 1;
+    for (int i = 0; i < kPositions; ++i) {
+        seed = seed * 1664525 + 1013904223;
+        positions[i] = (seed / 4294967296.0) * kDurationSeconds * kSampleRate * 2;
+    }
+
+    int i = 0;
+    double prevBeat;
+    double nextBeat;
+    while (state.KeepRunning()) {
+        map.findPrevNextBeats(positions[i], &prevBeat, &nextBeat);
+        benchmark::DoNotOptimize(prevBeat);
+        benchmark::DoNotOptimize(nextBeat);
+        i = (i + 1) % kPositions;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(std::to_string(beats.size()) + " beats");
+}
+BENCHMARK(BM_BeatMapFindPrevNextBeats);
+
 }  // namespace
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <QAtomicInt>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include "sources/bytesource.h"
+#include "util/memory.h"
+
+namespace {
+
+const qint64 kFileSize = 100 * 1000 + 7;
+const qint64 kBlockSize = 4096;
+const int kBlockCount = 4;
+
+// A stand-in for a file on a slow network file system
+class ThrottledFile : public QFile {
+  public:
+    explicit ThrottledFile(const QString& fileName)
+            : QFile(fileName),
+              m_readerThread(QThread::currentThread()),
+              m_readsInReaderThread(0) {
+    }
+
+    int readsInReaderThread() const {
+        return m_readsInReaderThread.load();
+    }
+
+  protected:
+    qint64 readData(char* data, qint64 maxSize) override {
+        if (QThread::currentThread() == m_readerThread) {
+            m_readsInReaderThread.ref();
+        }
+        QThread::msleep(2);
+        return QFile::readData(data, maxSize);
+    }
+
+  private:
+    QThread* const m_readerThread;
+    QAtomicInt m_readsInReaderThread;
+};
+
+class ByteSourceTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_directory.isValid());
+        m_fileName = m_directory.path() + "/test.bin";
+        m_content.resize(kFileSize);
+        for (qint64 i = 0; i < kFileSize; ++i) {
+            m_content[static_cast<int>(i)] = static_cast<char>((i * 7) % 251);
+        }
+        QFile file(m_fileName);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        ASSERT_EQ(kFileSize, file.write(m_content));
+    }
+
+    std::unique_ptr<mixxx::ReadAheadDevice> newReadAheadDevice(ThrottledFile** ppFile) {
+        auto pFile = std::make_unique<ThrottledFile>(m_fileName);
+        EXPECT_TRUE(pFile->open(QIODevice::ReadOnly));
+        *ppFile = pFile.get();
+        return std::make_unique<mixxx::ReadAheadDevice>(
+                std::move(pFile), QString(), kBlockSize, kBlockCount);
+    }
+
+    // Reads with small odd sizes like the decoders
+    void expectContent(QIODevice* pDevice, qint64 pos, qint64 size) {
+        ASSERT_TRUE(pDevice->seek(pos));
+        QByteArray data;
+        char buffer[1000];
+        while (data.size() < size) {
+            const qint64 readSize = pDevice->read(
+                    buffer, std::min<qint64>(sizeof(buffer) - 3, size - data.size()));
+            ASSERT_LT(0, readSize);
+            data.append(buffer, readSize);
+        }
+        EXPECT_EQ(m_content.mid(pos, size), data);
+    }
+
+    QTemporaryDir m_directory;
+    QString m_fileName;
+    QByteArray m_content;
+};
+
+using mixxx::ByteSource;
+using mixxx::MappedFileDevice;
+using mixxx::ReadAheadDevice;
+
+TEST_F(ByteSourceTest, MappedFileDevice) {
+    MappedFileDevice device(m_fileName);
+    ASSERT_TRUE(device.open(QIODevice::ReadOnly));
+    EXPECT_EQ(kFileSize, device.size());
+    expectContent(&device, 0, kFileSize);
+    EXPECT_TRUE(device.atEnd());
+    expectContent(&device, 12345, 30000);
+
+    // Used by the WavPack decoder
+    char c;
+    ASSERT_TRUE(device.getChar(&c));
+    device.ungetChar(c);
+    expectContent(&device, device.pos(), 100);
+
+    EXPECT_FALSE(device.seek(kFileSize + 1));
+}
+
+TEST_F(ByteSourceTest, ReadAheadDeviceReadSequentially) {
+    ThrottledFile* pFile;
+    auto pDevice = newReadAheadDevice(&pFile);
+    ASSERT_TRUE(pDevice->open(QIODevice::ReadOnly));
+    EXPECT_EQ(kFileSize, pDevice->size());
+    expectContent(pDevice.get(), 0, kFileSize);
+    EXPECT_TRUE(pDevice->atEnd());
+    char c;
+    EXPECT_FALSE(pDevice->getChar(&c));
+    // The upstream device is only read by the worker thread
+    EXPECT_EQ(0, pFile->readsInReaderThread());
+}
+
+TEST_F(ByteSourceTest, ReadAheadDeviceSeek) {
+    ThrottledFile* pFile;
+    auto pDevice = newReadAheadDevice(&pFile);
+    ASSERT_TRUE(pDevice->open(QIODevice::ReadOnly));
+    // Across block boundaries, backwards and beyond the window
+    expectContent(pDevice.get(), kBlockSize - 10, 20);
+    expectContent(pDevice.get(), 50000, 10000);
+    expectContent(pDevice.get(), 49000, 3000);
+    expectContent(pDevice.get(), 3, 5);
+    expectContent(pDevice.get(), kFileSize - 100, 100);
+    EXPECT_EQ(0, pFile->readsInReaderThread());
+    EXPECT_FALSE(pDevice->seek(kFileSize + 1));
+}
+
+TEST_F(ByteSourceTest, ReadAheadDeviceReopen) {
+    ThrottledFile* pFile;
+    auto pDevice = newReadAheadDevice(&pFile);
+    ASSERT_TRUE(pDevice->open(QIODevice::ReadOnly));
+    expectContent(pDevice.get(), 20000, 100);
+    pDevice->close();
+    ASSERT_TRUE(pDevice->open(QIODevice::ReadOnly));
+    EXPECT_EQ(0, pDevice->pos());
+    expectContent(pDevice.get(), 0, 100);
+}
+
+TEST_F(ByteSourceTest, OpenWithAllStrategies) {
+    for (auto strategy : {
+            ByteSource::Strategy::Auto,
+            ByteSource::Strategy::Buffered,
+            ByteSource::Strategy::Mapped,
+            ByteSource::Strategy::ReadAhead}) {
+        ByteSource::Options options;
+        options.strategy = strategy;
+        const auto pDevice = ByteSource::open(m_fileName, options);
+        ASSERT_NE(nullptr, pDevice);
+        EXPECT_FALSE(pDevice->isSequential());
+        expectContent(pDevice.get(), 0, kFileSize);
+        expectContent(pDevice.get(), 777, 7777);
+    }
+}
+
+TEST_F(ByteSourceTest, OpenMissingFile) {
+    EXPECT_EQ(nullptr, ByteSource::open(m_directory.path() + "/missing.bin"));
+}
+
+} // namespace
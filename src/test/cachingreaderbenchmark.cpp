@@ -0,0 +1,209 @@
+// Benchmarks of reading track samples in the engine callback. Run them with
+//   mixxx-test --benchmark --benchmark_filter=BM_CachingReader
+//   mixxx-test --benchmark --benchmark_filter=BM_ReadAheadManager
+// The reader decodes sine-30.wav, which has more chunks than the cache can
+// hold. The misses block until the reader thread has decoded the chunk, so
+// they include the decoding and the hand-over between the threads. The
+// chunks of WAV files are decoded in parallel when multiple chunks are
+// requested at once.
+#include <benchmark/benchmark.h>
+
+#include <QDir>
+#include <QThread>
+
+#include "engine/cachingreader/cachingreader.h"
+#include "engine/controls/loopingcontrol.h"
+#include "engine/engineworkerscheduler.h"
+#include "engine/readaheadmanager.h"
+#include "test/mixxxtest.h"
+#include "track/track.h"
+#include "util/defs.h"
+#include "util/samplebuffer.h"
+
+namespace {
+
+const QString kGroup = "[Test]";
+const SINT kTrackFrames = 30 * 44100;
+
+// Loads sine-30.wav into a CachingReader that reads in blocking mode
+class CachingReaderBenchmark : public MixxxTest {
+  public:
+    CachingReaderBenchmark()
+            : m_reader(kGroup, config()) {
+        m_scheduler.start(QThread::HighPriority);
+        m_reader.setScheduler(&m_scheduler);
+        m_reader.setBlockingReads(true);
+
+        m_reader.newTrack(Track::newTemporary(
+                QDir::currentPath() + "/src/test/sine-30.wav"));
+        // Reads fail until the track has been loaded
+        mixxx::SampleBuffer buffer(2);
+        while (m_reader.read(0, 2, false, buffer.data()) ==
+                CachingReader::ReadResult::UNAVAILABLE) {
+            m_scheduler.runWorkers();
+            QThread::usleep(100);
+        }
+    }
+
+    CachingReader* reader() {
+        return &m_reader;
+    }
+
+    void TestBody() override {}
+
+  private:
+    EngineWorkerScheduler m_scheduler;
+    CachingReader m_reader;
+};
+
+// Loops between two fixed frames without any controls
+class FixedLoopControl : public LoopingControl {
+  public:
+    FixedLoopControl(SINT loopInSample, SINT loopOutSample)
+            : LoopingControl(kGroup, UserSettingsPointer()),
+              m_loopInSample(loopInSample),
+              m_loopOutSample(loopOutSample) {
+    }
+
+    double nextTrigger(bool reverse,
+                       const double currentSample,
+                       double* pTarget) override {
+        Q_UNUSED(currentSample);
+        if (m_loopOutSample <= m_loopInSample) {
+            *pTarget = kNoTrigger;
+            return kNoTrigger;
+        }
+        *pTarget = reverse ? m_loopOutSample : m_loopInSample;
+        return reverse ? m_loopInSample : m_loopOutSample;
+    }
+
+    bool getActiveLoop(double* pStartSample, double* pEndSample) const override {
+        if (m_loopOutSample <= m_loopInSample) {
+            return false;
+        }
+        *pStartSample = m_loopInSample;
+        *pEndSample = m_loopOutSample;
+        return true;
+    }
+
+    void hintReader(HintVector* pHintList) override {
+        Q_UNUSED(pHintList);
+    }
+
+    void notifySeek(double dNewPlaypos) override {
+        Q_UNUSED(dNewPlaypos);
+    }
+
+    void trackLoaded(TrackPointer pTrack) override {
+        Q_UNUSED(pTrack);
+    }
+
+  private:
+    const SINT m_loopInSample;
+    const SINT m_loopOutSample;
+};
+
+// Reads the same buffer again and again from cached chunks
+static void BM_CachingReader_ReadHit(benchmark::State& state) {
+    CachingReaderBenchmark test;
+    const SINT samples = state.range_x() * 2;
+    mixxx::SampleBuffer buffer(samples);
+    while (state.KeepRunning()) {
+        test.reader()->read(0, samples, false, buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+BENCHMARK(BM_CachingReader_ReadHit)->Arg(64)->Arg(256)->Arg(1024)->Arg(4096);
+
+// Reads from the next chunk every time. Cycling through more chunks than fit
+// into the cache evicts every chunk before it is read again.
+static void BM_CachingReader_ReadMiss(benchmark::State& state) {
+    CachingReaderBenchmark test;
+    const SINT samples = state.range_x() * 2;
+    const SINT chunks = kTrackFrames / CachingReaderChunk::kFrames;
+    mixxx::SampleBuffer buffer(samples);
+    SINT chunk = 0;
+    while (state.KeepRunning()) {
+        test.reader()->read(
+                CachingReaderChunk::frames2samples(
+                        chunk * CachingReaderChunk::kFrames),
+                samples, false, buffer.data());
+        chunk = (chunk + 1) % chunks;
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+BENCHMARK(BM_CachingReader_ReadMiss)->Arg(64)->Arg(1024);
+
+// Hints state.range_x() consecutive chunks at once like after loading a
+// track or jumping to a hotcue and waits until all of them have been read.
+static void BM_CachingReader_FillCache(benchmark::State& state) {
+    CachingReaderBenchmark test;
+    const SINT frames = state.range_x() * CachingReaderChunk::kFrames;
+    const SINT chunks = kTrackFrames / CachingReaderChunk::kFrames;
+    mixxx::SampleBuffer buffer(CachingReaderChunk::frames2samples(frames));
+    SINT chunk = 0;
+    while (state.KeepRunning()) {
+        if (chunk + state.range_x() > chunks) {
+            chunk = 0;
+        }
+        const SINT frame = chunk * CachingReaderChunk::kFrames;
+        HintVector hints;
+        Hint hint;
+        hint.frame = frame;
+        hint.frameCount = frames;
+        hint.priority = 1;
+        hints.append(hint);
+        test.reader()->hintAndMaybeWake(hints);
+        test.reader()->read(
+                CachingReaderChunk::frames2samples(frame),
+                buffer.size(), false, buffer.data());
+        chunk += state.range_x();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+BENCHMARK(BM_CachingReader_FillCache)->Arg(1)->Arg(4)->Arg(16);
+
+// Plays a loop of state.range_y() frames, or without a loop if it is 0, in
+// buffers of state.range_x() frames.
+static void BM_ReadAheadManager_GetNextSamples(benchmark::State& state) {
+    CachingReaderBenchmark test;
+    const SINT samples = state.range_x() * 2;
+    const SINT loopSamples = state.range_y() * 2;
+    // Starts in the middle of a chunk, so that the loop crosses chunks
+    const SINT loopInSample = CachingReaderChunk::kSamples / 2;
+    FixedLoopControl loopControl(loopInSample, loopInSample + loopSamples);
+    ReadAheadManager readAheadManager(test.reader(), &loopControl);
+    readAheadManager.notifySeek(loopInSample);
+
+    mixxx::SampleBuffer buffer(samples);
+    SINT samplesRead = 0;
+    while (state.KeepRunning()) {
+        SINT remaining = samples;
+        while (remaining > 0) {
+            const SINT read = readAheadManager.getNextSamples(
+                    1.0, buffer.data() + (samples - remaining), remaining);
+            if (read <= 0) {
+                break;
+            }
+            remaining -= read;
+        }
+        samplesRead += samples - remaining;
+        // Like EngineBuffer after every callback
+        HintVector hints;
+        readAheadManager.hintReader(1.0, &hints);
+        test.reader()->hintAndMaybeWake(hints);
+        if (loopSamples == 0 &&
+                readAheadManager.getPlaypos() >= kTrackFrames * 2 - samples) {
+            readAheadManager.notifySeek(0);
+        }
+    }
+    state.SetItemsProcessed(samplesRead / 2);
+}
+BENCHMARK(BM_ReadAheadManager_GetNextSamples)
+        ->ArgPair(256, 0)->ArgPair(1024, 0)
+        // 1/8 beat at 120 BPM, wraps around every few buffers
+        ->ArgPair(256, 2756)->ArgPair(1024, 2756)
+        // 4 beats at 120 BPM
+        ->ArgPair(256, 88200)->ArgPair(1024, 88200);
+
+}  // namespace
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+
+#include "util/compressedbitmap.h"
+
+namespace {
+
+using mixxx::CompressedBitmap;
+
+class CompressedBitmapTest : public testing::Test {
+  protected:
+    static std::vector<quint32> toVector(const std::set<quint32>& values) {
+        return std::vector<quint32>(values.begin(), values.end());
+    }
+
+    // Sparse and dense regions in multiple containers
+    static std::set<quint32> randomValues(std::mt19937* pRandom, int count) {
+        std::set<quint32> values;
+        std::uniform_int_distribution<quint32> sparse(0, 300000);
+        std::uniform_int_distribution<quint32> dense(70000, 80000);
+        for (int i = 0; i < count; ++i) {
+            values.insert(sparse(*pRandom));
+            values.insert(dense(*pRandom));
+        }
+        return values;
+    }
+
+    static CompressedBitmap toBitmap(const std::set<quint32>& values) {
+        CompressedBitmap bitmap;
+        for (quint32 value : values) {
+            bitmap.insert(value);
+        }
+        return bitmap;
+    }
+};
+
+TEST_F(CompressedBitmapTest, InsertRemove) {
+    CompressedBitmap bitmap;
+    EXPECT_TRUE(bitmap.isEmpty());
+    EXPECT_TRUE(bitmap.insert(5));
+    EXPECT_FALSE(bitmap.insert(5));
+    EXPECT_TRUE(bitmap.insert(0x10003));
+    EXPECT_TRUE(bitmap.insert(1));
+    EXPECT_EQ(3, bitmap.cardinality());
+    EXPECT_TRUE(bitmap.contains(5));
+    EXPECT_FALSE(bitmap.contains(6));
+    EXPECT_TRUE(bitmap.contains(0x10003));
+    EXPECT_EQ(std::vector<quint32>({1, 5, 0x10003}), bitmap.toVector());
+
+    EXPECT_TRUE(bitmap.remove(5));
+    EXPECT_FALSE(bitmap.remove(5));
+    EXPECT_TRUE(bitmap.remove(1));
+    EXPECT_TRUE(bitmap.remove(0x10003));
+    EXPECT_TRUE(bitmap.isEmpty());
+}
+
+TEST_F(CompressedBitmapTest, DenseContainer) {
+    CompressedBitmap bitmap;
+    const quint32 kCount = CompressedBitmap::kMaxArraySize * 3;
+    for (quint32 value = 0; value < kCount; ++value) {
+        bitmap.insert(value * 2);
+    }
+    EXPECT_EQ(static_cast<int>(kCount), bitmap.cardinality());
+    EXPECT_TRUE(bitmap.contains(2 * 1000));
+    EXPECT_FALSE(bitmap.contains(2 * 1000 + 1));
+    for (quint32 value = 0; value < kCount; ++value) {
+        bitmap.remove(value * 2);
+        EXPECT_EQ(static_cast<int>(kCount - value - 1), bitmap.cardinality());
+    }
+    EXPECT_TRUE(bitmap.isEmpty());
+}
+
+TEST_F(CompressedBitmapTest, FromSorted) {
+    std::mt19937 random(17);
+    const auto values = randomValues(&random, 10000);
+    std::vector<quint32> sorted = toVector(values);
+    // Duplicates are ignored
+    sorted.insert(sorted.begin() + 10, sorted[10]);
+    const auto bitmap = CompressedBitmap::fromSorted(sorted);
+    EXPECT_EQ(toVector(values), bitmap.toVector());
+    EXPECT_EQ(toBitmap(values), bitmap);
+}
+
+TEST_F(CompressedBitmapTest, SetOperations) {
+    std::mt19937 random(42);
+    for (int i = 0; i < 10; ++i) {
+        const auto lhs = randomValues(&random, 1000 * (i + 1));
+        const auto rhs = randomValues(&random, 3000);
+        const auto lhsBitmap = toBitmap(lhs);
+        const auto rhsBitmap = toBitmap(rhs);
+
+        std::set<quint32> expected;
+        auto bitmap = lhsBitmap;
+        bitmap |= rhsBitmap;
+        std::set_union(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                std::inserter(expected, expected.end()));
+        EXPECT_EQ(toVector(expected), bitmap.toVector());
+        EXPECT_EQ(toBitmap(expected), bitmap);
+
+        expected.clear();
+        bitmap = lhsBitmap;
+        bitmap &= rhsBitmap;
+        std::set_intersection(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                std::inserter(expected, expected.end()));
+        EXPECT_EQ(toVector(expected), bitmap.toVector());
+        EXPECT_EQ(toBitmap(expected), bitmap);
+
+        expected.clear();
+        bitmap = lhsBitmap;
+        bitmap -= rhsBitmap;
+        std::set_difference(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                std::inserter(expected, expected.end()));
+        EXPECT_EQ(toVector(expected), bitmap.toVector());
+        EXPECT_EQ(toBitmap(expected), bitmap);
+    }
+}
+
+TEST_F(CompressedBitmapTest, Ranges) {
+    CompressedBitmap bitmap;
+    for (quint32 value = 0xFFF0; value <= 0x10010; ++value) {
+        bitmap.insert(value);
+    }
+    bitmap.insert(3);
+    bitmap.insert(5);
+    bitmap.insert(6);
+    EXPECT_EQ(std::vector<CompressedBitmap::Range>({
+            CompressedBitmap::Range(3, 3),
+            CompressedBitmap::Range(5, 6),
+            CompressedBitmap::Range(0xFFF0, 0x10010)}),
+            bitmap.ranges());
+}
+
+} // namespace
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include "library/coverartthumbnailstore.h"
+
+namespace {
+
+const quint16 kHash = 4321;
+
+CoverInfo newCoverInfo(quint16 hash, const QString& trackLocation) {
+    CoverInfo info;
+    info.type = CoverInfo::METADATA;
+    info.hash = hash;
+    info.trackLocation = trackLocation;
+    return info;
+}
+
+const CoverInfo kInfo = newCoverInfo(kHash, "/music/track.mp3");
+
+QImage newCover(int width, int height, Qt::GlobalColor color = Qt::darkCyan) {
+    QImage cover(width, height, QImage::Format_RGB32);
+    cover.fill(color);
+    return cover;
+}
+
+class CoverArtThumbnailStoreTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_directory.isValid());
+        ASSERT_TRUE(m_store.open(m_directory.path()));
+    }
+
+    QTemporaryDir m_directory;
+    CoverArtThumbnailStore m_store;
+};
+
+TEST_F(CoverArtThumbnailStoreTest, BucketWidth) {
+    EXPECT_EQ(0, CoverArtThumbnailStore::bucketWidth(0));
+    EXPECT_EQ(64, CoverArtThumbnailStore::bucketWidth(1));
+    EXPECT_EQ(64, CoverArtThumbnailStore::bucketWidth(64));
+    EXPECT_EQ(128, CoverArtThumbnailStore::bucketWidth(65));
+    EXPECT_EQ(256, CoverArtThumbnailStore::bucketWidth(256));
+    EXPECT_EQ(0, CoverArtThumbnailStore::bucketWidth(257));
+}
+
+TEST_F(CoverArtThumbnailStoreTest, StoreAndLoadThumbnails) {
+    EXPECT_TRUE(m_store.shouldStoreThumbnails(kInfo));
+    EXPECT_TRUE(m_store.loadThumbnail(kInfo, 100).isNull());
+
+    m_store.storeThumbnails(kInfo, newCover(1000, 500));
+    EXPECT_FALSE(m_store.shouldStoreThumbnails(kInfo));
+    EXPECT_TRUE(m_store.shouldStoreThumbnails(newCoverInfo(kHash + 1, kInfo.trackLocation)));
+
+    const QImage thumbnail = m_store.loadThumbnail(kInfo, 100);
+    EXPECT_EQ(QSize(128, 64), thumbnail.size());
+    EXPECT_EQ(QColor(Qt::darkCyan).rgb(), thumbnail.pixel(10, 10));
+
+    // Full size covers are not stored
+    EXPECT_TRUE(m_store.loadThumbnail(kInfo, 0).isNull());
+    EXPECT_TRUE(m_store.loadThumbnail(kInfo, 300).isNull());
+}
+
+TEST_F(CoverArtThumbnailStoreTest, DoNotScaleUpSmallCovers) {
+    m_store.storeThumbnails(kInfo, newCover(100, 100));
+    EXPECT_EQ(QSize(64, 64), m_store.loadThumbnail(kInfo, 50).size());
+    EXPECT_EQ(QSize(100, 100), m_store.loadThumbnail(kInfo, 200).size());
+}
+
+TEST_F(CoverArtThumbnailStoreTest, KeepThumbnailsWhenReopening) {
+    m_store.storeThumbnails(kInfo, newCover(300, 300));
+    m_store.close();
+    EXPECT_FALSE(m_store.isOpen());
+    EXPECT_TRUE(m_store.loadThumbnail(kInfo, 64).isNull());
+
+    ASSERT_TRUE(m_store.open(m_directory.path()));
+    EXPECT_EQ(QSize(64, 64), m_store.loadThumbnail(kInfo, 64).size());
+    EXPECT_FALSE(m_store.shouldStoreThumbnails(kInfo));
+}
+
+TEST_F(CoverArtThumbnailStoreTest, RecreateInvalidFile) {
+    m_store.storeThumbnails(kInfo, newCover(300, 300));
+    m_store.close();
+
+    QFile file(QDir(m_directory.path()).filePath("thumbnails-64.bin"));
+    ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+    file.write("garbage");
+    file.close();
+
+    ASSERT_TRUE(m_store.open(m_directory.path()));
+    // Falls back to the next larger bucket
+    EXPECT_EQ(QSize(128, 128), m_store.loadThumbnail(kInfo, 64).size());
+    EXPECT_TRUE(m_store.shouldStoreThumbnails(kInfo));
+}
+
+TEST_F(CoverArtThumbnailStoreTest, RejectHashCollisions) {
+    const CoverInfo otherInfo = newCoverInfo(kHash, "/music/other.mp3");
+    m_store.storeThumbnails(kInfo, newCover(64, 64));
+    EXPECT_TRUE(m_store.loadThumbnail(otherInfo, 64).isNull());
+    EXPECT_TRUE(m_store.shouldStoreThumbnails(otherInfo));
+
+    m_store.storeThumbnails(otherInfo, newCover(64, 64, Qt::darkRed));
+    EXPECT_EQ(QColor(Qt::darkCyan).rgb(), m_store.loadThumbnail(kInfo, 64).pixel(10, 10));
+    EXPECT_EQ(QColor(Qt::darkRed).rgb(), m_store.loadThumbnail(otherInfo, 64).pixel(10, 10));
+}
+
+TEST_F(CoverArtThumbnailStoreTest, ShareImageDataOfSameCover) {
+    m_store.storeThumbnails(kInfo, newCover(64, 64));
+    m_store.close();
+    const QFileInfo fileInfo(QDir(m_directory.path()).filePath("thumbnails-64.bin"));
+    const qint64 fileSize = fileInfo.size();
+    ASSERT_TRUE(m_store.open(m_directory.path()));
+
+    // Another track of the same album
+    const CoverInfo otherInfo = newCoverInfo(kHash, "/music/other.mp3");
+    m_store.storeThumbnails(otherInfo, newCover(64, 64));
+    EXPECT_EQ(QSize(64, 64), m_store.loadThumbnail(otherInfo, 64).size());
+    m_store.close();
+    EXPECT_EQ(fileSize, QFileInfo(fileInfo.filePath()).size());
+}
+
+} // namespace
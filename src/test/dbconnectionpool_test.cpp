@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <QSqlQuery>
+
 #include "test/mixxxtest.h"
 
 #include "database/mixxxdb.h"
@@ -35,3 +37,38 @@ TEST_F(DbConnectionPoolTest, MoveSemantics) {
     EXPECT_TRUE(p1.isPooling());
     EXPECT_FALSE(p2.isPooling());
 }
+
+namespace {
+
+QVariant queryPragma(const QSqlDatabase& database, const QString& pragma) {
+    QSqlQuery query(database);
+    if (!query.exec("PRAGMA " + pragma) || !query.next()) {
+        return QVariant();
+    }
+    return query.value(0);
+}
+
+} // anonymous namespace
+
+TEST_F(DbConnectionPoolTest, PerformanceProfile) {
+    config()->setValue(ConfigKey("[Library]", "DbProfile"), QString("performance"));
+    const MixxxDb mixxxDb(config());
+    const mixxx::DbConnectionPooler pooler(mixxxDb.connectionPool());
+    const QSqlDatabase database = mixxx::DbConnectionPooled(mixxxDb.connectionPool());
+    EXPECT_EQ("wal", queryPragma(database, "journal_mode").toString());
+    // NORMAL
+    EXPECT_EQ(1, queryPragma(database, "synchronous").toInt());
+    // MEMORY
+    EXPECT_EQ(2, queryPragma(database, "temp_store").toInt());
+    EXPECT_EQ(-64 * 1024, queryPragma(database, "cache_size").toInt());
+}
+
+TEST_F(DbConnectionPoolTest, DefaultProfile) {
+    config()->setValue(ConfigKey("[Library]", "DbProfile"), QString("default"));
+    const MixxxDb mixxxDb(config());
+    const mixxx::DbConnectionPooler pooler(mixxxDb.connectionPool());
+    const QSqlDatabase database = mixxx::DbConnectionPooled(mixxxDb.connectionPool());
+    EXPECT_EQ("delete", queryPragma(database, "journal_mode").toString());
+    // FULL
+    EXPECT_EQ(2, queryPragma(database, "synchronous").toInt());
+}
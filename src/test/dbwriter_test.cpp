@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include "test/mixxxtest.h"
+
+#include "util/db/dbconnectionpooled.h"
+#include "util/db/dbconnectionpooler.h"
+#include "util/db/dbwriter.h"
+#include "util/memory.h"
+
+namespace {
+
+class DbWriterTest : public MixxxTest {
+  protected:
+    DbWriterTest()
+            : m_pDbConnectionPool(mixxx::DbConnectionPool::create(
+                      params(m_directory.path() + "/test.sqlite"), "TEST")),
+              m_dbConnectionPooler(m_pDbConnectionPool),
+              m_database(mixxx::DbConnectionPooled(m_pDbConnectionPool)) {
+        QSqlQuery query(m_database);
+        EXPECT_TRUE(query.exec(
+                "CREATE TABLE IF NOT EXISTS test (value INTEGER UNIQUE)"));
+        m_pDbWriter = std::make_unique<mixxx::DbWriter>(
+                m_pDbConnectionPool, "Test");
+        m_pDbWriter->start();
+    }
+
+    ~DbWriterTest() override {
+        m_pDbWriter.reset();
+    }
+
+    static mixxx::DbConnection::Params params(const QString& filePath) {
+        mixxx::DbConnection::Params params;
+        params.type = "QSQLITE";
+        params.filePath = filePath;
+        params.tuning = mixxx::DbConnection::Tuning::performance();
+        return params;
+    }
+
+    static mixxx::DbWriter::Command insertValue(int value) {
+        return [value](QSqlDatabase database) {
+            QSqlQuery query(database);
+            query.prepare("INSERT INTO test (value) VALUES (:value)");
+            query.bindValue(":value", value);
+            return query.exec();
+        };
+    }
+
+    QList<int> selectValues() const {
+        QList<int> values;
+        QSqlQuery query(m_database);
+        EXPECT_TRUE(query.exec("SELECT value FROM test ORDER BY rowid"));
+        while (query.next()) {
+            values.append(query.value(0).toInt());
+        }
+        return values;
+    }
+
+    QTemporaryDir m_directory;
+    const mixxx::DbConnectionPoolPtr m_pDbConnectionPool;
+    const mixxx::DbConnectionPooler m_dbConnectionPooler;
+    QSqlDatabase m_database;
+    std::unique_ptr<mixxx::DbWriter> m_pDbWriter;
+};
+
+TEST_F(DbWriterTest, ExecuteInOrder) {
+    QList<int> expectedValues;
+    QList<int> completedValues;
+    QThread* pCompletionThread = nullptr;
+    for (int i = 0; i < 3 * mixxx::DbWriter::kMaxBatchSize; ++i) {
+        expectedValues.append(i);
+        m_pDbWriter->enqueue(insertValue(i),
+                [i, &completedValues, &pCompletionThread](bool succeeded) {
+                    EXPECT_TRUE(succeeded);
+                    completedValues.append(i);
+                    pCompletionThread = QThread::currentThread();
+                });
+    }
+    m_pDbWriter->waitForPending();
+    EXPECT_EQ(0, m_pDbWriter->queueDepth());
+    EXPECT_EQ(expectedValues, selectValues());
+
+    m_pDbWriter->stop();
+    EXPECT_EQ(expectedValues, completedValues);
+    EXPECT_EQ(QThread::currentThread(), pCompletionThread);
+}
+
+TEST_F(DbWriterTest, RollbackFailedCommand) {
+    QList<bool> results;
+    const auto completion = [&results](bool succeeded) {
+        results.append(succeeded);
+    };
+    m_pDbWriter->enqueue(insertValue(1), completion);
+    m_pDbWriter->enqueue(
+            [](QSqlDatabase database) {
+                // Violates the unique constraint after a successful insert
+                return insertValue(2)(database) && insertValue(1)(database);
+            },
+            completion);
+    m_pDbWriter->enqueue(insertValue(3), completion);
+    m_pDbWriter->stop();
+
+    EXPECT_EQ(QList<bool>() << true << false << true, results);
+    EXPECT_EQ(QList<int>() << 1 << 3, selectValues());
+}
+
+TEST_F(DbWriterTest, CompletionInEventLoop) {
+    bool completed = false;
+    m_pDbWriter->enqueue(insertValue(1),
+            [&completed](bool succeeded) {
+                completed = succeeded;
+            });
+    for (int i = 0; i < 1000 && !completed; ++i) {
+        application()->processEvents();
+        QThread::msleep(1);
+    }
+    EXPECT_TRUE(completed);
+}
+
+TEST_F(DbWriterTest, FinishPending) {
+    bool completed = false;
+    m_pDbWriter->enqueue(insertValue(1),
+            [&completed](bool succeeded) {
+                completed = succeeded;
+            });
+    m_pDbWriter->finishPending();
+
+    EXPECT_TRUE(completed);
+    EXPECT_EQ(QList<int>() << 1, selectValues());
+}
+
+TEST_F(DbWriterTest, DestroyedContext) {
+    bool completed = false;
+    auto pContext = std::make_unique<QObject>();
+    m_pDbWriter->enqueue(insertValue(1),
+            [&completed](bool) {
+                completed = true;
+            },
+            pContext.get());
+    m_pDbWriter->waitForPending();
+    pContext.reset();
+    m_pDbWriter->stop();
+
+    EXPECT_FALSE(completed);
+    EXPECT_EQ(QList<int>() << 1, selectValues());
+}
+
+} // namespace
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "sources/decodedblockcache.h"
+
+namespace {
+
+using mixxx::DecodedBlockCache;
+
+const QString kLocation = "/music/track.flac";
+const SINT kSampleRate = 44100;
+// 2 complete blocks and a partial one at the end
+const mixxx::IndexRange kFrameIndexRange = mixxx::IndexRange::forward(
+        0, 2 * DecodedBlockCache::kBlockFrames + 100);
+
+class DecodedBlockCacheTest : public testing::Test {
+  protected:
+    DecodedBlockCache::Consumer newConsumer(
+            mixxx::IndexRange frameIndexRange = kFrameIndexRange) {
+        return DecodedBlockCache::Consumer(
+                &m_cache, kLocation, frameIndexRange, kSampleRate);
+    }
+
+    // Decodes a block with samples that are distinct for each block
+    void decodeBlock(const DecodedBlockCache::Consumer& consumer, SINT blockIndex) {
+        const auto frameIndexRange = consumer.blockFrameIndexRange(blockIndex);
+        m_samples.assign(frameIndexRange.length() * 2, CSAMPLE(blockIndex));
+        consumer.publishBlock(blockIndex, mixxx::ReadableSampleFrames(
+                frameIndexRange,
+                mixxx::SampleBuffer::ReadableSlice(
+                        m_samples.data(), m_samples.size())));
+    }
+
+    DecodedBlockCache m_cache;
+    std::vector<CSAMPLE> m_samples;
+};
+
+TEST_F(DecodedBlockCacheTest, ShareBlockWithOtherConsumer) {
+    const auto deck = newConsumer();
+    const auto analysis = newConsumer();
+    ASSERT_TRUE(deck.isValid());
+    ASSERT_TRUE(analysis.isValid());
+
+    EXPECT_FALSE(analysis.takeBlock(1));
+    decodeBlock(deck, 1);
+    EXPECT_EQ(1, m_cache.cachedBlockCount(kLocation));
+
+    const auto pBlock = analysis.takeBlock(1);
+    ASSERT_TRUE(pBlock);
+    EXPECT_EQ(deck.blockFrameIndexRange(1), pBlock->frameIndexRange());
+    const auto sampleFrames = pBlock->readableSampleFrames();
+    EXPECT_EQ(DecodedBlockCache::kBlockFrames * 2, sampleFrames.readableLength());
+    EXPECT_EQ(CSAMPLE(1), sampleFrames.readableData()[0]);
+
+    // Dropped after all other consumers have taken it
+    EXPECT_EQ(0, m_cache.cachedBlockCount(kLocation));
+    EXPECT_FALSE(analysis.takeBlock(1));
+
+    const auto stats = m_cache.stats();
+    EXPECT_EQ(1, stats.sharedBlocks);
+    EXPECT_EQ(1, stats.decodedBlocks);
+    EXPECT_EQ(0, stats.duplicatedBlocks);
+}
+
+TEST_F(DecodedBlockCacheTest, ShareLastPartialBlock) {
+    const auto deck = newConsumer();
+    const auto analysis = newConsumer();
+
+    decodeBlock(analysis, 2);
+    const auto pBlock = deck.takeBlock(2);
+    ASSERT_TRUE(pBlock);
+    EXPECT_EQ(100, pBlock->frameIndexRange().length());
+}
+
+TEST_F(DecodedBlockCacheTest, KeepFirstBlocksForLaterConsumer) {
+    const DecodedBlockCache::Consumer deck(
+            &m_cache,
+            kLocation,
+            mixxx::IndexRange::forward(0, 20 * DecodedBlockCache::kBlockFrames),
+            kSampleRate);
+    for (SINT blockIndex = 0; blockIndex < 20; ++blockIndex) {
+        decodeBlock(deck, blockIndex);
+    }
+    EXPECT_EQ(DecodedBlockCache::kMaxUnsharedBlocksPerFile,
+            m_cache.cachedBlockCount(kLocation));
+
+    const DecodedBlockCache::Consumer analysis(
+            &m_cache,
+            kLocation,
+            mixxx::IndexRange::forward(0, 20 * DecodedBlockCache::kBlockFrames),
+            kSampleRate);
+    EXPECT_TRUE(analysis.takeBlock(0));
+    EXPECT_FALSE(analysis.takeBlock(DecodedBlockCache::kMaxUnsharedBlocksPerFile));
+}
+
+TEST_F(DecodedBlockCacheTest, DoNotPublishIncompleteBlock) {
+    const auto deck = newConsumer();
+    const auto analysis = newConsumer();
+
+    // Decoding error in the middle of the block
+    std::vector<CSAMPLE> samples(100 * 2);
+    deck.publishBlock(0, mixxx::ReadableSampleFrames(
+            mixxx::IndexRange::forward(0, 100),
+            mixxx::SampleBuffer::ReadableSlice(samples.data(), samples.size())));
+    EXPECT_FALSE(analysis.takeBlock(0));
+    EXPECT_EQ(1, m_cache.stats().decodedBlocks);
+}
+
+TEST_F(DecodedBlockCacheTest, DoNotShareWithMismatchingConsumer) {
+    const auto deck = newConsumer();
+    const auto analysis = newConsumer(mixxx::IndexRange::forward(0, 100));
+    EXPECT_TRUE(deck.isValid());
+    EXPECT_FALSE(analysis.isValid());
+
+    decodeBlock(deck, 0);
+    EXPECT_FALSE(analysis.takeBlock(0));
+}
+
+TEST_F(DecodedBlockCacheTest, DropBlocksWithLastConsumer) {
+    {
+        const auto deck = newConsumer();
+        const auto analysis = newConsumer();
+        decodeBlock(deck, 0);
+        decodeBlock(deck, 1);
+        EXPECT_EQ(2, m_cache.cachedBlockCount(kLocation));
+    }
+    EXPECT_EQ(0, m_cache.cachedBlockCount(kLocation));
+
+    const auto deck = newConsumer();
+    EXPECT_FALSE(deck.takeBlock(0));
+}
+
+TEST_F(DecodedBlockCacheTest, CountDuplicatedDecoding) {
+    const auto deck = newConsumer();
+    const auto analysis = newConsumer();
+
+    decodeBlock(analysis, 0);
+    EXPECT_TRUE(deck.takeBlock(0));
+    // The block is gone after the deck has taken it
+    decodeBlock(deck, 0);
+
+    const auto stats = m_cache.stats();
+    EXPECT_EQ(1, stats.sharedBlocks);
+    EXPECT_EQ(2, stats.decodedBlocks);
+    EXPECT_EQ(1, stats.duplicatedBlocks);
+}
+
+TEST_F(DecodedBlockCacheTest, MoveConsumer) {
+    auto deck = newConsumer();
+    DecodedBlockCache::Consumer movedDeck(std::move(deck));
+    EXPECT_FALSE(deck.isValid());
+    EXPECT_TRUE(movedDeck.isValid());
+
+    const auto analysis = newConsumer();
+    decodeBlock(movedDeck, 0);
+    movedDeck = DecodedBlockCache::Consumer();
+    // The analysis is the last consumer
+    EXPECT_TRUE(analysis.takeBlock(0));
+}
+
+} // namespace
@@ -0,0 +1,376 @@
+// Headless benchmarks of the complete mixing engine. Run them with
+//   mixxx-test --benchmark --benchmark_filter=BM_Engine
+// Each iteration is one audio callback. Besides the average time per
+// callback that is reported by the benchmark library the label contains
+// the p50/p99/max callback times and the p50/p99 times of the individual
+// stages of EngineMaster::process() in microseconds.
+// BM_EngineDecks plays 2, 4 or 8 decks to show how the callback time scales
+// with the number of decks:
+//   mixxx-test --benchmark --benchmark_filter=BM_EngineDecks
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <QDir>
+#include <QTest>
+
+#include "control/controlobject.h"
+#include "effects/builtin/builtinbackend.h"
+#include "effects/effectrack.h"
+#include "effects/effectsmanager.h"
+#include "engine/channels/enginedeck.h"
+#include "engine/enginebuffer.h"
+#include "mixer/deck.h"
+#include "mixer/playermanager.h"
+#include "mixer/sampler.h"
+#include "test/mixxxtest.h"
+#include "test/signalpathtest.h"
+#include "track/track.h"
+#include "util/math.h"
+#include "util/performancetimer.h"
+#include "waveform/guitick.h"
+#include "waveform/visualsmanager.h"
+
+namespace {
+
+const int kNumDecks = 4;
+const int kNumSamplers = 4;
+const SINT kSampleRate = 44100;
+const double kTrackBpm = 120.0;
+
+// Callbacks that are processed before measuring to let ramping gains,
+// scalers and the read-ahead settle.
+const int kWarmupCallbacks = 100;
+
+// Scripted scenarios. All control changes only depend on the callback
+// index so that every run processes exactly the same sequence.
+enum class Scenario {
+    Play,
+    KeylockSoundTouch,
+    KeylockRubberBand,
+    KeylockRubberBandLookAhead,
+    Loop,
+    Scratch,
+    Sync,
+    Effects,
+};
+
+const char* scenarioName(Scenario scenario) {
+    switch (scenario) {
+    case Scenario::Play:
+        return "play";
+    case Scenario::KeylockSoundTouch:
+        return "keylock_soundtouch";
+    case Scenario::KeylockRubberBand:
+        return "keylock_rubberband";
+    case Scenario::KeylockRubberBandLookAhead:
+        return "keylock_rubberband_lookahead";
+    case Scenario::Loop:
+        return "loop";
+    case Scenario::Scratch:
+        return "scratch";
+    case Scenario::Sync:
+        return "sync";
+    case Scenario::Effects:
+        return "effects";
+    }
+    return "unknown";
+}
+
+// Returns the p-quantile of the values. Reorders the values.
+double quantile(std::vector<double>* pValues, double p) {
+    DEBUG_ASSERT(!pValues->empty());
+    const auto nth = pValues->begin() +
+            static_cast<std::size_t>(p * (pValues->size() - 1));
+    std::nth_element(pValues->begin(), nth, pValues->end());
+    return *nth;
+}
+
+// Sets up the engine with decks, samplers and effect racks like
+// MixxxMainWindow does, but without any sound devices or GUI.
+class EngineBenchmark : public MixxxTest {
+  public:
+    explicit EngineBenchmark(int numDecks = kNumDecks)
+            : m_numDecks(numDecks),
+              m_pGuiTick(std::make_unique<GuiTick>()),
+              m_pChannelHandleFactory(new ChannelHandleFactory()),
+              m_pNumDecks(new ControlObject(ConfigKey("[Master]", "num_decks"))),
+              m_pEffectsManager(new EffectsManager(nullptr, config(),
+                      m_pChannelHandleFactory)),
+              m_pVisualsManager(new VisualsManager()),
+              m_pEngineMaster(new TestEngineMaster(config(), "[Master]",
+                      m_pEffectsManager, m_pChannelHandleFactory, false)) {
+        m_pEffectsManager->addEffectsBackend(
+                new BuiltInBackend(m_pEffectsManager));
+        m_pEffectsManager->setup();
+        ControlObject::set(ConfigKey("[Master]", "samplerate"), kSampleRate);
+        ControlObject::set(ConfigKey("[Master]", "enabled"), 1.0);
+
+        for (int i = 0; i < m_numDecks; ++i) {
+            const QString group = PlayerManager::groupForDeck(i);
+            Deck* pDeck = new Deck(nullptr, config(), m_pEngineMaster,
+                    m_pEffectsManager, m_pVisualsManager,
+                    i % 2 == 0 ? EngineChannel::LEFT : EngineChannel::RIGHT,
+                    group);
+            m_pEffectsManager->getEqualizerRack(0)->setupForGroup(group);
+            pDeck->setupEqControls();
+            m_pEffectsManager->getQuickEffectRack(0)->setupForGroup(group);
+            m_pNumDecks->set(m_pNumDecks->get() + 1);
+            m_players.append(pDeck);
+        }
+        for (int i = 0; i < kNumSamplers; ++i) {
+            m_players.append(new Sampler(nullptr, config(), m_pEngineMaster,
+                    m_pEffectsManager, m_pVisualsManager,
+                    EngineChannel::CENTER, PlayerManager::groupForSampler(i)));
+        }
+
+        // Decode synchronously while loading and warming up, so that every
+        // run starts measuring with the same chunks in the caches. See
+        // endWarmup().
+        m_pEngineMaster->setBlockingReads(true);
+        m_pEngineMaster->setStageTimingEnabled(true);
+
+        TrackPointer pTrack(Track::newTemporary(
+                QDir::currentPath() + "/src/test/sine-30.wav"));
+        pTrack->setBpm(kTrackBpm);
+        for (BaseTrackPlayer* pPlayer : m_players) {
+            loadTrack(pPlayer, pTrack);
+        }
+    }
+
+    ~EngineBenchmark() override {
+        qDeleteAll(m_players);
+        // Deletes all EngineChannels added to it.
+        delete m_pEngineMaster;
+        delete m_pEffectsManager;
+        delete m_pVisualsManager;
+        delete m_pNumDecks;
+    }
+
+    void startScenario(Scenario scenario) {
+        const bool rubberBand = scenario == Scenario::KeylockRubberBand ||
+                scenario == Scenario::KeylockRubberBandLookAhead;
+        ControlObject::set(ConfigKey("[Master]", "keylock_engine"),
+                rubberBand ? EngineBuffer::RUBBERBAND : EngineBuffer::SOUNDTOUCH);
+        ControlObject::set(ConfigKey("[Master]", "keylock_lookahead"),
+                scenario == Scenario::KeylockRubberBandLookAhead ? 1.0 : 0.0);
+        for (BaseTrackPlayer* pPlayer : m_players) {
+            const QString group = pPlayer->getGroup();
+            ControlObject::set(ConfigKey(group, "repeat"), 1.0);
+            ControlObject::set(ConfigKey(group, "master"), 1.0);
+            ControlObject::set(ConfigKey(group, "play"), 1.0);
+        }
+        for (int i = 0; i < m_numDecks; ++i) {
+            const QString group = PlayerManager::groupForDeck(i);
+            // Different tempos for all decks
+            const double rate = 0.1 * (i + 1);
+            switch (scenario) {
+            case Scenario::Play:
+            case Scenario::Scratch:
+                break;
+            case Scenario::KeylockSoundTouch:
+            case Scenario::KeylockRubberBand:
+            case Scenario::KeylockRubberBandLookAhead:
+                ControlObject::set(ConfigKey(group, "keylock"), 1.0);
+                ControlObject::set(ConfigKey(group, "rate"), rate);
+                break;
+            case Scenario::Loop:
+                ControlObject::set(ConfigKey(group, "beatloop_size"), 0.25);
+                ControlObject::set(ConfigKey(group, "beatloop_activate"), 1.0);
+                break;
+            case Scenario::Sync:
+                ControlObject::set(ConfigKey(group, "rate"), rate);
+                ControlObject::set(ConfigKey(group, "sync_enabled"), 1.0);
+                break;
+            case Scenario::Effects:
+                ControlObject::set(ConfigKey(
+                        QuickEffectRack::formatEffectChainSlotGroupString(0, group),
+                        "super1"), 0.25);
+                ControlObject::set(ConfigKey(
+                        StandardEffectRack::formatEffectChainSlotGroupString(0, 0),
+                        QString("group_%1_enable").arg(group)), 1.0);
+                break;
+            }
+        }
+        if (scenario == Scenario::Effects) {
+            const QString unitGroup =
+                    StandardEffectRack::formatEffectChainSlotGroupString(0, 0);
+            ControlObject::set(ConfigKey(unitGroup, "next_chain"), 1.0);
+            ControlObject::set(ConfigKey(unitGroup, "mix"), 0.5);
+        }
+        // Start the look-ahead workers, which happens in queued slots
+        application()->processEvents();
+    }
+
+    void updateScenario(Scenario scenario, int callback) {
+        if (scenario != Scenario::Scratch) {
+            return;
+        }
+        // Scratch back and forth with a period of 64 callbacks
+        const double scratchRate = 2.0 * std::sin(2 * M_PI * callback / 64.0);
+        for (int i = 0; i < m_numDecks; ++i) {
+            const QString group = PlayerManager::groupForDeck(i);
+            ControlObject::set(ConfigKey(group, "scratch2_enable"), 1.0);
+            ControlObject::set(ConfigKey(group, "scratch2"), scratchRate);
+        }
+    }
+
+    // Disables the synchronous decoding before measuring. The caches can't
+    // hold the whole track, and decoding the missing chunks within the
+    // timed callbacks would measure the decoder instead of the engine.
+    // From now on the reader threads decode them like in a live session.
+    void endWarmup() {
+        m_pEngineMaster->setBlockingReads(false);
+    }
+
+    void process(int framesPerBuffer) {
+        m_pEngineMaster->process(framesPerBuffer * 2);
+    }
+
+    const EngineMaster::StageTimes& getLastStageTimes() const {
+        return m_pEngineMaster->getLastStageTimes();
+    }
+
+  private:
+    // Not run as a test
+    void TestBody() override {}
+
+    void loadTrack(BaseTrackPlayer* pPlayer, TrackPointer pTrack) {
+        pPlayer->slotLoadTrack(pTrack, false);
+        EngineBuffer* pEngineBuffer =
+                m_pEngineMaster->getChannel(pPlayer->getGroup())->getEngineBuffer();
+        while (!pEngineBuffer->isTrackLoaded()) {
+            process(1024);
+            QTest::qSleep(1); // millis
+        }
+    }
+
+    const int m_numDecks;
+    std::unique_ptr<GuiTick> m_pGuiTick;
+    ChannelHandleFactory* m_pChannelHandleFactory;
+    ControlObject* m_pNumDecks;
+    EffectsManager* m_pEffectsManager;
+    VisualsManager* m_pVisualsManager;
+    TestEngineMaster* m_pEngineMaster;
+    QList<BaseTrackPlayer*> m_players;
+};
+
+class CallbackStats {
+  public:
+    explicit CallbackStats(std::size_t capacity) {
+        m_total.reserve(capacity);
+        m_channels.reserve(capacity);
+        m_mixing.reserve(capacity);
+        m_outputs.reserve(capacity);
+        m_workers.reserve(capacity);
+    }
+
+    void add(mixxx::Duration total, const EngineMaster::StageTimes& stages) {
+        m_total.push_back(total.toDoubleMicros());
+        m_channels.push_back(stages.channels.toDoubleMicros());
+        m_mixing.push_back(stages.mixing.toDoubleMicros());
+        m_outputs.push_back(stages.outputs.toDoubleMicros());
+        m_workers.push_back(stages.workers.toDoubleMicros());
+    }
+
+    QString format() {
+        if (m_total.empty()) {
+            return QString();
+        }
+        return QString("p50 %1 p99 %2 max %3 | channels %4/%5 "
+                "mixing %6/%7 outputs %8/%9 workers %10/%11")
+                .arg(quantile(&m_total, 0.5), 0, 'f', 1)
+                .arg(quantile(&m_total, 0.99), 0, 'f', 1)
+                .arg(*std::max_element(m_total.begin(), m_total.end()), 0, 'f', 1)
+                .arg(quantile(&m_channels, 0.5), 0, 'f', 1)
+                .arg(quantile(&m_channels, 0.99), 0, 'f', 1)
+                .arg(quantile(&m_mixing, 0.5), 0, 'f', 1)
+                .arg(quantile(&m_mixing, 0.99), 0, 'f', 1)
+                .arg(quantile(&m_outputs, 0.5), 0, 'f', 1)
+                .arg(quantile(&m_outputs, 0.99), 0, 'f', 1)
+                .arg(quantile(&m_workers, 0.5), 0, 'f', 1)
+                .arg(quantile(&m_workers, 0.99), 0, 'f', 1);
+    }
+
+  private:
+    std::vector<double> m_total;
+    std::vector<double> m_channels;
+    std::vector<double> m_mixing;
+    std::vector<double> m_outputs;
+    std::vector<double> m_workers;
+};
+
+static void BM_EngineScenario(benchmark::State& state) {
+    const Scenario scenario = static_cast<Scenario>(state.range_x());
+    const int framesPerBuffer = state.range_y();
+
+    EngineBenchmark engine;
+    engine.startScenario(scenario);
+    int callback = 0;
+    for (; callback < kWarmupCallbacks; ++callback) {
+        engine.updateScenario(scenario, callback);
+        engine.process(framesPerBuffer);
+    }
+    engine.endWarmup();
+
+    CallbackStats stats(16384);
+    PerformanceTimer timer;
+    while (state.KeepRunning()) {
+        engine.updateScenario(scenario, callback++);
+        timer.start();
+        engine.process(framesPerBuffer);
+        stats.add(timer.elapsed(), engine.getLastStageTimes());
+    }
+
+    state.SetItemsProcessed(
+            static_cast<std::size_t>(state.iterations()) * framesPerBuffer);
+    state.SetLabel(QString("%1 %2")
+            .arg(scenarioName(scenario), stats.format()).toStdString());
+}
+
+void engineScenarioArguments(benchmark::internal::Benchmark* pBenchmark) {
+    for (int scenario = static_cast<int>(Scenario::Play);
+            scenario <= static_cast<int>(Scenario::Effects); ++scenario) {
+        for (int framesPerBuffer = 64; framesPerBuffer <= 2048;
+                framesPerBuffer *= 4) {
+            pBenchmark->ArgPair(scenario, framesPerBuffer);
+        }
+    }
+}
+BENCHMARK(BM_EngineScenario)->Apply(engineScenarioArguments);
+
+// Plays state.range_x() decks in buffers of state.range_y() frames
+static void BM_EngineDecks(benchmark::State& state) {
+    const int numDecks = state.range_x();
+    const int framesPerBuffer = state.range_y();
+
+    EngineBenchmark engine(numDecks);
+    engine.startScenario(Scenario::Play);
+    int callback = 0;
+    for (; callback < kWarmupCallbacks; ++callback) {
+        engine.updateScenario(Scenario::Play, callback);
+        engine.process(framesPerBuffer);
+    }
+    engine.endWarmup();
+
+    CallbackStats stats(16384);
+    PerformanceTimer timer;
+    while (state.KeepRunning()) {
+        engine.updateScenario(Scenario::Play, callback++);
+        timer.start();
+        engine.process(framesPerBuffer);
+        stats.add(timer.elapsed(), engine.getLastStageTimes());
+    }
+
+    state.SetItemsProcessed(
+            static_cast<std::size_t>(state.iterations()) * framesPerBuffer);
+    state.SetLabel(QString("%1 decks %2")
+            .arg(QString::number(numDecks), stats.format()).toStdString());
+}
+BENCHMARK(BM_EngineDecks)
+        ->ArgPair(2, 256)->ArgPair(4, 256)->ArgPair(8, 256)
+        ->ArgPair(2, 1024)->ArgPair(4, 1024)->ArgPair(8, 1024);
+
+}  // namespace
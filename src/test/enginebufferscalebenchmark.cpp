@@ -0,0 +1,106 @@
+// Benchmarks of the EngineBufferScale implementations. Run them with
+//   mixxx-test --benchmark --benchmark_filter=BM_EngineBufferScale
+// Each iteration scales one buffer of state.range_x() frames. The input
+// comes from memory, so only the cost of the scaler is measured.
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "engine/bufferscalers/enginebufferscalelinear.h"
+#include "engine/bufferscalers/enginebufferscalerubberband.h"
+#include "engine/bufferscalers/enginebufferscalest.h"
+#include "engine/readaheadmanager.h"
+#include "test/mixxxtest.h"
+#include "util/math.h"
+#include "util/samplebuffer.h"
+
+namespace {
+
+const SINT kSampleRate = 44100;
+
+// Reads a looped sine from memory instead of a track
+class SineReadAheadManager : public ReadAheadManager {
+  public:
+    SineReadAheadManager()
+            : m_sine(kSampleRate * 2),
+              m_position(0) {
+        // One second of a 441 Hz sine loops seamlessly
+        for (SINT i = 0; i < kSampleRate; ++i) {
+            const CSAMPLE value = static_cast<CSAMPLE>(
+                    0.5 * std::sin(2 * M_PI * 441.0 * i / kSampleRate));
+            m_sine[i * 2] = value;
+            m_sine[i * 2 + 1] = value;
+        }
+    }
+
+    SINT getNextSamples(double dRate, CSAMPLE* buffer,
+            SINT requested_samples) override {
+        Q_UNUSED(dRate);
+        const SINT size = static_cast<SINT>(m_sine.size());
+        for (SINT i = 0; i < requested_samples; ++i) {
+            buffer[i] = m_sine[m_position];
+            m_position = (m_position + 1) % size;
+        }
+        return requested_samples;
+    }
+
+  private:
+    std::vector<CSAMPLE> m_sine;
+    SINT m_position;
+};
+
+class EngineBufferScaleBenchmark : public MixxxTest {
+  public:
+    void TestBody() override {}
+};
+
+template<class Scaler>
+void benchmarkScaler(benchmark::State& state, double tempoRatio,
+        double pitchRatio) {
+    EngineBufferScaleBenchmark test;
+    SineReadAheadManager readAheadManager;
+    Scaler scaler(&readAheadManager);
+    scaler.setSampleRate(kSampleRate);
+    // Twice, to skip the ramping of the linear scaler
+    for (int i = 0; i < 2; ++i) {
+        double tempo = tempoRatio;
+        double pitch = pitchRatio;
+        scaler.setScaleParameters(1.0, &tempo, &pitch);
+    }
+
+    const SINT samples = state.range_x() * 2;
+    mixxx::SampleBuffer output(samples);
+    // Fill the internal buffers of the scaler before measuring
+    for (int i = 0; i < 16; ++i) {
+        scaler.scaleBuffer(output.data(), samples);
+    }
+    while (state.KeepRunning()) {
+        scaler.scaleBuffer(output.data(), samples);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+#define FOR_SCALER_BUFFER_SIZES(bm) bm->Arg(64)->Arg(256)->Arg(1024)->Arg(4096);
+
+// Vinyl emulation: the tempo and the pitch change together
+static void BM_EngineBufferScale_Linear(benchmark::State& state) {
+    benchmarkScaler<EngineBufferScaleLinear>(state, 1.06, 1.06);
+}
+FOR_SCALER_BUFFER_SIZES(BENCHMARK(BM_EngineBufferScale_Linear));
+
+// Keylock: the tempo changes, the pitch is kept
+static void BM_EngineBufferScale_SoundTouch(benchmark::State& state) {
+    benchmarkScaler<EngineBufferScaleST>(state, 1.06, 1.0);
+}
+FOR_SCALER_BUFFER_SIZES(BENCHMARK(BM_EngineBufferScale_SoundTouch));
+
+// Stretches in the callback, without the look-ahead worker
+static void BM_EngineBufferScale_RubberBand(benchmark::State& state) {
+    benchmarkScaler<EngineBufferScaleRubberBand>(state, 1.06, 1.0);
+}
+FOR_SCALER_BUFFER_SIZES(BENCHMARK(BM_EngineBufferScale_RubberBand));
+
+}  // namespace
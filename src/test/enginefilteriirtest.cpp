@@ -0,0 +1,213 @@
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "engine/filters/enginefilterbessel4.h"
+#include "engine/filters/enginefilterbessel8.h"
+#include "engine/filters/enginefilterbiquad1.h"
+#include "engine/filters/enginefilterlinkwitzriley8.h"
+
+namespace {
+
+const int kSampleRate = 44100;
+
+// Filters the channels one after the other, like EngineFilterIIR did before
+// it processed both channels of a frame at once. Serves as the reference
+// for the tests and the "before" case of the benchmarks. Ramping is not
+// supported, so the filter must have settled.
+template<class Filter, unsigned int SIZE>
+class PerChannelFilter : public Filter {
+  public:
+    template<typename... Args>
+    explicit PerChannelFilter(Args... args)
+            : Filter(args...) {
+        memset(m_buf1, 0, sizeof(m_buf1));
+        memset(m_buf2, 0, sizeof(m_buf2));
+        Filter::assumeSettled();
+    }
+
+    void processPerChannel(const CSAMPLE* pIn, CSAMPLE* pOutput,
+            const int iBufferSize) {
+        for (int i = 0; i < iBufferSize; i += 2) {
+            pOutput[i] = static_cast<CSAMPLE>(
+                    this->processSample(this->m_coef, m_buf1,
+                            static_cast<double>(pIn[i])));
+            pOutput[i + 1] = static_cast<CSAMPLE>(
+                    this->processSample(this->m_coef, m_buf2,
+                            static_cast<double>(pIn[i + 1])));
+        }
+    }
+
+  private:
+    double m_buf1[SIZE];
+    double m_buf2[SIZE];
+};
+
+typedef PerChannelFilter<EngineFilterBessel4Low, 4> Bessel4Low;
+typedef PerChannelFilter<EngineFilterBessel8Low, 8> Bessel8Low;
+typedef PerChannelFilter<EngineFilterBessel8Band, 16> Bessel8Band;
+typedef PerChannelFilter<EngineFilterLinkwitzRiley8Low, 8> LinkwitzRiley8Low;
+typedef PerChannelFilter<EngineFilterLinkwitzRiley8High, 8> LinkwitzRiley8High;
+typedef PerChannelFilter<EngineFilterBiquad1Peaking, 5> Biquad1Peaking;
+
+// Different signals on the left and right channel
+std::vector<CSAMPLE> testSignal(int samples) {
+    std::vector<CSAMPLE> signal(samples);
+    for (int i = 0; i < samples; i += 2) {
+        signal[i] = static_cast<CSAMPLE>(((i * 37) % 101) / 101.0 - 0.5);
+        signal[i + 1] = static_cast<CSAMPLE>(((i * 53) % 89) / 89.0 - 0.5);
+    }
+    return signal;
+}
+
+template<class Filter>
+void assertStereoMatchesPerChannel(Filter* pStereo, Filter* pPerChannel) {
+    const int kBufferSize = 1024;
+    const std::vector<CSAMPLE> input = testSignal(kBufferSize);
+    std::vector<CSAMPLE> stereo(kBufferSize);
+    std::vector<CSAMPLE> perChannel(kBufferSize);
+    // Several buffers to check that the state is carried over
+    for (int buffer = 0; buffer < 4; ++buffer) {
+        pStereo->process(input.data(), stereo.data(), kBufferSize);
+        pPerChannel->processPerChannel(input.data(), perChannel.data(),
+                kBufferSize);
+        for (int i = 0; i < kBufferSize; ++i) {
+            ASSERT_NEAR(perChannel[i], stereo[i], 1e-6) << "sample " << i;
+        }
+    }
+}
+
+class EngineFilterIIRTest : public testing::Test {
+};
+
+TEST_F(EngineFilterIIRTest, StereoMatchesPerChannel) {
+    {
+        Bessel4Low stereo(kSampleRate, 250), perChannel(kSampleRate, 250);
+        assertStereoMatchesPerChannel(&stereo, &perChannel);
+    }
+    {
+        Bessel8Low stereo(kSampleRate, 250), perChannel(kSampleRate, 250);
+        assertStereoMatchesPerChannel(&stereo, &perChannel);
+    }
+    {
+        Bessel8Band stereo(kSampleRate, 250, 2500);
+        Bessel8Band perChannel(kSampleRate, 250, 2500);
+        assertStereoMatchesPerChannel(&stereo, &perChannel);
+    }
+    {
+        LinkwitzRiley8Low stereo(kSampleRate, 250);
+        LinkwitzRiley8Low perChannel(kSampleRate, 250);
+        assertStereoMatchesPerChannel(&stereo, &perChannel);
+    }
+    {
+        LinkwitzRiley8High stereo(kSampleRate, 2500);
+        LinkwitzRiley8High perChannel(kSampleRate, 2500);
+        assertStereoMatchesPerChannel(&stereo, &perChannel);
+    }
+    {
+        Biquad1Peaking stereo(kSampleRate, 1000, 1.75);
+        Biquad1Peaking perChannel(kSampleRate, 1000, 1.75);
+        assertStereoMatchesPerChannel(&stereo, &perChannel);
+    }
+}
+
+TEST_F(EngineFilterIIRTest, RampingFromDryMatchesPerChannelAfterRamp) {
+    // After the ramp the output only depends on the new filter state,
+    // which has been processed the same way in both cases.
+    const int kBufferSize = 1024;
+    const std::vector<CSAMPLE> input = testSignal(kBufferSize);
+    std::vector<CSAMPLE> stereo(kBufferSize);
+    std::vector<CSAMPLE> perChannel(kBufferSize);
+
+    Bessel8Low stereoFilter(kSampleRate, 250);
+    stereoFilter.setStartFromDry(true);
+    stereoFilter.pauseFilter();
+    stereoFilter.process(input.data(), stereo.data(), kBufferSize);
+    // Fades to the filtered signal and stays within the input range
+    for (int i = 0; i < kBufferSize; ++i) {
+        ASSERT_LE(std::abs(stereo[i]), 1.0f) << "sample " << i;
+    }
+
+    Bessel8Low perChannelFilter(kSampleRate, 250);
+    perChannelFilter.processPerChannel(input.data(), perChannel.data(),
+            kBufferSize);
+    stereoFilter.process(input.data(), stereo.data(), kBufferSize);
+    perChannelFilter.processPerChannel(input.data(), perChannel.data(),
+            kBufferSize);
+    for (int i = 0; i < kBufferSize; ++i) {
+        ASSERT_NEAR(perChannel[i], stereo[i], 1e-6) << "sample " << i;
+    }
+}
+
+// Run with
+//   mixxx-test --benchmark --benchmark_filter=BM_EngineFilterIIR
+// The PerChannel variants show the cost before both channels were
+// processed at once.
+template<class Filter, bool kPerChannel>
+void benchmarkFilter(benchmark::State& state, Filter* pFilter) {
+    const int kBufferSize = state.range_x();
+    const std::vector<CSAMPLE> input = testSignal(kBufferSize);
+    std::vector<CSAMPLE> output(kBufferSize);
+    while (state.KeepRunning()) {
+        if (kPerChannel) {
+            pFilter->processPerChannel(input.data(), output.data(),
+                    kBufferSize);
+        } else {
+            pFilter->process(input.data(), output.data(), kBufferSize);
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * kBufferSize / 2);
+}
+
+static void BM_EngineFilterIIR_Bessel8Low_PerChannel(benchmark::State& state) {
+    Bessel8Low filter(kSampleRate, 250);
+    benchmarkFilter<Bessel8Low, true>(state, &filter);
+}
+BENCHMARK(BM_EngineFilterIIR_Bessel8Low_PerChannel)->Range(64, 4096);
+
+static void BM_EngineFilterIIR_Bessel8Low_Stereo(benchmark::State& state) {
+    Bessel8Low filter(kSampleRate, 250);
+    benchmarkFilter<Bessel8Low, false>(state, &filter);
+}
+BENCHMARK(BM_EngineFilterIIR_Bessel8Low_Stereo)->Range(64, 4096);
+
+static void BM_EngineFilterIIR_Bessel8Band_PerChannel(benchmark::State& state) {
+    Bessel8Band filter(kSampleRate, 250, 2500);
+    benchmarkFilter<Bessel8Band, true>(state, &filter);
+}
+BENCHMARK(BM_EngineFilterIIR_Bessel8Band_PerChannel)->Range(64, 4096);
+
+static void BM_EngineFilterIIR_Bessel8Band_Stereo(benchmark::State& state) {
+    Bessel8Band filter(kSampleRate, 250, 2500);
+    benchmarkFilter<Bessel8Band, false>(state, &filter);
+}
+BENCHMARK(BM_EngineFilterIIR_Bessel8Band_Stereo)->Range(64, 4096);
+
+static void BM_EngineFilterIIR_LinkwitzRiley8Low_PerChannel(benchmark::State& state) {
+    LinkwitzRiley8Low filter(kSampleRate, 250);
+    benchmarkFilter<LinkwitzRiley8Low, true>(state, &filter);
+}
+BENCHMARK(BM_EngineFilterIIR_LinkwitzRiley8Low_PerChannel)->Range(64, 4096);
+
+static void BM_EngineFilterIIR_LinkwitzRiley8Low_Stereo(benchmark::State& state) {
+    LinkwitzRiley8Low filter(kSampleRate, 250);
+    benchmarkFilter<LinkwitzRiley8Low, false>(state, &filter);
+}
+BENCHMARK(BM_EngineFilterIIR_LinkwitzRiley8Low_Stereo)->Range(64, 4096);
+
+static void BM_EngineFilterIIR_Biquad1Peaking_PerChannel(benchmark::State& state) {
+    Biquad1Peaking filter(kSampleRate, 1000, 1.75);
+    benchmarkFilter<Biquad1Peaking, true>(state, &filter);
+}
+BENCHMARK(BM_EngineFilterIIR_Biquad1Peaking_PerChannel)->Range(64, 4096);
+
+static void BM_EngineFilterIIR_Biquad1Peaking_Stereo(benchmark::State& state) {
+    Biquad1Peaking filter(kSampleRate, 1000, 1.75);
+    benchmarkFilter<Biquad1Peaking, false>(state, &filter);
+}
+BENCHMARK(BM_EngineFilterIIR_Biquad1Peaking_Stereo)->Range(64, 4096);
+
+}  // namespace
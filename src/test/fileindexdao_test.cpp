@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <QtSql>
+#include <QTemporaryFile>
+
+#include "library/dao/fileindexdao.h"
+#include "library/scanner/fileidentity.h"
+
+#include "test/librarytest.h"
+
+namespace {
+
+class FileIndexDAOTest : public LibraryTest {
+  protected:
+    void SetUp() override {
+        m_fileIndexDao.initialize(dbConnection());
+    }
+
+    void TearDown() override {
+        QSqlQuery query(dbConnection());
+        query.exec("DELETE FROM track_file_index");
+        query.exec("DELETE FROM track_locations");
+    }
+
+    void addTrackLocation(const QString& location, bool deleted) {
+        QSqlQuery query(dbConnection());
+        query.prepare("INSERT INTO track_locations (location, fs_deleted) "
+                      "VALUES (:location, :fs_deleted)");
+        query.bindValue(":location", location);
+        query.bindValue(":fs_deleted", deleted ? 1 : 0);
+        ASSERT_TRUE(query.exec());
+    }
+
+    FileIndexDAO m_fileIndexDao;
+};
+
+TEST_F(FileIndexDAOTest, FileIdentityDetectsModifications) {
+    QTemporaryFile file;
+    ASSERT_TRUE(file.open());
+    file.write("abc");
+    file.flush();
+
+    const FileIdentity before = FileIdentity::fromFileInfo(QFileInfo(file.fileName()));
+    ASSERT_TRUE(before.isValid());
+    EXPECT_EQ(3, before.fileSize());
+    EXPECT_EQ(before, FileIdentity::fromFileInfo(QFileInfo(file.fileName())));
+
+    file.write("def");
+    file.flush();
+
+    const FileIdentity after = FileIdentity::fromFileInfo(QFileInfo(file.fileName()));
+    ASSERT_TRUE(after.isValid());
+    EXPECT_NE(before, after);
+    EXPECT_EQ(before.inode(), after.inode());
+
+    EXPECT_FALSE(FileIdentity::fromFileInfo(
+            QFileInfo(file.fileName() + ".missing")).isValid());
+}
+
+TEST_F(FileIndexDAOTest, SaveAndRemoveStale) {
+    FileIdentityIndex fileIdentities;
+    fileIdentities.insert("/music/a.mp3", FileIdentity(1000, 1500000000000LL, 42));
+    fileIdentities.insert("/music/b.mp3", FileIdentity(2000, 1500000000001LL, 43));
+    fileIdentities.insert("/music/c.mp3", FileIdentity(3000, 1500000000002LL, 44));
+    m_fileIndexDao.saveFileIdentities(fileIdentities);
+    EXPECT_EQ(fileIdentities, m_fileIndexDao.getFileIdentities());
+
+    // Replace an existing entry
+    fileIdentities.insert("/music/a.mp3", FileIdentity(1001, 1500000000003LL, 42));
+    m_fileIndexDao.saveFileIdentities(fileIdentities);
+    EXPECT_EQ(fileIdentities, m_fileIndexDao.getFileIdentities());
+
+    addTrackLocation("/music/a.mp3", false);
+    addTrackLocation("/music/b.mp3", true);
+    m_fileIndexDao.removeStaleFileIdentities();
+
+    const FileIdentityIndex remaining = m_fileIndexDao.getFileIdentities();
+    EXPECT_EQ(1, remaining.size());
+    EXPECT_EQ(fileIdentities.value("/music/a.mp3"), remaining.value("/music/a.mp3"));
+}
+
+} // anonymous namespace
@@ -0,0 +1,207 @@
+// Benchmarks of searching and sorting the library. Run them with
+//   mixxx-test --benchmark --benchmark_filter=BM_Library
+// The library is an in-memory database with state.range_x() generated
+// tracks. BM_Library_FilterAndSort measures what the library table does for
+// every keystroke in the search box, BM_Library_ParseQuery only the parsing
+// of the search query.
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include <QSqlQuery>
+#include <QStringList>
+
+#include "library/basetrackcache.h"
+#include "library/dao/trackschema.h"
+#include "library/queryutil.h"
+#include "library/searchqueryparser.h"
+#include "test/librarytest.h"
+#include "util/db/sqltransaction.h"
+
+namespace {
+
+const QString kTableName = "benchmark_library_view";
+
+const char* kQueries[] = {
+        "",
+        "title",
+        "artist:\"Artist 42\"",
+        "bpm:120-130",
+        "genre:techno -title 1",
+};
+
+const char* kGenres[] = {
+        "Techno",
+        "House",
+        "Drum & Bass",
+        "Hip Hop",
+        "Ambient",
+};
+
+// The JSON output of the benchmark library does not escape the labels
+std::string queryLabel(const QString& searchQuery) {
+    return QString("[%1]").arg(searchQuery).replace('"', '\'').toStdString();
+}
+
+class LibraryBenchmark : public LibraryTest {
+  public:
+    explicit LibraryBenchmark(int numTracks) {
+        addTracks(numTracks);
+
+        QStringList columns;
+        columns << LIBRARYTABLE_ID
+                << LIBRARYTABLE_ARTIST
+                << LIBRARYTABLE_TITLE
+                << LIBRARYTABLE_ALBUM
+                << LIBRARYTABLE_ALBUMARTIST
+                << LIBRARYTABLE_GENRE
+                << LIBRARYTABLE_GROUPING
+                << LIBRARYTABLE_COMMENT
+                << LIBRARYTABLE_YEAR
+                << LIBRARYTABLE_BPM
+                << LIBRARYTABLE_DURATION
+                << LIBRARYTABLE_MIXXXDELETED;
+        QStringList viewColumns;
+        for (const auto& column : columns) {
+            viewColumns << "library." + column;
+        }
+        viewColumns << "track_locations.location";
+        columns << "location";
+
+        // Like MixxxLibraryFeature
+        QSqlQuery query(dbConnection());
+        query.prepare(QString(
+                "CREATE TEMPORARY VIEW IF NOT EXISTS %1 AS "
+                "SELECT %2 FROM library "
+                "INNER JOIN track_locations ON library.location = track_locations.id")
+                .arg(kTableName, viewColumns.join(",")));
+        if (!query.exec()) {
+            LOG_FAILED_QUERY(query);
+        }
+        m_pTrackCache = std::make_unique<BaseTrackCache>(
+                collection(), kTableName, LIBRARYTABLE_ID, columns, true);
+        m_pTrackCache->buildIndex();
+
+        QSqlQuery idQuery(dbConnection());
+        idQuery.prepare("SELECT id FROM library");
+        if (!idQuery.exec()) {
+            LOG_FAILED_QUERY(idQuery);
+        }
+        while (idQuery.next()) {
+            m_trackIds.insert(TrackId(idQuery.value(0)));
+        }
+    }
+
+    BaseTrackCache* trackCache() {
+        return m_pTrackCache.get();
+    }
+
+    const QSet<TrackId>& trackIds() const {
+        return m_trackIds;
+    }
+
+    SearchQueryParser* queryParser() {
+        if (!m_pQueryParser) {
+            m_pQueryParser = std::make_unique<SearchQueryParser>(collection());
+        }
+        return m_pQueryParser.get();
+    }
+
+    void TestBody() override {}
+
+  private:
+    void addTracks(int numTracks) {
+        SqlTransaction transaction(dbConnection());
+        QSqlQuery locationQuery(dbConnection());
+        locationQuery.prepare(
+                "INSERT INTO track_locations "
+                "(location, filename, directory, filesize, fs_deleted, "
+                "needs_verification) "
+                "VALUES (:location, :filename, '/music', 0, 0, 0)");
+        QSqlQuery trackQuery(dbConnection());
+        trackQuery.prepare(
+                "INSERT INTO library "
+                "(artist, title, album, album_artist, genre, grouping, "
+                "comment, year, bpm, duration, location, mixxx_deleted) "
+                "VALUES (:artist, :title, :album, :artist, :genre, '', "
+                ":comment, :year, :bpm, :duration, :location, 0)");
+        for (int i = 0; i < numTracks; ++i) {
+            const QString fileName = QString("track%1.mp3").arg(i);
+            locationQuery.bindValue(":location", "/music/" + fileName);
+            locationQuery.bindValue(":filename", fileName);
+            if (!locationQuery.exec()) {
+                LOG_FAILED_QUERY(locationQuery);
+                return;
+            }
+            trackQuery.bindValue(":artist", QString("Artist %1").arg(i % 500));
+            trackQuery.bindValue(":title", QString("Title %1").arg(i));
+            trackQuery.bindValue(":album", QString("Album %1").arg(i % 2000));
+            trackQuery.bindValue(":genre",
+                    kGenres[i % (sizeof(kGenres) / sizeof(kGenres[0]))]);
+            trackQuery.bindValue(":comment", QString("Comment %1").arg(i % 7));
+            trackQuery.bindValue(":year", QString::number(1970 + i % 50));
+            trackQuery.bindValue(":bpm", 80.0 + i % 80);
+            trackQuery.bindValue(":duration", 120.0 + i % 300);
+            trackQuery.bindValue(":location", locationQuery.lastInsertId());
+            if (!trackQuery.exec()) {
+                LOG_FAILED_QUERY(trackQuery);
+                return;
+            }
+        }
+        transaction.commit();
+    }
+
+    std::unique_ptr<BaseTrackCache> m_pTrackCache;
+    std::unique_ptr<SearchQueryParser> m_pQueryParser;
+    QSet<TrackId> m_trackIds;
+};
+
+static void BM_Library_FilterAndSort(benchmark::State& state) {
+    LibraryBenchmark library(state.range_x());
+    const QString searchQuery = kQueries[state.range_y()];
+    const QString extraFilter = LIBRARYTABLE_MIXXXDELETED + "=0";
+    const QString orderBy = "ORDER BY " + LIBRARYTABLE_ARTIST;
+    const QList<SortColumn> sortColumns;
+    QHash<TrackId, int> trackToIndex;
+    while (state.KeepRunning()) {
+        library.trackCache()->filterAndSort(library.trackIds(), searchQuery,
+                extraFilter, orderBy, sortColumns, 0, &trackToIndex);
+    }
+    state.SetItemsProcessed(state.iterations() * library.trackIds().size());
+    state.SetLabel(queryLabel(searchQuery) +
+            QString(" %1 matches").arg(trackToIndex.size()).toStdString());
+}
+
+static void BM_Library_ParseQuery(benchmark::State& state) {
+    LibraryBenchmark library(0);
+    const QString searchQuery = kQueries[state.range_x()];
+    QStringList searchColumns;
+    searchColumns << "artist" << "album" << "album_artist" << "location"
+                  << "grouping" << "comment" << "title" << "genre" << "crate";
+    SearchQueryParser* pParser = library.queryParser();
+    while (state.KeepRunning()) {
+        auto pQuery = pParser->parseQuery(searchQuery, searchColumns, "");
+        benchmark::DoNotOptimize(pQuery.get());
+    }
+    state.SetLabel(queryLabel(searchQuery));
+}
+
+void filterAndSortArguments(benchmark::internal::Benchmark* pBenchmark) {
+    const int queries = sizeof(kQueries) / sizeof(kQueries[0]);
+    for (int numTracks = 1000; numTracks <= 100000; numTracks *= 10) {
+        for (int query = 0; query < queries; ++query) {
+            pBenchmark->ArgPair(numTracks, query);
+        }
+    }
+}
+BENCHMARK(BM_Library_FilterAndSort)->Apply(filterAndSortArguments);
+
+void parseQueryArguments(benchmark::internal::Benchmark* pBenchmark) {
+    const int queries = sizeof(kQueries) / sizeof(kQueries[0]);
+    for (int query = 0; query < queries; ++query) {
+        pBenchmark->Arg(query);
+    }
+}
+BENCHMARK(BM_Library_ParseQuery)->Apply(parseQueryArguments);
+
+}  // namespace
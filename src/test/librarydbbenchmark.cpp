@@ -0,0 +1,198 @@
+// Benchmarks of the SQLite tuning profiles of the library database. Run
+// them with
+//   mixxx-test --benchmark --benchmark_filter=BM_LibraryDb
+// Every iteration replays a workload on a database file with
+// state.range_x() tracks: the library scanner adds a directory of tracks
+// in one transaction, the analysis results of some tracks are saved with
+// a commit each, and the library view is browsed.
+#include <benchmark/benchmark.h>
+
+#include <QSqlQuery>
+#include <QTemporaryDir>
+
+#include "database/mixxxdb.h"
+#include "library/queryutil.h"
+#include "util/db/dbconnectionpooled.h"
+#include "util/db/dbconnectionpooler.h"
+#include "util/db/sqltransaction.h"
+
+namespace {
+
+const int kTracksPerDirectory = 20;
+const int kAnalyzedTracks = 5;
+const int kBrowsedTracks = 20;
+
+class LibraryDbWorkload {
+  public:
+    LibraryDbWorkload(
+            const QString& filePath,
+            const mixxx::DbConnection::Tuning& tuning)
+            : m_pDbConnectionPool(mixxx::DbConnectionPool::create(
+                      params(filePath, tuning), "BENCHMARK")),
+              m_dbConnectionPooler(m_pDbConnectionPool),
+              m_database(mixxx::DbConnectionPooled(m_pDbConnectionPool)),
+              m_numTracks(0),
+              m_crateId(-1) {
+        MixxxDb::initDatabaseSchema(m_database);
+        QSqlQuery query(m_database);
+        if (!query.exec("INSERT INTO crates (name) VALUES ('Benchmark')")) {
+            LOG_FAILED_QUERY(query);
+        }
+        m_crateId = query.lastInsertId().toInt();
+    }
+
+    int numTracks() const {
+        return m_numTracks;
+    }
+
+    void scanDirectory() {
+        SqlTransaction transaction(m_database);
+        QSqlQuery locationQuery(m_database);
+        locationQuery.prepare(
+                "INSERT INTO track_locations "
+                "(location, filename, directory, filesize, fs_deleted, "
+                "needs_verification) "
+                "VALUES (:location, :filename, :directory, 0, 0, 0)");
+        QSqlQuery trackQuery(m_database);
+        trackQuery.prepare(
+                "INSERT INTO library "
+                "(artist, title, location, mixxx_deleted) "
+                "VALUES (:artist, :title, :location, 0)");
+        QSqlQuery crateQuery(m_database);
+        crateQuery.prepare(
+                "INSERT INTO crate_tracks (crate_id, track_id) "
+                "VALUES (:crate_id, :track_id)");
+        const QString directory = QString("/music/%1").arg(
+                m_numTracks / kTracksPerDirectory);
+        for (int i = 0; i < kTracksPerDirectory; ++i) {
+            const QString fileName = QString("track%1.mp3").arg(m_numTracks);
+            locationQuery.bindValue(":location", location(m_numTracks));
+            locationQuery.bindValue(":filename", fileName);
+            locationQuery.bindValue(":directory", directory);
+            if (!locationQuery.exec()) {
+                LOG_FAILED_QUERY(locationQuery);
+                return;
+            }
+            trackQuery.bindValue(":artist", QString("Artist %1").arg(m_numTracks % 500));
+            trackQuery.bindValue(":title", QString("Title %1").arg(m_numTracks));
+            trackQuery.bindValue(":location", locationQuery.lastInsertId());
+            if (!trackQuery.exec()) {
+                LOG_FAILED_QUERY(trackQuery);
+                return;
+            }
+            if (m_numTracks % 10 == 0) {
+                crateQuery.bindValue(":crate_id", m_crateId);
+                crateQuery.bindValue(":track_id", trackQuery.lastInsertId());
+                if (!crateQuery.exec()) {
+                    LOG_FAILED_QUERY(crateQuery);
+                    return;
+                }
+            }
+            ++m_numTracks;
+        }
+        transaction.commit();
+    }
+
+    // Like TrackDAO, every track is saved on its own
+    void saveAnalysis(int trackIndex) {
+        QSqlQuery query(m_database);
+        query.prepare(
+                "UPDATE library SET bpm=:bpm, replaygain=:replaygain "
+                "WHERE location=("
+                "SELECT id FROM track_locations WHERE location=:location)");
+        query.bindValue(":bpm", 120.0 + trackIndex % 20);
+        query.bindValue(":replaygain", 1.0);
+        query.bindValue(":location", location(trackIndex));
+        if (!query.exec()) {
+            LOG_FAILED_QUERY(query);
+        }
+    }
+
+    // Returns the number of visible tracks
+    int browse(int firstTrackIndex) {
+        QSqlQuery query(m_database);
+        query.setForwardOnly(true);
+        query.prepare(
+                "SELECT COUNT(*) FROM library "
+                "INNER JOIN track_locations ON library.location = track_locations.id "
+                "WHERE library.mixxx_deleted=0");
+        int count = 0;
+        if (query.exec() && query.next()) {
+            count = query.value(0).toInt();
+        } else {
+            LOG_FAILED_QUERY(query);
+        }
+        // Like the crate column of the library view
+        QSqlQuery crateQuery(m_database);
+        crateQuery.prepare(
+                "SELECT crate_tracks.crate_id FROM crate_tracks "
+                "INNER JOIN library ON crate_tracks.track_id = library.id "
+                "INNER JOIN track_locations ON library.location = track_locations.id "
+                "WHERE track_locations.location=:location");
+        for (int i = 0; i < kBrowsedTracks; ++i) {
+            crateQuery.bindValue(":location",
+                    location((firstTrackIndex + i * 7919) % m_numTracks));
+            if (!crateQuery.exec()) {
+                LOG_FAILED_QUERY(crateQuery);
+            }
+            while (crateQuery.next()) {
+            }
+        }
+        return count;
+    }
+
+  private:
+    static mixxx::DbConnection::Params params(
+            const QString& filePath,
+            const mixxx::DbConnection::Tuning& tuning) {
+        mixxx::DbConnection::Params params;
+        params.type = "QSQLITE";
+        params.hostName = "localhost";
+        params.filePath = filePath;
+        params.userName = "mixxx";
+        params.password = "mixxx";
+        params.tuning = tuning;
+        return params;
+    }
+
+    static QString location(int trackIndex) {
+        return QString("/music/%1/track%2.mp3").arg(
+                QString::number(trackIndex / kTracksPerDirectory),
+                QString::number(trackIndex));
+    }
+
+    const mixxx::DbConnectionPoolPtr m_pDbConnectionPool;
+    const mixxx::DbConnectionPooler m_dbConnectionPooler;
+    QSqlDatabase m_database;
+    int m_numTracks;
+    int m_crateId;
+};
+
+static void BM_LibraryDb_Workload(benchmark::State& state) {
+    const bool performance = state.range_y() != 0;
+    QTemporaryDir directory;
+    LibraryDbWorkload workload(
+            directory.path() + "/mixxxdb.sqlite",
+            performance ?
+                    mixxx::DbConnection::Tuning::performance() :
+                    mixxx::DbConnection::Tuning::defaults());
+    while (workload.numTracks() < state.range_x()) {
+        workload.scanDirectory();
+    }
+    int iteration = 0;
+    while (state.KeepRunning()) {
+        workload.scanDirectory();
+        for (int i = 0; i < kAnalyzedTracks; ++i) {
+            workload.saveAnalysis((iteration * kAnalyzedTracks + i) %
+                    workload.numTracks());
+        }
+        benchmark::DoNotOptimize(workload.browse(iteration));
+        ++iteration;
+    }
+    state.SetLabel(performance ? "performance" : "default");
+}
+BENCHMARK(BM_LibraryDb_Workload)
+        ->ArgPair(1000, 0)->ArgPair(1000, 1)
+        ->ArgPair(20000, 0)->ArgPair(20000, 1);
+
+} // anonymous namespace
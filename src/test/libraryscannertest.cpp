@@ -1,15 +1,44 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QThread>
+
 #include "test/librarytest.h"
 
+#include "library/dao/fileindexdao.h"
+#include "library/scanner/fileidentity.h"
 #include "library/scanner/libraryscanner.h"
 
 class LibraryScannerTest : public LibraryTest {
   protected:
     LibraryScannerTest()
-        : m_libraryScanner(dbConnectionPool(), collection(), config()) {
+        : LibraryTest(false), // shared with the scanner thread
+          m_libraryScanner(dbConnectionPool(), collection(), config()) {
+    }
+
+    // Blocks until the scan has finished and the queued signals of the
+    // scanner have been delivered
+    void scanAndWait() {
+        m_libraryScanner.scan();
+        while (m_libraryScanner.m_state != LibraryScanner::IDLE) {
+            application()->processEvents();
+            QThread::msleep(10);
+        }
+        application()->processEvents();
     }
+
+    static bool copyFileContent(const QString& sourcePath, const QString& targetPath) {
+        QFile source(sourcePath);
+        QFile target(targetPath);
+        // Overwrite the target in place instead of replacing it
+        return source.open(QIODevice::ReadOnly) &&
+                target.open(QIODevice::WriteOnly | QIODevice::Truncate) &&
+                target.write(source.readAll()) == source.size();
+    }
+
     LibraryScanner m_libraryScanner;
 };
 
@@ -52,3 +81,49 @@ TEST_F(LibraryScannerTest, ScannerRoundtrip) {
     m_libraryScanner.changeScannerState(LibraryScanner::IDLE);
     EXPECT_EQ(m_libraryScanner.m_state, LibraryScanner::IDLE);
 }
+
+TEST_F(LibraryScannerTest, RescanReimportsModifiedFile) {
+    const QDir testDataDir(QDir::currentPath() + "/src/test/id3-test-data");
+    QTemporaryDir libraryDir;
+    ASSERT_TRUE(libraryDir.isValid());
+    const QString trackLocation =
+            QDir(libraryDir.path()).absoluteFilePath("track.mp3");
+    ASSERT_TRUE(copyFileContent(
+            testDataDir.absoluteFilePath("empty.mp3"), trackLocation));
+    ASSERT_EQ(ALL_FINE, collection()->getDirectoryDAO().addDirectory(libraryDir.path()));
+
+    FileIndexDAO fileIndexDao;
+    fileIndexDao.initialize(dbConnection());
+
+    // Initial scan
+    scanAndWait();
+    TrackDAO& trackDao = collection()->getTrackDAO();
+    const TrackId trackId = trackDao.getTrackId(trackLocation);
+    ASSERT_TRUE(trackId.isValid());
+    TrackPointer pTrack = trackDao.getTrack(trackId);
+    ASSERT_TRUE(pTrack);
+    EXPECT_EQ(QString(), pTrack->getArtist());
+    pTrack.reset();
+    const FileIdentity identityBefore =
+            FileIdentity::fromFileInfo(QFileInfo(trackLocation));
+    ASSERT_TRUE(identityBefore.isValid());
+    EXPECT_EQ(identityBefore,
+            fileIndexDao.getFileIdentities().value(trackLocation));
+
+    // Modify the tags of the file without changing the directory listing
+    ASSERT_TRUE(copyFileContent(
+            testDataDir.absoluteFilePath("artist.mp3"), trackLocation));
+    const FileIdentity identityAfter =
+            FileIdentity::fromFileInfo(QFileInfo(trackLocation));
+    ASSERT_TRUE(identityAfter.isValid());
+    ASSERT_NE(identityBefore, identityAfter);
+
+    // Incremental rescan
+    scanAndWait();
+    EXPECT_EQ(trackId, trackDao.getTrackId(trackLocation));
+    pTrack = trackDao.getTrack(trackId);
+    ASSERT_TRUE(pTrack);
+    EXPECT_EQ(QString("Test Artist"), pTrack->getArtist());
+    EXPECT_EQ(identityAfter,
+            fileIndexDao.getFileIdentities().value(trackLocation));
+}
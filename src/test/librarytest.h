@@ -24,7 +24,13 @@ class LibraryTest : public MixxxTest,
 
   protected:
     LibraryTest()
-        : m_mixxxDb(config(), kInMemoryDbConnection),
+        : LibraryTest(kInMemoryDbConnection) {
+    }
+    // Each connection to an in-memory database opens a separate, empty
+    // database. Tests that access the database from other threads, e.g.
+    // through the library scanner, need a database file instead.
+    explicit LibraryTest(bool inMemoryDbConnection)
+        : m_mixxxDb(config(), inMemoryDbConnection),
           m_dbConnectionPooler(m_mixxxDb.connectionPool()),
           m_dbConnection(mixxx::DbConnectionPooled(m_mixxxDb.connectionPool())),
           m_trackCollection(config()) {
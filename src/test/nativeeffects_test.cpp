@@ -1,5 +1,10 @@
-#if 0
-// TODO: make this work again
+// Benchmarks of the built-in effects with their default parameters. Run
+// them with
+//   mixxx-test --benchmark --benchmark_filter=BM_BuiltInEffects
+// The EQ effects are the ones that run on every deck in every callback.
+// At their default gains the LVMix EQs skip their filters, so the EQs are
+// also benchmarked with all knobs turned up:
+//   mixxx-test --benchmark --benchmark_filter=BM_BuiltInEffects_TurnedKnobs
 #include <benchmark/benchmark.h>
 #include <gtest/gtest.h>
 
@@ -7,6 +12,7 @@
 #include "effects/builtin/autopaneffect.h"
 #include "effects/builtin/bessel4lvmixeqeffect.h"
 #include "effects/builtin/bessel8lvmixeqeffect.h"
+#include "effects/builtin/biquadfullkilleqeffect.h"
 #include "effects/builtin/bitcrushereffect.h"
 #include "effects/builtin/echoeffect.h"
 #include "effects/builtin/filtereffect.h"
@@ -14,84 +20,148 @@
 #include "effects/builtin/graphiceqeffect.h"
 #include "effects/builtin/linkwitzriley8eqeffect.h"
 #include "effects/builtin/moogladder4filtereffect.h"
+#include "effects/builtin/parametriceqeffect.h"
 #include "effects/builtin/phasereffect.h"
 #include "effects/builtin/reverbeffect.h"
+#include "effects/builtin/threebandbiquadeqeffect.h"
 #include "engine/channelhandle.h"
+#include "engine/effects/engineeffect.h"
 #include "engine/effects/groupfeaturestate.h"
+#include "engine/effects/message.h"
 #include "test/baseeffecttest.h"
 #include "util/samplebuffer.h"
 
 namespace {
 
-class EffectsBenchmarkTest : public BaseEffectTest {
-  protected:
-    void SetUp() override {
+class EffectsBenchmark : public BaseEffectTest {
+  public:
+    EffectsBenchmark()
+            : m_loEqFrequency(
+                      ConfigKey("[Mixer Profile]", "LoEQFrequency"), 0., 22040),
+              m_hiEqFrequency(
+                      ConfigKey("[Mixer Profile]", "HiEQFrequency"), 0., 22040) {
+        m_loEqFrequency.setDefaultValue(250.0);
+        m_loEqFrequency.set(250.0);
+        m_hiEqFrequency.setDefaultValue(2500.0);
+        m_hiEqFrequency.set(2500.0);
         registerTestBackend();
     }
+
+    EffectsManager* effectsManager() {
+        return m_pEffectsManager.data();
+    }
+
+    void TestBody() override {}
+
+  private:
+    ControlPotmeter m_loEqFrequency;
+    ControlPotmeter m_hiEqFrequency;
 };
 
+// Sets all knobs halfway between their default and maximum
+void turnKnobs(EngineEffect* pEffect) {
+    for (const auto& pManifestParameter : pEffect->getManifest()->parameters()) {
+        if (pManifestParameter->controlHint() ==
+                EffectManifestParameter::ControlHint::TOGGLE_STEPPING) {
+            continue;
+        }
+        pEffect->getParameterById(pManifestParameter->id())->setValue(
+                (pManifestParameter->getDefault() +
+                        pManifestParameter->getMaximum()) / 2);
+    }
+}
+
 template <class EffectType>
-void benchmarkBuiltInEffectDefaultParameters(const mixxx::EngineParameters& bufferParameters,
-                                            benchmark::State* pState, EffectsManager* pEffectsManager) {
-    EffectManifestPointer pManifest = EffectType::getManifest();
+void benchmarkBuiltInEffect(benchmark::State& state, bool turnedKnobs) {
+    EffectsBenchmark test;
+    EffectsManager* pEffectsManager = test.effectsManager();
+    const mixxx::EngineParameters bufferParameters(
+            mixxx::AudioSignal::SampleRate(44100),
+            state.range_x());
 
     ChannelHandleFactory factory;
-    QSet<ChannelHandleAndGroup> activeInputChannels;
-
-    QString channel1_group = QString("[Channel1]");
-    ChannelHandle channel1 = factory.getOrCreateHandle(channel1_group);
-    ChannelHandleAndGroup handle_and_group(channel1, channel1_group);
+    const QString channel1_group = QString("[Channel1]");
+    const ChannelHandle channel1 = factory.getOrCreateHandle(channel1_group);
+    const ChannelHandleAndGroup handle_and_group(channel1, channel1_group);
     pEffectsManager->registerInputChannel(handle_and_group);
     pEffectsManager->registerOutputChannel(handle_and_group);
+    QSet<ChannelHandleAndGroup> activeInputChannels;
     activeInputChannels.insert(handle_and_group);
+
     EffectInstantiatorPointer pInstantiator = EffectInstantiatorPointer(
-        new EffectProcessorInstantiator<EffectType>());
-    EngineEffect effect(pManifest, activeInputChannels, pEffectsManager, pInstantiator);
+            new EffectProcessorInstantiator<EffectType>());
+    EngineEffect effect(EffectType::getManifest(), activeInputChannels,
+            pEffectsManager, pInstantiator);
+
+    // Preallocate the states like EffectsManager does in the main thread
+    EffectStatesMap statesMap;
+    statesMap.insert(channel1, effect.createState(bufferParameters));
+    effect.loadStatesForInputChannel(&channel1, &statesMap);
+
+    // Enable the effect like EffectsManager does when the effect is loaded
+    QPair<EffectsRequestPipe*, EffectsResponsePipe*> pipes =
+            TwoWayMessagePipe<EffectsRequest*, EffectsResponse>::makeTwoWayMessagePipe(
+                    2, 2, false, false);
+    EffectsRequest request;
+    request.type = EffectsRequest::SET_EFFECT_PARAMETERS;
+    request.SetEffectParameters.enabled = true;
+    effect.processEffectsRequest(request, pipes.second);
+    delete pipes.first;
+    delete pipes.second;
+
+    if (turnedKnobs) {
+        turnKnobs(&effect);
+    }
 
     GroupFeatureState featureState;
-    EffectEnableState enableState = EffectEnableState::Enabled;
+    const EffectEnableState enableState = EffectEnableState::Enabled;
 
     mixxx::SampleBuffer input(bufferParameters.samplesPerBuffer());
+    input.fill(0.1f);
     mixxx::SampleBuffer output(bufferParameters.samplesPerBuffer());
 
-    while (pState->KeepRunning()) {
+    while (state.KeepRunning()) {
         effect.process(channel1, channel1, input.data(), output.data(),
                        bufferParameters.samplesPerBuffer(),
                        bufferParameters.sampleRate(),
                        enableState, featureState);
     }
+    state.SetItemsProcessed(
+            state.iterations() * bufferParameters.framesPerBuffer());
 }
 
 #define FOR_COMMON_BUFFER_SIZES(bm) bm->Arg(32)->Arg(64)->Arg(128)->Arg(256)->Arg(512)->Arg(1024)->Arg(2048)->Arg(4096);
 
-#define DECLARE_EFFECT_BENCHMARK(EffectName)                           \
-TEST_F(EffectsBenchmarkTest, BM_BuiltInEffects_DefaultParameters_##EffectName) { \
-    ControlPotmeter loEqFrequency(                                     \
-        ConfigKey("[Mixer Profile]", "LoEQFrequency"), 0., 22040);     \
-    loEqFrequency.setDefaultValue(250.0);                              \
-    ControlPotmeter hiEqFrequency(                                     \
-        ConfigKey("[Mixer Profile]", "HiEQFrequency"), 0., 22040);     \
-    hiEqFrequency.setDefaultValue(2500.0);                             \
-    mixxx::EngineParameters bufferParameters(                          \
-        mixxx::AudioSignal::SampleRate(44100),                         \
-        state.range_x());                                              \
-    benchmarkBuiltInEffectDefaultParameters<EffectName>(                \
-        bufferParameters, &state, m_pEffectsManager);                                     \
-}                                                                      \
+#define DECLARE_EFFECT_BENCHMARK(EffectName)                                    \
+static void BM_BuiltInEffects_DefaultParameters_##EffectName(                   \
+        benchmark::State& state) {                                              \
+    benchmarkBuiltInEffect<EffectName>(state, false);                           \
+}                                                                               \
 FOR_COMMON_BUFFER_SIZES(BENCHMARK(BM_BuiltInEffects_DefaultParameters_##EffectName));
 
-DECLARE_EFFECT_BENCHMARK(Bessel4LVMixEQEffect)
-DECLARE_EFFECT_BENCHMARK(Bessel8LVMixEQEffect)
+#define DECLARE_EQ_BENCHMARK(EffectName)                                        \
+DECLARE_EFFECT_BENCHMARK(EffectName)                                            \
+static void BM_BuiltInEffects_TurnedKnobs_##EffectName(                         \
+        benchmark::State& state) {                                              \
+    benchmarkBuiltInEffect<EffectName>(state, true);                            \
+}                                                                               \
+FOR_COMMON_BUFFER_SIZES(BENCHMARK(BM_BuiltInEffects_TurnedKnobs_##EffectName));
+
+DECLARE_EQ_BENCHMARK(Bessel4LVMixEQEffect)
+DECLARE_EQ_BENCHMARK(Bessel8LVMixEQEffect)
+DECLARE_EQ_BENCHMARK(BiquadFullKillEQEffect)
+DECLARE_EQ_BENCHMARK(GraphicEQEffect)
+DECLARE_EQ_BENCHMARK(LinkwitzRiley8EQEffect)
+DECLARE_EQ_BENCHMARK(ParametricEQEffect)
+DECLARE_EQ_BENCHMARK(ThreeBandBiquadEQEffect)
+
+DECLARE_EFFECT_BENCHMARK(AutoPanEffect)
 DECLARE_EFFECT_BENCHMARK(BitCrusherEffect)
 DECLARE_EFFECT_BENCHMARK(EchoEffect)
 DECLARE_EFFECT_BENCHMARK(FilterEffect)
 DECLARE_EFFECT_BENCHMARK(FlangerEffect)
-DECLARE_EFFECT_BENCHMARK(GraphicEQEffect)
-DECLARE_EFFECT_BENCHMARK(LinkwitzRiley8EQEffect)
 DECLARE_EFFECT_BENCHMARK(MoogLadder4FilterEffect)
 DECLARE_EFFECT_BENCHMARK(PhaserEffect)
 DECLARE_EFFECT_BENCHMARK(ReverbEffect)
 
 }  // namespace
-#endif
-
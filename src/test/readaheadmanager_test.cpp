@@ -15,21 +15,37 @@
 class StubReader : public CachingReader {
   public:
     StubReader()
-            : CachingReader("[test]", UserSettingsPointer()) { }
+            : CachingReader("[test]", UserSettingsPointer()),
+              m_available(true) { }
+
+    void setAvailable(bool available) {
+        m_available = available;
+    }
 
     CachingReader::ReadResult read(SINT startSample, SINT numSamples, bool reverse,
              CSAMPLE* buffer) override {
         Q_UNUSED(startSample);
         Q_UNUSED(reverse);
         SampleUtil::clear(buffer, numSamples);
-        return CachingReader::ReadResult::AVAILABLE;
+        return m_available ? CachingReader::ReadResult::AVAILABLE :
+                CachingReader::ReadResult::UNAVAILABLE;
     }
+
+  private:
+    bool m_available;
 };
 
 class StubLoopControl : public LoopingControl {
   public:
     StubLoopControl()
-            : LoopingControl("[test]", UserSettingsPointer()) { }
+            : LoopingControl("[test]", UserSettingsPointer()),
+              m_loopStart(kNoTrigger),
+              m_loopEnd(kNoTrigger) { }
+
+    void setActiveLoop(double start, double end) {
+        m_loopStart = start;
+        m_loopEnd = end;
+    }
 
     void pushTriggerReturnValue(double value) {
         m_triggerReturnValues.push_back(value);
@@ -51,6 +67,15 @@ class StubLoopControl : public LoopingControl {
         return m_triggerReturnValues.takeFirst();
     }
 
+    bool getActiveLoop(double* pStartSample, double* pEndSample) const override {
+        if (m_loopStart == kNoTrigger || m_loopEnd == kNoTrigger) {
+            return false;
+        }
+        *pStartSample = m_loopStart;
+        *pEndSample = m_loopEnd;
+        return true;
+    }
+
     // hintReader has no effect in this stubbed class
     void hintReader(HintVector* pHintList) override {
         Q_UNUSED(pHintList);
@@ -67,6 +92,8 @@ class StubLoopControl : public LoopingControl {
   protected:
     QList<double> m_triggerReturnValues;
     QList<double> m_targetReturnValues;
+    double m_loopStart;
+    double m_loopEnd;
 };
 
 class ReadAheadManagerTest : public MixxxTest {
@@ -126,3 +153,88 @@ TEST_F(ReadAheadManagerTest, FractionalFrameLoop) {
     // The rounding error must not exceed a half frame (one samples in stereo)
     EXPECT_NEAR(16, m_pReadAheadManager->getPlaypos(), 1);
 }
+
+TEST_F(ReadAheadManagerTest, HintLoopInBeforeReachingLoopOut) {
+    m_pLoopControl->setActiveLoop(1000, 20000);
+    m_pReadAheadManager->notifySeek(19000);
+
+    HintVector hints;
+    m_pReadAheadManager->hintReader(1.0, &hints);
+
+    // Up to the loop out point and then the whole loop
+    ASSERT_EQ(2, hints.size());
+    EXPECT_EQ(9500, hints[0].frame);
+    EXPECT_EQ(500, hints[0].frameCount);
+    EXPECT_EQ(500, hints[1].frame);
+    EXPECT_EQ(9500, hints[1].frameCount);
+}
+
+TEST_F(ReadAheadManagerTest, HintLoopOutBeforeReachingLoopInInReverse) {
+    m_pLoopControl->setActiveLoop(1000, 20000);
+    m_pReadAheadManager->notifySeek(3000);
+
+    HintVector hints;
+    m_pReadAheadManager->hintReader(-1.0, &hints);
+
+    ASSERT_EQ(2, hints.size());
+    EXPECT_EQ(500, hints[0].frame);
+    EXPECT_EQ(1000, hints[0].frameCount);
+    EXPECT_EQ(500, hints[1].frame);
+    EXPECT_EQ(9500, hints[1].frameCount);
+}
+
+TEST_F(ReadAheadManagerTest, HintFollowsReadRate) {
+    m_pReadAheadManager->notifySeek(0);
+
+    // Without any reads, two chunks are hinted
+    HintVector hints;
+    m_pReadAheadManager->hintReader(1.0, &hints);
+    ASSERT_EQ(1, hints.size());
+    EXPECT_EQ(0, hints[0].frame);
+    EXPECT_EQ(2 * CachingReaderChunk::kFrames, hints[0].frameCount);
+
+    // Like a callback of 5000 frames at double speed
+    m_pLoopControl->pushTriggerReturnValue(kNoTrigger);
+    m_pLoopControl->pushTargetReturnValue(kNoTrigger);
+    EXPECT_EQ(20000, m_pReadAheadManager->getNextSamples(2.0, m_pBuffer, 20000));
+
+    hints.clear();
+    m_pReadAheadManager->hintReader(2.0, &hints);
+    ASSERT_EQ(1, hints.size());
+    EXPECT_EQ(10000, hints[0].frame);
+    // 4 callbacks ahead
+    EXPECT_EQ(40000, hints[0].frameCount);
+}
+
+TEST_F(ReadAheadManagerTest, CountCacheMisses) {
+    m_pReadAheadManager->notifySeek(0);
+    m_pLoopControl->pushTriggerReturnValue(kNoTrigger);
+    m_pLoopControl->pushTargetReturnValue(kNoTrigger);
+    m_pLoopControl->pushTriggerReturnValue(kNoTrigger);
+    m_pLoopControl->pushTargetReturnValue(kNoTrigger);
+
+    m_pReadAheadManager->getNextSamples(1.0, m_pBuffer, 100);
+    EXPECT_EQ(0, m_pReadAheadManager->getCacheMissCount());
+
+    m_pReader->setAvailable(false);
+    m_pReadAheadManager->getNextSamples(1.0, m_pBuffer, 100);
+    EXPECT_EQ(1, m_pReadAheadManager->getCacheMissCount());
+}
+
+TEST_F(ReadAheadManagerTest, ReadLogOfManyLoops) {
+    // A very short loop creates a new log entry for every read
+    const int loops = 2000;
+    m_pReadAheadManager->notifySeek(0);
+    for (int i = 0; i < loops; ++i) {
+        m_pLoopControl->pushTriggerReturnValue(10);
+        m_pLoopControl->pushTargetReturnValue(0);
+    }
+    for (int i = 0; i < loops; ++i) {
+        EXPECT_EQ(10, m_pReadAheadManager->getNextSamples(1.0, m_pBuffer, 100));
+    }
+
+    // The log has wrapped around and is still consumed entry by entry
+    EXPECT_DOUBLE_EQ(4, m_pReadAheadManager->getFilePlaypositionFromLog(0, 4));
+    EXPECT_DOUBLE_EQ(10, m_pReadAheadManager->getFilePlaypositionFromLog(4, 6));
+    EXPECT_DOUBLE_EQ(2, m_pReadAheadManager->getFilePlaypositionFromLog(10, 2));
+}
@@ -23,10 +23,15 @@ class SearchQueryParserTest : public LibraryTest {
 
     SearchQueryParser m_parser;
 
-    // The expected query to be returned by CrateFilterNode
-    const QString m_crateFilterQuery =
-        "id IN (SELECT DISTINCT track_id FROM crate_tracks"
-        " JOIN crates ON crate_id=id WHERE name LIKE '%%1%' ORDER BY track_id)";
+    // The expected query to be returned by CrateFilterNode after the
+    // matching track ids have been evaluated in memory
+    static QString crateFilterQuery(const QList<TrackId>& trackIds) {
+        QStringList values;
+        for (const auto& trackId : trackIds) {
+            values << trackId.toString();
+        }
+        return QString("id IN (%1)").arg(values.join(","));
+    }
 };
 
 TEST_F(SearchQueryParserTest, EmptySearch) {
@@ -777,7 +782,7 @@ TEST_F(SearchQueryParserTest, CrateFilter) {
     EXPECT_FALSE(pQuery->match(pTrackB));
 
     EXPECT_STREQ(
-                 qPrintable(m_crateFilterQuery.arg(searchTerm)),
+                 qPrintable(crateFilterQuery(trackIds)),
                  qPrintable(pQuery->toSql()));
 }
 
@@ -877,7 +882,7 @@ TEST_F(SearchQueryParserTest, CrateFilterQuote){
     EXPECT_FALSE(pQuery->match(pTrackB));
 
     EXPECT_STREQ(
-                 qPrintable(m_crateFilterQuery.arg(searchTerm)),
+                 qPrintable(crateFilterQuery(trackIds)),
                  qPrintable(pQuery->toSql()));
 }
 
@@ -924,7 +929,7 @@ TEST_F(SearchQueryParserTest, CrateFilterWithOther){
     EXPECT_FALSE(pQuery->match(pTrackB));
 
     EXPECT_STREQ(
-                 qPrintable("(" + m_crateFilterQuery.arg(searchTerm) +
+                 qPrintable("(" + crateFilterQuery(trackIds) +
                             ") AND ((artist LIKE '%asdf%') OR (album_artist LIKE '%asdf%'))"),
                  qPrintable(pQuery->toSql()));
 }
@@ -932,7 +937,6 @@ TEST_F(SearchQueryParserTest, CrateFilterWithOther){
 TEST_F(SearchQueryParserTest, CrateFilterWithCrateFilterAndNegation){
     // User's search term
     QString searchTermA = "testA'1"; // Also a test if "'" is escaped lp1789728
-    QString searchTermAEsc = "testA''1";
     QString searchTermB = "testB";
 
     // Parse the user query
@@ -974,9 +978,9 @@ TEST_F(SearchQueryParserTest, CrateFilterWithCrateFilterAndNegation){
     EXPECT_TRUE(pQueryA->match(pTrackA));
     EXPECT_FALSE(pQueryA->match(pTrackB));
 
+    // Both crate filters are combined into a single clause
     EXPECT_STREQ(
-                 qPrintable("(" + m_crateFilterQuery.arg(searchTermAEsc) +
-                            ") AND (" + m_crateFilterQuery.arg(searchTermB) + ")"),
+                 qPrintable(crateFilterQuery(QList<TrackId>() << trackAId)),
                  qPrintable(pQueryA->toSql()));
 
     // parse again to test negation
@@ -987,7 +991,77 @@ TEST_F(SearchQueryParserTest, CrateFilterWithCrateFilterAndNegation){
     EXPECT_TRUE(pQueryB->match(pTrackB));
 
     EXPECT_STREQ(
-                 qPrintable("(" + m_crateFilterQuery.arg(searchTermAEsc) +
-                            ") AND (NOT (" + m_crateFilterQuery.arg(searchTermB) + "))"),
+                 qPrintable(crateFilterQuery(QList<TrackId>() << trackBId)),
                  qPrintable(pQueryB->toSql()));
 }
+
+TEST_F(SearchQueryParserTest, CrateFilterFollowsCrateModifications) {
+    auto pQuery(m_parser.parseQuery(QString("crate: test"), QStringList(), ""));
+
+    const QString kTrackALocationTest(QDir::currentPath() %
+                  "/src/test/id3-test-data/cover-test-jpg.mp3");
+    TrackId trackAId = addTrackToCollection(kTrackALocationTest);
+    TrackPointer pTrackA(Track::newDummy(kTrackALocationTest, trackAId));
+
+    // No crate matches
+    EXPECT_FALSE(pQuery->match(pTrackA));
+    EXPECT_STREQ(qPrintable("0"), qPrintable(pQuery->toSql()));
+
+    Crate crate;
+    crate.setName("other");
+    CrateId crateId;
+    ASSERT_TRUE(collection()->insertCrate(crate, &crateId));
+    QList<TrackId> trackIds;
+    trackIds << trackAId;
+    ASSERT_TRUE(collection()->addCrateTracks(crateId, trackIds));
+    EXPECT_FALSE(pQuery->match(pTrackA));
+
+    // Renaming the crate affects the existing query
+    ASSERT_TRUE(collection()->crates().readCrateById(crateId, &crate));
+    crate.setName("my TEST crate");
+    ASSERT_TRUE(collection()->updateCrate(crate));
+    EXPECT_TRUE(pQuery->match(pTrackA));
+    EXPECT_STREQ(
+                 qPrintable(crateFilterQuery(trackIds)),
+                 qPrintable(pQuery->toSql()));
+
+    ASSERT_TRUE(collection()->removeCrateTracks(crateId, trackIds));
+    EXPECT_FALSE(pQuery->match(pTrackA));
+
+    ASSERT_TRUE(collection()->addCrateTracks(crateId, trackIds));
+    EXPECT_TRUE(pQuery->match(pTrackA));
+
+    ASSERT_TRUE(collection()->deleteCrate(crateId));
+    EXPECT_FALSE(pQuery->match(pTrackA));
+}
+
+TEST_F(SearchQueryParserTest, NoCrateFilter) {
+    auto pQuery(m_parser.parseQuery(QString("crate: \"\""), QStringList(), ""));
+
+    const QString kTrackALocationTest(QDir::currentPath() %
+                  "/src/test/id3-test-data/cover-test-jpg.mp3");
+    const QString kTrackBLocationTest(QDir::currentPath() %
+                  "/src/test/id3-test-data/cover-test-png.mp3");
+    TrackId trackAId = addTrackToCollection(kTrackALocationTest);
+    TrackPointer pTrackA(Track::newDummy(kTrackALocationTest, trackAId));
+    TrackId trackBId = addTrackToCollection(kTrackBLocationTest);
+    TrackPointer pTrackB(Track::newDummy(kTrackBLocationTest, trackBId));
+
+    Crate crate;
+    crate.setName("test");
+    CrateId crateId;
+    ASSERT_TRUE(collection()->insertCrate(crate, &crateId));
+    QList<TrackId> trackIds;
+    trackIds << trackAId;
+    ASSERT_TRUE(collection()->addCrateTracks(crateId, trackIds));
+
+    EXPECT_FALSE(pQuery->match(pTrackA));
+    EXPECT_TRUE(pQuery->match(pTrackB));
+    EXPECT_STREQ(
+                 qPrintable(QString("id NOT IN (%1)").arg(trackAId.toString())),
+                 qPrintable(pQuery->toSql()));
+
+    // Purged tracks are removed from all crates
+    ASSERT_TRUE(collection()->purgeTracks(trackIds));
+    EXPECT_STREQ(qPrintable("1"), qPrintable(pQuery->toSql()));
+}
@@ -69,25 +69,10 @@ class SoundSourceProxyTest: public MixxxTest {
         return filePaths;
     }
 
-    enum class OpenAudioSourceMode {
-        Default,
-        DisableFFmpeg,
-    };
-
-    static mixxx::AudioSourcePointer openAudioSource(const QString& filePath, OpenAudioSourceMode mode = OpenAudioSourceMode::Default) {
+    static mixxx::AudioSourcePointer openAudioSource(const QString& filePath) {
         auto pTrack = Track::newTemporary(filePath);
         SoundSourceProxy proxy(pTrack);
 
-        // TODO(XXX): Fix SoundSourceFFmpeg to avoid this special case handling
-        if ((mode == OpenAudioSourceMode::DisableFFmpeg) &&
-                proxy.getSoundSourceProvider() &&
-                (proxy.getSoundSourceProvider()->getName() == "FFmpeg")) {
-            qWarning()
-                    << "Disabling test for FFmpeg:"
-                    << filePath;
-            return mixxx::AudioSourcePointer();
-        }
-
         // All test files are mono, but we are requesting a stereo signal
         // to test the upscaling of channels
         mixxx::AudioSource::OpenParams openParams;
@@ -452,8 +437,7 @@ TEST_F(SoundSourceProxyTest, seekBoundaries) {
 
         qDebug() << "Seek boundaries test:" << filePath;
 
-        // TODO(XXX): Fix SoundSourceFFmpeg and re-enable testing
-        mixxx::AudioSourcePointer pSeekReadSource(openAudioSource(filePath, OpenAudioSourceMode::DisableFFmpeg));
+        mixxx::AudioSourcePointer pSeekReadSource(openAudioSource(filePath));
         // Obtaining an AudioSource may fail for unsupported file formats,
         // even if the corresponding file extension is supported, e.g.
         // AAC vs. ALAC in .m4a files
@@ -645,3 +629,57 @@ TEST_F(SoundSourceProxyTest, regressionTestCachingReaderChunkJumpForward) {
         }
     }
 }
+
+TEST_F(SoundSourceProxyTest, decodeMonoAsStereo) {
+    const SINT kReadFrameCount = 1000;
+    for (const auto& filePath: getFilePaths()) {
+        ASSERT_TRUE(SoundSourceProxy::isFileNameSupported(filePath));
+
+        qDebug() << "Decode mono as stereo test:" << filePath;
+
+        mixxx::AudioSource::OpenParams monoParams;
+        monoParams.setChannelCount(1);
+        SoundSourceProxy monoProxy(Track::newTemporary(filePath));
+        mixxx::AudioSourcePointer pMonoSource(
+                monoProxy.openAudioSource(monoParams));
+        if (!pMonoSource) {
+            // skip test file
+            continue;
+        }
+        // All test files are mono
+        ASSERT_EQ(1, pMonoSource->channelCount());
+
+        // Decoders either double the channels while decoding or
+        // the proxy doubles them afterwards
+        mixxx::AudioSourcePointer pStereoSource(openAudioSource(filePath));
+        ASSERT_FALSE(!pStereoSource);
+        ASSERT_EQ(pMonoSource->frameIndexRange(), pStereoSource->frameIndexRange());
+
+        const auto readFrameIndexRange = intersect(
+                mixxx::IndexRange::forward(
+                        pMonoSource->frameIndexMin() + pMonoSource->frameLength() / 2,
+                        kReadFrameCount),
+                pMonoSource->frameIndexRange());
+        mixxx::SampleBuffer monoData(kReadFrameCount);
+        const auto monoSampleFrames =
+                pMonoSource->readSampleFrames(
+                        mixxx::WritableSampleFrames(
+                                readFrameIndexRange,
+                                mixxx::SampleBuffer::WritableSlice(monoData)));
+        ASSERT_EQ(readFrameIndexRange, monoSampleFrames.frameIndexRange());
+        mixxx::SampleBuffer stereoData(2 * kReadFrameCount);
+        const auto stereoSampleFrames =
+                pStereoSource->readSampleFrames(
+                        mixxx::WritableSampleFrames(
+                                readFrameIndexRange,
+                                mixxx::SampleBuffer::WritableSlice(stereoData)));
+        ASSERT_EQ(readFrameIndexRange, stereoSampleFrames.frameIndexRange());
+
+        for (SINT i = 0; i < readFrameIndexRange.length(); ++i) {
+            EXPECT_EQ(monoSampleFrames.readableData()[i],
+                    stereoSampleFrames.readableData()[2 * i]);
+            EXPECT_EQ(monoSampleFrames.readableData()[i],
+                    stereoSampleFrames.readableData()[2 * i + 1]);
+        }
+    }
+}
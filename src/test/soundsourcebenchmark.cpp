@@ -0,0 +1,106 @@
+// Decoding throughput of the SoundSources per file format. Run them with
+//   mixxx-test --benchmark --benchmark_filter=BM_SoundSourceDecode
+// Each iteration decodes one block of frames like the CachingReaderWorker
+// does, starting over at the beginning after the end of the file. The items
+// per second are decoded frames per second and the bytes per second refer
+// to the decoded stereo float samples. The label names the format.
+#include <benchmark/benchmark.h>
+
+#include <QDir>
+
+#include "sources/audiosourcestereoproxy.h"
+#include "sources/soundsourceproxy.h"
+#include "test/mixxxtest.h"
+#include "track/track.h"
+#include "util/samplebuffer.h"
+
+namespace {
+
+const QDir kTestDir(QDir::current().absoluteFilePath("src/test/id3-test-data"));
+
+// The test files of SoundSourceProxyTest
+const char* kFileNameSuffixes[] = {
+        ".aiff",
+        ".flac",
+        ".m4a",
+        "-png.mp3",
+        ".ogg",
+        ".opus",
+        ".wav",
+        ".wv",
+};
+
+class SoundSourceBenchmark : public MixxxTest {
+  public:
+    // Returns a null pointer if the format is not supported by this build
+    mixxx::AudioSourcePointer openAudioSource(const QString& filePath,
+            SINT maxReadFrameCount) {
+        if (!SoundSourceProxy::isFileNameSupported(filePath)) {
+            return mixxx::AudioSourcePointer();
+        }
+        SoundSourceProxy proxy(Track::newTemporary(filePath));
+        mixxx::AudioSource::OpenParams openParams;
+        openParams.setChannelCount(2);
+        auto pAudioSource = proxy.openAudioSource(openParams);
+        if (pAudioSource && pAudioSource->channelCount() != 2) {
+            // The engine always reads stereo
+            pAudioSource = mixxx::AudioSourceStereoProxy::create(
+                    pAudioSource, maxReadFrameCount);
+        }
+        return pAudioSource;
+    }
+
+    void TestBody() override {}
+};
+
+static void BM_SoundSourceDecode(benchmark::State& state) {
+    const QString fileNameSuffix = kFileNameSuffixes[state.range_x()];
+    const SINT framesPerBlock = state.range_y();
+
+    SoundSourceBenchmark test;
+    mixxx::AudioSourcePointer pAudioSource = test.openAudioSource(
+            kTestDir.absoluteFilePath("cover-test" + fileNameSuffix),
+            framesPerBlock);
+    if (!pAudioSource || pAudioSource->frameIndexRange().empty()) {
+        while (state.KeepRunning()) {
+        }
+        state.SetLabel(QString("%1 unsupported")
+                .arg(fileNameSuffix).toStdString());
+        return;
+    }
+
+    mixxx::SampleBuffer buffer(pAudioSource->frames2samples(framesPerBlock));
+    SINT frameIndex = pAudioSource->frameIndexMin();
+    SINT framesDecoded = 0;
+    while (state.KeepRunning()) {
+        const auto readFrames = pAudioSource->readSampleFrames(
+                mixxx::WritableSampleFrames(
+                        mixxx::IndexRange::forward(frameIndex, framesPerBlock),
+                        mixxx::SampleBuffer::WritableSlice(buffer)));
+        const SINT frames = readFrames.frameLength();
+        framesDecoded += frames;
+        frameIndex += frames;
+        if (frames < framesPerBlock ||
+                frameIndex >= pAudioSource->frameIndexMax()) {
+            // Seeking back is part of the measurement, like at the start
+            // of every new chunk in the reader
+            frameIndex = pAudioSource->frameIndexMin();
+        }
+    }
+    state.SetItemsProcessed(framesDecoded);
+    state.SetBytesProcessed(static_cast<size_t>(
+            pAudioSource->frames2samples(framesDecoded)) * sizeof(CSAMPLE));
+    state.SetLabel(fileNameSuffix.toStdString());
+}
+
+void soundSourceDecodeArguments(benchmark::internal::Benchmark* pBenchmark) {
+    const int formats = sizeof(kFileNameSuffixes) / sizeof(kFileNameSuffixes[0]);
+    for (int format = 0; format < formats; ++format) {
+        // The chunk size of the CachingReader and a typical analysis block
+        pBenchmark->ArgPair(format, 8192);
+        pBenchmark->ArgPair(format, 4096);
+    }
+}
+BENCHMARK(BM_SoundSourceDecode)->Apply(soundSourceDecodeArguments);
+
+}  // namespace
@@ -0,0 +1,123 @@
+// Opening and seeking throughput of SoundSourceFFmpeg for the test files
+// of SoundSourceProxyTest. Run them with
+//   mixxx-test --benchmark --benchmark_filter=BM_SoundSourceFFmpeg
+// The FFmpeg decoder is instantiated directly, because SoundSourceProxy
+// only uses it as the last resort. The items per second are opened files
+// or random seeks per second. The label names the format.
+#ifdef __FFMPEGFILE__
+
+#include <benchmark/benchmark.h>
+
+#include <QDir>
+#include <QUrl>
+
+#include <random>
+
+#include "sources/soundsourceffmpeg.h"
+#include "util/samplebuffer.h"
+
+namespace {
+
+const QDir kTestDir(QDir::current().absoluteFilePath("src/test/id3-test-data"));
+
+// The test files of SoundSourceProxyTest
+const char* kFileNameSuffixes[] = {
+        ".aiff",
+        ".flac",
+        ".m4a",
+        "-png.mp3",
+        ".ogg",
+        ".opus",
+        ".wav",
+        ".wv",
+};
+
+QUrl testFileUrl(const QString& fileNameSuffix) {
+    return QUrl::fromLocalFile(
+            kTestDir.absoluteFilePath("cover-test" + fileNameSuffix));
+}
+
+static void BM_SoundSourceFFmpegOpen(benchmark::State& state) {
+    const QString fileNameSuffix = kFileNameSuffixes[state.range_x()];
+    const QUrl url = testFileUrl(fileNameSuffix);
+
+    int opened = 0;
+    bool failed = false;
+    while (state.KeepRunning()) {
+        if (failed) {
+            continue;
+        }
+        mixxx::SoundSourceFFmpeg soundSource(url);
+        if (soundSource.open(mixxx::AudioSource::OpenMode::Strict) !=
+                mixxx::AudioSource::OpenResult::Succeeded) {
+            failed = true;
+            continue;
+        }
+        soundSource.close();
+        ++opened;
+    }
+    if (failed) {
+        state.SetLabel(QString("%1 unsupported")
+                .arg(fileNameSuffix).toStdString());
+        return;
+    }
+    state.SetItemsProcessed(opened);
+    state.SetLabel(fileNameSuffix.toStdString());
+}
+
+// Reads a block of frames at a random position in each iteration like
+// the CachingReaderWorker does when jumping around in a track
+static void BM_SoundSourceFFmpegRandomSeek(benchmark::State& state) {
+    const QString fileNameSuffix = kFileNameSuffixes[state.range_x()];
+    const SINT framesPerBlock = state.range_y();
+
+    mixxx::SoundSourceFFmpeg soundSource(testFileUrl(fileNameSuffix));
+    if ((soundSource.open(mixxx::AudioSource::OpenMode::Strict) !=
+                mixxx::AudioSource::OpenResult::Succeeded) ||
+            soundSource.frameIndexRange().empty()) {
+        while (state.KeepRunning()) {
+        }
+        state.SetLabel(QString("%1 unsupported")
+                .arg(fileNameSuffix).toStdString());
+        return;
+    }
+
+    mixxx::SampleBuffer buffer(soundSource.frames2samples(framesPerBlock));
+    // Same sequence of positions for each run
+    std::mt19937 random(42);
+    std::uniform_int_distribution<SINT> frameIndexDistribution(
+            soundSource.frameIndexMin(), soundSource.frameIndexMax() - 1);
+    int seeks = 0;
+    while (state.KeepRunning()) {
+        const SINT frameIndex = frameIndexDistribution(random);
+        const auto readFrames = soundSource.readSampleFrames(
+                mixxx::WritableSampleFrames(
+                        mixxx::IndexRange::forward(frameIndex, framesPerBlock),
+                        mixxx::SampleBuffer::WritableSlice(buffer)));
+        benchmark::DoNotOptimize(readFrames.frameLength());
+        ++seeks;
+    }
+    state.SetItemsProcessed(seeks);
+    state.SetLabel(fileNameSuffix.toStdString());
+}
+
+void soundSourceFFmpegOpenArguments(benchmark::internal::Benchmark* pBenchmark) {
+    const int formats = sizeof(kFileNameSuffixes) / sizeof(kFileNameSuffixes[0]);
+    for (int format = 0; format < formats; ++format) {
+        pBenchmark->Arg(format);
+    }
+}
+BENCHMARK(BM_SoundSourceFFmpegOpen)->Apply(soundSourceFFmpegOpenArguments);
+
+void soundSourceFFmpegRandomSeekArguments(benchmark::internal::Benchmark* pBenchmark) {
+    const int formats = sizeof(kFileNameSuffixes) / sizeof(kFileNameSuffixes[0]);
+    for (int format = 0; format < formats; ++format) {
+        // The chunk size of the CachingReader
+        pBenchmark->ArgPair(format, 8192);
+    }
+}
+BENCHMARK(BM_SoundSourceFFmpegRandomSeek)->Apply(soundSourceFFmpegRandomSeekArguments);
+
+}  // namespace
+
+#endif // __FFMPEGFILE__
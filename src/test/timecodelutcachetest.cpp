@@ -0,0 +1,149 @@
+#ifdef __VINYLCONTROL__
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "vinylcontrol/timecodelutcache.h"
+
+namespace {
+
+// The shortest timecode keeps the tests fast
+const char* kTimecode = "mixvibes_7inch";
+
+class TimecodeLutCacheTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_dir.isValid());
+        m_path = m_dir.path() + "/test.lut";
+
+        const timecode_def* pDef =
+                timecoder_find_definition_without_lookup(kTimecode);
+        ASSERT_NE(nullptr, pDef);
+        // Copies that don't touch the shared definitions
+        m_fresh = *pDef;
+        m_fresh.lookup = false;
+        ASSERT_EQ(0, timecoder_build_lookup(&m_fresh));
+        m_cached = *pDef;
+        m_cached.lookup = false;
+    }
+
+    void TearDown() override {
+        lut_clear(&m_fresh.lut);
+        if (m_cached.lookup) {
+            lut_clear(&m_cached.lut);
+        }
+    }
+
+    void expectSameLut(const timecode_def& expected, timecode_def* pActual) {
+        ASSERT_TRUE(pActual->lookup);
+        ASSERT_EQ(expected.lut.avail, pActual->lut.avail);
+        EXPECT_EQ(0, memcmp(expected.lut.slot, pActual->lut.slot,
+                expected.lut.avail * sizeof(struct slot)));
+        EXPECT_EQ(0, memcmp(expected.lut.table, pActual->lut.table,
+                LUT_HASHES * sizeof(slot_no_t)));
+        for (unsigned int n = 0; n < expected.length; n += 997) {
+            EXPECT_EQ(n, lut_lookup(&pActual->lut, expected.lut.slot[n].timecode));
+        }
+    }
+
+    QTemporaryDir m_dir;
+    QString m_path;
+    timecode_def m_fresh;
+    timecode_def m_cached;
+};
+
+TEST_F(TimecodeLutCacheTest, CachedMatchesFresh) {
+    ASSERT_TRUE(TimecodeLutCache::writeFile(m_path, m_fresh));
+
+    QFile file(m_path);
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    ASSERT_TRUE(TimecodeLutCache::mapFile(&file, &m_cached));
+    expectSameLut(m_fresh, &m_cached);
+}
+
+TEST_F(TimecodeLutCacheTest, RejectsOtherDefinition) {
+    ASSERT_TRUE(TimecodeLutCache::writeFile(m_path, m_fresh));
+
+    m_cached.seed ^= 0x1;
+    QFile file(m_path);
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    EXPECT_FALSE(TimecodeLutCache::mapFile(&file, &m_cached));
+    EXPECT_FALSE(m_cached.lookup);
+}
+
+TEST_F(TimecodeLutCacheTest, RejectsTruncatedFile) {
+    ASSERT_TRUE(TimecodeLutCache::writeFile(m_path, m_fresh));
+    QFile file(m_path);
+    ASSERT_TRUE(file.resize(file.size() - sizeof(slot_no_t)));
+
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    EXPECT_FALSE(TimecodeLutCache::mapFile(&file, &m_cached));
+    EXPECT_FALSE(m_cached.lookup);
+}
+
+TEST_F(TimecodeLutCacheTest, RejectsLinksOutOfBounds) {
+    ASSERT_TRUE(TimecodeLutCache::writeFile(m_path, m_fresh));
+    QFile file(m_path);
+    ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+    // The last entry of the hash table
+    const slot_no_t outOfBounds = m_fresh.length;
+    ASSERT_TRUE(file.seek(file.size() - sizeof(slot_no_t)));
+    ASSERT_EQ(static_cast<qint64>(sizeof(outOfBounds)),
+            file.write(reinterpret_cast<const char*>(&outOfBounds),
+                    sizeof(outOfBounds)));
+    file.close();
+
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    EXPECT_FALSE(TimecodeLutCache::mapFile(&file, &m_cached));
+    EXPECT_FALSE(m_cached.lookup);
+}
+
+TEST_F(TimecodeLutCacheTest, RejectsCyclicLinks) {
+    ASSERT_TRUE(TimecodeLutCache::writeFile(m_path, m_fresh));
+    QFile file(m_path);
+    ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+    // Link the second slot to itself
+    const slot_no_t cyclic = 1;
+    const qint64 slotsOffset = file.size() -
+            m_fresh.lut.avail * sizeof(struct slot) -
+            LUT_HASHES * sizeof(slot_no_t);
+    ASSERT_TRUE(file.seek(slotsOffset + sizeof(struct slot) +
+            offsetof(struct slot, next)));
+    ASSERT_EQ(static_cast<qint64>(sizeof(cyclic)),
+            file.write(reinterpret_cast<const char*>(&cyclic),
+                    sizeof(cyclic)));
+    file.close();
+
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    EXPECT_FALSE(TimecodeLutCache::mapFile(&file, &m_cached));
+    EXPECT_FALSE(m_cached.lookup);
+}
+
+TEST_F(TimecodeLutCacheTest, FindDefinitionLoadsFromCache) {
+    TimecodeLutCache::setCacheDirectory(m_dir.path());
+
+    // Builds and writes the cache file
+    timecode_def* pDef = TimecodeLutCache::findDefinition(kTimecode);
+    ASSERT_NE(nullptr, pDef);
+    expectSameLut(m_fresh, pDef);
+    EXPECT_FALSE(pDef->lut.external);
+    TimecodeLutCache::freeAll();
+    EXPECT_FALSE(pDef->lookup);
+
+    // Maps the cache file
+    pDef = TimecodeLutCache::findDefinition(kTimecode);
+    ASSERT_NE(nullptr, pDef);
+    expectSameLut(m_fresh, pDef);
+    EXPECT_TRUE(pDef->lut.external);
+    TimecodeLutCache::freeAll();
+
+    TimecodeLutCache::setCacheDirectory(QString());
+}
+
+}  // namespace
+
+#endif // __VINYLCONTROL__
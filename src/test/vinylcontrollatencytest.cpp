@@ -0,0 +1,300 @@
+// Measures how long a change of the record speed takes to reach the deck, the
+// end-to-end pitch response of vinyl control. Run it with
+//   mixxx-test --benchmark --benchmark_filter=BM_VinylControlPitchResponse
+// The Thread variants decode the timecode on the VinylControlProcessor thread,
+// the Callback variants in the engine callback. The label reports the mean
+// time from the speed step until [Channel1],vinylcontrol_rate has covered 90%
+// of the step.
+//
+// By default the input is a sine with the carrier frequency of the Serato
+// CV02 timecode, which carries the pitch but no position. To measure with a
+// recorded timecode instead, point MIXXX_VINYL_TIMECODE_WAV to a stereo
+// recording of a Serato CV02 side A record playing at 33 RPM.
+#ifdef __VINYLCONTROL__
+
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+#include <sndfile.h>
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include <QScopedPointer>
+#include <QtDebug>
+
+#include "control/controlobject.h"
+#include "test/mixxxtest.h"
+#include "util/math.h"
+#include "vinylcontrol/defs_vinylcontrol.h"
+#include "vinylcontrol/vinylcontrolprocessor.h"
+
+namespace {
+
+const int kSampleRate = 44100;
+// The carrier frequency of the Serato CV02 timecode at 33 RPM
+const double kCarrierHz = 1000.0;
+const double kSpeedStep = 1.08;
+const double kWarmUpSeconds = 1.0;
+const double kStepSeconds = 1.0;
+// The step counts as arrived when the rate has covered this much of it
+const double kResponseFraction = 0.9;
+
+// A looped stereo signal that is read at a variable speed
+class TimecodeSignal {
+  public:
+    TimecodeSignal()
+            : m_sampleRate(kSampleRate),
+              m_position(0.0) {
+        if (!loadWav(qgetenv("MIXXX_VINYL_TIMECODE_WAV"))) {
+            // One second holds a whole number of periods and loops seamlessly.
+            // The right channel trails the left one like a record playing
+            // forwards.
+            m_frames.resize(kSampleRate * 2);
+            for (int i = 0; i < kSampleRate; ++i) {
+                const double phase = 2 * M_PI * kCarrierHz * i / kSampleRate;
+                m_frames[i * 2] = static_cast<CSAMPLE>(0.5 * sin(phase));
+                m_frames[i * 2 + 1] = static_cast<CSAMPLE>(0.5 * cos(phase));
+            }
+        }
+    }
+
+    int sampleRate() const {
+        return m_sampleRate;
+    }
+
+    // Writes the next frames as if the record turned at speed, resampled
+    // linearly
+    void read(CSAMPLE* pBuffer, int frames, double speed) {
+        const int totalFrames = static_cast<int>(m_frames.size() / 2);
+        for (int i = 0; i < frames; ++i) {
+            const int frame = static_cast<int>(m_position);
+            const int next = (frame + 1) % totalFrames;
+            const CSAMPLE fraction = static_cast<CSAMPLE>(m_position - frame);
+            for (int channel = 0; channel < 2; ++channel) {
+                const CSAMPLE a = m_frames[frame * 2 + channel];
+                const CSAMPLE b = m_frames[next * 2 + channel];
+                pBuffer[i * 2 + channel] = a + (b - a) * fraction;
+            }
+            m_position = fmod(m_position + speed, totalFrames);
+        }
+    }
+
+  private:
+    bool loadWav(const QByteArray& path) {
+        if (path.isEmpty()) {
+            return false;
+        }
+        SF_INFO info;
+        memset(&info, 0, sizeof(info));
+        SNDFILE* pFile = sf_open(path.constData(), SFM_READ, &info);
+        if (pFile == nullptr) {
+            qWarning() << "Failed to open" << path << sf_strerror(nullptr);
+            return false;
+        }
+        if (info.channels != 2 || info.frames < 2) {
+            qWarning() << path << "is not a stereo recording";
+            sf_close(pFile);
+            return false;
+        }
+        m_frames.resize(info.frames * 2);
+        const sf_count_t framesRead =
+                sf_readf_float(pFile, m_frames.data(), info.frames);
+        sf_close(pFile);
+        if (framesRead < 2) {
+            return false;
+        }
+        m_frames.resize(framesRead * 2);
+        m_sampleRate = info.samplerate;
+        return true;
+    }
+
+    std::vector<CSAMPLE> m_frames;
+    int m_sampleRate;
+    double m_position;
+};
+
+class VinylControlLatencyTest : public MixxxTest {
+  public:
+    VinylControlLatencyTest()
+            : m_group(kVCGroup.arg(1)),
+              m_vinylInput(AudioInput::VINYLCONTROL, 0, 2, 0) {
+        createControl("vinylcontrol_rate", 0.0);
+        createControl("vinylcontrol_enabled", 1.0);
+        createControl("vinylcontrol_mode", MIXXX_VCMODE_RELATIVE);
+        createControl("play", 1.0);
+        createControl("playposition", 0.1);
+        createControl("duration", 300.0);
+        createControl("track_samplerate", kSampleRate);
+        createControl("track_samples", 300.0 * kSampleRate * 2);
+        createControl("rateRange", 0.08);
+        createControl("rate_dir", 1.0);
+
+        config()->set(ConfigKey(m_group, "vinylcontrol_vinyl_type"),
+                ConfigValue(MIXXX_VINYL_SERATOCV02VINYLSIDEA));
+        config()->set(ConfigKey(m_group, "vinylcontrol_speed_type"),
+                ConfigValue(MIXXX_VINYL_SPEED_33));
+        config()->set(ConfigKey(VINYL_PREF_KEY, "gain"), ConfigValue(1));
+    }
+
+    ~VinylControlLatencyTest() override {
+        qDeleteAll(m_controls);
+    }
+
+    void TestBody() override {}
+
+    // Creates the processor with the deck decoded in the engine callback or
+    // on the processor thread
+    void startProcessor(bool decodeInCallback, int sampleRate) {
+        config()->set(ConfigKey("[Soundcard]", "Samplerate"),
+                ConfigValue(sampleRate));
+        config()->set(ConfigKey(VINYL_PREF_KEY, "decode_in_callback_ch1"),
+                ConfigValue(decodeInCallback ? 1 : 0));
+        m_pProcessor.reset(new VinylControlProcessor(nullptr, config()));
+        m_pProcessor->onInputConfigured(m_vinylInput);
+    }
+
+    void stopProcessor() {
+        m_pProcessor.reset();
+    }
+
+    // Like the engine callback
+    void receiveBuffer(const CSAMPLE* pBuffer, unsigned int frames) {
+        m_pProcessor->receiveBuffer(m_vinylInput, pBuffer, frames);
+    }
+
+    double rate() const {
+        return ControlObject::get(ConfigKey(m_group, "vinylcontrol_rate"));
+    }
+
+  private:
+    void createControl(const char* item, double value) {
+        ControlObject* pControl = new ControlObject(ConfigKey(m_group, item));
+        pControl->set(value);
+        m_controls.append(pControl);
+    }
+
+    const QString m_group;
+    const AudioInput m_vinylInput;
+    QList<ControlObject*> m_controls;
+    QScopedPointer<VinylControlProcessor> m_pProcessor;
+};
+
+TEST_F(VinylControlLatencyTest, CallbackModeSetsRateWithinReceiveBuffer) {
+    TimecodeSignal signal;
+    startProcessor(true, signal.sampleRate());
+
+    const int kFrames = 512;
+    std::vector<CSAMPLE> buffer(kFrames * 2);
+    for (int i = 0; i < 50; ++i) {
+        signal.read(buffer.data(), kFrames, 1.0);
+        receiveBuffer(buffer.data(), kFrames);
+    }
+    EXPECT_NEAR(1.0, rate(), 0.01);
+
+    // Without a thread in between, the deck follows within a few buffers
+    for (int i = 0; i < 20; ++i) {
+        signal.read(buffer.data(), kFrames, kSpeedStep);
+        receiveBuffer(buffer.data(), kFrames);
+    }
+    EXPECT_NEAR(kSpeedStep, rate(), 0.01);
+
+    stopProcessor();
+}
+
+// Feeds buffers in real time like a sound card and returns the time from the
+// speed step until the rate of the deck has covered most of the step, or a
+// negative value if it never did.
+double measurePitchResponse(VinylControlLatencyTest* pTest,
+        TimecodeSignal* pSignal, int frames) {
+    typedef std::chrono::steady_clock Clock;
+    const auto bufferDuration = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(
+                    static_cast<double>(frames) / pSignal->sampleRate()));
+    const int warmUpBuffers = static_cast<int>(
+            kWarmUpSeconds * pSignal->sampleRate() / frames);
+    const int stepBuffers = static_cast<int>(
+            kStepSeconds * pSignal->sampleRate() / frames);
+
+    std::vector<CSAMPLE> buffer(frames * 2);
+    // The rate before the step, averaged since the speed of a recording
+    // is not exactly 1
+    double baseline = 0.0;
+    int baselineBuffers = 0;
+    double response = -1.0;
+    auto deadline = Clock::now();
+    for (int i = 0; i < warmUpBuffers + stepBuffers; ++i) {
+        const bool stepped = i >= warmUpBuffers;
+        pSignal->read(buffer.data(), frames, stepped ? kSpeedStep : 1.0);
+        pTest->receiveBuffer(buffer.data(), frames);
+        std::this_thread::sleep_until(deadline += bufferDuration);
+
+        // What the engine would read in the next callback
+        const double rate = pTest->rate();
+        if (!stepped) {
+            if (i >= warmUpBuffers / 2) {
+                baseline += rate;
+                ++baselineBuffers;
+            }
+        } else if (response < 0) {
+            const double target = baseline / baselineBuffers * kSpeedStep;
+            const double start = baseline / baselineBuffers;
+            if ((rate - start) >= kResponseFraction * (target - start)) {
+                response = (i - warmUpBuffers + 1) *
+                        static_cast<double>(frames) / pSignal->sampleRate();
+            }
+        }
+    }
+    return response;
+}
+
+void benchmarkPitchResponse(benchmark::State& state, bool decodeInCallback) {
+    VinylControlLatencyTest test;
+    TimecodeSignal signal;
+    const int frames = state.range_x();
+    test.startProcessor(decodeInCallback, signal.sampleRate());
+
+    double totalResponse = 0.0;
+    int responses = 0;
+    int misses = 0;
+    while (state.KeepRunning()) {
+        const double response =
+                measurePitchResponse(&test, &signal, frames);
+        if (response < 0) {
+            ++misses;
+        } else {
+            totalResponse += response;
+            ++responses;
+        }
+    }
+    test.stopProcessor();
+
+    QString label;
+    if (responses > 0) {
+        const double meanSeconds = totalResponse / responses;
+        label = QString("response %1 ms (%2 buffers)")
+                .arg(meanSeconds * 1000, 0, 'f', 1)
+                .arg(meanSeconds * signal.sampleRate() / frames, 0, 'f', 1);
+    }
+    if (misses > 0) {
+        label += QString(" missed %1").arg(misses);
+    }
+    state.SetLabel(label.trimmed().toStdString());
+}
+
+static void BM_VinylControlPitchResponse_Thread(benchmark::State& state) {
+    benchmarkPitchResponse(state, false);
+}
+BENCHMARK(BM_VinylControlPitchResponse_Thread)
+        ->Arg(64)->Arg(256)->Arg(1024)->UseRealTime();
+
+static void BM_VinylControlPitchResponse_Callback(benchmark::State& state) {
+    benchmarkPitchResponse(state, true);
+}
+BENCHMARK(BM_VinylControlPitchResponse_Callback)
+        ->Arg(64)->Arg(256)->Arg(1024)->UseRealTime();
+
+}  // namespace
+
+#endif // __VINYLCONTROL__
@@ -60,6 +60,7 @@ BeatGrid::BeatGrid(const BeatGrid& other)
           m_iSampleRate(other.m_iSampleRate),
           m_grid(other.m_grid),
           m_dBeatLength(other.m_dBeatLength) {
+    m_snapshot.setValue(other.m_snapshot.getValue());
     moveToThread(other.thread());
 }
 
@@ -73,6 +74,7 @@ void BeatGrid::setGrid(double dBpm, double dFirstBeatSample) {
     m_grid.mutable_first_beat()->set_frame_position(dFirstBeatSample / kFrameSize);
     // Calculate beat length as sample offsets
     m_dBeatLength = (60.0 * m_iSampleRate / dBpm) * kFrameSize;
+    publishSnapshot();
 }
 
 QByteArray BeatGrid::toByteArray() const {
@@ -93,6 +95,7 @@ void BeatGrid::readByteArray(const QByteArray& byteArray) {
     if (grid.ParseFromArray(byteArray.constData(), byteArray.length())) {
         m_grid = grid;
         m_dBeatLength = (60.0 * m_iSampleRate / bpm()) * kFrameSize;
+        publishSnapshot();
         return;
     }
 
@@ -133,6 +136,15 @@ bool BeatGrid::isValid() const {
     return m_iSampleRate > 0 && bpm() > 0;
 }
 
+// Must be called while holding m_mutex
+void BeatGrid::publishSnapshot() {
+    Snapshot snapshot;
+    snapshot.valid = isValid();
+    snapshot.firstBeatSample = firstBeatSample();
+    snapshot.beatLength = m_dBeatLength;
+    m_snapshot.setValue(snapshot);
+}
+
 // This could be implemented in the Beats Class itself.
 // If necessary, the child class can redefine it.
 double BeatGrid::findNextBeat(double dSamples) const {
@@ -147,13 +159,13 @@ double BeatGrid::findPrevBeat(double dSamples) const {
 
 // This is an internal call. This could be implemented in the Beats Class itself.
 double BeatGrid::findClosestBeat(double dSamples) const {
-    QMutexLocker locker(&m_mutex);
-    if (!isValid()) {
+    const Snapshot snapshot = m_snapshot.getValue();
+    if (!snapshot.valid) {
         return -1;
     }
     double prevBeat;
     double nextBeat;
-    findPrevNextBeats(dSamples, &prevBeat, &nextBeat);
+    snapshot.findPrevNextBeats(dSamples, &prevBeat, &nextBeat);
     if (prevBeat == -1) {
         // If both values are -1, we correctly return -1.
         return nextBeat;
@@ -164,12 +176,22 @@ double BeatGrid::findClosestBeat(double dSamples) const {
 }
 
 double BeatGrid::findNthBeat(double dSamples, int n) const {
-    QMutexLocker locker(&m_mutex);
-    if (!isValid() || n == 0) {
+    return m_snapshot.getValue().findNthBeat(dSamples, n);
+}
+
+bool BeatGrid::findPrevNextBeats(double dSamples,
+                                 double* dpPrevBeatSamples,
+                                 double* dpNextBeatSamples) const {
+    return m_snapshot.getValue().findPrevNextBeats(
+            dSamples, dpPrevBeatSamples, dpNextBeatSamples);
+}
+
+double BeatGrid::Snapshot::findNthBeat(double dSamples, int n) const {
+    if (!valid || n == 0) {
         return -1;
     }
 
-    double beatFraction = (dSamples - firstBeatSample()) / m_dBeatLength;
+    double beatFraction = (dSamples - firstBeatSample) / beatLength;
     double prevBeat = floor(beatFraction);
     double nextBeat = ceil(beatFraction);
 
@@ -197,39 +219,32 @@ double BeatGrid::findNthBeat(double dSamples, int n) const {
     if (n > 0) {
         // We're going forward, so use ceil to round up to the next multiple of
         // m_dBeatLength
-        dClosestBeat = nextBeat * m_dBeatLength + firstBeatSample();
+        dClosestBeat = nextBeat * beatLength + firstBeatSample;
         n = n - 1;
     } else {
         // We're going backward, so use floor to round down to the next multiple
         // of m_dBeatLength
-        dClosestBeat = prevBeat * m_dBeatLength + firstBeatSample();
+        dClosestBeat = prevBeat * beatLength + firstBeatSample;
         n = n + 1;
     }
 
-    double dResult = floor(dClosestBeat + n * m_dBeatLength);
+    double dResult = floor(dClosestBeat + n * beatLength);
     if (!even(static_cast<int>(dResult))) {
         dResult--;
     }
     return dResult;
 }
 
-bool BeatGrid::findPrevNextBeats(double dSamples,
-                                 double* dpPrevBeatSamples,
-                                 double* dpNextBeatSamples) const {
-    double dFirstBeatSample;
-    double dBeatLength;
-    {
-        QMutexLocker locker(&m_mutex);
-        if (!isValid()) {
-            *dpPrevBeatSamples = -1.0;
-            *dpNextBeatSamples = -1.0;
-            return false;
-        }
-        dFirstBeatSample = firstBeatSample();
-        dBeatLength = m_dBeatLength;
+bool BeatGrid::Snapshot::findPrevNextBeats(double dSamples,
+                                           double* dpPrevBeatSamples,
+                                           double* dpNextBeatSamples) const {
+    if (!valid) {
+        *dpPrevBeatSamples = -1.0;
+        *dpNextBeatSamples = -1.0;
+        return false;
     }
 
-    double beatFraction = (dSamples - dFirstBeatSample) / dBeatLength;
+    double beatFraction = (dSamples - firstBeatSample) / beatLength;
     double prevBeat = floor(beatFraction);
     double nextBeat = ceil(beatFraction);
 
@@ -246,8 +261,8 @@ bool BeatGrid::findPrevNextBeats(double dSamples,
         // And nextBeat needs to be incremented.
         ++nextBeat;
     }
-    *dpPrevBeatSamples = floor(prevBeat * dBeatLength + dFirstBeatSample);
-    *dpNextBeatSamples = floor(nextBeat * dBeatLength + dFirstBeatSample);
+    *dpPrevBeatSamples = floor(prevBeat * beatLength + firstBeatSample);
+    *dpNextBeatSamples = floor(nextBeat * beatLength + firstBeatSample);
     if (!even(static_cast<int>(*dpPrevBeatSamples))) {
         --*dpPrevBeatSamples;
     }
@@ -337,6 +352,7 @@ void BeatGrid::translate(double dNumSamples) {
     }
     double newFirstBeatFrames = (firstBeatSample() + dNumSamples) / kFrameSize;
     m_grid.mutable_first_beat()->set_frame_position(newFirstBeatFrames);
+    publishSnapshot();
     locker.unlock();
     emit(updated());
 }
@@ -377,6 +393,7 @@ void BeatGrid::setBpm(double dBpm) {
     }
     m_grid.mutable_bpm()->set_bpm(dBpm);
     m_dBeatLength = (60.0 * m_iSampleRate / dBpm) * kFrameSize;
+    publishSnapshot();
     locker.unlock();
     emit(updated());
 }
@@ -3,6 +3,7 @@
 
 #include <QMutex>
 
+#include "control/controlvalue.h"
 #include "track/track.h"
 #include "track/beats.h"
 #include "proto/beats.pb.h"
@@ -72,7 +73,21 @@ class BeatGrid final : public Beats {
     virtual void setBpm(double dBpm);
 
   private:
+    // The grid parameters needed to locate beats. A copy is published on
+    // every change of the grid so that lookups don't lock m_mutex.
+    struct Snapshot {
+        double findNthBeat(double dSamples, int n) const;
+        bool findPrevNextBeats(double dSamples,
+                               double* dpPrevBeatSamples,
+                               double* dpNextBeatSamples) const;
+
+        bool valid = false;
+        double firstBeatSample = 0.0;
+        double beatLength = 0.0;
+    };
+
     BeatGrid(const BeatGrid& other);
+    void publishSnapshot();
     double firstBeatSample() const;
     double bpm() const;
 
@@ -89,6 +104,7 @@ class BeatGrid final : public Beats {
     mixxx::track::io::BeatGrid m_grid;
     // The length of a beat in samples
     double m_dBeatLength;
+    ControlValueAtomic<Snapshot> m_snapshot;
 };
 
 
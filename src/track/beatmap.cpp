@@ -5,6 +5,8 @@
  *      Author: vittorio
  */
 
+#include <algorithm>
+
 #include <QtDebug>
 #include <QtGlobal>
 #include <QMutexLocker>
@@ -58,6 +60,152 @@ class BeatMapIterator : public BeatIterator {
     BeatList::const_iterator m_endBeat;
 };
 
+BeatMapSnapshot::BeatMapSnapshot(const BeatList& beats, SINT iSampleRate)
+        : m_iSampleRate(iSampleRate) {
+    m_framePositions.reserve(beats.size());
+    for (int i = 0; i < beats.size(); ++i) {
+        const Beat& beat = beats.at(i);
+        m_framePositions.push_back(beat.frame_position());
+        if (!beat.enabled() && m_disabled.empty()) {
+            m_disabled.resize(beats.size(), false);
+        }
+        if (!m_disabled.empty()) {
+            m_disabled[i] = !beat.enabled();
+        }
+    }
+}
+
+void BeatMapSnapshot::locate(double dSamples,
+        int* pOnBeat, int* pPrevBeat, int* pNextBeat) const {
+    // Reduce sample offset to a frame offset.
+    const double frame = samplesToFrames(dSamples);
+
+    // Points at the first occurrence of frame or the next largest beat
+    int i = static_cast<int>(std::lower_bound(m_framePositions.begin(),
+            m_framePositions.end(), frame) - m_framePositions.begin());
+
+    // If the position is within 1/10th of a second of the next or previous
+    // beat, pretend we are on that beat.
+    const double kFrameEpsilon = 0.1 * m_iSampleRate;
+
+    // Back-up by one.
+    if (i > 0) {
+        --i;
+    }
+
+    // Scan forward to find whether we are on a beat.
+    *pOnBeat = -1;
+    *pPrevBeat = -1;
+    *pNextBeat = -1;
+    const int size = static_cast<int>(m_framePositions.size());
+    for (; i < size; ++i) {
+        const double delta = m_framePositions[i] - frame;
+
+        // We are "on" this beat.
+        if (fabs(delta) < kFrameEpsilon) {
+            *pOnBeat = i;
+            break;
+        }
+
+        if (delta < 0) {
+            // If we are not on the beat and delta < 0 then this beat comes
+            // before our current position.
+            *pPrevBeat = i;
+        } else {
+            // If we are past the beat and we aren't on it then this beat comes
+            // after our current position.
+            *pNextBeat = i;
+            // Stop because we have everything we need now.
+            break;
+        }
+    }
+}
+
+double BeatMapSnapshot::findNthBeat(double dSamples, int n) const {
+    if (!isValid() || n == 0) {
+        return -1;
+    }
+
+    int onBeat;
+    int prevBeat;
+    int nextBeat;
+    locate(dSamples, &onBeat, &prevBeat, &nextBeat);
+
+    // If we are within epsilon samples of a beat then the immediately next and
+    // previous beats are the beat we are on.
+    if (onBeat != -1) {
+        nextBeat = onBeat;
+        prevBeat = onBeat;
+    }
+
+    if (n > 0 && nextBeat != -1) {
+        const int size = static_cast<int>(m_framePositions.size());
+        for (; nextBeat < size; ++nextBeat) {
+            if (!isEnabled(nextBeat)) {
+                continue;
+            }
+            if (n == 1) {
+                // Return a sample offset
+                return framesToSamples(m_framePositions[nextBeat]);
+            }
+            --n;
+        }
+    } else if (n < 0 && prevBeat != -1) {
+        for (; prevBeat >= 0; --prevBeat) {
+            if (!isEnabled(prevBeat)) {
+                continue;
+            }
+            if (n == -1) {
+                // Return a sample offset
+                return framesToSamples(m_framePositions[prevBeat]);
+            }
+            ++n;
+        }
+    }
+    return -1;
+}
+
+bool BeatMapSnapshot::findPrevNextBeats(double dSamples,
+                                        double* dpPrevBeatSamples,
+                                        double* dpNextBeatSamples) const {
+    *dpPrevBeatSamples = -1;
+    *dpNextBeatSamples = -1;
+    if (!isValid()) {
+        return false;
+    }
+
+    int onBeat;
+    int prevBeat;
+    int nextBeat;
+    locate(dSamples, &onBeat, &prevBeat, &nextBeat);
+
+    // If we are within epsilon samples of a beat then the previous beat is
+    // the beat we are on.
+    const int size = static_cast<int>(m_framePositions.size());
+    if (onBeat != -1) {
+        prevBeat = onBeat;
+        nextBeat = onBeat + 1 < size ? onBeat + 1 : -1;
+    }
+
+    if (nextBeat != -1) {
+        for (; nextBeat < size; ++nextBeat) {
+            if (isEnabled(nextBeat)) {
+                *dpNextBeatSamples = framesToSamples(m_framePositions[nextBeat]);
+                break;
+            }
+        }
+    }
+    if (prevBeat != -1) {
+        for (; prevBeat >= 0; --prevBeat) {
+            if (isEnabled(prevBeat)) {
+                *dpPrevBeatSamples = framesToSamples(m_framePositions[prevBeat]);
+                break;
+            }
+        }
+    }
+    return *dpPrevBeatSamples != -1 && *dpNextBeatSamples != -1;
+}
+
 BeatMap::BeatMap(const Track& track, SINT iSampleRate)
         : m_mutex(QMutex::Recursive),
           m_iSampleRate(iSampleRate > 0 ? iSampleRate : track.getSampleRate()),
@@ -89,6 +237,11 @@ BeatMap::BeatMap (const BeatMap& other)
           m_dCachedBpm(other.m_dCachedBpm),
           m_dLastFrame(other.m_dLastFrame),
           m_beats(other.m_beats) {
+    // Snapshots are immutable and can be shared
+    const BeatMapSnapshotPointer pSnapshot = other.getSnapshot();
+    if (pSnapshot) {
+        publishSnapshot(pSnapshot);
+    }
     moveToThread(other.thread());
 }
 
@@ -177,13 +330,13 @@ double BeatMap::findPrevBeat(double dSamples) const {
 }
 
 double BeatMap::findClosestBeat(double dSamples) const {
-    QMutexLocker locker(&m_mutex);
-    if (!isValid()) {
+    const BeatMapSnapshotPointer pSnapshot = getSnapshot();
+    if (!pSnapshot || !pSnapshot->isValid()) {
         return -1;
     }
     double prevBeat;
     double nextBeat;
-    findPrevNextBeats(dSamples, &prevBeat, &nextBeat);
+    pSnapshot->findPrevNextBeats(dSamples, &prevBeat, &nextBeat);
     if (prevBeat == -1) {
         // If both values are -1, we correctly return -1.
         return nextBeat;
@@ -194,177 +347,24 @@ double BeatMap::findClosestBeat(double dSamples) const {
 }
 
 double BeatMap::findNthBeat(double dSamples, int n) const {
-    QMutexLocker locker(&m_mutex);
-
-    if (!isValid() || n == 0) {
+    const BeatMapSnapshotPointer pSnapshot = getSnapshot();
+    if (!pSnapshot) {
         return -1;
     }
-
-    Beat beat;
-    // Reduce sample offset to a frame offset.
-    beat.set_frame_position(samplesToFrames(dSamples));
-
-    // it points at the first occurrence of beat or the next largest beat
-    BeatList::const_iterator it =
-            qLowerBound(m_beats.constBegin(), m_beats.constEnd(), beat, BeatLessThan);
-
-    // If the position is within 1/10th of a second of the next or previous
-    // beat, pretend we are on that beat.
-    const double kFrameEpsilon = 0.1 * m_iSampleRate;
-
-    // Back-up by one.
-    if (it != m_beats.begin()) {
-        --it;
-    }
-
-    // Scan forward to find whether we are on a beat.
-    BeatList::const_iterator on_beat = m_beats.constEnd();
-    BeatList::const_iterator previous_beat = m_beats.constEnd();
-    BeatList::const_iterator next_beat = m_beats.constEnd();
-    for (; it != m_beats.end(); ++it) {
-        qint32 delta = it->frame_position() - beat.frame_position();
-
-        // We are "on" this beat.
-        if (abs(delta) < kFrameEpsilon) {
-            on_beat = it;
-            break;
-        }
-
-        if (delta < 0) {
-            // If we are not on the beat and delta < 0 then this beat comes
-            // before our current position.
-            previous_beat = it;
-        } else {
-            // If we are past the beat and we aren't on it then this beat comes
-            // after our current position.
-            next_beat = it;
-            // Stop because we have everything we need now.
-            break;
-        }
-    }
-
-    // If we are within epsilon samples of a beat then the immediately next and
-    // previous beats are the beat we are on.
-    if (on_beat != m_beats.end()) {
-        next_beat = on_beat;
-        previous_beat = on_beat;
-    }
-
-    if (n > 0) {
-        for (; next_beat != m_beats.end(); ++next_beat) {
-            if (!next_beat->enabled()) {
-                continue;
-            }
-            if (n == 1) {
-                // Return a sample offset
-                return framesToSamples(next_beat->frame_position());
-            }
-            --n;
-        }
-    } else if (n < 0 && previous_beat != m_beats.end()) {
-        for (; true; --previous_beat) {
-            if (previous_beat->enabled()) {
-                if (n == -1) {
-                    // Return a sample offset
-                    return framesToSamples(previous_beat->frame_position());
-                }
-                ++n;
-            }
-
-            // Don't step before the start of the list.
-            if (previous_beat == m_beats.begin()) {
-                break;
-            }
-        }
-    }
-    return -1;
+    return pSnapshot->findNthBeat(dSamples, n);
 }
 
 bool BeatMap::findPrevNextBeats(double dSamples,
                                 double* dpPrevBeatSamples,
                                 double* dpNextBeatSamples) const {
-    QMutexLocker locker(&m_mutex);
-
-    if (!isValid()) {
+    const BeatMapSnapshotPointer pSnapshot = getSnapshot();
+    if (!pSnapshot) {
         *dpPrevBeatSamples = -1;
         *dpNextBeatSamples = -1;
         return false;
     }
-
-    Beat beat;
-    // Reduce sample offset to a frame offset.
-    beat.set_frame_position(samplesToFrames(dSamples));
-
-    // it points at the first occurrence of beat or the next largest beat
-    BeatList::const_iterator it =
-            qLowerBound(m_beats.constBegin(), m_beats.constEnd(), beat, BeatLessThan);
-
-    // If the position is within 1/10th of a second of the next or previous
-    // beat, pretend we are on that beat.
-    const double kFrameEpsilon = 0.1 * m_iSampleRate;
-
-    // Back-up by one.
-    if (it != m_beats.begin()) {
-        --it;
-    }
-
-    // Scan forward to find whether we are on a beat.
-    BeatList::const_iterator on_beat = m_beats.constEnd();
-    BeatList::const_iterator previous_beat = m_beats.constEnd();
-    BeatList::const_iterator next_beat = m_beats.constEnd();
-    for (; it != m_beats.end(); ++it) {
-        qint32 delta = it->frame_position() - beat.frame_position();
-
-        // We are "on" this beat.
-        if (abs(delta) < kFrameEpsilon) {
-            on_beat = it;
-            break;
-        }
-
-        if (delta < 0) {
-            // If we are not on the beat and delta < 0 then this beat comes
-            // before our current position.
-            previous_beat = it;
-        } else {
-            // If we are past the beat and we aren't on it then this beat comes
-            // after our current position.
-            next_beat = it;
-            // Stop because we have everything we need now.
-            break;
-        }
-    }
-
-    // If we are within epsilon samples of a beat then the immediately next and
-    // previous beats are the beat we are on.
-    if (on_beat != m_beats.end()) {
-        previous_beat = on_beat;
-        next_beat = on_beat + 1;
-    }
-
-    *dpPrevBeatSamples = -1;
-    *dpNextBeatSamples = -1;
-
-    for (; next_beat != m_beats.end(); ++next_beat) {
-        if (!next_beat->enabled()) {
-            continue;
-        }
-        *dpNextBeatSamples = framesToSamples(next_beat->frame_position());
-        break;
-    }
-    if (previous_beat != m_beats.end()) {
-        for (; true; --previous_beat) {
-            if (previous_beat->enabled()) {
-                *dpPrevBeatSamples = framesToSamples(previous_beat->frame_position());
-                break;
-            }
-
-            // Don't step before the start of the list.
-            if (previous_beat == m_beats.begin()) {
-                break;
-            }
-        }
-    }
-    return *dpPrevBeatSamples != -1 && *dpNextBeatSamples != -1;
+    return pSnapshot->findPrevNextBeats(
+            dSamples, dpPrevBeatSamples, dpNextBeatSamples);
 }
 
 std::unique_ptr<BeatIterator> BeatMap::findBeats(double startSample, double stopSample) const {
@@ -714,7 +714,25 @@ void BeatMap::setBpm(double dBpm) {
      */
 }
 
+void BeatMap::publishSnapshot(const BeatMapSnapshotPointer& pSnapshot) {
+    m_publishedSnapshots.push_back(pSnapshot);
+    m_snapshot.setValue(pSnapshot);
+    // Release the retired snapshots that are only referenced by this list.
+    // Neither the ring buffer of m_snapshot nor any reader holds a copy of
+    // them, so no reader can obtain a new reference concurrently.
+    m_publishedSnapshots.erase(
+            std::remove_if(
+                    m_publishedSnapshots.begin(),
+                    m_publishedSnapshots.end(),
+                    [](const BeatMapSnapshotPointer& pRetired) {
+                        return pRetired.use_count() == 1;
+                    }),
+            m_publishedSnapshots.end());
+}
+
 void BeatMap::onBeatlistChanged() {
+    publishSnapshot(std::make_shared<const BeatMapSnapshot>(
+            m_beats, m_iSampleRate));
     if (!isValid()) {
         m_dLastFrame = 0;
         m_dCachedBpm = 0;
@@ -8,8 +8,12 @@
 #ifndef BEATMAP_H_
 #define BEATMAP_H_
 
+#include <memory>
+#include <vector>
+
 #include <QMutex>
 
+#include "control/controlvalue.h"
 #include "track/track.h"
 #include "track/beats.h"
 #include "proto/beats.pb.h"
@@ -18,6 +22,41 @@
 
 typedef QList<mixxx::track::io::Beat> BeatList;
 
+// Immutable copy of the beat positions of a BeatMap in a contiguous array.
+// A new snapshot is published whenever the beat list changes, so lookups
+// only need to search the current snapshot and never wait for the mutex
+// that protects the beat list while it is edited.
+class BeatMapSnapshot {
+  public:
+    BeatMapSnapshot(const BeatList& beats, SINT iSampleRate);
+
+    bool isValid() const {
+        return m_iSampleRate > 0 && !m_framePositions.empty();
+    }
+
+    double findNthBeat(double dSamples, int n) const;
+    bool findPrevNextBeats(double dSamples,
+                           double* dpPrevBeatSamples,
+                           double* dpNextBeatSamples) const;
+
+  private:
+    bool isEnabled(int index) const {
+        return m_disabled.empty() || !m_disabled[index];
+    }
+    // Finds the beat we are on or, if we are not within the epsilon of a
+    // beat, the beats immediately before and after dSamples. Indices are
+    // -1 if there is no such beat.
+    void locate(double dSamples, int* pOnBeat, int* pPrevBeat, int* pNextBeat) const;
+
+    const SINT m_iSampleRate;
+    // Frame positions of all beats in ascending order
+    std::vector<double> m_framePositions;
+    // Empty if all beats are enabled, which is the common case
+    std::vector<bool> m_disabled;
+};
+
+typedef std::shared_ptr<const BeatMapSnapshot> BeatMapSnapshotPointer;
+
 class BeatMap final : public Beats {
   public:
     // Construct a BeatMap. iSampleRate may be provided if a more accurate
@@ -85,6 +124,10 @@ class BeatMap final : public Beats {
     bool readByteArray(const QByteArray& byteArray);
     void createFromBeatVector(const QVector<double>& beats);
     void onBeatlistChanged();
+    void publishSnapshot(const BeatMapSnapshotPointer& pSnapshot);
+    BeatMapSnapshotPointer getSnapshot() const {
+        return m_snapshot.getValue();
+    }
 
     double calculateBpm(const mixxx::track::io::Beat& startBeat,
                         const mixxx::track::io::Beat& stopBeat) const;
@@ -104,6 +147,13 @@ class BeatMap final : public Beats {
     double m_dCachedBpm;
     double m_dLastFrame;
     BeatList m_beats;
+    // Published by onBeatlistChanged(), read without locking m_mutex
+    ControlValueAtomic<BeatMapSnapshotPointer> m_snapshot;
+    // Owns every published snapshot until no reader holds a copy anymore.
+    // Readers like the engine must never drop the last reference, because
+    // freeing the snapshot there would deallocate on the audio thread.
+    // Only accessed by writers while holding m_mutex.
+    std::vector<BeatMapSnapshotPointer> m_publishedSnapshots;
 };
 
 #endif /* BEATMAP_H_ */
@@ -17,6 +17,7 @@ CmdlineArgs::CmdlineArgs()
       m_settingsPathSet(false),
       m_logLevel(mixxx::kLogLevelDefault),
       m_logFlushLevel(mixxx::kLogFlushLevelDefault),
+      m_renderSeconds(0.0),
 // We are not ready to switch to XDG folders under Linux, so keeping $HOME/.mixxx as preferences folder. see lp:1463273
 #ifdef __LINUX__
     m_settingsPath(QDir::homePath().append("/").append(SETTINGS_PATH)) {
@@ -58,6 +59,12 @@ bool CmdlineArgs::Parse(int &argc, char **argv) {
         } else if (argv[i] == QString("--timelinePath") && i+1 < argc) {
             m_timelinePath = QString::fromLocal8Bit(argv[i+1]);
             i++;
+        } else if (argv[i] == QString("--renderTo") && i+1 < argc) {
+            m_renderPath = QString::fromLocal8Bit(argv[i+1]);
+            i++;
+        } else if (argv[i] == QString("--renderDuration") && i+1 < argc) {
+            m_renderSeconds = QString::fromLocal8Bit(argv[i+1]).toDouble();
+            i++;
         } else if (argv[i] == QString("--logLevel") && i+1 < argc) {
             logLevelSet = true;
             auto level = QLatin1String(argv[i+1]);
@@ -166,6 +173,19 @@ void CmdlineArgs::printUsage() {
 --logFlushLevel LEVEL   Sets the the logging level at which the log buffer\n\
                         is flushed to mixxx.log. LEVEL is one of the values\n\
                         defined at --logLevel above.\n\
+\n\
+--renderTo FILE         Renders the master output faster than real-time\n\
+                        into FILE instead of opening the sound devices.\n\
+                        The file extension selects the encoder. All decks\n\
+                        with a track from the command line start playing\n\
+                        once loaded. Rendering stops when none of them is\n\
+                        playing anymore. Mixxx quits after rendering has\n\
+                        finished. The main window is not shown, but\n\
+                        Mixxx still initializes its GUI and therefore\n\
+                        needs a display.\n\
+\n\
+--renderDuration SECS   Stops rendering after SECS seconds of audio\n\
+                        instead.\n\
 \n"
 #ifdef MIXXX_BUILD_DEBUG
 "\
@@ -37,6 +37,9 @@ class CmdlineArgs final {
     const QString& getResourcePath() const { return m_resourcePath; }
     const QString& getPluginPath() const { return m_pluginPath; }
     const QString& getTimelinePath() const { return m_timelinePath; }
+    bool getOfflineRenderingEnabled() const { return !m_renderPath.isEmpty(); }
+    const QString& getRenderPath() const { return m_renderPath; }
+    double getRenderSeconds() const { return m_renderSeconds; }
 
   private:
     CmdlineArgs();
@@ -55,6 +58,8 @@ class CmdlineArgs final {
     QString m_resourcePath;
     QString m_pluginPath;
     QString m_timelinePath;
+    QString m_renderPath;
+    double m_renderSeconds;
 };
 
 #endif /* CMDLINEARGS_H */
@@ -0,0 +1,417 @@
+#include "util/compressedbitmap.h"
+
+#include <algorithm>
+#include <bitset>
+#include <iterator>
+
+#include "util/assert.h"
+
+namespace mixxx {
+
+namespace {
+
+inline quint16 highBits(quint32 value) {
+    return static_cast<quint16>(value >> 16);
+}
+
+inline quint16 lowBits(quint32 value) {
+    return static_cast<quint16>(value & 0xFFFF);
+}
+
+} // anonymous namespace
+
+//static
+int CompressedBitmap::lowestBit(quint64 word) {
+    DEBUG_ASSERT(word != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while ((word & 1) == 0) {
+        word >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+//static
+int CompressedBitmap::popCount(quint64 word) {
+    return static_cast<int>(std::bitset<64>(word).count());
+}
+
+bool CompressedBitmap::Container::contains(quint16 low) const {
+    if (isBitset()) {
+        return (bits[low / 64] >> (low % 64)) & 1;
+    } else {
+        return std::binary_search(array.begin(), array.end(), low);
+    }
+}
+
+//static
+void CompressedBitmap::toBitset(Container* pContainer) {
+    if (pContainer->isBitset()) {
+        return;
+    }
+    pContainer->bits.assign(kBitsetWords, 0);
+    for (quint16 low : pContainer->array) {
+        pContainer->bits[low / 64] |= quint64(1) << (low % 64);
+    }
+    pContainer->array.clear();
+    pContainer->array.shrink_to_fit();
+}
+
+//static
+void CompressedBitmap::normalize(Container* pContainer) {
+    if (pContainer->isBitset()) {
+        if (pContainer->cardinality > kMaxArraySize) {
+            return;
+        }
+        pContainer->array.reserve(pContainer->cardinality);
+        for (int i = 0; i < kBitsetWords; ++i) {
+            quint64 word = pContainer->bits[i];
+            while (word != 0) {
+                pContainer->array.push_back(
+                        static_cast<quint16>(i * 64 + lowestBit(word)));
+                word &= word - 1;
+            }
+        }
+        pContainer->bits.clear();
+        pContainer->bits.shrink_to_fit();
+    } else if (pContainer->cardinality > kMaxArraySize) {
+        toBitset(pContainer);
+    }
+}
+
+std::vector<CompressedBitmap::Container>::iterator
+CompressedBitmap::findContainer(quint16 key) {
+    return std::lower_bound(m_containers.begin(), m_containers.end(), key,
+            [](const Container& container, quint16 key) {
+                return container.key < key;
+            });
+}
+
+std::vector<CompressedBitmap::Container>::const_iterator
+CompressedBitmap::findContainer(quint16 key) const {
+    return std::lower_bound(m_containers.begin(), m_containers.end(), key,
+            [](const Container& container, quint16 key) {
+                return container.key < key;
+            });
+}
+
+//static
+CompressedBitmap CompressedBitmap::fromSorted(const std::vector<quint32>& values) {
+    DEBUG_ASSERT(std::is_sorted(values.begin(), values.end()));
+    CompressedBitmap bitmap;
+    for (quint32 value : values) {
+        const quint16 key = highBits(value);
+        if (bitmap.m_containers.empty() || bitmap.m_containers.back().key != key) {
+            if (!bitmap.m_containers.empty()) {
+                normalize(&bitmap.m_containers.back());
+            }
+            bitmap.m_containers.emplace_back();
+            bitmap.m_containers.back().key = key;
+            bitmap.m_containers.back().cardinality = 0;
+        }
+        Container& container = bitmap.m_containers.back();
+        const quint16 low = lowBits(value);
+        if (!container.array.empty() && container.array.back() == low) {
+            continue; // duplicate
+        }
+        container.array.push_back(low);
+        ++container.cardinality;
+    }
+    if (!bitmap.m_containers.empty()) {
+        normalize(&bitmap.m_containers.back());
+    }
+    return bitmap;
+}
+
+int CompressedBitmap::cardinality() const {
+    int cardinality = 0;
+    for (const auto& container : m_containers) {
+        cardinality += container.cardinality;
+    }
+    return cardinality;
+}
+
+bool CompressedBitmap::contains(quint32 value) const {
+    const auto i = findContainer(highBits(value));
+    if (i == m_containers.end() || i->key != highBits(value)) {
+        return false;
+    }
+    return i->contains(lowBits(value));
+}
+
+bool CompressedBitmap::insert(quint32 value) {
+    const quint16 key = highBits(value);
+    const quint16 low = lowBits(value);
+    auto i = findContainer(key);
+    if (i == m_containers.end() || i->key != key) {
+        i = m_containers.insert(i, Container());
+        i->key = key;
+        i->cardinality = 0;
+    }
+    if (i->isBitset()) {
+        quint64& word = i->bits[low / 64];
+        const quint64 mask = quint64(1) << (low % 64);
+        if (word & mask) {
+            return false;
+        }
+        word |= mask;
+    } else {
+        const auto j = std::lower_bound(i->array.begin(), i->array.end(), low);
+        if (j != i->array.end() && *j == low) {
+            return false;
+        }
+        i->array.insert(j, low);
+    }
+    ++i->cardinality;
+    normalize(&(*i));
+    return true;
+}
+
+bool CompressedBitmap::remove(quint32 value) {
+    const quint16 key = highBits(value);
+    const quint16 low = lowBits(value);
+    const auto i = findContainer(key);
+    if (i == m_containers.end() || i->key != key) {
+        return false;
+    }
+    if (i->isBitset()) {
+        quint64& word = i->bits[low / 64];
+        const quint64 mask = quint64(1) << (low % 64);
+        if (!(word & mask)) {
+            return false;
+        }
+        word &= ~mask;
+    } else {
+        const auto j = std::lower_bound(i->array.begin(), i->array.end(), low);
+        if (j == i->array.end() || *j != low) {
+            return false;
+        }
+        i->array.erase(j);
+    }
+    if (--i->cardinality == 0) {
+        m_containers.erase(i);
+    } else {
+        normalize(&(*i));
+    }
+    return true;
+}
+
+//static
+void CompressedBitmap::unite(Container* pTarget, const Container& source) {
+    if (!pTarget->isBitset() && !source.isBitset()) {
+        std::vector<quint16> merged;
+        merged.reserve(pTarget->array.size() + source.array.size());
+        std::set_union(
+                pTarget->array.begin(), pTarget->array.end(),
+                source.array.begin(), source.array.end(),
+                std::back_inserter(merged));
+        pTarget->array.swap(merged);
+        pTarget->cardinality = static_cast<int>(pTarget->array.size());
+    } else {
+        toBitset(pTarget);
+        if (source.isBitset()) {
+            for (int i = 0; i < kBitsetWords; ++i) {
+                pTarget->bits[i] |= source.bits[i];
+            }
+        } else {
+            for (quint16 low : source.array) {
+                pTarget->bits[low / 64] |= quint64(1) << (low % 64);
+            }
+        }
+        int cardinality = 0;
+        for (quint64 word : pTarget->bits) {
+            cardinality += popCount(word);
+        }
+        pTarget->cardinality = cardinality;
+    }
+    normalize(pTarget);
+}
+
+//static
+void CompressedBitmap::intersect(Container* pTarget, const Container& source) {
+    if (!pTarget->isBitset()) {
+        std::vector<quint16> intersection;
+        if (source.isBitset()) {
+            for (quint16 low : pTarget->array) {
+                if (source.contains(low)) {
+                    intersection.push_back(low);
+                }
+            }
+        } else {
+            std::set_intersection(
+                    pTarget->array.begin(), pTarget->array.end(),
+                    source.array.begin(), source.array.end(),
+                    std::back_inserter(intersection));
+        }
+        pTarget->array.swap(intersection);
+        pTarget->cardinality = static_cast<int>(pTarget->array.size());
+    } else if (!source.isBitset()) {
+        // The result is at most as large as the source array
+        std::vector<quint16> intersection;
+        for (quint16 low : source.array) {
+            if (pTarget->contains(low)) {
+                intersection.push_back(low);
+            }
+        }
+        pTarget->bits.clear();
+        pTarget->bits.shrink_to_fit();
+        pTarget->array.swap(intersection);
+        pTarget->cardinality = static_cast<int>(pTarget->array.size());
+    } else {
+        int cardinality = 0;
+        for (int i = 0; i < kBitsetWords; ++i) {
+            pTarget->bits[i] &= source.bits[i];
+            cardinality += popCount(pTarget->bits[i]);
+        }
+        pTarget->cardinality = cardinality;
+    }
+    normalize(pTarget);
+}
+
+//static
+void CompressedBitmap::subtract(Container* pTarget, const Container& source) {
+    if (!pTarget->isBitset()) {
+        std::vector<quint16> difference;
+        if (source.isBitset()) {
+            for (quint16 low : pTarget->array) {
+                if (!source.contains(low)) {
+                    difference.push_back(low);
+                }
+            }
+        } else {
+            std::set_difference(
+                    pTarget->array.begin(), pTarget->array.end(),
+                    source.array.begin(), source.array.end(),
+                    std::back_inserter(difference));
+        }
+        pTarget->array.swap(difference);
+        pTarget->cardinality = static_cast<int>(pTarget->array.size());
+    } else {
+        if (source.isBitset()) {
+            for (int i = 0; i < kBitsetWords; ++i) {
+                pTarget->bits[i] &= ~source.bits[i];
+            }
+        } else {
+            for (quint16 low : source.array) {
+                pTarget->bits[low / 64] &= ~(quint64(1) << (low % 64));
+            }
+        }
+        int cardinality = 0;
+        for (quint64 word : pTarget->bits) {
+            cardinality += popCount(word);
+        }
+        pTarget->cardinality = cardinality;
+    }
+    normalize(pTarget);
+}
+
+CompressedBitmap& CompressedBitmap::operator|=(const CompressedBitmap& other) {
+    std::vector<Container> containers;
+    containers.reserve(m_containers.size() + other.m_containers.size());
+    auto i = m_containers.begin();
+    auto j = other.m_containers.begin();
+    while (i != m_containers.end() || j != other.m_containers.end()) {
+        if (j == other.m_containers.end() ||
+                (i != m_containers.end() && i->key < j->key)) {
+            containers.push_back(std::move(*i++));
+        } else if (i == m_containers.end() || j->key < i->key) {
+            containers.push_back(*j++);
+        } else {
+            unite(&(*i), *j++);
+            containers.push_back(std::move(*i++));
+        }
+    }
+    m_containers.swap(containers);
+    return *this;
+}
+
+CompressedBitmap& CompressedBitmap::operator&=(const CompressedBitmap& other) {
+    auto out = m_containers.begin();
+    auto j = other.m_containers.begin();
+    for (auto i = m_containers.begin(); i != m_containers.end(); ++i) {
+        while (j != other.m_containers.end() && j->key < i->key) {
+            ++j;
+        }
+        if (j == other.m_containers.end()) {
+            break;
+        }
+        if (j->key != i->key) {
+            continue;
+        }
+        intersect(&(*i), *j);
+        if (i->cardinality > 0) {
+            if (out != i) {
+                *out = std::move(*i);
+            }
+            ++out;
+        }
+    }
+    m_containers.erase(out, m_containers.end());
+    return *this;
+}
+
+CompressedBitmap& CompressedBitmap::operator-=(const CompressedBitmap& other) {
+    auto out = m_containers.begin();
+    auto j = other.m_containers.begin();
+    for (auto i = m_containers.begin(); i != m_containers.end(); ++i) {
+        while (j != other.m_containers.end() && j->key < i->key) {
+            ++j;
+        }
+        if (j != other.m_containers.end() && j->key == i->key) {
+            subtract(&(*i), *j);
+        }
+        if (i->cardinality > 0) {
+            if (out != i) {
+                *out = std::move(*i);
+            }
+            ++out;
+        }
+    }
+    m_containers.erase(out, m_containers.end());
+    return *this;
+}
+
+bool operator==(const CompressedBitmap& lhs, const CompressedBitmap& rhs) {
+    if (lhs.m_containers.size() != rhs.m_containers.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.m_containers.size(); ++i) {
+        // Both representations are normalized by cardinality
+        const auto& lhsContainer = lhs.m_containers[i];
+        const auto& rhsContainer = rhs.m_containers[i];
+        if (lhsContainer.key != rhsContainer.key ||
+                lhsContainer.cardinality != rhsContainer.cardinality ||
+                lhsContainer.array != rhsContainer.array ||
+                lhsContainer.bits != rhsContainer.bits) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<quint32> CompressedBitmap::toVector() const {
+    std::vector<quint32> values;
+    values.reserve(cardinality());
+    forEach([&values](quint32 value) {
+        values.push_back(value);
+    });
+    return values;
+}
+
+std::vector<CompressedBitmap::Range> CompressedBitmap::ranges() const {
+    std::vector<Range> ranges;
+    forEach([&ranges](quint32 value) {
+        if (!ranges.empty() && ranges.back().second + 1 == value) {
+            ranges.back().second = value;
+        } else {
+            ranges.emplace_back(value, value);
+        }
+    });
+    return ranges;
+}
+
+} // namespace mixxx
@@ -0,0 +1,126 @@
+#ifndef MIXXX_COMPRESSEDBITMAP_H
+#define MIXXX_COMPRESSEDBITMAP_H
+
+#include <utility>
+#include <vector>
+
+#include <QtGlobal>
+
+namespace mixxx {
+
+// A compressed set of 32-bit unsigned integers, e.g. database ids, that
+// supports fast set operations.
+//
+// The values are partitioned by their upper 16 bits into containers
+// that store the lower 16 bits of each value either as a sorted array
+// (sparse) or as a bitset with 65536 bits (dense), whichever is smaller.
+// This is the layout of Roaring bitmaps. Contiguous ids of tracks that
+// have been imported together are stored in dense containers while
+// sparse selections only need 2 bytes per value.
+class CompressedBitmap final {
+  public:
+    // The cardinality above which a container is stored as a bitset
+    static const int kMaxArraySize = 4096;
+
+    typedef std::pair<quint32, quint32> Range; // [first, last]
+
+    CompressedBitmap() = default;
+    CompressedBitmap(const CompressedBitmap&) = default;
+    CompressedBitmap(CompressedBitmap&&) = default;
+    CompressedBitmap& operator=(const CompressedBitmap&) = default;
+    CompressedBitmap& operator=(CompressedBitmap&&) = default;
+
+    // The values must be sorted in ascending order. Duplicates are
+    // allowed.
+    static CompressedBitmap fromSorted(const std::vector<quint32>& values);
+
+    bool isEmpty() const {
+        return m_containers.empty();
+    }
+    int cardinality() const;
+
+    void clear() {
+        m_containers.clear();
+    }
+
+    bool contains(quint32 value) const;
+    // Returns true if the value has not been contained before
+    bool insert(quint32 value);
+    // Returns true if the value has been contained before
+    bool remove(quint32 value);
+
+    // Union
+    CompressedBitmap& operator|=(const CompressedBitmap& other);
+    // Intersection
+    CompressedBitmap& operator&=(const CompressedBitmap& other);
+    // Difference
+    CompressedBitmap& operator-=(const CompressedBitmap& other);
+
+    friend bool operator==(const CompressedBitmap& lhs, const CompressedBitmap& rhs);
+    friend bool operator!=(const CompressedBitmap& lhs, const CompressedBitmap& rhs) {
+        return !(lhs == rhs);
+    }
+
+    // Invokes the function for all values in ascending order
+    template<typename F>
+    void forEach(F f) const {
+        for (const auto& container : m_containers) {
+            const quint32 high = static_cast<quint32>(container.key) << 16;
+            if (container.isBitset()) {
+                for (int i = 0; i < kBitsetWords; ++i) {
+                    quint64 word = container.bits[i];
+                    while (word != 0) {
+                        const int bit = lowestBit(word);
+                        f(high | static_cast<quint32>(i * 64 + bit));
+                        word &= word - 1;
+                    }
+                }
+            } else {
+                for (quint16 low : container.array) {
+                    f(high | low);
+                }
+            }
+        }
+    }
+
+    std::vector<quint32> toVector() const;
+    // The values as maximal ranges of consecutive values in ascending order
+    std::vector<Range> ranges() const;
+
+  private:
+    static const int kBitsetWords = 65536 / 64;
+
+    struct Container {
+        bool isBitset() const {
+            return !bits.empty();
+        }
+        bool contains(quint16 low) const;
+
+        quint16 key;
+        int cardinality;
+        // Only one of both is used
+        std::vector<quint16> array;
+        std::vector<quint64> bits;
+    };
+
+    static int lowestBit(quint64 word);
+    static int popCount(quint64 word);
+
+    static void toBitset(Container* pContainer);
+    // Switches between array and bitset according to the cardinality
+    static void normalize(Container* pContainer);
+
+    static void unite(Container* pTarget, const Container& source);
+    static void intersect(Container* pTarget, const Container& source);
+    static void subtract(Container* pTarget, const Container& source);
+
+    std::vector<Container>::iterator findContainer(quint16 key);
+    std::vector<Container>::const_iterator findContainer(quint16 key) const;
+
+    // Sorted by key, empty containers are removed
+    std::vector<Container> m_containers;
+};
+
+} // namespace mixxx
+
+#endif // MIXXX_COMPRESSEDBITMAP_H
@@ -1,5 +1,6 @@
 #include <QSqlDriver>
 #include <QSqlError>
+#include <QSqlQuery>
 
 #ifdef __SQLITE3__
 #include <sqlite3.h>
@@ -296,18 +297,98 @@ bool initDatabase(QSqlDatabase database, StringCollator* pCollator) {
     return true;
 }
 
+// Returns the first value of the result, if any
+bool execPragma(
+        const QSqlDatabase& database,
+        const QString& pragma,
+        QVariant* pResult = nullptr) {
+    QSqlQuery query(database);
+    if (!query.exec(QString("PRAGMA %1").arg(pragma))) {
+        kLogger.warning()
+                << "Failed to execute"
+                << pragma
+                << query.lastError();
+        return false;
+    }
+    if (pResult && query.next()) {
+        *pResult = query.value(0);
+    }
+    return true;
+}
+
+void tuneDatabase(
+        const QSqlDatabase& database,
+        const DbConnection::Tuning& tuning) {
+    DEBUG_ASSERT(database.isOpen());
+    if (database.driverName() != "QSQLITE") {
+        return;
+    }
+    if (!tuning.journalMode.isEmpty()) {
+        QVariant journalMode;
+        if (execPragma(database,
+                QString("journal_mode=%1").arg(tuning.journalMode),
+                &journalMode) &&
+                journalMode.toString().compare(
+                        tuning.journalMode, Qt::CaseInsensitive) != 0) {
+            // In-memory databases don't support write-ahead logging
+            kLogger.info()
+                    << "Journal mode"
+                    << journalMode.toString()
+                    << "instead of"
+                    << tuning.journalMode;
+        }
+    }
+    if (!tuning.synchronous.isEmpty()) {
+        execPragma(database,
+                QString("synchronous=%1").arg(tuning.synchronous));
+    }
+    execPragma(database,
+            QString("mmap_size=%1").arg(tuning.mmapSize));
+    if (tuning.cacheSizeKiB > 0) {
+        // Negative values are in KiB instead of pages
+        execPragma(database,
+                QString("cache_size=-%1").arg(tuning.cacheSizeKiB));
+    }
+    execPragma(database,
+            QString("temp_store=%1").arg(
+                    tuning.tempStoreInMemory ? "MEMORY" : "DEFAULT"));
+}
+
 } // anonymous namespace
 
+//static
+DbConnection::Tuning DbConnection::Tuning::defaults() {
+    Tuning tuning;
+    tuning.journalMode = "DELETE";
+    tuning.synchronous = "FULL";
+    return tuning;
+}
+
+//static
+DbConnection::Tuning DbConnection::Tuning::performance() {
+    Tuning tuning;
+    tuning.journalMode = "WAL";
+    // Still consistent after a power loss, but the latest commits
+    // might be rolled back
+    tuning.synchronous = "NORMAL";
+    tuning.mmapSize = 256 * 1024 * 1024;
+    tuning.cacheSizeKiB = 64 * 1024;
+    tuning.tempStoreInMemory = true;
+    return tuning;
+}
+
 DbConnection::DbConnection(
         const Params& params,
         const QString& connectionName)
-    : m_sqlDatabase(createDatabase(params, connectionName)) {
+    : m_sqlDatabase(createDatabase(params, connectionName)),
+      m_tuning(params.tuning) {
 }
 
 DbConnection::DbConnection(
         const DbConnection& prototype,
         const QString& connectionName)
-    : m_sqlDatabase(cloneDatabase(prototype.m_sqlDatabase, connectionName)) {
+    : m_sqlDatabase(cloneDatabase(prototype.m_sqlDatabase, connectionName)),
+      m_tuning(prototype.m_tuning) {
 }
 
 DbConnection::~DbConnection() {
@@ -335,6 +416,7 @@ bool DbConnection::open() {
         m_sqlDatabase.close();
         return false; // abort
     }
+    tuneDatabase(m_sqlDatabase, m_tuning);
     return true;
 }
 
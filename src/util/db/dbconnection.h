@@ -24,12 +24,40 @@ class DbConnection final {
 
     static void makeStringLatinLow(QString* string);
 
+    // Performance tuning of SQLite connections that is applied with
+    // PRAGMA statements after opening. Ignored by other drivers.
+    struct Tuning {
+        // The defaults of SQLite. The journal mode is stored in the
+        // database file and needs to be reset explicitly.
+        static Tuning defaults();
+        // Write-ahead logging lets readers continue while a writer
+        // commits and only syncs to disk on checkpoints. Large caches
+        // and memory-mapped I/O reduce the system calls for reading.
+        static Tuning performance();
+
+        Tuning()
+            : mmapSize(0),
+              cacheSizeKiB(0),
+              tempStoreInMemory(false) {
+        }
+
+        // Unmodified if empty
+        QString journalMode;
+        QString synchronous;
+        // In bytes, disabled if 0
+        qint64 mmapSize;
+        // Unmodified if 0
+        int cacheSizeKiB;
+        bool tempStoreInMemory;
+    };
+
     struct Params {
         QString type;
         QString hostName;
         QString filePath;
         QString userName;
         QString password;
+        Tuning tuning;
     };
 
     // All constructors are reserved for DbConnectionPool!!
@@ -63,6 +91,7 @@ class DbConnection final {
     DbConnection(const DbConnection&&) = delete;
 
     QSqlDatabase m_sqlDatabase;
+    const Tuning m_tuning;
     StringCollator m_collator;
 };
 
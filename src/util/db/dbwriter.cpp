@@ -0,0 +1,284 @@
+#include "util/db/dbwriter.h"
+
+#include <QSqlError>
+#include <QSqlQuery>
+
+#include <sqlite3.h>
+
+#include "util/assert.h"
+#include "util/db/dbconnectionpooled.h"
+#include "util/db/dbconnectionpooler.h"
+#include "util/logger.h"
+#include "util/stat.h"
+#include "util/timer.h"
+
+namespace mixxx {
+
+namespace {
+
+const Logger kLogger("DbWriter");
+
+// Other connections, e.g. of the GUI or the library scanner, might hold
+// the write lock of the database for a while
+const int kMaxBusyRetries = 8;
+const unsigned long kBusyRetryDelayMillis = 10;
+
+enum class StatementResult {
+    Succeeded,
+    Failed,
+    Busy,
+};
+
+StatementResult execStatement(
+        const QSqlDatabase& database,
+        const QString& statement) {
+    QSqlQuery query(database);
+    if (query.exec(statement)) {
+        return StatementResult::Succeeded;
+    }
+    if (query.lastError().number() == SQLITE_BUSY) {
+        return StatementResult::Busy;
+    }
+    kLogger.warning()
+            << "Failed to execute"
+            << statement
+            << query.lastError();
+    return StatementResult::Failed;
+}
+
+// Retries the statement with an increasing delay while the database
+// is locked by another connection
+bool execStatementRetryBusy(
+        const QSqlDatabase& database,
+        const QString& statement) {
+    unsigned long delayMillis = kBusyRetryDelayMillis;
+    for (int retry = 0; retry <= kMaxBusyRetries; ++retry) {
+        switch (execStatement(database, statement)) {
+        case StatementResult::Succeeded:
+            return true;
+        case StatementResult::Failed:
+            return false;
+        case StatementResult::Busy:
+            QThread::msleep(delayMillis);
+            delayMillis *= 2;
+            break;
+        }
+    }
+    kLogger.warning()
+            << "Database is still locked after"
+            << kMaxBusyRetries
+            << "retries:"
+            << statement;
+    return false;
+}
+
+bool execSavepointStatement(
+        const QSqlDatabase& database,
+        const QString& statement) {
+    return execStatement(database, statement) == StatementResult::Succeeded;
+}
+
+} // anonymous namespace
+
+//static
+const int DbWriter::kMaxBatchSize = 100;
+
+DbWriter::DbWriter(
+        DbConnectionPoolPtr pDbConnectionPool,
+        const QString& name)
+        : m_pDbConnectionPool(std::move(pDbConnectionPool)),
+          m_queueDepthStatsKey(name + " DbWriter queue depth"),
+          m_batchSizeStatsKey(name + " DbWriter batch size"),
+          m_commitStatsKey(name + " DbWriter commit"),
+          m_executing(0),
+          m_stop(false) {
+    setObjectName(name + " DbWriter");
+    // The writer lives in the thread that has created it
+    connect(this, SIGNAL(batchFinished()),
+            this, SLOT(slotBatchFinished()),
+            Qt::QueuedConnection);
+}
+
+DbWriter::~DbWriter() {
+    stop();
+}
+
+void DbWriter::enqueue(
+        Command command,
+        Completion completion,
+        QObject* pContext) {
+    Request request;
+    request.command = std::move(command);
+    request.completion = std::move(completion);
+    request.pContext = pContext;
+    request.hasContext = pContext != nullptr;
+    int queueDepth;
+    {
+        QMutexLocker locked(&m_mutex);
+        VERIFY_OR_DEBUG_ASSERT(!m_stop) {
+            kLogger.warning()
+                    << "Discarding command after stopping";
+            return;
+        }
+        m_requests.push_back(std::move(request));
+        queueDepth = static_cast<int>(m_requests.size()) + m_executing;
+    }
+    m_requestsEnqueued.wakeOne();
+    Stat::track(m_queueDepthStatsKey, Stat::UNSPECIFIED,
+            Stat::COUNT | Stat::AVERAGE | Stat::MAX, queueDepth);
+}
+
+int DbWriter::queueDepth() const {
+    QMutexLocker locked(&m_mutex);
+    return static_cast<int>(m_requests.size()) + m_executing;
+}
+
+void DbWriter::waitForPending() {
+    QMutexLocker locked(&m_mutex);
+    if (!isRunning()) {
+        return;
+    }
+    while (!m_requests.empty() || m_executing > 0) {
+        m_batchExecuted.wait(&m_mutex);
+    }
+}
+
+void DbWriter::finishPending() {
+    DEBUG_ASSERT(QThread::currentThread() == thread());
+    waitForPending();
+    slotBatchFinished();
+}
+
+void DbWriter::stop() {
+    DEBUG_ASSERT(QThread::currentThread() == thread());
+    {
+        QMutexLocker locked(&m_mutex);
+        m_stop = true;
+    }
+    m_requestsEnqueued.wakeOne();
+    wait();
+    // Commands that have been enqueued without ever starting the
+    // thread are discarded.
+    {
+        QMutexLocker locked(&m_mutex);
+        for (auto& request : m_requests) {
+            Response response;
+            response.completion = std::move(request.completion);
+            response.pContext = request.pContext;
+            response.hasContext = request.hasContext;
+            response.succeeded = false;
+            m_responses.push_back(std::move(response));
+        }
+        m_requests.clear();
+    }
+    slotBatchFinished();
+}
+
+void DbWriter::run() {
+    const DbConnectionPooler dbConnectionPooler(m_pDbConnectionPool);
+    VERIFY_OR_DEBUG_ASSERT(dbConnectionPooler.isPooling()) {
+        kLogger.critical()
+                << "Failed to obtain database connection";
+        return;
+    }
+    const QSqlDatabase database = DbConnectionPooled(m_pDbConnectionPool);
+
+    std::vector<Request> batch;
+    batch.reserve(kMaxBatchSize);
+    while (true) {
+        {
+            QMutexLocker locked(&m_mutex);
+            while (m_requests.empty() && !m_stop) {
+                m_requestsEnqueued.wait(&m_mutex);
+            }
+            if (m_requests.empty()) {
+                DEBUG_ASSERT(m_stop);
+                break;
+            }
+            while (!m_requests.empty() &&
+                    static_cast<int>(batch.size()) < kMaxBatchSize) {
+                batch.push_back(std::move(m_requests.front()));
+                m_requests.pop_front();
+            }
+            m_executing = static_cast<int>(batch.size());
+        }
+        Stat::track(m_batchSizeStatsKey, Stat::UNSPECIFIED,
+                Stat::COUNT | Stat::AVERAGE | Stat::MAX, batch.size());
+        executeBatch(database, &batch);
+        batch.clear();
+        {
+            QMutexLocker locked(&m_mutex);
+            m_executing = 0;
+        }
+        m_batchExecuted.wakeAll();
+        emit(batchFinished());
+    }
+}
+
+void DbWriter::executeBatch(
+        QSqlDatabase database,
+        std::vector<Request>* pBatch) {
+    std::vector<Response> responses;
+    responses.reserve(pBatch->size());
+    Timer timer(m_commitStatsKey,
+            Stat::COUNT | Stat::AVERAGE | Stat::MAX | Stat::MIN);
+    timer.start();
+    // Acquire the write lock upfront. A deferred transaction would only
+    // try to upgrade its lock on the first write, when it is too late to
+    // wait for the lock without risking a deadlock.
+    const bool began = execStatementRetryBusy(database, "BEGIN IMMEDIATE");
+    for (auto& request : *pBatch) {
+        Response response;
+        response.completion = std::move(request.completion);
+        response.pContext = request.pContext;
+        response.hasContext = request.hasContext;
+        response.succeeded = false;
+        if (began &&
+                execSavepointStatement(database, "SAVEPOINT dbwriter")) {
+            response.succeeded = request.command(database);
+            if (!response.succeeded) {
+                execSavepointStatement(database, "ROLLBACK TO dbwriter");
+            }
+            execSavepointStatement(database, "RELEASE dbwriter");
+        }
+        responses.push_back(std::move(response));
+    }
+    if (!began || !execStatementRetryBusy(database, "COMMIT")) {
+        kLogger.warning()
+                << "Failed to commit"
+                << pBatch->size()
+                << "commands";
+        if (began) {
+            execStatement(database, "ROLLBACK");
+        }
+        for (auto& response : responses) {
+            response.succeeded = false;
+        }
+    }
+    timer.elapsed(true);
+
+    QMutexLocker locked(&m_mutex);
+    for (auto& response : responses) {
+        m_responses.push_back(std::move(response));
+    }
+}
+
+void DbWriter::slotBatchFinished() {
+    std::vector<Response> responses;
+    {
+        QMutexLocker locked(&m_mutex);
+        responses.swap(m_responses);
+    }
+    for (const auto& response : responses) {
+        if (!response.completion) {
+            continue;
+        }
+        if (response.hasContext && !response.pContext) {
+            // The context has been destroyed
+            continue;
+        }
+        response.completion(response.succeeded);
+    }
+}
+
+} // namespace mixxx
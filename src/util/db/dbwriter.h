@@ -0,0 +1,120 @@
+#ifndef MIXXX_DBWRITER_H
+#define MIXXX_DBWRITER_H
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include <QMutex>
+#include <QPointer>
+#include <QSqlDatabase>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "util/db/dbconnectionpool.h"
+
+namespace mixxx {
+
+// Executes database mutations in a dedicated thread with its own pooled
+// connection, so that the GUI thread doesn't block while writing large
+// amounts of data, e.g. after dropping thousands of tracks onto a
+// playlist or crate.
+//
+// The commands that have been enqueued are executed in their order and
+// in batches. Every batch is committed in a single immediate transaction
+// and every command of a batch in a nested savepoint, i.e. a failing
+// command only rolls back its own changes. Beginning and committing the
+// transaction is retried while the database is locked by another
+// connection.
+//
+// The completion of a command is invoked in the thread that has created
+// the writer after the batch has been committed, unless the optional
+// context object has been destroyed in the meantime.
+//
+// The depth of the queue, the size of the batches and the latency of the
+// commits are reported to the stats.
+class DbWriter : public QThread {
+    Q_OBJECT
+  public:
+    // Executed in the writer thread and must not begin or end any
+    // transactions. Returns false on failure.
+    typedef std::function<bool(QSqlDatabase database)> Command;
+    typedef std::function<void(bool succeeded)> Completion;
+
+    static const int kMaxBatchSize;
+
+    DbWriter(
+            DbConnectionPoolPtr pDbConnectionPool,
+            const QString& name);
+    // Executes all pending commands before returning
+    ~DbWriter() override;
+
+    // Might be called from any thread
+    void enqueue(
+            Command command,
+            Completion completion = Completion(),
+            QObject* pContext = nullptr);
+
+    int queueDepth() const;
+
+    // Blocks until all commands that have been enqueued before have been
+    // executed. Their completions are invoked asynchronously as usual.
+    void waitForPending();
+
+    // Blocks until all commands that have been enqueued before have been
+    // executed and invokes their completions. Must be called from the
+    // thread that has created the writer before any synchronous write
+    // that depends on the outcome of these commands.
+    void finishPending();
+
+    // Executes all pending commands, stops the thread and invokes all
+    // outstanding completions. Must be called from the thread that has
+    // created the writer.
+    void stop();
+
+  signals:
+    void batchFinished();
+
+  protected:
+    void run() override;
+
+  private slots:
+    void slotBatchFinished();
+
+  private:
+    struct Request {
+        Command command;
+        Completion completion;
+        QPointer<QObject> pContext;
+        bool hasContext;
+    };
+
+    struct Response {
+        Completion completion;
+        QPointer<QObject> pContext;
+        bool hasContext;
+        bool succeeded;
+    };
+
+    void executeBatch(
+            QSqlDatabase database,
+            std::vector<Request>* pBatch);
+
+    const DbConnectionPoolPtr m_pDbConnectionPool;
+    const QString m_queueDepthStatsKey;
+    const QString m_batchSizeStatsKey;
+    const QString m_commitStatsKey;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_requestsEnqueued;
+    QWaitCondition m_batchExecuted;
+    std::deque<Request> m_requests;
+    // The requests that are being executed
+    int m_executing;
+    bool m_stop;
+    std::vector<Response> m_responses;
+};
+
+} // namespace mixxx
+
+#endif // MIXXX_DBWRITER_H
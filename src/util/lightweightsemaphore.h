@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+
+#if defined(__LINUX__)
+#include <semaphore.h>
+#include <errno.h>
+#else
+#include <QSemaphore>
+#endif
+
+#include "util/class.h"
+
+namespace mixxx {
+
+// A counting semaphore for waking up a worker thread from a real-time
+// thread, e.g. the audio callback.
+//
+// The count is maintained by a lock-free atomic. The underlying OS
+// semaphore is only touched if the consumer is actually sleeping. On
+// Linux this is an unnamed POSIX semaphore that is backed by a futex
+// and never takes a user space lock in release(). Other platforms fall
+// back to QSemaphore for the slow path.
+//
+// Only a single thread is supposed to call acquire().
+class LightweightSemaphore {
+  public:
+    LightweightSemaphore()
+            : m_count(0) {
+#if defined(__LINUX__)
+        sem_init(&m_sema, 0, 0);
+#endif
+    }
+    ~LightweightSemaphore() {
+#if defined(__LINUX__)
+        sem_destroy(&m_sema);
+#endif
+    }
+
+    // Wait-free unless the consumer is sleeping.
+    void release() {
+        const int oldCount = m_count.fetch_add(1, std::memory_order_release);
+        if (oldCount < 0) {
+            // The consumer is (about to be) sleeping
+            wakeUp();
+        }
+    }
+
+    // Blocks until release() has been invoked at least once since
+    // the last acquire().
+    void acquire() {
+        const int oldCount = m_count.fetch_sub(1, std::memory_order_acquire);
+        if (oldCount <= 0) {
+            sleep();
+        }
+    }
+
+  private:
+    void wakeUp() {
+#if defined(__LINUX__)
+        sem_post(&m_sema);
+#else
+        m_sema.release();
+#endif
+    }
+
+    void sleep() {
+#if defined(__LINUX__)
+        while (sem_wait(&m_sema) != 0 && errno == EINTR) {
+            // Interrupted by a signal handler
+        }
+#else
+        m_sema.acquire();
+#endif
+    }
+
+    std::atomic<int> m_count;
+#if defined(__LINUX__)
+    sem_t m_sema;
+#else
+    QSemaphore m_sema;
+#endif
+
+    DISALLOW_COPY_AND_ASSIGN(LightweightSemaphore);
+};
+
+} // namespace mixxx
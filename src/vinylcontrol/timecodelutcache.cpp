@@ -0,0 +1,243 @@
+#include "vinylcontrol/timecodelutcache.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSaveFile>
+#include <QtConcurrentRun>
+
+#include "util/assert.h"
+#include "util/logger.h"
+#include "util/timer.h"
+
+namespace {
+
+const mixxx::Logger kLogger("TimecodeLutCache");
+
+// "MXLT", reads differently with the other byte order
+const quint32 kMagic = 0x4d584c54;
+// Increment when the layout of the file or of struct lut changes
+const quint32 kVersion = 1;
+
+struct Header {
+    quint32 magic;
+    quint32 version;
+    quint32 slotSize;
+    quint32 hashes;
+    // The fields of the definition that determine the LUT
+    quint32 bits;
+    quint32 seed;
+    quint32 taps;
+    quint32 length;
+    // Number of used slots
+    quint32 avail;
+    quint32 reserved;
+};
+
+qint64 fileSize(const Header& header) {
+    return sizeof(Header) +
+            static_cast<qint64>(header.avail) * header.slotSize +
+            static_cast<qint64>(header.hashes) * sizeof(slot_no_t);
+}
+
+Header headerForDefinition(const timecode_def& def) {
+    Header header;
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.slotSize = sizeof(struct slot);
+    header.hashes = LUT_HASHES;
+    header.bits = def.bits;
+    header.seed = def.seed;
+    header.taps = def.taps;
+    header.length = def.length;
+    header.avail = def.length;
+    header.reserved = 0;
+    return header;
+}
+
+bool isValidSlot(slot_no_t slot, slot_no_t avail) {
+    return slot == LUT_NO_SLOT || slot < avail;
+}
+
+struct Entry {
+    QMutex mutex;
+    timecode_def* pDef = nullptr;
+    // The mapped cache file if the LUT has been loaded from it
+    QFile file;
+};
+
+QMutex s_mutex;
+QString s_cacheDirectory;
+QHash<QString, Entry*> s_entries;
+QList<QFuture<void>> s_preparations;
+
+Entry* entryForTimecode(const QString& timecode) {
+    QMutexLocker locker(&s_mutex);
+    Entry*& pEntry = s_entries[timecode];
+    if (pEntry == nullptr) {
+        pEntry = new Entry();
+    }
+    return pEntry;
+}
+
+QString cacheFilePath(const QString& timecode) {
+    QMutexLocker locker(&s_mutex);
+    if (s_cacheDirectory.isEmpty()) {
+        return QString();
+    }
+    return QDir(s_cacheDirectory).filePath(timecode + QStringLiteral(".lut"));
+}
+
+void prepareTimecode(QString timecode) {
+    TimecodeLutCache::findDefinition(timecode.toLatin1().constData());
+}
+
+} // anonymous namespace
+
+// static
+void TimecodeLutCache::setCacheDirectory(const QString& path) {
+    QMutexLocker locker(&s_mutex);
+    s_cacheDirectory = path;
+}
+
+// static
+void TimecodeLutCache::prepare(const QStringList& timecodes) {
+    QMutexLocker locker(&s_mutex);
+    for (const QString& timecode : timecodes) {
+        s_preparations.append(QtConcurrent::run(prepareTimecode, timecode));
+    }
+}
+
+// static
+timecode_def* TimecodeLutCache::findDefinition(const char* timecode) {
+    Entry* pEntry = entryForTimecode(QString::fromLatin1(timecode));
+    QMutexLocker locker(&pEntry->mutex);
+    if (pEntry->pDef != nullptr && pEntry->pDef->lookup) {
+        return pEntry->pDef;
+    }
+
+    timecode_def* pDef = timecoder_find_definition_without_lookup(timecode);
+    if (pDef == nullptr) {
+        return nullptr;
+    }
+
+    ScopedTimer t("TimecodeLutCache::findDefinition");
+    const QString path = cacheFilePath(QString::fromLatin1(pDef->name));
+    if (!path.isEmpty()) {
+        pEntry->file.setFileName(path);
+        if (pEntry->file.open(QIODevice::ReadOnly)) {
+            if (mapFile(&pEntry->file, pDef)) {
+                kLogger.debug() << "Loaded the LUT of" << pDef->desc
+                                << "from" << path;
+                pEntry->pDef = pDef;
+                return pDef;
+            }
+            kLogger.info() << "Rebuilding the outdated LUT" << path;
+            pEntry->file.close();
+        }
+    }
+
+    if (timecoder_build_lookup(pDef) == -1) {
+        kLogger.warning() << "Failed to allocate the LUT of" << pDef->desc;
+        return nullptr;
+    }
+    if (!path.isEmpty() && !writeFile(path, *pDef)) {
+        kLogger.warning() << "Failed to write the LUT of" << pDef->desc
+                          << "to" << path;
+    }
+    pEntry->pDef = pDef;
+    return pDef;
+}
+
+// static
+void TimecodeLutCache::freeAll() {
+    QList<QFuture<void>> preparations;
+    {
+        QMutexLocker locker(&s_mutex);
+        preparations.swap(s_preparations);
+    }
+    for (QFuture<void>& preparation : preparations) {
+        preparation.waitForFinished();
+    }
+
+    // Frees the built LUTs and resets the mapped ones
+    timecoder_free_lookup();
+
+    QMutexLocker locker(&s_mutex);
+    qDeleteAll(s_entries);
+    s_entries.clear();
+}
+
+// static
+bool TimecodeLutCache::writeFile(const QString& path, const timecode_def& def) {
+    VERIFY_OR_DEBUG_ASSERT(def.lookup && def.lut.avail == def.length) {
+        return false;
+    }
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // Replaces the file atomically, a concurrent reader either sees the
+    // old or the new file.
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    const Header header = headerForDefinition(def);
+    const qint64 slotBytes = static_cast<qint64>(header.avail) * header.slotSize;
+    const qint64 tableBytes = static_cast<qint64>(header.hashes) * sizeof(slot_no_t);
+    if (file.write(reinterpret_cast<const char*>(&header), sizeof(header)) !=
+                    sizeof(header) ||
+            file.write(reinterpret_cast<const char*>(def.lut.slot), slotBytes) !=
+                    slotBytes ||
+            file.write(reinterpret_cast<const char*>(def.lut.table), tableBytes) !=
+                    tableBytes) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+// static
+bool TimecodeLutCache::mapFile(QFile* pFile, timecode_def* pDef) {
+    const Header expected = headerForDefinition(*pDef);
+    if (pFile->size() != fileSize(expected)) {
+        return false;
+    }
+    uchar* pData = pFile->map(0, pFile->size());
+    if (pData == nullptr) {
+        return false;
+    }
+    if (memcmp(pData, &expected, sizeof(expected)) != 0) {
+        pFile->unmap(pData);
+        return false;
+    }
+
+    // Verify all links, so that a damaged file cannot make lut_lookup()
+    // read out of bounds or loop forever. lut_push() always links a new
+    // slot to a slot that has been pushed before, i.e. a lower slot.
+    struct slot* pSlots = reinterpret_cast<struct slot*>(pData + sizeof(Header));
+    slot_no_t* pTable = reinterpret_cast<slot_no_t*>(pSlots + expected.avail);
+    for (quint32 i = 0; i < expected.avail; ++i) {
+        if (!isValidSlot(pSlots[i].next, i)) {
+            pFile->unmap(pData);
+            return false;
+        }
+    }
+    for (quint32 i = 0; i < expected.hashes; ++i) {
+        if (!isValidSlot(pTable[i], expected.avail)) {
+            pFile->unmap(pData);
+            return false;
+        }
+    }
+    // The first slot is the timecode at position zero
+    if (expected.avail > 0 && pSlots[0].timecode != pDef->seed) {
+        pFile->unmap(pData);
+        return false;
+    }
+
+    lut_init_external(&pDef->lut, pSlots, pTable, expected.avail);
+    pDef->lookup = true;
+    return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+#ifdef _MSC_VER
+#include "timecoder.h"
+#else
+extern "C" {
+#include "timecoder.h"
+}
+#endif
+
+// Provides the lookup tables (LUTs) of the xwax timecode definitions.
+// Building the LUT of a long timecode takes seconds, so built LUTs are
+// written to cache files that are mapped into memory the next time.
+//
+// A cache file consists of a header followed by the slots and the hash
+// table of the xwax struct lut in their native memory layout. Files that
+// do not match the definition, the cache version or the byte order are
+// replaced.
+//
+// All functions are thread-safe.
+class TimecodeLutCache {
+  public:
+    // Sets the directory of the cache files. Without one the LUTs are
+    // always built.
+    static void setCacheDirectory(const QString& path);
+
+    // Loads or builds the LUTs of the given xwax timecodes in parallel in
+    // the background, so that findDefinition() returns immediately later.
+    static void prepare(const QStringList& timecodes);
+
+    // Returns the xwax definition of timecode with its LUT loaded from the
+    // cache or built. Waits if the LUT is being prepared. Returns nullptr if
+    // the timecode is unknown or the LUT could not be allocated.
+    static timecode_def* findDefinition(const char* timecode);
+
+    // Waits for pending preparations and frees all LUTs. The definitions
+    // must not be in use anymore.
+    static void freeAll();
+
+    // Writes the LUT of def to a cache file. Exposed for tests.
+    static bool writeFile(const QString& path, const timecode_def& def);
+
+    // Maps the cache file that has been opened in pFile and points the LUT
+    // of pDef into it if the file matches the definition. The file must
+    // stay open while the LUT is in use. Exposed for tests.
+    static bool mapFile(QFile* pFile, timecode_def* pDef);
+};
@@ -16,7 +16,17 @@ class VinylControl : public QObject {
 
     virtual void toggleVinylControl(bool enable);
     virtual bool isEnabled();
-    virtual void analyzeSamples(CSAMPLE* pSamples, size_t nFrames) = 0;
+    // Called from the processor thread or, if the deck is decoded in the
+    // engine callback, from the callback. Must not block or allocate.
+    virtual void analyzeSamples(const CSAMPLE* pSamples, size_t nFrames) = 0;
+    // Called from the processor thread. Applies the changes to controls
+    // that analyzeSamples() must not make itself, because they may
+    // allocate or block, e.g. controls outside of the deck.
+    virtual void updateControls() {}
+    // Whether analyzeSamples() has left changes for updateControls()
+    virtual bool controlUpdatesPending() const {
+        return false;
+    }
     virtual bool writeQualityReport(VinylSignalQualityReport* qualityReportFifo) = 0;
 
   protected:
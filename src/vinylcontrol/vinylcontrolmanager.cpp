@@ -6,6 +6,8 @@
 
 #include "vinylcontrol/vinylcontrolmanager.h"
 
+#include <QDir>
+
 #include "control/controlobject.h"
 #include "control/controlproxy.h"
 #include "mixer/playermanager.h"
@@ -13,6 +15,7 @@
 #include "util/compatibility.h"
 #include "util/timer.h"
 #include "vinylcontrol/defs_vinylcontrol.h"
+#include "vinylcontrol/timecodelutcache.h"
 #include "vinylcontrol/vinylcontrol.h"
 #include "vinylcontrol/vinylcontrolprocessor.h"
 #include "vinylcontrol/vinylcontrolxwax.h"
@@ -33,6 +36,25 @@ VinylControlManager::VinylControlManager(QObject* pParent,
             AudioInput(AudioInput::VINYLCONTROL, 0, 2, i), m_pProcessor);
     }
 
+    // Load or build the timecode lookup tables of the configured decks in
+    // the background, so that enabling vinyl control does not stall.
+    TimecodeLutCache::setCacheDirectory(
+            QDir(pConfig->getSettingsPath()).filePath("timecode_luts"));
+    QStringList timecodes;
+    for (int i = 0; i < kMaximumVinylControlInputs; ++i) {
+        const QString vinylType = pConfig->getValueString(ConfigKey(
+                PlayerManager::groupForDeck(i), "vinylcontrol_vinyl_type"));
+        if (vinylType.isEmpty()) {
+            continue;
+        }
+        const QString timecode = QString::fromLatin1(
+                VinylControlXwax::timecodeForVinylType(vinylType));
+        if (!timecodes.contains(timecode)) {
+            timecodes.append(timecode);
+        }
+    }
+    TimecodeLutCache::prepare(timecodes);
+
     connect(&m_vinylControlEnabledMapper,
             QOverload<int>::of(&QSignalMapper::mapped),
             this,
@@ -33,6 +33,9 @@ VinylControlProcessor::VinylControlProcessor(QObject* pParent, UserSettingsPoint
 
     for (int i = 0; i < kMaximumVinylControlInputs; ++i) {
         m_samplePipes[i] = new FIFO<CSAMPLE>(SAMPLE_PIPE_FIFO_SIZE);
+        m_callbackProcessors[i] = nullptr;
+        m_callbackProcessorBusy[i] = false;
+        m_callbackReportPending[i] = false;
     }
 
     start(QThread::HighPriority);
@@ -46,16 +49,12 @@ VinylControlProcessor::~VinylControlProcessor() {
     delete m_pToggle;
     SampleUtil::free(m_pWorkBuffer);
 
-    {
-        QMutexLocker locker(&m_processorsLock);
-        for (int i = 0; i < kMaximumVinylControlInputs; ++i) {
-            VinylControl* pProcessor = m_processors.at(i);
-            m_processors[i] = NULL;
-            delete pProcessor;
+    for (int i = 0; i < kMaximumVinylControlInputs; ++i) {
+        setProcessor(i, NULL);
 
-            delete m_samplePipes[i];
-            m_samplePipes[i] = NULL;
-        }
+        QMutexLocker locker(&m_processorsLock);
+        delete m_samplePipes[i];
+        m_samplePipes[i] = NULL;
     }
 
     // xwax has a global LUT that we need to free after we've shut down our
@@ -89,6 +88,29 @@ void VinylControlProcessor::run() {
         }
 
         for (int i = 0; i < kMaximumVinylControlInputs; ++i) {
+            if (m_callbackProcessors[i].load() != nullptr) {
+                // Decoded in the engine callback. setProcessor() only
+                // deletes a processor after replacing it with the lock
+                // held, so it is safe to use while locked.
+                {
+                    QMutexLocker locker(&m_processorsLock);
+                    VinylControl* pCallbackProcessor = m_callbackProcessors[i].load();
+                    if (pCallbackProcessor != nullptr) {
+                        pCallbackProcessor->updateControls();
+                    }
+                }
+                // Forward its report
+                if (m_callbackReportPending[i].exchange(false)) {
+                    VinylSignalQualityReport report =
+                            m_callbackReports[i].getValue();
+                    report.processor = i;
+                    if (m_signalQualityFifo.write(&report, 1) != 1) {
+                        qWarning() << "VinylControlProcessor could not write signal quality report for VC index:" << i;
+                    }
+                }
+                continue;
+            }
+
             QMutexLocker locker(&m_processorsLock);
             VinylControl* pProcessor = m_processors[i];
             locker.unlock();
@@ -105,6 +127,7 @@ void VinylControlProcessor::run() {
 
                 if (pProcessor) {
                     pProcessor->analyzeSamples(m_pWorkBuffer, framesRead);
+                    pProcessor->updateControls();
                 } else {
                     // Samples are being written to a non-existent processor. Warning?
                     qWarning() << "Samples written to non-existent VinylControl processor:" << i;
@@ -140,21 +163,38 @@ void VinylControlProcessor::run() {
 void VinylControlProcessor::reloadConfig() {
     for (int i = 0; i < kMaximumVinylControlInputs; ++i) {
         QMutexLocker locker(&m_processorsLock);
-        VinylControl* pCurrent = m_processors[i];
-
-        if (pCurrent == NULL) {
+        if (m_processors[i] == NULL) {
             continue;
         }
-
-        VinylControl *pNew = new VinylControlXwax(
-            m_pConfig, kVCGroup.arg(i + 1));
-        m_processors.replace(i, pNew);
         locker.unlock();
-        // Delete outside of the critical section to avoid deadlocks.
-        delete pCurrent;
+
+        setProcessor(i, new VinylControlXwax(m_pConfig, kVCGroup.arg(i + 1)));
     }
 }
 
+bool VinylControlProcessor::decodeInCallback(int index) const {
+    return m_pConfig->getValue<bool>(ConfigKey(VINYL_PREF_KEY,
+            QString("decode_in_callback_ch%1").arg(index + 1)), false);
+}
+
+void VinylControlProcessor::setProcessor(int index, VinylControl* pNew) {
+    QMutexLocker locker(&m_processorsLock);
+    VinylControl* pCurrent = m_processors.at(index);
+    m_processors.replace(index, pNew);
+    m_callbackProcessors[index] =
+            pNew != NULL && decodeInCallback(index) ? pNew : nullptr;
+    locker.unlock();
+
+    // Wait until the engine callback is done with the old processor. It
+    // finishes within one callback.
+    while (m_callbackProcessorBusy[index].load()) {
+        QThread::yieldCurrentThread();
+    }
+    m_callbackReportPending[index] = false;
+    // Delete outside of the critical section to avoid deadlocks.
+    delete pCurrent;
+}
+
 void VinylControlProcessor::onInputConfigured(AudioInput input) {
     if (input.getType() != AudioInput::VINYLCONTROL) {
         qDebug() << "WARNING: AudioInput type is not VINYLCONTROL. Ignoring.";
@@ -168,15 +208,8 @@ void VinylControlProcessor::onInputConfigured(AudioInput input) {
         return;
     }
 
-    VinylControl *pNew = new VinylControlXwax(
-        m_pConfig, kVCGroup.arg(index + 1));
-
-    QMutexLocker locker(&m_processorsLock);
-    VinylControl* pCurrent = m_processors.at(index);
-    m_processors.replace(index, pNew);
-    locker.unlock();
-    // Delete outside of the critical section to avoid deadlocks.
-    delete pCurrent;
+    setProcessor(index, new VinylControlXwax(
+        m_pConfig, kVCGroup.arg(index + 1)));
 }
 
 void VinylControlProcessor::onInputUnconfigured(AudioInput input) {
@@ -193,12 +226,7 @@ void VinylControlProcessor::onInputUnconfigured(AudioInput input) {
         return;
     }
 
-    QMutexLocker locker(&m_processorsLock);
-    VinylControl* pVC = m_processors.at(index);
-    m_processors.replace(index, NULL);
-    locker.unlock();
-    // Delete outside of the critical section to avoid deadlocks.
-    delete pVC;
+    setProcessor(index, NULL);
 }
 
 bool VinylControlProcessor::deckConfigured(int index) const {
@@ -221,6 +249,11 @@ void VinylControlProcessor::receiveBuffer(AudioInput input,
         return;
     }
 
+    if (m_callbackProcessors[vcIndex].load() != nullptr) {
+        analyzeInCallback(vcIndex, pBuffer, nFrames);
+        return;
+    }
+
     FIFO<CSAMPLE>* pSamplePipe = m_samplePipes[vcIndex];
 
     if (pSamplePipe == NULL) {
@@ -240,6 +273,35 @@ void VinylControlProcessor::receiveBuffer(AudioInput input,
     m_samplesAvailableSignal.wakeAll();
 }
 
+void VinylControlProcessor::analyzeInCallback(int index,
+                                              const CSAMPLE* pBuffer,
+                                              unsigned int nFrames) {
+    // Announce the use before loading the pointer, so that setProcessor()
+    // either sees us busy or we see the new processor.
+    m_callbackProcessorBusy[index] = true;
+    bool controlUpdatesPending = false;
+    VinylControl* pProcessor = m_callbackProcessors[index].load();
+    if (pProcessor != nullptr) {
+        pProcessor->analyzeSamples(pBuffer, nFrames);
+        controlUpdatesPending = pProcessor->controlUpdatesPending();
+
+        if (m_bReportSignalQuality) {
+            VinylSignalQualityReport report;
+            if (pProcessor->writeQualityReport(&report)) {
+                m_callbackReports[index].setValue(report);
+                m_callbackReportPending[index] = true;
+            }
+        }
+    }
+    m_callbackProcessorBusy[index] = false;
+
+    // Let the processor thread forward the signal quality report and
+    // apply the changes of controls outside of the deck
+    if (m_bReportSignalQuality || controlUpdatesPending) {
+        m_samplesAvailableSignal.wakeAll();
+    }
+}
+
 void VinylControlProcessor::toggleDeck(double value) {
     if (!value)
         return;
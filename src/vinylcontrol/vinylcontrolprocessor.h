@@ -3,10 +3,13 @@
 
 #include <QObject>
 #include <QThread>
+
+#include <atomic>
 #include <QVector>
 #include <QMutex>
 #include <QWaitCondition>
 
+#include "control/controlvalue.h"
 #include "preferences/usersettings.h"
 #include "util/fifo.h"
 #include "vinylcontrol/vinylsignalquality.h"
@@ -19,6 +22,11 @@ class ControlPushButton;
 // the engine callback and feeding those samples to the VinylControl
 // classes. The most important thing is that the connection between the engine
 // callback and VinylControlProcessor (the receiveBuffer method) is lock-free.
+//
+// Decks with the [VinylControl],decode_in_callback_chN preference enabled
+// skip the thread: their timecode is decoded right in receiveBuffer, so the
+// pitch reaches the deck without waiting for the processor thread to be
+// scheduled.
 class VinylControlProcessor : public QThread, public AudioDestination {
     Q_OBJECT
   public:
@@ -45,7 +53,8 @@ class VinylControlProcessor : public QThread, public AudioDestination {
     virtual void onInputUnconfigured(AudioInput input);
 
     // Called by the engine callback. Must not touch any state in
-    // VinylControlProcessor except for m_samplePipes. NOTE:
+    // VinylControlProcessor except for m_samplePipes and the m_callback*
+    // members. NOTE:
 
     // This is called by SoundManager whenever there are new samples from the
     // configured input to be processed. This is run in the callback thread of
@@ -64,6 +73,13 @@ class VinylControlProcessor : public QThread, public AudioDestination {
 
   private:
     void reloadConfig();
+    // Replaces the processor of a deck and deletes the old one once the
+    // engine callback does not use it anymore.
+    void setProcessor(int index, VinylControl* pNew);
+    bool decodeInCallback(int index) const;
+    // Decodes the samples of a deck in the engine callback
+    void analyzeInCallback(int index, const CSAMPLE* pBuffer,
+                           unsigned int nFrames);
 
     UserSettingsPointer m_pConfig;
     ControlPushButton* m_pToggle;
@@ -76,6 +92,16 @@ class VinylControlProcessor : public QThread, public AudioDestination {
     QMutex m_waitForSampleMutex;
     QMutex m_processorsLock;
     QVector<VinylControl*> m_processors;
+    // The processors of the decks that are decoded in the engine callback.
+    // The callback sets m_callbackProcessorBusy while it uses a processor, so
+    // that setProcessor() does not delete it under its feet.
+    std::atomic<VinylControl*> m_callbackProcessors[kMaximumVinylControlInputs];
+    std::atomic<bool> m_callbackProcessorBusy[kMaximumVinylControlInputs];
+    // The signal quality reports of the decks that are decoded in the engine
+    // callback, forwarded by the processor thread that is the only writer of
+    // m_signalQualityFifo.
+    ControlValueAtomic<VinylSignalQualityReport> m_callbackReports[kMaximumVinylControlInputs];
+    std::atomic<bool> m_callbackReportPending[kMaximumVinylControlInputs];
     FIFO<VinylSignalQualityReport> m_signalQualityFifo;
     volatile bool m_bReportSignalQuality;
     volatile bool m_bQuit;
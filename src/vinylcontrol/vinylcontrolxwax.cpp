@@ -23,6 +23,7 @@
 #include <limits.h>
 
 #include "vinylcontrol/vinylcontrolxwax.h"
+#include "vinylcontrol/timecodelutcache.h"
 #include "util/timer.h"
 #include "control/controlproxy.h"
 #include "control/controlobject.h"
@@ -41,7 +42,6 @@
 // Sample threshold below which we consider there to be no signal.
 const double kMinSignal = 75.0 / SAMPLE_MAX;
 
-bool VinylControlXwax::s_bLUTInitialized = false;
 QMutex VinylControlXwax::s_xwaxLUTMutex;
 
 VinylControlXwax::VinylControlXwax(UserSettingsPointer pConfig, QString group)
@@ -71,6 +71,8 @@ VinylControlXwax::VinylControlXwax(UserSettingsPointer pConfig, QString group)
           m_bTrackSelectMode(false),
           m_pControlTrackSelector(NULL),
           m_pControlTrackLoader(NULL),
+          m_trackSelectSteps(0),
+          m_trackLoadRequested(false),
           m_dLastTrackSelectPos(0.0),
           m_dCurTrackSelectPos(0.0),
           m_dDriftAmt(0.0),
@@ -86,31 +88,12 @@ VinylControlXwax::VinylControlXwax(UserSettingsPointer pConfig, QString group)
     QString strVinylSpeed = m_pConfig->getValueString(
         ConfigKey(group,"vinylcontrol_speed_type"));
 
-    // libxwax indexes by C-strings so we pass libxwax string literals so we
-    // don't have to deal with freeing the strings later
-    char* timecode = NULL;
-
-
-    if (strVinylType == MIXXX_VINYL_SERATOCV02VINYLSIDEA) {
-        timecode = (char*)"serato_2a";
-    }
-    else if (strVinylType == MIXXX_VINYL_SERATOCV02VINYLSIDEB) {
-        timecode = (char*)"serato_2b";
-    } else if (strVinylType == MIXXX_VINYL_SERATOCD) {
-        timecode = (char*)"serato_cd";
+    const char* timecode = timecodeForVinylType(strVinylType);
+    if (strVinylType == MIXXX_VINYL_SERATOCD) {
         m_bCDControl = true;
         // Set up very sensitive steady monitors for CDJs.
         m_pSteadySubtle = new SteadyPitch(0.06, true);
         m_pSteadyGross = new SteadyPitch(0.25, true);
-    } else if (strVinylType == MIXXX_VINYL_TRAKTORSCRATCHSIDEA) {
-        timecode = (char*)"traktor_a";
-    } else if (strVinylType == MIXXX_VINYL_TRAKTORSCRATCHSIDEB) {
-        timecode = (char*)"traktor_b";
-    } else if (strVinylType == MIXXX_VINYL_MIXVIBESDVS) {
-        timecode = (char*)"mixvibes_v2";
-    } else {
-        qDebug() << "Unknown vinyl type, defaulting to serato_2a";
-        timecode = (char*)"serato_2a";
     }
 
     // If we didn't set up the steady monitors already (not CDJ), do it now.
@@ -122,11 +105,13 @@ VinylControlXwax::VinylControlXwax(UserSettingsPointer pConfig, QString group)
     }
 
 
-    timecode_def* tc_def = timecoder_find_definition(timecode);
+    // Loads the LUT from the cache or waits until it has been prepared in
+    // the background.
+    timecode_def* tc_def = TimecodeLutCache::findDefinition(timecode);
     if (tc_def == NULL) {
         qDebug() << "Error finding timecode definition for " << timecode << ", defaulting to serato_2a";
-        timecode = (char*)"serato_2a";
-        tc_def = timecoder_find_definition(timecode);
+        timecode = "serato_2a";
+        tc_def = TimecodeLutCache::findDefinition(timecode);
     }
 
     double speed = 1.0;
@@ -160,13 +145,18 @@ VinylControlXwax::VinylControlXwax(UserSettingsPointer pConfig, QString group)
 
     timecoder_init(&timecoder, tc_def, speed, iSampleRate, /* phono */ false);
     timecoder_monitor_init(&timecoder, MIXXX_VINYL_SCOPE_SIZE);
-    //Note that timecoder_init will not double-malloc the LUTs, and after this we are guaranteed
-    //that the LUT has been generated unless we ran out of memory.
-    s_bLUTInitialized = true;
     m_uiSafeZone = timecoder_get_safe(&timecoder);
     //}
     s_xwaxLUTMutex.unlock();
 
+    // The library controls are only touched by updateControls() on the
+    // processor thread and never by analyzeSamples().
+    m_pControlTrackSelector = new ControlProxy(this);
+    m_pControlTrackSelector->initialize(
+            ConfigKey("[Playlist]", "SelectTrackKnob"), false);
+    m_pControlTrackLoader = new ControlProxy(
+            m_group, "LoadSelectedTrack", this);
+
     qDebug() << "Starting vinyl control xwax thread";
 }
 
@@ -180,23 +170,37 @@ VinylControlXwax::~VinylControlXwax() {
     timecoder_monitor_clear(&timecoder);
     timecoder_clear(&timecoder);
 
-    // TODO(rryan): This looks wrong. freeLUTs is called later by
-    // VinylControlProcessor so we are probably leaking the LUTs.
-    s_bLUTInitialized = false;
-
     m_pVCRate->set(0.0);
 }
 
 //static
 void VinylControlXwax::freeLUTs() {
     s_xwaxLUTMutex.lock(); //Static mutex! We don't want two threads doing this!
-    if (s_bLUTInitialized) {
-        timecoder_free_lookup(); //Frees all the LUTs in xwax.
-        s_bLUTInitialized = false;
-    }
+    TimecodeLutCache::freeAll(); //Frees all the LUTs in xwax.
     s_xwaxLUTMutex.unlock();
 }
 
+//static
+const char* VinylControlXwax::timecodeForVinylType(const QString& strVinylType) {
+    // libxwax indexes by C-strings so we pass libxwax string literals so we
+    // don't have to deal with freeing the strings later
+    if (strVinylType == MIXXX_VINYL_SERATOCV02VINYLSIDEA) {
+        return "serato_2a";
+    } else if (strVinylType == MIXXX_VINYL_SERATOCV02VINYLSIDEB) {
+        return "serato_2b";
+    } else if (strVinylType == MIXXX_VINYL_SERATOCD) {
+        return "serato_cd";
+    } else if (strVinylType == MIXXX_VINYL_TRAKTORSCRATCHSIDEA) {
+        return "traktor_a";
+    } else if (strVinylType == MIXXX_VINYL_TRAKTORSCRATCHSIDEB) {
+        return "traktor_b";
+    } else if (strVinylType == MIXXX_VINYL_MIXVIBESDVS) {
+        return "mixvibes_v2";
+    }
+    qDebug() << "Unknown vinyl type, defaulting to serato_2a";
+    return "serato_2a";
+}
+
 
 bool VinylControlXwax::writeQualityReport(VinylSignalQualityReport* pReport) {
     if (pReport) {
@@ -209,7 +213,7 @@ bool VinylControlXwax::writeQualityReport(VinylSignalQualityReport* pReport) {
 }
 
 
-void VinylControlXwax::analyzeSamples(CSAMPLE* pSamples, size_t nFrames) {
+void VinylControlXwax::analyzeSamples(const CSAMPLE* pSamples, size_t nFrames) {
     ScopedTimer t("VinylControlXwax::analyzeSamples");
     CSAMPLE gain = m_pVinylControlInputGain->get();
     const int kChannels = 2;
@@ -219,30 +223,31 @@ void VinylControlXwax::analyzeSamples(CSAMPLE* pSamples, size_t nFrames) {
         gain = 1.0f;
     }
 
-    size_t samplesSize = nFrames * kChannels;
+    // Submit the samples in pieces that fit the work buffer, so that this
+    // never allocates when it runs in the engine callback.
+    const size_t samplesSize = nFrames * kChannels;
+    for (size_t offset = 0; offset < samplesSize; offset += m_workBufferSize) {
+        const int chunkSize = static_cast<int>(
+                math_min(samplesSize - offset, m_workBufferSize));
+        const CSAMPLE* pChunk = pSamples + offset;
 
-    if (samplesSize > m_workBufferSize) {
-        delete [] m_pWorkBuffer;
-        m_pWorkBuffer = new short[samplesSize];
-        m_workBufferSize = samplesSize;
-    }
-
-    // Convert CSAMPLE samples to shorts, preventing overflow.
-    for (int i = 0; i < static_cast<int>(samplesSize); ++i) {
-        CSAMPLE sample = pSamples[i] * gain * SAMPLE_MAX;
+        // Convert CSAMPLE samples to shorts, preventing overflow.
+        for (int i = 0; i < chunkSize; ++i) {
+            CSAMPLE sample = pChunk[i] * gain * SAMPLE_MAX;
 
-        if (sample > SAMPLE_MAX) {
-            m_pWorkBuffer[i] = SAMPLE_MAX;
-        } else if (sample < SAMPLE_MIN) {
-            m_pWorkBuffer[i] = SAMPLE_MIN;
-        } else {
-            m_pWorkBuffer[i] = static_cast<short>(sample);
+            if (sample > SAMPLE_MAX) {
+                m_pWorkBuffer[i] = SAMPLE_MAX;
+            } else if (sample < SAMPLE_MIN) {
+                m_pWorkBuffer[i] = SAMPLE_MIN;
+            } else {
+                m_pWorkBuffer[i] = static_cast<short>(sample);
+            }
         }
-    }
 
-    // Submit the samples to the xwax timecode processor. The size argument is
-    // in stereo frames.
-    timecoder_submit(&timecoder, m_pWorkBuffer, nFrames);
+        // Submit the samples to the xwax timecode processor. The size
+        // argument is in stereo frames.
+        timecoder_submit(&timecoder, m_pWorkBuffer, chunkSize / kChannels);
+    }
 
     bool bHaveSignal = fabs(pSamples[0]) + fabs(pSamples[1]) > kMinSignal;
     //qDebug() << "signal?" << bHaveSignal;
@@ -425,13 +430,7 @@ void VinylControlXwax::analyzeSamples(CSAMPLE* pSamples, size_t nFrames) {
                 return;
             } else if (m_bTrackSelectMode) {
                 //qDebug() << "discontinuing select mode, selecting track";
-                if (m_pControlTrackLoader == NULL) {
-                    m_pControlTrackLoader = new ControlProxy(
-                            m_group, "LoadSelectedTrack", this);
-                }
-
-                m_pControlTrackLoader->slotSet(1.0);
-                m_pControlTrackLoader->slotSet(0.0); // I think I have to do this...
+                m_trackLoadRequested = true;
 
                 // if position is known and safe then no track select mode
                 m_bTrackSelectMode = false;
@@ -708,13 +707,6 @@ void VinylControlXwax::doTrackSelection(bool valid_pos, double pitch, double pos
     const int SELECT_INTERVAL = 150;
     const double NOPOS_SPEED = 0.50;
 
-    if (m_pControlTrackSelector == NULL) {
-        // this isn't done in the constructor because this object
-        // doesn't seem to be created yet
-        m_pControlTrackSelector = new ControlProxy(
-                "[Playlist]","SelectTrackKnob", this);
-    }
-
     if (!valid_pos) {
         if (fabs(pitch) > 0.1) {
             //how to estimate how far the record has moved when we don't have a valid
@@ -739,12 +731,35 @@ void VinylControlXwax::doTrackSelection(bool valid_pos, double pitch, double pos
         m_dLastTrackSelectPos = m_dCurTrackSelectPos;
     } else if (fabs(m_dCurTrackSelectPos - m_dLastTrackSelectPos) > SELECT_INTERVAL) {
         //only adjust by one at a time.  It's no help jumping around
-        m_pControlTrackSelector->set((int)(m_dCurTrackSelectPos - m_dLastTrackSelectPos) / fabs(m_dCurTrackSelectPos - m_dLastTrackSelectPos));
+        m_trackSelectSteps +=
+                (m_dCurTrackSelectPos > m_dLastTrackSelectPos) ? 1 : -1;
         m_dLastTrackSelectPos = m_dCurTrackSelectPos;
     }
 }
 
 
+bool VinylControlXwax::controlUpdatesPending() const {
+    return m_trackSelectSteps.load() != 0 || m_trackLoadRequested.load();
+}
+
+void VinylControlXwax::updateControls() {
+    if (!m_pControlTrackSelector->valid()) {
+        // The library may not have created this control yet when we
+        // were constructed
+        m_pControlTrackSelector->initialize(
+                ConfigKey("[Playlist]", "SelectTrackKnob"), false);
+    }
+    const int trackSelectSteps = m_trackSelectSteps.exchange(0);
+    if (trackSelectSteps != 0 && m_pControlTrackSelector->valid()) {
+        m_pControlTrackSelector->set(trackSelectSteps);
+    }
+    // The track is loaded after all pending selection steps
+    if (m_trackLoadRequested.exchange(false)) {
+        m_pControlTrackLoader->set(1.0);
+        m_pControlTrackLoader->set(0.0); // I think I have to do this...
+    }
+}
+
 void VinylControlXwax::resetSteadyPitch(double pitch, double time) {
     m_pSteadySubtle->reset(pitch, time);
     m_pSteadyGross->reset(pitch, time);
@@ -3,6 +3,8 @@
 
 #include <QTime>
 
+#include <atomic>
+
 #include "soundio/soundmanagerutil.h"
 #include "vinylcontrol/vinylcontrol.h"
 #include "vinylcontrol/steadypitch.h"
@@ -26,7 +28,12 @@ class VinylControlXwax : public VinylControl {
     virtual ~VinylControlXwax();
 
     static void freeLUTs();
-    void analyzeSamples(CSAMPLE* pSamples, size_t nFrames);
+    // Returns the name of the xwax timecode definition for a
+    // vinylcontrol_vinyl_type setting.
+    static const char* timecodeForVinylType(const QString& strVinylType);
+    void analyzeSamples(const CSAMPLE* pSamples, size_t nFrames);
+    void updateControls() override;
+    bool controlUpdatesPending() const override;
 
     virtual bool writeQualityReport(VinylSignalQualityReport* qualityReportFifo);
 
@@ -116,9 +123,12 @@ class VinylControlXwax : public VinylControl {
     // Whether track select mode is enabled.
     bool m_bTrackSelectMode;
 
-    // Controls for manipulating the library.
+    // Controls for manipulating the library. Only used by updateControls().
     ControlProxy* m_pControlTrackSelector;
     ControlProxy* m_pControlTrackLoader;
+    // Requested by analyzeSamples() and applied by updateControls()
+    std::atomic<int> m_trackSelectSteps;
+    std::atomic<bool> m_trackLoadRequested;
 
     // The previous and current track select position. Used for track selection
     // using the control region.
@@ -138,7 +148,6 @@ class VinylControlXwax : public VinylControl {
     struct timecoder timecoder;
     // Static mutex that protects our creation/destruction of the xwax LUTs
     static QMutex s_xwaxLUTMutex;
-    static bool s_bLUTInitialized;
 };
 
 #endif
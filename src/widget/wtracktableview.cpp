@@ -44,6 +44,10 @@ WTrackTableView::WTrackTableView(QWidget * parent,
           m_pConfig(pConfig),
           m_pTrackCollection(pTrackCollection),
           m_sorting(sorting),
+          m_bRestoreSelectionPending(false),
+          m_pendingHScrollBarPos(0),
+          m_bRestoreNoSearchVScrollBarPosPending(false),
+          m_bRestoreVScrollBarPosPending(false),
           m_iCoverSourceColumn(-1),
           m_iCoverTypeColumn(-1),
           m_iCoverLocationColumn(-1),
@@ -275,6 +279,23 @@ void WTrackTableView::loadTrackModel(QAbstractItemModel *model) {
         //using address of track model as key
     }
 
+    // Pending restores refer to the previous model
+    m_bRestoreSelectionPending = false;
+    m_pendingSelectedTrackIds.clear();
+    m_bRestoreNoSearchVScrollBarPosPending = false;
+    m_bRestoreVScrollBarPosPending = false;
+    if (m_pSqlTableModel) {
+        disconnect(m_pSqlTableModel, SIGNAL(selectFinished()),
+                   this, SLOT(slotSelectFinished()));
+    }
+    QSortFilterProxyModel* proxyModel = qobject_cast<QSortFilterProxyModel*>(model);
+    m_pSqlTableModel = qobject_cast<BaseSqlTableModel*>(
+            proxyModel ? proxyModel->sourceModel() : model);
+    if (m_pSqlTableModel) {
+        connect(m_pSqlTableModel, SIGNAL(selectFinished()),
+                this, SLOT(slotSelectFinished()));
+    }
+
     // The "coverLocation" and "hash" column numbers are required very often
     // by slotLoadCoverArt(). As this value will not change when the model
     // still the same, we must avoid doing hundreds of "fieldIndex" calls
@@ -418,6 +439,10 @@ void WTrackTableView::loadTrackModel(QAbstractItemModel *model) {
 
     setVisible(true);
 
+    if (isSelectPending()) {
+        m_bRestoreVScrollBarPosPending = true;
+        return;
+    }
     restoreVScrollBarPos(newModel);
     // restoring scrollBar position using model pointer as key
     // scrollbar positions with respect to different models are backed by map
@@ -1067,9 +1092,14 @@ void WTrackTableView::onSearch(const QString& text) {
             saveNoSearchVScrollBarPos();
             searchWasEmpty = true;
         }
+        m_bRestoreNoSearchVScrollBarPosPending = false;
         trackModel->search(text);
         if (!searchWasEmpty && text.isEmpty()) {
-            restoreNoSearchVScrollBarPos();
+            if (isSelectPending()) {
+                m_bRestoreNoSearchVScrollBarPosPending = true;
+            } else {
+                restoreNoSearchVScrollBarPos();
+            }
         }
     }
 }
@@ -1614,7 +1644,7 @@ void WTrackTableView::addSelectionToPlaylist(int iPlaylistId) {
 
     // TODO(XXX): Care whether the append succeeded.
     m_pTrackCollection->unhideTracks(trackIds);
-    playlistDao.appendTracksToPlaylist(trackIds, iPlaylistId);
+    playlistDao.appendTracksToPlaylistAsync(trackIds, iPlaylistId);
 }
 
 void WTrackTableView::slotPopulateCrateMenu() {
@@ -1705,7 +1735,7 @@ void WTrackTableView::updateSelectionCrates(QWidget* pWidget) {
         }
         if (crateId.isValid()) {
             m_pTrackCollection->unhideTracks(trackIds);
-            m_pTrackCollection->addCrateTracks(crateId, trackIds);
+            m_pTrackCollection->addCrateTracksAsync(crateId, trackIds);
         }
     }
 }
@@ -1723,7 +1753,7 @@ void WTrackTableView::addSelectionToNewCrate() {
 
     if (crateId.isValid()) {
         m_pTrackCollection->unhideTracks(trackIds);
-        m_pTrackCollection->addCrateTracks(crateId, trackIds);
+        m_pTrackCollection->addCrateTracksAsync(crateId, trackIds);
     }
 
 }
@@ -1736,12 +1766,31 @@ void WTrackTableView::doSortByColumn(int headerSection) {
         return;
     }
 
-    // Save the selection
-    const QList<TrackId> selectedTrackIds = getSelectedTrackIds();
-    int savedHScrollBarPos = horizontalScrollBar()->value();
+    // Save the selection, unless a previous sort has not been restored yet
+    if (!m_bRestoreSelectionPending) {
+        m_pendingSelectedTrackIds = getSelectedTrackIds();
+        m_pendingHScrollBarPos = horizontalScrollBar()->value();
+    }
 
     sortByColumn(headerSection);
 
+    if (isSelectPending()) {
+        m_bRestoreSelectionPending = true;
+        return;
+    }
+    m_bRestoreSelectionPending = false;
+    restoreSelection(m_pendingSelectedTrackIds, m_pendingHScrollBarPos);
+    m_pendingSelectedTrackIds.clear();
+}
+
+void WTrackTableView::restoreSelection(
+        const QList<TrackId>& selectedTrackIds, int hScrollBarPos) {
+    TrackModel* trackModel = getTrackModel();
+    QAbstractItemModel* itemModel = model();
+    if (trackModel == nullptr || itemModel == nullptr) {
+        return;
+    }
+
     QItemSelectionModel* currentSelection = selectionModel();
     currentSelection->reset(); // remove current selection
 
@@ -1776,7 +1825,31 @@ void WTrackTableView::doSortByColumn(int headerSection) {
     }
 
     scrollTo(first, QAbstractItemView::EnsureVisible);
-    horizontalScrollBar()->setValue(savedHScrollBarPos);
+    horizontalScrollBar()->setValue(hScrollBarPos);
+}
+
+bool WTrackTableView::isSelectPending() const {
+    return m_pSqlTableModel && m_pSqlTableModel->isSelecting();
+}
+
+void WTrackTableView::slotSelectFinished() {
+    if (isSelectPending()) {
+        // Superseded by another select
+        return;
+    }
+    if (m_bRestoreSelectionPending) {
+        m_bRestoreSelectionPending = false;
+        restoreSelection(m_pendingSelectedTrackIds, m_pendingHScrollBarPos);
+        m_pendingSelectedTrackIds.clear();
+    }
+    if (m_bRestoreNoSearchVScrollBarPosPending) {
+        m_bRestoreNoSearchVScrollBarPosPending = false;
+        restoreNoSearchVScrollBarPos();
+    }
+    if (m_bRestoreVScrollBarPosPending) {
+        m_bRestoreVScrollBarPosPending = false;
+        restoreVScrollBarPos(getTrackModel());
+    }
 }
 
 void WTrackTableView::applySortingIfVisible() {
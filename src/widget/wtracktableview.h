@@ -2,10 +2,12 @@
 #define WTRACKTABLEVIEW_H
 
 #include <QAbstractItemModel>
+#include <QPointer>
 #include <QSortFilterProxyModel>
 
 #include "preferences/usersettings.h"
 #include "control/controlproxy.h"
+#include "library/basesqltablemodel.h"
 #include "library/coverart.h"
 #include "library/dlgtagfetcher.h"
 #include "library/libraryview.h"
@@ -97,6 +99,7 @@ class WTrackTableView : public WLibraryTableView {
     void slotTagFetcherClosed();
     void slotSortingChanged(int headerSection, Qt::SortOrder order);
     void keyNotationChanged();
+    void slotSelectFinished();
 
   private:
 
@@ -108,6 +111,11 @@ class WTrackTableView : public WLibraryTableView {
     void dragEnterEvent(QDragEnterEvent * event) override;
     void dropEvent(QDropEvent * event) override;
     void lockBpm(bool lock);
+    void restoreSelection(const QList<TrackId>& trackIds, int hScrollBarPos);
+
+    // True while the rows of the model are selected asynchronously. The
+    // selection and scroll positions are restored after it has finished.
+    bool isSelectPending() const;
 
     void enableCachedOnly();
     void selectionChanged(const QItemSelection &selected,
@@ -204,6 +212,15 @@ class WTrackTableView : public WLibraryTableView {
 
     bool m_sorting;
 
+    // The model of the current track model or the source model of
+    // a proxy model, if any. Used to wait for asynchronous selects.
+    QPointer<BaseSqlTableModel> m_pSqlTableModel;
+    bool m_bRestoreSelectionPending;
+    QList<TrackId> m_pendingSelectedTrackIds;
+    int m_pendingHScrollBarPos;
+    bool m_bRestoreNoSearchVScrollBarPosPending;
+    bool m_bRestoreVScrollBarPosPending;
+
     // Column numbers
     int m_iCoverSourceColumn; // cover art source
     int m_iCoverTypeColumn; // cover art type